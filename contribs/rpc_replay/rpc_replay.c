@@ -0,0 +1,769 @@
+/*****************************************************************************\
+ *  rpc_replay.c - replay a slurmctld RPC capture against a test controller
+ *
+ *  Reads a capture written by slurmctld with SlurmctldParameters=rpc_capture=
+ *  and sends the same mix of RPC types with the same relative timing, sped
+ *  up or slowed down by a scale factor, through the normal libslurm client
+ *  path. Captures hold no message content, so requests are rebuilt from
+ *  defaults and only the RPC types a user command would send are replayed.
+ *
+ *  A job trace exported from sacct can be replayed too, submitting each job
+ *  with its recorded size, time limit and run time, and the scheduler
+ *  statistics of the test controller are reported at the end.
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/parse_time.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/timers.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+/* Requests starting later than this after their due time count as late */
+#define LATE_USEC 10000
+
+/* Environment variable giving slurmd_emulator the run time of a job */
+#define RUN_TIME_ENV "EMULATOR_RUN_TIME"
+
+typedef struct {
+	uint64_t offset;	/* usec after the start of the capture */
+	int type_inx;		/* index into types[] */
+	int job_inx;		/* index into jobs[], -1 if not a trace job */
+} replay_rec_t;
+
+/* Job from a sacct trace */
+typedef struct {
+	uint32_t nodes;
+	uint32_t cpus;
+	uint32_t time_limit;	/* seconds, NO_VAL for the partition default */
+	uint32_t run_time;	/* seconds */
+	char *partition;
+} replay_job_t;
+
+typedef struct {
+	uint16_t msg_type;
+	bool supported;
+	uint32_t captured;
+	uint32_t sent;
+	uint32_t errors;
+	uint64_t usec_sum;
+	uint64_t usec_max;
+} replay_type_t;
+
+static char *capture_file = NULL;
+static char *trace_file = NULL;
+static double scale = 1.0;
+static int thread_cnt = 32;
+static bool submit_jobs = false;
+
+static replay_rec_t *recs = NULL;
+static int rec_cnt = 0;
+static int rec_size = 0;
+static replay_type_t *types = NULL;
+static int type_cnt = 0;
+static replay_type_t trace_type = { .msg_type = REQUEST_SUBMIT_BATCH_JOB };
+static replay_job_t *jobs = NULL;
+static int job_cnt = 0;
+static job_desc_msg_t job_desc;
+
+static pthread_mutex_t replay_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int rec_next = 0;
+static struct timeval start_tv;
+static uint32_t late_cnt = 0;
+static uint64_t late_max = 0;
+static bool replay_done = false;
+
+/* Queue depth sampled while replaying a job trace */
+static uint32_t sample_cnt = 0;
+static uint64_t pending_sum = 0, running_sum = 0;
+static uint32_t pending_max = 0, running_max = 0;
+
+static void _help(void)
+{
+	printf("\
+Usage: rpc_replay [OPTIONS] -f <capture_file> | -j <job_trace>\n\
+  -f, --file=<path>          RPC capture written by slurmctld\n\
+  -j, --jobs=<path>          job trace written by sacct, see README.txt\n\
+  -s, --scale=<factor>       replay rate relative to the capture, for\n\
+                             example 2 replays twice as fast (default 1)\n\
+  -S, --submit               also replay batch job submissions, as jobs\n\
+                             running /bin/true\n\
+  -t, --threads=<count>      maximum concurrent requests (default 32)\n\
+  -v, --verbose              increase logging verbosity\n\
+\nHelp options:\n\
+  --help          show this help message\n");
+}
+
+static void _parse_args(int argc, char **argv, log_options_t *logopt)
+{
+	int opt_char, option_index;
+	char *end = NULL;
+	static struct option long_options[] = {
+		{"file",	required_argument,	0,	'f'},
+		{"help",	no_argument,		0,	'h'},
+		{"jobs",	required_argument,	0,	'j'},
+		{"scale",	required_argument,	0,	's'},
+		{"submit",	no_argument,		0,	'S'},
+		{"threads",	required_argument,	0,	't'},
+		{"verbose",	no_argument,		0,	'v'},
+		{NULL,		0,			0,	0}
+	};
+
+	while ((opt_char = getopt_long(argc, argv, "f:hj:Ss:t:v", long_options,
+				       &option_index)) != -1) {
+		switch (opt_char) {
+		case 'f':
+			xfree(capture_file);
+			capture_file = xstrdup(optarg);
+			break;
+		case 'h':
+			_help();
+			exit(0);
+		case 'j':
+			xfree(trace_file);
+			trace_file = xstrdup(optarg);
+			break;
+		case 'S':
+			submit_jobs = true;
+			break;
+		case 's':
+			scale = strtod(optarg, &end);
+			if ((scale <= 0) || (end[0] != '\0'))
+				fatal("Invalid --scale: %s", optarg);
+			break;
+		case 't':
+			thread_cnt = strtol(optarg, &end, 10);
+			if ((thread_cnt < 1) || (end[0] != '\0'))
+				fatal("Invalid --threads: %s", optarg);
+			break;
+		case 'v':
+			logopt->stderr_level++;
+			break;
+		default:
+			fprintf(stderr, "Try \"rpc_replay --help\" for more information\n");
+			exit(1);
+		}
+	}
+
+	if (!capture_file && !trace_file)
+		fatal("Nothing to replay, use --file or --jobs");
+}
+
+static bool _type_supported(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_BUILD_INFO:
+	case REQUEST_FED_INFO:
+	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_STEP_INFO:
+	case REQUEST_JOB_USER_INFO:
+	case REQUEST_NODE_INFO:
+	case REQUEST_PARTITION_INFO:
+	case REQUEST_PING:
+	case REQUEST_RESERVATION_INFO:
+	case REQUEST_STATS_INFO:
+		return true;
+	case REQUEST_SUBMIT_BATCH_JOB:
+		return submit_jobs;
+	default:
+		return false;
+	}
+}
+
+static int _type_inx(uint16_t msg_type)
+{
+	int i;
+
+	for (i = 0; i < type_cnt; i++) {
+		if (types[i].msg_type == msg_type)
+			return i;
+	}
+	xrecalloc(types, type_cnt + 1, sizeof(replay_type_t));
+	types[type_cnt].msg_type = msg_type;
+	types[type_cnt].supported = _type_supported(msg_type);
+
+	return type_cnt++;
+}
+
+static int _cmp_rec(const void *x, const void *y)
+{
+	const replay_rec_t *a = x, *b = y;
+
+	if (a->offset < b->offset)
+		return -1;
+	if (a->offset > b->offset)
+		return 1;
+	return 0;
+}
+
+static replay_type_t *_rec_type(replay_rec_t *rec)
+{
+	if (rec->job_inx >= 0)
+		return &trace_type;
+	return &types[rec->type_inx];
+}
+
+static replay_rec_t *_new_rec(uint64_t offset)
+{
+	if (rec_cnt >= rec_size) {
+		rec_size = MAX(rec_size * 2, 1024);
+		xrecalloc(recs, rec_size, sizeof(replay_rec_t));
+	}
+	recs[rec_cnt].offset = offset;
+	recs[rec_cnt].type_inx = -1;
+	recs[rec_cnt].job_inx = -1;
+
+	return &recs[rec_cnt++];
+}
+
+/* Load the capture, keeping only the RPCs which will be replayed */
+static void _load_capture(void)
+{
+	FILE *fp;
+	char line[256];
+	int line_num = 0;
+
+	if (!(fp = fopen(capture_file, "r")))
+		fatal("Unable to open %s: %m", capture_file);
+
+	while (fgets(line, sizeof(line), fp)) {
+		int64_t offset;
+		unsigned int msg_type, bytes;
+		int inx;
+
+		line_num++;
+		if (line[0] == '#')
+			continue;
+		if ((sscanf(line, "%"SCNd64" %u %u", &offset, &msg_type,
+			    &bytes) != 3) || (offset < 0) ||
+		    (msg_type > UINT16_MAX)) {
+			error("%s:%d: invalid record", capture_file, line_num);
+			continue;
+		}
+
+		inx = _type_inx(msg_type);
+		types[inx].captured++;
+		if (!types[inx].supported)
+			continue;
+
+		_new_rec(offset)->type_inx = inx;
+	}
+	fclose(fp);
+}
+
+/*
+ * Load a job trace. Each line holds the submit time, elapsed time, time
+ * limit, node count, CPU count and partition of a job, separated by "|":
+ *	sacct -a -X -n -P -o Submit,Elapsed,Timelimit,NNodes,NCPUS,Partition
+ */
+static void _load_trace(void)
+{
+	FILE *fp;
+	char line[1024];
+	int line_num = 0, job_size = 0;
+	time_t first_submit = 0;
+
+	if (!(fp = fopen(trace_file, "r")))
+		fatal("Unable to open %s: %m", trace_file);
+
+	while (fgets(line, sizeof(line), fp)) {
+		char *field[6], *save_ptr = NULL, *tok;
+		int i, elapsed, limit;
+		time_t submit;
+		replay_job_t *job;
+
+		line_num++;
+		if (line[0] == '#')
+			continue;
+		line[strcspn(line, "\n")] = '\0';
+		for (i = 0, tok = line; i < ARRAY_SIZE(field); i++) {
+			field[i] = strtok_r(tok, "|", &save_ptr);
+			tok = NULL;
+		}
+		if (!field[4] ||
+		    !(submit = parse_time(field[0], 0)) ||
+		    ((elapsed = time_str2secs(field[1])) == NO_VAL) ||
+		    (elapsed == INFINITE) ||
+		    (((limit = time_str2secs(field[2])) == NO_VAL) &&
+		     xstrcasecmp(field[2], "Partition_Limit")) ||
+		    (atoi(field[3]) < 1) || (atoi(field[4]) < 1)) {
+			error("%s:%d: invalid record", trace_file, line_num);
+			continue;
+		}
+
+		if (job_cnt >= job_size) {
+			job_size = MAX(job_size * 2, 1024);
+			xrecalloc(jobs, job_size, sizeof(replay_job_t));
+		}
+		job = &jobs[job_cnt];
+		job->nodes = atoi(field[3]);
+		job->cpus = atoi(field[4]);
+		job->run_time = elapsed / scale;
+		if ((limit == NO_VAL) || (limit == INFINITE))
+			job->time_limit = NO_VAL;
+		else
+			job->time_limit = limit / scale;
+		job->partition = xstrdup(field[5]);
+
+		if (!first_submit || (submit < first_submit))
+			first_submit = submit;
+		_new_rec(submit)->job_inx = job_cnt++;
+		trace_type.captured++;
+	}
+	fclose(fp);
+
+	/* Offsets hold the submit time until the first one is known */
+	for (int i = 0; i < rec_cnt; i++) {
+		if (recs[i].job_inx >= 0)
+			recs[i].offset = (recs[i].offset - first_submit) *
+					 USEC_IN_SEC;
+	}
+}
+
+static void _init_job_desc(void)
+{
+	static char *env[] = { "PATH=/bin:/usr/bin", NULL };
+
+	slurm_init_job_desc_msg(&job_desc);
+	job_desc.name = "rpc_replay";
+	job_desc.script = "#!/bin/sh\n/bin/true\n";
+	job_desc.environment = env;
+	job_desc.env_size = 1;
+	job_desc.user_id = getuid();
+	job_desc.group_id = getgid();
+	job_desc.work_dir = "/tmp";
+	job_desc.std_out = "/dev/null";
+	job_desc.min_nodes = 1;
+	job_desc.time_limit = 1;
+}
+
+/* Replies to info requests are freed by their own API functions */
+static void _free_response(slurm_msg_t *msg)
+{
+	switch (msg->msg_type) {
+	case RESPONSE_BUILD_INFO:
+		slurm_free_ctl_conf(msg->data);
+		break;
+	case RESPONSE_JOB_INFO:
+		slurm_free_job_info_msg(msg->data);
+		break;
+	case RESPONSE_JOB_STEP_INFO:
+		slurm_free_job_step_info_response_msg(msg->data);
+		break;
+	case RESPONSE_NODE_INFO:
+		slurm_free_node_info_msg(msg->data);
+		break;
+	case RESPONSE_PARTITION_INFO:
+		slurm_free_partition_info_msg(msg->data);
+		break;
+	case RESPONSE_RESERVATION_INFO:
+		slurm_free_reservation_info_msg(msg->data);
+		break;
+	case RESPONSE_STATS_INFO:
+		slurm_free_stats_response_msg(msg->data);
+		break;
+	default:
+		slurm_free_msg_data(msg->msg_type, msg->data);
+		break;
+	}
+}
+
+/* Submit a job of the trace, running for its recorded time when emulated */
+static int _submit_trace_job(replay_job_t *job)
+{
+	job_desc_msg_t desc;
+	submit_response_msg_t *resp = NULL;
+	char run_env[64];
+	char *env[] = { "PATH=/bin:/usr/bin", run_env, NULL };
+	char *script;
+	int rc;
+
+	snprintf(run_env, sizeof(run_env), RUN_TIME_ENV"=%u", job->run_time);
+	script = xstrdup_printf("#!/bin/sh\nsleep %u\n", job->run_time);
+
+	slurm_init_job_desc_msg(&desc);
+	desc.name = "rpc_replay";
+	desc.script = script;
+	desc.environment = env;
+	desc.env_size = 2;
+	desc.user_id = getuid();
+	desc.group_id = getgid();
+	desc.work_dir = "/tmp";
+	desc.std_out = "/dev/null";
+	desc.min_nodes = job->nodes;
+	desc.min_cpus = job->cpus;
+	if (job->partition && job->partition[0])
+		desc.partition = job->partition;
+	/* Limits are whole minutes, rounded up to keep the job's run time */
+	if (job->time_limit != NO_VAL)
+		desc.time_limit = MAX(1, ((job->time_limit + 59) / 60));
+
+	if ((rc = slurm_submit_batch_job(&desc, &resp)))
+		rc = errno ? errno : SLURM_ERROR;
+	slurm_free_submit_response_response_msg(resp);
+	xfree(script);
+
+	return rc;
+}
+
+/* Build a default request of the given type and send it to slurmctld */
+static int _send_request(uint16_t msg_type)
+{
+	slurm_msg_t req_msg, resp_msg;
+	union {
+		job_info_request_msg_t job_info;
+		job_step_info_request_msg_t step_info;
+		job_user_id_msg_t job_user;
+		last_update_msg_t last_update;
+		node_info_request_msg_t node_info;
+		part_info_request_msg_t part_info;
+		resv_info_request_msg_t resv_info;
+		stats_info_request_msg_t stats;
+	} req;
+	int rc = SLURM_SUCCESS;
+
+	memset(&req, 0, sizeof(req));
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	req_msg.msg_type = msg_type;
+	req_msg.data = &req;
+
+	switch (msg_type) {
+	case REQUEST_JOB_STEP_INFO:
+		req.step_info.step_id.job_id = NO_VAL;
+		req.step_info.step_id.step_id = NO_VAL;
+		req.step_info.step_id.step_het_comp = NO_VAL;
+		break;
+	case REQUEST_JOB_USER_INFO:
+		req.job_user.user_id = getuid();
+		break;
+	case REQUEST_STATS_INFO:
+		req.stats.command_id = STAT_COMMAND_GET;
+		break;
+	case REQUEST_FED_INFO:
+	case REQUEST_PING:
+		req_msg.data = NULL;
+		break;
+	case REQUEST_SUBMIT_BATCH_JOB:
+		req_msg.data = &job_desc;
+		break;
+	default:
+		/* All zero requests are full, not incremental, updates */
+		break;
+	}
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg,
+					   working_cluster_rec) < 0)
+		return errno ? errno : SLURM_ERROR;
+
+	if (resp_msg.msg_type == RESPONSE_SLURM_RC)
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+	_free_response(&resp_msg);
+
+	return rc;
+}
+
+static void *_replay_thread(void *arg)
+{
+	while (true) {
+		struct timeval now, sent_tv;
+		uint64_t due, elapsed, usec;
+		replay_type_t *type;
+		int i, rc;
+
+		slurm_mutex_lock(&replay_mutex);
+		if (rec_next >= rec_cnt) {
+			slurm_mutex_unlock(&replay_mutex);
+			break;
+		}
+		i = rec_next++;
+		slurm_mutex_unlock(&replay_mutex);
+
+		due = recs[i].offset / scale;
+		gettimeofday(&now, NULL);
+		elapsed = ((now.tv_sec - start_tv.tv_sec) * USEC_IN_SEC) +
+			  (now.tv_usec - start_tv.tv_usec);
+		if (due > elapsed) {
+			usleep(due - elapsed);
+			elapsed = due;
+		}
+
+		sent_tv.tv_sec = 0;
+		(void) slurm_delta_tv(&sent_tv);
+		if (recs[i].job_inx >= 0)
+			rc = _submit_trace_job(&jobs[recs[i].job_inx]);
+		else
+			rc = _send_request(types[recs[i].type_inx].msg_type);
+		usec = slurm_delta_tv(&sent_tv);
+
+		slurm_mutex_lock(&replay_mutex);
+		type = _rec_type(&recs[i]);
+		type->sent++;
+		type->usec_sum += usec;
+		type->usec_max = MAX(type->usec_max, usec);
+		if (rc) {
+			type->errors++;
+			debug("%s: %s", rpc_num2string(type->msg_type),
+			      slurm_strerror(rc));
+		}
+		if ((elapsed - due) > LATE_USEC) {
+			late_cnt++;
+			late_max = MAX(late_max, elapsed - due);
+		}
+		slurm_mutex_unlock(&replay_mutex);
+	}
+
+	return NULL;
+}
+
+/*
+ * Sample the pending and running job counts once a second, until all jobs
+ * are submitted and none are left pending or running
+ */
+static void *_sample_thread(void *arg)
+{
+	stats_info_request_msg_t req = { .command_id = STAT_COMMAND_GET };
+	bool active = true;
+
+	while (true) {
+		stats_info_response_msg_t *stats = NULL;
+
+		slurm_mutex_lock(&replay_mutex);
+		if (replay_done && !active) {
+			slurm_mutex_unlock(&replay_mutex);
+			break;
+		}
+		slurm_mutex_unlock(&replay_mutex);
+
+		if (!slurm_get_statistics(&stats, &req)) {
+			active = stats->jobs_pending || stats->jobs_running;
+			slurm_mutex_lock(&replay_mutex);
+			sample_cnt++;
+			pending_sum += stats->jobs_pending;
+			running_sum += stats->jobs_running;
+			pending_max = MAX(pending_max, stats->jobs_pending);
+			running_max = MAX(running_max, stats->jobs_running);
+			slurm_mutex_unlock(&replay_mutex);
+			slurm_free_stats_response_msg(stats);
+		}
+		sleep(1);
+	}
+
+	return NULL;
+}
+
+static double _mean(uint64_t sum, uint32_t cnt)
+{
+	return cnt ? ((double) sum / cnt) : 0.0;
+}
+
+/* Report the scheduler activity of the test controller during the replay */
+static void _print_sched_stats(stats_info_response_msg_t *s0,
+			       stats_info_response_msg_t *s1)
+{
+	uint32_t cycles = s1->schedule_cycle_counter -
+			  s0->schedule_cycle_counter;
+	uint32_t bf_cycles = s1->bf_cycle_counter - s0->bf_cycle_counter;
+
+	printf("\nJobs submitted %u started %u completed %u failed %u\n",
+	       s1->jobs_submitted - s0->jobs_submitted,
+	       s1->jobs_started - s0->jobs_started,
+	       s1->jobs_completed - s0->jobs_completed,
+	       s1->jobs_failed - s0->jobs_failed);
+	printf("Pending jobs mean %.1f max %u, running jobs mean %.1f max %u\n",
+	       _mean(pending_sum, sample_cnt), pending_max,
+	       _mean(running_sum, sample_cnt), running_max);
+
+	printf("\nMain scheduler cycles %u, mean usec: cycle %.0f queue build %.0f node selection %.0f, mean depth %.1f\n",
+	       cycles,
+	       _mean(s1->schedule_cycle_sum - s0->schedule_cycle_sum, cycles),
+	       _mean(s1->schedule_queue_build_sum -
+		     s0->schedule_queue_build_sum, cycles),
+	       _mean(s1->schedule_select_sum - s0->schedule_select_sum,
+		     cycles),
+	       _mean(s1->schedule_cycle_depth - s0->schedule_cycle_depth,
+		     cycles));
+	printf("Backfill cycles %u, mean usec: cycle %.0f queue build %.0f node selection %.0f yield %.0f, mean depth %.1f, jobs backfilled %u\n",
+	       bf_cycles,
+	       _mean(s1->bf_cycle_sum - s0->bf_cycle_sum, bf_cycles),
+	       _mean(s1->bf_queue_build_sum - s0->bf_queue_build_sum,
+		     bf_cycles),
+	       _mean(s1->bf_select_sum - s0->bf_select_sum, bf_cycles),
+	       _mean(s1->bf_yield_sum - s0->bf_yield_sum, bf_cycles),
+	       _mean(s1->bf_depth_sum - s0->bf_depth_sum, bf_cycles),
+	       s1->bf_backfilled_jobs - s0->bf_backfilled_jobs);
+}
+
+static void _print_stats(uint64_t run_usec)
+{
+	uint32_t skipped = 0, sent = 0;
+	int i;
+
+	printf("%-32s %10s %10s %8s %12s %12s\n", "RPC", "CAPTURED", "SENT",
+	       "ERRORS", "MEAN_USEC", "MAX_USEC");
+	for (i = 0; i < type_cnt; i++) {
+		replay_type_t *type = &types[i];
+
+		if (!type->supported) {
+			skipped += type->captured;
+			continue;
+		}
+		sent += type->sent;
+		printf("%-32s %10u %10u %8u %12"PRIu64" %12"PRIu64"\n",
+		       rpc_num2string(type->msg_type), type->captured,
+		       type->sent, type->errors,
+		       type->sent ? (type->usec_sum / type->sent) : 0,
+		       type->usec_max);
+	}
+	if (trace_type.captured) {
+		sent += trace_type.sent;
+		printf("%-32s %10u %10u %8u %12"PRIu64" %12"PRIu64"\n",
+		       "TRACE_JOBS", trace_type.captured, trace_type.sent,
+		       trace_type.errors,
+		       trace_type.sent ?
+		       (trace_type.usec_sum / trace_type.sent) : 0,
+		       trace_type.usec_max);
+	}
+
+	printf("\nSent %u RPCs in %.3f sec (%.1f per sec) at scale %.2f\n",
+	       sent, (double) run_usec / USEC_IN_SEC,
+	       run_usec ? ((double) sent * USEC_IN_SEC / run_usec) : 0.0,
+	       scale);
+	printf("Late by more than %d msec: %u (max %"PRIu64" msec)\n",
+	       LATE_USEC / 1000, late_cnt, late_max / 1000);
+	if (skipped) {
+		printf("Not replayed: %u RPCs of types", skipped);
+		for (i = 0; i < type_cnt; i++) {
+			if (!types[i].supported)
+				printf(" %s", rpc_num2string(types[i].msg_type));
+		}
+		printf("\n");
+	}
+}
+
+int main(int argc, char **argv)
+{
+	log_options_t logopt = LOG_OPTS_STDERR_ONLY;
+	stats_info_request_msg_t stats_req = { .command_id = STAT_COMMAND_GET };
+	stats_info_response_msg_t *stats_start = NULL, *stats_end = NULL;
+	pthread_t *tids, sample_tid = 0;
+	struct timeval end_tv;
+	uint64_t run_usec;
+	int i;
+
+	slurm_conf_init(NULL);
+	log_init(xbasename(argv[0]), logopt, 0, NULL);
+	_parse_args(argc, argv, &logopt);
+	log_alter(logopt, 0, NULL);
+
+	if (capture_file)
+		_load_capture();
+	if (trace_file)
+		_load_trace();
+	if (!rec_cnt)
+		fatal("No RPCs or jobs to replay");
+	/*
+	 * Captures are written by concurrent threads and sacct lists jobs by
+	 * ID, so records may be out of order
+	 */
+	qsort(recs, rec_cnt, sizeof(replay_rec_t), _cmp_rec);
+	if (submit_jobs)
+		_init_job_desc();
+	info("Replaying %d RPCs and jobs spanning %.3f sec at scale %.2f",
+	     rec_cnt, (double) recs[rec_cnt - 1].offset / scale / USEC_IN_SEC,
+	     scale);
+
+	if (slurm_get_statistics(&stats_start, &stats_req))
+		fatal("Unable to get slurmctld statistics: %m");
+	if (trace_file)
+		slurm_thread_create(&sample_tid, _sample_thread, NULL);
+
+	gettimeofday(&start_tv, NULL);
+	tids = xcalloc(thread_cnt, sizeof(pthread_t));
+	for (i = 0; i < thread_cnt; i++)
+		slurm_thread_create(&tids[i], _replay_thread, NULL);
+	for (i = 0; i < thread_cnt; i++)
+		pthread_join(tids[i], NULL);
+	gettimeofday(&end_tv, NULL);
+	run_usec = ((end_tv.tv_sec - start_tv.tv_sec) * USEC_IN_SEC) +
+		   (end_tv.tv_usec - start_tv.tv_usec);
+
+	slurm_mutex_lock(&replay_mutex);
+	replay_done = true;
+	slurm_mutex_unlock(&replay_mutex);
+	if (sample_tid) {
+		info("Waiting for the jobs to complete");
+		pthread_join(sample_tid, NULL);
+		gettimeofday(&end_tv, NULL);
+	}
+
+	_print_stats(run_usec);
+	if (sample_tid)
+		printf("All jobs completed after %.3f sec\n",
+		       (double) (end_tv.tv_sec - start_tv.tv_sec) +
+		       ((double) (end_tv.tv_usec - start_tv.tv_usec) /
+			USEC_IN_SEC));
+	if (!slurm_get_statistics(&stats_end, &stats_req))
+		_print_sched_stats(stats_start, stats_end);
+	else
+		error("Unable to get slurmctld statistics: %m");
+
+	slurm_free_stats_response_msg(stats_start);
+	slurm_free_stats_response_msg(stats_end);
+	for (i = 0; i < job_cnt; i++)
+		xfree(jobs[i].partition);
+	xfree(jobs);
+	xfree(tids);
+	xfree(recs);
+	xfree(types);
+	xfree(capture_file);
+	xfree(trace_file);
+	slurm_conf_destroy();
+	log_fini();
+
+	return 0;
+}
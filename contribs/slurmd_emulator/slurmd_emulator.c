@@ -0,0 +1,745 @@
+/*****************************************************************************\
+ *  slurmd_emulator.c - emulate many slurmd daemons in a single process
+ *
+ *  Every emulated node listens on the port configured for it in slurm.conf,
+ *  registers with slurmctld, answers pings and forwards messages to other
+ *  nodes exactly as slurmd does, but runs no slurmstepd. Batch jobs are
+ *  reported as complete after a randomly sampled run time. This permits
+ *  benchmarking slurmctld fanout, registration and RPC handling with tens of
+ *  thousands of nodes from a few machines.
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/env.h"
+#include "src/common/fd.h"
+#include "src/common/forward.h"
+#include "src/common/hostlist.h"
+#include "src/common/list.h"
+#include "src/common/pack.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_acct_gather_energy.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/slurm_rlimits_info.h"
+#include "src/common/timers.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xsignal.h"
+#include "src/common/xstring.h"
+
+typedef struct {
+	char *name;
+	uint16_t port;
+	int listen_fd;
+	uint16_t cpus;
+	uint16_t boards;
+	uint16_t sockets;
+	uint16_t cores;
+	uint16_t threads;
+	uint64_t real_memory;
+	uint32_t tmp_disk;
+	time_t boot_time;
+} emu_node_t;
+
+typedef struct {
+	uint32_t job_id;
+	uint32_t user_id;
+	int node_inx;		/* batch host, index into nodes[] */
+	time_t end_time;	/* when to report completion */
+} emu_job_t;
+
+typedef struct {
+	int fd;
+	int node_inx;
+	slurm_addr_t cli_addr;
+} emu_conn_t;
+
+static emu_node_t *nodes = NULL;
+static int node_cnt = 0;
+static char *node_list = NULL;
+static int reg_threads = 16;
+static uint32_t run_min = 10, run_max = 60;
+static time_t start_time = 0;
+static volatile bool shutdown_emu = false;
+
+/* Running batch jobs, sorted by end_time */
+static List job_list = NULL;
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_mutex_t reg_mutex = PTHREAD_MUTEX_INITIALIZER;
+static int reg_next = 0;
+static int reg_fail = 0;
+
+static pthread_mutex_t stat_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t rpc_cnt = 0;
+static uint32_t jobs_started = 0, jobs_completed = 0;
+
+static void _help(void)
+{
+	printf("\
+Usage: slurmd_emulator [OPTIONS] -N <nodelist>\n\
+  -N, --nodes=<nodelist>     NodeNames from slurm.conf to emulate\n\
+  -r, --run-time=<min>[-<max>]\n\
+                             batch job run time in seconds, sampled\n\
+                             uniformly from the range (default 10-60)\n\
+  -R, --reg-threads=<count>  concurrent node registrations at startup\n\
+                             (default 16)\n\
+  -v, --verbose              increase logging verbosity\n\
+\nHelp options:\n\
+  --help          show this help message\n");
+}
+
+static void _parse_args(int argc, char **argv, log_options_t *logopt)
+{
+	int opt_char, option_index;
+	char *end = NULL;
+	static struct option long_options[] = {
+		{"help",	no_argument,		0,	'h'},
+		{"nodes",	required_argument,	0,	'N'},
+		{"reg-threads",	required_argument,	0,	'R'},
+		{"run-time",	required_argument,	0,	'r'},
+		{"verbose",	no_argument,		0,	'v'},
+		{NULL,		0,			0,	0}
+	};
+
+	while ((opt_char = getopt_long(argc, argv, "hN:R:r:v", long_options,
+				       &option_index)) != -1) {
+		switch (opt_char) {
+		case 'h':
+			_help();
+			exit(0);
+		case 'N':
+			xfree(node_list);
+			node_list = xstrdup(optarg);
+			break;
+		case 'R':
+			reg_threads = strtol(optarg, &end, 10);
+			if ((reg_threads < 1) || (end[0] != '\0'))
+				fatal("Invalid --reg-threads: %s", optarg);
+			break;
+		case 'r':
+			run_min = strtoul(optarg, &end, 10);
+			if (end[0] == '-')
+				run_max = strtoul(end + 1, &end, 10);
+			else
+				run_max = run_min;
+			if ((end[0] != '\0') || (run_max < run_min))
+				fatal("Invalid --run-time: %s", optarg);
+			break;
+		case 'v':
+			logopt->stderr_level++;
+			break;
+		default:
+			fprintf(stderr, "Try \"slurmd_emulator --help\" for more information\n");
+			exit(1);
+		}
+	}
+
+	if (!node_list)
+		fatal("No nodes to emulate, use --nodes");
+}
+
+/* Fill in nodes[] from slurm.conf and open a listening socket for each */
+static void _init_nodes(void)
+{
+	slurm_conf_node_t **ptr_array;
+	hostset_t hs;
+	hostlist_t hl;
+	char *name;
+	int cnt, i, j;
+
+	if (!(hs = hostset_create(node_list)))
+		fatal("Invalid node list: %s", node_list);
+	nodes = xcalloc(hostset_count(hs), sizeof(emu_node_t));
+
+	cnt = slurm_conf_nodename_array(&ptr_array);
+	for (i = 0; i < cnt; i++) {
+		if (!(hl = hostlist_create(ptr_array[i]->nodenames)))
+			continue;
+		while ((name = hostlist_shift(hl))) {
+			emu_node_t *node;
+
+			if (!hostset_within(hs, name) ||
+			    (node_cnt >= hostset_count(hs))) {
+				free(name);
+				continue;
+			}
+			node = &nodes[node_cnt++];
+			node->name = xstrdup(name);
+			node->real_memory = ptr_array[i]->real_memory;
+			node->tmp_disk = ptr_array[i]->tmp_disk;
+			free(name);
+		}
+		hostlist_destroy(hl);
+	}
+	if (node_cnt != hostset_count(hs))
+		fatal("Only %d of %d nodes in %s found in slurm.conf",
+		      node_cnt, hostset_count(hs), node_list);
+	hostset_destroy(hs);
+
+	for (i = 0; i < node_cnt; i++) {
+		emu_node_t *node = &nodes[i];
+
+		if (slurm_conf_get_cpus_bsct(node->name, &node->cpus,
+					     &node->boards, &node->sockets,
+					     &node->cores, &node->threads))
+			fatal("Unable to get CPU layout of node %s",
+			      node->name);
+		node->port = slurm_conf_get_port(node->name);
+		node->boot_time = start_time;
+		for (j = 0; j < i; j++) {
+			if (nodes[j].port == node->port)
+				fatal("Nodes %s and %s both use port %hu, configure a unique Port for every emulated node",
+				      nodes[j].name, node->name, node->port);
+		}
+		if ((node->listen_fd =
+		     slurm_init_msg_engine_port(node->port)) < 0)
+			fatal("Unable to bind port %hu for node %s: %m",
+			      node->port, node->name);
+		fd_set_close_on_exec(node->listen_fd);
+	}
+}
+
+static int _sort_by_end_time(void *x, void *y)
+{
+	emu_job_t *job1 = *(emu_job_t **) x;
+	emu_job_t *job2 = *(emu_job_t **) y;
+
+	if (job1->end_time < job2->end_time)
+		return -1;
+	return (job1->end_time > job2->end_time);
+}
+
+static int _find_job(void *x, void *key)
+{
+	emu_job_t *job = x;
+
+	return (job->job_id == *(uint32_t *) key);
+}
+
+static bool _authorized_user(slurm_msg_t *msg)
+{
+	if ((msg->auth_uid == 0) ||
+	    (msg->auth_uid == slurm_conf.slurm_user_id))
+		return true;
+
+	error("Security violation, %s RPC from uid %u",
+	      rpc_num2string(msg->msg_type), msg->auth_uid);
+	return false;
+}
+
+static void _send_registration(int node_inx)
+{
+	emu_node_t *node = &nodes[node_inx];
+	slurm_node_registration_status_msg_t reg;
+	slurm_msg_t req, resp;
+	struct utsname buf;
+	ListIterator itr;
+	emu_job_t *job;
+	int i = 0;
+
+	memset(&reg, 0, sizeof(reg));
+	uname(&buf);
+	reg.node_name = node->name;
+	reg.version = SLURM_VERSION_STRING;
+	reg.arch = buf.machine;
+	reg.os = buf.sysname;
+	reg.cpus = node->cpus;
+	reg.boards = node->boards;
+	reg.sockets = node->sockets;
+	reg.cores = node->cores;
+	reg.threads = node->threads;
+	reg.real_memory = node->real_memory;
+	reg.free_mem = node->real_memory;
+	reg.tmp_disk = node->tmp_disk;
+	reg.hash_val = slurm_conf.hash_val;
+	reg.slurmd_start_time = node->boot_time;
+	reg.up_time = time(NULL) - node->boot_time;
+	reg.timestamp = time(NULL);
+
+	/* Empty GRES configuration, as packed by gres_node_config_pack() */
+	reg.gres_info = init_buf(16);
+	pack16(SLURM_PROTOCOL_VERSION, reg.gres_info);
+	pack16(0, reg.gres_info);
+
+	slurm_mutex_lock(&job_mutex);
+	reg.step_id = xcalloc(list_count(job_list), sizeof(*reg.step_id));
+	itr = list_iterator_create(job_list);
+	while ((job = list_next(itr))) {
+		if (job->node_inx != node_inx)
+			continue;
+		reg.step_id[i].job_id = job->job_id;
+		reg.step_id[i].step_id = SLURM_BATCH_SCRIPT;
+		reg.step_id[i].step_het_comp = NO_VAL;
+		i++;
+	}
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&job_mutex);
+	reg.job_count = i;
+
+	slurm_msg_t_init(&req);
+	slurm_msg_t_init(&resp);
+	req.msg_type = MESSAGE_NODE_REGISTRATION_STATUS;
+	req.data = &reg;
+
+	if (slurm_send_recv_controller_msg(&req, &resp, NULL) < 0) {
+		error("Unable to register node %s: %m", node->name);
+		slurm_mutex_lock(&reg_mutex);
+		reg_fail++;
+		slurm_mutex_unlock(&reg_mutex);
+	} else
+		slurm_free_msg_data(resp.msg_type, resp.data);
+
+	xfree(reg.step_id);
+	free_buf(reg.gres_info);
+}
+
+static void *_registration_thread(void *arg)
+{
+	int node_inx;
+
+	while (!shutdown_emu) {
+		slurm_mutex_lock(&reg_mutex);
+		node_inx = reg_next++;
+		slurm_mutex_unlock(&reg_mutex);
+		if (node_inx >= node_cnt)
+			break;
+		_send_registration(node_inx);
+	}
+
+	return NULL;
+}
+
+/* Register all nodes, reg_threads at a time, as after a cluster restart */
+static void _register_all(void)
+{
+	pthread_t *tids;
+	int i, cnt = MIN(reg_threads, node_cnt);
+	DEF_TIMERS;
+
+	START_TIMER;
+	tids = xcalloc(cnt, sizeof(pthread_t));
+	for (i = 0; i < cnt; i++)
+		slurm_thread_create(&tids[i], _registration_thread, NULL);
+	for (i = 0; i < cnt; i++)
+		pthread_join(tids[i], NULL);
+	xfree(tids);
+	END_TIMER;
+
+	info("Registered %d nodes (%d failed) in %ld usec",
+	     node_cnt - reg_fail, reg_fail, DELTA_TIMER);
+}
+
+static void _send_epilog_complete(uint32_t job_id, int node_inx)
+{
+	slurm_msg_t msg;
+	epilog_complete_msg_t req;
+
+	slurm_msg_t_init(&msg);
+	memset(&req, 0, sizeof(req));
+	req.job_id = job_id;
+	req.node_name = nodes[node_inx].name;
+	msg.msg_type = MESSAGE_EPILOG_COMPLETE;
+	msg.data = &req;
+
+	/* slurmctld resends REQUEST_TERMINATE_JOB if this is lost */
+	if (slurm_send_only_controller_msg(&msg, NULL) < 0)
+		error("Unable to send epilog complete for JobId=%u from %s: %m",
+		      job_id, nodes[node_inx].name);
+}
+
+static void _send_prolog_complete(uint32_t job_id)
+{
+	slurm_msg_t msg;
+	complete_prolog_msg_t req;
+	int rc;
+
+	slurm_msg_t_init(&msg);
+	memset(&req, 0, sizeof(req));
+	req.job_id = job_id;
+	msg.msg_type = REQUEST_COMPLETE_PROLOG;
+	msg.data = &req;
+
+	if (slurm_send_recv_controller_rc_msg(&msg, &rc, NULL))
+		error("Unable to send prolog complete for JobId=%u: %m",
+		      job_id);
+}
+
+static void _send_batch_complete(emu_job_t *job)
+{
+	slurm_msg_t msg;
+	complete_batch_script_msg_t req;
+	int rc, retry;
+
+	slurm_msg_t_init(&msg);
+	memset(&req, 0, sizeof(req));
+	req.job_id = job->job_id;
+	req.user_id = job->user_id;
+	req.node_name = nodes[job->node_inx].name;
+	msg.msg_type = REQUEST_COMPLETE_BATCH_SCRIPT;
+	msg.data = &req;
+
+	for (retry = 0; retry < 5; retry++) {
+		if (!slurm_send_recv_controller_rc_msg(&msg, &rc, NULL))
+			break;
+		error("Unable to send batch complete for JobId=%u: %m",
+		      job->job_id);
+		sleep(retry + 1);
+	}
+}
+
+/* Report batch jobs complete once their sampled run time has passed */
+static void *_job_complete_thread(void *arg)
+{
+	struct timespec ts = {0, 0};
+	emu_job_t *job;
+	time_t now;
+
+	slurm_mutex_lock(&job_mutex);
+	while (!shutdown_emu) {
+		now = time(NULL);
+		job = list_peek(job_list);
+		if (!job || (job->end_time > now)) {
+			ts.tv_sec = job ? job->end_time : (now + 1);
+			ts.tv_sec = MIN(ts.tv_sec, now + 1);
+			slurm_cond_timedwait(&job_cond, &job_mutex, &ts);
+			continue;
+		}
+		job = list_pop(job_list);
+		slurm_mutex_unlock(&job_mutex);
+
+		_send_batch_complete(job);
+		slurm_mutex_lock(&stat_mutex);
+		jobs_completed++;
+		slurm_mutex_unlock(&stat_mutex);
+		xfree(job);
+
+		slurm_mutex_lock(&job_mutex);
+	}
+	slurm_mutex_unlock(&job_mutex);
+
+	return NULL;
+}
+
+static int _rpc_batch_job(slurm_msg_t *msg, int node_inx)
+{
+	batch_job_launch_msg_t *req = msg->data;
+	emu_job_t *job = xmalloc(sizeof(*job));
+	char *run_time;
+
+	job->job_id = req->job_id;
+	job->user_id = req->uid;
+	job->node_inx = node_inx;
+	/* Jobs replayed from a trace by rpc_replay carry their run time */
+	if ((run_time = getenvp(req->environment, "EMULATOR_RUN_TIME"))) {
+		job->end_time = time(NULL) + strtoul(run_time, NULL, 10);
+	} else {
+		job->end_time = time(NULL) + run_min;
+		if (run_max > run_min)
+			job->end_time += random() % (run_max - run_min + 1);
+	}
+
+	slurm_mutex_lock(&job_mutex);
+	list_append(job_list, job);
+	list_sort(job_list, _sort_by_end_time);
+	slurm_cond_signal(&job_cond);
+	slurm_mutex_unlock(&job_mutex);
+
+	slurm_mutex_lock(&stat_mutex);
+	jobs_started++;
+	slurm_mutex_unlock(&stat_mutex);
+
+	debug("Launched JobId=%u on %s", req->job_id, nodes[node_inx].name);
+	return SLURM_SUCCESS;
+}
+
+static void _rpc_ping(slurm_msg_t *msg, int node_inx)
+{
+	slurm_msg_t resp_msg;
+	ping_slurmd_resp_msg_t ping_resp;
+
+	ping_resp.cpu_load = 0;
+	ping_resp.free_mem = nodes[node_inx].real_memory;
+	slurm_msg_t_copy(&resp_msg, msg);
+	resp_msg.msg_type = RESPONSE_PING_SLURMD;
+	resp_msg.data = &ping_resp;
+	slurm_send_node_msg(msg->conn_fd, &resp_msg);
+
+	if (msg->msg_type == REQUEST_NODE_REGISTRATION_STATUS)
+		_send_registration(node_inx);
+}
+
+static void _rpc_acct_gather_update(slurm_msg_t *msg, int node_inx)
+{
+	slurm_msg_t resp_msg;
+	acct_gather_node_resp_msg_t acct_msg;
+
+	memset(&acct_msg, 0, sizeof(acct_msg));
+	acct_msg.node_name = nodes[node_inx].name;
+	acct_msg.sensor_cnt = 1;
+	acct_msg.energy = acct_gather_energy_alloc(acct_msg.sensor_cnt);
+
+	slurm_msg_t_copy(&resp_msg, msg);
+	resp_msg.msg_type = RESPONSE_ACCT_GATHER_UPDATE;
+	resp_msg.data = &acct_msg;
+	slurm_send_node_msg(msg->conn_fd, &resp_msg);
+
+	acct_gather_energy_destroy(acct_msg.energy);
+}
+
+/* Forget a running job, RET true if it was running on this node */
+static bool _kill_job(uint32_t job_id, int node_inx)
+{
+	emu_job_t *job;
+	bool found = false;
+
+	slurm_mutex_lock(&job_mutex);
+	job = list_find_first(job_list, _find_job, &job_id);
+	if (job && (job->node_inx == node_inx)) {
+		list_remove_first(job_list, _find_job, &job_id);
+		xfree(job);
+		found = true;
+	}
+	slurm_mutex_unlock(&job_mutex);
+
+	return found;
+}
+
+static void _process_rpc(slurm_msg_t *msg, int node_inx)
+{
+	kill_job_msg_t *kill_req;
+	int rc = SLURM_SUCCESS;
+
+	if (!_authorized_user(msg)) {
+		slurm_send_rc_msg(msg, ESLURM_USER_ID_MISSING);
+		return;
+	}
+
+	switch (msg->msg_type) {
+	case REQUEST_PING:
+	case REQUEST_NODE_REGISTRATION_STATUS:
+		_rpc_ping(msg, node_inx);
+		return;
+	case REQUEST_ACCT_GATHER_UPDATE:
+		_rpc_acct_gather_update(msg, node_inx);
+		return;
+	case REQUEST_BATCH_JOB_LAUNCH:
+		rc = _rpc_batch_job(msg, node_inx);
+		break;
+	case REQUEST_LAUNCH_PROLOG:
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		_send_prolog_complete(
+			((prolog_launch_msg_t *) msg->data)->job_id);
+		return;
+	case REQUEST_TERMINATE_JOB:
+	case REQUEST_KILL_PREEMPTED:
+	case REQUEST_KILL_TIMELIMIT:
+		kill_req = msg->data;
+		slurm_send_rc_msg(msg, SLURM_SUCCESS);
+		(void) _kill_job(kill_req->step_id.job_id, node_inx);
+		_send_epilog_complete(kill_req->step_id.job_id, node_inx);
+		return;
+	case REQUEST_ABORT_JOB:
+		kill_req = msg->data;
+		(void) _kill_job(kill_req->step_id.job_id, node_inx);
+		break;
+	case REQUEST_LAUNCH_TASKS:
+		/* No slurmstepd to run tasks or I/O for srun */
+		rc = ESLURM_NOT_SUPPORTED;
+		break;
+	case REQUEST_RECONFIGURE:
+	case REQUEST_RECONFIGURE_WITH_CONFIG:
+		/* No reply, slurmd registers again once reconfigured */
+		forward_wait(msg);
+		_send_registration(node_inx);
+		return;
+	case REQUEST_REBOOT_NODES:
+		/* Reboot instantly, slurmctld sees the new boot time */
+		forward_wait(msg);
+		nodes[node_inx].boot_time = time(NULL);
+		_send_registration(node_inx);
+		return;
+	case REQUEST_SHUTDOWN:
+		/* No reply, the emulated nodes keep running */
+		forward_wait(msg);
+		return;
+	case REQUEST_HEALTH_CHECK:
+	case REQUEST_SIGNAL_TASKS:
+	case REQUEST_SUSPEND_INT:
+	case REQUEST_TERMINATE_TASKS:
+		break;
+	default:
+		error("Unsupported RPC %s on node %s",
+		      rpc_num2string(msg->msg_type), nodes[node_inx].name);
+		rc = EINVAL;
+		break;
+	}
+
+	slurm_send_rc_msg(msg, rc);
+}
+
+static void *_service_connection(void *arg)
+{
+	emu_conn_t *conn = arg;
+	slurm_msg_t *msg = xmalloc(sizeof(slurm_msg_t));
+	int rc;
+
+	slurm_msg_t_init(msg);
+	if ((rc = slurm_receive_msg_and_forward(conn->fd, &conn->cli_addr,
+						msg))) {
+		error("%s: slurm_receive_msg for node %s: %m",
+		      __func__, nodes[conn->node_inx].name);
+		/* Let the nodes we forward to be accounted for */
+		slurm_send_rc_msg(msg, rc);
+	} else {
+		debug2("Processing RPC %s on node %s",
+		       rpc_num2string(msg->msg_type),
+		       nodes[conn->node_inx].name);
+		_process_rpc(msg, conn->node_inx);
+	}
+
+	if (msg->conn_fd >= 0)
+		close(msg->conn_fd);
+	slurm_free_msg(msg);
+	xfree(conn);
+
+	slurm_mutex_lock(&stat_mutex);
+	rpc_cnt++;
+	slurm_mutex_unlock(&stat_mutex);
+
+	return NULL;
+}
+
+static void _sig_handler(int signal)
+{
+	shutdown_emu = true;
+}
+
+int main(int argc, char **argv)
+{
+	log_options_t logopt = LOG_OPTS_STDERR_ONLY;
+	struct pollfd *pfds;
+	pthread_t complete_tid;
+	int i;
+
+	slurm_conf_init(NULL);
+	log_init(xbasename(argv[0]), logopt, 0, NULL);
+	_parse_args(argc, argv, &logopt);
+	log_alter(logopt, 0, NULL);
+
+	xsignal(SIGPIPE, SIG_IGN);
+	xsignal(SIGINT, _sig_handler);
+	xsignal(SIGTERM, _sig_handler);
+	rlimits_increase_nofile();
+	srandom(getpid());
+	start_time = time(NULL);
+
+	job_list = list_create(xfree_ptr);
+	_init_nodes();
+	info("Emulating %d nodes: %s", node_cnt, node_list);
+
+	slurm_thread_create(&complete_tid, _job_complete_thread, NULL);
+	_register_all();
+
+	pfds = xcalloc(node_cnt, sizeof(struct pollfd));
+	for (i = 0; i < node_cnt; i++) {
+		pfds[i].fd = nodes[i].listen_fd;
+		pfds[i].events = POLLIN;
+	}
+
+	while (!shutdown_emu) {
+		int n = poll(pfds, node_cnt, 1000);
+
+		if ((n < 0) && (errno != EINTR))
+			fatal("poll: %m");
+		for (i = 0; (n > 0) && (i < node_cnt); i++) {
+			emu_conn_t *conn;
+			int fd;
+
+			if (!(pfds[i].revents & POLLIN))
+				continue;
+			n--;
+			conn = xmalloc(sizeof(*conn));
+			fd = slurm_accept_msg_conn(pfds[i].fd,
+						   &conn->cli_addr);
+			if (fd < 0) {
+				if (errno != EINTR)
+					error("accept on node %s: %m",
+					      nodes[i].name);
+				xfree(conn);
+				continue;
+			}
+			fd_set_close_on_exec(fd);
+			conn->fd = fd;
+			conn->node_inx = i;
+			slurm_thread_create_detached(NULL, _service_connection,
+						     conn);
+		}
+	}
+
+	slurm_mutex_lock(&job_mutex);
+	slurm_cond_signal(&job_cond);
+	slurm_mutex_unlock(&job_mutex);
+	pthread_join(complete_tid, NULL);
+
+	slurm_mutex_lock(&stat_mutex);
+	info("Shutting down: %"PRIu64" RPCs processed, %u batch jobs started, %u completed",
+	     rpc_cnt, jobs_started, jobs_completed);
+	slurm_mutex_unlock(&stat_mutex);
+
+	for (i = 0; i < node_cnt; i++) {
+		close(nodes[i].listen_fd);
+		xfree(nodes[i].name);
+	}
+	xfree(nodes);
+	xfree(pfds);
+	xfree(node_list);
+	FREE_NULL_LIST(job_list);
+
+	return 0;
+}
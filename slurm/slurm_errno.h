@@ -247,6 +247,7 @@ enum {
 	ESLURMD_STEP_NOTSUSPENDED,
 	ESLURMD_INVALID_SOCKET_NAME_LEN =		4030,
 	ESLURMD_CONTAINER_RUNTIME_INVALID,
+	ESLURMD_SBCAST_CACHE_MISS,
 
 	/* slurmd errors in user batch job */
 	ESCRIPT_CHDIR_FAILED =			4100,
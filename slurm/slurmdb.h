@@ -258,6 +258,13 @@ typedef struct {
 	char *type;     /* Type of TRES (CPU, MEM, etc) */
 } slurmdb_tres_rec_t;
 
+/*
+ * with_usage value for slurmdb_assoc_cond_t and slurmdb_wckey_cond_t to get
+ * a single accounting record per TRES summed over usage_start to usage_end
+ * instead of one per usage period (any other non-zero value).
+ */
+#define SLURMDB_USAGE_SUMMED 2
+
 /* slurmdb_assoc_cond_t is used in other structures below so
  * this needs to be declared first.
  */
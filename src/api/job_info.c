@@ -1330,6 +1330,30 @@ extern int slurm_job_batch_script(FILE *out, uint32_t jobid)
 extern int
 slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 		 uint16_t show_flags)
+{
+	return slurm_load_jobs_filter(update_time, job_info_msg_pptr,
+				      show_flags, NULL, NULL, NULL, NULL, NULL);
+}
+
+/*
+ * slurm_load_jobs_filter - same as slurm_load_jobs(), but only jobs matching
+ *	all given filters are sent by slurmctld
+ * IN update_time - time of current configuration data
+ * IN/OUT job_info_msg_pptr - place to store a job configuration pointer
+ * IN show_flags - job filtering options
+ * IN accounts - comma delimited list of account names
+ * IN job_id_list - list of job, job array or hetjob IDs to be reported
+ * IN partitions - comma delimited list of partition names
+ * IN state_list - list of job states to be reported
+ * IN uid_list - list of user IDs to be reported
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int slurm_load_jobs_filter(time_t update_time,
+				  job_info_msg_t **job_info_msg_pptr,
+				  uint16_t show_flags, char *accounts,
+				  List job_id_list, char *partitions,
+				  List state_list, List uid_list)
 {
 	slurm_msg_t req_msg;
 	job_info_request_msg_t req;
@@ -1359,6 +1383,11 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	memset(&req, 0, sizeof(req));
 	req.last_update  = update_time;
 	req.show_flags   = show_flags;
+	req.accounts     = accounts;
+	req.job_id_list  = job_id_list;
+	req.partitions   = partitions;
+	req.state_list   = state_list;
+	req.uid_list     = uid_list;
 	req_msg.msg_type = REQUEST_JOB_INFO;
 	req_msg.data     = &req;
 
@@ -1377,6 +1406,150 @@ slurm_load_jobs (time_t update_time, job_info_msg_t **job_info_msg_pptr,
 	return rc;
 }
 
+static int _sort_job_id(const void *a, const void *b)
+{
+	const slurm_job_info_t *job1 = *(slurm_job_info_t **) a;
+	const slurm_job_info_t *job2 = *(slurm_job_info_t **) b;
+
+	if (job1->job_id < job2->job_id)
+		return -1;
+	if (job1->job_id > job2->job_id)
+		return 1;
+	return 0;
+}
+
+/*
+ * Move the records of old_ptr over to the records of a delta reply left
+ * unchanged by slurmctld. Moved records are cleared in old_ptr.
+ * RET SLURM_ERROR, leaving old_ptr as it was, if an unchanged record is not
+ *	found in old_ptr
+ */
+static int _merge_job_delta(job_info_msg_t *new_ptr, job_info_msg_t *old_ptr)
+{
+	slurm_job_info_t **old_jobs, **found, *job_ptr, key, *key_ptr = &key;
+	int i, pass, rc = SLURM_SUCCESS;
+
+	old_jobs = xcalloc(old_ptr->record_count + 1,
+			   sizeof(slurm_job_info_t *));
+	for (i = 0; i < old_ptr->record_count; i++)
+		old_jobs[i] = &old_ptr->job_array[i];
+	qsort(old_jobs, old_ptr->record_count, sizeof(slurm_job_info_t *),
+	      _sort_job_id);
+
+	/* Find every record before moving any, so a failure changes nothing */
+	for (pass = 0; (pass < 2) && (rc == SLURM_SUCCESS); pass++) {
+		for (i = 0, job_ptr = new_ptr->job_array;
+		     i < new_ptr->record_count; i++, job_ptr++) {
+			if (job_ptr->job_state != NO_VAL)
+				continue;
+			key.job_id = job_ptr->job_id;
+			found = bsearch(&key_ptr, old_jobs,
+					old_ptr->record_count,
+					sizeof(slurm_job_info_t *),
+					_sort_job_id);
+			if (!found || ((*found)->job_state == NO_VAL)) {
+				rc = SLURM_ERROR;
+				break;
+			}
+			if (!pass)
+				continue;
+
+			*job_ptr = **found;
+			/* Keep the job_id, old_jobs stays sorted */
+			memset(*found, 0, sizeof(slurm_job_info_t));
+			(*found)->job_id = key.job_id;
+			(*found)->job_state = NO_VAL;
+
+			/* As set by _unpack_job_info_msg() */
+			if (IS_JOB_PENDING(job_ptr) && job_ptr->start_time &&
+			    (job_ptr->start_time < new_ptr->last_update)) {
+				job_ptr->start_time = new_ptr->last_update;
+				if (job_ptr->time_limit != NO_VAL)
+					job_ptr->end_time = MAX(
+						job_ptr->end_time,
+						(job_ptr->start_time +
+						 job_ptr->time_limit * 60));
+			}
+			job_ptr->bitflags &= (~BACKFILL_LAST);
+			if ((job_ptr->bitflags & BACKFILL_SCHED) &&
+			    new_ptr->last_backfill &&
+			    IS_JOB_PENDING(job_ptr) &&
+			    (new_ptr->last_backfill <=
+			     job_ptr->last_sched_eval))
+				job_ptr->bitflags |= BACKFILL_LAST;
+		}
+	}
+	xfree(old_jobs);
+
+	return rc;
+}
+
+/*
+ * slurm_load_jobs_delta - refresh job information previously returned by
+ *	slurm_load_jobs_filter() with the same filters. Only records changed
+ *	since old_job_ptr was loaded are sent by slurmctld, the remaining
+ *	records are moved over from old_job_ptr. Falls back to a full load
+ *	when needed.
+ * IN old_job_ptr - job information from a previous load, may be NULL.
+ *	Records moved into *job_info_msg_pptr are cleared, the caller must
+ *	still free it
+ * OUT job_info_msg_pptr - place to store a job configuration pointer
+ * IN show_flags - job filtering options
+ * IN accounts, job_id_list, partitions, state_list, uid_list - filters as
+ *	for slurm_load_jobs_filter()
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_job_info_msg
+ */
+extern int slurm_load_jobs_delta(job_info_msg_t *old_job_ptr,
+				 job_info_msg_t **job_info_msg_pptr,
+				 uint16_t show_flags, char *accounts,
+				 List job_id_list, char *partitions,
+				 List state_list, List uid_list)
+{
+	slurm_msg_t req_msg;
+	job_info_request_msg_t req;
+	job_info_msg_t *new_ptr = NULL;
+	int rc;
+
+	if (!old_job_ptr || !old_job_ptr->last_update ||
+	    (show_flags & SHOW_FEDERATION))
+		return slurm_load_jobs_filter(old_job_ptr ?
+					      old_job_ptr->last_update : 0,
+					      job_info_msg_pptr, show_flags,
+					      accounts, job_id_list,
+					      partitions, state_list,
+					      uid_list);
+
+	slurm_msg_t_init(&req_msg);
+	memset(&req, 0, sizeof(req));
+	req.last_update  = old_job_ptr->last_update;
+	req.show_flags   = show_flags | SHOW_DELTA | SHOW_LOCAL;
+	req.accounts     = accounts;
+	req.job_id_list  = job_id_list;
+	req.partitions   = partitions;
+	req.state_list   = state_list;
+	req.uid_list     = uid_list;
+	req_msg.msg_type = REQUEST_JOB_INFO;
+	req_msg.data     = &req;
+
+	rc = _load_cluster_jobs(&req_msg, &new_ptr, working_cluster_rec);
+	if ((rc != SLURM_SUCCESS) || !new_ptr) {
+		*job_info_msg_pptr = new_ptr;
+		return rc;
+	}
+
+	if (_merge_job_delta(new_ptr, old_job_ptr) != SLURM_SUCCESS) {
+		slurm_free_job_info_msg(new_ptr);
+		return slurm_load_jobs_filter(0, job_info_msg_pptr,
+					      show_flags, accounts,
+					      job_id_list, partitions,
+					      state_list, uid_list);
+	}
+
+	*job_info_msg_pptr = new_ptr;
+	return SLURM_SUCCESS;
+}
+
 /*
  * slurm_load_job_user - issue RPC to get slurm information about all jobs
  *	to be run as the specified user
@@ -1478,6 +1651,51 @@ slurm_load_job (job_info_msg_t **job_info_msg_pptr, uint32_t job_id,
 	return rc;
 }
 
+/*
+ * slurm_load_job_sched_trace - issue RPC to get the most recent scheduling
+ *	attempts of one job, as kept by slurmctld
+ * IN job_id - ID of job we want information about
+ * OUT resp - place to store the trace
+ * RET 0 or -1 on error
+ * NOTE: free the response using slurm_free_sched_trace_msg
+ */
+extern int slurm_load_job_sched_trace(uint32_t job_id,
+				      sched_trace_msg_t **resp)
+{
+	int rc;
+	slurm_msg_t req_msg, resp_msg;
+	job_id_msg_t req;
+
+	slurm_msg_t_init(&req_msg);
+	slurm_msg_t_init(&resp_msg);
+	memset(&req, 0, sizeof(req));
+	req.job_id = job_id;
+	req_msg.msg_type = REQUEST_JOB_SCHED_TRACE;
+	req_msg.data = &req;
+
+	if (slurm_send_recv_controller_msg(&req_msg, &resp_msg,
+					   working_cluster_rec) < 0)
+		return SLURM_ERROR;
+
+	switch (resp_msg.msg_type) {
+	case RESPONSE_JOB_SCHED_TRACE:
+		*resp = (sched_trace_msg_t *) resp_msg.data;
+		break;
+	case RESPONSE_SLURM_RC:
+		rc = ((return_code_msg_t *) resp_msg.data)->return_code;
+		slurm_free_return_code_msg(resp_msg.data);
+		*resp = NULL;
+		if (rc)
+			slurm_seterrno_ret(rc);
+		break;
+	default:
+		slurm_seterrno_ret(SLURM_UNEXPECTED_MSG_ERROR);
+		break;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 /*
  * slurm_pid2jobid - issue RPC to get the slurm job_id given a process_id
  *	on this machine
@@ -765,6 +765,67 @@ extern int slurm_load_node2(time_t update_time, node_info_msg_t **resp,
 	return _load_cluster_nodes(&req_msg, resp, cluster, show_flags);
 }
 
+/*
+ * slurm_load_node_delta - refresh node information previously returned by
+ *	slurm_load_node(). Only records changed since old_node_ptr was loaded
+ *	are sent by slurmctld, the remaining records are moved over from
+ *	old_node_ptr. Falls back to a full load when needed.
+ * IN old_node_ptr - node information from a previous load, may be NULL.
+ *	Records moved into *resp are cleared, the caller must still free it
+ * OUT resp - place to store a node configuration pointer
+ * IN show_flags - node filtering options
+ * RET 0 or a slurm error code
+ * NOTE: free the response using slurm_free_node_info_msg
+ */
+extern int slurm_load_node_delta(node_info_msg_t *old_node_ptr,
+				 node_info_msg_t **resp, uint16_t show_flags)
+{
+	slurm_msg_t req_msg;
+	node_info_request_msg_t req;
+	node_info_msg_t *new_ptr = NULL;
+	node_info_t *node_ptr;
+	int i, rc;
+
+	if (!old_node_ptr || (show_flags & SHOW_FEDERATION))
+		return slurm_load_node(old_node_ptr ?
+				       old_node_ptr->last_update : 0,
+				       resp, show_flags);
+
+	slurm_msg_t_init(&req_msg);
+	memset(&req, 0, sizeof(req));
+	req.last_update  = old_node_ptr->last_update;
+	req.show_flags   = show_flags | SHOW_DELTA | SHOW_LOCAL;
+	req_msg.msg_type = REQUEST_NODE_INFO;
+	req_msg.data     = &req;
+
+	/* MIXED is set below, once unchanged records are filled in */
+	rc = _load_cluster_nodes(&req_msg, &new_ptr, working_cluster_rec,
+				 show_flags & (~SHOW_MIXED));
+	if ((rc != SLURM_SUCCESS) || !new_ptr) {
+		*resp = new_ptr;
+		return rc;
+	}
+
+	/* Node table rebuilt by slurmctld, unchanged records do not apply */
+	if (new_ptr->record_count != old_node_ptr->record_count) {
+		slurm_free_node_info_msg(new_ptr);
+		return slurm_load_node(0, resp, show_flags);
+	}
+
+	for (i = 0, node_ptr = new_ptr->node_array;
+	     i < new_ptr->record_count; i++, node_ptr++) {
+		if (node_ptr->name || (node_ptr->node_state != NO_VAL))
+			continue;
+		*node_ptr = old_node_ptr->node_array[i];
+		memset(&old_node_ptr->node_array[i], 0, sizeof(node_info_t));
+	}
+	if (show_flags & SHOW_MIXED)
+		_set_node_mixed(new_ptr);
+
+	*resp = new_ptr;
+	return SLURM_SUCCESS;
+}
+
 /*
  * slurm_load_node_single - issue RPC to get slurm configuration information
  *	for a specific node
@@ -35,6 +35,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <sys/select.h>
+#include <sys/uio.h>
 #include <stdio.h>
 #include <string.h>
 #include <time.h>
@@ -60,6 +61,7 @@
 #include "src/api/step_launch.h"
 
 #define STDIO_MAX_FREE_BUF 1024
+#define STDIO_MAX_WRITEV 64	/* queued messages sent by one server write */
 
 struct io_buf {
 	int ref_count;
@@ -146,6 +148,9 @@ struct file_write_info {
 	List msg_queue;
 	struct io_buf *out_msg;
 	int32_t out_remaining;
+	/* Record of a SLURM_IO_MULTI out_msg currently being written */
+	io_hdr_t rec_header;
+	int32_t rec_remaining;
 	/* If taskid is (uint32_t)-1, output from all tasks is accepted,
 	   otherwise only output from the specified task is accepted. */
 	uint32_t taskid;
@@ -281,6 +286,31 @@ _server_readable(eio_obj_t *obj)
 	return false;
 }
 
+/*
+ * Unpack the header of a record in the body of a SLURM_IO_MULTI message.
+ */
+static int _unpack_multi_header(void *data, int32_t len, io_hdr_t *header)
+{
+	buf_t *buffer;
+	int rc;
+
+	if (len < io_hdr_packed_size())
+		return SLURM_ERROR;
+
+	buffer = create_buf(data, io_hdr_packed_size());
+	rc = io_hdr_unpack(header, buffer);
+	/* free the buffer structure, but not the memory to which it points */
+	buffer->head = NULL;
+	free_buf(buffer);
+
+	if ((rc == SLURM_SUCCESS) &&
+	    (!header->length ||
+	     (header->length > (len - io_hdr_packed_size()))))
+		rc = SLURM_ERROR;
+
+	return rc;
+}
+
 static int
 _server_read(eio_obj_t *obj, List objs)
 {
@@ -415,9 +445,17 @@ _server_read(eio_obj_t *obj, List objs)
 	{
 		eio_obj_t *obj;
 		struct file_write_info *info;
+		io_hdr_t rec_header;
+		uint16_t type = s->in_msg->header.type;
+
+		/* All records of a multi message are for the same stream */
+		if ((type == SLURM_IO_MULTI) &&
+		    !_unpack_multi_header(s->in_msg->data, s->in_msg->length,
+					  &rec_header))
+			type = rec_header.type;
 
 		s->in_msg->ref_count = 1;
-		if (s->in_msg->header.type == SLURM_IO_STDOUT)
+		if (type == SLURM_IO_STDOUT)
 			obj = s->cio->stdout_obj;
 		else
 			obj = s->cio->stderr_obj;
@@ -460,12 +498,28 @@ _server_writable(eio_obj_t *obj)
 	return false;
 }
 
+/* Return a message fully sent to this server to the free list if unused */
+static void _server_msg_done(struct server_io_info *s)
+{
+	s->out_msg->ref_count--;
+	if (s->out_msg->ref_count == 0) {
+		slurm_mutex_lock(&s->cio->ioservers_lock);
+		list_enqueue(s->cio->free_incoming, s->out_msg);
+		slurm_mutex_unlock(&s->cio->ioservers_lock);
+	} else
+		debug3("  Could not free msg!!");
+	s->out_msg = NULL;
+}
+
 static int
 _server_write(eio_obj_t *obj, List objs)
 {
 	struct server_io_info *s = (struct server_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct iovec iov[STDIO_MAX_WRITEV];
+	struct io_buf *msg;
+	ListIterator iter;
+	int iovcnt;
+	ssize_t n;
 
 	debug4("Entering _server_write");
 
@@ -487,11 +541,25 @@ _server_write(eio_obj_t *obj, List objs)
 	debug3("  s->out_remaining = %d", s->out_remaining);
 
 	/*
-	 * Write message to socket.
+	 * Write the rest of the current message together with the messages
+	 * queued behind it, so that stdin broadcast to many nodes costs one
+	 * system call per node for everything queued rather than one per
+	 * message. Only this thread dequeues, so the head of the queue stays
+	 * the next message to send.
 	 */
-	buf = s->out_msg->data + (s->out_msg->length - s->out_remaining);
+	iov[0].iov_base = s->out_msg->data +
+			  (s->out_msg->length - s->out_remaining);
+	iov[0].iov_len = s->out_remaining;
+	iovcnt = 1;
+	iter = list_iterator_create(s->msg_queue);
+	while ((iovcnt < STDIO_MAX_WRITEV) && (msg = list_next(iter))) {
+		iov[iovcnt].iov_base = msg->data;
+		iov[iovcnt].iov_len = msg->length;
+		iovcnt++;
+	}
+	list_iterator_destroy(iter);
 again:
-	if ((n = write(obj->fd, buf, s->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, iovcnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
@@ -508,22 +576,22 @@ again:
 		}
 	}
 
-	debug3("Wrote %d bytes to socket", n);
-	s->out_remaining -= n;
-	if (s->out_remaining > 0)
-		return SLURM_SUCCESS;
+	debug3("Wrote %zd bytes to socket in %d messages", n, iovcnt);
 
 	/*
-	 * Free the message and prepare to send the next one.
+	 * Free the messages completely sent and prepare to send the next one.
 	 */
-	s->out_msg->ref_count--;
-	if (s->out_msg->ref_count == 0) {
-		slurm_mutex_lock(&s->cio->ioservers_lock);
-		list_enqueue(s->cio->free_incoming, s->out_msg);
-		slurm_mutex_unlock(&s->cio->ioservers_lock);
-	} else
-		debug3("  Could not free msg!!");
-	s->out_msg = NULL;
+	while (s->out_msg && (n >= s->out_remaining)) {
+		n -= s->out_remaining;
+		_server_msg_done(s);
+		if (n > 0) {
+			s->out_msg = list_dequeue(s->msg_queue);
+			if (s->out_msg)
+				s->out_remaining = s->out_msg->length;
+		}
+	}
+	if (s->out_msg)
+		s->out_remaining -= n;
 
 	return SLURM_SUCCESS;
 }
@@ -566,6 +634,54 @@ static bool _file_writable(eio_obj_t *obj)
 	return false;
 }
 
+/*
+ * Write the records of a SLURM_IO_MULTI message, resuming with the record
+ * a previous call could not write in full.
+ */
+static int _file_write_multi(eio_obj_t *obj, struct file_write_info *info)
+{
+	void *ptr;
+	int n;
+
+	while (info->out_remaining > 0) {
+		ptr = info->out_msg->data + (info->out_msg->length
+					     - info->out_remaining);
+		if (!info->rec_remaining) {
+			if (_unpack_multi_header(ptr, info->out_remaining,
+						 &info->rec_header)) {
+				error("%s: discarding malformed message",
+				      __func__);
+				info->out_remaining = 0;
+				break;
+			}
+			info->out_remaining -= io_hdr_packed_size();
+			info->rec_remaining = info->rec_header.length;
+			continue;
+		}
+
+		if ((info->taskid != (uint32_t) -1) &&
+		    (info->rec_header.gtaskid != info->taskid)) {
+			/* we are ignoring messages not from info->taskid */
+			n = info->rec_remaining;
+		} else if ((n = write_labelled_message(obj->fd, ptr,
+						info->rec_remaining,
+						info->rec_header.gtaskid,
+						info->cio->het_job_offset,
+						info->cio->het_job_task_offset,
+						info->cio->label,
+						info->cio->taskid_width)) < 0) {
+			return SLURM_ERROR;
+		}
+		debug3("  wrote %d bytes", n);
+		info->rec_remaining -= n;
+		info->out_remaining -= n;
+		if (info->rec_remaining > 0)
+			break;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 static int _file_write(eio_obj_t *obj, List objs)
 {
 	struct file_write_info *info = (struct file_write_info *) obj->arg;
@@ -584,12 +700,22 @@ static int _file_write(eio_obj_t *obj, List objs)
 			return SLURM_SUCCESS;
 		}
 		info->out_remaining = info->out_msg->length;
+		info->rec_remaining = 0;
 	}
 
 	/*
 	 * Write message to file.
 	 */
-	if ((info->taskid != (uint32_t) -1) &&
+	if (info->out_msg->header.type == SLURM_IO_MULTI) {
+		if (info->eof) {
+			/* this output is closed, discard message */
+		} else if (_file_write_multi(obj, info) != SLURM_SUCCESS) {
+			list_enqueue(info->cio->free_outgoing, info->out_msg);
+			info->eof = true;
+			return SLURM_ERROR;
+		} else if (info->out_remaining > 0)
+			return SLURM_SUCCESS;
+	} else if ((info->taskid != (uint32_t) -1) &&
 	    (info->out_msg->header.gtaskid != info->taskid)) {
 		/* we are ignoring messages not from info->taskid */
 	} else if (!info->eof) {
@@ -752,17 +878,23 @@ again:
 		int i;
 		struct server_io_info *server;
 		for (i = 0; i < info->cio->num_nodes; i++) {
-			msg->ref_count++;
 			if (info->cio->ioserver[i] == NULL)
 				/* client_io_handler_abort() or
 				 * client_io_handler_downnodes() called */
 				verbose("ioserver stream of node %d not yet "
 					"initialized", i);
 			else {
+				msg->ref_count++;
 				server = info->cio->ioserver[i]->arg;
 				list_enqueue(server->msg_queue, msg);
 			}
 		}
+		if (msg->ref_count == 0) {
+			/* No stream left to send it to */
+			slurm_mutex_lock(&info->cio->ioservers_lock);
+			list_enqueue(info->cio->free_incoming, msg);
+			slurm_mutex_unlock(&info->cio->ioservers_lock);
+		}
 	} else if (header.type == SLURM_IO_STDIN) {
 		uint32_t nodeid;
 		struct server_io_info *server;
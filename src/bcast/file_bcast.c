@@ -73,6 +73,13 @@
 
 #define MAX_THREADS      8	/* These can be huge messages, so
 				 * only run MAX_THREADS at one time */
+#define MAX_WINDOW       4	/* Blocks in flight at one time */
+
+typedef struct {
+	struct bcast_parameters *params;
+	file_bcast_msg_t bcast_msg;
+	char *node_list;
+} bcast_block_args_t;
 
 int block_len;				/* block size */
 int fd;					/* source file descriptor */
@@ -80,10 +87,14 @@ void *src;				/* source mmap'd address */
 struct stat f_stat;			/* source file stats */
 job_sbcast_cred_msg_t *sbcast_cred;	/* job alloc info and sbcast cred */
 
+static pthread_mutex_t window_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t window_cond = PTHREAD_COND_INITIALIZER;
+static int window_cnt = 0;		/* blocks in flight */
+static int window_rc = SLURM_SUCCESS;	/* worst return code of those */
+
 static int   _bcast_file(struct bcast_parameters *params);
 static int   _file_bcast(struct bcast_parameters *params,
-			 file_bcast_msg_t *bcast_msg,
-			 job_sbcast_cred_msg_t *sbcast_cred);
+			 file_bcast_msg_t *bcast_msg, char *node_list);
 static int   _file_state(struct bcast_parameters *params);
 static int   _get_job_info(struct bcast_parameters *params);
 
@@ -154,8 +165,7 @@ static int _get_job_info(struct bcast_parameters *params)
 
 /* Issue the RPC to transfer the file's data */
 static int _file_bcast(struct bcast_parameters *params,
-		       file_bcast_msg_t *bcast_msg,
-		       job_sbcast_cred_msg_t *sbcast_cred)
+		       file_bcast_msg_t *bcast_msg, char *node_list)
 {
 	List ret_list = NULL;
 	ListIterator itr;
@@ -169,8 +179,7 @@ static int _file_bcast(struct bcast_parameters *params,
 	msg.forward.tree_width = params->fanout;
 	msg.msg_type = REQUEST_FILE_BCAST;
 
-	ret_list = slurm_send_recv_msgs(sbcast_cred->node_list, &msg,
-					params->timeout);
+	ret_list = slurm_send_recv_msgs(node_list, &msg, params->timeout);
 	if (ret_list == NULL) {
 		error("slurm_send_recv_msgs: %m");
 		exit(1);
@@ -194,6 +203,121 @@ static int _file_bcast(struct bcast_parameters *params,
 	return rc;
 }
 
+/*
+ * Hash the file contents, 64-bit FNV-1a over 8 byte words. Node caches are
+ * private to each user, so this needs to avoid accidental collisions only.
+ */
+static uint64_t _file_hash(void)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL, word;
+	const uint64_t prime = 0x100000001b3ULL;
+	const char *pos = src;
+	int64_t remaining = f_stat.st_size;
+
+	while (remaining >= sizeof(word)) {
+		memcpy(&word, pos, sizeof(word));
+		hash = (hash ^ word) * prime;
+		pos += sizeof(word);
+		remaining -= sizeof(word);
+	}
+	while (remaining-- > 0)
+		hash = (hash ^ (uint8_t) *pos++) * prime;
+
+	return hash ? hash : 1;
+}
+
+/*
+ * Ask every node to create the file from its cache of broadcast files.
+ * RET the nodes that still need the file's data, xfree() it, or NULL
+ */
+static char *_file_bcast_probe(struct bcast_parameters *params,
+			       file_bcast_msg_t *bcast_msg, int *rc)
+{
+	List ret_list = NULL;
+	ListIterator itr;
+	ret_data_info_t *ret_data_info = NULL;
+	hostlist_t miss = hostlist_create(NULL);
+	char *node_list = NULL;
+	int msg_rc;
+	slurm_msg_t msg;
+
+	slurm_msg_t_init(&msg);
+	msg.data = bcast_msg;
+	msg.flags = USE_BCAST_NETWORK;
+	msg.forward.tree_width = params->fanout;
+	msg.msg_type = REQUEST_FILE_BCAST;
+
+	ret_list = slurm_send_recv_msgs(sbcast_cred->node_list, &msg,
+					params->timeout);
+	if (ret_list == NULL) {
+		error("slurm_send_recv_msgs: %m");
+		exit(1);
+	}
+
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		msg_rc = slurm_get_return_code(ret_data_info->type,
+					       ret_data_info->data);
+		if (msg_rc == ESLURMD_SBCAST_CACHE_MISS) {
+			hostlist_push_host(miss, ret_data_info->node_name);
+			continue;
+		} else if (msg_rc == SLURM_SUCCESS)
+			continue;
+
+		error("REQUEST_FILE_BCAST(%s): %s",
+		      ret_data_info->node_name,
+		      slurm_strerror(msg_rc));
+		*rc = MAX(*rc, msg_rc);
+	}
+	list_iterator_destroy(itr);
+	FREE_NULL_LIST(ret_list);
+
+	if (hostlist_count(miss)) {
+		hostlist_sort(miss);
+		node_list = hostlist_ranged_string_xmalloc(miss);
+	}
+	hostlist_destroy(miss);
+
+	return node_list;
+}
+
+/* Send one block of a windowed transfer */
+static void *_bcast_block_thread(void *arg)
+{
+	bcast_block_args_t *args = arg;
+	int rc;
+
+	rc = _file_bcast(args->params, &args->bcast_msg, args->node_list);
+
+	slurm_mutex_lock(&window_mutex);
+	window_rc = MAX(window_rc, rc);
+	window_cnt--;
+	slurm_cond_signal(&window_cond);
+	slurm_mutex_unlock(&window_mutex);
+
+	xfree(args->bcast_msg.block);
+	xfree(args);
+
+	return NULL;
+}
+
+/*
+ * Wait until no more than max_cnt blocks are in flight.
+ * RET the worst return code of the blocks sent so far
+ */
+static int _window_wait(int max_cnt)
+{
+	int rc;
+
+	slurm_mutex_lock(&window_mutex);
+	while (window_cnt > max_cnt)
+		slurm_cond_wait(&window_cond, &window_mutex);
+	rc = window_rc;
+	slurm_mutex_unlock(&window_mutex);
+
+	return rc;
+}
+
 /* load a buffer with data from the file to broadcast,
  * return number of bytes read, zero on end of file */
 static int _get_block_none(char **buffer, int *orig_len, bool *more)
@@ -291,6 +415,9 @@ static int _bcast_file(struct bcast_parameters *params)
 	uint64_t size_uncompressed = 0, size_compressed = 0;
 	uint32_t time_compression = 0;
 	bool more = true;
+	bcast_block_args_t *args;
+	char *node_list = NULL;
+	int tmp_rc;
 	DEF_TIMERS;
 
 	if (params->block_size)
@@ -319,6 +446,31 @@ static int _bcast_file(struct bcast_parameters *params)
 	else
 		params->fanout = MIN(MAX_THREADS, params->fanout);
 
+	/*
+	 * With node caches enabled, an empty first block carrying the hash
+	 * of the file lets nodes that already have it skip the transfer.
+	 */
+	if (f_stat.st_size &&
+	    xstrcasestr(slurm_conf.sbcast_parameters, "CacheSize=")) {
+		START_TIMER;
+		bcast_msg.file_hash = _file_hash();
+		END_TIMER;
+		verbose("file hash = %016"PRIx64" in %s",
+			bcast_msg.file_hash, TIME_STR);
+		bcast_msg.compress = params->compress;
+		node_list = _file_bcast_probe(params, &bcast_msg, &rc);
+		if (!node_list || (rc != SLURM_SUCCESS)) {
+			if (rc == SLURM_SUCCESS)
+				verbose("file found in cache of all nodes");
+			xfree(node_list);
+			xfree(bcast_msg.user_name);
+			return rc;
+		}
+		verbose("sending file to %s", node_list);
+		bcast_msg.block_no++;
+	} else
+		node_list = xstrdup(sbcast_cred->node_list);
+
 	while (more) {
 		START_TIMER;
 		bcast_msg.block_len = _next_block(params, &buffer, &orig_len,
@@ -335,7 +487,31 @@ static int _bcast_file(struct bcast_parameters *params)
 		if (!more)
 			bcast_msg.last_block = 1;
 
-		rc = _file_bcast(params, &bcast_msg, sbcast_cred);
+		/*
+		 * The first block creates the file and the last one sets its
+		 * attributes and closes it, so these are sent on their own.
+		 * Blocks in between are written at their offset by slurmd and
+		 * are sent MAX_WINDOW at a time through the forwarding tree.
+		 */
+		if ((bcast_msg.block_no == 1) || bcast_msg.last_block) {
+			if ((rc = _window_wait(0)) == SLURM_SUCCESS)
+				rc = _file_bcast(params, &bcast_msg,
+						 node_list);
+		} else if ((rc = _window_wait(MAX_WINDOW - 1)) ==
+			   SLURM_SUCCESS) {
+			args = xmalloc(sizeof(*args));
+			args->params = params;
+			args->bcast_msg = bcast_msg;
+			args->node_list = node_list;
+			args->bcast_msg.block = xmalloc(bcast_msg.block_len);
+			memcpy(args->bcast_msg.block, buffer,
+			       bcast_msg.block_len);
+			slurm_mutex_lock(&window_mutex);
+			window_cnt++;
+			slurm_mutex_unlock(&window_mutex);
+			slurm_thread_create_detached(NULL, _bcast_block_thread,
+						     args);
+		}
 		if (rc != SLURM_SUCCESS)
 			break;
 		if (bcast_msg.last_block)
@@ -343,7 +519,11 @@ static int _bcast_file(struct bcast_parameters *params)
 		bcast_msg.block_no++;
 		bcast_msg.block_offset += orig_len;
 	}
+	/* blocks in flight share user_name and node_list */
+	if ((tmp_rc = _window_wait(0)) && (rc == SLURM_SUCCESS))
+		rc = tmp_rc;
 	xfree(bcast_msg.user_name);
+	xfree(node_list);
 	xfree(buffer);
 
 	if (size_uncompressed && (params->compress != 0)) {
@@ -55,8 +55,12 @@ struct bcast_parameters {
 };
 
 typedef struct file_bcast_info {
+	int cache_fd;		/* node cache entry descriptor, or -1 */
+	char *cache_tmp;	/* node cache entry being written */
+	bool cache_error;	/* failed to write cache entry */
 	void *data;		/* mmap of file data */
 	int fd;			/* file descriptor */
+	uint64_t file_hash;	/* content hash, zero if not to be cached */
 	uint64_t file_size;	/* file size */
 	char *fname;		/* filename */
 	gid_t gid;		/* gid of owner */
@@ -38,6 +38,7 @@
 
 #include "assoc_mgr.h"
 
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <pwd.h>
 #include <fcntl.h>
@@ -51,7 +52,14 @@
 #include "src/slurmdbd/read_config.h"
 
 #define ASSOC_HASH_SIZE 1000
-#define ASSOC_HASH_ID_INX(_assoc_id)	(_assoc_id % ASSOC_HASH_SIZE)
+#define ASSOC_HASH_ID_INX(_assoc_id)	(_assoc_id % assoc_hash_size)
+
+/* A state file as last written by dump_assoc_mgr_state() */
+typedef struct {
+	uint32_t hash;		/* of the contents after the header, 0 if none */
+	ino_t ino;
+	time_t mtime;
+} state_file_sig_t;
 
 slurmdb_assoc_rec_t *assoc_mgr_root_assoc = NULL;
 uint32_t g_qos_max_priority = 0;
@@ -71,11 +79,13 @@ List assoc_mgr_wckey_list = NULL;
 
 static int setup_children = 0;
 static pthread_rwlock_t assoc_mgr_locks[ASSOC_MGR_ENTITY_COUNT];
-static pthread_mutex_t assoc_lock_init = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t assoc_lock_init = PTHREAD_ONCE_INIT;
 
 static assoc_init_args_t init_setup;
 static slurmdb_assoc_rec_t **assoc_hash_id = NULL;
 static slurmdb_assoc_rec_t **assoc_hash = NULL;
+static int assoc_hash_size = ASSOC_HASH_SIZE;	/* buckets in both tables */
+static int assoc_hash_cnt = 0;			/* records in both tables */
 static int *assoc_mgr_tres_old_pos = NULL;
 
 static bool _running_cache(void)
@@ -122,25 +132,18 @@ static int _assoc_hash_index(slurmdb_assoc_rec_t *assoc)
 	if (assoc->partition)
 		index += _get_str_inx(assoc->partition);
 
-	index %= ASSOC_HASH_SIZE;
+	index %= assoc_hash_size;
 	if (index < 0)
-		index += ASSOC_HASH_SIZE;
+		index += assoc_hash_size;
 
 	return index;
 
 }
 
-static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc)
+static void _insert_assoc_hash(slurmdb_assoc_rec_t *assoc)
 {
 	int inx = ASSOC_HASH_ID_INX(assoc->id);
 
-	if (!assoc_hash_id)
-		assoc_hash_id = xcalloc(ASSOC_HASH_SIZE,
-					sizeof(slurmdb_assoc_rec_t *));
-	if (!assoc_hash)
-		assoc_hash = xcalloc(ASSOC_HASH_SIZE,
-				     sizeof(slurmdb_assoc_rec_t *));
-
 	assoc->assoc_next_id = assoc_hash_id[inx];
 	assoc_hash_id[inx] = assoc;
 
@@ -149,6 +152,55 @@ static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc)
 	assoc_hash[inx] = assoc;
 }
 
+/*
+ * Rebuild both hash tables with more buckets so the chains stay short as
+ * associations are added.
+ */
+static void _grow_assoc_hash(void)
+{
+	slurmdb_assoc_rec_t **old_hash_id = assoc_hash_id;
+	slurmdb_assoc_rec_t *assoc, *next;
+	int i, old_size = assoc_hash_size;
+
+	assoc_hash_size *= 4;
+	debug2("%s: %d associations, growing hash to %d buckets",
+	       __func__, assoc_hash_cnt, assoc_hash_size);
+	xfree(assoc_hash);
+	assoc_hash_id = xcalloc(assoc_hash_size,
+				sizeof(slurmdb_assoc_rec_t *));
+	assoc_hash = xcalloc(assoc_hash_size, sizeof(slurmdb_assoc_rec_t *));
+
+	/* Every record is in the id table exactly once */
+	for (i = 0; i < old_size; i++) {
+		for (assoc = old_hash_id[i]; assoc; assoc = next) {
+			next = assoc->assoc_next_id;
+			_insert_assoc_hash(assoc);
+		}
+	}
+	xfree(old_hash_id);
+}
+
+static void _add_assoc_hash(slurmdb_assoc_rec_t *assoc)
+{
+	if (!assoc_hash_id)
+		assoc_hash_id = xcalloc(assoc_hash_size,
+					sizeof(slurmdb_assoc_rec_t *));
+	if (!assoc_hash)
+		assoc_hash = xcalloc(assoc_hash_size,
+				     sizeof(slurmdb_assoc_rec_t *));
+
+	if (++assoc_hash_cnt > (assoc_hash_size * 2))
+		_grow_assoc_hash();
+	_insert_assoc_hash(assoc);
+}
+
+static void _free_assoc_hash(void)
+{
+	xfree(assoc_hash_id);
+	xfree(assoc_hash);
+	assoc_hash_cnt = 0;
+}
+
 static bool _remove_from_assoc_list(slurmdb_assoc_rec_t *assoc)
 {
 	slurmdb_assoc_rec_t *assoc_ptr;
@@ -322,6 +374,8 @@ static void _delete_assoc_hash(slurmdb_assoc_rec_t *assoc)
 		return;	/* Fix CLANG false positive error */
 	} else
 		*assoc_pptr = assoc_ptr->assoc_next;
+
+	assoc_hash_cnt--;
 }
 
 
@@ -1021,8 +1075,10 @@ static int _post_assoc_list(void)
 	if (!assoc_mgr_assoc_list)
 		return SLURM_ERROR;
 
-	xfree(assoc_hash_id);
-	xfree(assoc_hash);
+	_free_assoc_hash();
+	/* Size the tables for the whole list up front */
+	assoc_hash_size = MAX(ASSOC_HASH_SIZE,
+			      list_count(assoc_mgr_assoc_list));
 
 	itr = list_iterator_create(assoc_mgr_assoc_list);
 
@@ -2098,8 +2154,8 @@ extern int assoc_mgr_fini(bool save_state)
 	if (_running_cache())
 		*init_setup.running_cache = RUNNING_CACHE_STATE_NOTRUNNING;
 
-	xfree(assoc_hash_id);
-	xfree(assoc_hash);
+	_free_assoc_hash();
+	assoc_hash_size = ASSOC_HASH_SIZE;
 
 	assoc_mgr_unlock(&locks);
 
@@ -2159,18 +2215,21 @@ bool verify_assoc_lock(assoc_mgr_lock_datatype_t datatype, lock_level_t level)
 }
 #endif
 
+static void _init_assoc_mgr_locks(void)
+{
+	for (int i = 0; i < ASSOC_MGR_ENTITY_COUNT; i++)
+		slurm_rwlock_init(&assoc_mgr_locks[i]);
+}
+
 extern void assoc_mgr_lock(assoc_mgr_lock_t *locks)
 {
-	static bool init_run = false;
 	xassert(_store_locks(locks));
 
-	slurm_mutex_lock(&assoc_lock_init);
-	if (!init_run) {
-		init_run = true;
-		for (int i = 0; i < ASSOC_MGR_ENTITY_COUNT; i++)
-			slurm_rwlock_init(&assoc_mgr_locks[i]);
-	}
-	slurm_mutex_unlock(&assoc_lock_init);
+	/*
+	 * Every reader comes through here, so don't serialize them all on a
+	 * mutex just to check whether the locks were initialized.
+	 */
+	pthread_once(&assoc_lock_init, _init_assoc_mgr_locks);
 
 	if (locks->assoc == READ_LOCK)
 		slurm_rwlock_rdlock(&assoc_mgr_locks[ASSOC_LOCK]);
@@ -5292,42 +5351,45 @@ extern void assoc_mgr_remove_qos_usage(slurmdb_qos_rec_t *qos)
 	}
 }
 
-extern int dump_assoc_mgr_state(void)
+/* FNV-1a hash of a state file's contents after its header, never zero */
+static uint32_t _state_file_hash(buf_t *buffer, uint32_t offset)
 {
-	static int high_buffer_size = (1024 * 1024);
-	int error_code = 0, log_fd;
-	char *old_file = NULL, *new_file = NULL, *reg_file = NULL,
-		*tmp_char = NULL;
-	dbd_list_msg_t msg;
-	buf_t *buffer = NULL;
-	assoc_mgr_lock_t locks = { .assoc = READ_LOCK, .file = WRITE_LOCK,
-				   .qos = READ_LOCK, .res = READ_LOCK,
-				   .tres = READ_LOCK, .user = READ_LOCK,
-				   .wckey = READ_LOCK};
-	DEF_TIMERS;
+	unsigned char *data = (unsigned char *) get_buf_data(buffer);
+	uint32_t i, end = get_buf_offset(buffer), hash = 2166136261U;
 
-	xassert(init_setup.state_save_location &&
-		*init_setup.state_save_location);
-
-	START_TIMER;
-
-	/* now make a file for last_tres */
-	buffer = init_buf(high_buffer_size);
+	for (i = offset; i < end; i++) {
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
 
-	/* write header: version, time */
-	pack16(SLURM_PROTOCOL_VERSION, buffer);
-	pack_time(time(NULL), buffer);
+	return hash ? hash : 1;
+}
 
-	assoc_mgr_lock(&locks);
-	if (assoc_mgr_tres_list) {
-		memset(&msg, 0, sizeof(dbd_list_msg_t));
-		msg.my_list = assoc_mgr_tres_list;
-		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
-				       DBD_ADD_TRES, buffer);
+/*
+ * Write a state file from buffer, unless its contents after the header at
+ * hdr_offset are the same as when it was last written and the file has not
+ * been replaced since (e.g. by a backup slurmctld).
+ * IN/OUT last - the file as last written by us
+ * NOTE: Call with the assoc_mgr file write lock
+ */
+static int _write_state_file(buf_t *buffer, uint32_t hdr_offset,
+			     char *name, state_file_sig_t *last)
+{
+	int error_code = 0, log_fd;
+	char *old_file, *new_file, *reg_file;
+	uint32_t hash = _state_file_hash(buffer, hdr_offset);
+	struct stat stat_buf;
+
+	reg_file = xstrdup_printf("%s/%s",
+				  *init_setup.state_save_location, name);
+	if ((hash == last->hash) && !stat(reg_file, &stat_buf) &&
+	    (stat_buf.st_ino == last->ino) &&
+	    (stat_buf.st_mtime == last->mtime)) {
+		debug3("%s: %s unchanged, not saved", __func__, name);
+		xfree(reg_file);
+		return SLURM_SUCCESS;
 	}
 
-	reg_file = xstrdup_printf("%s/last_tres",
-				  *init_setup.state_save_location);
 	old_file = xstrdup_printf("%s.old", reg_file);
 	new_file = xstrdup_printf("%s.new", reg_file);
 
@@ -5339,7 +5401,6 @@ extern int dump_assoc_mgr_state(void)
 	} else {
 		int pos = 0, nwrite = get_buf_offset(buffer), amount;
 		char *data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
 		while (nwrite > 0) {
 			amount = write(log_fd, &data[pos], nwrite);
 			if ((amount < 0) && (errno != EINTR)) {
@@ -5353,9 +5414,10 @@ extern int dump_assoc_mgr_state(void)
 		fsync(log_fd);
 		close(log_fd);
 	}
-	if (error_code)
+	if (error_code) {
 		(void) unlink(new_file);
-	else {			/* file shuffle */
+		last->hash = 0;
+	} else {		/* file shuffle */
 		(void) unlink(old_file);
 		if (link(reg_file, old_file))
 			debug4("unable to create link for %s -> %s: %m",
@@ -5365,11 +5427,62 @@ extern int dump_assoc_mgr_state(void)
 			debug4("unable to create link for %s -> %s: %m",
 			       new_file, reg_file);
 		(void) unlink(new_file);
+		last->hash = 0;
+		if (!stat(reg_file, &stat_buf)) {
+			last->hash = hash;
+			last->ino = stat_buf.st_ino;
+			last->mtime = stat_buf.st_mtime;
+		}
 	}
 	xfree(old_file);
 	xfree(reg_file);
 	xfree(new_file);
 
+	return error_code;
+}
+
+extern int dump_assoc_mgr_state(void)
+{
+	static int high_buffer_size = (1024 * 1024);
+	/* Each state file as last written, protected by the file lock */
+	static state_file_sig_t last_tres_sig, assoc_mgr_state_sig;
+	static state_file_sig_t assoc_usage_sig, qos_usage_sig;
+	int error_code = 0, rc;
+	uint32_t hdr_offset;
+	char *tmp_char = NULL;
+	dbd_list_msg_t msg;
+	buf_t *buffer = NULL;
+	assoc_mgr_lock_t locks = { .assoc = READ_LOCK, .file = WRITE_LOCK,
+				   .qos = READ_LOCK, .res = READ_LOCK,
+				   .tres = READ_LOCK, .user = READ_LOCK,
+				   .wckey = READ_LOCK};
+	DEF_TIMERS;
+
+	xassert(init_setup.state_save_location &&
+		*init_setup.state_save_location);
+
+	START_TIMER;
+
+	/* now make a file for last_tres */
+	buffer = init_buf(high_buffer_size);
+
+	/* write header: version, time */
+	pack16(SLURM_PROTOCOL_VERSION, buffer);
+	pack_time(time(NULL), buffer);
+	hdr_offset = get_buf_offset(buffer);
+
+	assoc_mgr_lock(&locks);
+	if (assoc_mgr_tres_list) {
+		memset(&msg, 0, sizeof(dbd_list_msg_t));
+		msg.my_list = assoc_mgr_tres_list;
+		slurmdbd_pack_list_msg(&msg, SLURM_PROTOCOL_VERSION,
+				       DBD_ADD_TRES, buffer);
+	}
+
+	if ((rc = _write_state_file(buffer, hdr_offset, "last_tres",
+				    &last_tres_sig)))
+		error_code = rc;
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
 	free_buf(buffer);
 
 	/* Now write the rest of the lists */
@@ -5378,7 +5491,7 @@ extern int dump_assoc_mgr_state(void)
 	/* write header: version, time */
 	pack16(SLURM_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
-
+	hdr_offset = get_buf_offset(buffer);
 	if (assoc_mgr_user_list) {
 		memset(&msg, 0, sizeof(dbd_list_msg_t));
 		msg.my_list = assoc_mgr_user_list;
@@ -5425,51 +5538,14 @@ extern int dump_assoc_mgr_state(void)
 				       DBD_ADD_ASSOCS, buffer);
 	}
 
-	/* write the buffer to file */
-	reg_file = xstrdup_printf("%s/assoc_mgr_state",
-				  *init_setup.state_save_location);
-	old_file = xstrdup_printf("%s.old", reg_file);
-	new_file = xstrdup_printf("%s.new", reg_file);
-
-	log_fd = creat(new_file, 0600);
-	if (log_fd < 0) {
-		error("Can't save state, create file %s error %m",
-		      new_file);
-		error_code = errno;
-	} else {
-		int pos = 0, nwrite = get_buf_offset(buffer), amount;
-		char *data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
-		fsync(log_fd);
-		close(log_fd);
-	}
-	if (error_code)
-		(void) unlink(new_file);
-	else {			/* file shuffle */
-		(void) unlink(old_file);
-		if (link(reg_file, old_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       reg_file, old_file);
-		(void) unlink(reg_file);
-		if (link(new_file, reg_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       new_file, reg_file);
-		(void) unlink(new_file);
-	}
-	xfree(old_file);
-	xfree(reg_file);
-	xfree(new_file);
-
+	/*
+	 * Association records are only changed by updates from the database,
+	 * so most of the time this large file does not need to be rewritten.
+	 */
+	if ((rc = _write_state_file(buffer, hdr_offset, "assoc_mgr_state",
+				    &assoc_mgr_state_sig)))
+		error_code = rc;
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
 	free_buf(buffer);
 	/* now make a file for assoc_usage */
 
@@ -5477,6 +5553,7 @@ extern int dump_assoc_mgr_state(void)
 	/* write header: version, time */
 	pack16(SLURM_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
+	hdr_offset = get_buf_offset(buffer);
 
 	if (assoc_mgr_assoc_list) {
 		ListIterator itr = NULL;
@@ -5497,50 +5574,10 @@ extern int dump_assoc_mgr_state(void)
 		list_iterator_destroy(itr);
 	}
 
-	reg_file = xstrdup_printf("%s/assoc_usage",
-				  *init_setup.state_save_location);
-	old_file = xstrdup_printf("%s.old", reg_file);
-	new_file = xstrdup_printf("%s.new", reg_file);
-
-	log_fd = creat(new_file, 0600);
-	if (log_fd < 0) {
-		error("Can't save state, create file %s error %m",
-		      new_file);
-		error_code = errno;
-	} else {
-		int pos = 0, nwrite = get_buf_offset(buffer), amount;
-		char *data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
-		fsync(log_fd);
-		close(log_fd);
-	}
-	if (error_code)
-		(void) unlink(new_file);
-	else {			/* file shuffle */
-		(void) unlink(old_file);
-		if (link(reg_file, old_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       reg_file, old_file);
-		(void) unlink(reg_file);
-		if (link(new_file, reg_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       new_file, reg_file);
-		(void) unlink(new_file);
-	}
-	xfree(old_file);
-	xfree(reg_file);
-	xfree(new_file);
-
+	if ((rc = _write_state_file(buffer, hdr_offset, "assoc_usage",
+				    &assoc_usage_sig)))
+		error_code = rc;
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
 	free_buf(buffer);
 	/* now make a file for qos_usage */
 
@@ -5548,6 +5585,7 @@ extern int dump_assoc_mgr_state(void)
 	/* write header: version, time */
 	pack16(SLURM_PROTOCOL_VERSION, buffer);
 	pack_time(time(NULL), buffer);
+	hdr_offset = get_buf_offset(buffer);
 
 	if (assoc_mgr_qos_list) {
 		ListIterator itr = NULL;
@@ -5565,51 +5603,12 @@ extern int dump_assoc_mgr_state(void)
 		list_iterator_destroy(itr);
 	}
 
-	reg_file = xstrdup_printf("%s/qos_usage",
-				  *init_setup.state_save_location);
-	old_file = xstrdup_printf("%s.old", reg_file);
-	new_file = xstrdup_printf("%s.new", reg_file);
-
-	log_fd = creat(new_file, 0600);
-	if (log_fd < 0) {
-		error("Can't save state, create file %s error %m",
-		      new_file);
-		error_code = errno;
-	} else {
-		int pos = 0, nwrite = get_buf_offset(buffer), amount;
-		char *data = (char *)get_buf_data(buffer);
-		high_buffer_size = MAX(nwrite, high_buffer_size);
-		while (nwrite > 0) {
-			amount = write(log_fd, &data[pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m", new_file);
-				error_code = errno;
-				break;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
-		fsync(log_fd);
-		close(log_fd);
-	}
-	if (error_code)
-		(void) unlink(new_file);
-	else {			/* file shuffle */
-		(void) unlink(old_file);
-		if (link(reg_file, old_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       reg_file, old_file);
-		(void) unlink(reg_file);
-		if (link(new_file, reg_file))
-			debug4("unable to create link for %s -> %s: %m",
-			       new_file, reg_file);
-		(void) unlink(new_file);
-	}
-	xfree(old_file);
-	xfree(reg_file);
-	xfree(new_file);
+	if ((rc = _write_state_file(buffer, hdr_offset, "qos_usage",
+				    &qos_usage_sig)))
+		error_code = rc;
 	assoc_mgr_unlock(&locks);
 
+	high_buffer_size = MAX(get_buf_offset(buffer), high_buffer_size);
 	free_buf(buffer);
 	END_TIMER2("dump_assoc_mgr_state");
 	return error_code;
@@ -6296,7 +6295,12 @@ extern slurmdb_tres_rec_t *assoc_mgr_find_tres_rec(slurmdb_tres_rec_t *tres_rec)
 extern int assoc_mgr_set_tres_cnt_array(uint64_t **tres_cnt, char *tres_str,
 					uint64_t init_val, bool locked)
 {
-	int diff_cnt = 0, i;
+	assoc_mgr_lock_t locks = { .tres = READ_LOCK };
+	const char *tmp_str = tres_str;
+	bitstr_t *found_pos = NULL;
+	int *unknown_ids = NULL;
+	int diff_cnt = 0, i, id, pos, found_cnt = 0, unknown_cnt = 0;
+	uint64_t count;
 
 	xassert(tres_cnt);
 
@@ -6313,36 +6317,78 @@ extern int assoc_mgr_set_tres_cnt_array(uint64_t **tres_cnt, char *tres_str,
 			(*tres_cnt)[i] = init_val;
 	}
 
-	if (tres_str) {
-		List tmp_list = NULL;
-		/* info("got %s", tres_str); */
-		slurmdb_tres_list_from_string(
-			&tmp_list, tres_str, TRES_STR_FLAG_NONE);
-		if (tmp_list) {
-			slurmdb_tres_rec_t *tres_rec;
-			ListIterator itr = list_iterator_create(tmp_list);
-			while ((tres_rec = list_next(itr))) {
-				int pos = assoc_mgr_find_tres_pos(
-					tres_rec, locked);
-				if (pos == -1) {
-					debug2("assoc_mgr_set_tres_cnt_array: "
-					       "no tres "
-					       "of id %u found in the array",
-					       tres_rec->id);
-					continue;
-				}
-				/* set the index to the count */
-				(*tres_cnt)[pos] = tres_rec->count;
-				/* info("%d pos %d has count of %"PRIu64, */
-				/*      tres_rec->id, */
-				/*      pos, tres_rec->count); */
-			}
-			list_iterator_destroy(itr);
-			if (g_tres_count != list_count(tmp_list))
-				diff_cnt = 1;
-			FREE_NULL_LIST(tmp_list);
+	if (!tres_str || !tres_str[0])
+		return diff_cnt;
+
+	/*
+	 * Parse the simple "id=count,..." string straight into the array.
+	 * This is what slurmdb_tres_list_from_string() with
+	 * TRES_STR_FLAG_NONE followed by assoc_mgr_find_tres_pos() on every
+	 * record would do (the first count given for an id wins), without
+	 * building the intermediate list.
+	 */
+	if (!locked)
+		assoc_mgr_lock(&locks);
+
+	xassert(assoc_mgr_tres_array);
+	found_pos = bit_alloc(g_tres_count);
+
+	if (tmp_str[0] == ',')
+		tmp_str++;
+
+	while (tmp_str) {
+		id = atoi(tmp_str);
+		/* 0 isn't a valid tres id */
+		if (id <= 0) {
+			error("%s: no id found at %s instead",
+			      __func__, tmp_str);
+			break;
+		}
+		if (!(tmp_str = strchr(tmp_str, '='))) {
+			error("%s: no value found %s", __func__, tres_str);
+			break;
+		}
+		count = slurm_atoull(++tmp_str);
+
+		for (pos = 0; pos < g_tres_count; pos++) {
+			if (assoc_mgr_tres_array[pos]->id == id)
+				break;
 		}
+		if (pos < g_tres_count) {
+			if (!bit_test(found_pos, pos)) {
+				bit_set(found_pos, pos);
+				(*tres_cnt)[pos] = count;
+				found_cnt++;
+			}
+		} else {
+			for (i = 0; i < unknown_cnt; i++) {
+				if (unknown_ids[i] == id)
+					break;
+			}
+			if (i == unknown_cnt) {
+				debug2("%s: no tres of id %u found in the array",
+				       __func__, id);
+				xrecalloc(unknown_ids, unknown_cnt + 1,
+					  sizeof(int));
+				unknown_ids[unknown_cnt++] = id;
+			}
+		}
+
+		if (!(tmp_str = strchr(tmp_str, ',')))
+			break;
+		tmp_str++;
 	}
+
+	if (!locked)
+		assoc_mgr_unlock(&locks);
+
+	if ((found_cnt || unknown_cnt) &&
+	    (g_tres_count != (found_cnt + unknown_cnt)))
+		diff_cnt = 1;
+
+	FREE_NULL_BITMAP(found_pos);
+	xfree(unknown_ids);
+
 	return diff_cnt;
 }
 
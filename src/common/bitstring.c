@@ -97,6 +97,24 @@
 	xassert((bit) <= 0x40000000); 	\
 } while (0)
 
+/*
+ * Words of data (including any partial last word) in a bitstring. Whole
+ * bitmap operations loop over a local copy of this rather than testing
+ * _bitstr_bits() each iteration, which the compiler must reload after every
+ * store into the bitmap, so that the loops can be unrolled and vectorized.
+ */
+#define _bitstr_data_words(name) \
+	(_bitstr_words(_bitstr_bits(name)) - BITSTR_OVERHEAD)
+
+/*
+ * Use the POPCNT instruction when the CPU has it. Generic x86 builds
+ * otherwise count bits with a libgcc table lookup.
+ */
+#if defined(HAVE___BUILTIN_POPCOUNTLL) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define BITSTR_POPCNT_DISPATCH 1
+#endif
+
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
  * for details.
@@ -111,6 +129,7 @@ strong_alias(bit_set_all,	slurm_bit_set_all);
 strong_alias(bit_clear_all,	slurm_bit_clear_all);
 strong_alias(bit_ffc,		slurm_bit_ffc);
 strong_alias(bit_ffs,		slurm_bit_ffs);
+strong_alias(bit_ffs_from_bit,	slurm_bit_ffs_from_bit);
 strong_alias(bit_free,		slurm_bit_free);
 strong_alias(bit_realloc,	slurm_bit_realloc);
 strong_alias(bit_size,		slurm_bit_size);
@@ -495,6 +514,61 @@ bit_ffs(bitstr_t *b)
 		return -1;
 }
 
+/*
+ * Find first bit set in b at or after bit start, skipping clear words
+ * rather than testing every bit. Iterate over the set bits of b with:
+ *	for (i = 0; (i = bit_ffs_from_bit(b, i)) >= 0; i++)
+ *   b (IN)		bitstring to search
+ *   start (IN)		first bit to consider, negative values start at 0
+ *   RETURN 		resulting bit position (-1 if none found)
+ */
+bitoff_t
+bit_ffs_from_bit(bitstr_t *b, bitoff_t start)
+{
+	bitoff_t bit = MAX(start, 0), bit_cnt;
+	int32_t word_size = sizeof(bitstr_t) * 8;
+
+	_assert_bitstr_valid(b);
+
+	bit_cnt = _bitstr_bits(b);
+	while (bit < bit_cnt) {
+		int32_t word = _bit_word(bit);
+		bitstr_t value = b[word];
+
+		if (value == 0) {
+			bit = (bit + word_size) & ~((bitoff_t) BITSTR_MAXPOS);
+			continue;
+		}
+#if HAVE___BUILTIN_CLZLL && (defined SLURM_BIGENDIAN)
+		value &= ~((bitstr_t) 0) >> (bit & BITSTR_MAXPOS);
+		if (value) {
+			bit = (bit & ~((bitoff_t) BITSTR_MAXPOS)) +
+			      __builtin_clzll(value);
+			break;
+		}
+		bit = (bit + word_size) & ~((bitoff_t) BITSTR_MAXPOS);
+#elif HAVE___BUILTIN_CTZLL && (!defined SLURM_BIGENDIAN)
+		value &= ~((bitstr_t) 0) << (bit & BITSTR_MAXPOS);
+		if (value) {
+			bit = (bit & ~((bitoff_t) BITSTR_MAXPOS)) +
+			      __builtin_ctzll(value);
+			break;
+		}
+		bit = (bit + word_size) & ~((bitoff_t) BITSTR_MAXPOS);
+#else
+		while ((bit < bit_cnt) && (_bit_word(bit) == word)) {
+			if (value & _bit_mask(bit))
+				return bit;
+			bit++;
+		}
+#endif
+	}
+	if (bit < bit_cnt)
+		return bit;
+	else
+		return -1;
+}
+
 /*
  * Find last bit set in b.
  *   b (IN)		bitstring to search
@@ -571,15 +645,16 @@ bit_fill_gaps(bitstr_t *b)
 int
 bit_super_set(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = &b1[BITSTR_OVERHEAD], *w2 = &b2[BITSTR_OVERHEAD];
+	int64_t i, cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != (b1[_bit_word(bit)] &
-		                           b2[_bit_word(bit)]))
+	cnt = _bitstr_data_words(b1);
+	for (i = 0; i < cnt; i++) {
+		if (w1[i] & ~w2[i])
 			return 0;
 	}
 
@@ -592,18 +667,15 @@ bit_super_set(bitstr_t *b1, bitstr_t *b2)
 extern int
 bit_equal(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
-
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 
 	if (_bitstr_bits(b1) != _bitstr_bits(b2))
 		return 0;
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8) {
-		if (b1[_bit_word(bit)] != b2[_bit_word(bit)])
-			return 0;
-	}
+	if (memcmp(&b1[BITSTR_OVERHEAD], &b2[BITSTR_OVERHEAD],
+		   _bitstr_data_words(b1) * sizeof(bitstr_t)))
+		return 0;
 
 	return 1;
 }
@@ -618,14 +690,16 @@ bit_equal(bitstr_t *b1, bitstr_t *b2)
 void
 bit_and(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = &b1[BITSTR_OVERHEAD], *w2 = &b2[BITSTR_OVERHEAD];
+	int64_t i, cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= b2[_bit_word(bit)];
+	cnt = _bitstr_data_words(b1);
+	for (i = 0; i < cnt; i++)
+		w1[i] &= w2[i];
 }
 
 /*
@@ -635,14 +709,16 @@ bit_and(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = &b1[BITSTR_OVERHEAD], *w2 = &b2[BITSTR_OVERHEAD];
+	int64_t i, cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] &= ~b2[_bit_word(bit)];
+	cnt = _bitstr_data_words(b1);
+	for (i = 0; i < cnt; i++)
+		w1[i] &= ~w2[i];
 }
 
 /*
@@ -652,12 +728,14 @@ void bit_and_not(bitstr_t *b1, bitstr_t *b2)
 void
 bit_not(bitstr_t *b)
 {
-	bitoff_t bit;
+	bitstr_t *w = &b[BITSTR_OVERHEAD];
+	int64_t i, cnt;
 
 	_assert_bitstr_valid(b);
 
-	for (bit = 0; bit < _bitstr_bits(b); bit += sizeof(bitstr_t)*8)
-		b[_bit_word(bit)] = ~b[_bit_word(bit)];
+	cnt = _bitstr_data_words(b);
+	for (i = 0; i < cnt; i++)
+		w[i] = ~w[i];
 }
 
 /*
@@ -668,14 +746,16 @@ bit_not(bitstr_t *b)
 void
 bit_or(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = &b1[BITSTR_OVERHEAD], *w2 = &b2[BITSTR_OVERHEAD];
+	int64_t i, cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= b2[_bit_word(bit)];
+	cnt = _bitstr_data_words(b1);
+	for (i = 0; i < cnt; i++)
+		w1[i] |= w2[i];
 }
 
 /*
@@ -685,14 +765,16 @@ bit_or(bitstr_t *b1, bitstr_t *b2)
  */
 void bit_or_not(bitstr_t *b1, bitstr_t *b2)
 {
-	bitoff_t bit;
+	bitstr_t *w1 = &b1[BITSTR_OVERHEAD], *w2 = &b2[BITSTR_OVERHEAD];
+	int64_t i, cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
-	for (bit = 0; bit < _bitstr_bits(b1); bit += sizeof(bitstr_t)*8)
-		b1[_bit_word(bit)] |= ~b2[_bit_word(bit)];
+	cnt = _bitstr_data_words(b1);
+	for (i = 0; i < cnt; i++)
+		w1[i] |= ~w2[i];
 }
 
 /*
@@ -746,6 +828,72 @@ hweight(uint64_t w)
 }
 #endif
 
+/* Count bits set in cnt words */
+static int32_t _count_words(const bitstr_t *w, int64_t cnt)
+{
+	int32_t count = 0;
+	int64_t i;
+
+	for (i = 0; i < cnt; i++)
+		count += hweight(w[i]);
+	return count;
+}
+
+/* Count bits set in both of cnt word pairs */
+static int32_t _count_and_words(const bitstr_t *w1, const bitstr_t *w2,
+				int64_t cnt)
+{
+	int32_t count = 0;
+	int64_t i;
+
+	for (i = 0; i < cnt; i++)
+		count += hweight(w1[i] & w2[i]);
+	return count;
+}
+
+#ifdef BITSTR_POPCNT_DISPATCH
+__attribute__((target("popcnt")))
+static int32_t _count_words_popcnt(const bitstr_t *w, int64_t cnt)
+{
+	int32_t count = 0;
+	int64_t i;
+
+	for (i = 0; i < cnt; i++)
+		count += __builtin_popcountll(w[i]);
+	return count;
+}
+
+__attribute__((target("popcnt")))
+static int32_t _count_and_words_popcnt(const bitstr_t *w1, const bitstr_t *w2,
+				       int64_t cnt)
+{
+	int32_t count = 0;
+	int64_t i;
+
+	for (i = 0; i < cnt; i++)
+		count += __builtin_popcountll(w1[i] & w2[i]);
+	return count;
+}
+
+static bool _have_popcnt(void)
+{
+	static int have_popcnt = -1;
+
+	if (have_popcnt == -1)
+		have_popcnt = __builtin_cpu_supports("popcnt") ? 1 : 0;
+	return have_popcnt;
+}
+
+#define _popcnt_words(w, cnt) \
+	(_have_popcnt() ? _count_words_popcnt(w, cnt) : _count_words(w, cnt))
+#define _popcnt_and_words(w1, w2, cnt) \
+	(_have_popcnt() ? _count_and_words_popcnt(w1, w2, cnt) : \
+	 _count_and_words(w1, w2, cnt))
+#else
+#define _popcnt_words(w, cnt)		_count_words(w, cnt)
+#define _popcnt_and_words(w1, w2, cnt)	_count_and_words(w1, w2, cnt)
+#endif
+
 /*
  * Count the number of bits set in bitstring.
  *   b (IN)		bitstring to check
@@ -754,17 +902,16 @@ hweight(uint64_t w)
 int32_t
 bit_set_count(bitstr_t *b)
 {
-	int32_t count = 0;
+	int32_t count;
 	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	int64_t word_cnt;
 
 	_assert_bitstr_valid(b);
 
 	bit_cnt = _bitstr_bits(b);
-	for (bit = 0; (bit + word_size) <= bit_cnt; bit += word_size) {
-		count += hweight(b[_bit_word(bit)]);
-	}
-	for ( ; bit < bit_cnt; bit++) {
+	word_cnt = bit_cnt >> BITSTR_SHIFT;
+	count = _popcnt_words(&b[BITSTR_OVERHEAD], word_cnt);
+	for (bit = word_cnt << BITSTR_SHIFT; bit < bit_cnt; bit++) {
 		if (bit_test(b, bit))
 			count++;
 	}
@@ -807,26 +954,26 @@ bit_set_count_range(bitstr_t *b, int32_t start, int32_t end)
 
 static int32_t _bit_overlap_internal(bitstr_t *b1, bitstr_t *b2, bool count_it)
 {
+	bitstr_t *w1 = &b1[BITSTR_OVERHEAD], *w2 = &b2[BITSTR_OVERHEAD];
 	int32_t count = 0;
-	int64_t anded;
 	bitoff_t bit, bit_cnt;
-	int32_t word_size = sizeof(bitstr_t) * 8;
+	int64_t i, word_cnt;
 
 	_assert_bitstr_valid(b1);
 	_assert_bitstr_valid(b2);
 	xassert(_bitstr_bits(b1) == _bitstr_bits(b2));
 
 	bit_cnt = _bitstr_bits(b1);
-	for (bit = 0; bit < bit_cnt; bit += word_size) {
-		if ((bit + word_size - 1) >= bit_cnt)
-			break;
-		anded = b1[_bit_word(bit)] & b2[_bit_word(bit)];
-		if (count_it)
-			count += hweight(anded);
-		else if (anded)
-			return 1;
+	word_cnt = bit_cnt >> BITSTR_SHIFT;
+	if (count_it) {
+		count = _popcnt_and_words(w1, w2, word_cnt);
+	} else {
+		for (i = 0; i < word_cnt; i++) {
+			if (w1[i] & w2[i])
+				return 1;
+		}
 	}
-	for ( ; bit < bit_cnt; bit++) {
+	for (bit = word_cnt << BITSTR_SHIFT; bit < bit_cnt; bit++) {
 		if (bit_test(b1, bit) && bit_test(b2, bit)) {
 			if (count_it)
 				count++;
@@ -104,6 +104,7 @@ void bit_clear_all(bitstr_t *b);
 /* changed interface from Vixie macros */
 bitoff_t bit_ffc(bitstr_t *b);
 bitoff_t bit_ffs(bitstr_t *b);
+bitoff_t bit_ffs_from_bit(bitstr_t *b, bitoff_t bit);
 
 /* new */
 bitoff_t bit_nffs(bitstr_t *b, int32_t n);
@@ -111,9 +111,17 @@ static List mime_types_list = NULL;
 #define DATA_LIST_MAGIC 0x1992F89F
 #define DATA_LIST_NODE_MAGIC 0x1921F89F
 
+/* dictionaries with at least this many entries get a hash index */
+#define DATA_DICT_INDEX_MIN 16
+
+/*
+ * Node, its data and its key are a single allocation. Data owned by a node
+ * must only be released by releasing the node.
+ */
 typedef struct data_list_node_s data_list_node_t;
 struct data_list_node_s {
 	int magic;
+	uint32_t hash; /* hash of key (dictionary only) */
 	data_list_node_t *next;
 
 	data_t *data;
@@ -127,6 +135,10 @@ struct data_list_s {
 
 	data_list_node_t *begin;
 	data_list_node_t *end;
+
+	/* open addressing hash index of dictionary nodes or NULL */
+	data_list_node_t **index;
+	size_t index_size; /* power of 2, at least twice count */
 };
 
 static void _check_magic(const data_t *data);
@@ -484,6 +496,80 @@ static void _check_data_list_magic(const data_list_t *dl)
 #endif /* !NDEBUG */
 }
 
+/* FNV-1a */
+static uint32_t _hash_key(const char *key)
+{
+	uint32_t hash = 2166136261U;
+
+	for (; *key; key++) {
+		hash ^= (unsigned char) *key;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static void _index_insert(data_list_t *dl, data_list_node_t *dn)
+{
+	const size_t mask = dl->index_size - 1;
+
+	for (size_t i = (dn->hash & mask);; i = ((i + 1) & mask)) {
+		if (!dl->index[i]) {
+			dl->index[i] = dn;
+			return;
+		}
+	}
+}
+
+/* (Re)create hash index of dictionary if large enough to need one */
+static void _index_rebuild(data_list_t *dl)
+{
+	xfree(dl->index);
+	dl->index_size = 0;
+
+	if (dl->count < DATA_DICT_INDEX_MIN)
+		return;
+
+	dl->index_size = DATA_DICT_INDEX_MIN * 2;
+	while (dl->index_size < (dl->count * 2))
+		dl->index_size *= 2;
+	dl->index = xcalloc(dl->index_size, sizeof(*dl->index));
+
+	for (data_list_node_t *i = dl->begin; i; i = i->next)
+		_index_insert(dl, i);
+}
+
+/* Find dictionary node by key. RET node or NULL if not found */
+static data_list_node_t *_dict_find(const data_list_t *dl, const char *key)
+{
+	const uint32_t hash = _hash_key(key);
+
+	_check_data_list_magic(dl);
+
+	if (dl->index) {
+		const size_t mask = dl->index_size - 1;
+
+		for (size_t i = (hash & mask); dl->index[i];
+		     i = ((i + 1) & mask)) {
+			data_list_node_t *dn = dl->index[i];
+
+			if ((dn->hash == hash) && !xstrcmp(key, dn->key))
+				return dn;
+		}
+
+		return NULL;
+	}
+
+	for (data_list_node_t *i = dl->begin; i; i = i->next) {
+		_check_data_list_node_magic(i);
+
+		if ((i->hash == hash) && !xstrcmp(key, i->key))
+			return i;
+	}
+
+	return NULL;
+}
+
 /* verify node is in parent list */
 static void _check_data_list_node_parent(const data_list_t *dl,
 					 const data_list_node_t *dn)
@@ -542,8 +628,12 @@ static void _release_data_list_node(data_list_t *dl, data_list_node_t *dn)
 	}
 
 	dl->count--;
-	FREE_NULL_DATA(dn->data);
-	xfree(dn->key);
+	if (dl->index)
+		_index_rebuild(dl);
+
+	xassert(dn->data == (data_t *) (dn + 1));
+	_release(dn->data);
+	dn->data->magic = ~DATA_MAGIC;
 
 	dn->magic = ~DATA_LIST_NODE_MAGIC;
 	xfree(dn);
@@ -559,6 +649,10 @@ static void _release_data_list(data_list_t *dl)
 
 	_check_data_list_magic(dl);
 
+	/* no point maintaining index while releasing everything */
+	xfree(dl->index);
+	dl->index_size = 0;
+
 	if (!n) {
 		xassert(!dl->count);
 		xassert(!dl->end);
@@ -587,19 +681,27 @@ finish:
 }
 
 /*
- * Create new data list node entry
- * IN d - data type to take ownership of
- * IN key - dictionary key to dup or NULL
+ * Create new data list node entry with a new null data
+ * IN key - dictionary key to copy or NULL
  */
-static data_list_node_t *_new_data_list_node(data_t *d, const char *key)
+static data_list_node_t *_new_data_list_node(const char *key)
 {
-	data_list_node_t *dn = xmalloc(sizeof(*dn));
+	size_t key_len = (key ? (strlen(key) + 1) : 0);
+	data_list_node_t *dn;
+
+	/* single allocation for node, data and key */
+	dn = xmalloc(sizeof(*dn) + sizeof(data_t) + key_len);
 	dn->magic = DATA_LIST_NODE_MAGIC;
-	_check_magic(d);
 
-	dn->data = d;
-	if (key)
-		dn->key = xstrdup(key);
+	dn->data = (data_t *) (dn + 1);
+	dn->data->magic = DATA_MAGIC;
+	dn->data->type = DATA_TYPE_NULL;
+
+	if (key) {
+		dn->key = (char *) (dn->data + 1);
+		memcpy(dn->key, key, key_len);
+		dn->hash = _hash_key(key);
+	}
 
 	log_flag(DATA, "%s: new data list node (0x%"PRIXPTR")",
 		 __func__, (uintptr_t) dn);
@@ -607,11 +709,22 @@ static data_list_node_t *_new_data_list_node(data_t *d, const char *key)
 	return dn;
 }
 
-static void _data_list_append(data_list_t *dl, data_t *d, const char *key)
+/* Add dictionary node to hash index after count was incremented */
+static void _index_add(data_list_t *dl, data_list_node_t *dn)
+{
+	if (!dn->key)
+		return;
+
+	if (dl->index && ((dl->count * 2) <= dl->index_size))
+		_index_insert(dl, dn);
+	else if (dl->count >= DATA_DICT_INDEX_MIN)
+		_index_rebuild(dl);
+}
+
+static data_t *_data_list_append(data_list_t *dl, const char *key)
 {
-	data_list_node_t *n = _new_data_list_node(d, key);
+	data_list_node_t *n = _new_data_list_node(key);
 	_check_data_list_magic(dl);
-	_check_magic(d);
 
 	if (dl->end) {
 		xassert(!dl->end->next);
@@ -627,13 +740,15 @@ static void _data_list_append(data_list_t *dl, data_t *d, const char *key)
 	}
 
 	dl->count++;
+	_index_add(dl, n);
+
+	return n->data;
 }
 
-static void _data_list_prepend(data_list_t *dl, data_t *d, const char *key)
+static data_t *_data_list_prepend(data_list_t *dl, const char *key)
 {
-	data_list_node_t *n = _new_data_list_node(d, key);
+	data_list_node_t *n = _new_data_list_node(key);
 	_check_data_list_magic(dl);
-	_check_magic(d);
 
 	if (dl->begin) {
 		_check_data_list_node_magic(dl->begin);
@@ -646,6 +761,9 @@ static void _data_list_prepend(data_list_t *dl, data_t *d, const char *key)
 	}
 
 	dl->count++;
+	_index_add(dl, n);
+
+	return n->data;
 }
 
 data_t *data_new(void)
@@ -732,6 +850,7 @@ extern data_t *data_set_float(data_t *data, double value)
 	_check_magic(data);
 	if (!data)
 		return NULL;
+	_release(data);
 
 	log_flag(DATA, "%s: set data (0x%"PRIXPTR") to float: %lf",
 	       __func__, (uintptr_t) data, value);
@@ -813,6 +932,7 @@ extern data_t *data_set_string_own(data_t *data, char *value)
 
 	if (!data || !value)
 		return NULL;
+	_release(data);
 
 	log_flag(DATA, "%s: set data (0x%"PRIXPTR") to string: %s",
 		 __func__, (uintptr_t) data, value);
@@ -866,8 +986,7 @@ extern data_t *data_list_append(data_t *data)
 	if (!data || data->type != DATA_TYPE_LIST)
 		return NULL;
 
-	ndata = data_new();
-	_data_list_append(data->data.list_u, ndata, NULL);
+	ndata = _data_list_append(data->data.list_u, NULL);
 
 	log_flag(DATA, "%s: list append data (0x%"PRIXPTR") to (0x%"PRIXPTR")",
 		 __func__, (uintptr_t) ndata, (uintptr_t) data);
@@ -883,8 +1002,7 @@ extern data_t *data_list_prepend(data_t *data)
 	if (!data || data->type != DATA_TYPE_LIST)
 		return NULL;
 
-	ndata = data_new();
-	_data_list_prepend(data->data.list_u, ndata, NULL);
+	ndata = _data_list_prepend(data->data.list_u, NULL);
 
 	log_flag(DATA, "%s: list prepend data (0x%"PRIXPTR") to (0x%"PRIXPTR")",
 		 __func__, (uintptr_t) ndata, (uintptr_t) data);
@@ -938,16 +1056,7 @@ const data_t *data_key_get_const(const data_t *data, const char *key)
 	if (!data->data.dict_u->count)
 		return NULL;
 
-	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
-
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
+	i = _dict_find(data->data.dict_u, key);
 
 	if (i)
 		return i->data;
@@ -971,16 +1080,7 @@ data_t *data_key_get(data_t *data, const char *key)
 	if (!data->data.dict_u->count)
 		return NULL;
 
-	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
-
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
+	i = _dict_find(data->data.dict_u, key);
 
 	if (i)
 		return i->data;
@@ -1008,8 +1108,7 @@ data_t *data_key_set(data_t *data, const char *key)
 		return d;
 	}
 
-	d = data_new();
-	_data_list_append(data->data.dict_u, d, key);
+	d = _data_list_append(data->data.dict_u, key);
 
 	log_flag(DATA, "%s: set new key in data (0x%"PRIXPTR") key: %s data (0x%"PRIXPTR")",
 		 __func__, (uintptr_t) data, key, (uintptr_t) d);
@@ -1039,16 +1138,7 @@ bool data_key_unset(data_t *data, const char *key)
 	if (!key || data->type != DATA_TYPE_DICT)
 		return NULL;
 
-	_check_data_list_magic(data->data.dict_u);
-	i = data->data.dict_u->begin;
-	while (i) {
-		_check_data_list_node_magic(i);
-
-		if (!xstrcmp(key, i->key))
-			break;
-
-		i = i->next;
-	}
+	i = _dict_find(data->data.dict_u, key);
 
 	if (!i) {
 		log_flag(DATA, "%s: remove non-existent key in data (0x%"PRIXPTR") key: %s",
@@ -2201,3 +2291,242 @@ extern const char *data_resolve_mime_type(const char *mime_type)
 
 	return pmt->mime_type;
 }
+
+#define DATA_STREAM_MAGIC 0x1daa5e0f
+
+typedef struct {
+	bool is_dict;
+	size_t count;		/* values written into container */
+	data_t *tree;		/* container when collecting a tree */
+} data_stream_level_t;
+
+struct data_stream_s {
+	int magic;
+	const char *mime_type;
+	data_serializer_flags_t flags;
+	bool json;		/* write JSON directly instead of a tree */
+	serializer_funcs_t *ops;	/* serializer plugin of mime_type */
+	int rc;			/* first error serializing a value */
+	char *out;		/* JSON written so far */
+	size_t out_len;
+	size_t out_size;
+	data_stream_level_t *levels;
+	int depth;		/* current nesting depth */
+	int levels_size;
+	char *key;		/* dictionary key of next value */
+	data_t *root;		/* collected tree */
+};
+
+static void _stream_write(data_stream_t *s, const char *str, size_t len)
+{
+	if ((s->out_len + len + 1) > s->out_size) {
+		s->out_size = MAX((s->out_size * 2), (s->out_len + len + 1));
+		xrealloc_nz(s->out, s->out_size);
+	}
+
+	memcpy(s->out + s->out_len, str, len);
+	s->out_len += len;
+	s->out[s->out_len] = '\0';
+}
+
+static void _stream_puts(data_stream_t *s, const char *str)
+{
+	_stream_write(s, str, strlen(str));
+}
+
+/* Start new line indented for depth when pretty printing */
+static void _stream_newline(data_stream_t *s, int depth)
+{
+	if (!(s->flags & DATA_SER_FLAGS_PRETTY))
+		return;
+
+	_stream_write(s, "\n", 1);
+	for (int i = 0; i < depth; i++)
+		_stream_write(s, "  ", 2);
+}
+
+/*
+ * Append value as written by the JSON serializer plugin, so the stream and
+ * data_g_serialize() format values alike. The plugin indents from level 0,
+ * so each line is moved over to the current depth.
+ */
+static void _stream_json_value(data_stream_t *s, const data_t *d)
+{
+	char *str = NULL, *pos, *nl;
+	int rc;
+
+	if ((rc = (*(s->ops->serialize))(&str, d, s->flags))) {
+		if (!s->rc)
+			s->rc = rc;
+		xfree(str);
+		return;
+	}
+
+	for (pos = str; (nl = strchr(pos, '\n')); pos = (nl + 1)) {
+		_stream_write(s, pos, (nl - pos));
+		_stream_newline(s, s->depth);
+	}
+	_stream_puts(s, pos);
+	xfree(str);
+}
+
+/* Start next value in current container, RET tree node to set (tree mode) */
+static data_t *_stream_next(data_stream_t *s)
+{
+	data_stream_level_t *level;
+	data_t *d = NULL;
+
+	xassert(s->magic == DATA_STREAM_MAGIC);
+
+	if (!s->depth) {
+		xassert(!s->out_len && !s->root);
+		if (!s->json)
+			d = s->root = data_new();
+		return d;
+	}
+
+	level = &s->levels[s->depth - 1];
+	xassert(!level->is_dict || s->key);
+
+	if (s->json) {
+		if (level->count)
+			_stream_write(s, ",", 1);
+		_stream_newline(s, s->depth);
+		if (level->is_dict) {
+			data_t *key = data_set_string(data_new(), s->key);
+
+			_stream_json_value(s, key);
+			FREE_NULL_DATA(key);
+			_stream_puts(s, ((s->flags & DATA_SER_FLAGS_PRETTY) ?
+					 ": " : ":"));
+		}
+	} else if (level->is_dict) {
+		d = data_key_set(level->tree, s->key);
+	} else {
+		d = data_list_append(level->tree);
+	}
+
+	level->count++;
+	xfree(s->key);
+
+	return d;
+}
+
+static void _stream_begin(data_stream_t *s, bool is_dict)
+{
+	data_t *d = _stream_next(s);
+	data_stream_level_t *level;
+
+	if (s->depth >= s->levels_size) {
+		s->levels_size = MAX(8, (s->levels_size * 2));
+		xrecalloc(s->levels, s->levels_size, sizeof(*s->levels));
+	}
+
+	level = &s->levels[s->depth++];
+	level->is_dict = is_dict;
+	level->count = 0;
+
+	if (s->json)
+		_stream_write(s, (is_dict ? "{" : "["), 1);
+	else if (is_dict)
+		level->tree = data_set_dict(d);
+	else
+		level->tree = data_set_list(d);
+}
+
+extern data_stream_t *data_stream_new(const char *mime_type,
+				      data_serializer_flags_t flags)
+{
+	data_stream_t *s;
+	plugin_mime_type_t *pmt = _find_serializer(mime_type);
+	plugin_mime_type_t *json = _find_serializer(MIME_TYPE_JSON);
+
+	if (!pmt)
+		return NULL;
+
+	s = xmalloc(sizeof(*s));
+	s->magic = DATA_STREAM_MAGIC;
+	s->mime_type = pmt->mime_type;
+	s->flags = flags;
+	s->json = (json && (json->index == pmt->index));
+	s->ops = &plugins[pmt->index];
+
+	return s;
+}
+
+extern void data_stream_dict_begin(data_stream_t *stream)
+{
+	_stream_begin(stream, true);
+}
+
+extern void data_stream_list_begin(data_stream_t *stream)
+{
+	_stream_begin(stream, false);
+}
+
+extern void data_stream_end(data_stream_t *stream)
+{
+	data_stream_level_t *level;
+
+	xassert(stream->magic == DATA_STREAM_MAGIC);
+	xassert(stream->depth > 0);
+	xassert(!stream->key);
+
+	level = &stream->levels[--stream->depth];
+
+	if (stream->json) {
+		if (level->count)
+			_stream_newline(stream, stream->depth);
+		_stream_write(stream, (level->is_dict ? "}" : "]"), 1);
+	}
+}
+
+extern void data_stream_key(data_stream_t *stream, const char *key)
+{
+	xassert(stream->magic == DATA_STREAM_MAGIC);
+	xassert(stream->depth && stream->levels[stream->depth - 1].is_dict);
+
+	xfree(stream->key);
+	stream->key = xstrdup(key);
+}
+
+extern void data_stream_value(data_stream_t *stream, const data_t *value)
+{
+	data_t *d = _stream_next(stream);
+
+	if (stream->json)
+		_stream_json_value(stream, value);
+	else
+		data_copy(d, value);
+}
+
+extern int data_stream_finish(data_stream_t *stream, char **dest)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!stream)
+		return SLURM_SUCCESS;
+
+	xassert(stream->magic == DATA_STREAM_MAGIC);
+	xassert(!stream->depth);
+	xassert(dest && !*dest);
+
+	if (stream->json) {
+		if (!(rc = stream->rc)) {
+			*dest = stream->out;
+			stream->out = NULL;
+		}
+	} else if (stream->root) {
+		rc = data_g_serialize(dest, stream->root, stream->mime_type,
+				      stream->flags);
+	}
+
+	stream->magic = ~DATA_STREAM_MAGIC;
+	xfree(stream->out);
+	xfree(stream->levels);
+	xfree(stream->key);
+	FREE_NULL_DATA(stream->root);
+	xfree(stream);
+
+	return rc;
+}
@@ -593,4 +593,46 @@ extern int data_g_deserialize(data_t **dest, const char *src, size_t length,
  */
 extern const char *data_resolve_mime_type(const char *mime_type);
 
+/*
+ * Incremental serializer to avoid holding an entire data_t tree for large
+ * responses. Containers are opened and closed in order and values are added
+ * one at a time, each value being a (small) data_t tree.
+ *
+ * JSON is written out as values are added, each value formatted by the
+ * JSON serializer plugin. Other mime types are collected into a data_t tree
+ * and handed to their serializer plugin by data_stream_finish().
+ */
+typedef struct data_stream_s data_stream_t;
+
+/*
+ * Create new stream
+ * IN mime_type - serialize data into the given mime_type
+ * IN flags - presentation flags as data_g_serialize()
+ * RET stream or NULL if no plugin handles mime_type
+ */
+extern data_stream_t *data_stream_new(const char *mime_type,
+				      data_serializer_flags_t flags);
+
+/* Open dictionary or list as next value in stream */
+extern void data_stream_dict_begin(data_stream_t *stream);
+extern void data_stream_list_begin(data_stream_t *stream);
+
+/* Close most recently opened dictionary or list */
+extern void data_stream_end(data_stream_t *stream);
+
+/* Set key of next value, required before each value added to a dictionary */
+extern void data_stream_key(data_stream_t *stream, const char *key);
+
+/* Add copy of value as next value in stream */
+extern void data_stream_value(data_stream_t *stream, const data_t *value);
+
+/*
+ * Release stream and get serialized data
+ * IN stream - stream with all containers closed (will be free'd)
+ * IN/OUT dest - ptr to NULL string ptr to set with output data.
+ * 	caller must xfree(dest) if set.
+ * RET SLURM_SUCCESS or error
+ */
+extern int data_stream_finish(data_stream_t *stream, char **dest);
+
 #endif /* _DATA_H */
@@ -48,6 +48,10 @@
 #define POLLRDHUP POLLHUP
 #endif
 
+#if defined(__linux__)
+#include <sys/epoll.h>
+#endif
+
 #include "src/common/fd.h"
 #include "src/common/eio.h"
 #include "src/common/log.h"
@@ -80,6 +84,33 @@ strong_alias(eio_signal_wakeup,		slurm_eio_signal_wakeup);
  * it wakes up.
  */
 #define EIO_MAGIC 0xe1e10
+
+#if defined(__linux__)
+/*
+ * epoll interest set of a mainloop. It is kept from one pass to the next so
+ * only fds whose events changed since the last pass go to the kernel, rather
+ * than all of them on every poll(). On Linux the poll and epoll event bits
+ * have the same values.
+ */
+typedef struct {
+	int epfd;
+	int fd_cnt;		/* size of the fd indexed arrays below */
+	uint32_t *events;	/* events registered for each fd, 0 if none */
+	uint32_t *gen;		/* bumped on each EPOLL_CTL_ADD of the fd */
+	uint32_t *want;		/* events wanted for each fd in this pass */
+	uint32_t *pass;		/* last pass each fd was wanted in */
+	uint32_t *owner;	/* serial of the first object using each fd */
+	int *first;		/* first pollfd of each fd in this pass */
+	int *reg_fds;		/* fds with events registered */
+	int reg_cnt;
+	int *next;		/* next pollfd with the same fd */
+	struct epoll_event *ready;
+	int pfd_cnt;		/* size of next and ready */
+	uint32_t pass_cnt;
+	bool rebuild;		/* stale registration seen, start over */
+} eio_epoll_t;
+#endif
+
 struct eio_handle_components {
 	int  magic;
 	int  fds[2];
@@ -88,6 +119,9 @@ struct eio_handle_components {
 	uint16_t shutdown_wait;
 	List obj_list;
 	List new_objs;
+#if defined(__linux__)
+	eio_epoll_t *ep;	/* NULL to use poll() */
+#endif
 };
 
 /* Function prototypes */
@@ -99,6 +133,16 @@ static void         _poll_dispatch(struct pollfd *, unsigned int, eio_obj_t **,
 		                   List objList);
 static void         _poll_handle_event(short revents, eio_obj_t *obj,
 		                       List objList);
+#if defined(__linux__)
+static eio_epoll_t *_epoll_create(void);
+static void         _epoll_destroy(eio_epoll_t *ep);
+static int          _epoll_internal(eio_epoll_t *ep, struct pollfd *pfds,
+				    eio_obj_t **map, unsigned int nfds,
+				    time_t shutdown_time);
+#endif
+
+static pthread_mutex_t serial_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t obj_serial = 0;
 
 eio_handle_t *eio_handle_create(uint16_t shutdown_wait)
 {
@@ -124,6 +168,10 @@ eio_handle_t *eio_handle_create(uint16_t shutdown_wait)
 	if (shutdown_wait > 0)
 		eio->shutdown_wait = shutdown_wait;
 
+#if defined(__linux__)
+	eio->ep = _epoll_create();
+#endif
+
 	return eio;
 }
 
@@ -136,6 +184,9 @@ void eio_handle_destroy(eio_handle_t *eio)
 	FREE_NULL_LIST(eio->obj_list);
 	FREE_NULL_LIST(eio->new_objs);
 	slurm_mutex_destroy(&eio->shutdown_mutex);
+#if defined(__linux__)
+	_epoll_destroy(eio->ep);
+#endif
 
 	eio->magic = ~EIO_MAGIC;
 	xfree(eio);
@@ -312,6 +363,13 @@ int eio_handle_mainloop(eio_handle_t *eio)
 		slurm_mutex_lock(&eio->shutdown_mutex);
 		shutdown_time = eio->shutdown_time;
 		slurm_mutex_unlock(&eio->shutdown_mutex);
+#if defined(__linux__)
+		if (eio->ep) {
+			if (_epoll_internal(eio->ep, pollfds, map, nfds,
+					    shutdown_time) < 0)
+				goto error;
+		} else
+#endif
 		if (_poll_internal(pollfds, nfds, shutdown_time) < 0)
 			goto error;
 
@@ -364,6 +422,243 @@ static int _poll_internal(struct pollfd *pfds, unsigned int nfds,
 	return n;
 }
 
+#if defined(__linux__)
+static eio_epoll_t *_epoll_create(void)
+{
+	eio_epoll_t *ep;
+	int epfd;
+
+	if ((epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+		debug("%s: epoll_create1: %m, using poll", __func__);
+		return NULL;
+	}
+
+	ep = xmalloc(sizeof(*ep));
+	ep->epfd = epfd;
+	return ep;
+}
+
+static void _epoll_destroy(eio_epoll_t *ep)
+{
+	if (!ep)
+		return;
+
+	if (ep->epfd >= 0)
+		close(ep->epfd);
+	xfree(ep->events);
+	xfree(ep->gen);
+	xfree(ep->want);
+	xfree(ep->pass);
+	xfree(ep->owner);
+	xfree(ep->first);
+	xfree(ep->reg_fds);
+	xfree(ep->next);
+	xfree(ep->ready);
+	xfree(ep);
+}
+
+/* Make the fd indexed arrays of ep large enough to hold fd */
+static void _epoll_grow(eio_epoll_t *ep, int fd)
+{
+	int fd_cnt = MAX(ep->fd_cnt * 2, 64);
+
+	while (fd_cnt <= fd)
+		fd_cnt *= 2;
+
+	xrealloc(ep->events, fd_cnt * sizeof(uint32_t));
+	xrealloc(ep->gen, fd_cnt * sizeof(uint32_t));
+	xrealloc(ep->want, fd_cnt * sizeof(uint32_t));
+	xrealloc(ep->pass, fd_cnt * sizeof(uint32_t));
+	xrealloc(ep->owner, fd_cnt * sizeof(uint32_t));
+	xrealloc(ep->first, fd_cnt * sizeof(int));
+	xrealloc(ep->reg_fds, fd_cnt * sizeof(int));
+	ep->fd_cnt = fd_cnt;
+}
+
+/*
+ * Drop every registration and start a new epoll instance. Used when an
+ * event arrives for a registration that can no longer be removed, which
+ * happens when an fd was closed while a dup of it is still open elsewhere.
+ */
+static int _epoll_rebuild(eio_epoll_t *ep)
+{
+	int i;
+
+	close(ep->epfd);
+	if ((ep->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+		error("%s: epoll_create1: %m", __func__);
+		return -1;
+	}
+	for (i = 0; i < ep->reg_cnt; i++)
+		ep->events[ep->reg_fds[i]] = 0;
+	ep->reg_cnt = 0;
+	ep->rebuild = false;
+
+	return 0;
+}
+
+/* Stop tracking a registration of fd, the kernel side is left as is */
+static void _epoll_forget(eio_epoll_t *ep, int fd)
+{
+	int i;
+
+	ep->events[fd] = 0;
+	for (i = 0; i < ep->reg_cnt; i++) {
+		if (ep->reg_fds[i] == fd) {
+			ep->reg_fds[i] = ep->reg_fds[--ep->reg_cnt];
+			break;
+		}
+	}
+}
+
+/* Register events for fd, RET -1 with errno set on failure */
+static int _epoll_set(eio_epoll_t *ep, int fd, uint32_t events)
+{
+	struct epoll_event ev = { 0 };
+
+	ev.events = events;
+	if (ep->events[fd]) {
+		ev.data.u64 = ((uint64_t) ep->gen[fd] << 32) | fd;
+		if (!epoll_ctl(ep->epfd, EPOLL_CTL_MOD, fd, &ev)) {
+			ep->events[fd] = events;
+			return 0;
+		}
+		if (errno != ENOENT)
+			return -1;
+		/* fd was closed and reused since it was added */
+		_epoll_forget(ep, fd);
+	}
+
+	ep->gen[fd]++;
+	ev.data.u64 = ((uint64_t) ep->gen[fd] << 32) | fd;
+	if (epoll_ctl(ep->epfd, EPOLL_CTL_ADD, fd, &ev))
+		return -1;
+	ep->events[fd] = events;
+	ep->reg_fds[ep->reg_cnt++] = fd;
+
+	return 0;
+}
+
+/*
+ * Same as _poll_internal() but waits through the epoll interest set of ep,
+ * which is first brought in line with the events asked for in pfds.
+ * revents of pfds are filled in as poll() would. map holds the object of
+ * each pollfd but the last one, the eio signaling fd.
+ */
+static int _epoll_internal(eio_epoll_t *ep, struct pollfd *pfds,
+			   eio_obj_t **map, unsigned int nfds,
+			   time_t shutdown_time)
+{
+	int i, j, n, fd, timeout, reg_cnt = 0, nval_cnt = 0;
+	uint32_t gen, owner;
+
+	if (ep->rebuild && (_epoll_rebuild(ep) < 0))
+		return -1;
+
+	if (ep->pfd_cnt < nfds) {
+		ep->pfd_cnt = nfds;
+		xrealloc(ep->next, nfds * sizeof(int));
+		xrealloc(ep->ready, nfds * sizeof(struct epoll_event));
+	}
+
+	/* Chain the pollfds of each fd and gather the events they want */
+	ep->pass_cnt++;
+	for (i = nfds - 1; i >= 0; i--) {
+		pfds[i].revents = 0;
+		if ((fd = pfds[i].fd) < 0)
+			continue;
+		if (fd >= ep->fd_cnt)
+			_epoll_grow(ep, fd);
+		if (ep->pass[fd] != ep->pass_cnt) {
+			ep->pass[fd] = ep->pass_cnt;
+			ep->want[fd] = 0;
+			ep->next[i] = -1;
+		} else
+			ep->next[i] = ep->first[fd];
+		ep->first[fd] = i;
+		ep->want[fd] |= pfds[i].events;
+	}
+
+	/* Remove fds nobody wants any more */
+	for (i = 0; i < ep->reg_cnt; i++) {
+		fd = ep->reg_fds[i];
+		if (ep->pass[fd] == ep->pass_cnt) {
+			ep->reg_fds[reg_cnt++] = fd;
+			continue;
+		}
+		/* Fails if fd was closed already, which removed it */
+		(void) epoll_ctl(ep->epfd, EPOLL_CTL_DEL, fd, NULL);
+		ep->events[fd] = 0;
+	}
+	ep->reg_cnt = reg_cnt;
+
+	/* Add or change the others */
+	for (i = 0; i < nfds; i++) {
+		fd = pfds[i].fd;
+		if ((fd < 0) || (ep->first[fd] != i))
+			continue;
+		/*
+		 * A new object on the fd means the old one may have closed it
+		 * and the number got reused, which silently dropped it from
+		 * the interest set. Register it again to be sure.
+		 */
+		owner = (i < (nfds - 1)) ? map[i]->serial : 0;
+		if (ep->events[fd] && (ep->owner[fd] != owner)) {
+			(void) epoll_ctl(ep->epfd, EPOLL_CTL_DEL, fd, NULL);
+			_epoll_forget(ep, fd);
+		}
+		ep->owner[fd] = owner;
+		if (ep->events[fd] == ep->want[fd])
+			continue;
+		if (!_epoll_set(ep, fd, ep->want[fd]))
+			continue;
+		if (errno != EBADF) {
+			error("%s: epoll_ctl(%d): %m", __func__, fd);
+			return -1;
+		}
+		/* Closed fd, report it as poll() would */
+		if (ep->events[fd])
+			_epoll_forget(ep, fd);
+		for (j = i; j >= 0; j = ep->next[j])
+			pfds[j].revents = POLLNVAL;
+		nval_cnt++;
+	}
+
+	if (nval_cnt)
+		timeout = 0;
+	else if (shutdown_time)
+		timeout = 1000;	/* Return every 1000 msec during shutdown */
+	else
+		timeout = -1;
+	while ((n = epoll_wait(ep->epfd, ep->ready, nfds, timeout)) < 0) {
+		switch (errno) {
+		case EINTR:
+			return nval_cnt;
+		case EAGAIN:
+			continue;
+		default:
+			error("epoll_wait: %m");
+			return -1;
+		}
+	}
+
+	for (i = 0; i < n; i++) {
+		fd = ep->ready[i].data.u64 & 0xffffffff;
+		gen = ep->ready[i].data.u64 >> 32;
+		if ((fd >= ep->fd_cnt) || !ep->events[fd] ||
+		    (ep->gen[fd] != gen)) {
+			ep->rebuild = true;
+			continue;
+		}
+		for (j = ep->first[fd]; j >= 0; j = ep->next[j])
+			pfds[j].revents = ep->ready[i].events &
+				(pfds[j].events | POLLERR | POLLHUP);
+	}
+
+	return n + nval_cnt;
+}
+#endif
+
 static bool _is_writable(eio_obj_t *obj)
 {
 	return (obj->ops->writable && (*obj->ops->writable)(obj));
@@ -502,6 +797,12 @@ eio_obj_t *eio_obj_create(int fd, struct io_operations *ops, void *arg)
 	obj->arg = arg;
 	obj->ops = _ops_copy(ops);
 	obj->shutdown = false;
+	slurm_mutex_lock(&serial_mutex);
+	/* 0 is the eio signaling fd in _epoll_internal() */
+	if (!++obj_serial)
+		++obj_serial;
+	obj->serial = obj_serial;
+	slurm_mutex_unlock(&serial_mutex);
 	return obj;
 }
 
@@ -67,6 +67,7 @@ struct eio_obj {
 	void *arg;                        /* application-specific data       */
 	struct io_operations *ops;        /* pointer to ops struct for obj   */
 	bool shutdown;
+	uint32_t serial;                  /* unique, set by eio_obj_create() */
 };
 
 eio_handle_t *eio_handle_create(uint16_t);
@@ -36,9 +36,12 @@
 
 #define _GNU_SOURCE
 
+#include <fcntl.h>
 #include <inttypes.h>
 #include <sys/mman.h>	/* memfd_create */
+#include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "src/common/fetch_config.h"
 #include "src/common/read_config.h"
@@ -313,6 +316,30 @@ static void _init_minimal_conf_server_config(List controllers)
 	xfree(filename);
 }
 
+/* Return true if the file exists and holds exactly the given content */
+static bool _conf_unchanged(const char *file, const char *content)
+{
+	struct stat stat_buf;
+	size_t len = strlen(content);
+	char *buf = NULL;
+	bool match = false;
+	int fd;
+
+	if ((fd = open(file, O_RDONLY|O_CLOEXEC)) < 0)
+		return false;
+
+	if (!fstat(fd, &stat_buf) && (stat_buf.st_size == (off_t) len)) {
+		buf = xmalloc(len + 1);
+		safe_read(fd, buf, len);
+		match = !memcmp(buf, content, len);
+	}
+
+rwfail:
+	xfree(buf);
+	close(fd);
+	return match;
+}
+
 static int _write_conf(const char *dir, const char *name, const char *content)
 {
 	char *file = NULL, *file_final = NULL;
@@ -326,6 +353,13 @@ static int _write_conf(const char *dir, const char *name, const char *content)
 		goto cleanup;
 	}
 
+	/*
+	 * Every reconfigure pushes all of the configs to every node, but
+	 * usually only one of them has changed. Leave identical files alone.
+	 */
+	if (_conf_unchanged(file_final, content))
+		goto cleanup;
+
 	if ((fd = open(file, O_CREAT|O_WRONLY|O_TRUNC|O_CLOEXEC, 0644)) < 0) {
 		error("%s: could not open config file `%s`", __func__, file);
 		goto rwfail;
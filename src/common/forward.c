@@ -41,6 +41,7 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/time.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -52,9 +53,27 @@
 #include "src/common/slurm_route.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
+#define FWD_LATENCY_FAIL	(10 * USEC_IN_SEC) /* latency sample charged
+						    * for a failed head */
+#define FWD_LATENCY_SLOW	2	/* replace a head only if it is this
+					 * many times slower than the best */
+
+/*
+ * Decaying average time for the RPCs sent to a node while it was the head
+ * of a branch of the tree, divided by the depth of that branch
+ */
+typedef struct {
+	char *name;
+	uint32_t latency;	/* usec per tree level */
+} fwd_latency_t;
+
+static pthread_mutex_t fwd_latency_lock = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *fwd_latency_hash = NULL;
+
 typedef struct {
 	pthread_cond_t *notify;
 	int            *p_thr_count;
@@ -73,6 +92,123 @@ static void _forward_msg_internal(hostlist_t hl, hostlist_t* sp_hl,
 				  header_t *header, int timeout,
 				  int hl_count);
 
+static void _latency_id(void *item, const char **key, uint32_t *key_len)
+{
+	fwd_latency_t *fwd_latency = item;
+
+	*key = fwd_latency->name;
+	*key_len = strlen(fwd_latency->name);
+}
+
+static void _latency_free(void *item)
+{
+	fwd_latency_t *fwd_latency = item;
+
+	xfree(fwd_latency->name);
+	xfree(fwd_latency);
+}
+
+/* TopologyParam=RouteLatency */
+static bool _latency_enabled(void)
+{
+	return (xstrcasestr(slurm_conf.topology_param, "RouteLatency") != NULL);
+}
+
+/*
+ * Record the time a branch head took to answer for itself and fwd_cnt
+ * forwarded nodes, or that it failed to
+ */
+static void _latency_record(const char *name, struct timeval *start,
+			    int fwd_cnt, bool failed)
+{
+	fwd_latency_t *fwd_latency;
+	struct timeval end;
+	uint32_t sample;
+	int levels = 1, tree_width = MAX(slurm_conf.tree_width, 2);
+	int save_errno = errno;	/* callers still test errno */
+
+	if (!_latency_enabled())
+		return;
+
+	if (failed) {
+		sample = FWD_LATENCY_FAIL;
+	} else {
+		gettimeofday(&end, NULL);
+		while (fwd_cnt > 0) {
+			levels++;
+			fwd_cnt /= tree_width;
+		}
+		sample = ((end.tv_sec - start->tv_sec) * USEC_IN_SEC +
+			  end.tv_usec - start->tv_usec) / levels;
+	}
+
+	slurm_mutex_lock(&fwd_latency_lock);
+	if (!fwd_latency_hash)
+		fwd_latency_hash = xhash_init(_latency_id, _latency_free);
+	if (!(fwd_latency = xhash_get_str(fwd_latency_hash, name))) {
+		fwd_latency = xmalloc(sizeof(*fwd_latency));
+		fwd_latency->name = xstrdup(name);
+		fwd_latency->latency = sample;
+		xhash_add(fwd_latency_hash, fwd_latency);
+	} else {
+		fwd_latency->latency = (fwd_latency->latency * 7 + sample) / 8;
+	}
+	slurm_mutex_unlock(&fwd_latency_lock);
+	errno = save_errno;
+}
+
+/*
+ * Remove and return the node to send to for a branch of the tree. This is
+ * the first node of the branch unless TopologyParam=RouteLatency is set and
+ * another node of the branch has answered much faster as a branch head.
+ * Nodes without history count as fast, so every node gets tried out.
+ * RET node name to free() as returned by hostlist_shift()
+ */
+static char *_next_head(hostlist_t hl)
+{
+	hostlist_iterator_t itr;
+	fwd_latency_t *fwd_latency;
+	char *name, *best_name = NULL;
+	uint32_t latency, first_latency = 0, best_latency = 0;
+	bool first = true;
+
+	if ((hostlist_count(hl) < 2) || !_latency_enabled())
+		return hostlist_shift(hl);
+
+	slurm_mutex_lock(&fwd_latency_lock);
+	if (!fwd_latency_hash) {
+		slurm_mutex_unlock(&fwd_latency_lock);
+		return hostlist_shift(hl);
+	}
+	itr = hostlist_iterator_create(hl);
+	while ((name = hostlist_next(itr))) {
+		fwd_latency = xhash_get_str(fwd_latency_hash, name);
+		latency = fwd_latency ? fwd_latency->latency : 0;
+		if (first) {
+			first_latency = latency;
+			first = false;
+		} else if (!best_name || (latency < best_latency)) {
+			if (best_name)
+				free(best_name);
+			best_name = name;
+			best_latency = latency;
+			continue;
+		}
+		free(name);
+	}
+	hostlist_iterator_destroy(itr);
+	slurm_mutex_unlock(&fwd_latency_lock);
+
+	if (!best_name || ((best_latency * FWD_LATENCY_SLOW) >= first_latency)) {
+		if (best_name)
+			free(best_name);
+		return hostlist_shift(hl);
+	}
+
+	hostlist_delete_host(hl, best_name);
+	return best_name;
+}
+
 void _destroy_tree_fwd(fwd_tree_t *fwd_tree)
 {
 	if (fwd_tree) {
@@ -106,9 +242,12 @@ void *_forward_thread(void *arg)
 	char *buf = NULL;
 	int steps = 0;
 	int start_timeout = fwd_msg->timeout;
+	struct timeval start;
+	struct iovec iov[2];
 
 	/* repeat until we are sure the message was sent */
-	while ((name = hostlist_shift(hl))) {
+	while ((name = _next_head(hl))) {
+		gettimeofday(&start, NULL);
 		if (slurm_conf_get_addr(name, &addr, fwd_msg->header.flags)
 		    == SLURM_ERROR) {
 			error("forward_thread: can't find address for host "
@@ -125,6 +264,7 @@ void *_forward_thread(void *arg)
 		}
 		if ((fd = slurm_open_msg_conn(&addr)) < 0) {
 			error("forward_thread to %s: %m", name);
+			_latency_record(name, &start, 0, true);
 
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			mark_as_failed_forward(
@@ -163,25 +303,15 @@ void *_forward_thread(void *arg)
 
 		pack_header(&fwd_msg->header, buffer);
 
-		/* add forward data to buffer */
-		if (remaining_buf(buffer) < fwd_struct->buf_len) {
-			int new_size = buffer->processed + fwd_struct->buf_len;
-			new_size += 1024; /* padded for paranoia */
-			xrealloc_nz(buffer->head, new_size);
-			buffer->size = new_size;
-		}
-		if (fwd_struct->buf_len) {
-			memcpy(&buffer->head[buffer->processed],
-			       fwd_struct->buf, fwd_struct->buf_len);
-			buffer->processed += fwd_struct->buf_len;
-		}
-
 		/*
-		 * forward message
+		 * forward message, the forward data is sent in place after
+		 * the header rather than being copied into the buffer
 		 */
-		if (slurm_msg_sendto(fd,
-				     get_buf_data(buffer),
-				     get_buf_offset(buffer)) < 0) {
+		iov[0].iov_base = get_buf_data(buffer);
+		iov[0].iov_len = get_buf_offset(buffer);
+		iov[1].iov_base = fwd_struct->buf;
+		iov[1].iov_len = fwd_struct->buf_len;
+		if (slurm_msg_sendv(fd, iov, 2) < 0) {
 			error("forward_thread: slurm_msg_sendto: %m");
 
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
@@ -190,7 +320,7 @@ void *_forward_thread(void *arg)
 			free(name);
 			if (hostlist_count(hl) > 0) {
 				free_buf(buffer);
-				buffer = init_buf(fwd_struct->buf_len);
+				buffer = init_buf(BUF_SIZE);
 				slurm_mutex_unlock(&fwd_struct->forward_mutex);
 				close(fd);
 				fd = -1;
@@ -246,9 +376,14 @@ void *_forward_thread(void *arg)
 		ret_list = slurm_receive_msgs(fd, steps, fwd_msg->timeout);
 		/* info("sent %d forwards got %d back", */
 		/*      fwd_msg->header.forward.cnt, list_count(ret_list)); */
+		if (ret_list && (list_count(ret_list) >
+				 fwd_msg->header.forward.cnt))
+			_latency_record(name, &start,
+					fwd_msg->header.forward.cnt, false);
 
 		if (!ret_list || (fwd_msg->header.forward.cnt != 0
 				  && list_count(ret_list) <= 1)) {
+			_latency_record(name, &start, 0, true);
 			slurm_mutex_lock(&fwd_struct->forward_mutex);
 			mark_as_failed_forward(&fwd_struct->ret_list, name,
 					       errno);
@@ -256,7 +391,7 @@ void *_forward_thread(void *arg)
 			FREE_NULL_LIST(ret_list);
 			if (hostlist_count(hl) > 0) {
 				free_buf(buffer);
-				buffer = init_buf(fwd_struct->buf_len);
+				buffer = init_buf(BUF_SIZE);
 				slurm_mutex_unlock(&fwd_struct->forward_mutex);
 				close(fd);
 				fd = -1;
@@ -346,6 +481,7 @@ void *_fwd_tree_thread(void *arg)
 	char *name = NULL;
 	char *buf = NULL;
 	slurm_msg_t send_msg;
+	struct timeval start;
 
 	slurm_msg_t_init(&send_msg);
 	send_msg.msg_type = fwd_tree->orig_msg->msg_type;
@@ -354,7 +490,7 @@ void *_fwd_tree_thread(void *arg)
 	send_msg.protocol_version = fwd_tree->orig_msg->protocol_version;
 
 	/* repeat until we are sure the message was sent */
-	while ((name = hostlist_shift(fwd_tree->tree_hl))) {
+	while ((name = _next_head(fwd_tree->tree_hl))) {
 		if (slurm_conf_get_addr(name, &send_msg.address, send_msg.flags)
 		    == SLURM_ERROR) {
 			error("fwd_tree_thread: can't find address for host "
@@ -383,6 +519,7 @@ void *_fwd_tree_thread(void *arg)
 		} else
 			debug3("Tree sending to %s", name);
 
+		gettimeofday(&start, NULL);
 		ret_list = slurm_send_addr_recv_msgs(&send_msg, name,
 						     fwd_tree->timeout);
 
@@ -390,6 +527,10 @@ void *_fwd_tree_thread(void *arg)
 
 		if (ret_list) {
 			int ret_cnt = list_count(ret_list);
+			_latency_record(name, &start, send_msg.forward.cnt,
+					((ret_cnt <= send_msg.forward.cnt) ||
+					 (errno ==
+					  SLURM_COMMUNICATIONS_CONNECTION_ERROR)));
 			/* This is most common if a slurmd is running
 			   an older version of Slurm than the
 			   originator of the message.
@@ -575,6 +716,13 @@ extern void forward_init(forward_t *forward)
 	forward->init = FORWARD_INIT;
 }
 
+extern void forward_fini(void)
+{
+	slurm_mutex_lock(&fwd_latency_lock);
+	xhash_free(fwd_latency_hash);
+	slurm_mutex_unlock(&fwd_latency_lock);
+}
+
 /*
  * forward_msg        - logic to forward a message which has been received and
  *                      accumulate the return codes from processes getting the
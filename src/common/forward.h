@@ -49,6 +49,11 @@
  */
 extern void forward_init(forward_t *forward);
 
+/*
+ * forward_fini    - free the branch head latencies kept with RouteLatency
+ */
+extern void forward_fini(void);
+
 /*
  * forward_msg	      - logic to forward a message which has been received and
  *			accumulate the return codes from processes getting the
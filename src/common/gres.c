@@ -6920,6 +6920,14 @@ extern char *gres_sock_str(List sock_gres_list, int sock_inx)
  * GRES of a given type model can be distributed over multiple topo structures,
  * so we need to OR the core_bitmap over all of them.
  */
+/* Return true if any bit from start up to (not including) end is set */
+static bool _bit_range_any(bitstr_t *b, bitoff_t start, bitoff_t end)
+{
+	bitoff_t bit = bit_ffs_from_bit(b, start);
+
+	return ((bit >= 0) && (bit < end));
+}
+
 static sock_gres_t *_build_sock_gres_by_topo(
 	gres_job_state_t *job_gres_ptr,
 	gres_node_state_t *node_gres_ptr,
@@ -7008,16 +7016,10 @@ static sock_gres_t *_build_sock_gres_by_topo(
 		    node_gres_ptr->topo_core_bitmap[i]) {
 			use_all_sockets = true;
 			for (s = 0; s < sockets; s++) {
-				bool use_this_socket = false;
-				for (c = 0; c < cores_per_sock; c++) {
-					j = (s * cores_per_sock) + c;
-					if (bit_test(node_gres_ptr->
-						     topo_core_bitmap[i], j)) {
-						use_this_socket = true;
-						break;
-					}
-				}
-				if (!use_this_socket) {
+				j = s * cores_per_sock;
+				if (!_bit_range_any(node_gres_ptr->
+						    topo_core_bitmap[i], j,
+						    j + cores_per_sock)) {
 					use_all_sockets = false;
 					break;
 				}
@@ -7054,44 +7056,35 @@ static sock_gres_t *_build_sock_gres_by_topo(
 						 topo_core_bitmap[i]));
 		}
 		for (s = 0; ((s < sockets) && avail_gres); s++) {
-			if (enforce_binding && core_bitmap) {
-				for (c = 0; c < cores_per_sock; c++) {
-					j = (s * cores_per_sock) + c;
-					if (bit_test(core_bitmap, j))
-						break;
-				}
-				if (c >= cores_per_sock) {
-					/* No available cores on this socket */
-					continue;
-				}
+			j = s * cores_per_sock;
+			if (enforce_binding && core_bitmap &&
+			    !_bit_range_any(core_bitmap, j,
+					    j + cores_per_sock)) {
+				/* No available cores on this socket */
+				continue;
 			}
-			for (c = 0; c < cores_per_sock; c++) {
-				j = (s * cores_per_sock) + c;
-				if (j >= tot_cores)
-					break;	/* Off end of core bitmap */
-				if (node_gres_ptr->topo_core_bitmap[i] &&
-				    !bit_test(node_gres_ptr->topo_core_bitmap[i],
-					      j))
-					continue;
-				if (!node_gres_ptr->topo_gres_bitmap[i]) {
-					error("%s: topo_gres_bitmap NULL on node %s",
-					      __func__, node_name);
-					continue;
-				}
-				if (!sock_gres->bits_by_sock[s]) {
-					sock_gres->bits_by_sock[s] =
-						bit_copy(node_gres_ptr->
-							 topo_gres_bitmap[i]);
-				} else {
-					bit_or(sock_gres->bits_by_sock[s],
-					       node_gres_ptr->topo_gres_bitmap[i]);
-				}
-				sock_gres->cnt_by_sock[s] += avail_gres;
-				sock_gres->total_cnt += avail_gres;
-				avail_gres = 0;
-				match = true;
-				break;
+			/* Any core of this socket usable by this GRES */
+			if (!_bit_range_any(node_gres_ptr->topo_core_bitmap[i],
+					    j, MIN(j + cores_per_sock,
+						   tot_cores)))
+				continue;
+			if (!node_gres_ptr->topo_gres_bitmap[i]) {
+				error("%s: topo_gres_bitmap NULL on node %s",
+				      __func__, node_name);
+				continue;
+			}
+			if (!sock_gres->bits_by_sock[s]) {
+				sock_gres->bits_by_sock[s] =
+					bit_copy(node_gres_ptr->
+						 topo_gres_bitmap[i]);
+			} else {
+				bit_or(sock_gres->bits_by_sock[s],
+				       node_gres_ptr->topo_gres_bitmap[i]);
 			}
+			sock_gres->cnt_by_sock[s] += avail_gres;
+			sock_gres->total_cnt += avail_gres;
+			avail_gres = 0;
+			match = true;
 		}
 	}
 
@@ -7137,13 +7130,10 @@ static sock_gres_t *_build_sock_gres_by_topo(
 		for (s = 0; s < sockets; s++) {
 			if (sock_gres->cnt_by_sock[s] == 0)
 				continue;
-			for (c = 0; c < cores_per_sock; c++) {
-				i = (s * cores_per_sock) + c;
-				if (!bit_test(core_bitmap, i))
-					continue;
+			i = s * cores_per_sock;
+			if (_bit_range_any(core_bitmap, i, i + cores_per_sock)) {
 				avail_sock++;
 				avail_sock_flag[s] = true;
-				break;
 			}
 		}
 		while (avail_sock > s_p_n) {
@@ -45,9 +45,13 @@
  *   is -1 for not enough space, and we will xrealloc to handle this.
  *   In practice, if the name service cannot resolve a given user ID you will
  *   get an array back with a single element equal to the gid passed in.
+ * - Also cache the passwd fields for a uid (user_cache_lookup), so building
+ *   a job credential with send_gids does not query the name service each
+ *   time. Failed lookups are not cached.
  */
 
 #include <grp.h>
+#include <pwd.h>
 
 #include "src/common/group_cache.h"
 #include "src/common/list.h"
@@ -76,8 +80,18 @@ typedef struct gids_cache_needle {
 	time_t now;		/* automatically filled in */
 } gids_cache_needle_t;
 
+typedef struct user_cache {
+	uid_t uid;
+	char *pw_name;
+	char *pw_gecos;
+	char *pw_dir;
+	char *pw_shell;
+	time_t expiration;
+} user_cache_t;
+
 static pthread_mutex_t gids_mutex = PTHREAD_MUTEX_INITIALIZER;
 static List gids_cache_list = NULL;
+static List user_cache_list = NULL;
 
 static void _group_cache_list_delete(void *x)
 {
@@ -87,13 +101,22 @@ static void _group_cache_list_delete(void *x)
 	xfree(entry);
 }
 
+static void _user_cache_list_delete(void *x)
+{
+	user_cache_t *entry = (user_cache_t *) x;
+	xfree(entry->pw_name);
+	xfree(entry->pw_gecos);
+	xfree(entry->pw_dir);
+	xfree(entry->pw_shell);
+	xfree(entry);
+}
+
 /* call on daemon shutdown to cleanup properly */
 void group_cache_purge(void)
 {
 	slurm_mutex_lock(&gids_mutex);
-	if (gids_cache_list)
-		list_destroy(gids_cache_list);
-	gids_cache_list = NULL;
+	FREE_NULL_LIST(gids_cache_list);
+	FREE_NULL_LIST(user_cache_list);
 	slurm_mutex_unlock(&gids_mutex);
 }
 
@@ -215,6 +238,87 @@ extern int group_cache_lookup(uid_t uid, gid_t gid, char *username, gid_t **gids
 	return _group_cache_lookup_internal(&needle, gids);
 }
 
+static int _find_user_entry(void *x, void *key)
+{
+	user_cache_t *entry = (user_cache_t *) x;
+	uid_t *uid = (uid_t *) key;
+
+	return (entry->uid == *uid);
+}
+
+static void _copy_user_entry(user_cache_t *entry, char **pw_name,
+			     char **pw_gecos, char **pw_dir, char **pw_shell)
+{
+	if (pw_name)
+		*pw_name = xstrdup(entry->pw_name);
+	if (pw_gecos)
+		*pw_gecos = xstrdup(entry->pw_gecos);
+	if (pw_dir)
+		*pw_dir = xstrdup(entry->pw_dir);
+	if (pw_shell)
+		*pw_shell = xstrdup(entry->pw_shell);
+}
+
+/*
+ * IN: uid
+ * OUT: (optional) pw_name, pw_gecos, pw_dir, pw_shell - xmalloc'd strings
+ * RET: SLURM_SUCCESS, or SLURM_ERROR if the uid could not be resolved
+ */
+extern int user_cache_lookup(uid_t uid, char **pw_name, char **pw_gecos,
+			     char **pw_dir, char **pw_shell)
+{
+	struct passwd pwd, *result;
+	char buffer[PW_BUF_SIZE];
+	user_cache_t *entry;
+	time_t now = time(NULL);
+	int rc;
+	DEF_TIMERS;
+
+	slurm_mutex_lock(&gids_mutex);
+	if (user_cache_list &&
+	    (entry = list_find_first(user_cache_list, _find_user_entry,
+				     &uid)) &&
+	    (entry->expiration > now)) {
+		_copy_user_entry(entry, pw_name, pw_gecos, pw_dir, pw_shell);
+		slurm_mutex_unlock(&gids_mutex);
+		return SLURM_SUCCESS;
+	}
+	slurm_mutex_unlock(&gids_mutex);
+
+	/* Don't serialize the other lookups behind the name service */
+	START_TIMER;
+	rc = slurm_getpwuid_r(uid, &pwd, buffer, PW_BUF_SIZE, &result);
+	END_TIMER3("user_cache_lookup() took", 3000000);
+	if (rc || !result) {
+		error("%s: getpwuid failed for uid=%u: %s",
+		      __func__, uid, slurm_strerror(rc));
+		return SLURM_ERROR;
+	}
+
+	slurm_mutex_lock(&gids_mutex);
+	if (!user_cache_list)
+		user_cache_list = list_create(_user_cache_list_delete);
+	if (!(entry = list_find_first(user_cache_list, _find_user_entry,
+				      &uid))) {
+		entry = xmalloc(sizeof(*entry));
+		entry->uid = uid;
+		list_prepend(user_cache_list, entry);
+	}
+	xfree(entry->pw_name);
+	xfree(entry->pw_gecos);
+	xfree(entry->pw_dir);
+	xfree(entry->pw_shell);
+	entry->pw_name = xstrdup(result->pw_name);
+	entry->pw_gecos = xstrdup(result->pw_gecos);
+	entry->pw_dir = xstrdup(result->pw_dir);
+	entry->pw_shell = xstrdup(result->pw_shell);
+	entry->expiration = now + slurm_conf.group_time;
+	_copy_user_entry(entry, pw_name, pw_gecos, pw_dir, pw_shell);
+	slurm_mutex_unlock(&gids_mutex);
+
+	return SLURM_SUCCESS;
+}
+
 static int _cleanup_search(void *x, void *key)
 {
 	gids_cache_t *cached = (gids_cache_t *) x;
@@ -226,6 +330,17 @@ static int _cleanup_search(void *x, void *key)
 	return 0;
 }
 
+static int _user_cleanup_search(void *x, void *key)
+{
+	user_cache_t *cached = (user_cache_t *) x;
+	time_t *now = (time_t *) key;
+
+	if (cached->expiration < *now)
+		return 1;
+
+	return 0;
+}
+
 /*
  * Call periodically to remove old records.
  */
@@ -236,6 +351,8 @@ extern void group_cache_cleanup(void)
 	slurm_mutex_lock(&gids_mutex);
 	if (gids_cache_list)
 		list_delete_all(gids_cache_list, _cleanup_search, &now);
+	if (user_cache_list)
+		list_delete_all(user_cache_list, _user_cleanup_search, &now);
 	slurm_mutex_unlock(&gids_mutex);
 }
 
@@ -1946,6 +1946,48 @@ int hostlist_push(hostlist_t hl, const char *hosts)
 	return retval;
 }
 
+/*
+ * Extend the last range of hl by host str if str is the next host of that
+ * range, without creating a hostname and hostrange for it. This is the
+ * common case when pushing hosts in node table order.
+ * RET true if str was added to hl
+ */
+static bool _hostlist_push_tail(hostlist_t hl, const char *str, int dims)
+{
+	hostrange_t *tail;
+	int idx, len, width, base = hostlist_get_base(dims);
+	unsigned long num;
+	char *p;
+	bool pushed = false;
+
+	len = strlen(str);
+	idx = host_prefix_end(str, dims);
+	if (idx == (len - 1))
+		return false;	/* no numeric suffix */
+	width = len - idx - 1;
+	if ((dims > 1) && (width != dims))
+		base = 10;
+	num = strtoul(str + idx + 1, &p, base);
+	if (*p != '\0')
+		return false;
+
+	LOCK_HOSTLIST(hl);
+	if (hl->nranges > 0) {
+		tail = hl->hr[hl->nranges - 1];
+		if (!tail->singlehost && (tail->hi == num - 1) &&
+		    (strlen(tail->prefix) == (idx + 1)) &&
+		    !strncmp(tail->prefix, str, idx + 1) &&
+		    _width_equiv(tail->lo, &tail->width, num, &width)) {
+			tail->hi = num;
+			hl->nhosts++;
+			pushed = true;
+		}
+	}
+	UNLOCK_HOSTLIST(hl);
+
+	return pushed;
+}
+
 int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims)
 {
 	hostrange_t *hr;
@@ -1957,6 +1999,9 @@ int hostlist_push_host_dims(hostlist_t hl, const char *str, int dims)
 	if (!dims)
 		dims = slurmdb_setup_cluster_name_dims();
 
+	if (_hostlist_push_tail(hl, str, dims))
+		return 1;
+
 	hn = hostname_create_dims(str, dims);
 
 	if (hostname_suffix_is_valid(hn))
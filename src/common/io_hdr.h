@@ -54,6 +54,12 @@
 #define SLURM_IO_STDERR 2
 #define SLURM_IO_ALLSTDIN 3
 #define SLURM_IO_CONNECTION_TEST 4
+/*
+ * The body of a SLURM_IO_MULTI message is a sequence of complete non-empty
+ * SLURM_IO_STDOUT or SLURM_IO_STDERR messages (header and data) for the same
+ * stream, coalesced by slurmstepd to cut the per-message cost in srun.
+ */
+#define SLURM_IO_MULTI 5
 
 struct slurm_io_init_msg {
 	uint16_t      version;
@@ -310,15 +310,32 @@ int list_transfer_max(List l, List sub, int max)
 
 	xassert(l);
 	xassert(sub);
+	xassert(l != sub);
 	xassert(l->magic == LIST_MAGIC);
 	xassert(sub->magic == LIST_MAGIC);
 	xassert(l->fDel == sub->fDel);
 
-	while ((!max || n <= max) && (v = list_pop(sub))) {
-		list_append(l, v);
+	/*
+	 * Move the entries with both lists locked once rather than locking
+	 * each list for every entry. Lock in address order so two threads
+	 * transferring in opposite directions can not deadlock.
+	 */
+	if (l < sub) {
+		slurm_mutex_lock(&l->mutex);
+		slurm_mutex_lock(&sub->mutex);
+	} else {
+		slurm_mutex_lock(&sub->mutex);
+		slurm_mutex_lock(&l->mutex);
+	}
+
+	while ((!max || n < max) && (v = _list_pop_locked(sub))) {
+		_list_append_locked(l, v);
 		n++;
 	}
 
+	slurm_mutex_unlock(&sub->mutex);
+	slurm_mutex_unlock(&l->mutex);
+
 	return n;
 }
 
@@ -1176,6 +1176,14 @@ static void _log_msg(log_level_t level, bool sched, bool spank, const char *fmt,
 	char *msgbuf = NULL;
 	int priority = LOG_INFO;
 
+	/*
+	 * Format the message before taking log_lock. The caller has already
+	 * checked the level, and expanding the message (%m, %pJ, etc.) is the
+	 * most expensive part of logging, so keep it out of the section that
+	 * serializes every thread's output.
+	 */
+	buf = vxstrfmt(fmt, args);
+
 	slurm_mutex_lock(&log_lock);
 
 	if (!LOG_INITIALIZED) {
@@ -1185,7 +1193,6 @@ static void _log_msg(log_level_t level, bool sched, bool spank, const char *fmt,
 
 	if (SCHED_LOG_INITIALIZED && sched &&
 	    (highest_sched_log_level > LOG_LEVEL_QUIET)) {
-		buf = vxstrfmt(fmt, args);
 		xlogfmtcat(&msgbuf, "[%M] %s%s%s", sched_log->fpfx, pfx, buf);
 		_log_printf(sched_log, sched_log->fbuf, sched_log->logfp,
 			    "sched: %s\n", msgbuf);
@@ -1251,12 +1258,6 @@ static void _log_msg(log_level_t level, bool sched, bool spank, const char *fmt,
 
 	}
 
-	if (!buf) {
-		/* format the basic message,
-		 * if not already done for scheduling log */
-		buf = vxstrfmt(fmt, args);
-	}
-
 	if (level <= log->opt.stderr_level) {
 
 		fflush(stdout);
@@ -607,6 +607,21 @@ extern config_record_t *create_config_record(void)
 	return config_ptr;
 }
 
+/*
+ * Return the number of records allocated in node_record_table_ptr for
+ * node_cnt records. The table doubles in size as it grows since every
+ * xrealloc() of it requires rehashing all of the node records.
+ */
+static int _node_table_size(int node_cnt)
+{
+	int table_size = 64;
+
+	while (table_size < node_cnt)
+		table_size *= 2;
+
+	return table_size;
+}
+
 /*
  * create_node_record - create a node record and set its values to defaults
  * IN config_ptr - pointer to node's configuration information
@@ -619,25 +634,21 @@ extern node_record_t *create_node_record(config_record_t *config_ptr,
 					 char *node_name)
 {
 	node_record_t *node_ptr;
-	int old_buffer_size, new_buffer_size;
+	int old_table_size, new_table_size;
 	uint32_t tot_cores;
 
 	last_node_update = time (NULL);
 	xassert(config_ptr);
 	xassert(node_name);
 
-	/* round up the buffer size to reduce overhead of xrealloc */
-	old_buffer_size = (node_record_count) * sizeof(node_record_t);
-	old_buffer_size =
-		((int) ((old_buffer_size / BUF_SIZE) + 1)) * BUF_SIZE;
-	new_buffer_size =
-		(node_record_count + 1) * sizeof(node_record_t);
-	new_buffer_size =
-		((int) ((new_buffer_size / BUF_SIZE) + 1)) * BUF_SIZE;
+	old_table_size = _node_table_size(node_record_count);
+	new_table_size = _node_table_size(node_record_count + 1);
 	if (!node_record_table_ptr) {
-		node_record_table_ptr = xmalloc(new_buffer_size);
-	} else if (old_buffer_size != new_buffer_size) {
-		xrealloc (node_record_table_ptr, new_buffer_size);
+		node_record_table_ptr = xcalloc(new_table_size,
+						sizeof(node_record_t));
+	} else if (old_table_size != new_table_size) {
+		xrecalloc(node_record_table_ptr, new_table_size,
+			  sizeof(node_record_t));
 		/*
 		 * You need to rehash the hash after we realloc or we will have
 		 * only bad memory references in the hash.
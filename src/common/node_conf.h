@@ -176,6 +176,13 @@ struct node_record {
 	char *mcs_label;		/* mcs_label if mcs plugin in use */
 	uint16_t vpus;	                /* number of threads we are using per
 					 * core */
+	uint64_t pack_hash[2];		/* hash of last packed record, without
+					 * and with SHOW_DETAIL. NO_PACK */
+	time_t pack_change[2];		/* time pack_hash last changed. NO_PACK */
+	uint32_t event_gen;		/* event_mgr scan generation this node
+					 * was last seen in. NO_PACK */
+	uint32_t event_state;		/* node_state last reported by
+					 * event_mgr. NO_PACK */
 };
 extern node_record_t *node_record_table_ptr;  /* ptr to node records */
 extern int node_record_count;		/* count in node_record_table_ptr */
@@ -52,6 +52,7 @@
 
 #include "src/common/list.h"
 #include "src/common/node_select.h"
+#include "src/common/probes.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_selecttype_info.h"
 #include "src/common/xstring.h"
@@ -502,15 +503,21 @@ extern int select_g_job_test(job_record_t *job_ptr, bitstr_t *bitmap,
 			     List *preemptee_job_list,
 			     bitstr_t *exc_core_bitmap)
 {
+	int rc;
+
 	if (slurm_select_init(0) < 0)
 		return SLURM_ERROR;
 
-	return (*(ops[select_context_default].job_test))
+	SLURM_PROBE2(select__job_test, job_ptr->job_id, mode);
+	rc = (*(ops[select_context_default].job_test))
 		(job_ptr, bitmap,
 		 min_nodes, max_nodes,
 		 req_nodes, mode,
 		 preemptee_candidates, preemptee_job_list,
 		 exc_core_bitmap);
+	SLURM_PROBE2(select__job_test_done, job_ptr->job_id, rc);
+
+	return rc;
 }
 
 /*
@@ -46,6 +46,7 @@
 #include <inttypes.h>
 #include <math.h>
 #include <netinet/in.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -67,12 +68,26 @@
 #define MAX_ARRAY_LEN_MEDIUM	1000000
 #define MAX_ARRAY_LEN_LARGE	100000000
 
+/*
+ * Pool of buffer memory kept for reuse by init_pool_buf(). Class N holds
+ * allocations of at least (BUF_SIZE << N) bytes.
+ */
+#define BUF_POOL_CLASSES	11	/* BUF_SIZE through 16MB */
+#define BUF_POOL_DEPTH		4
+#define BUF_POOL_MAX_BYTES	(64 * 1024 * 1024)
+
+static pthread_mutex_t buf_pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static void *buf_pool[BUF_POOL_CLASSES][BUF_POOL_DEPTH];
+static int buf_pool_cnt[BUF_POOL_CLASSES];
+static size_t buf_pool_bytes = 0;
+
 /*
  * Define slurm-specific aliases for use by plugins, see slurm_xlator.h
  * for details.
  */
 strong_alias(create_buf,	slurm_create_buf);
 strong_alias(create_mmap_buf,	slurm_create_mmap_buf);
+strong_alias(create_shadow_buf,	slurm_create_shadow_buf);
 strong_alias(free_buf,		slurm_free_buf);
 strong_alias(grow_buf,		slurm_grow_buf);
 strong_alias(init_buf,		slurm_init_buf);
@@ -89,6 +104,14 @@ strong_alias(pack64,		slurm_pack64);
 strong_alias(unpack64,		slurm_unpack64);
 strong_alias(pack32,		slurm_pack32);
 strong_alias(unpack32,		slurm_unpack32);
+strong_alias(packvar64,		slurm_packvar64);
+strong_alias(unpackvar64,	slurm_unpackvar64);
+strong_alias(packvar32,		slurm_packvar32);
+strong_alias(unpackvar32,	slurm_unpackvar32);
+strong_alias(packvar_time,	slurm_packvar_time);
+strong_alias(unpackvar_time,	slurm_unpackvar_time);
+strong_alias(packvarmem,	slurm_packvarmem);
+strong_alias(unpackvarmem_xmalloc, slurm_unpackvarmem_xmalloc);
 strong_alias(pack16,		slurm_pack16);
 strong_alias(unpack16,		slurm_unpack16);
 strong_alias(pack8,		slurm_pack8);
@@ -129,6 +152,7 @@ buf_t *create_buf(char *data, uint32_t size)
 	my_buf->processed = 0;
 	my_buf->head = data;
 	my_buf->mmaped = false;
+	my_buf->shadow = false;
 
 	return my_buf;
 }
@@ -162,18 +186,48 @@ buf_t *create_mmap_buf(const char *file)
 		return NULL;
 	}
 
+	/*
+	 * Files mapped here are unpacked front to back. Ask for aggressive
+	 * read-ahead and start reading now, rather than faulting in one page
+	 * at a time from a cold (possibly network) file system.
+	 */
+	(void) madvise(data, f_stat.st_size, MADV_SEQUENTIAL);
+	(void) madvise(data, f_stat.st_size, MADV_WILLNEED);
+
 	my_buf = xmalloc_nz(sizeof(*my_buf));
 	my_buf->magic = BUF_MAGIC;
 	my_buf->size = f_stat.st_size;
 	my_buf->processed = 0;
 	my_buf->head = data;
 	my_buf->mmaped = true;
+	my_buf->shadow = false;
 
 	debug3("%s: loaded file `%s` as buf_t", __func__, file);
 
 	return my_buf;
 }
 
+/*
+ * create_shadow_buf - create a read-only buffer over data owned by another
+ *	buffer, typically a packmem() field of a message being unpacked. No
+ *	copy is made, so the shadow buffer must only be unpacked from and must
+ *	be freed before the buffer that owns the data.
+ */
+buf_t *create_shadow_buf(char *data, uint32_t size)
+{
+	buf_t *my_buf;
+
+	my_buf = xmalloc_nz(sizeof(*my_buf));
+	my_buf->magic = BUF_MAGIC;
+	my_buf->size = size;
+	my_buf->processed = 0;
+	my_buf->head = data;
+	my_buf->mmaped = false;
+	my_buf->shadow = true;
+
+	return my_buf;
+}
+
 
 /* free_buf - release memory associated with a given buffer */
 void free_buf(buf_t *my_buf)
@@ -183,7 +237,7 @@ void free_buf(buf_t *my_buf)
 	xassert(my_buf->magic == BUF_MAGIC);
 	if (my_buf->mmaped)
 		munmap(my_buf->head, my_buf->size);
-	else
+	else if (!my_buf->shadow)
 		xfree(my_buf->head);
 
 	xfree(my_buf);
@@ -194,6 +248,8 @@ void grow_buf(buf_t *buffer, uint32_t size)
 {
 	if (buffer->mmaped)
 		fatal_abort("attempt to grow mmap()'d buffer not supported");
+	if (buffer->shadow)
+		fatal_abort("attempt to grow shadow buffer not supported");
 	if ((buffer->size + size) > MAX_BUF_SIZE) {
 		error("%s: Buffer size limit exceeded (%u > %u)",
 		      __func__, (buffer->size + size), MAX_BUF_SIZE);
@@ -222,6 +278,7 @@ buf_t *init_buf(uint32_t size)
 	my_buf->processed = 0;
 	my_buf->head = xmalloc(size);
 	my_buf->mmaped = false;
+	my_buf->shadow = false;
 	return my_buf;
 }
 
@@ -235,12 +292,103 @@ void *xfer_buf_data(buf_t *my_buf)
 
 	if (my_buf->mmaped)
 		fatal_abort("attempt to grow mmap()'d buffer not supported");
+	if (my_buf->shadow)
+		fatal_abort("attempt to transfer shadow buffer not supported");
 
 	data_ptr = (void *) my_buf->head;
 	xfree(my_buf);
 	return data_ptr;
 }
 
+/*
+ * init_pool_buf - create an empty buffer of at least the given size, reusing
+ *	memory released by free_pool_buf() or free_pool_data() when possible.
+ *	Unlike init_buf() the contents are not zeroed.
+ */
+buf_t *init_pool_buf(uint32_t size)
+{
+	buf_t *my_buf;
+	void *head = NULL;
+	int i;
+
+	if (size <= 0)
+		size = BUF_SIZE;
+	for (i = 0; i < BUF_POOL_CLASSES; i++) {
+		if ((BUF_SIZE << i) >= size)
+			break;
+	}
+	if (i >= BUF_POOL_CLASSES)
+		return init_buf(size);
+
+	slurm_mutex_lock(&buf_pool_lock);
+	if (buf_pool_cnt[i]) {
+		head = buf_pool[i][--buf_pool_cnt[i]];
+		buf_pool_bytes -= xsize(head);
+	}
+	slurm_mutex_unlock(&buf_pool_lock);
+
+	if (!head)
+		head = xmalloc_nz(BUF_SIZE << i);
+
+	my_buf = xmalloc_nz(sizeof(*my_buf));
+	my_buf->magic = BUF_MAGIC;
+	my_buf->size = xsize(head);
+	my_buf->processed = 0;
+	my_buf->head = head;
+	my_buf->mmaped = false;
+	my_buf->shadow = false;
+	return my_buf;
+}
+
+/*
+ * free_pool_data - release xmalloc()'d buffer data, as returned by
+ *	xfer_buf_data(), keeping it for reuse by init_pool_buf() if there is
+ *	room in the pool
+ */
+void free_pool_data(void *data)
+{
+	size_t size;
+	int i;
+
+	if (!data)
+		return;
+
+	size = xsize(data);
+	for (i = BUF_POOL_CLASSES - 1; i >= 0; i--) {
+		if (size >= (BUF_SIZE << i))
+			break;
+	}
+	if (i < 0) {
+		xfree(data);
+		return;
+	}
+
+	slurm_mutex_lock(&buf_pool_lock);
+	if ((buf_pool_cnt[i] < BUF_POOL_DEPTH) &&
+	    ((buf_pool_bytes + size) <= BUF_POOL_MAX_BYTES)) {
+		buf_pool[i][buf_pool_cnt[i]++] = data;
+		buf_pool_bytes += size;
+		data = NULL;
+	}
+	slurm_mutex_unlock(&buf_pool_lock);
+
+	xfree(data);
+}
+
+/* free_pool_buf - release a buffer, keeping its memory for init_pool_buf() */
+void free_pool_buf(buf_t *my_buf)
+{
+	if (!my_buf)
+		return;
+	xassert(my_buf->magic == BUF_MAGIC);
+	if (my_buf->mmaped || my_buf->shadow) {
+		free_buf(my_buf);
+		return;
+	}
+
+	free_pool_data(xfer_buf_data(my_buf));
+}
+
 /*
  * Given a time_t in host byte order, promote it to int64_t, convert to
  * network byte order, store in buffer and adjust buffer acc'd'ngly
@@ -504,6 +652,135 @@ int unpack32(uint32_t *valp, buf_t *buffer)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Store a 64-bit integer 7 bits per byte, least significant bits first, with
+ * the high bit set in all but the last byte (LEB128).
+ */
+static void _packvar(uint64_t val, buf_t *buffer)
+{
+	uint8_t bytes[10];
+	int cnt = 0;
+
+	do {
+		bytes[cnt] = val & 0x7f;
+		val >>= 7;
+		if (val)
+			bytes[cnt] |= 0x80;
+		cnt++;
+	} while (val);
+
+	if (remaining_buf(buffer) < cnt) {
+		if ((buffer->size + BUF_SIZE) > MAX_BUF_SIZE) {
+			error("%s: Buffer size limit exceeded (%u > %u)",
+			      __func__, (buffer->size + BUF_SIZE),
+			      MAX_BUF_SIZE);
+			return;
+		}
+		buffer->size += BUF_SIZE;
+		xrealloc_nz(buffer->head, buffer->size);
+	}
+
+	memcpy(&buffer->head[buffer->processed], bytes, cnt);
+	buffer->processed += cnt;
+}
+
+static int _unpackvar(uint64_t *valp, buf_t *buffer)
+{
+	uint64_t val = 0;
+	uint8_t byte;
+	int shift = 0;
+
+	do {
+		if (!remaining_buf(buffer) || (shift > 63))
+			return SLURM_ERROR;
+		byte = buffer->head[buffer->processed++];
+		val |= ((uint64_t) (byte & 0x7f)) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	*valp = val;
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Variable length encoding of a 64-bit integer. NO_VAL64 and INFINITE64 are
+ * stored as 0 and 1 and anything else as its value plus 2, so sentinels and
+ * small values take a single byte.
+ */
+void packvar64(uint64_t val, buf_t *buffer)
+{
+	if (val == NO_VAL64)
+		_packvar(0, buffer);
+	else if (val == INFINITE64)
+		_packvar(1, buffer);
+	else
+		_packvar(val + 2, buffer);
+}
+
+int unpackvar64(uint64_t *valp, buf_t *buffer)
+{
+	uint64_t val;
+
+	if (_unpackvar(&val, buffer))
+		return SLURM_ERROR;
+
+	if (val == 0)
+		*valp = NO_VAL64;
+	else if (val == 1)
+		*valp = INFINITE64;
+	else
+		*valp = val - 2;
+	return SLURM_SUCCESS;
+}
+
+/* Variable length encoding of a 32-bit integer, see packvar64() */
+void packvar32(uint32_t val, buf_t *buffer)
+{
+	if (val == NO_VAL)
+		_packvar(0, buffer);
+	else if (val == INFINITE)
+		_packvar(1, buffer);
+	else
+		_packvar((uint64_t) val + 2, buffer);
+}
+
+int unpackvar32(uint32_t *valp, buf_t *buffer)
+{
+	uint64_t val;
+
+	if (_unpackvar(&val, buffer))
+		return SLURM_ERROR;
+
+	if (val == 0)
+		*valp = NO_VAL;
+	else if (val == 1)
+		*valp = INFINITE;
+	else if ((val - 2) > UINT32_MAX)
+		return SLURM_ERROR;
+	else
+		*valp = val - 2;
+	return SLURM_SUCCESS;
+}
+
+/* Variable length encoding of a time_t, zigzag encoded to allow negatives */
+void packvar_time(time_t val, buf_t *buffer)
+{
+	int64_t n64 = (int64_t) val;
+
+	_packvar((((uint64_t) n64) << 1) ^ ((uint64_t) (n64 >> 63)), buffer);
+}
+
+int unpackvar_time(time_t *valp, buf_t *buffer)
+{
+	uint64_t val;
+
+	if (_unpackvar(&val, buffer))
+		return SLURM_ERROR;
+
+	*valp = (time_t) ((int64_t) (val >> 1) ^ -((int64_t) (val & 1)));
+	return SLURM_SUCCESS;
+}
+
 /*
  * Given a *uint16_t, it will pack an array of size_val
  */
@@ -812,6 +1089,44 @@ extern void packmem(void *valp, uint32_t size_val, buf_t *buffer)
 	}
 }
 
+/* As packmem(), with the size stored by packvar32() */
+extern void packvarmem(void *valp, uint32_t size_val, buf_t *buffer)
+{
+	if (size_val > MAX_PACK_MEM_LEN) {
+		error("%s: Buffer to be packed is too large (%u > %u)",
+		      __func__, size_val, MAX_PACK_MEM_LEN);
+		return;
+	}
+	packvar32(size_val, buffer);
+	if (size_val)
+		packmem_array(valp, size_val, buffer);
+}
+
+/*
+ * Given a buffer containing a size stored by packvar32() and an arbitrary
+ * data string, copy the data string into the location specified by valp.
+ * NOTE: the caller is responsible for calling xfree() on *valp if non-NULL
+ *	(set to NULL on zero size buffer value)
+ */
+int unpackvarmem_xmalloc(char **valp, uint32_t *size_valp, buf_t *buffer)
+{
+	*valp = NULL;
+	if (unpackvar32(size_valp, buffer))
+		return SLURM_ERROR;
+
+	if (*size_valp > MAX_ARRAY_LEN_LARGE) {
+		error("%s: Buffer to be unpacked is too large (%u > %u)",
+		      __func__, *size_valp, MAX_ARRAY_LEN_LARGE);
+		return SLURM_ERROR;
+	} else if (*size_valp > 0) {
+		if (remaining_buf(buffer) < *size_valp)
+			return SLURM_ERROR;
+		*valp = xmalloc_nz(*size_valp);
+		memcpy(*valp, &buffer->head[buffer->processed], *size_valp);
+		buffer->processed += *size_valp;
+	}
+	return SLURM_SUCCESS;
+}
 
 /*
  * Given a buffer containing a network byte order 16-bit integer,
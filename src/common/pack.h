@@ -66,6 +66,7 @@ typedef struct {
 	uint32_t size;
 	uint32_t processed;
 	bool mmaped;
+	bool shadow;	/* head borrowed from another buffer, never freed */
 } buf_t;
 
 #define get_buf_data(__buf)		(__buf->head)
@@ -76,11 +77,23 @@ typedef struct {
 
 extern buf_t *create_buf(char *data, uint32_t size);
 extern buf_t *create_mmap_buf(const char *file);
+extern buf_t *create_shadow_buf(char *data, uint32_t size);
 extern void free_buf(buf_t *my_buf);
 extern buf_t *init_buf(uint32_t size);
 extern void grow_buf(buf_t *my_buf, uint32_t size);
 extern void *xfer_buf_data(buf_t *my_buf);
 
+/*
+ * Buffers for hot paths which are allocated and released repeatedly.
+ * Memory released with free_pool_buf(), or buffer data from xfer_buf_data()
+ * released with free_pool_data(), is kept for reuse by init_pool_buf()
+ * rather than being returned to the allocator. Data from pool buffers may
+ * still be released with xfree().
+ */
+extern buf_t *init_pool_buf(uint32_t size);
+extern void free_pool_buf(buf_t *my_buf);
+extern void free_pool_data(void *data);
+
 extern void pack_time(time_t val, buf_t *buffer);
 extern int unpack_time(time_t *valp, buf_t *buffer);
 
@@ -99,6 +112,24 @@ extern int unpack64(uint64_t *valp, buf_t *buffer);
 extern void pack32(uint32_t val, buf_t *buffer);
 extern int unpack32(uint32_t *valp, buf_t *buffer);
 
+/*
+ * Variable length (LEB128) encodings, taking a single byte for NO_VAL,
+ * INFINITE and values below 126. Used by SLURM_21_08_PROTOCOL_VERSION and
+ * later for job and node records.
+ */
+extern void packvar64(uint64_t val, buf_t *buffer);
+extern int unpackvar64(uint64_t *valp, buf_t *buffer);
+
+extern void packvar32(uint32_t val, buf_t *buffer);
+extern int unpackvar32(uint32_t *valp, buf_t *buffer);
+
+extern void packvar_time(time_t val, buf_t *buffer);
+extern int unpackvar_time(time_t *valp, buf_t *buffer);
+
+extern void packvarmem(void *valp, uint32_t size_val, buf_t *buffer);
+extern int unpackvarmem_xmalloc(char **valp, uint32_t *size_valp,
+				buf_t *buffer);
+
 extern void pack16(uint16_t val, buf_t *buffer);
 extern int unpack16(uint16_t *valp, buf_t *buffer);
 
@@ -183,6 +214,27 @@ extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
 		goto unpack_error;			\
 } while (0)
 
+#define safe_unpackvar64(valp,buf) do {			\
+	xassert(sizeof(*valp) == sizeof(uint64_t));	\
+	xassert(buf->magic == BUF_MAGIC);		\
+	if (unpackvar64(valp,buf))			\
+		goto unpack_error;			\
+} while (0)
+
+#define safe_unpackvar32(valp,buf) do {			\
+	xassert(sizeof(*valp) == sizeof(uint32_t));	\
+	xassert(buf->magic == BUF_MAGIC);		\
+	if (unpackvar32(valp,buf))			\
+		goto unpack_error;			\
+} while (0)
+
+#define safe_unpackvar_time(valp,buf) do {		\
+	xassert(sizeof(*valp) == sizeof(time_t));	\
+	xassert(buf->magic == BUF_MAGIC);		\
+	if (unpackvar_time(valp,buf))			\
+		goto unpack_error;			\
+} while (0)
+
 #define safe_unpack16(valp,buf) do {			\
 	xassert(sizeof(*valp) == sizeof(uint16_t)); 	\
 	xassert(buf->magic == BUF_MAGIC);		\
@@ -270,6 +322,33 @@ extern int unpackmem_array(char *valp, uint32_t size_valp, buf_t *buffer);
 	packmem(str,(uint32_t)_size,buf);		\
 } while (0)
 
+#define packvarstr(str,buf) do {			\
+	uint32_t _size = 0;				\
+	if ((char *)str != NULL)			\
+		_size = (uint32_t)strlen(str)+1;	\
+	xassert(buf->magic == BUF_MAGIC);		\
+	packvarmem(str,(uint32_t)_size,buf);		\
+} while (0)
+
+#define safe_unpackvarstr_xmalloc(valp, size_valp, buf) do {	\
+	xassert(sizeof(*size_valp) == sizeof(uint32_t));	\
+	xassert(buf->magic == BUF_MAGIC);			\
+	if (unpackvarmem_xmalloc(valp, size_valp, buf))		\
+		goto unpack_error;				\
+} while (0)
+
+#define packvarnull(buf) do {				\
+	xassert(buf->magic == BUF_MAGIC);		\
+	packvarmem(NULL, 0, buf);			\
+} while (0)
+
+#define safe_unpackvarstr(valp, buf) do {			\
+	uint32_t size_valp;					\
+	xassert(buf->magic == BUF_MAGIC);			\
+	if (unpackvarmem_xmalloc(valp, &size_valp, buf))	\
+		goto unpack_error;				\
+} while (0)
+
 #define packnull(buf) do { \
 	xassert(buf != NULL); \
 	xassert(buf->magic == BUF_MAGIC); \
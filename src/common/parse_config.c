@@ -40,7 +40,6 @@
 \*****************************************************************************/
 
 #include <ctype.h>
-#include <regex.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -86,14 +85,6 @@ strong_alias(transfer_s_p_options,	slurm_transfer_s_p_options);
 
 #define CONF_HASH_LEN 173
 
-static char *keyvalue_pattern =
-	"^[[:space:]]*"
-	"([[:alnum:]_.]+)" /* key */
-	"[[:space:]]*([-*+/]?)=[[:space:]]*"
-	"((\"([^\"]*)\")|([^[:space:]]+))" /* value: quoted with whitespace,
-					    * or unquoted and no whitespace */
-	"([[:space:]]|$)";
-
 struct s_p_values {
 	char *key;
 	int type;
@@ -108,7 +99,6 @@ struct s_p_values {
 };
 
 struct s_p_hashtbl {
-	regex_t keyvalue_re;
 	s_p_values_t *hash[CONF_HASH_LEN];
 };
 
@@ -196,9 +186,6 @@ s_p_hashtbl_t *s_p_hashtbl_create(const s_p_options_t options[])
 		_conf_hashtbl_insert(tbl, value);
 	}
 
-	if (regcomp(&tbl->keyvalue_re, keyvalue_pattern, REG_EXTENDED))
-		fatal("keyvalue regex compilation failed");
-
 	return tbl;
 }
 
@@ -277,13 +264,17 @@ void s_p_hashtbl_destroy(s_p_hashtbl_t *tbl)
 		}
 	}
 
-	regfree(&tbl->keyvalue_re);
-
 	xfree(tbl);
 }
 
 /*
- * IN tbl - table to work off
+ * Find the next key=value pair at the start of line, skipping leading
+ * whitespace. The key is made of alphanumerics, '_' and '.', and may be
+ * followed by an operator ('+', '-', '*' or '/') right before the '='. The
+ * value is either double quoted (and may contain whitespace) or runs up to
+ * the next whitespace. A quoted value must be followed by whitespace or the
+ * end of the line, otherwise the quotes are part of an unquoted value.
+ *
  * IN line - string to be search for a key=value pair
  * OUT key - pointer to the key string (caller must free with xfree())
  * OUT value - pointer to the value string (caller must free with xfree())
@@ -291,49 +282,65 @@ void s_p_hashtbl_destroy(s_p_hashtbl_t *tbl)
  *                 of the unsearched portion of the string
  * Return 0 when a key-value pair is found, and -1 otherwise.
  */
-static int _keyvalue_regex(s_p_hashtbl_t *tbl, const char *line,
-			   char **key, char **value, char **remaining,
-			   slurm_parser_operator_t *operator)
+static int _keyvalue_tokenize(const char *line, char **key, char **value,
+			      char **remaining,
+			      slurm_parser_operator_t *operator)
 {
-	size_t nmatch = 8;
-	regmatch_t pmatch[8];
-	char op;
+	const char *ptr = line, *key_start, *key_end, *val_start, *quote;
 
 	*key = NULL;
 	*value = NULL;
 	*remaining = (char *)line;
 	*operator = S_P_OPERATOR_SET;
-	memset(pmatch, 0, sizeof(regmatch_t)*nmatch);
 
-	if (regexec(&tbl->keyvalue_re, line, nmatch, pmatch, 0) == REG_NOMATCH)
+	while (isspace((unsigned char) *ptr))
+		ptr++;
+	key_start = ptr;
+	while (isalnum((unsigned char) *ptr) || (*ptr == '_') || (*ptr == '.'))
+		ptr++;
+	if (ptr == key_start)
+		return -1;
+	key_end = ptr;
+
+	while (isspace((unsigned char) *ptr))
+		ptr++;
+	if (*ptr == '+') {
+		*operator = S_P_OPERATOR_ADD;
+		ptr++;
+	} else if (*ptr == '-') {
+		*operator = S_P_OPERATOR_SUB;
+		ptr++;
+	} else if (*ptr == '*') {
+		*operator = S_P_OPERATOR_MUL;
+		ptr++;
+	} else if (*ptr == '/') {
+		*operator = S_P_OPERATOR_DIV;
+		ptr++;
+	}
+	if (*ptr != '=') {
+		*operator = S_P_OPERATOR_SET;
 		return -1;
-
-	*key = (char *)(xstrndup(line + pmatch[1].rm_so,
-				 pmatch[1].rm_eo - pmatch[1].rm_so));
-	if (pmatch[2].rm_so != -1 &&
-	    (pmatch[2].rm_so != pmatch[2].rm_eo)) {
-		op = *(line + pmatch[2].rm_so);
-		if (op == '+') {
-			*operator = S_P_OPERATOR_ADD;
-		} else if (op == '-') {
-			*operator = S_P_OPERATOR_SUB;
-		} else if (op == '*') {
-			*operator = S_P_OPERATOR_MUL;
-		} else if (op == '/') {
-			*operator = S_P_OPERATOR_DIV;
-		}
 	}
-	if (pmatch[5].rm_so != -1) {
-		*value = (char *)(xstrndup(line + pmatch[5].rm_so,
-					   pmatch[5].rm_eo - pmatch[5].rm_so));
-	} else if (pmatch[6].rm_so != -1) {
-		*value = (char *)(xstrndup(line + pmatch[6].rm_so,
-					   pmatch[6].rm_eo - pmatch[6].rm_so));
+	ptr++;
+	while (isspace((unsigned char) *ptr))
+		ptr++;
+
+	if ((*ptr == '"') && (quote = strchr(ptr + 1, '"')) &&
+	    (!quote[1] || isspace((unsigned char) quote[1]))) {
+		*value = xstrndup(ptr + 1, quote - ptr - 1);
+		ptr = quote + 1;
 	} else {
-		*value = xstrdup("");
+		val_start = ptr;
+		while (*ptr && !isspace((unsigned char) *ptr))
+			ptr++;
+		if (ptr == val_start) {
+			*operator = S_P_OPERATOR_SET;
+			return -1;
+		}
+		*value = xstrndup(val_start, ptr - val_start);
 	}
-
-	*remaining = (char *)(line + pmatch[3].rm_eo);
+	*key = xstrndup(key_start, key_end - key_start);
+	*remaining = (char *)ptr;
 
 	return 0;
 }
@@ -503,13 +510,6 @@ s_p_hashtbl_t *_hashtbl_copy_keys(const s_p_hashtbl_t *from_tbl)
 		}
 	}
 
-	/*
-	 * We cannot copy a regex since a regfree() on either
-	 * the original or the copy can affect the other one.
-	 */
-	if (regcomp(&to_tbl->keyvalue_re, keyvalue_pattern, REG_EXTENDED))
-		fatal("keyvalue regex compilation failed");
-
 	return to_tbl;
 }
 
@@ -978,7 +978,7 @@ int s_p_parse_line(s_p_hashtbl_t *hashtbl, const char *line, char **leftover)
 	char *new_leftover;
 	slurm_parser_operator_t op;
 
-	while (_keyvalue_regex(hashtbl, ptr, &key, &value, &new_leftover, &op) == 0) {
+	while (_keyvalue_tokenize(ptr, &key, &value, &new_leftover, &op) == 0) {
 		if ((p = _conf_hashtbl_lookup(hashtbl, key))) {
 			p->operator = op;
 			if (_handle_keyvalue_match(p, value, new_leftover,
@@ -1015,7 +1015,7 @@ static int _parse_next_key(s_p_hashtbl_t *hashtbl,
 	char *new_leftover;
 	slurm_parser_operator_t op;
 
-	if (_keyvalue_regex(hashtbl, line, &key, &value, &new_leftover, &op) == 0) {
+	if (_keyvalue_tokenize(line, &key, &value, &new_leftover, &op) == 0) {
 		if ((p = _conf_hashtbl_lookup(hashtbl, key))) {
 			p->operator = op;
 			if (_handle_keyvalue_match(p, value, new_leftover,
@@ -1504,13 +1504,6 @@ static s_p_hashtbl_t *_parse_expline_adapt_table(const s_p_hashtbl_t *tbl)
 		}
 	}
 
-	/*
-	 * We cannot copy a regex since a regfree() on either
-	 * the original or the copy can affect the other one.
-	 */
-	if (regcomp(&to_tbl->keyvalue_re, keyvalue_pattern, REG_EXTENDED))
-		fatal("keyvalue regex compilation failed");
-
 	return to_tbl;
 }
 
@@ -0,0 +1,89 @@
+/*****************************************************************************\
+ *  probes.h - static (USDT) tracepoints
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Static tracepoints for profiling a running daemon with bpftrace, perf or
+ * SystemTap, e.g. "bpftrace -l 'usdt:/usr/sbin/slurmctld:slurm:*'". When
+ * <sys/sdt.h> is available each probe compiles to a single nop plus an
+ * ELF note, so disabled probes cost almost nothing; otherwise they compile
+ * to nothing. Probe arguments are evaluated either way, so only pass values
+ * already at hand.
+ *
+ * Probes (provider "slurm", "__" in a name shows as "-" in tracers):
+ *   rpc__accept(fd)                         slurmctld accepted a connection
+ *   rpc__start(msg_type, uid)               RPC dispatched to its handler
+ *   rpc__done(msg_type, usec)               RPC handler returned
+ *   lock__acquire(levels, caller)           lock_slurmctld() called
+ *   lock__acquired(levels, caller, usec)    all requested locks granted
+ *   lock__release(levels, usec)             unlock_slurmctld(), held usec
+ *   sched__job_start(job_id)                _schedule() tests a job
+ *   sched__job_done(job_id, rc)             ... with select_nodes() rc
+ *   backfill__job_start(job_id)             backfill tests a job
+ *   backfill__job_done(job_id, rc)          ... with the test rc
+ *   select__job_test(job_id, mode)          select_g_job_test() entry
+ *   select__job_test_done(job_id, rc)       select_g_job_test() exit
+ *   agent__send(msg_type, nodelist)         agent thread sends an RPC
+ *   agent__done(msg_type, nodelist, state)  ... with the thread state
+ *   agent__retry(msg_type, count)           RPC queued for retry to count
+ *                                           nodes
+ *   state_save__start(type)                 state save of type ("job",
+ *                                           "node", ...) starts
+ *   state_save__done(type, rc)              state save completed
+ *
+ * Lock levels are passed as one integer with a hex digit per lock, from
+ * high to low conf, job, node, part and fed, each a lock_level_t.
+ */
+
+#ifndef _SLURM_PROBES_H
+#define _SLURM_PROBES_H
+
+#include "config.h"
+
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define SLURM_PROBE(name) DTRACE_PROBE(slurm, name)
+#define SLURM_PROBE1(name, a1) DTRACE_PROBE1(slurm, name, a1)
+#define SLURM_PROBE2(name, a1, a2) DTRACE_PROBE2(slurm, name, a1, a2)
+#define SLURM_PROBE3(name, a1, a2, a3) DTRACE_PROBE3(slurm, name, a1, a2, a3)
+#else
+#define SLURM_PROBE(name) do { } while (0)
+#define SLURM_PROBE1(name, a1) do { (void) (a1); } while (0)
+#define SLURM_PROBE2(name, a1, a2) do { (void) (a1); (void) (a2); } while (0)
+#define SLURM_PROBE3(name, a1, a2, a3)					\
+	do { (void) (a1); (void) (a2); (void) (a3); } while (0)
+#endif
+
+#endif
@@ -2583,6 +2583,20 @@ extern void slurm_reset_alias(char *node_name, char *node_addr,
 	return;
 }
 
+/* Return the NodeName's record. Call with slurm_conf_lock() held */
+static names_ll_t *_find_node_alias(const char *node_name)
+{
+	names_ll_t *p;
+
+	_init_slurmd_nodehash();
+
+	p = node_to_host_hashtbl[_get_hash_idx(node_name)];
+	while (p && xstrcmp(p->alias, node_name))
+		p = p->next_alias;
+
+	return p;
+}
+
 /*
  * slurm_conf_get_addr - Return the slurm_addr_t for a given NodeName
  * Returns SLURM_SUCCESS on success, SLURM_ERROR on failure.
@@ -2590,18 +2604,14 @@ extern void slurm_reset_alias(char *node_name, char *node_addr,
 extern int slurm_conf_get_addr(const char *node_name, slurm_addr_t *address,
 			       uint16_t flags)
 {
-	int idx;
 	names_ll_t *p;
+	slurm_addr_t addr;
+	char *host;
+	uint16_t port;
+	bool bcast;
 
 	slurm_conf_lock();
-	_init_slurmd_nodehash();
-
-	idx = _get_hash_idx(node_name);
-	p = node_to_host_hashtbl[idx];
-	while (p && xstrcmp(p->alias, node_name))
-		p = p->next_alias;
-
-	if (!p) {
+	if (!(p = _find_node_alias(node_name))) {
 		slurm_conf_unlock();
 		return SLURM_ERROR;
 	}
@@ -2613,34 +2623,49 @@ extern int slurm_conf_get_addr(const char *node_name, slurm_addr_t *address,
 	 * Only use BcastAddr if USE_BCAST_NETWORK flag set and BcastAddr
 	 * exists. Otherwise fall through to using NodeAddr value below.
 	 */
-	if (p->bcast_address && (flags & USE_BCAST_NETWORK)) {
-		if (!p->bcast_addr_initialized) {
-			slurm_set_addr(&p->bcast_addr, p->port,
-				       p->bcast_address);
-			if (slurm_addr_is_unspec(&p->bcast_addr)) {
-				slurm_conf_unlock();
-				return SLURM_ERROR;
-			}
-		}
-		if (!no_addr_cache)
-			p->bcast_addr_initialized = true;
+	bcast = (p->bcast_address && (flags & USE_BCAST_NETWORK));
+	if (bcast && p->bcast_addr_initialized) {
 		*address = p->bcast_addr;
 		slurm_conf_unlock();
 		return SLURM_SUCCESS;
+	} else if (!bcast && p->addr_initialized) {
+		*address = p->addr;
+		slurm_conf_unlock();
+		return SLURM_SUCCESS;
 	}
 
-	if (!p->addr_initialized) {
-		slurm_set_addr(&p->addr, p->port, p->address);
-		if (slurm_addr_is_unspec(&p->addr)) {
-			slurm_conf_unlock();
-			return SLURM_ERROR;
-		}
-		if (!no_addr_cache)
-			p->addr_initialized = true;
+	host = xstrdup(bcast ? p->bcast_address : p->address);
+	port = p->port;
+	slurm_conf_unlock();
+
+	/*
+	 * Resolving the name may block on DNS for a long time, so never do
+	 * it with the configuration lock held. The node table may have been
+	 * rebuilt or the address changed meanwhile, so look the record up
+	 * again before caching the result.
+	 */
+	slurm_set_addr(&addr, port, host);
+	if (slurm_addr_is_unspec(&addr)) {
+		xfree(host);
+		return SLURM_ERROR;
 	}
 
-	*address = p->addr;
+	slurm_conf_lock();
+	if ((p = _find_node_alias(node_name)) && (p->port == port)) {
+		if (bcast && !xstrcmp(p->bcast_address, host)) {
+			p->bcast_addr = addr;
+			if (!no_addr_cache)
+				p->bcast_addr_initialized = true;
+		} else if (!bcast && !xstrcmp(p->address, host)) {
+			p->addr = addr;
+			if (!no_addr_cache)
+				p->addr_initialized = true;
+		}
+	}
 	slurm_conf_unlock();
+
+	xfree(host);
+	*address = addr;
 	return SLURM_SUCCESS;
 }
 
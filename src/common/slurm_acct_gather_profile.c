@@ -120,6 +120,7 @@ static pthread_t timer_thread_id = 0;
 static pthread_mutex_t timer_thread_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t timer_thread_cond = PTHREAD_COND_INITIALIZER;
 static bool init_run = false;
+static bool align_samples = false;
 
 static void _set_freq(int type, char *freq, char *freq_def)
 {
@@ -130,9 +131,32 @@ static void _set_freq(int type, char *freq, char *freq_def)
 			acct_gather_profile_timer[type].freq = 0;
 }
 
+/*
+ * With JobAcctGatherParams=AlignSamples, return the wall clock time of the
+ * next sample of any type, so that every node samples at multiples of the
+ * frequency and types with the same frequency sample together.
+ */
+static time_t _next_aligned_sample(time_t now)
+{
+	time_t next = 0, slot;
+	int i;
+
+	for (i = 0; i < PROFILE_CNT; i++) {
+		if (!acct_gather_profile_timer[i].freq)
+			continue;
+		slot = ((now / acct_gather_profile_timer[i].freq) + 1) *
+			acct_gather_profile_timer[i].freq;
+		if (!next || (slot < next))
+			next = slot;
+	}
+
+	return next ? next : (now + SLEEP_TIME);
+}
+
 /*
  * This thread wakes up other profiling threads in the jobacct plugins,
- * and operates on a 1-second granularity.
+ * and operates on a 1-second granularity. With AlignSamples it only wakes
+ * when a sample is due.
  */
 
 static void *_timer_thread(void *args)
@@ -176,8 +200,16 @@ static void *_timer_thread(void *args)
 			/* info ("%d is %d and %d", i, */
 			/*       acct_gather_profile_timer[i].freq, */
 			/*       diff); */
-			if (!acct_gather_profile_timer[i].freq
-			    || (diff < acct_gather_profile_timer[i].freq))
+			if (!acct_gather_profile_timer[i].freq)
+				continue;
+			if (align_samples) {
+				/* Sample once per aligned interval */
+				if (acct_gather_profile_timer[i].last_notify &&
+				    ((acct_gather_profile_timer[i].last_notify /
+				      acct_gather_profile_timer[i].freq) ==
+				     (now / acct_gather_profile_timer[i].freq)))
+					continue;
+			} else if (diff < acct_gather_profile_timer[i].freq)
 				continue;
 			if (!acct_gather_profile_test())
 				break;	/* Shutting down */
@@ -200,7 +232,11 @@ static void *_timer_thread(void *args)
 		 * to shutdown by acct_gather_profile_fini().
 		 */
 
-		abs.tv_sec += 1;
+		if (align_samples && !acct_gather_suspend_test()) {
+			abs.tv_sec = _next_aligned_sample(time(NULL));
+			abs.tv_nsec = 0;
+		} else
+			abs.tv_sec += 1;
 		slurm_mutex_lock(&timer_thread_mutex);
 		slurm_cond_timedwait(&timer_thread_cond, &timer_thread_mutex,
 				     &abs);
@@ -468,6 +504,9 @@ extern int acct_gather_profile_startpoll(char *freq, char *freq_def)
 	(*(ops.get))(ACCT_GATHER_PROFILE_RUNNING, &profile);
 	xassert(profile != ACCT_GATHER_PROFILE_NOT_SET);
 
+	align_samples = xstrcasestr(slurm_conf.job_acct_gather_params,
+				    "AlignSamples");
+
 	for (i=0; i < PROFILE_CNT; i++) {
 		memset(&acct_gather_profile_timer[i], 0,
 		       sizeof(acct_gather_profile_timer_t));
@@ -153,6 +153,12 @@ struct slurm_cred_context {
 
 	void *exkey;		/* Old public key if key is updated	*/
 	time_t exkey_exp;	/* Old key expiration time		*/
+
+	pthread_rwlock_t key_lock; /* Protects key and exkey. Held for
+				    * reading while a signature is checked
+				    * so verifications can run in parallel;
+				    * held for writing (along with mutex)
+				    * while the keys are changed	*/
 };
 
 
@@ -376,30 +382,19 @@ static int _slurm_cred_fini(void)
 
 static int _fill_cred_gids(slurm_cred_t *cred, slurm_cred_arg_t *arg)
 {
-	struct passwd pwd, *result;
-	char buffer[PW_BUF_SIZE];
-	int rc;
-
 	if (!enable_nss_slurm && !enable_send_gids)
 		return SLURM_SUCCESS;
 
 	xassert(cred);
 	xassert(arg);
 
-	rc = slurm_getpwuid_r(arg->uid, &pwd, buffer, PW_BUF_SIZE, &result);
-	if (rc || !result) {
-		error("%s: getpwuid failed for uid=%u: %s",
-		      __func__, arg->uid, slurm_strerror(rc));
+	/* Called for every credential, so avoid a name service round trip */
+	if (user_cache_lookup(arg->uid, &cred->pw_name, &cred->pw_gecos,
+			      &cred->pw_dir, &cred->pw_shell))
 		return SLURM_ERROR;
-	}
-
-	cred->pw_name = xstrdup(result->pw_name);
-	cred->pw_gecos = xstrdup(result->pw_gecos);
-	cred->pw_dir = xstrdup(result->pw_dir);
-	cred->pw_shell = xstrdup(result->pw_shell);
 
 	cred->ngids = group_cache_lookup(arg->uid, arg->gid,
-					 arg->pw_name, &cred->gids);
+					 cred->pw_name, &cred->gids);
 
 	return SLURM_SUCCESS;
 }
@@ -480,6 +475,7 @@ slurm_cred_ctx_destroy(slurm_cred_ctx_t ctx)
 		return;
 
 	slurm_mutex_lock(&ctx->mutex);
+	slurm_rwlock_wrlock(&ctx->key_lock);
 	xassert(ctx->magic == CRED_CTX_MAGIC);
 
 	if (ctx->exkey)
@@ -490,7 +486,9 @@ slurm_cred_ctx_destroy(slurm_cred_ctx_t ctx)
 	FREE_NULL_LIST(ctx->state_list);
 
 	ctx->magic = ~CRED_CTX_MAGIC;
+	slurm_rwlock_unlock(&ctx->key_lock);
 	slurm_mutex_unlock(&ctx->mutex);
+	slurm_rwlock_destroy(&ctx->key_lock);
 	slurm_mutex_destroy(&ctx->mutex);
 
 	xfree(ctx);
@@ -1030,19 +1028,27 @@ slurm_cred_verify(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&cred->mutex);
-	slurm_mutex_lock(&ctx->mutex);
 
 	xassert(ctx->magic  == CRED_CTX_MAGIC);
 	xassert(ctx->type   == SLURM_CRED_VERIFIER);
 	xassert(cred->magic == CRED_MAGIC);
 
-	/* NOTE: the verification checks that the credential was
+	/*
+	 * The signature check is the expensive part (a round trip to munged)
+	 * and only needs the keys, so do it before taking ctx->mutex. This
+	 * lets concurrent launch requests verify their credentials in
+	 * parallel instead of queueing behind each other.
+	 *
+	 * NOTE: the verification checks that the credential was
 	 * created by SlurmUser or root */
 	if (_slurm_cred_verify_signature(ctx, cred, protocol_version) < 0) {
+		slurm_mutex_unlock(&cred->mutex);
 		slurm_seterrno(ESLURMD_INVALID_JOB_CREDENTIAL);
-		goto error;
+		return SLURM_ERROR;
 	}
 
+	slurm_mutex_lock(&ctx->mutex);
+
 	if (now > (cred->ctime + ctx->expiry_window)) {
 		slurm_seterrno(ESLURMD_CREDENTIAL_EXPIRED);
 		goto error;
@@ -1831,8 +1837,10 @@ _ctx_update_private_key(slurm_cred_ctx_t ctx, const char *path)
 	xassert(ctx->magic == CRED_CTX_MAGIC);
 	xassert(ctx->type  == SLURM_CRED_CREATOR);
 
+	slurm_rwlock_wrlock(&ctx->key_lock);
 	tmpk = ctx->key;
 	ctx->key = pk;
+	slurm_rwlock_unlock(&ctx->key_lock);
 
 	slurm_mutex_unlock(&ctx->mutex);
 
@@ -1857,6 +1865,7 @@ _ctx_update_public_key(slurm_cred_ctx_t ctx, const char *path)
 	xassert(ctx->magic == CRED_CTX_MAGIC);
 	xassert(ctx->type  == SLURM_CRED_VERIFIER);
 
+	slurm_rwlock_wrlock(&ctx->key_lock);
 	if (ctx->exkey)
 		(*(ops.cred_destroy_key))(ctx->exkey);
 
@@ -1868,12 +1877,18 @@ _ctx_update_public_key(slurm_cred_ctx_t ctx, const char *path)
 	 * This should be long enough to capture any keys in-flight.
 	 */
 	ctx->exkey_exp = time(NULL) + ctx->expiry_window + 60;
+	slurm_rwlock_unlock(&ctx->key_lock);
 
 	slurm_mutex_unlock(&ctx->mutex);
 	return SLURM_SUCCESS;
 }
 
 
+/*
+ * Caller must hold ctx->key_lock. An expired exkey is not destroyed here,
+ * since other threads may hold the lock for reading; it is released on
+ * the next key update or when the context is destroyed.
+ */
 static bool
 _exkey_is_valid(slurm_cred_ctx_t ctx)
 {
@@ -1882,8 +1897,6 @@ _exkey_is_valid(slurm_cred_ctx_t ctx)
 
 	if (time(NULL) > ctx->exkey_exp) {
 		debug2("old job credential key slurmd expired");
-		(*(ops.cred_destroy_key))(ctx->exkey);
-		ctx->exkey = NULL;
 		return false;
 	}
 
@@ -1898,6 +1911,7 @@ _slurm_cred_ctx_alloc(void)
 	/* Contents initialized to zero */
 
 	slurm_mutex_init(&ctx->mutex);
+	slurm_rwlock_init(&ctx->key_lock);
 
 	ctx->magic = CRED_CTX_MAGIC;
 	ctx->expiry_window = cred_expire;
@@ -1954,6 +1968,7 @@ _slurm_cred_verify_signature(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
 	debug("Checking credential with %u bytes of sig data", cred->siglen);
 	_pack_cred(cred, buffer, protocol_version);
 
+	slurm_rwlock_rdlock(&ctx->key_lock);
 	rc = (*(ops.cred_verify_sign))(ctx->key,
 				       get_buf_data(buffer),
 				       get_buf_offset(buffer),
@@ -1966,6 +1981,7 @@ _slurm_cred_verify_signature(slurm_cred_ctx_t ctx, slurm_cred_t *cred,
 					       cred->signature,
 					       cred->siglen);
 	}
+	slurm_rwlock_unlock(&ctx->key_lock);
 	free_buf(buffer);
 
 	if (rc) {
@@ -2655,9 +2671,11 @@ sbcast_cred_arg_t *extract_sbcast_cred(slurm_cred_ctx_t ctx,
 		_pack_sbcast_cred(sbcast_cred, buffer, protocol_version);
 		/* NOTE: the verification checks that the credential was
 		 * created by SlurmUser or root */
+		slurm_rwlock_rdlock(&ctx->key_lock);
 		rc = (*(ops.cred_verify_sign)) (
 			ctx->key, get_buf_data(buffer), get_buf_offset(buffer),
 			sbcast_cred->signature, sbcast_cred->siglen);
+		slurm_rwlock_unlock(&ctx->key_lock);
 		free_buf(buffer);
 
 		if (rc) {
@@ -2696,10 +2714,12 @@ sbcast_cred_arg_t *extract_sbcast_cred(slurm_cred_ctx_t ctx,
 			buffer = init_buf(4096);
 			_pack_sbcast_cred(sbcast_cred, buffer,
 					  protocol_version);
+			slurm_rwlock_rdlock(&ctx->key_lock);
 			rc = (*(ops.cred_verify_sign)) (
 				ctx->key, get_buf_data(buffer),
 				get_buf_offset(buffer),
 				sbcast_cred->signature, sbcast_cred->siglen);
+			slurm_rwlock_unlock(&ctx->key_lock);
 			free_buf(buffer);
 			if (rc)
 				err_str = (char *)(*(ops.cred_str_error))(rc);
@@ -446,6 +446,8 @@ static slurm_errtab_t slurm_errtab[] = {
 	  "Unix socket name exceeded maximum length"		},
 	{ ESLURMD_CONTAINER_RUNTIME_INVALID,
 	  "Container runtime not configured or invalid"		},
+	{ ESLURMD_SBCAST_CACHE_MISS,
+	  "File to broadcast not found in node cache"		},
 
 	/* slurmd errors in user batch job */
 	{ ESCRIPT_CHDIR_FAILED,
@@ -3996,6 +3996,18 @@ static slurm_cli_opt_t slurm_opt_spread_job = {
 	.reset_each_pass = true,
 };
 
+COMMON_SBATCH_STRING_OPTION(submit_list);
+static slurm_cli_opt_t slurm_opt_submit_list = {
+	.name = "submit-list",
+	.has_arg = required_argument,
+	.val = LONG_OPT_SUBMIT_LIST,
+	.sbatch_early_pass = true,
+	.set_func_sbatch = arg_set_submit_list,
+	.set_func_data = arg_set_data_submit_list,
+	.get_func = arg_get_submit_list,
+	.reset_func = arg_reset_submit_list,
+};
+
 static int arg_set_switch_req(slurm_opt_t *opt, const char *arg)
 {
 	opt->req_switch = parse_int("--switches", arg, true);
@@ -5045,6 +5057,7 @@ static const slurm_cli_opt_t *common_options[] = {
 	&slurm_opt_slurmd_debug,
 	&slurm_opt_sockets_per_node,
 	&slurm_opt_spread_job,
+	&slurm_opt_submit_list,
 	&slurm_opt_switch_req,
 	&slurm_opt_switch_wait,
 	&slurm_opt_switches,
@@ -163,6 +163,7 @@ enum {
 	LONG_OPT_SLURMD_DEBUG,
 	LONG_OPT_SOCKETSPERNODE,
 	LONG_OPT_SPREAD_JOB,
+	LONG_OPT_SUBMIT_LIST,
 	LONG_OPT_SWITCH_REQ,
 	LONG_OPT_SWITCH_WAIT,
 	LONG_OPT_SWITCHES,
@@ -214,6 +215,7 @@ typedef struct {
 	bool parsable;			/* --parsable			*/
 	char *propagate;		/* --propagate[=RLIMIT_CORE,...]*/
 	int requeue;			/* --requeue and --no-requeue	*/
+	char *submit_list;		/* --submit-list=file		*/
 	bool test_only;			/* --test-only			*/
 	int umask;			/* job umask for PBS		*/
 	bool wait;			/* --wait			*/
@@ -56,6 +56,10 @@
 #include <time.h>
 #include <unistd.h>
 
+#if HAVE_LZ4
+#  include <lz4.h>
+#endif
+
 /* PROJECT INCLUDES */
 #include "src/common/assoc_mgr.h"
 #include "src/common/fd.h"
@@ -890,6 +894,85 @@ fini:	_slurm_api_free_comm_config(proto_conf);
 	return rc;
 }
 
+/*
+ * Request bodies which may be unpacked into msg->arena. The receiver must
+ * not keep any memory from these bodies past freeing the message, so only
+ * read only requests belong here.
+ */
+static bool _arena_msg_type(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_ASSOC_MGR_INFO:
+	case REQUEST_JOB_INFO:
+	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_JOB_STEP_INFO:
+	case REQUEST_JOB_USER_INFO:
+	case REQUEST_LICENSE_INFO:
+	case REQUEST_NODE_INFO:
+	case REQUEST_NODE_INFO_SINGLE:
+	case REQUEST_PARTITION_INFO:
+	case REQUEST_RESERVATION_INFO:
+	case REQUEST_STATS_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Smallest reply body worth compressing. Below this the time spent in lz4
+ * is not won back on the wire.
+ */
+#define COMPRESS_MIN_BODY_SIZE	(64 * 1024)
+/* Largest body we agree to uncompress, same as slurm_msg_recvfrom_timeout */
+#define COMPRESS_MAX_BODY_SIZE	(1024 * 1024 * 1024)
+
+extern int slurm_uncompress_msg_body(header_t *header, buf_t *buffer)
+{
+#if HAVE_LZ4
+	uint32_t offset = get_buf_offset(buffer), orig_len;
+	char *head;
+	int len;
+
+	if ((header->body_length < sizeof(orig_len)) ||
+	    (header->body_length > remaining_buf(buffer)))
+		return SLURM_ERROR;
+
+	memcpy(&orig_len, get_buf_data(buffer) + offset, sizeof(orig_len));
+	orig_len = ntohl(orig_len);
+	if (orig_len > COMPRESS_MAX_BODY_SIZE) {
+		error("%s: %s compressed body too large (%u bytes)",
+		      __func__, rpc_num2string(header->msg_type), orig_len);
+		return SLURM_ERROR;
+	}
+
+	head = xmalloc_nz(offset + orig_len);
+	memcpy(head, get_buf_data(buffer), offset);
+	len = LZ4_decompress_safe(get_buf_data(buffer) + offset +
+				  sizeof(orig_len), head + offset,
+				  header->body_length - sizeof(orig_len),
+				  orig_len);
+	if ((len < 0) || (len != orig_len)) {
+		error("%s: %s body failed to uncompress",
+		      __func__, rpc_num2string(header->msg_type));
+		xfree(head);
+		return SLURM_ERROR;
+	}
+
+	xfree(buffer->head);
+	buffer->head = head;
+	buffer->size = offset + orig_len;
+	header->body_length = orig_len;
+	header->flags &= ~SLURM_BODY_COMPRESSED;
+
+	return SLURM_SUCCESS;
+#else
+	error("%s: %s body is compressed, but lz4 support is not built in",
+	      __func__, rpc_num2string(header->msg_type));
+	return SLURM_ERROR;
+#endif
+}
+
 extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer)
 {
 	header_t header;
@@ -960,14 +1043,31 @@ extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer)
 	/*
 	 * Unpack message body
 	 */
+	if ((header.flags & SLURM_BODY_COMPRESSED) &&
+	    slurm_uncompress_msg_body(&header, buffer)) {
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		(void) auth_g_destroy(auth_cred);
+		goto total_return;
+	}
+
 	msg->protocol_version = header.version;
 	msg->msg_type = header.msg_type;
 	msg->flags = header.flags;
 
 	msg->body_offset =  get_buf_offset(buffer);
 
-	if ((header.body_length > remaining_buf(buffer)) ||
-	    (unpack_msg(msg, buffer) != SLURM_SUCCESS)) {
+	if (header.body_length > remaining_buf(buffer)) {
+		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
+		(void) auth_g_destroy(auth_cred);
+		goto total_return;
+	}
+	if (msg->arena && _arena_msg_type(msg->msg_type)) {
+		xarena_set(msg->arena);
+		rc = unpack_msg(msg, buffer);
+		xarena_set(NULL);
+	} else
+		rc = unpack_msg(msg, buffer);
+	if (rc != SLURM_SUCCESS) {
 		rc = ESLURM_PROTOCOL_INCOMPLETE_PACKET;
 		(void) auth_g_destroy(auth_cred);
 		goto total_return;
@@ -1246,9 +1346,11 @@ List slurm_receive_msgs(int fd, int steps, int timeout)
 	 */
 	msg.protocol_version = header.version;
 	msg.msg_type = header.msg_type;
-	msg.flags = header.flags;
+	msg.flags = header.flags & ~SLURM_BODY_COMPRESSED;
 
-	if ((header.body_length > remaining_buf(buffer)) ||
+	if (((header.flags & SLURM_BODY_COMPRESSED) &&
+	     slurm_uncompress_msg_body(&header, buffer)) ||
+	    (header.body_length > remaining_buf(buffer)) ||
 	    (unpack_msg(&msg, buffer) != SLURM_SUCCESS)) {
 		(void) auth_g_destroy(auth_cred);
 		free_buf(buffer);
@@ -1506,6 +1608,65 @@ total_return:
  * send message functions
 \**********************************************************************/
 
+#if HAVE_LZ4
+/*
+ * Replies allowed to be sent compressed to a peer which set
+ * SLURM_ACCEPT_COMPRESSED on its request. These are the few that can grow
+ * to many megabytes on large systems.
+ */
+static bool _compress_msg_type(uint16_t msg_type)
+{
+	switch (msg_type) {
+	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_STEP_INFO:
+	case RESPONSE_NODE_INFO:
+	case RESPONSE_PARTITION_INFO:
+	case RESPONSE_RESERVATION_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+#endif
+
+extern char *slurm_compress_msg_body(slurm_msg_t *msg, const char *body,
+				     uint32_t body_len, uint32_t *comp_len)
+{
+#if HAVE_LZ4
+	char *comp;
+	int bound, len;
+	uint32_t tmp32;
+
+	if (!(msg->flags & SLURM_ACCEPT_COMPRESSED) ||
+	    (msg->protocol_version < SLURM_21_08_PROTOCOL_VERSION) ||
+	    (body_len < COMPRESS_MIN_BODY_SIZE) ||
+	    (body_len > COMPRESS_MAX_BODY_SIZE) ||
+	    !_compress_msg_type(msg->msg_type))
+		return NULL;
+
+	if (!(bound = LZ4_compressBound(body_len)))
+		return NULL;
+	comp = xmalloc_nz(sizeof(tmp32) + bound);
+	len = LZ4_compress_default(body, comp + sizeof(tmp32), body_len,
+				   bound);
+	/* Not worth it unless it saves at least an eighth of the body */
+	if ((len <= 0) || (len > (body_len - (body_len / 8)))) {
+		xfree(comp);
+		return NULL;
+	}
+	tmp32 = htonl(body_len);
+	memcpy(comp, &tmp32, sizeof(tmp32));
+	*comp_len = sizeof(tmp32) + len;
+
+	log_flag(NET, "%s: %s body compressed from %u to %u bytes",
+		 __func__, rpc_num2string(msg->msg_type), body_len, *comp_len);
+
+	return comp;
+#else
+	return NULL;
+#endif
+}
+
 /*
  *  Do the wonderful stuff that needs be done to pack msg
  *  and hdr into buffer
@@ -1539,6 +1700,8 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	int      rc;
 	void *   auth_cred;
 	time_t   start_time = time(NULL);
+	char *comp_body = NULL;
+	uint32_t comp_len = 0;
 
 	if (msg->conn) {
 		persist_msg_t persist_msg;
@@ -1611,11 +1774,15 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 	}
 
 	init_header(&header, msg, msg->flags);
+	header.flags &= ~SLURM_BODY_COMPRESSED;
+#if HAVE_LZ4
+	header.flags |= SLURM_ACCEPT_COMPRESSED;
+#endif
 
 	/*
 	 * Pack header into buffer for transmission
 	 */
-	buffer = init_buf(BUF_SIZE);
+	buffer = init_pool_buf(BUF_SIZE);
 	pack_header(&header, buffer);
 
 	/*
@@ -1626,23 +1793,82 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 		error("%s: auth_g_pack: %s has  authentication error: %m",
 		      __func__, rpc_num2string(header.msg_type));
 		(void) auth_g_destroy(auth_cred);
-		free_buf(buffer);
+		free_pool_buf(buffer);
 		slurm_seterrno_ret(SLURM_PROTOCOL_AUTHENTICATION_ERROR);
 	}
 	(void) auth_g_destroy(auth_cred);
 
-	/*
-	 * Pack message into buffer
-	 */
-	_pack_msg(msg, &header, buffer);
-	log_flag_hex(NET_RAW, get_buf_data(buffer), get_buf_offset(buffer),
-		     "%s: packed", __func__);
+	if (pack_msg_prepacked(msg)) {
+		struct iovec iov[2];
+		unsigned int tmplen;
 
-	/*
-	 * Send message
-	 */
-	rc = slurm_msg_sendto(fd, get_buf_data(buffer),
-			      get_buf_offset(buffer));
+		/*
+		 * Body is already packed, send it in place after the
+		 * header and credential rather than copying it
+		 */
+		if ((comp_body = slurm_compress_msg_body(msg, msg->data,
+							 msg->data_size,
+							 &comp_len))) {
+			header.flags |= SLURM_BODY_COMPRESSED;
+			update_header(&header, comp_len);
+		} else
+			update_header(&header, msg->data_size);
+		tmplen = get_buf_offset(buffer);
+		set_buf_offset(buffer, 0);
+		pack_header(&header, buffer);
+		set_buf_offset(buffer, tmplen);
+		log_flag_hex(NET_RAW, get_buf_data(buffer),
+			     get_buf_offset(buffer), "%s: packed header",
+			     __func__);
+		log_flag_hex(NET_RAW, msg->data, msg->data_size,
+			     "%s: packed body", __func__);
+
+		iov[0].iov_base = get_buf_data(buffer);
+		iov[0].iov_len = get_buf_offset(buffer);
+		if (comp_body) {
+			iov[1].iov_base = comp_body;
+			iov[1].iov_len = comp_len;
+		} else {
+			iov[1].iov_base = msg->data;
+			iov[1].iov_len = msg->data_size;
+		}
+		rc = slurm_msg_sendv(fd, iov, 2);
+	} else {
+		unsigned int body_offset = get_buf_offset(buffer);
+
+		/*
+		 * Pack message into buffer
+		 */
+		_pack_msg(msg, &header, buffer);
+		log_flag_hex(NET_RAW, get_buf_data(buffer),
+			     get_buf_offset(buffer), "%s: packed", __func__);
+
+		if ((comp_body = slurm_compress_msg_body(
+			     msg, get_buf_data(buffer) + body_offset,
+			     get_buf_offset(buffer) - body_offset,
+			     &comp_len))) {
+			struct iovec iov[2];
+
+			/* Same header size, only flags and length change */
+			header.flags |= SLURM_BODY_COMPRESSED;
+			update_header(&header, comp_len);
+			set_buf_offset(buffer, 0);
+			pack_header(&header, buffer);
+
+			iov[0].iov_base = get_buf_data(buffer);
+			iov[0].iov_len = body_offset;
+			iov[1].iov_base = comp_body;
+			iov[1].iov_len = comp_len;
+			rc = slurm_msg_sendv(fd, iov, 2);
+		} else {
+			/*
+			 * Send message
+			 */
+			rc = slurm_msg_sendto(fd, get_buf_data(buffer),
+					      get_buf_offset(buffer));
+		}
+	}
+	xfree(comp_body);
 
 	if ((rc < 0) && (errno == ENOTCONN)) {
 		log_flag(NET, "%s: peer has disappeared for msg_type=%u",
@@ -1660,7 +1886,7 @@ int slurm_send_node_msg(int fd, slurm_msg_t * msg)
 			      msg->msg_type);
 	}
 
-	free_buf(buffer);
+	free_pool_buf(buffer);
 	return rc;
 }
 
@@ -2035,6 +2261,83 @@ extern int slurm_send_recv_msg(int fd, slurm_msg_t *req,
 	return rc;
 }
 
+/*
+ * Idle connections to slurmctld kept for reuse when
+ * CommunicationParameters=ReuseCtldConn is set. slurmctld waits a few
+ * seconds for another request after one flagged with SLURM_CONN_KEEP_ALIVE,
+ * so only reuse connections idle for well under that.
+ */
+#define CTLD_CONN_POOL_SIZE	4
+#define CTLD_CONN_MAX_IDLE	2	/* seconds */
+
+typedef struct {
+	int fd;
+	time_t last_used;
+	pid_t pid;
+} ctld_conn_t;
+
+static ctld_conn_t ctld_conn_pool[CTLD_CONN_POOL_SIZE];
+static int ctld_conn_cnt = 0;
+static pthread_mutex_t ctld_conn_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool _ctld_conn_reuse(slurmdb_cluster_rec_t *comm_cluster_rec)
+{
+	if (comm_cluster_rec)
+		return false;
+
+	return xstrcasestr(slurm_conf.comm_params, "ReuseCtldConn");
+}
+
+/*
+ * Take an idle connection to the controller from the pool.
+ * RET fd or -1 if none is usable
+ */
+static int _ctld_conn_get(void)
+{
+	int fd = -1;
+	time_t now = time(NULL);
+	pid_t pid = getpid();
+
+	slurm_mutex_lock(&ctld_conn_lock);
+	while ((fd < 0) && ctld_conn_cnt) {
+		ctld_conn_t *conn = &ctld_conn_pool[--ctld_conn_cnt];
+		struct pollfd pfd = { .fd = conn->fd, .events = POLLIN };
+
+		/*
+		 * Drop connections that were inherited over fork(), sat idle
+		 * past the reuse window, or that slurmctld has already closed
+		 * (an idle connection is never readable otherwise).
+		 */
+		if ((conn->pid != pid) ||
+		    ((now - conn->last_used) > CTLD_CONN_MAX_IDLE) ||
+		    (poll(&pfd, 1, 0) != 0)) {
+			close(conn->fd);
+			continue;
+		}
+		fd = conn->fd;
+	}
+	slurm_mutex_unlock(&ctld_conn_lock);
+
+	return fd;
+}
+
+/* Return a connection to the pool, or close it if the pool is full */
+static void _ctld_conn_put(int fd)
+{
+	slurm_mutex_lock(&ctld_conn_lock);
+	if (ctld_conn_cnt < CTLD_CONN_POOL_SIZE) {
+		ctld_conn_pool[ctld_conn_cnt].fd = fd;
+		ctld_conn_pool[ctld_conn_cnt].last_used = time(NULL);
+		ctld_conn_pool[ctld_conn_cnt].pid = getpid();
+		ctld_conn_cnt++;
+		fd = -1;
+	}
+	slurm_mutex_unlock(&ctld_conn_lock);
+
+	if ((fd >= 0) && close(fd))
+		error("%s: closing fd:%d error: %m", __func__, fd);
+}
+
 /*
  * Send and recv a slurm request and response on the open slurm descriptor
  * Closes the connection.
@@ -2126,7 +2429,7 @@ extern int slurm_send_recv_controller_msg(slurm_msg_t * request_msg,
 	time_t start_time = time(NULL);
 	int retry = 1;
 	slurm_conf_t *conf;
-	bool have_backup;
+	bool have_backup, reuse, reused = false;
 	uint16_t slurmctld_timeout;
 	slurm_addr_t ctrl_addr;
 	static bool use_backup = false;
@@ -2146,8 +2449,15 @@ tryagain:
 	if (comm_cluster_rec)
 		request_msg->flags |= SLURM_GLOBAL_AUTH_KEY;
 
-	if ((fd = slurm_open_controller_conn(&ctrl_addr, &use_backup,
-					     comm_cluster_rec)) < 0) {
+	if ((reuse = _ctld_conn_reuse(comm_cluster_rec))) {
+		request_msg->flags |= SLURM_CONN_KEEP_ALIVE;
+		if ((fd = _ctld_conn_get()) >= 0)
+			reused = true;
+	}
+
+	if ((fd < 0) &&
+	    ((fd = slurm_open_controller_conn(&ctrl_addr, &use_backup,
+					      comm_cluster_rec)) < 0)) {
 		rc = -1;
 		goto cleanup;
 	}
@@ -2163,12 +2473,38 @@ tryagain:
 		 * control, we sleep and retry later
 		 */
 		retry = 0;
-		rc = _send_and_recv_msg(fd, request_msg, response_msg, 0);
+		if (reuse) {
+			rc = slurm_send_recv_msg(fd, request_msg, response_msg,
+						 0);
+		} else {
+			rc = _send_and_recv_msg(fd, request_msg, response_msg,
+						0);
+		}
 		if (response_msg->auth_cred)
 			auth_g_destroy(response_msg->auth_cred);
 		else
 			rc = -1;
 
+		if (reused) {
+			reused = false;
+			/*
+			 * slurmctld closed the idle connection before reading
+			 * the request, so it is safe to send it again on a
+			 * new one.
+			 */
+			if (rc == -1) {
+				log_flag(NET, "%s: reused controller connection closed, reconnecting",
+					 __func__);
+				close(fd);
+				if ((fd = slurm_open_controller_conn(
+					     &ctrl_addr, &use_backup,
+					     comm_cluster_rec)) < 0)
+					break;
+				retry = 1;
+				continue;
+			}
+		}
+
 		if ((rc == 0) && (!comm_cluster_rec)
 		    && (response_msg->msg_type == RESPONSE_SLURM_RC)
 		    && ((((return_code_msg_t *)response_msg->data)->return_code)
@@ -2179,6 +2515,8 @@ tryagain:
 			log_flag(NET, "%s: Primary not responding, backup not in control. Sleeping and retry.",
 				 __func__);
 			slurm_free_return_code_msg(response_msg->data);
+			if (reuse)
+				close(fd);
 			sleep(slurmctld_timeout / 2);
 			use_backup = false;
 			if ((fd = slurm_open_controller_conn(&ctrl_addr,
@@ -2195,6 +2533,15 @@ tryagain:
 			break;
 	}
 
+	if (reuse && (fd >= 0)) {
+		if (rc == 0)
+			_ctld_conn_put(fd);
+		else
+			close(fd);
+	}
+	fd = -1;
+	request_msg->flags &= ~SLURM_CONN_KEEP_ALIVE;
+
 	if (!rc && (response_msg->msg_type == RESPONSE_SLURM_REROUTE_MSG)) {
 		reroute_msg_t *rr_msg = (reroute_msg_t *)response_msg->data;
 
@@ -2634,6 +2981,8 @@ extern void slurm_free_msg_members(slurm_msg_t *msg)
 		free_buf(msg->buffer);
 		slurm_free_msg_data(msg->msg_type, msg->data);
 		FREE_NULL_LIST(msg->ret_list);
+		xarena_destroy(msg->arena);
+		msg->arena = NULL;
 	}
 }
 
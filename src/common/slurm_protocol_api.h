@@ -250,6 +250,17 @@ extern int slurm_accept_msg_conn(int open_fd, slurm_addr_t * slurm_address);
 
 extern int slurm_unpack_received_msg(slurm_msg_t *msg, int fd, buf_t *buffer);
 
+/*
+ * Replace the lz4 compressed body at the current offset of buffer (see
+ * slurm_compress_msg_body()) with the uncompressed one, leaving what was
+ * already unpacked untouched, and update header->body_length to match.
+ * IN/OUT header - header of the message, SLURM_BODY_COMPRESSED is cleared
+ * IN/OUT buffer - received message positioned at the start of the body
+ * RET SLURM_SUCCESS or SLURM_ERROR if the body is malformed or lz4 support
+ *	is not built in
+ */
+extern int slurm_uncompress_msg_body(header_t *header, buf_t *buffer);
+
 /*
  *  Receive a slurm message on the open slurm descriptor "fd" waiting
  *    at most "timeout" seconds for the message data. If timeout is
@@ -311,6 +322,20 @@ int slurm_receive_msg_and_forward(int fd, slurm_addr_t *orig_addr,
  */
 int slurm_send_node_msg(int open_fd, slurm_msg_t *msg);
 
+/*
+ * Compress a packed message body if msg is allowed to be sent compressed
+ * and it pays off.
+ * IN msg - message the body belongs to, its flags must carry
+ *	SLURM_ACCEPT_COMPRESSED
+ * IN body - packed message body
+ * IN body_len - size of body
+ * OUT comp_len - size of the returned compressed body
+ * RET xmalloc()'d compressed body (the uncompressed length followed by the
+ *	lz4 data) or NULL to send the body as is
+ */
+extern char *slurm_compress_msg_body(slurm_msg_t *msg, const char *body,
+				     uint32_t body_len, uint32_t *comp_len);
+
 /**********************************************************************\
  * msg connection establishment functions used by msg clients
 \**********************************************************************/
@@ -105,5 +105,13 @@
 #define SLURM_DROP_PRIV		0x0008
 #define USE_BCAST_NETWORK	0x0010
 #define CTLD_QUEUE_PROCESSING	0x0020
+#define SLURM_CONN_KEEP_ALIVE	0x0040	/* sender will reuse the connection
+					 * for another request */
+#define SLURM_AGGREGATE_REPLY	0x0080	/* nodes forwarding the request may
+					 * merge the replies of their subtree
+					 * (REQUEST_JOB_STEP_STAT only) */
+#define SLURM_ACCEPT_COMPRESSED	0x0100	/* sender can take an lz4 compressed
+					 * reply body */
+#define SLURM_BODY_COMPRESSED	0x0200	/* message body is lz4 compressed */
 
 #endif
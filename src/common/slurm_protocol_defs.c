@@ -994,6 +994,11 @@ extern void slurm_free_job_info_request_msg(job_info_request_msg_t *msg)
 {
 	if (msg) {
 		FREE_NULL_LIST(msg->job_ids);
+		xfree(msg->accounts);
+		FREE_NULL_LIST(msg->job_id_list);
+		xfree(msg->partitions);
+		FREE_NULL_LIST(msg->state_list);
+		FREE_NULL_LIST(msg->uid_list);
 		xfree(msg);
 	}
 }
@@ -1762,6 +1767,52 @@ extern void slurm_free_stats_response_msg(stats_info_response_msg_t *msg)
 			xfree(msg->rpc_dump_hostlist[i]);
 		}
 		xfree(msg->rpc_dump_hostlist);
+		if (msg->lock_name) {
+			for (i = 0; i < msg->lock_stats_cnt; i++)
+				xfree(msg->lock_name[i]);
+		}
+		xfree(msg->lock_name);
+		xfree(msg->lock_count);
+		xfree(msg->lock_wait_sum);
+		xfree(msg->lock_wait_max);
+		xfree(msg->lock_wait_hist);
+		xfree(msg->lock_hold_sum);
+		xfree(msg->lock_hold_max);
+		xfree(msg->lock_hold_hist);
+		if (msg->lock_holder_caller) {
+			for (i = 0; i < msg->lock_holder_cnt; i++)
+				xfree(msg->lock_holder_caller[i]);
+		}
+		xfree(msg->lock_holder_caller);
+		xfree(msg->lock_holder_rpc_type);
+		xfree(msg->lock_holder_count);
+		xfree(msg->lock_holder_hold_sum);
+		xfree(msg->lock_holder_hold_max);
+		xfree(msg->rpcq_type_id);
+		xfree(msg->rpcq_depth);
+		xfree(msg->rpcq_depth_max);
+		xfree(msg->rpcq_msg_cnt);
+		xfree(msg->rpcq_batch_cnt);
+		xfree(msg->rpcq_batch_max);
+		xfree(msg->rpcq_wait_sum);
+		xfree(msg->rpcq_wait_max);
+		if (msg->fed_sib_name) {
+			for (i = 0; i < msg->fed_sib_cnt; i++)
+				xfree(msg->fed_sib_name[i]);
+		}
+		xfree(msg->fed_sib_name);
+		xfree(msg->fed_sib_depth);
+		xfree(msg->fed_sib_msg_cnt);
+		xfree(msg->fed_sib_batch_cnt);
+		xfree(msg->fed_sib_batch_max);
+		xfree(msg->fed_sib_fail_cnt);
+		xfree(msg->fed_sib_lag_sum);
+		xfree(msg->fed_sib_lag_max);
+		xfree(msg->fed_sib_lag_now);
+		xfree(msg->rpc_lat_type_id);
+		xfree(msg->rpc_lat_exec);
+		xfree(msg->rpc_lat_wait);
+		xfree(msg->rpc_lat_wait_sum);
 		xfree(msg);
 	}
 }
@@ -4239,6 +4290,29 @@ extern void slurm_free_submit_response_response_msg(submit_response_msg_t * msg)
 	}
 }
 
+/*
+ * slurm_free_submit_response_list_msg - free slurm job list submit response
+ *	message
+ * IN msg - pointer to job list submit response message
+ * NOTE: buffer is loaded by slurm_submit_batch_job_list
+ */
+extern void slurm_free_submit_response_list_msg(
+	submit_response_list_msg_t *msg)
+{
+	uint32_t i;
+
+	if (msg) {
+		if (msg->job_submit_user_msg) {
+			for (i = 0; i < msg->job_cnt; i++)
+				xfree(msg->job_submit_user_msg[i]);
+			xfree(msg->job_submit_user_msg);
+		}
+		xfree(msg->error_code);
+		xfree(msg->job_id);
+		xfree(msg);
+	}
+}
+
 
 /*
  * slurm_free_ctl_conf - free slurm control information response message
@@ -4651,6 +4725,7 @@ extern void slurm_free_step_complete_msg(step_complete_msg_t *msg)
 {
 	if (msg) {
 		jobacctinfo_destroy(msg->jobacct);
+		FREE_NULL_BITMAP(msg->task_exit_ok);
 		xfree(msg);
 	}
 }
@@ -4860,6 +4935,35 @@ extern void slurm_free_set_fs_dampening_factor_msg(
 	xfree(msg);
 }
 
+extern void slurm_free_event_info_request_msg(event_info_request_msg_t *msg)
+{
+	xfree(msg);
+}
+
+extern void slurm_free_event_info_msg(event_info_msg_t *msg)
+{
+	int i;
+
+	if (!msg)
+		return;
+
+	if (msg->event_array) {
+		for (i = 0; i < msg->record_count; i++)
+			xfree(msg->event_array[i].name);
+		xfree(msg->event_array);
+	}
+	xfree(msg);
+}
+
+extern void slurm_free_sched_trace_msg(sched_trace_msg_t *msg)
+{
+	if (!msg)
+		return;
+
+	xfree(msg->trace_array);
+	xfree(msg);
+}
+
 extern void slurm_free_control_status_msg(control_status_msg_t *msg)
 {
 	xfree(msg);
@@ -5011,6 +5115,9 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 	case RESPONSE_SUBMIT_BATCH_JOB:
 		slurm_free_submit_response_response_msg(data);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		slurm_free_submit_response_list_msg(data);
+		break;
 	case RESPONSE_ACCT_GATHER_UPDATE:
 		slurm_free_acct_gather_node_resp_msg(data);
 		break;
@@ -5281,12 +5388,25 @@ extern int slurm_free_msg_data(slurm_msg_type_t type, void *data)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
 	case RESPONSE_HET_JOB_ALLOCATION:
 		FREE_NULL_LIST(data);
 		break;
 	case REQUEST_SET_FS_DAMPENING_FACTOR:
 		slurm_free_set_fs_dampening_factor_msg(data);
 		break;
+	case REQUEST_EVENT_INFO:
+		slurm_free_event_info_request_msg(data);
+		break;
+	case RESPONSE_EVENT_INFO:
+		slurm_free_event_info_msg(data);
+		break;
+	case REQUEST_JOB_SCHED_TRACE:
+		slurm_free_job_id_msg(data);
+		break;
+	case RESPONSE_JOB_SCHED_TRACE:
+		slurm_free_sched_trace_msg(data);
+		break;
 	case RESPONSE_CONTROL_STATUS:
 		slurm_free_control_status_msg(data);
 		break;
@@ -5570,6 +5690,14 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_BURST_BUFFER_STATUS";
 	case RESPONSE_BURST_BUFFER_STATUS:
 		return "RESPONSE_BURST_BUFFER_STATUS";
+	case REQUEST_EVENT_INFO:
+		return "REQUEST_EVENT_INFO";
+	case RESPONSE_EVENT_INFO:
+		return "RESPONSE_EVENT_INFO";
+	case REQUEST_JOB_SCHED_TRACE:
+		return "REQUEST_JOB_SCHED_TRACE";
+	case RESPONSE_JOB_SCHED_TRACE:
+		return "RESPONSE_JOB_SCHED_TRACE";
 
 	case REQUEST_CRONTAB:					/* 2200 */
 		return "REQUEST_CRONTAB";
@@ -5658,6 +5786,10 @@ rpc_num2string(uint16_t opcode)
 		return "REQUEST_HET_JOB_ALLOC_INFO";
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
 		return "REQUEST_SUBMIT_BATCH_HET_JOB";
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
+		return "REQUEST_SUBMIT_BATCH_JOB_LIST";
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		return "RESPONSE_SUBMIT_BATCH_JOB_LIST";
 
 	case REQUEST_JOB_STEP_CREATE:				/* 5001 */
 		return "REQUEST_JOB_STEP_CREATE";
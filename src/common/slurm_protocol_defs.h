@@ -66,6 +66,7 @@
 #include "src/common/slurmdb_defs.h"
 #include "src/common/working_cluster.h"
 #include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
 
 #define FORWARD_INIT 0xfffe
 
@@ -303,6 +304,10 @@ typedef enum {
 	RESPONSE_CONTROL_STATUS,
 	REQUEST_BURST_BUFFER_STATUS,
 	RESPONSE_BURST_BUFFER_STATUS,
+	REQUEST_EVENT_INFO,
+	RESPONSE_EVENT_INFO,
+	REQUEST_JOB_SCHED_TRACE,
+	RESPONSE_JOB_SCHED_TRACE,
 
 	REQUEST_CRONTAB = 2200,
 	RESPONSE_CRONTAB,
@@ -351,6 +356,8 @@ typedef enum {
 	RESPONSE_HET_JOB_ALLOCATION,
 	REQUEST_HET_JOB_ALLOC_INFO,
 	REQUEST_SUBMIT_BATCH_HET_JOB,
+	REQUEST_SUBMIT_BATCH_JOB_LIST,
+	RESPONSE_SUBMIT_BATCH_JOB_LIST,		/* 4030 */
 
 	REQUEST_CTLD_MULT_MSG = 4500,
 	RESPONSE_CTLD_MULT_MSG,
@@ -527,6 +534,9 @@ typedef struct slurm_msg {
 				 buffer starts. */
 	buf_t *buffer;		/* DON'T PACK! ptr to buffer that msg was
 				 * unpacked from. */
+	xarena_t *arena;	/* DON'T PACK! if set by the receiver, arena
+				 * the body of a read only request is
+				 * unpacked into, freed with the msg */
 	slurm_persist_conn_t *conn; /* DON'T PACK OR FREE! this is here to
 				     * distinguish a persistent connection from
 				     * a normal connection it should be filled
@@ -649,6 +659,12 @@ typedef struct job_info_request_msg {
 	uint16_t show_flags;
 	List   job_ids;		/* Optional list of job_ids, otherwise show all
 				 * jobs. */
+	/* Optional filters, only jobs matching all of them are shown */
+	char  *accounts;	/* comma delimited account names */
+	List   job_id_list;	/* uint32_t job, array or hetjob IDs */
+	char  *partitions;	/* comma delimited partition names */
+	List   state_list;	/* uint32_t job states */
+	List   uid_list;	/* uint32_t user IDs */
 } job_info_request_msg_t;
 
 typedef struct job_step_info_request_msg {
@@ -705,6 +721,8 @@ typedef struct step_complete_msg {
 	slurm_step_id_t step_id;
  	uint32_t step_rc;	/* largest task return code */
 	jobacctinfo_t *jobacct;
+	bitstr_t *task_exit_ok;	/* tasks exited 0 whose MESSAGE_TASK_EXIT is
+				 * left to the reverse tree root, or NULL */
 } step_complete_msg_t;
 
 typedef struct signal_tasks_msg {
@@ -965,6 +983,11 @@ typedef struct set_fs_dampening_factor_msg {
 	uint16_t dampening_factor;
 } set_fs_dampening_factor_msg_t;
 
+typedef struct event_info_request_msg {
+	uint64_t seq;		/* first event wanted, 0 for current */
+	uint16_t wait;		/* seconds to wait for an event */
+} event_info_request_msg_t;
+
 typedef struct control_status_msg {
 	uint16_t backup_inx;	/* Our BackupController# index,
 				 * between 0 and (MAX_CONTROLLERS-1) */
@@ -1196,6 +1219,7 @@ typedef struct file_bcast_msg {
 	uint64_t block_offset;	/* offset for this data block */
 	uint32_t uncomp_len;	/* uncompressed length of this data block */
 	char *block;		/* data for this block */
+	uint64_t file_hash;	/* content hash for node caches, or zero */
 	uint64_t file_size;	/* file size */
 } file_bcast_msg_t;
 
@@ -1532,6 +1556,8 @@ extern void slurm_free_job_step_create_response_msg(
 		job_step_create_response_msg_t * msg);
 extern void slurm_free_submit_response_response_msg(
 		submit_response_msg_t * msg);
+extern void slurm_free_submit_response_list_msg(
+		submit_response_list_msg_t *msg);
 extern void slurm_free_ctl_conf(slurm_ctl_conf_info_msg_t * config_ptr);
 extern void slurm_free_job_info_msg(job_info_msg_t * job_buffer_ptr);
 extern void slurm_free_job_step_info_response_msg(
@@ -1570,6 +1596,7 @@ extern void slurm_free_network_callerid_msg(network_callerid_msg_t *mesg);
 extern void slurm_free_network_callerid_resp(network_callerid_resp_t *resp);
 extern void slurm_free_set_fs_dampening_factor_msg(
 	set_fs_dampening_factor_msg_t *msg);
+extern void slurm_free_event_info_request_msg(event_info_request_msg_t *msg);
 extern void slurm_free_control_status_msg(control_status_msg_t *msg);
 
 extern void slurm_free_bb_status_req_msg(bb_status_req_msg_t *msg);
@@ -48,6 +48,7 @@
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 #include "src/common/macros.h"
@@ -95,6 +96,20 @@ extern ssize_t slurm_msg_sendto_timeout(int open_fd,
 					size_t size,
 					int timeout);
 
+/* slurm_msg_sendv
+ * Send a message made of several pieces as one length prefixed
+ *	message, without first copying the pieces into one buffer
+ * IN open_fd - an open file descriptor
+ * IN iov - pieces of the message to transmit, in order
+ * IN iov_cnt - count of pieces
+ * RET number of bytes written, excluding the length prefix
+ */
+extern ssize_t slurm_msg_sendv(int open_fd, struct iovec *iov, int iov_cnt);
+/* slurm_msg_sendv_timeout is identical to slurm_msg_sendv except
+ * IN timeout - maximum time to wait for a message in milliseconds */
+extern ssize_t slurm_msg_sendv_timeout(int open_fd, struct iovec *iov,
+				       int iov_cnt, int timeout);
+
 /********************/
 /* stream functions */
 /********************/
@@ -78,6 +78,7 @@
 #define _pack_stats_response_msg(msg,buf)	_pack_buffer_msg(msg,buf)
 #define _pack_reserve_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
 #define _pack_assoc_mgr_info_msg(msg,buf)      _pack_buffer_msg(msg,buf)
+#define _pack_event_info_msg(msg,buf)		_pack_buffer_msg(msg,buf)
 
 static int _unpack_node_info_members(node_info_t *node, buf_t *buffer,
 				     uint16_t protocol_version);
@@ -1662,6 +1663,7 @@ static int _unpack_node_info_msg(node_info_msg_t **msg, buf_t *buffer,
 				 uint16_t protocol_version)
 {
 	int i;
+	uint8_t delta, changed;
 	node_info_msg_t *tmp_ptr;
 
 	xassert(msg);
@@ -1669,7 +1671,35 @@ static int _unpack_node_info_msg(node_info_msg_t **msg, buf_t *buffer,
 	*msg = tmp_ptr;
 
 	/* load buffer's header (data structure version and time) */
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32(&tmp_ptr->record_count, buffer);
+		safe_unpack_time(&tmp_ptr->last_update, buffer);
+		safe_unpack8(&delta, buffer);
+
+		safe_xcalloc(tmp_ptr->node_array, tmp_ptr->record_count,
+			     sizeof(node_info_t));
+
+		/*
+		 * Records unchanged since the delta request's update_time are
+		 * left with a NULL name and a node_state of NO_VAL for
+		 * slurm_load_node_delta() to fill in.
+		 */
+		for (i = 0; i < tmp_ptr->record_count; i++) {
+			changed = 1;
+			if (delta)
+				safe_unpack8(&changed, buffer);
+			if (!changed) {
+				slurm_init_node_info_t(&tmp_ptr->node_array[i],
+						       false);
+				tmp_ptr->node_array[i].node_state = NO_VAL;
+				continue;
+			}
+			if (_unpack_node_info_members(&tmp_ptr->node_array[i],
+						      buffer,
+						      protocol_version))
+				goto unpack_error;
+		}
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&tmp_ptr->record_count, buffer);
 		safe_unpack_time(&tmp_ptr->last_update, buffer);
 
@@ -1706,16 +1736,16 @@ _unpack_node_info_members(node_info_t * node, buf_t *buffer,
 	slurm_init_node_info_t(node, false);
 
 	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
-		safe_unpackstr_xmalloc(&node->name, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->node_hostname, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&node->name, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->node_hostname, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&node->node_addr, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->bcast_address, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&node->node_addr, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->bcast_address, &uint32_tmp,
 				       buffer);
 		safe_unpack16(&node->port, buffer);
-		safe_unpack32(&node->next_state, buffer);
-		safe_unpack32(&node->node_state, buffer);
-		safe_unpackstr_xmalloc(&node->version, &uint32_tmp, buffer);
+		safe_unpackvar32(&node->next_state, buffer);
+		safe_unpackvar32(&node->node_state, buffer);
+		safe_unpackvarstr_xmalloc(&node->version, &uint32_tmp, buffer);
 
 		safe_unpack16(&node->cpus, buffer);
 		safe_unpack16(&node->boards, buffer);
@@ -1723,43 +1753,43 @@ _unpack_node_info_members(node_info_t * node, buf_t *buffer,
 		safe_unpack16(&node->cores, buffer);
 		safe_unpack16(&node->threads, buffer);
 
-		safe_unpack64(&node->real_memory, buffer);
-		safe_unpack32(&node->tmp_disk, buffer);
+		safe_unpackvar64(&node->real_memory, buffer);
+		safe_unpackvar32(&node->tmp_disk, buffer);
 
-		safe_unpackstr_xmalloc(&node->mcs_label, &uint32_tmp, buffer);
-		safe_unpack32(&node->owner, buffer);
+		safe_unpackvarstr_xmalloc(&node->mcs_label, &uint32_tmp, buffer);
+		safe_unpackvar32(&node->owner, buffer);
 		safe_unpack16(&node->core_spec_cnt, buffer);
-		safe_unpack32(&node->cpu_bind, buffer);
-		safe_unpack64(&node->mem_spec_limit, buffer);
-		safe_unpackstr_xmalloc(&node->cpu_spec_list, &uint32_tmp,
+		safe_unpackvar32(&node->cpu_bind, buffer);
+		safe_unpackvar64(&node->mem_spec_limit, buffer);
+		safe_unpackvarstr_xmalloc(&node->cpu_spec_list, &uint32_tmp,
 				       buffer);
 
-		safe_unpack32(&node->cpu_load, buffer);
-		safe_unpack64(&node->free_mem, buffer);
-		safe_unpack32(&node->weight, buffer);
-		safe_unpack32(&node->reason_uid, buffer);
+		safe_unpackvar32(&node->cpu_load, buffer);
+		safe_unpackvar64(&node->free_mem, buffer);
+		safe_unpackvar32(&node->weight, buffer);
+		safe_unpackvar32(&node->reason_uid, buffer);
 
-		safe_unpack_time(&node->boot_time, buffer);
-		safe_unpack_time(&node->last_busy, buffer);
-		safe_unpack_time(&node->reason_time, buffer);
-		safe_unpack_time(&node->slurmd_start_time, buffer);
+		safe_unpackvar_time(&node->boot_time, buffer);
+		safe_unpackvar_time(&node->last_busy, buffer);
+		safe_unpackvar_time(&node->reason_time, buffer);
+		safe_unpackvar_time(&node->slurmd_start_time, buffer);
 
 		if (select_g_select_nodeinfo_unpack(&node->select_nodeinfo,
 						    buffer, protocol_version)
 		    != SLURM_SUCCESS)
 			goto unpack_error;
 
-		safe_unpackstr_xmalloc(&node->arch, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->features, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->features_act, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->arch, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->features, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->features_act, &uint32_tmp, buffer);
 		if (!node->features_act)
 			node->features_act = xstrdup(node->features);
-		safe_unpackstr_xmalloc(&node->gres, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->gres_drain, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->gres_used, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->os, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->comment, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&node->reason, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->gres, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->gres_drain, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->gres_used, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->os, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->comment, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&node->reason, &uint32_tmp, buffer);
 		if (acct_gather_energy_unpack(&node->energy, buffer,
 					      protocol_version, 1)
 		    != SLURM_SUCCESS)
@@ -1772,7 +1802,7 @@ _unpack_node_info_members(node_info_t * node, buf_t *buffer,
 					   protocol_version) != SLURM_SUCCESS)
 			goto unpack_error;
 
-		safe_unpackstr_xmalloc(&node->tres_fmt_str, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&node->tres_fmt_str, &uint32_tmp,
 				       buffer);
 	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		safe_unpackstr_xmalloc(&node->name, &uint32_tmp, buffer);
@@ -2312,11 +2342,11 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-extern int slurm_pack_list(List send_list,
-			   void (*pack_function) (void *object,
-						  uint16_t protocol_version,
-						  buf_t *buffer),
-			   buf_t *buffer, uint16_t protocol_version)
+static int _pack_list(List send_list,
+		      void (*pack_function) (void *object,
+					     uint16_t protocol_version,
+					     buf_t *buffer),
+		      buf_t *buffer, uint16_t protocol_version, bool consume)
 {
 	uint32_t count = 0;
 	uint32_t header_position;
@@ -2348,6 +2378,8 @@ extern int slurm_pack_list(List send_list,
 				rc = ESLURM_RESULT_TOO_LARGE;
 				break;
 			}
+			if (consume)
+				list_delete_item(itr);
 		}
 		list_iterator_destroy(itr);
 	}
@@ -2355,6 +2387,26 @@ extern int slurm_pack_list(List send_list,
 	return rc;
 }
 
+extern int slurm_pack_list(List send_list,
+			   void (*pack_function) (void *object,
+						  uint16_t protocol_version,
+						  buf_t *buffer),
+			   buf_t *buffer, uint16_t protocol_version)
+{
+	return _pack_list(send_list, pack_function, buffer, protocol_version,
+			  false);
+}
+
+extern int slurm_pack_list_consume(List send_list,
+				   void (*pack_function) (void *object,
+							  uint16_t rpc_version,
+							  buf_t *buffer),
+				   buf_t *buffer, uint16_t protocol_version)
+{
+	return _pack_list(send_list, pack_function, buffer, protocol_version,
+			  true);
+}
+
 extern int slurm_unpack_list(List *recv_list,
 			     int (*unpack_function) (void **object,
 						     uint16_t protocol_version,
@@ -3547,6 +3599,7 @@ _unpack_job_info_msg(job_info_msg_t ** msg, buf_t *buffer,
 		     uint16_t protocol_version)
 {
 	job_info_t *job = NULL;
+	uint8_t delta = 0, changed;
 
 	xassert(msg);
 	*msg = xmalloc(sizeof(job_info_msg_t));
@@ -3556,6 +3609,7 @@ _unpack_job_info_msg(job_info_msg_t ** msg, buf_t *buffer,
 		safe_unpack32(&((*msg)->record_count), buffer);
 		safe_unpack_time(&((*msg)->last_update), buffer);
 		safe_unpack_time(&((*msg)->last_backfill), buffer);
+		safe_unpack8(&delta, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&((*msg)->record_count), buffer);
 		safe_unpack_time(&((*msg)->last_update), buffer);
@@ -3573,9 +3627,31 @@ _unpack_job_info_msg(job_info_msg_t ** msg, buf_t *buffer,
 	/* load individual job info */
 	for (int i = 0; i < (*msg)->record_count; i++) {
 		job_info_t *job_ptr = &job[i];
+		/*
+		 * Records unchanged since the delta request's update_time are
+		 * left with only the job_id and a job_state of NO_VAL for
+		 * slurm_load_jobs_delta() to fill in.
+		 */
+		changed = 1;
+		if (delta)
+			safe_unpack8(&changed, buffer);
+		if (!changed) {
+			safe_unpack32(&job_ptr->job_id, buffer);
+			job_ptr->job_state = NO_VAL;
+			continue;
+		}
 		if (_unpack_job_info_members(job_ptr, buffer,
 					     protocol_version))
 			goto unpack_error;
+		/* Expected start time is never in the past */
+		if (IS_JOB_PENDING(job_ptr) && job_ptr->start_time &&
+		    (job_ptr->start_time < (*msg)->last_update)) {
+			job_ptr->start_time = (*msg)->last_update;
+			if (job_ptr->time_limit != NO_VAL)
+				job_ptr->end_time = MAX(job_ptr->end_time,
+					(job_ptr->start_time +
+					 job_ptr->time_limit * 60));
+		}
 		if ((job_ptr->bitflags & BACKFILL_SCHED) &&
 		    (*msg)->last_backfill &&
 		    IS_JOB_PENDING(job_ptr) &&
@@ -3606,97 +3682,97 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 	char *temp_str;
 
 	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
-		safe_unpack32(&job->array_job_id, buffer);
-		safe_unpack32(&job->array_task_id, buffer);
+		safe_unpackvar32(&job->array_job_id, buffer);
+		safe_unpackvar32(&job->array_task_id, buffer);
 		/* The array_task_str value is stored in slurmctld and passed
 		 * here in hex format for best scalability. Its format needs
 		 * to be converted to human readable form by the client. */
-		safe_unpackstr_xmalloc(&job->array_task_str, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->array_task_str, &uint32_tmp,
 				       buffer);
-		safe_unpack32(&job->array_max_tasks, buffer);
+		safe_unpackvar32(&job->array_max_tasks, buffer);
 		xlate_array_task_str(&job->array_task_str, job->array_max_tasks,
 				     &job->array_bitmap);
 
-		safe_unpack32(&job->assoc_id, buffer);
-		safe_unpackstr_xmalloc(&job->container, &uint32_tmp, buffer);
-		safe_unpack32(&job->delay_boot, buffer);
-		safe_unpack32(&job->job_id, buffer);
-		safe_unpack32(&job->user_id, buffer);
-		safe_unpack32(&job->group_id, buffer);
-		safe_unpack32(&job->het_job_id, buffer);
-		safe_unpackstr_xmalloc(&job->het_job_id_set, &uint32_tmp,
+		safe_unpackvar32(&job->assoc_id, buffer);
+		safe_unpackvarstr_xmalloc(&job->container, &uint32_tmp, buffer);
+		safe_unpackvar32(&job->delay_boot, buffer);
+		safe_unpackvar32(&job->job_id, buffer);
+		safe_unpackvar32(&job->user_id, buffer);
+		safe_unpackvar32(&job->group_id, buffer);
+		safe_unpackvar32(&job->het_job_id, buffer);
+		safe_unpackvarstr_xmalloc(&job->het_job_id_set, &uint32_tmp,
 				       buffer);
-		safe_unpack32(&job->het_job_offset, buffer);
-		safe_unpack32(&job->profile, buffer);
+		safe_unpackvar32(&job->het_job_offset, buffer);
+		safe_unpackvar32(&job->profile, buffer);
 
-		safe_unpack32(&job->job_state, buffer);
+		safe_unpackvar32(&job->job_state, buffer);
 		safe_unpack16(&job->batch_flag, buffer);
 		safe_unpack16(&job->state_reason, buffer);
 		safe_unpack8 (&job->power_flags, buffer);
 		safe_unpack8 (&job->reboot, buffer);
 		safe_unpack16(&job->restart_cnt, buffer);
 		safe_unpack16(&job->show_flags, buffer);
-		safe_unpack_time(&job->deadline, buffer);
-
-		safe_unpack32(&job->alloc_sid, buffer);
-		safe_unpack32(&job->time_limit, buffer);
-		safe_unpack32(&job->time_min, buffer);
-
-		safe_unpack32(&job->nice, buffer);
-
-		safe_unpack_time(&job->submit_time, buffer);
-		safe_unpack_time(&job->eligible_time, buffer);
-		safe_unpack_time(&job->accrue_time, buffer);
-		safe_unpack_time(&job->start_time, buffer);
-		safe_unpack_time(&job->end_time, buffer);
-		safe_unpack_time(&job->suspend_time, buffer);
-		safe_unpack_time(&job->pre_sus_time, buffer);
-		safe_unpack_time(&job->resize_time, buffer);
-		safe_unpack_time(&job->last_sched_eval, buffer);
-		safe_unpack_time(&job->preempt_time, buffer);
-		safe_unpack32(&job->priority, buffer);
+		safe_unpackvar_time(&job->deadline, buffer);
+
+		safe_unpackvar32(&job->alloc_sid, buffer);
+		safe_unpackvar32(&job->time_limit, buffer);
+		safe_unpackvar32(&job->time_min, buffer);
+
+		safe_unpackvar32(&job->nice, buffer);
+
+		safe_unpackvar_time(&job->submit_time, buffer);
+		safe_unpackvar_time(&job->eligible_time, buffer);
+		safe_unpackvar_time(&job->accrue_time, buffer);
+		safe_unpackvar_time(&job->start_time, buffer);
+		safe_unpackvar_time(&job->end_time, buffer);
+		safe_unpackvar_time(&job->suspend_time, buffer);
+		safe_unpackvar_time(&job->pre_sus_time, buffer);
+		safe_unpackvar_time(&job->resize_time, buffer);
+		safe_unpackvar_time(&job->last_sched_eval, buffer);
+		safe_unpackvar_time(&job->preempt_time, buffer);
+		safe_unpackvar32(&job->priority, buffer);
 		safe_unpackdouble(&job->billable_tres, buffer);
-		safe_unpackstr_xmalloc(&job->cluster, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->nodes, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->sched_nodes, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->partition, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->account, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->admin_comment, &uint32_tmp,buffer);
-		safe_unpack32(&job->site_factor, buffer);
-		safe_unpackstr_xmalloc(&job->network, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->comment, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->container, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->batch_features, &uint32_tmp,
-				       buffer);
-		safe_unpackstr_xmalloc(&job->batch_host, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->burst_buffer, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->burst_buffer_state, &uint32_tmp,
-				       buffer);
-		safe_unpackstr_xmalloc(&job->system_comment,
-				       &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->qos, &uint32_tmp, buffer);
-		safe_unpack_time(&job->preemptable_time, buffer);
-		safe_unpackstr_xmalloc(&job->licenses, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->state_desc, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->resv_name, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->mcs_label, &uint32_tmp, buffer);
-
-		safe_unpack32(&job->exit_code, buffer);
-		safe_unpack32(&job->derived_ec, buffer);
-		safe_unpackstr_xmalloc(&job->gres_total, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->cluster, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->nodes, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->sched_nodes, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->partition, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->account, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->admin_comment, &uint32_tmp,buffer);
+		safe_unpackvar32(&job->site_factor, buffer);
+		safe_unpackvarstr_xmalloc(&job->network, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->comment, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->container, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->batch_features, &uint32_tmp,
+				       buffer);
+		safe_unpackvarstr_xmalloc(&job->batch_host, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->burst_buffer, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->burst_buffer_state, &uint32_tmp,
+				       buffer);
+		safe_unpackvarstr_xmalloc(&job->system_comment,
+				       &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->qos, &uint32_tmp, buffer);
+		safe_unpackvar_time(&job->preemptable_time, buffer);
+		safe_unpackvarstr_xmalloc(&job->licenses, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->state_desc, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->resv_name, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->mcs_label, &uint32_tmp, buffer);
+
+		safe_unpackvar32(&job->exit_code, buffer);
+		safe_unpackvar32(&job->derived_ec, buffer);
+		safe_unpackvarstr_xmalloc(&job->gres_total, &uint32_tmp, buffer);
 		if (unpack_job_resources(&job->job_resrcs, buffer,
 					 protocol_version))
 			goto unpack_error;
 		safe_unpackstr_array(&job->gres_detail_str,
 				     &job->gres_detail_cnt, buffer);
 
-		safe_unpackstr_xmalloc(&job->name, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->user_name, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->wckey, &uint32_tmp, buffer);
-		safe_unpack32(&job->req_switch, buffer);
-		safe_unpack32(&job->wait4switch, buffer);
+		safe_unpackvarstr_xmalloc(&job->name, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->user_name, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->wckey, &uint32_tmp, buffer);
+		safe_unpackvar32(&job->req_switch, buffer);
+		safe_unpackvar32(&job->wait4switch, buffer);
 
-		safe_unpackstr_xmalloc(&job->alloc_node, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->alloc_node, &uint32_tmp, buffer);
 
 		unpack_bit_str_hex_as_inx(&job->node_inx, buffer);
 
@@ -3705,28 +3781,28 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 			goto unpack_error;
 
 		/*** unpack default job details ***/
-		safe_unpackstr_xmalloc(&job->features, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->cluster_features, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->features, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->cluster_features, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->work_dir, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->dependency, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->command, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->work_dir, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->dependency, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->command, &uint32_tmp, buffer);
 
-		safe_unpack32(&job->num_cpus, buffer);
-		safe_unpack32(&job->max_cpus, buffer);
-		safe_unpack32(&job->num_nodes, buffer);
-		safe_unpack32(&job->max_nodes, buffer);
+		safe_unpackvar32(&job->num_cpus, buffer);
+		safe_unpackvar32(&job->max_cpus, buffer);
+		safe_unpackvar32(&job->num_nodes, buffer);
+		safe_unpackvar32(&job->max_nodes, buffer);
 		safe_unpack16(&job->requeue, buffer);
 		safe_unpack16(&job->ntasks_per_node, buffer);
 		safe_unpack16(&job->ntasks_per_tres, buffer);
-		safe_unpack32(&job->num_tasks, buffer);
+		safe_unpackvar32(&job->num_tasks, buffer);
 
 		safe_unpack16(&job->shared, buffer);
-		safe_unpack32(&job->cpu_freq_min, buffer);
-		safe_unpack32(&job->cpu_freq_max, buffer);
-		safe_unpack32(&job->cpu_freq_gov, buffer);
+		safe_unpackvar32(&job->cpu_freq_min, buffer);
+		safe_unpackvar32(&job->cpu_freq_max, buffer);
+		safe_unpackvar32(&job->cpu_freq_gov, buffer);
 
-		safe_unpackstr_xmalloc(&job->cronspec, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->cronspec, &uint32_tmp, buffer);
 
 		/*** unpack pending job details ***/
 		safe_unpack16(&job->contiguous, buffer);
@@ -3734,19 +3810,19 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 		safe_unpack16(&job->cpus_per_task, buffer);
 		safe_unpack16(&job->pn_min_cpus, buffer);
 
-		safe_unpack64(&job->pn_min_memory, buffer);
-		safe_unpack32(&job->pn_min_tmp_disk, buffer);
-		safe_unpackstr_xmalloc(&job->req_nodes, &uint32_tmp, buffer);
+		safe_unpackvar64(&job->pn_min_memory, buffer);
+		safe_unpackvar32(&job->pn_min_tmp_disk, buffer);
+		safe_unpackvarstr_xmalloc(&job->req_nodes, &uint32_tmp, buffer);
 
 		unpack_bit_str_hex_as_inx(&job->req_node_inx, buffer);
 
-		safe_unpackstr_xmalloc(&job->exc_nodes, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->exc_nodes, &uint32_tmp, buffer);
 
 		unpack_bit_str_hex_as_inx(&job->exc_node_inx, buffer);
 
-		safe_unpackstr_xmalloc(&job->std_err, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->std_in, &uint32_tmp, buffer);
-		safe_unpackstr_xmalloc(&job->std_out, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->std_err, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->std_in, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->std_out, &uint32_tmp, buffer);
 
 		if (unpack_multi_core_data(&mc_ptr, buffer, protocol_version))
 			goto unpack_error;
@@ -3761,40 +3837,40 @@ _unpack_job_info_members(job_info_t * job, buf_t *buffer,
 			job->ntasks_per_core = mc_ptr->ntasks_per_core;
 			xfree(mc_ptr);
 		}
-		safe_unpack64(&job->bitflags, buffer);
-		safe_unpackstr_xmalloc(&job->tres_alloc_str, &uint32_tmp,
+		safe_unpackvar64(&job->bitflags, buffer);
+		safe_unpackvarstr_xmalloc(&job->tres_alloc_str, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_req_str, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->tres_req_str, &uint32_tmp, buffer);
 		safe_unpack16(&job->start_protocol_ver, buffer);
 
-		safe_unpackstr_xmalloc(&job->fed_origin_str, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->fed_origin_str, &uint32_tmp,
 				       buffer);
-		safe_unpack64(&job->fed_siblings_active, buffer);
-		safe_unpackstr_xmalloc(&job->fed_siblings_active_str,
+		safe_unpackvar64(&job->fed_siblings_active, buffer);
+		safe_unpackvarstr_xmalloc(&job->fed_siblings_active_str,
 				       &uint32_tmp, buffer);
-		safe_unpack64(&job->fed_siblings_viable, buffer);
-		safe_unpackstr_xmalloc(&job->fed_siblings_viable_str,
+		safe_unpackvar64(&job->fed_siblings_viable, buffer);
+		safe_unpackvarstr_xmalloc(&job->fed_siblings_viable_str,
 				       &uint32_tmp, buffer);
 
-		safe_unpackstr_xmalloc(&job->cpus_per_tres, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->cpus_per_tres, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->mem_per_tres, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->mem_per_tres, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_bind, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->tres_bind, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_freq, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->tres_freq, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_per_job, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->tres_per_job, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_per_node, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->tres_per_node, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_per_socket, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->tres_per_socket, &uint32_tmp,
 				       buffer);
-		safe_unpackstr_xmalloc(&job->tres_per_task, &uint32_tmp,
+		safe_unpackvarstr_xmalloc(&job->tres_per_task, &uint32_tmp,
 				       buffer);
 
 		safe_unpack16(&job->mail_type, buffer);
-		safe_unpackstr_xmalloc(&job->mail_user, &uint32_tmp, buffer);
+		safe_unpackvarstr_xmalloc(&job->mail_user, &uint32_tmp, buffer);
 	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		safe_unpack32(&job->array_job_id, buffer);
 		safe_unpack32(&job->array_task_id, buffer);
@@ -9819,7 +9895,15 @@ static void
 _pack_step_complete_msg(step_complete_msg_t * msg, buf_t *buffer,
 			uint16_t protocol_version)
 {
-	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack_step_id(&msg->step_id, buffer, protocol_version);
+		pack32((uint32_t)msg->range_first, buffer);
+		pack32((uint32_t)msg->range_last, buffer);
+		pack32((uint32_t)msg->step_rc, buffer);
+		jobacctinfo_pack(msg->jobacct, protocol_version,
+				 PROTOCOL_TYPE_SLURM, buffer);
+		pack_bit_str_hex(msg->task_exit_ok, buffer);
+	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		pack_step_id(&msg->step_id, buffer, protocol_version);
 		pack32((uint32_t)msg->range_first, buffer);
 		pack32((uint32_t)msg->range_last, buffer);
@@ -9845,7 +9929,19 @@ _unpack_step_complete_msg(step_complete_msg_t ** msg_ptr, buf_t *buffer,
 	msg = xmalloc(sizeof(step_complete_msg_t));
 	*msg_ptr = msg;
 
-	if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		if (unpack_step_id_members(&msg->step_id, buffer,
+					   protocol_version) != SLURM_SUCCESS)
+			goto unpack_error;
+		safe_unpack32(&msg->range_first, buffer);
+		safe_unpack32(&msg->range_last, buffer);
+		safe_unpack32(&msg->step_rc, buffer);
+		if (jobacctinfo_unpack(&msg->jobacct, protocol_version,
+				       PROTOCOL_TYPE_SLURM, buffer, 1)
+		    != SLURM_SUCCESS)
+			goto unpack_error;
+		unpack_bit_str_hex(&msg->task_exit_ok, buffer);
+	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		if (unpack_step_id_members(&msg->step_id, buffer,
 					   protocol_version) != SLURM_SUCCESS)
 			goto unpack_error;
@@ -9881,6 +9977,47 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Pack a List of uint32_t, NULL is kept apart from an empty List */
+static void _pack_uint32_list(List uint32_list, buf_t *buffer)
+{
+	uint32_t count = NO_VAL, *uint32_ptr;
+	ListIterator itr;
+
+	if (uint32_list)
+		count = list_count(uint32_list);
+	pack32(count, buffer);
+	if (count && (count != NO_VAL)) {
+		itr = list_iterator_create(uint32_list);
+		while ((uint32_ptr = list_next(itr)))
+			pack32(*uint32_ptr, buffer);
+		list_iterator_destroy(itr);
+	}
+}
+
+static int _unpack_uint32_list(List *uint32_list, buf_t *buffer)
+{
+	uint32_t count, i, *uint32_ptr = NULL;
+
+	safe_unpack32(&count, buffer);
+	if (count > NO_VAL)
+		goto unpack_error;
+	if (count != NO_VAL) {
+		*uint32_list = list_create(xfree_ptr);
+		for (i = 0; i < count; i++) {
+			uint32_ptr = xmalloc(sizeof(uint32_t));
+			safe_unpack32(uint32_ptr, buffer);
+			list_append(*uint32_list, uint32_ptr);
+			uint32_ptr = NULL;
+		}
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(uint32_ptr);
+	return SLURM_ERROR;
+}
+
 static void
 _pack_job_info_request_msg(job_info_request_msg_t * msg, buf_t *buffer,
 			   uint16_t protocol_version)
@@ -9891,7 +10028,17 @@ _pack_job_info_request_msg(job_info_request_msg_t * msg, buf_t *buffer,
 	xassert(msg);
 	xassert(buffer);
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack_time(msg->last_update, buffer);
+		pack16((uint16_t)msg->show_flags, buffer);
+		_pack_uint32_list(msg->job_ids, buffer);
+
+		packstr(msg->accounts, buffer);
+		_pack_uint32_list(msg->job_id_list, buffer);
+		packstr(msg->partitions, buffer);
+		_pack_uint32_list(msg->state_list, buffer);
+		_pack_uint32_list(msg->uid_list, buffer);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack_time(msg->last_update, buffer);
 		pack16((uint16_t)msg->show_flags, buffer);
 
@@ -9922,7 +10069,24 @@ _unpack_job_info_request_msg(job_info_request_msg_t** msg,
 	job_info = xmalloc(sizeof(job_info_request_msg_t));
 	*msg = job_info;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		uint32_t uint32_tmp;
+
+		safe_unpack_time(&job_info->last_update, buffer);
+		safe_unpack16(&job_info->show_flags, buffer);
+		if (_unpack_uint32_list(&job_info->job_ids, buffer))
+			goto unpack_error;
+
+		safe_unpackstr_xmalloc(&job_info->accounts, &uint32_tmp,
+				       buffer);
+		if (_unpack_uint32_list(&job_info->job_id_list, buffer))
+			goto unpack_error;
+		safe_unpackstr_xmalloc(&job_info->partitions, &uint32_tmp,
+				       buffer);
+		if (_unpack_uint32_list(&job_info->state_list, buffer) ||
+		    _unpack_uint32_list(&job_info->uid_list, buffer))
+			goto unpack_error;
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack_time(&job_info->last_update, buffer);
 		safe_unpack16(&job_info->show_flags, buffer);
 
@@ -11787,7 +11951,29 @@ static void _pack_file_bcast(file_bcast_msg_t * msg , buf_t *buffer,
 
 	grow_buf(buffer,  msg->block_len);
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack32(msg->block_no, buffer);
+		pack16(msg->compress, buffer);
+		pack16(msg->last_block, buffer);
+		pack16(msg->force, buffer);
+		pack16(msg->modes, buffer);
+
+		pack32(msg->uid, buffer);
+		packstr(msg->user_name, buffer);
+		pack32(msg->gid, buffer);
+
+		pack_time(msg->atime, buffer);
+		pack_time(msg->mtime, buffer);
+
+		packstr(msg->fname, buffer);
+		pack32(msg->block_len, buffer);
+		pack32(msg->uncomp_len, buffer);
+		pack64(msg->block_offset, buffer);
+		pack64(msg->file_hash, buffer);
+		pack64(msg->file_size, buffer);
+		packmem (msg->block, msg->block_len, buffer);
+		pack_sbcast_cred(msg->cred, buffer, protocol_version);
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack32(msg->block_no, buffer);
 		pack16(msg->compress, buffer);
 		pack16(msg->last_block, buffer);
@@ -11822,7 +12008,34 @@ static int _unpack_file_bcast(file_bcast_msg_t ** msg_ptr , buf_t *buffer,
 	msg = xmalloc ( sizeof (file_bcast_msg_t) ) ;
 	*msg_ptr = msg;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->block_no, buffer);
+		safe_unpack16(&msg->compress, buffer);
+		safe_unpack16(&msg->last_block, buffer);
+		safe_unpack16(&msg->force, buffer);
+		safe_unpack16(&msg->modes, buffer);
+
+		safe_unpack32(&msg->uid, buffer);
+		safe_unpackstr_xmalloc(&msg->user_name, &uint32_tmp, buffer);
+		safe_unpack32 (&msg->gid, buffer);
+
+		safe_unpack_time(&msg->atime, buffer);
+		safe_unpack_time(&msg->mtime, buffer);
+
+		safe_unpackstr_xmalloc ( & msg->fname, &uint32_tmp, buffer );
+		safe_unpack32(&msg->block_len, buffer);
+		safe_unpack32(&msg->uncomp_len, buffer);
+		safe_unpack64(&msg->block_offset, buffer);
+		safe_unpack64(&msg->file_hash, buffer);
+		safe_unpack64(&msg->file_size, buffer);
+		safe_unpackmem_xmalloc ( & msg->block, &uint32_tmp , buffer ) ;
+		if ( uint32_tmp != msg->block_len )
+			goto unpack_error;
+
+		msg->cred = unpack_sbcast_cred(buffer, protocol_version);
+		if (msg->cred == NULL)
+			goto unpack_error;
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack32(&msg->block_no, buffer);
 		safe_unpack16(&msg->compress, buffer);
 		safe_unpack16(&msg->last_block, buffer);
@@ -12535,6 +12748,182 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Unpack slurmctld RPC queue statistics from rpc_queue_pack_stats() */
+static int _unpack_rpc_queue_stats(stats_info_response_msg_t *msg,
+				   buf_t *buffer)
+{
+	uint32_t i;
+
+	safe_unpack32(&msg->rpcq_cnt, buffer);
+	if (msg->rpcq_cnt > NO_VAL16)
+		goto unpack_error;
+	msg->rpcq_type_id = xcalloc(msg->rpcq_cnt, sizeof(uint16_t));
+	msg->rpcq_depth = xcalloc(msg->rpcq_cnt, sizeof(uint32_t));
+	msg->rpcq_depth_max = xcalloc(msg->rpcq_cnt, sizeof(uint32_t));
+	msg->rpcq_msg_cnt = xcalloc(msg->rpcq_cnt, sizeof(uint32_t));
+	msg->rpcq_batch_cnt = xcalloc(msg->rpcq_cnt, sizeof(uint32_t));
+	msg->rpcq_batch_max = xcalloc(msg->rpcq_cnt, sizeof(uint32_t));
+	msg->rpcq_wait_sum = xcalloc(msg->rpcq_cnt, sizeof(uint64_t));
+	msg->rpcq_wait_max = xcalloc(msg->rpcq_cnt, sizeof(uint64_t));
+	for (i = 0; i < msg->rpcq_cnt; i++) {
+		safe_unpack16(&msg->rpcq_type_id[i], buffer);
+		safe_unpack32(&msg->rpcq_depth[i], buffer);
+		safe_unpack32(&msg->rpcq_depth_max[i], buffer);
+		safe_unpack32(&msg->rpcq_msg_cnt[i], buffer);
+		safe_unpack32(&msg->rpcq_batch_cnt[i], buffer);
+		safe_unpack32(&msg->rpcq_batch_max[i], buffer);
+		safe_unpack64(&msg->rpcq_wait_sum[i], buffer);
+		safe_unpack64(&msg->rpcq_wait_max[i], buffer);
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+/* Unpack federation sibling agent statistics from fed_mgr_pack_stats() */
+static int _unpack_fed_sib_stats(stats_info_response_msg_t *msg,
+				 buf_t *buffer)
+{
+	uint32_t i, uint32_tmp;
+
+	safe_unpack32(&msg->fed_sib_cnt, buffer);
+	if (msg->fed_sib_cnt > NO_VAL16)
+		goto unpack_error;
+	msg->fed_sib_name = xcalloc(msg->fed_sib_cnt, sizeof(char *));
+	msg->fed_sib_depth = xcalloc(msg->fed_sib_cnt, sizeof(uint32_t));
+	msg->fed_sib_msg_cnt = xcalloc(msg->fed_sib_cnt, sizeof(uint32_t));
+	msg->fed_sib_batch_cnt = xcalloc(msg->fed_sib_cnt, sizeof(uint32_t));
+	msg->fed_sib_batch_max = xcalloc(msg->fed_sib_cnt, sizeof(uint32_t));
+	msg->fed_sib_fail_cnt = xcalloc(msg->fed_sib_cnt, sizeof(uint32_t));
+	msg->fed_sib_lag_sum = xcalloc(msg->fed_sib_cnt, sizeof(uint64_t));
+	msg->fed_sib_lag_max = xcalloc(msg->fed_sib_cnt, sizeof(uint64_t));
+	msg->fed_sib_lag_now = xcalloc(msg->fed_sib_cnt, sizeof(uint64_t));
+	for (i = 0; i < msg->fed_sib_cnt; i++) {
+		safe_unpackstr_xmalloc(&msg->fed_sib_name[i], &uint32_tmp,
+				       buffer);
+		safe_unpack32(&msg->fed_sib_depth[i], buffer);
+		safe_unpack32(&msg->fed_sib_msg_cnt[i], buffer);
+		safe_unpack32(&msg->fed_sib_batch_cnt[i], buffer);
+		safe_unpack32(&msg->fed_sib_batch_max[i], buffer);
+		safe_unpack32(&msg->fed_sib_fail_cnt[i], buffer);
+		safe_unpack64(&msg->fed_sib_lag_sum[i], buffer);
+		safe_unpack64(&msg->fed_sib_lag_max[i], buffer);
+		safe_unpack64(&msg->fed_sib_lag_now[i], buffer);
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+/* Unpack slurmctld RPC latency statistics from _pack_rpc_latency() */
+static int _unpack_rpc_latency(stats_info_response_msg_t *msg, buf_t *buffer)
+{
+	uint32_t i;
+	int j;
+
+	safe_unpack32(&msg->rpc_lat_window, buffer);
+	safe_unpack32(&msg->rpc_lat_cnt, buffer);
+	if (msg->rpc_lat_cnt > NO_VAL16)
+		goto unpack_error;
+	msg->rpc_lat_type_id = xcalloc(msg->rpc_lat_cnt, sizeof(uint16_t));
+	msg->rpc_lat_exec = xcalloc(msg->rpc_lat_cnt * 4, sizeof(uint32_t));
+	msg->rpc_lat_wait = xcalloc(msg->rpc_lat_cnt * 4, sizeof(uint32_t));
+	msg->rpc_lat_wait_sum = xcalloc(msg->rpc_lat_cnt, sizeof(uint64_t));
+	for (i = 0; i < msg->rpc_lat_cnt; i++) {
+		safe_unpack16(&msg->rpc_lat_type_id[i], buffer);
+		for (j = 0; j < 4; j++)
+			safe_unpack32(&msg->rpc_lat_exec[(i * 4) + j], buffer);
+		for (j = 0; j < 4; j++)
+			safe_unpack32(&msg->rpc_lat_wait[(i * 4) + j], buffer);
+		safe_unpack64(&msg->rpc_lat_wait_sum[i], buffer);
+	}
+
+	safe_unpack64(&msg->rpc_delay_cnt, buffer);
+	safe_unpack64(&msg->rpc_delay_sum, buffer);
+	for (j = 0; j < 4; j++)
+		safe_unpack32(&msg->rpc_delay[j], buffer);
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	return SLURM_ERROR;
+}
+
+/* Unpack slurmctld lock statistics from pack_lock_stats() */
+static int _unpack_lock_stats(stats_info_response_msg_t *msg, buf_t *buffer)
+{
+	uint32_t i, hist_cnt, uint32_tmp;
+	uint64_t *hist = NULL;
+
+	safe_unpack32(&msg->lock_stats_cnt, buffer);
+	safe_unpack32(&msg->lock_hist_cnt, buffer);
+	if ((msg->lock_stats_cnt > NO_VAL16) || (msg->lock_hist_cnt > NO_VAL16))
+		goto unpack_error;
+	hist_cnt = msg->lock_hist_cnt;
+
+	msg->lock_name = xcalloc(msg->lock_stats_cnt, sizeof(char *));
+	msg->lock_count = xcalloc(msg->lock_stats_cnt, sizeof(uint64_t));
+	msg->lock_wait_sum = xcalloc(msg->lock_stats_cnt, sizeof(uint64_t));
+	msg->lock_wait_max = xcalloc(msg->lock_stats_cnt, sizeof(uint64_t));
+	msg->lock_wait_hist = xcalloc(msg->lock_stats_cnt * hist_cnt,
+				      sizeof(uint64_t));
+	msg->lock_hold_sum = xcalloc(msg->lock_stats_cnt, sizeof(uint64_t));
+	msg->lock_hold_max = xcalloc(msg->lock_stats_cnt, sizeof(uint64_t));
+	msg->lock_hold_hist = xcalloc(msg->lock_stats_cnt * hist_cnt,
+				      sizeof(uint64_t));
+	for (i = 0; i < msg->lock_stats_cnt; i++) {
+		safe_unpackstr_xmalloc(&msg->lock_name[i], &uint32_tmp, buffer);
+		safe_unpack64(&msg->lock_count[i], buffer);
+		safe_unpack64(&msg->lock_wait_sum[i], buffer);
+		safe_unpack64(&msg->lock_wait_max[i], buffer);
+		safe_unpack64_array(&hist, &uint32_tmp, buffer);
+		if (uint32_tmp != hist_cnt)
+			goto unpack_error;
+		memcpy(&msg->lock_wait_hist[i * hist_cnt], hist,
+		       sizeof(uint64_t) * hist_cnt);
+		xfree(hist);
+		safe_unpack64(&msg->lock_hold_sum[i], buffer);
+		safe_unpack64(&msg->lock_hold_max[i], buffer);
+		safe_unpack64_array(&hist, &uint32_tmp, buffer);
+		if (uint32_tmp != hist_cnt)
+			goto unpack_error;
+		memcpy(&msg->lock_hold_hist[i * hist_cnt], hist,
+		       sizeof(uint64_t) * hist_cnt);
+		xfree(hist);
+	}
+
+	safe_unpack32(&msg->lock_holder_cnt, buffer);
+	if (msg->lock_holder_cnt > NO_VAL16)
+		goto unpack_error;
+	msg->lock_holder_caller = xcalloc(msg->lock_holder_cnt, sizeof(char *));
+	msg->lock_holder_rpc_type = xcalloc(msg->lock_holder_cnt,
+					    sizeof(uint16_t));
+	msg->lock_holder_count = xcalloc(msg->lock_holder_cnt,
+					 sizeof(uint64_t));
+	msg->lock_holder_hold_sum = xcalloc(msg->lock_holder_cnt,
+					    sizeof(uint64_t));
+	msg->lock_holder_hold_max = xcalloc(msg->lock_holder_cnt,
+					    sizeof(uint64_t));
+	for (i = 0; i < msg->lock_holder_cnt; i++) {
+		safe_unpackstr_xmalloc(&msg->lock_holder_caller[i],
+				       &uint32_tmp, buffer);
+		safe_unpack16(&msg->lock_holder_rpc_type[i], buffer);
+		safe_unpack64(&msg->lock_holder_count[i], buffer);
+		safe_unpack64(&msg->lock_holder_hold_sum[i], buffer);
+		safe_unpack64(&msg->lock_holder_hold_max[i], buffer);
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	xfree(hist);
+	return SLURM_ERROR;
+}
+
 static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				       buf_t *buffer, uint16_t protocol_version)
 {
@@ -12592,6 +12981,18 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 
 			safe_unpack32(&msg->bf_active,		buffer);
 			safe_unpack32(&msg->bf_backfilled_het_jobs, buffer);
+
+			if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+				safe_unpack32(&msg->agent_merge_count, buffer);
+
+				safe_unpack64(&msg->schedule_queue_build_sum,
+					      buffer);
+				safe_unpack64(&msg->schedule_select_sum,
+					      buffer);
+				safe_unpack64(&msg->bf_queue_build_sum, buffer);
+				safe_unpack64(&msg->bf_select_sum, buffer);
+				safe_unpack64(&msg->bf_yield_sum, buffer);
+			}
 		}
 
 		safe_unpack32(&msg->rpc_type_size,		buffer);
@@ -12620,6 +13021,14 @@ static int  _unpack_stats_response_msg(stats_info_response_msg_t **msg_ptr,
 				     buffer);
 		if (uint32_tmp != msg->rpc_dump_count)
 			goto unpack_error;
+
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			if (_unpack_lock_stats(msg, buffer) ||
+			    _unpack_rpc_queue_stats(msg, buffer) ||
+			    _unpack_fed_sib_stats(msg, buffer) ||
+			    _unpack_rpc_latency(msg, buffer))
+				goto unpack_error;
+		}
 	} else {
 		error("%s: protocol_version %hu not supported",
 		      __func__, protocol_version);
@@ -12767,6 +13176,64 @@ static void _pack_job_array_resp_msg(job_array_resp_msg_t *msg, buf_t *buffer,
 		packstr(msg->job_array_id[i], buffer);
 	}
 }
+static void _pack_submit_response_list_msg(submit_response_list_msg_t *msg,
+					   buf_t *buffer,
+					   uint16_t protocol_version)
+{
+	uint32_t i;
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		pack32(msg->job_cnt, buffer);
+		for (i = 0; i < msg->job_cnt; i++) {
+			pack32(msg->job_id[i], buffer);
+			pack32(msg->error_code[i], buffer);
+			packstr(msg->job_submit_user_msg[i], buffer);
+		}
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+	}
+}
+
+static int _unpack_submit_response_list_msg(submit_response_list_msg_t **msg,
+					    buf_t *buffer,
+					    uint16_t protocol_version)
+{
+	submit_response_list_msg_t *resp;
+	uint32_t i, uint32_tmp;
+
+	resp = xmalloc(sizeof(submit_response_list_msg_t));
+	*msg = resp;
+
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack32(&resp->job_cnt, buffer);
+		if (resp->job_cnt > NO_VAL)
+			goto unpack_error;
+		safe_xcalloc(resp->job_id, resp->job_cnt, sizeof(uint32_t));
+		safe_xcalloc(resp->error_code, resp->job_cnt,
+			     sizeof(uint32_t));
+		safe_xcalloc(resp->job_submit_user_msg, resp->job_cnt,
+			     sizeof(char *));
+		for (i = 0; i < resp->job_cnt; i++) {
+			safe_unpack32(&resp->job_id[i], buffer);
+			safe_unpack32(&resp->error_code[i], buffer);
+			safe_unpackstr_xmalloc(&resp->job_submit_user_msg[i],
+					       &uint32_tmp, buffer);
+		}
+	} else {
+		error("%s: protocol_version %hu not supported",
+		      __func__, protocol_version);
+		goto unpack_error;
+	}
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_submit_response_list_msg(resp);
+	*msg = NULL;
+	return SLURM_ERROR;
+}
+
 static int  _unpack_job_array_resp_msg(job_array_resp_msg_t **msg, buf_t *buffer,
 				       uint16_t protocol_version)
 {
@@ -12973,6 +13440,146 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+static void _pack_event_info_request_msg(event_info_request_msg_t *msg,
+					 buf_t *buffer,
+					 uint16_t protocol_version)
+{
+	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+		pack64(msg->seq, buffer);
+		pack16(msg->wait, buffer);
+	}
+}
+
+static int _unpack_event_info_request_msg(event_info_request_msg_t **msg_ptr,
+					  buf_t *buffer,
+					  uint16_t protocol_version)
+{
+	event_info_request_msg_t *msg;
+
+	msg = xmalloc(sizeof(event_info_request_msg_t));
+	*msg_ptr = msg;
+
+	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+		safe_unpack64(&msg->seq, buffer);
+		safe_unpack16(&msg->wait, buffer);
+	} else
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_event_info_request_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+/*
+ * NOTE: event_mgr_pack() in slurmctld/event_mgr.c packs the message unpacked
+ * here
+ */
+static int _unpack_event_info_msg(event_info_msg_t **msg_ptr, buf_t *buffer,
+				  uint16_t protocol_version)
+{
+	int i;
+	uint32_t uint32_tmp;
+	event_info_msg_t *msg;
+	event_info_t *event;
+
+	msg = xmalloc(sizeof(event_info_msg_t));
+	*msg_ptr = msg;
+
+	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->record_count, buffer);
+		safe_unpackbool(&msg->lost, buffer);
+		safe_unpack64(&msg->next_seq, buffer);
+		safe_xcalloc(msg->event_array, msg->record_count,
+			     sizeof(event_info_t));
+		for (i = 0, event = msg->event_array; i < msg->record_count;
+		     i++, event++) {
+			safe_unpack64(&event->seq, buffer);
+			safe_unpack16(&event->type, buffer);
+			safe_unpack_time(&event->time, buffer);
+			safe_unpack32(&event->state, buffer);
+			safe_unpack32(&event->job_id, buffer);
+			safe_unpack32(&event->user_id, buffer);
+			safe_unpackstr_xmalloc(&event->name, &uint32_tmp,
+					       buffer);
+		}
+	} else
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_event_info_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
+static void _pack_sched_trace_msg(sched_trace_msg_t *msg, buf_t *buffer,
+				  uint16_t protocol_version)
+{
+	int i;
+	sched_trace_rec_t *rec;
+
+	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+		pack32(msg->job_id, buffer);
+		pack32(msg->attempts, buffer);
+		pack64(msg->total_usec, buffer);
+		pack32(msg->record_count, buffer);
+		for (i = 0, rec = msg->trace_array; i < msg->record_count;
+		     i++, rec++) {
+			pack_time(rec->time, buffer);
+			pack16(rec->scheduler, buffer);
+			pack32(rec->reason, buffer);
+			pack32(rec->error_code, buffer);
+			pack32(rec->total_usec, buffer);
+			pack32(rec->select_usec, buffer);
+			pack32(rec->acct_usec, buffer);
+			pack32(rec->resv_usec, buffer);
+		}
+	}
+}
+
+static int _unpack_sched_trace_msg(sched_trace_msg_t **msg_ptr,
+				   buf_t *buffer, uint16_t protocol_version)
+{
+	int i;
+	sched_trace_msg_t *msg;
+	sched_trace_rec_t *rec;
+
+	msg = xmalloc(sizeof(sched_trace_msg_t));
+	*msg_ptr = msg;
+
+	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+		safe_unpack32(&msg->job_id, buffer);
+		safe_unpack32(&msg->attempts, buffer);
+		safe_unpack64(&msg->total_usec, buffer);
+		safe_unpack32(&msg->record_count, buffer);
+		safe_xcalloc(msg->trace_array, msg->record_count,
+			     sizeof(sched_trace_rec_t));
+		for (i = 0, rec = msg->trace_array; i < msg->record_count;
+		     i++, rec++) {
+			safe_unpack_time(&rec->time, buffer);
+			safe_unpack16(&rec->scheduler, buffer);
+			safe_unpack32(&rec->reason, buffer);
+			safe_unpack32(&rec->error_code, buffer);
+			safe_unpack32(&rec->total_usec, buffer);
+			safe_unpack32(&rec->select_usec, buffer);
+			safe_unpack32(&rec->acct_usec, buffer);
+			safe_unpack32(&rec->resv_usec, buffer);
+		}
+	} else
+		goto unpack_error;
+
+	return SLURM_SUCCESS;
+
+unpack_error:
+	slurm_free_sched_trace_msg(msg);
+	*msg_ptr = NULL;
+	return SLURM_ERROR;
+}
+
 static void _pack_set_fs_dampening_factor_msg(
 	set_fs_dampening_factor_msg_t *msg,
 	buf_t *buffer, uint16_t protocol_version)
@@ -13211,6 +13818,34 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* pack_msg_prepacked
+ * IN msg - the message to check
+ * RET true if the message body is an already packed buffer (msg->data of
+ *	msg->data_size bytes) which pack_msg() would copy verbatim
+ */
+extern bool pack_msg_prepacked(slurm_msg_t const *msg)
+{
+	if (msg->protocol_version < SLURM_MIN_PROTOCOL_VERSION)
+		return false;
+
+	switch (msg->msg_type) {
+	case RESPONSE_ASSOC_MGR_INFO:
+	case RESPONSE_BURST_BUFFER_INFO:
+	case RESPONSE_FRONT_END_INFO:
+	case RESPONSE_JOB_INFO:
+	case RESPONSE_JOB_STEP_INFO:
+	case RESPONSE_LICENSE_INFO:
+	case RESPONSE_NODE_INFO:
+	case RESPONSE_PARTITION_INFO:
+	case RESPONSE_RESERVATION_INFO:
+	case RESPONSE_STATS_INFO:
+	case RESPONSE_EVENT_INFO:
+		return true;
+	default:
+		return false;
+	}
+}
+
 /* pack_msg
  * packs a generic slurm protocol message body
  * IN msg - the body structure to pack (note: includes message type)
@@ -13292,9 +13927,15 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
 		_pack_job_desc_list_msg((List) msg->data, buffer,
 					msg->protocol_version);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		_pack_submit_response_list_msg(
+			(submit_response_list_msg_t *) msg->data, buffer,
+			msg->protocol_version);
+		break;
 	case RESPONSE_HET_JOB_ALLOCATION:
 		_pack_job_info_list_msg((List) msg->data, buffer,
 					msg->protocol_version);
@@ -13649,6 +14290,7 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 	case REQUEST_BATCH_SCRIPT:
 	case REQUEST_JOB_READY:
 	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_JOB_SCHED_TRACE:
 		_pack_job_ready_msg((job_id_msg_t *)msg->data, buffer,
 				    msg->protocol_version);
 		break;
@@ -13819,6 +14461,18 @@ pack_msg(slurm_msg_t const *msg, buf_t *buffer)
 			(set_fs_dampening_factor_msg_t *)msg->data, buffer,
 			msg->protocol_version);
 		break;
+	case REQUEST_EVENT_INFO:
+		_pack_event_info_request_msg(
+			(event_info_request_msg_t *) msg->data, buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_EVENT_INFO:
+		_pack_event_info_msg((slurm_msg_t *) msg, buffer);
+		break;
+	case RESPONSE_JOB_SCHED_TRACE:
+		_pack_sched_trace_msg((sched_trace_msg_t *) msg->data, buffer,
+				      msg->protocol_version);
+		break;
 	case RESPONSE_CONTROL_STATUS:
 		_pack_control_status_msg((control_status_msg_t *)(msg->data),
 					 buffer, msg->protocol_version);
@@ -13937,9 +14591,15 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 		break;
 	case REQUEST_HET_JOB_ALLOCATION:
 	case REQUEST_SUBMIT_BATCH_HET_JOB:
+	case REQUEST_SUBMIT_BATCH_JOB_LIST:
 		rc = _unpack_job_desc_list_msg((List *) &(msg->data),
 					       buffer, msg->protocol_version);
 		break;
+	case RESPONSE_SUBMIT_BATCH_JOB_LIST:
+		rc = _unpack_submit_response_list_msg(
+			(submit_response_list_msg_t **) &(msg->data), buffer,
+			msg->protocol_version);
+		break;
 	case RESPONSE_HET_JOB_ALLOCATION:
 		rc = _unpack_job_info_list_msg((List *) &(msg->data),
 					       buffer, msg->protocol_version);
@@ -14321,6 +14981,7 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 	case REQUEST_BATCH_SCRIPT:
 	case REQUEST_JOB_READY:
 	case REQUEST_JOB_INFO_SINGLE:
+	case REQUEST_JOB_SCHED_TRACE:
 		rc = _unpack_job_ready_msg((job_id_msg_t **)
 					   & msg->data, buffer,
 					   msg->protocol_version);
@@ -14514,6 +15175,21 @@ unpack_msg(slurm_msg_t * msg, buf_t *buffer)
 			(set_fs_dampening_factor_msg_t **)&(msg->data), buffer,
 			msg->protocol_version);
 		break;
+	case REQUEST_EVENT_INFO:
+		rc = _unpack_event_info_request_msg(
+			(event_info_request_msg_t **) &msg->data, buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_EVENT_INFO:
+		rc = _unpack_event_info_msg(
+			(event_info_msg_t **) &msg->data, buffer,
+			msg->protocol_version);
+		break;
+	case RESPONSE_JOB_SCHED_TRACE:
+		rc = _unpack_sched_trace_msg(
+			(sched_trace_msg_t **) &msg->data, buffer,
+			msg->protocol_version);
+		break;
 	case RESPONSE_CONTROL_STATUS:
 		rc = _unpack_control_status_msg(
 			(control_status_msg_t **)&(msg->data), buffer,
@@ -80,6 +80,14 @@ extern int unpack_header(header_t *header, buf_t *buffer);
  */
 extern int pack_msg(slurm_msg_t const *msg, buf_t *buffer);
 
+/*
+ * IN msg - the message to check
+ * RET true if the message body is an already packed buffer (msg->data of
+ *	msg->data_size bytes) which pack_msg() would copy verbatim, letting
+ *	the sender transmit it in place rather than copying it
+ */
+extern bool pack_msg_prepacked(slurm_msg_t const *msg);
+
 /*
  * unpacks a generic slurm protocol message body
  * OUT msg - the body structure to unpack (note: includes message type)
@@ -94,6 +102,16 @@ extern int slurm_pack_list(List send_list,
 						  uint16_t rpc_version,
 						  buf_t *buffer),
 			   buf_t *buffer, uint16_t protocol_version);
+/*
+ * Same as slurm_pack_list() but each item is removed from send_list, and
+ * destroyed, once packed. That way a large list is never held twice, once as
+ * items and once packed.
+ */
+extern int slurm_pack_list_consume(List send_list,
+				   void (*pack_function) (void *object,
+							  uint16_t rpc_version,
+							  buf_t *buffer),
+				   buf_t *buffer, uint16_t protocol_version);
 extern int slurm_unpack_list(List *recv_list,
 			     int (*unpack_function) (void **object,
 						     uint16_t protocol_version,
@@ -80,6 +80,8 @@
 
 
 /* Static functions */
+static int _send_iov_timeout(int fd, struct iovec *iov, int iov_cnt,
+			     uint32_t flags, int timeout);
 static int _slurm_connect(int __fd, struct sockaddr const * __addr,
 			  socklen_t __len);
 
@@ -171,29 +173,51 @@ extern ssize_t slurm_msg_sendto(int fd, char *buffer, size_t size)
 ssize_t slurm_msg_sendto_timeout(int fd, char *buffer,
 				 size_t size, int timeout)
 {
-	int   len;
+	struct iovec iov;
+
+	iov.iov_base = buffer;
+	iov.iov_len = size;
+
+	return slurm_msg_sendv_timeout(fd, &iov, 1, timeout);
+}
+
+extern ssize_t slurm_msg_sendv(int fd, struct iovec *iov, int iov_cnt)
+{
+	return slurm_msg_sendv_timeout(fd, iov, iov_cnt,
+				       (slurm_conf.msg_timeout * 1000));
+}
+
+extern ssize_t slurm_msg_sendv_timeout(int fd, struct iovec *iov,
+				       int iov_cnt, int timeout)
+{
+	int   i, len;
 	uint32_t usize;
+	size_t size = 0;
+	struct iovec *send_iov;
 	SigFunc *ohandler;
 
+	/* Length prefix, then the pieces, sent without copying them */
+	send_iov = xcalloc(iov_cnt + 1, sizeof(struct iovec));
+	for (i = 0; i < iov_cnt; i++) {
+		send_iov[i + 1] = iov[i];
+		size += iov[i].iov_len;
+	}
+	usize = htonl(size);
+	send_iov[0].iov_base = &usize;
+	send_iov[0].iov_len = sizeof(usize);
+
 	/*
 	 *  Ignore SIGPIPE so that send can return a error code if the
 	 *    other side closes the socket
 	 */
 	ohandler = xsignal(SIGPIPE, SIG_IGN);
 
-	usize = htonl(size);
-
-	if ((len = slurm_send_timeout(
-				fd, (char *)&usize, sizeof(usize), 0,
-				timeout)) < 0)
-		goto done;
-
-	if ((len = slurm_send_timeout(fd, buffer, size, 0, timeout)) < 0)
-		goto done;
+	len = _send_iov_timeout(fd, send_iov, iov_cnt + 1, 0, timeout);
+	if (len >= 0)
+		len -= sizeof(usize);
 
-
-     done:
 	xsignal(SIGPIPE, ohandler);
+	xfree(send_iov);
 	return len;
 }
 
@@ -201,15 +225,38 @@ ssize_t slurm_msg_sendto_timeout(int fd, char *buffer,
  * RET message size (as specified in argument) or SLURM_ERROR on error */
 extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      uint32_t flags, int timeout)
+{
+	struct iovec iov;
+
+	iov.iov_base = buf;
+	iov.iov_len = size;
+
+	return _send_iov_timeout(fd, &iov, 1, flags, timeout);
+}
+
+/*
+ * Send the contents of an iovec array with timeout, iov is modified
+ * RET total size of the iovec array or SLURM_ERROR on error
+ */
+static int _send_iov_timeout(int fd, struct iovec *iov, int iov_cnt,
+			     uint32_t flags, int timeout)
 {
 	int rc;
 	int sent = 0;
-	int fd_flags;
+	size_t size = 0;
+	int fd_flags, i;
 	struct pollfd ufds;
 	struct timeval tstart;
+	struct msghdr msg;
 	int timeleft = timeout;
 	char temp[2];
 
+	for (i = 0; i < iov_cnt; i++)
+		size += iov[i].iov_len;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = iov_cnt;
+
 	ufds.fd     = fd;
 	ufds.events = POLLOUT;
 
@@ -274,7 +321,7 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 			      ufds.revents);
 		}
 
-		rc = send(fd, &buf[sent], (size - sent), flags);
+		rc = sendmsg(fd, &msg, flags);
 		if (rc < 0) {
  			if (errno == EINTR)
 				continue;
@@ -300,6 +347,20 @@ extern int slurm_send_timeout(int fd, char *buf, size_t size,
 		}
 
 		sent += rc;
+
+		/* Skip over what was sent, pieces may be partly sent */
+		while (rc && msg.msg_iovlen) {
+			if (rc >= msg.msg_iov->iov_len) {
+				rc -= msg.msg_iov->iov_len;
+				msg.msg_iov++;
+				msg.msg_iovlen--;
+			} else {
+				msg.msg_iov->iov_base =
+					(char *) msg.msg_iov->iov_base + rc;
+				msg.msg_iov->iov_len -= rc;
+				rc = 0;
+			}
+		}
 	}
 
     done:
@@ -211,6 +211,7 @@ extern slurm_step_layout_t *slurm_step_layout_copy(
 	layout = xmalloc(sizeof(slurm_step_layout_t));
 	layout->node_list = xstrdup(step_layout->node_list);
 	layout->node_cnt = step_layout->node_cnt;
+	layout->plane_size = step_layout->plane_size;
 	layout->start_protocol_ver = step_layout->start_protocol_ver;
 	layout->task_cnt = step_layout->task_cnt;
 	layout->task_dist = step_layout->task_dist;
@@ -280,12 +281,70 @@ extern void slurm_step_layout_merge(slurm_step_layout_t *step_layout1,
 	hostlist_destroy(hl);
 }
 
+/*
+ * Return true if the task ids are first, first + stride, first + 2 * stride,
+ * etc., as laid out by the block, cyclic and plane distributions
+ */
+static bool _tids_stride(uint32_t *tids, uint32_t cnt, uint32_t *stride)
+{
+	uint32_t i;
+
+	*stride = 0;
+	if (cnt < 2)
+		return true;
+	if (tids[1] <= tids[0])
+		return false;
+	*stride = tids[1] - tids[0];
+	for (i = 2; i < cnt; i++) {
+		if ((tids[i] - tids[i - 1]) != *stride)
+			return false;
+	}
+
+	return true;
+}
+
 extern void pack_slurm_step_layout(slurm_step_layout_t *step_layout,
 				   buf_t *buffer, uint16_t protocol_version)
 {
-	uint32_t i = 0;
+	uint32_t i = 0, j, stride;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		if (step_layout)
+			i = 1;
+
+		pack16(i, buffer);
+		if (!i)
+			return;
+		packstr(step_layout->front_end, buffer);
+		packstr(step_layout->node_list, buffer);
+		pack32(step_layout->node_cnt, buffer);
+		pack16(step_layout->start_protocol_ver, buffer);
+		pack32(step_layout->task_cnt, buffer);
+		pack32(step_layout->task_dist, buffer);
+
+		/*
+		 * Task ids in arithmetic progression, which is every node's
+		 * unless over-subscribed or from an arbitrary distribution,
+		 * are packed as the first id and the stride.
+		 */
+		for (i = 0; i < step_layout->node_cnt; i++) {
+			uint32_t *tids = step_layout->tids[i];
+			uint32_t cnt = step_layout->tasks[i];
+
+			packvar32(cnt, buffer);
+			if (!cnt)
+				continue;
+			if (_tids_stride(tids, cnt, &stride)) {
+				pack8(1, buffer);
+				packvar32(tids[0], buffer);
+				packvar32(stride, buffer);
+			} else {
+				pack8(0, buffer);
+				for (j = 0; j < cnt; j++)
+					packvar32(tids[j], buffer);
+			}
+		}
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		if (step_layout)
 			i = 1;
 
@@ -314,11 +373,54 @@ extern int unpack_slurm_step_layout(slurm_step_layout_t **layout, buf_t *buffer,
 				    uint16_t protocol_version)
 {
 	uint16_t uint16_tmp;
-	uint32_t num_tids;
+	uint32_t num_tids, first, stride, j;
+	uint8_t strided;
 	slurm_step_layout_t *step_layout = NULL;
 	int i;
 
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		safe_unpack16(&uint16_tmp, buffer);
+		if (!uint16_tmp)
+			return SLURM_SUCCESS;
+
+		step_layout = xmalloc(sizeof(slurm_step_layout_t));
+		*layout = step_layout;
+
+		safe_unpackstr(&step_layout->front_end, buffer);
+		safe_unpackstr(&step_layout->node_list, buffer);
+		safe_unpack32(&step_layout->node_cnt, buffer);
+		safe_unpack16(&step_layout->start_protocol_ver, buffer);
+		safe_unpack32(&step_layout->task_cnt, buffer);
+		safe_unpack32(&step_layout->task_dist, buffer);
+
+		safe_xcalloc(step_layout->tasks, step_layout->node_cnt,
+			     sizeof(uint32_t));
+		safe_xcalloc(step_layout->tids, step_layout->node_cnt,
+			     sizeof(uint32_t *));
+		for (i = 0; i < step_layout->node_cnt; i++) {
+			safe_unpackvar32(&num_tids, buffer);
+			if (num_tids > step_layout->task_cnt)
+				goto unpack_error;
+			step_layout->tasks[i] = num_tids;
+			if (!num_tids)
+				continue;
+			step_layout->tids[i] = xcalloc(num_tids,
+						       sizeof(uint32_t));
+			safe_unpack8(&strided, buffer);
+			if (strided) {
+				safe_unpackvar32(&first, buffer);
+				safe_unpackvar32(&stride, buffer);
+				for (j = 0; j < num_tids; j++)
+					step_layout->tids[i][j] =
+						first + (j * stride);
+			} else {
+				for (j = 0; j < num_tids; j++)
+					safe_unpackvar32(
+						&step_layout->tids[i][j],
+						buffer);
+			}
+		}
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		safe_unpack16(&uint16_tmp, buffer);
 		if (!uint16_tmp)
 			return SLURM_SUCCESS;
@@ -375,11 +477,39 @@ extern int slurm_step_layout_destroy(slurm_step_layout_t *step_layout)
 	return SLURM_SUCCESS;
 }
 
+static int _cmp_tid(const void *a, const void *b)
+{
+	uint32_t tid1 = *(uint32_t *) a, tid2 = *(uint32_t *) b;
+
+	if (tid1 < tid2)
+		return -1;
+	if (tid1 > tid2)
+		return 1;
+	return 0;
+}
+
 int slurm_step_layout_host_id (slurm_step_layout_t *s, int taskid)
 {
 	int i, j;
+	uint32_t tid = taskid;
+
 	if (!s->tasks || !s->tids || (taskid > s->task_cnt - 1))
 		return SLURM_ERROR;
+
+	/*
+	 * Every distribution lays out each node's task ids in increasing
+	 * order, so search the node whose range holds the task. Layouts
+	 * built otherwise are searched in full below.
+	 */
+	for (i = 0; i < s->node_cnt; i++) {
+		if (!s->tasks[i] || (tid < s->tids[i][0]) ||
+		    (tid > s->tids[i][s->tasks[i] - 1]))
+			continue;
+		if (bsearch(&tid, s->tids[i], s->tasks[i], sizeof(uint32_t),
+			    _cmp_tid))
+			return i;
+	}
+
 	for (i = 0; i < s->node_cnt; i++)
 		for (j = 0; j < s->tasks[i]; j++)
 			if (s->tids[i][j] == taskid)
@@ -519,15 +649,16 @@ static int _init_task_layout(slurm_step_layout_req_t *step_layout_req,
 static int _task_layout_hostfile(slurm_step_layout_t *step_layout,
 				 const char *arbitrary_nodes)
 {
-	int i=0, j, taskid = 0, task_cnt=0;
+	int i=0, j, taskid = 0, task_cnt=0, inx;
 	hostlist_iterator_t itr = NULL, itr_task = NULL;
 	char *host = NULL;
 
 	hostlist_t job_alloc_hosts = NULL;
 	hostlist_t step_alloc_hosts = NULL;
 
-	int step_inx = 0, step_hosts_cnt = 0;
-	node_record_t **step_hosts_ptrs = NULL;
+	int step_hosts_cnt = 0;
+	uint32_t *node_tids_offset = NULL, *node_tids = NULL;
+	int *step_hosts_inx = NULL;
 	node_record_t *host_ptr = NULL;
 
 	debug2("job list is %s", step_layout->node_list);
@@ -553,48 +684,52 @@ static int _task_layout_hostfile(slurm_step_layout_t *step_layout,
 	itr_task        = hostlist_iterator_create(step_alloc_hosts);
 
 	/*
-	 * Build array of pointers so that we can do pointer comparisons rather
-	 * than strcmp's on nodes.
+	 * Bucket the task ids by node table index, so each allocated node
+	 * finds its tasks directly rather than by comparing against every
+	 * task's node. Tasks on hosts without a node record share the last
+	 * bucket, as they all matched a NULL node record before.
 	 */
 	step_hosts_cnt  = hostlist_count(step_alloc_hosts);
-	step_hosts_ptrs = xcalloc(step_hosts_cnt,
-				  sizeof(node_record_t *));
+	step_hosts_inx = xcalloc(step_hosts_cnt, sizeof(int));
+	node_tids_offset = xcalloc(node_record_count + 2, sizeof(uint32_t));
+	node_tids = xcalloc(step_hosts_cnt, sizeof(uint32_t));
 
-	step_inx = 0;
+	taskid = 0;
 	while((host = hostlist_next(itr_task))) {
-		step_hosts_ptrs[step_inx++] = find_node_record_no_alias(host);
+		host_ptr = find_node_record_no_alias(host);
+		inx = host_ptr ? (host_ptr - node_record_table_ptr) :
+				 node_record_count;
+		step_hosts_inx[taskid++] = inx;
+		node_tids_offset[inx + 1]++;
 		free(host);
 	}
+	for (inx = 0; inx <= node_record_count; inx++)
+		node_tids_offset[inx + 1] += node_tids_offset[inx];
+	for (taskid = 0; taskid < step_hosts_cnt; taskid++) {
+		inx = step_hosts_inx[taskid];
+		node_tids[node_tids_offset[inx]++] = taskid;
+	}
+	/* Shift the offsets back to the start of each bucket */
+	for (inx = node_record_count; inx > 0; inx--)
+		node_tids_offset[inx] = node_tids_offset[inx - 1];
+	node_tids_offset[0] = 0;
 
 	while((host = hostlist_next(itr))) {
 		host_ptr = find_node_record(host);
-		step_layout->tasks[i] = 0;
-
-		for (step_inx = 0; step_inx < step_hosts_cnt; step_inx++) {
-			if (host_ptr == step_hosts_ptrs[step_inx]) {
-				step_layout->tasks[i]++;
-				task_cnt++;
-			}
-			if (task_cnt >= step_layout->task_cnt)
-				break;
-		}
+		inx = host_ptr ? (host_ptr - node_record_table_ptr) :
+				 node_record_count;
+		step_layout->tasks[i] = MIN(node_tids_offset[inx + 1] -
+					    node_tids_offset[inx],
+					    step_layout->task_cnt - task_cnt);
+		task_cnt += step_layout->tasks[i];
 		debug3("%s got %u tasks", host, step_layout->tasks[i]);
 		if (step_layout->tasks[i] == 0)
 			goto reset_hosts;
 		step_layout->tids[i] = xcalloc(step_layout->tasks[i],
 					       sizeof(uint32_t));
-		taskid = 0;
-		j = 0;
-
-		for (step_inx = 0; step_inx < step_hosts_cnt; step_inx++) {
-			if (host_ptr == step_hosts_ptrs[step_inx]) {
-				step_layout->tids[i][j] = taskid;
-				j++;
-			}
-			taskid++;
-			if (j >= step_layout->tasks[i])
-				break;
-		}
+		for (j = 0; j < step_layout->tasks[i]; j++)
+			step_layout->tids[i][j] =
+				node_tids[node_tids_offset[inx] + j];
 		i++;
 	reset_hosts:
 		free(host);
@@ -605,7 +740,9 @@ static int _task_layout_hostfile(slurm_step_layout_t *step_layout,
 	hostlist_iterator_destroy(itr_task);
 	hostlist_destroy(job_alloc_hosts);
 	hostlist_destroy(step_alloc_hosts);
-	xfree(step_hosts_ptrs);
+	xfree(step_hosts_inx);
+	xfree(node_tids_offset);
+	xfree(node_tids);
 
 	if (task_cnt != step_layout->task_cnt) {
 		error("Asked for %u tasks but placed %d. Check your nodelist",
@@ -713,8 +850,10 @@ static int _task_layout_block(slurm_step_layout_t *step_layout, uint16_t *cpus)
 static int _task_layout_cyclic(slurm_step_layout_t *step_layout,
 			       uint16_t *cpus)
 {
-	int i, j, max_over_subscribe = 0, taskid = 0, total_cpus = 0;
-	bool over_subscribe = false;
+	int i, j, k, max_over_subscribe = 0, taskid = 0, total_cpus = 0;
+	int pass;
+	uint32_t **tids = step_layout->tids;
+	bool over_subscribe = false, init_over_subscribe;
 
 	for (i = 0; i < step_layout->node_cnt; i++)
 		total_cpus += cpus[i];
@@ -724,27 +863,40 @@ static int _task_layout_cyclic(slurm_step_layout_t *step_layout,
 		max_over_subscribe = (i + step_layout->node_cnt - 1) /
 				     step_layout->node_cnt;
 	}
+	init_over_subscribe = over_subscribe;
 
-	for (j=0; taskid<step_layout->task_cnt; j++) {   /* cycle counter */
-		bool space_remaining = false;
-		for (i=0; ((i<step_layout->node_cnt)
-			   && (taskid<step_layout->task_cnt)); i++) {
-			if ((j < cpus[i]) ||
-			    (over_subscribe &&
-			     (j < (cpus[i] + max_over_subscribe)))) {
-				xrealloc(step_layout->tids[i], sizeof(uint32_t)
-					 * (step_layout->tasks[i] + 1));
-
-				step_layout->tids[i][step_layout->tasks[i]] =
-					taskid;
-				taskid++;
-				step_layout->tasks[i]++;
-				if ((j+1) < cpus[i])
-					space_remaining = true;
+	/*
+	 * Pass 0 counts the tasks of each node and pass 1 lays out their ids,
+	 * so each node's tids array is allocated once.
+	 */
+	for (pass = 0; pass < 2; pass++) {
+		if (pass) {
+			for (i = 0; i < step_layout->node_cnt; i++) {
+				tids[i] = xcalloc(step_layout->tasks[i],
+						  sizeof(uint32_t));
+				step_layout->tasks[i] = 0;
 			}
+			over_subscribe = init_over_subscribe;
+			taskid = 0;
+		}
+		for (j = 0; taskid < step_layout->task_cnt; j++) {
+			bool space_remaining = false;
+			for (i = 0; ((i < step_layout->node_cnt) &&
+				     (taskid < step_layout->task_cnt)); i++) {
+				if ((j < cpus[i]) ||
+				    (over_subscribe &&
+				     (j < (cpus[i] + max_over_subscribe)))) {
+					k = step_layout->tasks[i]++;
+					if (pass)
+						tids[i][k] = taskid;
+					taskid++;
+					if ((j+1) < cpus[i])
+						space_remaining = true;
+				}
+			}
+			if (!space_remaining)
+				over_subscribe = true;
 		}
-		if (!space_remaining)
-			over_subscribe = true;
 	}
 	return SLURM_SUCCESS;
 }
@@ -81,6 +81,7 @@
 #define	bit_clear_all		slurm_bit_clear_all
 #define	bit_ffc			slurm_bit_ffc
 #define	bit_ffs			slurm_bit_ffs
+#define	bit_ffs_from_bit	slurm_bit_ffs_from_bit
 #define	bit_free		slurm_bit_free
 #define	bit_realloc		slurm_bit_realloc
 #define	bit_size		slurm_bit_size
@@ -235,6 +236,7 @@
 
 /* pack.[ch] functions */
 #define	create_buf		slurm_create_buf
+#define	create_shadow_buf	slurm_create_shadow_buf
 #define	free_buf		slurm_free_buf
 #define grow_buf		slurm_grow_buf
 #define	init_buf		slurm_init_buf
@@ -247,6 +249,14 @@
 #define	unpacklongdouble	slurm_unpacklongdouble
 #define	pack64			slurm_pack64
 #define	unpack64		slurm_unpack64
+#define	packvar64		slurm_packvar64
+#define	unpackvar64		slurm_unpackvar64
+#define	packvar32		slurm_packvar32
+#define	unpackvar32		slurm_unpackvar32
+#define	packvar_time		slurm_packvar_time
+#define	unpackvar_time		slurm_unpackvar_time
+#define	packvarmem		slurm_packvarmem
+#define	unpackvarmem_xmalloc	slurm_unpackvarmem_xmalloc
 #define	pack32			slurm_pack32
 #define	unpack32		slurm_unpack32
 #define	pack16			slurm_pack16
@@ -338,6 +348,8 @@
 #define	_xiso8601timecat	slurm_xiso8601timecat
 #define	_xrfc5424timecat	slurm_xrfc5424timecat
 #define	_xstrfmtcat		slurm_xstrfmtcat
+#define	_xstrfmtcatat		slurm_xstrfmtcatat
+#define	_xstrcatat		slurm_xstrcatat
 #define	_xmemcat		slurm_xmemcat
 #define	xstrdup			slurm_xstrdup
 #define	xstrdup_printf		slurm_xstrdup_printf
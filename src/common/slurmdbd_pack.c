@@ -1219,20 +1219,20 @@ static void _pack_buffer(void *in, uint16_t rpc_version, buf_t *buffer)
 
 static int _unpack_buffer(void **out, uint16_t rpc_version, buf_t *buffer)
 {
-	buf_t *out_ptr = NULL;
 	char *msg = NULL;
 	uint32_t uint32_tmp;
 
-	safe_unpackmem_xmalloc(&msg, &uint32_tmp, buffer);
-	if (!(out_ptr = create_buf(msg, uint32_tmp)))
-		goto unpack_error;
-	*out = out_ptr;
+	/*
+	 * Each sub-message is only unpacked, and the resulting list is always
+	 * freed before the enclosing message buffer, so reference the data in
+	 * place rather than copying it.
+	 */
+	safe_unpackmem_ptr(&msg, &uint32_tmp, buffer);
+	*out = create_shadow_buf(msg, uint32_tmp);
 
 	return SLURM_SUCCESS;
 
 unpack_error:
-	xfree(msg);
-	slurmdbd_free_buffer(out_ptr);
 	*out = NULL;
 	return SLURM_ERROR;
 
@@ -1367,8 +1367,9 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
-extern void slurmdbd_pack_list_msg(dbd_list_msg_t *msg, uint16_t rpc_version,
-				   slurmdbd_msg_type_t type, buf_t *buffer)
+static void _pack_list_msg(dbd_list_msg_t *msg, uint16_t rpc_version,
+			   slurmdbd_msg_type_t type, buf_t *buffer,
+			   bool consume)
 {
 	int rc;
 	void (*my_function) (void *object, uint16_t rpc_version, buf_t *buffer);
@@ -1445,13 +1446,32 @@ extern void slurmdbd_pack_list_msg(dbd_list_msg_t *msg, uint16_t rpc_version,
 		return;
 	}
 
-	if ((rc = slurm_pack_list(msg->my_list, my_function,
-				  buffer, rpc_version)) != SLURM_SUCCESS)
+	if (consume)
+		rc = slurm_pack_list_consume(msg->my_list, my_function,
+					     buffer, rpc_version);
+	else
+		rc = slurm_pack_list(msg->my_list, my_function,
+				     buffer, rpc_version);
+	if (rc != SLURM_SUCCESS)
 		msg->return_code = rc;
 
 	pack32(msg->return_code, buffer);
 }
 
+extern void slurmdbd_pack_list_msg(dbd_list_msg_t *msg, uint16_t rpc_version,
+				   slurmdbd_msg_type_t type, buf_t *buffer)
+{
+	_pack_list_msg(msg, rpc_version, type, buffer, false);
+}
+
+extern void slurmdbd_pack_list_msg_consume(dbd_list_msg_t *msg,
+					   uint16_t rpc_version,
+					   slurmdbd_msg_type_t type,
+					   buf_t *buffer)
+{
+	_pack_list_msg(msg, rpc_version, type, buffer, true);
+}
+
 extern int slurmdbd_unpack_list_msg(dbd_list_msg_t **msg, uint16_t rpc_version,
 				    slurmdbd_msg_type_t type, buf_t *buffer)
 {
@@ -71,6 +71,11 @@ extern int slurmdbd_unpack_fini_msg(dbd_fini_msg_t **msg, uint16_t rpc_version,
 
 extern void slurmdbd_pack_list_msg(dbd_list_msg_t *msg, uint16_t rpc_version,
 				   slurmdbd_msg_type_t type, buf_t *buffer);
+/* Same as slurmdbd_pack_list_msg() but empties msg->my_list while packing */
+extern void slurmdbd_pack_list_msg_consume(dbd_list_msg_t *msg,
+					   uint16_t rpc_version,
+					   slurmdbd_msg_type_t type,
+					   buf_t *buffer);
 extern int slurmdbd_unpack_list_msg(dbd_list_msg_t **msg, uint16_t rpc_version,
 				    slurmdbd_msg_type_t type, buf_t *buffer);
 
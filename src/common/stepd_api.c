@@ -40,10 +40,10 @@
 
 #define _GNU_SOURCE
 
+#include <ctype.h>
 #include <dirent.h>
 #include <grp.h>
 #include <inttypes.h>
-#include <regex.h>
 #include <signal.h>
 #include <stdlib.h>
 #include <string.h>
@@ -460,58 +460,53 @@ _free_step_loc_t(step_loc_t *loc)
 	xfree(loc);
 }
 
-static int
-_sockname_regex_init(regex_t *re, const char *nodename)
+/* Parse a (possibly empty) run of decimal digits, advancing *str past it */
+static uint32_t _parse_digits(const char **str)
 {
-	char *pattern = NULL;
-
-	xstrcat(pattern, "^");
-	xstrcat(pattern, nodename);
-	xstrcat(pattern,
-		"_([[:digit:]]*)\\.([[:digit:]]*)\\.{0,1}([[:digit:]]*)$");
+	unsigned long val = 0;
 
-	if (regcomp(re, pattern, REG_EXTENDED) != 0) {
-		error("sockname regex compilation failed");
-		return -1;
+	while (isdigit((unsigned char) **str)) {
+		val = (val * 10) + (**str - '0');
+		(*str)++;
 	}
 
-	xfree(pattern);
-
-	return 0;
+	return (uint32_t) val;
 }
 
-static int
-_sockname_regex(regex_t *re, const char *filename, slurm_step_id_t *step_id)
+/*
+ * Parse a socket name of the form "<nodename>_<jobid>.<stepid>[.<het_comp>]"
+ * RET 0 and fill in step_id on match, -1 otherwise
+ *
+ * This is called for every entry of the spool directory each time the
+ * slurmd looks for its steps, so it avoids compiling and running a regex.
+ */
+static int _sockname_parse(const char *nodename, size_t nodename_len,
+			   const char *filename, slurm_step_id_t *step_id)
 {
-	size_t nmatch = 5;
-	regmatch_t pmatch[5];
-	char *match;
-	size_t my_size;
+	const char *ptr;
 
 	xassert(step_id);
 
-	memset(pmatch, 0, sizeof(regmatch_t)*nmatch);
-	if (regexec(re, filename, nmatch, pmatch, 0) == REG_NOMATCH) {
+	if (strncmp(filename, nodename, nodename_len) ||
+	    (filename[nodename_len] != '_'))
+		return -1;
+
+	ptr = filename + nodename_len + 1;
+	step_id->job_id = _parse_digits(&ptr);
+	if (*ptr++ != '.')
 		return -1;
+	step_id->step_id = _parse_digits(&ptr);
+
+	step_id->step_het_comp = NO_VAL;
+	if (*ptr == '.') {
+		ptr++;
+		/* If we have digits here we have a het_comp */
+		if (isdigit((unsigned char) *ptr))
+			step_id->step_het_comp = _parse_digits(&ptr);
 	}
 
-	match = xstrndup(filename + pmatch[1].rm_so,
-			(size_t)(pmatch[1].rm_eo - pmatch[1].rm_so));
-	step_id->job_id = slurm_atoul(match);
-	xfree(match);
-
-	match = xstrndup(filename + pmatch[2].rm_so,
-			(size_t)(pmatch[2].rm_eo - pmatch[2].rm_so));
-	step_id->step_id = slurm_atoul(match);
-	xfree(match);
-
-	/* If we have a size here we have a het_comp */
-	if ((my_size = pmatch[3].rm_eo - pmatch[3].rm_so)) {
-		match = xstrndup(filename + pmatch[3].rm_so, my_size);
-		step_id->step_het_comp = slurm_atoul(match);
-		xfree(match);
-	} else
-		step_id->step_het_comp = NO_VAL;
+	if (*ptr != '\0')
+		return -1;
 
 	return 0;
 }
@@ -533,8 +528,9 @@ stepd_available(const char *directory, const char *nodename)
 	List l;
 	DIR *dp;
 	struct dirent *ent;
-	regex_t re;
 	struct stat stat_buf;
+	char *spooldir = NULL;
+	size_t nodename_len;
 
 	if (nodename == NULL) {
 		if (!(nodename = _guess_nodename())) {
@@ -544,14 +540,13 @@ stepd_available(const char *directory, const char *nodename)
 	}
 	if (directory == NULL) {
 		slurm_conf_t *cf = slurm_conf_lock();
-		directory = slurm_conf_expand_slurmd_path(
+		directory = spooldir = slurm_conf_expand_slurmd_path(
 			cf->slurmd_spooldir, nodename);
 		slurm_conf_unlock();
 	}
 
 	l = list_create((ListDelF) _free_step_loc_t);
-	if (_sockname_regex_init(&re, nodename) == -1)
-		goto done;
+	nodename_len = strlen(nodename);
 
 	/*
 	 * Make sure that "directory" exists and is a directory.
@@ -573,7 +568,8 @@ stepd_available(const char *directory, const char *nodename)
 		step_loc_t *loc;
 		slurm_step_id_t step_id;
 
-		if (!_sockname_regex(&re, ent->d_name, &step_id)) {
+		if (!_sockname_parse(nodename, nodename_len, ent->d_name,
+				     &step_id)) {
 			debug4("found %ps", &step_id);
 			loc = xmalloc(sizeof(step_loc_t));
 			loc->directory = xstrdup(directory);
@@ -585,7 +581,7 @@ stepd_available(const char *directory, const char *nodename)
 
 	closedir(dp);
 done:
-	regfree(&re);
+	xfree(spooldir);
 	return l;
 }
 
@@ -599,11 +595,9 @@ stepd_cleanup_sockets(const char *directory, const char *nodename)
 {
 	DIR *dp;
 	struct dirent *ent;
-	regex_t re;
 	struct stat stat_buf;
 	int rc = SLURM_SUCCESS;
-
-	_sockname_regex_init(&re, nodename);
+	size_t nodename_len = strlen(nodename);
 
 	/*
 	 * Make sure that "directory" exists and is a directory.
@@ -623,7 +617,8 @@ stepd_cleanup_sockets(const char *directory, const char *nodename)
 
 	while ((ent = readdir(dp)) != NULL) {
 		slurm_step_id_t step_id;
-		if (!_sockname_regex(&re, ent->d_name, &step_id)) {
+		if (!_sockname_parse(nodename, nodename_len, ent->d_name,
+				     &step_id)) {
 			char *path;
 			int fd;
 			uint16_t protocol_version;
@@ -663,7 +658,6 @@ stepd_cleanup_sockets(const char *directory, const char *nodename)
 
 	closedir(dp);
 done:
-	regfree(&re);
 	return rc;
 }
 
@@ -1055,6 +1049,9 @@ stepd_completion(int fd, uint16_t protocol_version, step_complete_msg_t *sent)
 		 */
 		jobacctinfo_pack(sent->jobacct, protocol_version,
 				 PROTOCOL_TYPE_SLURM, buffer);
+		/* Older slurmstepd ignore data after the accounting record */
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+			pack_bit_str_hex(sent->task_exit_ok, buffer);
 		len = get_buf_offset(buffer);
 		safe_write(fd, &len, sizeof(int));
 		safe_write(fd, get_buf_data(buffer), len);
@@ -33,33 +33,26 @@
  *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
 \*****************************************************************************/
 
-#include "src/common/uthash.h"
 #include "src/common/xhash.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
-#if 0
-/* undefine default allocators */
-#undef uthash_malloc
-#undef uthash_free
-
-/* re-define them using slurm's ones */
-#define uthash_malloc(sz) xmalloc(sz)
-#define uthash_free(ptr, sz) xfree(ptr)
-#endif
-
 /*
- * FIXME:
- * A pre-malloced array of xhash_item_t could be associated to
- * the xhash_table in order to speed up the xhash_add function.
- * The default array size could be something like 10% of the
- * provided table_size (hash table are commonly defined larger
- * than necessary to avoid shared keys and usage of linked list)
+ * The table is an open addressing hash with linear probing. Each slot keeps
+ * the key's hash and length inline next to the key and item pointers, so a
+ * probe only dereferences the key when the cached hash matches and lookups
+ * walk one contiguous array instead of a chain of separately allocated items.
+ * Deletion shifts following entries back into the hole, so there are no
+ * tombstones and probe sequences stay short after many add/pop cycles.
  */
 
+#define XHASH_MIN_SIZE	16	/* initial number of slots, power of 2 */
+
 typedef struct xhash_item_st {
-	void*		item;    /* user item                               */
-	UT_hash_handle	hh;      /* make this structure hashable by uthash  */
+	void*		item;    /* user item, NULL if the slot is empty    */
+	const char*	key;     /* key returned by identify, not copied    */
+	uint32_t	key_len; /* length of key                           */
+	uint32_t	hash;    /* cached hash of key                      */
 } xhash_item_t;
 
 struct xhash_st {
@@ -68,37 +61,125 @@ struct xhash_st {
 	xhash_item_t*		ht;       /* hash table                      */
 	xhash_idfunc_t		identify; /* function returning a unique str
 					     key */
+	uint32_t		size;     /* slots in ht, 0 or a power of 2  */
 };
 
+/* FNV-1a with a final avalanche so the low bits can be used as the index */
+static uint32_t _hash(const char *key, uint32_t len)
+{
+	uint32_t hash = 2166136261U;
+
+	for (uint32_t i = 0; i < len; i++) {
+		hash ^= (unsigned char) key[i];
+		hash *= 16777619U;
+	}
+
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bU;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35U;
+	hash ^= hash >> 16;
+
+	return hash;
+}
+
+static bool _match(xhash_item_t *slot, const char *key, uint32_t len,
+		   uint32_t hash)
+{
+	return ((slot->hash == hash) && (slot->key_len == len) &&
+		!memcmp(slot->key, key, len));
+}
+
+/* Place an entry known not to be in the table into the first free slot */
+static void _insert(xhash_t *table, xhash_item_t *entry)
+{
+	uint32_t mask = table->size - 1;
+	uint32_t i = entry->hash & mask;
+
+	while (table->ht[i].item)
+		i = (i + 1) & mask;
+	table->ht[i] = *entry;
+}
+
+/* Grow the table before it gets more than half full */
+static void _grow(xhash_t *table)
+{
+	xhash_item_t *old_ht = table->ht;
+	uint32_t old_size = table->size;
+
+	if ((table->count + 1) * 2 <= table->size)
+		return;
+
+	table->size = old_size ? (old_size * 2) : XHASH_MIN_SIZE;
+	table->ht = xcalloc(table->size, sizeof(xhash_item_t));
+	for (uint32_t i = 0; i < old_size; i++) {
+		if (old_ht[i].item)
+			_insert(table, &old_ht[i]);
+	}
+	xfree(old_ht);
+}
+
+/* Empty slot i and shift back any following entries displaced past it */
+static void _remove_slot(xhash_t *table, uint32_t i)
+{
+	uint32_t mask = table->size - 1;
+	uint32_t j = i;
+
+	while (true) {
+		uint32_t home;
+
+		j = (j + 1) & mask;
+		if (!table->ht[j].item)
+			break;
+		home = table->ht[j].hash & mask;
+		/* leave entries whose home lies cyclically within (i, j] */
+		if ((i <= j) ? ((i < home) && (home <= j)) :
+			       ((i < home) || (home <= j)))
+			continue;
+		table->ht[i] = table->ht[j];
+		i = j;
+	}
+	memset(&table->ht[i], 0, sizeof(xhash_item_t));
+	--table->count;
+}
+
 xhash_t *xhash_init(xhash_idfunc_t idfunc, xhash_freefunc_t freefunc)
 {
 	xhash_t* table = NULL;
 	if (!idfunc)
 		return NULL;
 	table = xmalloc(sizeof(xhash_t));
-	table->ht = NULL; /* required by uthash */
+	table->ht = NULL; /* allocated on first add */
+	table->size = 0;
 	table->count = 0;
 	table->identify = idfunc;
 	table->freefunc = freefunc;
 	return table;
 }
 
-static xhash_item_t* xhash_find(xhash_t* table, const char* key, uint32_t len)
+/* Return the slot index holding key or -1 if not found */
+static int64_t xhash_find(xhash_t* table, const char* key, uint32_t len)
 {
-	xhash_item_t* hash_item = NULL;
+	uint32_t mask, hash, i;
 
-	if (!table || !key)
-		return NULL;
-	HASH_FIND(hh, table->ht, key, len, hash_item);
-	return hash_item;
+	if (!table || !key || !table->count)
+		return -1;
+
+	mask = table->size - 1;
+	hash = _hash(key, len);
+	for (i = hash & mask; table->ht[i].item; i = (i + 1) & mask) {
+		if (_match(&table->ht[i], key, len, hash))
+			return i;
+	}
+	return -1;
 }
 
 void* xhash_get(xhash_t* table, const char* key, uint32_t key_len)
 {
-	xhash_item_t* item = xhash_find(table, key, key_len);
-	if (!item)
+	int64_t i = xhash_find(table, key, key_len);
+	if (i < 0)
 		return NULL;
-	return item->item;
+	return table->ht[i].item;
 }
 
 void* xhash_get_str(xhash_t* table, const char* key)
@@ -108,30 +189,43 @@ void* xhash_get_str(xhash_t* table, const char* key)
 
 void* xhash_add(xhash_t* table, void* item)
 {
-	xhash_item_t* hash_item = NULL;
-	const char *key = NULL;
-	uint32_t keylen = 0;
+	xhash_item_t entry;
+	int64_t i;
 
 	if (!table || !item)
 		return NULL;
-	hash_item = xmalloc(sizeof(xhash_item_t));
-	hash_item->item    = item;
-	table->identify(item, &key, &keylen);
-	HASH_ADD_KEYPTR(hh, table->ht, key, keylen, hash_item);
+
+	entry.item = item;
+	entry.key = NULL;
+	entry.key_len = 0;
+	table->identify(item, &entry.key, &entry.key_len);
+	entry.hash = _hash(entry.key, entry.key_len);
+
+	_grow(table);
+
+	/*
+	 * Duplicate keys are kept, but the newest item must be the one found
+	 * by lookups, so it takes over the existing slot and the older item
+	 * moves further down the probe sequence.
+	 */
+	if ((i = xhash_find(table, entry.key, entry.key_len)) >= 0) {
+		xhash_item_t older = table->ht[i];
+		table->ht[i] = entry;
+		entry = older;
+	}
+	_insert(table, &entry);
 	++table->count;
-	return hash_item->item;
+	return item;
 }
 
 void* xhash_pop(xhash_t* table, const char* key, uint32_t len)
 {
 	void* item_item;
-	xhash_item_t* item = xhash_find(table, key, len);
-	if (!item)
+	int64_t i = xhash_find(table, key, len);
+	if (i < 0)
 		return NULL;
-	item_item = item->item;
-	HASH_DELETE(hh, table->ht, item);
-	xfree(item);
-	--table->count;
+	item_item = table->ht[i].item;
+	_remove_slot(table, i);
 	return item_item;
 }
 
@@ -165,29 +259,24 @@ void xhash_walk(xhash_t* table,
 		void (*callback)(void* item, void* arg),
 		void* arg)
 {
-	xhash_item_t* current_item = NULL;
-	xhash_item_t* tmp = NULL;
 	if (!table || !callback)
 		return;
-	HASH_ITER(hh, table->ht, current_item, tmp) {
-		  callback(current_item->item, arg);
+	for (uint32_t i = 0; i < table->size; i++) {
+		if (table->ht[i].item)
+			callback(table->ht[i].item, arg);
 	}
 }
 
 void xhash_clear(xhash_t* table)
 {
-	xhash_item_t* current_item = NULL;
-	xhash_item_t* tmp = NULL;
-
 	if (!table)
 		return;
-	HASH_ITER(hh, table->ht, current_item, tmp) {
-		  HASH_DEL(table->ht, current_item);
-		  if (table->freefunc)
-			  table->freefunc(current_item->item);
-		  xfree(current_item);
+	for (uint32_t i = 0; i < table->size; i++) {
+		if (table->ht[i].item && table->freefunc)
+			table->freefunc(table->ht[i].item);
 	}
-
+	xfree(table->ht);
+	table->size = 0;
 	table->count = 0;
 }
 
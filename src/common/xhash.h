@@ -65,7 +65,7 @@ typedef void (*xhash_idfunc_t)(void* item, const char** key, uint32_t* key_len);
   *          the given id.
   */
 
-/* Currently not implementable with uthash */
+/* Currently not implemented, xhash uses its own internal hash function */
 typedef unsigned (*xhash_hashfunc_t)(unsigned hashes_count, const char* id);
 
 /** This type of function is used to free data inserted into xhash table */
@@ -57,6 +57,52 @@ strong_alias(xfree_ptr, slurm_xfree_ptr);
 strong_alias(xsize, slurm_xsize);
 
 #define XMALLOC_MAGIC 0x42
+#define XMALLOC_ARENA_MAGIC 0x43	/* allocated from an xarena_t */
+
+#define XARENA_MAGIC 0x41524e41
+#define XARENA_CHUNK_SIZE	(16 * 1024)
+#define XARENA_MAX_ALLOC	1024	/* larger requests use malloc() */
+
+typedef struct xarena_chunk {
+	struct xarena_chunk *next;
+	size_t used;
+	char data[];		/* aligned as malloc() memory is */
+} xarena_chunk_t;
+
+struct xarena {
+	int magic;		/* XARENA_MAGIC */
+	xarena_chunk_t *chunks;	/* newest first */
+};
+
+/* Arena that xmalloc() allocates from in this thread, if any */
+static __thread xarena_t *thread_arena = NULL;
+
+/*
+ * Carve space for one allocation (including its two header words) out of
+ * the arena, RET NULL if a new chunk could not be allocated
+ */
+static size_t *_arena_alloc(xarena_t *arena, size_t total_size)
+{
+	xarena_chunk_t *chunk = arena->chunks;
+	size_t *p;
+
+	xassert(arena->magic == XARENA_MAGIC);
+
+	/* keep every allocation aligned to two header words */
+	total_size = (total_size + (2 * sizeof(size_t)) - 1) &
+		     ~((2 * sizeof(size_t)) - 1);
+	if (!chunk || ((chunk->used + total_size) > XARENA_CHUNK_SIZE)) {
+		if (!(chunk = malloc(sizeof(*chunk) + XARENA_CHUNK_SIZE)))
+			return NULL;
+		chunk->used = 0;
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+	}
+
+	p = (size_t *) (chunk->data + chunk->used);
+	chunk->used += total_size;
+	return p;
+}
 
 /*
  * "Safe" version of malloc().
@@ -93,6 +139,15 @@ void *slurm_xcalloc(size_t count, size_t size, bool clear, bool try,
 	count_size = count * size;
 	total_size = count_size + 2 * sizeof(size_t);
 
+	if (thread_arena && (count_size <= XARENA_MAX_ALLOC) &&
+	    (p = _arena_alloc(thread_arena, total_size))) {
+		if (clear)
+			memset(&p[2], 0, count_size);
+		p[0] = XMALLOC_ARENA_MAGIC;
+		p[1] = count_size;
+		return &p[2];
+	}
+
 	if (clear)
 		p = calloc(1, total_size);
 	else
@@ -146,7 +201,21 @@ extern void * slurm_xrecalloc(void **item, size_t count, size_t size,
 	count_size = count * size;
 	total_size = count_size + 2 * sizeof(size_t);
 
-	if (*item != NULL) {
+	if (*item && (((size_t *)*item - 2)[0] == XMALLOC_ARENA_MAGIC)) {
+		/* Arena memory can't be resized, move it to a new block */
+		void *new_item;
+		size_t old_size;
+
+		p = (size_t *)*item - 2;
+		old_size = p[1];
+		if (!(new_item = slurm_xcalloc(1, count_size, clear, try,
+					       file, line, func)))
+			return NULL;
+		memcpy(new_item, *item, MIN(old_size, count_size));
+		p[0] = 0;
+		*item = new_item;
+		return *item;
+	} else if (*item != NULL) {
 		size_t old_size;
 		p = (size_t *)*item - 2;
 
@@ -194,7 +263,8 @@ size_t xsize(void *item)
 {
 	size_t *p = (size_t *)item - 2;
 	xassert(item != NULL);
-	xassert(p[0] == XMALLOC_MAGIC); /* CLANG false positive here */
+	xassert((p[0] == XMALLOC_MAGIC) ||	/* CLANG false positive here */
+		(p[0] == XMALLOC_ARENA_MAGIC));
 	return p[1];
 }
 
@@ -208,9 +278,14 @@ void slurm_xfree(void **item)
 	if (*item != NULL) {
 		size_t *p = (size_t *)*item - 2;
 		/* magic cookie still there? */
-		xassert(p[0] == XMALLOC_MAGIC);
-		p[0] = 0;	/* make sure xfree isn't called twice */
-		free(p);
+		xassert((p[0] == XMALLOC_MAGIC) ||
+			(p[0] == XMALLOC_ARENA_MAGIC));
+		/* arena memory is only released with the whole arena */
+		if (p[0] == XMALLOC_MAGIC) {
+			p[0] = 0; /* make sure xfree isn't called twice */
+			free(p);
+		} else
+			p[0] = 0;
 		*item = NULL;
 	}
 }
@@ -224,3 +299,50 @@ void xfree_ptr(void *ptr)
 {
 	slurm_xfree(&ptr);
 }
+
+/*
+ * Create an arena for short lived allocations, see xarena_set()
+ */
+xarena_t *xarena_create(void)
+{
+	xarena_t *arena = xmalloc(sizeof(*arena));
+
+	arena->magic = XARENA_MAGIC;
+	return arena;
+}
+
+/*
+ * Make small xmalloc() allocations by the calling thread come from arena
+ * until called again with NULL.
+ * RET the arena which was previously in use
+ */
+xarena_t *xarena_set(xarena_t *arena)
+{
+	xarena_t *old_arena = thread_arena;
+
+	xassert(!arena || (arena->magic == XARENA_MAGIC));
+	thread_arena = arena;
+	return old_arena;
+}
+
+/*
+ * Release all memory allocated from the arena and the arena itself.
+ * Nothing allocated from it may be referenced afterwards, xfree() of such
+ * memory is optional.
+ */
+void xarena_destroy(xarena_t *arena)
+{
+	xarena_chunk_t *chunk;
+
+	if (!arena)
+		return;
+
+	xassert(arena->magic == XARENA_MAGIC);
+	xassert(thread_arena != arena);
+	while ((chunk = arena->chunks)) {
+		arena->chunks = chunk->next;
+		free(chunk);
+	}
+	arena->magic = ~XARENA_MAGIC;
+	xfree(arena);
+}
@@ -63,6 +63,11 @@
  * p. The memory must have been allocated with [try_]xmalloc() or
  * [try_]xrealloc().
  *
+ * xarena_set(arena) makes small allocations by the calling thread come from
+ * an arena created with xarena_create(), until xarena_set(NULL). xfree() of
+ * arena memory does nothing, it is all released by xarena_destroy(), so
+ * nothing allocated from an arena may outlive it.
+ *
 \*****************************************************************************/
 
 #ifndef _XMALLOC_H
@@ -111,4 +116,10 @@ size_t xsize(void *item);
 
 void xfree_ptr(void *);
 
+typedef struct xarena xarena_t;
+
+xarena_t *xarena_create(void);
+xarena_t *xarena_set(xarena_t *arena);
+void xarena_destroy(xarena_t *arena);
+
 #endif /* !_XMALLOC_H */
@@ -70,6 +70,7 @@ static size_t _xstrdup_vprintf(char **str, const char *_fmt, va_list _ap);
  * for details.
  */
 strong_alias(_xstrcat,		slurm_xstrcat);
+strong_alias(_xstrcatat,	slurm_xstrcatat);
 strong_alias(_xstrncat,		slurm_xstrncat);
 strong_alias(_xstrcatchar,	slurm_xstrcatchar);
 strong_alias(_xstrftimecat,	slurm_xstrftimecat);
@@ -138,6 +139,42 @@ void _xstrcat(char **str1, const char *str2)
 	strcat(*str1, str2);
 }
 
+/*
+ * Concatenate str2 onto str1 at position pos, expanding str1 as needed.
+ *   str1 (IN/OUT)	target string (pointer to in case of expansion)
+ *   pos (IN/OUT)	current end of str1, NULL if unknown. Updated to the
+ *			new end of str1.
+ *   str2 (IN)		source string
+ */
+void _xstrcatat(char **str1, char **pos, const char *str2)
+{
+	size_t orig_len, append_len;
+
+	if (str2 == NULL)
+		str2 = "(null)";
+
+	append_len = strlen(str2);
+
+	if (!*str1) {
+		orig_len = 0;
+	} else if (!*pos) {
+		orig_len = strlen(*str1);
+	} else {
+		xassert(*pos >= *str1);
+		orig_len = *pos - *str1;
+	}
+
+	_makespace(str1, orig_len, append_len);
+
+	memcpy(*str1 + orig_len, str2, append_len + 1);
+
+	/*
+	 * Update *pos. Cannot happen earlier as _makespace() may have
+	 * changed *str1 to a different address.
+	 */
+	*pos = *str1 + orig_len + append_len;
+}
+
 /*
  * Concatenate len of str2 onto str1, expanding str1 as needed.
  *   str1 (IN/OUT)	target string (pointer to in case of expansion)
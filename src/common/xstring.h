@@ -43,6 +43,7 @@
 #include "src/common/macros.h"
 
 #define xstrcat(__p, __q)		_xstrcat(&(__p), __q)
+#define xstrcatat(__p, __q, __s)	_xstrcatat(&(__p), __q, __s)
 #define xstrncat(__p, __q, __l)		_xstrncat(&(__p), __q, __l)
 #define xstrcatchar(__p, __c)		_xstrcatchar(&(__p), __c)
 #define xstrftimecat(__p, __fmt)	_xstrftimecat(&(__p), __fmt)
@@ -73,6 +74,13 @@
 */
 void _xstrcat(char **str1, const char *str2);
 
+/*
+** cat str2 onto str1 at position pos, expanding str1 as necessary.
+** pos is updated to the new end of str1, so repeated appends don't have
+** to rescan str1 (start with *pos == NULL).
+*/
+void _xstrcatat(char **str1, char **pos, const char *str2);
+
 /*
 ** cat len of str2 onto str1, expanding str1 as necessary
 */
@@ -50,6 +50,10 @@
 
 #define MAX_DEADLOCK_ATTEMPTS 10
 
+/* Keep batched inserts well below the default max_allowed_packet */
+#define MAX_BATCH_ROWS 500
+#define MAX_BATCH_SIZE (1024 * 1024)
+
 static char *table_defs_table = "table_defs_table";
 
 typedef struct {
@@ -202,6 +206,64 @@ end_it:
 	return rc;
 }
 
+/* NOTE: Ensure that mysql_conn->lock is set on function entry */
+static void _discard_batch(mysql_conn_t *mysql_conn)
+{
+	for (int i = 0; i < mysql_conn->batch_row_cnt; i++)
+		xfree(mysql_conn->batch_rows[i]);
+	xfree(mysql_conn->batch_rows);
+	xfree(mysql_conn->batch_prefix);
+	xfree(mysql_conn->batch_suffix);
+	mysql_conn->batch_row_cnt = 0;
+	mysql_conn->batch_size = 0;
+}
+
+/*
+ * Send the rows queued by mysql_db_query_batched(). Rows which could not be
+ * inserted are remembered in batch_failed and reported by the next commit.
+ * NOTE: Ensure that mysql_conn->lock is set on function entry
+ */
+static void _flush_batch(mysql_conn_t *mysql_conn)
+{
+	char *query = NULL;
+	int rc;
+
+	if (!mysql_conn->batch_row_cnt)
+		return;
+
+	xstrfmtcat(query, "%s ", mysql_conn->batch_prefix);
+	for (int i = 0; i < mysql_conn->batch_row_cnt; i++)
+		xstrfmtcat(query, "%s%s", i ? ", " : "",
+			   mysql_conn->batch_rows[i]);
+	xstrfmtcat(query, " %s", mysql_conn->batch_suffix);
+
+	rc = _mysql_query_internal(mysql_conn->db_conn, query);
+	xfree(query);
+
+	/*
+	 * A failed statement is rolled back on its own, so send the rows one
+	 * at a time to only lose the bad ones.
+	 */
+	if ((rc != SLURM_SUCCESS) && (mysql_conn->batch_row_cnt > 1)) {
+		error("%s: batch of %d rows failed, retrying one at a time",
+		      __func__, mysql_conn->batch_row_cnt);
+		for (int i = 0; i < mysql_conn->batch_row_cnt; i++) {
+			query = xstrdup_printf("%s %s %s",
+					       mysql_conn->batch_prefix,
+					       mysql_conn->batch_rows[i],
+					       mysql_conn->batch_suffix);
+			if (_mysql_query_internal(mysql_conn->db_conn, query))
+				mysql_conn->batch_failed = true;
+			xfree(query);
+		}
+	} else if (rc != SLURM_SUCCESS)
+		mysql_conn->batch_failed = true;
+
+	_discard_batch(mysql_conn);
+	/* the caller's own query sets errno next */
+	errno = 0;
+}
+
 /* NOTE: Ensure that mysql_conn->lock is NOT set on function entry */
 static int _mysql_make_table_current(mysql_conn_t *mysql_conn, char *table_name,
 				     storage_field_t *fields, char *ending)
@@ -848,6 +910,9 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn)
 {
 	slurm_mutex_lock(&mysql_conn->lock);
+	/* uncommitted rows are lost with the connection */
+	_discard_batch(mysql_conn);
+	mysql_conn->batch_failed = false;
 	if (mysql_conn && mysql_conn->db_conn) {
 		if (mysql_thread_safe())
 			mysql_thread_end();
@@ -880,11 +945,53 @@ extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	rc = _mysql_query_internal(mysql_conn->db_conn, query);
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
 }
 
+extern int mysql_db_query_batched(mysql_conn_t *mysql_conn, char *prefix,
+				  char *row, char *suffix)
+{
+	int rc = SLURM_SUCCESS;
+
+	if (!mysql_conn || !mysql_conn->db_conn) {
+		fatal("You haven't inited this storage yet.");
+		return 0;	/* For CLANG false positive */
+	}
+
+	slurm_mutex_lock(&mysql_conn->lock);
+	if (!mysql_conn->rollback) {
+		char *query = xstrdup_printf("%s %s %s", prefix, row, suffix);
+		rc = _mysql_query_internal(mysql_conn->db_conn, query);
+		xfree(query);
+		slurm_mutex_unlock(&mysql_conn->lock);
+		return rc;
+	}
+
+	if (mysql_conn->batch_row_cnt &&
+	    (xstrcmp(prefix, mysql_conn->batch_prefix) ||
+	     xstrcmp(suffix, mysql_conn->batch_suffix)))
+		_flush_batch(mysql_conn);
+
+	if (!mysql_conn->batch_row_cnt) {
+		mysql_conn->batch_prefix = xstrdup(prefix);
+		mysql_conn->batch_suffix = xstrdup(suffix);
+		mysql_conn->batch_rows = xcalloc(MAX_BATCH_ROWS,
+						 sizeof(char *));
+	}
+	mysql_conn->batch_rows[mysql_conn->batch_row_cnt++] = xstrdup(row);
+	mysql_conn->batch_size += strlen(row) + 2;
+
+	if ((mysql_conn->batch_row_cnt >= MAX_BATCH_ROWS) ||
+	    (mysql_conn->batch_size >= MAX_BATCH_SIZE))
+		_flush_batch(mysql_conn);
+	slurm_mutex_unlock(&mysql_conn->lock);
+
+	return rc;
+}
+
 /*
  * Executes a single delete sql query.
  * Returns the number of deleted rows, <0 for failure.
@@ -898,6 +1005,7 @@ extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query)
 		return 0;	/* For CLANG false positive */
 	}
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if (!(rc = _mysql_query_internal(mysql_conn->db_conn, query)))
 		rc = mysql_affected_rows(mysql_conn->db_conn);
 	slurm_mutex_unlock(&mysql_conn->lock);
@@ -933,6 +1041,7 @@ extern int mysql_db_commit(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_commit(mysql_conn->db_conn)) {
@@ -941,7 +1050,13 @@ extern int mysql_db_commit(mysql_conn_t *mysql_conn)
 		      mysql_error(mysql_conn->db_conn));
 		errno = mysql_errno(mysql_conn->db_conn);
 		rc = SLURM_ERROR;
+	} else if (mysql_conn->batch_failed) {
+		/* the rest was committed, the caller has to resend these */
+		error("%s: batched rows of this transaction were lost",
+		      __func__);
+		rc = SLURM_ERROR;
 	}
+	mysql_conn->batch_failed = false;
 	slurm_mutex_unlock(&mysql_conn->lock);
 	return rc;
 }
@@ -954,6 +1069,8 @@ extern int mysql_db_rollback(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_discard_batch(mysql_conn);
+	mysql_conn->batch_failed = false;
 	/* clear out the old results so we don't get a 2014 error */
 	_clear_results(mysql_conn->db_conn);
 	if (mysql_rollback(mysql_conn->db_conn)) {
@@ -980,6 +1097,7 @@ extern MYSQL_RES *mysql_db_query_ret(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
 		if (mysql_errno(mysql_conn->db_conn) == ER_NO_SUCH_TABLE)
 			goto fini;
@@ -1009,6 +1127,7 @@ extern int mysql_db_query_check_after(mysql_conn_t *mysql_conn, char *query)
 	int rc = SLURM_SUCCESS;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if ((rc = _mysql_query_internal(
 		     mysql_conn->db_conn, query)) != SLURM_ERROR)
 		rc = _clear_results(mysql_conn->db_conn);
@@ -1021,6 +1140,7 @@ extern uint64_t mysql_db_insert_ret_id(mysql_conn_t *mysql_conn, char *query)
 	uint64_t new_id = 0;
 
 	slurm_mutex_lock(&mysql_conn->lock);
+	_flush_batch(mysql_conn);
 	if (_mysql_query_internal(mysql_conn->db_conn, query) != SLURM_ERROR)  {
 		new_id = mysql_insert_id(mysql_conn->db_conn);
 		if (!new_id) {
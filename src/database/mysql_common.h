@@ -59,6 +59,13 @@ typedef enum {
 } slurm_mysql_plugin_type_t;
 
 typedef struct {
+	/* rows queued by mysql_db_query_batched(), protected by lock */
+	bool batch_failed;	/* rows lost since the last commit */
+	char *batch_prefix;
+	char **batch_rows;
+	int batch_row_cnt;
+	size_t batch_size;
+	char *batch_suffix;
 	bool cluster_deleted;
 	char *cluster_name;
 	MYSQL *db_conn;
@@ -94,6 +101,20 @@ extern int mysql_db_get_db_connection(mysql_conn_t *mysql_conn, char *db_name,
 extern int mysql_db_close_db_connection(mysql_conn_t *mysql_conn);
 extern int mysql_db_cleanup();
 extern int mysql_db_query(mysql_conn_t *mysql_conn, char *query);
+
+/*
+ * Queue one row of a multi-row insert, the statement sent is
+ * "<prefix> <row>, <row>, ... <suffix>".
+ *
+ * On rollback connections consecutive rows with the same prefix and suffix are
+ * sent as one statement before the next query or commit, or when the batch is
+ * full. Since the rows are sent later a failed insert is only reported by
+ * mysql_db_commit(), so callers must not treat the record as stored before
+ * the commit succeeded.
+ * Autocommit connections send the row right away.
+ */
+extern int mysql_db_query_batched(mysql_conn_t *mysql_conn, char *prefix,
+				  char *row, char *suffix);
 extern int mysql_db_delete_affected_rows(mysql_conn_t *mysql_conn, char *query);
 extern int mysql_db_ping(mysql_conn_t *mysql_conn);
 extern int mysql_db_commit(mysql_conn_t *mysql_conn);
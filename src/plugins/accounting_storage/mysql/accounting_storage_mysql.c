@@ -1465,7 +1465,9 @@ extern int create_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name)
 				  event_table_fields,
 				  ", primary key (node_name(42), time_start), "
 				  "key rollup (node_name(42), time_start, "
-				  "time_end, state))") == SLURM_ERROR)
+				  "time_end, state), "
+				  "key archive_purge (time_start, time_end))")
+	    == SLURM_ERROR)
 		return SLURM_ERROR;
 
 	snprintf(table_name, sizeof(table_name), "\"%s_%s\"",
@@ -1474,6 +1476,11 @@ extern int create_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name)
 	/*
 	 * sacct_def is the index for query's with state as time_start is used
 	 * in these queries. sacct_def2 is for plain sacct queries.
+	 * state_end is for queries of jobs ending in a given state within the
+	 * time window, user_submit for users with an explicit job list.
+	 * archive_purge lets archive and purge walk the oldest jobs by
+	 * time_submit one batch at a time instead of scanning the table for
+	 * each batch.
 	 */
 	if (mysql_db_create_table(mysql_conn, table_name, job_table_fields,
 				  ", primary key (job_db_inx), "
@@ -1492,7 +1499,10 @@ extern int create_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name)
 				  "key sacct_def (id_user, time_start, "
 				  "time_end), "
 				  "key sacct_def2 (id_user, time_end, "
-				  "time_eligible))")
+				  "time_eligible), "
+				  "key state_end (state, time_end), "
+				  "key user_submit (id_user, time_submit), "
+				  "key archive_purge (time_submit, time_end))")
 	    == SLURM_ERROR)
 		return SLURM_ERROR;
 
@@ -1530,7 +1540,9 @@ extern int create_cluster_tables(mysql_conn_t *mysql_conn, char *cluster_name)
 				  suspend_table_fields,
 				  ", primary key (job_db_inx, time_start), "
 				  "key job_db_inx_times (job_db_inx, "
-				  "time_start, time_end))") == SLURM_ERROR)
+				  "time_start, time_end), "
+				  "key archive_purge (time_start, time_end))")
+	    == SLURM_ERROR)
 		return SLURM_ERROR;
 
 	snprintf(table_name, sizeof(table_name), "\"%s_%s\"",
@@ -2769,6 +2781,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 
 	if ((rc != SLURM_SUCCESS) && (rc != ESLURM_CLUSTER_DELETED))
 		return rc;
+	rc = SLURM_SUCCESS;
 	/*
 	 * We should never get here since check_connection will return
 	 * ESLURM_DB_CONNECTION when !mysql_conn, but Coverity doesn't
@@ -2785,7 +2798,6 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 			if (mysql_db_rollback(mysql_conn))
 				error("rollback failed");
 		} else {
-			int rc = SLURM_SUCCESS;
 			/*
 			 * Handle anything here we were unable to do
 			 * because of rollback issues.
@@ -2802,9 +2814,9 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 			if (rc != SLURM_SUCCESS) {
 				if (mysql_db_rollback(mysql_conn))
 					error("rollback failed");
-			} else {
-				if (mysql_db_commit(mysql_conn))
-					error("commit failed");
+			} else if (mysql_db_commit(mysql_conn)) {
+				error("commit failed");
+				rc = SLURM_ERROR;
 			}
 		}
 	}
@@ -2869,7 +2881,7 @@ extern int acct_storage_p_commit(mysql_conn_t *mysql_conn, bool commit)
 	xfree(mysql_conn->pre_commit_query);
 	FREE_NULL_LIST(update_list);
 
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 extern int acct_storage_p_add_users(mysql_conn_t *mysql_conn, uint32_t uid,
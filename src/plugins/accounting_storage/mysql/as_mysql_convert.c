@@ -46,43 +46,160 @@
  */
 #define CONVERT_VERSION 9
 
+/*
+ * Range of job_db_inx values converted and committed per transaction, which
+ * keeps the size of each transaction bounded on large tables.
+ */
+#define CONVERT_CHUNK_JOBS 50000
+
 typedef struct {
 	uint64_t count;
 	uint32_t id;
 } local_tres_t;
 
+typedef struct {
+	char *cluster_name;
+	int *converted;
+	pthread_cond_t *converted_cond;
+	pthread_mutex_t *converted_lock;
+	mysql_conn_t *mysql_conn;
+	int *rc;
+} local_convert_t;
+
 static uint32_t db_curr_ver = NO_VAL;
 
+/*
+ * Get the lowest and highest job_db_inx of a table.
+ * RET SLURM_SUCCESS and *min > *max if the table is empty
+ */
+static int _get_job_db_inx_range(mysql_conn_t *mysql_conn, char *cluster_name,
+				 char *table, uint64_t *min, uint64_t *max)
+{
+	MYSQL_RES *result;
+	MYSQL_ROW row;
+	char *query;
+
+	*min = 1;
+	*max = 0;
+
+	query = xstrdup_printf("select min(job_db_inx), max(job_db_inx) "
+			       "from \"%s_%s\";", cluster_name, table);
+	DB_DEBUG(DB_QUERY, mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+	if (!result)
+		return SLURM_ERROR;
+
+	if ((row = mysql_fetch_row(result)) && row[0] && row[1]) {
+		*min = slurm_atoull(row[0]);
+		*max = slurm_atoull(row[1]);
+	}
+	mysql_free_result(result);
+
+	return SLURM_SUCCESS;
+}
+
 static int _convert_step_table_post(
 	mysql_conn_t *mysql_conn, char *cluster_name)
 {
 	int rc = SLURM_SUCCESS;
 	char *query = NULL;
+	uint64_t min, max, start;
+	time_t last_log = time(NULL);
 
-	if (db_curr_ver < 9) {
-		/*
-		 * Change the names pack_job_id and pack_job_offset to be het_*
-		 */
+	if (db_curr_ver >= 9)
+		return rc;
+
+	if ((rc = _get_job_db_inx_range(mysql_conn, cluster_name, step_table,
+					&min, &max)) != SLURM_SUCCESS)
+		return rc;
+
+	/*
+	 * Change the batch and extern step ids to their 20.11 values.
+	 *
+	 * This is done a range of jobs at a time, each in its own transaction,
+	 * rather than in a single update of the whole table. A range is found
+	 * through the primary key and only the rows not yet converted are
+	 * changed, so a conversion interrupted part way through picks up
+	 * where it left off on the next start.
+	 */
+	for (start = min; start <= max; start += CONVERT_CHUNK_JOBS) {
 		query = xstrdup_printf(
-			"update \"%s_%s\" set id_step = %d where id_step = -2;"
-			"update \"%s_%s\" set id_step = %d where id_step = -1;",
+			"update \"%s_%s\" set id_step = %d where "
+			"job_db_inx >= %"PRIu64" && job_db_inx < %"PRIu64" && "
+			"id_step = -2;"
+			"update \"%s_%s\" set id_step = %d where "
+			"job_db_inx >= %"PRIu64" && job_db_inx < %"PRIu64" && "
+			"id_step = -1;",
 			cluster_name, step_table, SLURM_BATCH_SCRIPT,
-			cluster_name, step_table, SLURM_EXTERN_CONT);
-	}
-
-	if (query) {
+			start, start + CONVERT_CHUNK_JOBS,
+			cluster_name, step_table, SLURM_EXTERN_CONT,
+			start, start + CONVERT_CHUNK_JOBS);
 		DB_DEBUG(DB_QUERY, mysql_conn->conn, "query\n%s", query);
 
 		rc = mysql_db_query(mysql_conn, query);
 		xfree(query);
-		if (rc != SLURM_SUCCESS)
+		if ((rc == SLURM_SUCCESS) && mysql_db_commit(mysql_conn))
+			rc = SLURM_ERROR;
+		if (rc != SLURM_SUCCESS) {
 			error("%s: Can't convert %s_%s info: %m",
 			      __func__, cluster_name, step_table);
+			break;
+		}
+
+		if (difftime(time(NULL), last_log) >= 60) {
+			info("%s: %s_%s converted up to job_db_inx %"PRIu64" of %"PRIu64,
+			     __func__, cluster_name, step_table,
+			     start + CONVERT_CHUNK_JOBS - 1, max);
+			last_log = time(NULL);
+		}
 	}
 
 	return rc;
 }
 
+/* Convert the tables of one cluster with its own database connection */
+static void *_convert_cluster_post(void *arg)
+{
+	local_convert_t *local_convert = arg;
+	mysql_conn_t mysql_conn;
+	int rc;
+
+	memset(&mysql_conn, 0, sizeof(mysql_conn_t));
+	mysql_conn.rollback = 1;
+	mysql_conn.conn = local_convert->mysql_conn->conn;
+	slurm_mutex_init(&mysql_conn.lock);
+
+	if ((rc = check_connection(&mysql_conn)) == SLURM_SUCCESS) {
+		info("post-converting step table for %s",
+		     local_convert->cluster_name);
+		rc = _convert_step_table_post(&mysql_conn,
+					      local_convert->cluster_name);
+	}
+
+	if ((rc == SLURM_SUCCESS) && mysql_db_commit(&mysql_conn))
+		rc = SLURM_ERROR;
+	if (rc != SLURM_SUCCESS) {
+		error("Cluster %s conversion failed",
+		      local_convert->cluster_name);
+		if (mysql_db_rollback(&mysql_conn))
+			error("rollback failed");
+	}
+
+	mysql_db_close_db_connection(&mysql_conn);
+	slurm_mutex_destroy(&mysql_conn.lock);
+
+	slurm_mutex_lock(local_convert->converted_lock);
+	(*local_convert->converted)++;
+	if ((rc != SLURM_SUCCESS) && (*local_convert->rc == SLURM_SUCCESS))
+		*local_convert->rc = rc;
+	slurm_cond_signal(local_convert->converted_cond);
+	slurm_mutex_unlock(local_convert->converted_lock);
+	xfree(local_convert);
+
+	return NULL;
+}
+
 static int _convert_job_table_pre(mysql_conn_t *mysql_conn, char *cluster_name)
 {
 	int rc = SLURM_SUCCESS;
@@ -202,6 +319,9 @@ extern int as_mysql_convert_tables_pre_create(mysql_conn_t *mysql_conn)
 extern int as_mysql_convert_tables_post_create(mysql_conn_t *mysql_conn)
 {
 	int rc = SLURM_SUCCESS;
+	int converted = 0, started = 0, max_threads = 0;
+	pthread_mutex_t converted_lock = PTHREAD_MUTEX_INITIALIZER;
+	pthread_cond_t converted_cond = PTHREAD_COND_INITIALIZER;
 	ListIterator itr;
 	char *cluster_name;
 
@@ -227,16 +347,48 @@ extern int as_mysql_convert_tables_post_create(mysql_conn_t *mysql_conn)
 		return SLURM_ERROR;
 	}
 
-	/* make it up to date */
+	if (slurmdbd_conf)
+		max_threads = slurmdbd_conf->rollup_threads;
+
+	/*
+	 * Make it up to date. Each cluster is converted in its own thread, so
+	 * the clusters are converted in parallel, with Parameters=rollup_threads
+	 * limiting how many at once as for usage rollups.
+	 */
 	itr = list_iterator_create(as_mysql_total_cluster_list);
 	while ((cluster_name = list_next(itr))) {
-		info("post-converting step table for %s", cluster_name);
-		if ((rc = _convert_step_table_post(mysql_conn, cluster_name)
-		     != SLURM_SUCCESS))
+		local_convert_t *local_convert;
+
+		slurm_mutex_lock(&converted_lock);
+		while (max_threads && ((started - converted) >= max_threads))
+			slurm_cond_wait(&converted_cond, &converted_lock);
+		if (rc != SLURM_SUCCESS) {
+			slurm_mutex_unlock(&converted_lock);
 			break;
+		}
+		started++;
+		slurm_mutex_unlock(&converted_lock);
+
+		local_convert = xmalloc(sizeof(*local_convert));
+		local_convert->cluster_name = cluster_name;
+		local_convert->converted = &converted;
+		local_convert->converted_cond = &converted_cond;
+		local_convert->converted_lock = &converted_lock;
+		local_convert->mysql_conn = mysql_conn;
+		local_convert->rc = &rc;
+		/* _convert_cluster_post() frees local_convert */
+		slurm_thread_create_detached(NULL, _convert_cluster_post,
+					     local_convert);
 	}
 	list_iterator_destroy(itr);
 
+	slurm_mutex_lock(&converted_lock);
+	while (converted < started)
+		slurm_cond_wait(&converted_cond, &converted_lock);
+	slurm_mutex_unlock(&converted_lock);
+	slurm_mutex_destroy(&converted_lock);
+	slurm_cond_destroy(&converted_cond);
+
 	return rc;
 }
 
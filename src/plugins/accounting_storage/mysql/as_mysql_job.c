@@ -1168,7 +1168,7 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	char *node_list = NULL;
 	char *node_inx = NULL;
 	time_t start_time, submit_time;
-	char *query = NULL;
+	char *query = NULL, *row = NULL, *suffix = NULL;
 
 	if (!step_ptr->job_ptr->db_index
 	    && ((!step_ptr->job_ptr->details
@@ -1267,9 +1267,11 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 		}
 	}
 
-	/* we want to print a -1 for the requid so leave it a
-	   %d */
-	/* The stepid could be negative so use %d not %u */
+	/*
+	 * The update uses VALUES() so the same statement fits any number of
+	 * rows, steps started in the same transaction are then sent as one
+	 * multi-row insert.
+	 */
 	query = xstrdup_printf(
 		"insert into \"%s_%s\" (job_db_inx, id_step, step_het_comp, "
 		"time_start, step_name, state, tres_alloc, "
@@ -1282,8 +1284,11 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 	if (step_ptr->container)
 		xstrcat(query, ", container");
 
-	xstrfmtcat(query,
-		   ") values (%"PRIu64", %d, %u, %d, '%s', %d, '%s', %d, %d, "
+	xstrcat(query, ") values");
+
+	/* The stepid could be negative so use %d not %u */
+	xstrfmtcat(row,
+		   "(%"PRIu64", %d, %u, %d, '%s', %d, '%s', %d, %d, "
 		   "'%s', '%s', %d, %u, %u, %u",
 		   step_ptr->job_ptr->db_index,
 		   step_ptr->step_id.step_id,
@@ -1295,30 +1300,35 @@ extern int as_mysql_step_start(mysql_conn_t *mysql_conn,
 		   step_ptr->cpu_freq_gov);
 
 	if (step_ptr->submit_line)
-		xstrfmtcat(query, ", '%s'", step_ptr->submit_line);
+		xstrfmtcat(row, ", '%s'", step_ptr->submit_line);
 	if (step_ptr->container)
-		xstrfmtcat(query, ", '%s'", step_ptr->container);
+		xstrfmtcat(row, ", '%s'", step_ptr->container);
 
-	xstrfmtcat(query,
-		   ") on duplicate key update "
-		   "nodes_alloc=%d, task_cnt=%d, time_end=0, state=%d, "
-		   "nodelist='%s', node_inx='%s', task_dist=%d, "
-		   "req_cpufreq=%u, req_cpufreq_min=%u, req_cpufreq_gov=%u,"
-		   "tres_alloc='%s'",
-		   nodes, tasks, JOB_RUNNING,
-		   node_list, node_inx, task_dist, step_ptr->cpu_freq_max,
-		   step_ptr->cpu_freq_min, step_ptr->cpu_freq_gov,
-		   step_ptr->tres_alloc_str);
+	xstrcat(row, ")");
+
+	xstrcat(suffix,
+		"on duplicate key update "
+		"nodes_alloc=VALUES(nodes_alloc), task_cnt=VALUES(task_cnt), "
+		"time_end=0, state=VALUES(state), "
+		"nodelist=VALUES(nodelist), node_inx=VALUES(node_inx), "
+		"task_dist=VALUES(task_dist), "
+		"req_cpufreq=VALUES(req_cpufreq), "
+		"req_cpufreq_min=VALUES(req_cpufreq_min), "
+		"req_cpufreq_gov=VALUES(req_cpufreq_gov), "
+		"tres_alloc=VALUES(tres_alloc)");
 
 	if (step_ptr->submit_line)
-		xstrfmtcat(query, ", submit_line='%s'", step_ptr->submit_line);
+		xstrcat(suffix, ", submit_line=VALUES(submit_line)");
 
 	if (step_ptr->container)
-		xstrfmtcat(query, ", container='%s'", step_ptr->container);
+		xstrcat(suffix, ", container=VALUES(container)");
 
-	DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s", query);
-	rc = mysql_db_query(mysql_conn, query);
+	DB_DEBUG(DB_STEP, mysql_conn->conn, "query\n%s %s %s",
+		 query, row, suffix);
+	rc = mysql_db_query_batched(mysql_conn, query, row, suffix);
 	xfree(query);
+	xfree(row);
+	xfree(suffix);
 
 	return rc;
 }
@@ -1687,8 +1697,8 @@ extern int as_mysql_flush_jobs_on_cluster(
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
 	char *query = NULL;
-	char *id_char = NULL;
-	char *suspended_char = NULL;
+	char *id_char = NULL, *id_pos = NULL;
+	char *suspended_char = NULL, *suspended_pos = NULL;
 	size_t count;
 
 again:
@@ -1713,24 +1723,19 @@ again:
 	while ((row = mysql_fetch_row(result))) {
 		int state = slurm_atoul(row[1]);
 		if (state == JOB_SUSPENDED) {
-			if (suspended_char)
-				xstrfmtcat(suspended_char,
-					   ", %s", row[0]);
-			else
-				xstrfmtcat(suspended_char, "job_db_inx in (%s",
-					   row[0]);
+			xstrcatat(suspended_char, &suspended_pos,
+				  suspended_char ? ", " : "job_db_inx in (");
+			xstrcatat(suspended_char, &suspended_pos, row[0]);
 		}
 
-		if (id_char)
-			xstrfmtcat(id_char, ", %s", row[0]);
-		else
-			xstrfmtcat(id_char, "job_db_inx in (%s", row[0]);
+		xstrcatat(id_char, &id_pos, id_char ? ", " : "job_db_inx in (");
+		xstrcatat(id_char, &id_pos, row[0]);
 	}
 	count = mysql_num_rows(result);
 	mysql_free_result(result);
 
 	if (suspended_char) {
-		xstrfmtcat(suspended_char, ")");
+		xstrcatat(suspended_char, &suspended_pos, ")");
 		xstrfmtcat(query,
 			   "update \"%s_%s\" set "
 			   "time_suspended=%ld-time_suspended "
@@ -1751,7 +1756,7 @@ again:
 		xfree(suspended_char);
 	}
 	if (id_char) {
-		xstrfmtcat(id_char, ")");
+		xstrcatat(id_char, &id_pos, ")");
 		xstrfmtcat(query,
 			   "update \"%s_%s\" set state=%d, "
 			   "time_end=%ld where %s;",
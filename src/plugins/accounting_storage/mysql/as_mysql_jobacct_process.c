@@ -43,6 +43,12 @@
 
 #include "as_mysql_jobacct_process.h"
 
+/*
+ * Job rows read from the database at once when getting jobs. A page always
+ * ends on a job id boundary so can be a bit bigger.
+ */
+#define JOB_PAGE_ROWS 10000
+
 typedef struct {
 	hostlist_t hl;
 	time_t start;
@@ -360,6 +366,52 @@ static void _setup_job_cond_selected_steps(slurmdb_job_cond_t *job_cond,
 	}
 }
 
+/*
+ * Add "column in ('a', 'b', ...)" for the values in list to extra. MySQL can
+ * use an index for IN but often not for the same test written as ORs.
+ */
+static void _append_in_list(char **extra, char *column, List list)
+{
+	ListIterator itr;
+	char *object, *sep = "";
+
+	if (*extra)
+		xstrcat(*extra, " && (");
+	else
+		xstrcat(*extra, " where (");
+
+	xstrfmtcat(*extra, "%s in (", column);
+	itr = list_iterator_create(list);
+	while ((object = list_next(itr))) {
+		xstrfmtcat(*extra, "%s'%s'", sep, object);
+		sep = ", ";
+	}
+	list_iterator_destroy(itr);
+	xstrcat(*extra, "))");
+}
+
+/* Is state one that is queried by the job ending in the time window */
+static bool _is_end_state(uint32_t state)
+{
+	switch (state) {
+	case JOB_COMPLETE:
+	case JOB_CANCELLED:
+	case JOB_FAILED:
+	case JOB_TIMEOUT:
+	case JOB_NODE_FAIL:
+	case JOB_PREEMPTED:
+	case JOB_BOOT_FAIL:
+	case JOB_DEADLINE:
+	case JOB_OOM:
+	case JOB_REQUEUE:
+	case JOB_RESIZING:
+	case JOB_REVOKED:
+		return true;
+	default:
+		return false;
+	}
+}
+
 static void _state_time_string(char **extra, char *cluster_name, uint32_t state,
 			       slurmdb_job_cond_t *job_cond)
 {
@@ -370,6 +422,21 @@ static void _state_time_string(char **extra, char *cluster_name, uint32_t state,
 		return;
 	}
 
+	if (_is_end_state(base_state)) {
+		/*
+		 * Query assuming that -S and -E are properly set in
+		 * slurmdb_job_cond_def_start_end
+		 *
+		 * Job ending *in* the time window with the specified state.
+		 */
+		xstrfmtcat(*extra,
+		           "(t1.state='%u' && (t1.time_end && "
+		           "(t1.time_end between %ld and %ld)))",
+		           base_state, job_cond->usage_start,
+			   job_cond->usage_end);
+		return;
+	}
+
 	switch(base_state) {
 	case JOB_PENDING:
 		/*
@@ -420,30 +487,6 @@ static void _state_time_string(char **extra, char *cluster_name, uint32_t state,
 			   job_cond->usage_start, base_state,
 			   job_cond->usage_end);
 		break;
-	case JOB_COMPLETE:
-	case JOB_CANCELLED:
-	case JOB_FAILED:
-	case JOB_TIMEOUT:
-	case JOB_NODE_FAIL:
-	case JOB_PREEMPTED:
-	case JOB_BOOT_FAIL:
-	case JOB_DEADLINE:
-	case JOB_OOM:
-	case JOB_REQUEUE:
-	case JOB_RESIZING:
-	case JOB_REVOKED:
-		/*
-		 * Query assuming that -S and -E are properly set in
-		 * slurmdb_job_cond_def_start_end
-		 *
-		 * Job ending *in* the time window with the specified state.
-		 */
-		xstrfmtcat(*extra,
-		           "(t1.state='%u' && (t1.time_end && "
-		           "(t1.time_end between %ld and %ld)))",
-		           base_state, job_cond->usage_start,
-			   job_cond->usage_end);
-		break;
 	default:
 		error("Unsupported state requested: %s",
 		      job_state_string(base_state));
@@ -464,6 +507,63 @@ static void _destroy_local_cluster(void *object)
 	}
 }
 
+/*
+ * Get the next page of job rows, those with an id_job after *page_id and up to
+ * the id_job of the JOB_PAGE_ROWS'th row, so all rows of a job are in the same
+ * page and the MySQL client never holds every row at once.
+ * IN/OUT page_id - last id_job of the previous page (NO_VAL for first page),
+ *                  set to the last id_job of this page
+ * OUT last_page - set when no rows come after this page
+ */
+static MYSQL_RES *_get_job_page(mysql_conn_t *mysql_conn, char *job_fields,
+				char *from_where, bool has_where,
+				uint32_t *page_id, bool *last_page)
+{
+	char *query = NULL, *cond = NULL;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+
+	if (*page_id != NO_VAL)
+		xstrfmtcat(cond, " %s t1.id_job > %u",
+			   has_where ? "&&" : "where", *page_id);
+
+	query = xstrdup_printf("select t1.id_job %s%s "
+			       "order by t1.id_job limit 1 offset %d",
+			       from_where, cond ? cond : "",
+			       JOB_PAGE_ROWS - 1);
+	DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+	if (!result) {
+		xfree(cond);
+		return NULL;
+	}
+
+	if ((row = mysql_fetch_row(result))) {
+		*page_id = slurm_atoul(row[0]);
+		xstrfmtcat(cond, " %s t1.id_job <= %u",
+			   (has_where || cond) ? "&&" : "where", *page_id);
+		*last_page = false;
+	} else
+		*last_page = true;
+	mysql_free_result(result);
+
+	/* Here we want to order them this way in such a way so it is
+	   easy to look for duplicates, it is also easy to sort the
+	   resized jobs.
+	*/
+	query = xstrdup_printf("select %s %s%s "
+			       "order by id_job, time_submit desc",
+			       job_fields, from_where, cond ? cond : "");
+	xfree(cond);
+
+	DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+
+	return result;
+}
+
 static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			     slurmdb_user_rec_t *user,
 			     slurmdb_job_cond_t *job_cond,
@@ -472,8 +572,10 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			     char *sent_extra,
 			     bool is_admin, int only_pending, List sent_list)
 {
-	char *query = NULL;
+	char *query = NULL, *from_where = NULL;
 	char *extra = xstrdup(sent_extra);
+	bool has_where = false, last_page = true;
+	uint32_t page_id = NO_VAL;
 	slurm_selected_step_t *selected_step = NULL;
 	MYSQL_RES *result = NULL, *step_result = NULL;
 	MYSQL_ROW row, step_row;
@@ -555,7 +657,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	setup_job_cluster_cond_limits(mysql_conn, job_cond,
 				      cluster_name, &extra);
 
-	query = xstrdup_printf("select %s from \"%s_%s\" as t1 "
+	from_where = xstrdup_printf("from \"%s_%s\" as t1 "
 			       "left join \"%s_%s\" as t2 "
 			       "on t1.id_assoc=t2.id_assoc "
 			       "left join \"%s_%s\" as t3 "
@@ -569,7 +671,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 			       "(t3.time_end >= t1.time_submit || "
 			       "t3.time_end = 0)) || "
 			       "(t3.time_start > t1.time_submit))))",
-			       job_fields, cluster_name, job_table,
+			       cluster_name, job_table,
 			       cluster_name, assoc_table,
 			       cluster_name, resv_table);
 
@@ -581,23 +683,16 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	}
 
 	if (extra) {
-		xstrcat(query, extra);
+		xstrcat(from_where, extra);
 		xfree(extra);
+		has_where = true;
 	}
 
-	/* Here we want to order them this way in such a way so it is
-	   easy to look for duplicates, it is also easy to sort the
-	   resized jobs.
-	*/
-	xstrcat(query, " order by id_job, time_submit desc");
-
-	DB_DEBUG(DB_JOB, mysql_conn->conn, "query\n%s", query);
-	if (!(result = mysql_db_query_ret(mysql_conn, query, 0))) {
-		xfree(query);
+	if (!(result = _get_job_page(mysql_conn, job_fields, from_where,
+				     has_where, &page_id, &last_page))) {
 		rc = SLURM_ERROR;
 		goto end_it;
 	}
-	xfree(query);
 
 
 	/* Here we set up environment to check used nodes of jobs.
@@ -616,6 +711,7 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 		}
 	}
 
+next_page:
 	while ((row = mysql_fetch_row(result))) {
 		char *db_inx_char = row[JOB_REQ_DB_INX];
 		bool job_ended = 0;
@@ -1130,7 +1226,18 @@ static int _cluster_get_jobs(mysql_conn_t *mysql_conn,
 	}
 	mysql_free_result(result);
 
+	if (!last_page) {
+		if (!(result = _get_job_page(mysql_conn, job_fields,
+					     from_where, has_where,
+					     &page_id, &last_page))) {
+			rc = SLURM_ERROR;
+			goto end_it;
+		}
+		goto next_page;
+	}
+
 end_it:
+	xfree(from_where);
 	if (itr2)
 		list_iterator_destroy(itr2);
 
@@ -1335,24 +1442,13 @@ extern int setup_job_cluster_cond_limits(mysql_conn_t *mysql_conn,
 	}
 no_resv:
 
-	if (job_cond->resvid_list && list_count(job_cond->resvid_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-		itr = list_iterator_create(job_cond->resvid_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.id_resv='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
+	if (job_cond->resvid_list && list_count(job_cond->resvid_list))
+		_append_in_list(extra, "t1.id_resv", job_cond->resvid_list);
 
 	if (job_cond->state_list && list_count(job_cond->state_list)) {
+		char *end_states = NULL;
+		bool window = (job_cond->usage_start || job_cond->usage_end);
+
 		set = 0;
 		if (*extra)
 			xstrcat(*extra, " && (");
@@ -1361,15 +1457,35 @@ no_resv:
 
 		itr = list_iterator_create(job_cond->state_list);
 		while ((object = list_next(itr))) {
+			uint32_t state = slurm_atoul(object);
+
+			/*
+			 * States matched on the end time share one
+			 * "state in (...)" so it can use the state_end key
+			 */
+			if (window && _is_end_state(state)) {
+				xstrfmtcat(end_states, "%s'%u'",
+					   end_states ? ", " : "", state);
+				continue;
+			}
+
 			if (set)
 				xstrcat(*extra, " || ");
 
-			_state_time_string(extra, cluster_name,
-					   (uint32_t)slurm_atoul(object),
+			_state_time_string(extra, cluster_name, state,
 					   job_cond);
 			set = 1;
 		}
 		list_iterator_destroy(itr);
+
+		if (end_states) {
+			xstrfmtcat(*extra,
+				   "%s(t1.state in (%s) && (t1.time_end && "
+				   "(t1.time_end between %ld and %ld)))",
+				   set ? " || " : "", end_states,
+				   job_cond->usage_start, job_cond->usage_end);
+			xfree(end_states);
+		}
 		xstrcat(*extra, ")");
 	}
 
@@ -1382,51 +1498,23 @@ no_resv:
 	return SLURM_SUCCESS;
 }
 
-extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
-				 char **extra)
+extern void setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
+				  char **extra)
 {
 	int set = 0;
 	ListIterator itr = NULL;
 	char *object = NULL;
 
 	if (!job_cond || (job_cond->flags & JOBCOND_FLAG_RUNAWAY))
-		return 0;
+		return;
 
 	slurmdb_job_cond_def_start_end(job_cond);
 
-	if (job_cond->acct_list && list_count(job_cond->acct_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-		itr = list_iterator_create(job_cond->acct_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.account='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
+	if (job_cond->acct_list && list_count(job_cond->acct_list))
+		_append_in_list(extra, "t1.account", job_cond->acct_list);
 
-	if (job_cond->associd_list && list_count(job_cond->associd_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-		itr = list_iterator_create(job_cond->associd_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.id_assoc='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
+	if (job_cond->associd_list && list_count(job_cond->associd_list))
+		_append_in_list(extra, "t1.id_assoc", job_cond->associd_list);
 
 	if (job_cond->constraint_list &&
 	    list_count(job_cond->constraint_list)) {
@@ -1468,111 +1556,25 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 		xstrcat(*extra, ")");
 	}
 
-	if (job_cond->reason_list && list_count(job_cond->reason_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
+	if (job_cond->reason_list && list_count(job_cond->reason_list))
+		_append_in_list(extra, "t1.state_reason_prev",
+				job_cond->reason_list);
 
-		itr = list_iterator_create(job_cond->reason_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.state_reason_prev='%s'",
-				   object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
+	if (job_cond->userid_list && list_count(job_cond->userid_list))
+		_append_in_list(extra, "t1.id_user", job_cond->userid_list);
 
-	if (job_cond->userid_list && list_count(job_cond->userid_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
+	if (job_cond->groupid_list && list_count(job_cond->groupid_list))
+		_append_in_list(extra, "t1.id_group", job_cond->groupid_list);
 
-		itr = list_iterator_create(job_cond->userid_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.id_user='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
+	if (job_cond->jobname_list && list_count(job_cond->jobname_list))
+		_append_in_list(extra, "t1.job_name", job_cond->jobname_list);
 
-	if (job_cond->groupid_list && list_count(job_cond->groupid_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-		itr = list_iterator_create(job_cond->groupid_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.id_group='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
-
-	if (job_cond->jobname_list && list_count(job_cond->jobname_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-
-		itr = list_iterator_create(job_cond->jobname_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.job_name='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
-
-	if (job_cond->partition_list && list_count(job_cond->partition_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-		itr = list_iterator_create(job_cond->partition_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.partition='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
+	if (job_cond->partition_list && list_count(job_cond->partition_list))
+		_append_in_list(extra, "t1.partition",
+				job_cond->partition_list);
 
-	if (job_cond->qos_list && list_count(job_cond->qos_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-		itr = list_iterator_create(job_cond->qos_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.id_qos='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
+	if (job_cond->qos_list && list_count(job_cond->qos_list))
+		_append_in_list(extra, "t1.id_qos", job_cond->qos_list);
 
 	if (job_cond->cpus_min) {
 		if (*extra)
@@ -1680,24 +1682,8 @@ extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
 		}
 	}
 
-	if (job_cond->wckey_list && list_count(job_cond->wckey_list)) {
-		set = 0;
-		if (*extra)
-			xstrcat(*extra, " && (");
-		else
-			xstrcat(*extra, " where (");
-
-		itr = list_iterator_create(job_cond->wckey_list);
-		while ((object = list_next(itr))) {
-			if (set)
-				xstrcat(*extra, " || ");
-			xstrfmtcat(*extra, "t1.wckey='%s'", object);
-			set = 1;
-		}
-		list_iterator_destroy(itr);
-		xstrcat(*extra, ")");
-	}
-	return set;
+	if (job_cond->wckey_list && list_count(job_cond->wckey_list))
+		_append_in_list(extra, "t1.wckey", job_cond->wckey_list);
 }
 
 extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn,
@@ -54,8 +54,8 @@ extern int good_nodes_from_inx(List local_cluster_list,
 extern int setup_job_cluster_cond_limits(mysql_conn_t *mysql_conn,
 					 slurmdb_job_cond_t *job_cond,
 					 char *cluster_name, char **extra);
-extern int setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
-				 char **extra);
+extern void setup_job_cond_limits(slurmdb_job_cond_t *job_cond,
+				  char **extra);
 
 extern List as_mysql_jobacct_process_get_jobs(mysql_conn_t *mysql_conn, uid_t uid,
 					   slurmdb_job_cond_t *job_cond);
@@ -42,6 +42,7 @@
 #include "as_mysql_archive.h"
 #include "src/common/parse_time.h"
 #include "src/common/slurm_time.h"
+#include "src/common/xhash.h"
 
 enum {
 	TIME_ALLOC,
@@ -72,6 +73,13 @@ typedef struct {
 	List loc_tres;
 } local_id_usage_t;
 
+typedef struct {
+	int cnt;
+	time_t *end;
+	uint64_t job_db_inx;
+	time_t *start;
+} local_suspend_t;
+
 typedef struct {
 	time_t end;
 	int id; /*only needed for reservations */
@@ -139,14 +147,52 @@ static int _find_loc_tres(void *x, void *key)
 	return 0;
 }
 
-static int _find_id_usage(void *x, void *key)
+static void _destroy_local_suspend(void *object)
 {
-	local_id_usage_t *loc = (local_id_usage_t *)x;
-	uint32_t id = *(uint32_t *)key;
+	local_suspend_t *s_usage = (local_suspend_t *)object;
+	if (s_usage) {
+		xfree(s_usage->start);
+		xfree(s_usage->end);
+		xfree(s_usage);
+	}
+}
 
-	if (loc->id == id)
-		return 1;
-	return 0;
+static void _id_usage_key(void *item, const char **key, uint32_t *key_len)
+{
+	local_id_usage_t *usage = (local_id_usage_t *)item;
+
+	*key = (char *)&usage->id;
+	*key_len = sizeof(usage->id);
+}
+
+static void _suspend_key(void *item, const char **key, uint32_t *key_len)
+{
+	local_suspend_t *s_usage = (local_suspend_t *)item;
+
+	*key = (char *)&s_usage->job_db_inx;
+	*key_len = sizeof(s_usage->job_db_inx);
+}
+
+/*
+ * Find the usage record of id in the hour, making it if needed.
+ * The map only indexes usage_list, which owns the records.
+ */
+static local_id_usage_t *_get_id_usage(List usage_list, xhash_t *usage_map,
+				       int id, bool make_tres)
+{
+	local_id_usage_t *usage;
+
+	if ((usage = xhash_get(usage_map, (char *)&id, sizeof(id))))
+		return usage;
+
+	usage = xmalloc(sizeof(local_id_usage_t));
+	usage->id = id;
+	if (make_tres)
+		usage->loc_tres = list_create(_destroy_local_tres_usage);
+	list_append(usage_list, usage);
+	xhash_add(usage_map, usage);
+
+	return usage;
 }
 
 static void _remove_job_tres_time_from_cluster(List c_tres, List j_tres,
@@ -734,10 +780,15 @@ static int _process_cluster_usage(mysql_conn_t *mysql_conn,
 	return rc;
 }
 
+/*
+ * Append the usage insert of id_usage to *query. *query_pos tracks the end
+ * of *query so appending for every association or wckey doesn't rescan the
+ * whole statement each time.
+ */
 static void _create_id_usage_insert(char *cluster_name, int type,
 				    time_t curr_start, time_t now,
 				    local_id_usage_t *id_usage,
-				    char **query)
+				    char **query, char **query_pos)
 {
 	local_tres_usage_t *loc_tres;
 	ListIterator itr;
@@ -770,27 +821,28 @@ static void _create_id_usage_insert(char *cluster_name, int type,
 	itr = list_iterator_create(id_usage->loc_tres);
 	while ((loc_tres = list_next(itr))) {
 		if (!first) {
-			xstrfmtcat(*query,
-				   ", (%ld, %ld, %u, %ld, %u, %"PRIu64")",
-				   now, now,
-				   id_usage->id, curr_start, loc_tres->id,
-				   loc_tres->time_alloc);
+			xstrfmtcatat(*query, query_pos,
+				     ", (%ld, %ld, %u, %ld, %u, %"PRIu64")",
+				     now, now,
+				     id_usage->id, curr_start, loc_tres->id,
+				     loc_tres->time_alloc);
 		} else {
-			xstrfmtcat(*query,
-				   "insert into \"%s_%s\" "
-				   "(creation_time, mod_time, id, "
-				   "time_start, id_tres, alloc_secs) "
-				   "values (%ld, %ld, %u, %ld, %u, %"PRIu64")",
-				   cluster_name, table, now, now,
-				   id_usage->id, curr_start, loc_tres->id,
-				   loc_tres->time_alloc);
+			xstrfmtcatat(*query, query_pos,
+				     "insert into \"%s_%s\" "
+				     "(creation_time, mod_time, id, "
+				     "time_start, id_tres, alloc_secs) "
+				     "values (%ld, %ld, %u, %ld, %u, "
+				     "%"PRIu64")",
+				     cluster_name, table, now, now,
+				     id_usage->id, curr_start, loc_tres->id,
+				     loc_tres->time_alloc);
 			first = 0;
 		}
 	}
 	list_iterator_destroy(itr);
-	xstrfmtcat(*query,
-		   " on duplicate key update mod_time=%ld, "
-		   "alloc_secs=VALUES(alloc_secs);", now);
+	xstrfmtcatat(*query, query_pos,
+		     " on duplicate key update mod_time=%ld, "
+		     "alloc_secs=VALUES(alloc_secs);", now);
 }
 
 static int _add_resv_usage_to_cluster(void *object, void *arg)
@@ -1076,6 +1128,87 @@ static local_cluster_usage_t *_setup_cluster_usage(mysql_conn_t *mysql_conn,
 	return c_usage;
 }
 
+/*
+ * Load every suspension overlapping the hour with one query instead of one
+ * per suspended job.
+ */
+static int _setup_suspend_usage(mysql_conn_t *mysql_conn, char *cluster_name,
+				time_t curr_start, time_t curr_end,
+				xhash_t *suspend_map)
+{
+	char *query;
+	MYSQL_RES *result = NULL;
+	MYSQL_ROW row;
+	local_suspend_t *s_usage = NULL;
+
+	query = xstrdup_printf("select job_db_inx, time_start, time_end "
+			       "from \"%s_%s\" where "
+			       "(time_start < %ld && (time_end >= %ld "
+			       "|| time_end = 0)) "
+			       "order by job_db_inx, time_start",
+			       cluster_name, suspend_table,
+			       curr_end, curr_start);
+
+	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
+	result = mysql_db_query_ret(mysql_conn, query, 0);
+	xfree(query);
+
+	if (!result)
+		return SLURM_ERROR;
+
+	while ((row = mysql_fetch_row(result))) {
+		uint64_t job_db_inx = slurm_atoull(row[0]);
+
+		if (!s_usage || (s_usage->job_db_inx != job_db_inx)) {
+			s_usage = xmalloc(sizeof(local_suspend_t));
+			s_usage->job_db_inx = job_db_inx;
+			xhash_add(suspend_map, s_usage);
+		}
+
+		if (!(s_usage->cnt % 8)) {
+			xrecalloc(s_usage->start, s_usage->cnt + 8,
+				  sizeof(time_t));
+			xrecalloc(s_usage->end, s_usage->cnt + 8,
+				  sizeof(time_t));
+		}
+		s_usage->start[s_usage->cnt] = slurm_atoul(row[1]);
+		s_usage->end[s_usage->cnt] = slurm_atoul(row[2]);
+		s_usage->cnt++;
+	}
+	mysql_free_result(result);
+
+	return SLURM_SUCCESS;
+}
+
+static int _get_suspend_seconds(local_suspend_t *s_usage,
+				time_t row_start, time_t row_end)
+{
+	int suspend_seconds = 0;
+
+	if (!s_usage)
+		return 0;
+
+	for (int i = 0; i < s_usage->cnt; i++) {
+		int tot_time = 0;
+		time_t local_start = s_usage->start[i];
+		time_t local_end = s_usage->end[i];
+
+		if (!local_start)
+			continue;
+
+		if (row_start > local_start)
+			local_start = row_start;
+		if (!local_end || row_end < local_end)
+			local_end = row_end;
+		tot_time = (local_end - local_start);
+
+		if (tot_time > 0)
+			suspend_seconds += tot_time;
+	}
+
+	return suspend_seconds;
+}
+
 extern int _setup_resv_usage(mysql_conn_t *mysql_conn,
 			     char *cluster_name,
 			     time_t curr_start,
@@ -1222,7 +1355,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	time_t now = time(NULL);
 	time_t curr_start = start;
 	time_t curr_end = curr_start + add_sec;
-	char *query = NULL;
+	char *query = NULL, *query_pos = NULL;
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
 	ListIterator a_itr = NULL;
@@ -1233,6 +1366,11 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	List cluster_down_list = list_create(_destroy_local_cluster_usage);
 	List wckey_usage_list = list_create(_destroy_local_id_usage);
 	List resv_usage_list = list_create(_destroy_local_resv_usage);
+	xhash_t *assoc_usage_map = xhash_init(_id_usage_key, NULL);
+	xhash_t *wckey_usage_map = xhash_init(_id_usage_key, NULL);
+	xhash_t *suspend_map = xhash_init(_suspend_key,
+					  _destroy_local_suspend);
+	bool suspend_loaded;
 	uint16_t track_wckey = slurm_get_track_wckey();
 	local_cluster_usage_t *loc_c_usage = NULL;
 	local_cluster_usage_t *c_usage = NULL;
@@ -1272,29 +1410,12 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		JOB_REQ_COUNT
 	};
 
-	char *suspend_req_inx[] = {
-		"time_start",
-		"time_end"
-	};
-	char *suspend_str = NULL;
-	enum {
-		SUSPEND_REQ_START,
-		SUSPEND_REQ_END,
-		SUSPEND_REQ_COUNT
-	};
-
 	i=0;
 	xstrfmtcat(job_str, "%s", job_req_inx[i]);
 	for(i=1; i<JOB_REQ_COUNT; i++) {
 		xstrfmtcat(job_str, ", %s", job_req_inx[i]);
 	}
 
-	i=0;
-	xstrfmtcat(suspend_str, "%s", suspend_req_inx[i]);
-	for(i=1; i<SUSPEND_REQ_COUNT; i++) {
-		xstrfmtcat(suspend_str, ", %s", suspend_req_inx[i]);
-	}
-
 	/* We need to figure out the dimensions of this cluster */
 	query = xstrdup_printf("select dimensions from %s where name='%s'",
 			       cluster_table, cluster_name);
@@ -1329,6 +1450,8 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		int last_id = -1;
 		int last_wckeyid = -1;
 
+		suspend_loaded = false;
+
 		DB_DEBUG(DB_USAGE, mysql_conn->conn,
 		         "%s curr hour is now %ld-%ld",
 		         cluster_name, curr_start, curr_end);
@@ -1372,6 +1495,7 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 		while ((row = mysql_fetch_row(result))) {
 			//uint32_t job_id = slurm_atoul(row[JOB_REQ_JOBID]);
+			uint64_t job_db_inx = slurm_atoull(row[JOB_REQ_DB_INX]);
 			uint32_t assoc_id = slurm_atoul(row[JOB_REQ_ASSOCID]);
 			uint32_t wckey_id = slurm_atoul(row[JOB_REQ_WCKEYID]);
 			uint32_t array_pending =
@@ -1400,60 +1524,33 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			seconds = (row_end - row_start);
 
 			if (slurm_atoul(row[JOB_REQ_SUSPENDED])) {
-				MYSQL_RES *result2 = NULL;
-				MYSQL_ROW row2;
 				/* get the suspended time for this job */
-				query = xstrdup_printf(
-					"select %s from \"%s_%s\" where "
-					"(time_start < %ld && (time_end >= %ld "
-					"|| time_end = 0)) && job_db_inx=%s "
-					"order by time_start",
-					suspend_str, cluster_name,
-					suspend_table,
-					curr_end, curr_start,
-					row[JOB_REQ_DB_INX]);
-
-				debug4("%d(%s:%d) query\n%s",
-				       mysql_conn->conn, THIS_FILE,
-				       __LINE__, query);
-				if (!(result2 = mysql_db_query_ret(
-					      mysql_conn,
-					      query, 0))) {
-					rc = SLURM_ERROR;
-					mysql_free_result(result);
-					goto end_it;
-				}
-				xfree(query);
-				while ((row2 = mysql_fetch_row(result2))) {
-					int tot_time = 0;
-					time_t local_start = slurm_atoul(
-						row2[SUSPEND_REQ_START]);
-					time_t local_end = slurm_atoul(
-						row2[SUSPEND_REQ_END]);
-
-					if (!local_start)
-						continue;
-
-					if (row_start > local_start)
-						local_start = row_start;
-					if (!local_end || row_end < local_end)
-						local_end = row_end;
-					tot_time = (local_end - local_start);
-
-					if (tot_time > 0)
-						suspend_seconds += tot_time;
+				if (!suspend_loaded) {
+					if ((rc = _setup_suspend_usage(
+						     mysql_conn, cluster_name,
+						     curr_start, curr_end,
+						     suspend_map))
+					    != SLURM_SUCCESS) {
+						mysql_free_result(result);
+						goto end_it;
+					}
+					suspend_loaded = true;
 				}
-				mysql_free_result(result2);
+				suspend_seconds = _get_suspend_seconds(
+					xhash_get(suspend_map,
+						  (char *)&job_db_inx,
+						  sizeof(job_db_inx)),
+					row_start, row_end);
 			}
 
 			if (last_id != assoc_id) {
-				a_usage = xmalloc(sizeof(local_id_usage_t));
-				a_usage->id = assoc_id;
-				list_append(assoc_usage_list, a_usage);
-				last_id = assoc_id;
 				/* a_usage->loc_tres is made later,
 				   don't do it here.
 				*/
+				a_usage = _get_id_usage(assoc_usage_list,
+							assoc_usage_map,
+							assoc_id, false);
+				last_id = assoc_id;
 			}
 
 			/* Short circuit this so so we don't get a pointer. */
@@ -1462,20 +1559,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 
 			/* do the wckey calculation */
 			if (last_wckeyid != wckey_id) {
-				list_iterator_reset(w_itr);
-				while ((w_usage = list_next(w_itr)))
-					if (w_usage->id == wckey_id)
-						break;
-
-				if (!w_usage) {
-					w_usage = xmalloc(
-						sizeof(local_id_usage_t));
-					w_usage->id = wckey_id;
-					list_append(wckey_usage_list,
-						    w_usage);
-					w_usage->loc_tres = list_create(
-						_destroy_local_tres_usage);
-				}
+				w_usage = _get_id_usage(wckey_usage_list,
+							wckey_usage_map,
+							wckey_id, true);
 				last_wckeyid = wckey_id;
 			}
 
@@ -1679,15 +1765,17 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		   associations that could had run in the reservation
 		*/
 		query = NULL;
+		query_pos = NULL;
 		list_iterator_reset(r_itr);
 		while ((r_usage = list_next(r_itr))) {
 			ListIterator t_itr;
 			local_tres_usage_t *loc_tres;
 
-			xstrfmtcat(query, "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
-				   cluster_name, resv_table,
-				   r_usage->unused_wall, r_usage->id,
-				   r_usage->orig_start);
+			xstrfmtcatat(query, &query_pos,
+				     "update \"%s_%s\" set unused_wall=%f where id_resv=%u and time_start=%ld;",
+				     cluster_name, resv_table,
+				     r_usage->unused_wall, r_usage->id,
+				     r_usage->orig_start);
 
 			if (!r_usage->loc_tres ||
 			    !list_count(r_usage->loc_tres))
@@ -1721,20 +1809,16 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 					r_usage->local_assocs);
 				while ((assoc = list_next(tmp_itr))) {
 					uint32_t associd = slurm_atoul(assoc);
-					if ((last_id != associd) &&
-					    !(a_usage = list_find_first(
-						      assoc_usage_list,
-						      _find_id_usage,
-						      &associd))) {
-						a_usage = xmalloc(
-							sizeof(local_id_usage_t));
-						a_usage->id = associd;
-						list_append(assoc_usage_list,
-							    a_usage);
+					if (last_id != associd) {
+						a_usage = _get_id_usage(
+							assoc_usage_list,
+							assoc_usage_map,
+							associd, true);
 						last_id = associd;
+					}
+					if (!a_usage->loc_tres)
 						a_usage->loc_tres = list_create(
 							_destroy_local_tres_usage);
-					}
 
 					_add_time_tres(a_usage->loc_tres,
 						       TIME_ALLOC, loc_tres->id,
@@ -1781,10 +1865,11 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		}
 
 		list_iterator_reset(a_itr);
+		query_pos = NULL;
 		while ((a_usage = list_next(a_itr)))
 			_create_id_usage_insert(cluster_name, ASSOC_TABLES,
 						curr_start, now,
-						a_usage, &query);
+						a_usage, &query, &query_pos);
 		if (query) {
 			DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s",
 			         query);
@@ -1800,10 +1885,11 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 			goto end_loop;
 
 		list_iterator_reset(w_itr);
+		query_pos = NULL;
 		while ((w_usage = list_next(w_itr)))
 			_create_id_usage_insert(cluster_name, WCKEY_TABLES,
 						curr_start, now,
-						w_usage, &query);
+						w_usage, &query, &query_pos);
 		if (query) {
 			DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s",
 			         query);
@@ -1823,6 +1909,9 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 		a_usage     = NULL;
 		w_usage     = NULL;
 
+		xhash_clear(assoc_usage_map);
+		xhash_clear(wckey_usage_map);
+		xhash_clear(suspend_map);
 		list_flush(assoc_usage_list);
 		list_flush(cluster_down_list);
 		list_flush(wckey_usage_list);
@@ -1832,7 +1921,6 @@ extern int as_mysql_hourly_rollup(mysql_conn_t *mysql_conn,
 	}
 end_it:
 	xfree(query);
-	xfree(suspend_str);
 	xfree(job_str);
 	_destroy_local_cluster_usage(c_usage);
 
@@ -1845,6 +1933,9 @@ end_it:
 	if (r_itr)
 		list_iterator_destroy(r_itr);
 
+	xhash_free(assoc_usage_map);
+	xhash_free(wckey_usage_map);
+	xhash_free(suspend_map);
 	FREE_NULL_LIST(assoc_usage_list);
 	FREE_NULL_LIST(cluster_down_list);
 	FREE_NULL_LIST(wckey_usage_list);
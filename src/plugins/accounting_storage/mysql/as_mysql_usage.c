@@ -410,13 +410,18 @@ end_it:
 	return NULL;
 }
 
-/* assoc_mgr locks need to be unlocked before coming here */
+/*
+ * assoc_mgr locks need to be unlocked before coming here
+ * IN summed - one record per object and TRES with the usage summed over the
+ *	time range instead of one per usage period
+ */
 static int _get_object_usage(mysql_conn_t *mysql_conn,
 			     slurmdbd_msg_type_t type, char *my_usage_table,
 			     char *cluster_name, char *id_str,
-			     time_t start, time_t end, List *usage_list)
+			     time_t start, time_t end, bool summed,
+			     List *usage_list)
 {
-	char *tmp = NULL;
+	char *tmp = NULL, *group_by;
 	int i = 0;
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
@@ -441,6 +446,16 @@ static int _get_object_usage(mysql_conn_t *mysql_conn,
 	if (type == DBD_GET_WCKEY_USAGE)
 		usage_req_inx[0] = "t1.id";
 
+	if (summed) {
+		usage_req_inx[USAGE_START] = "min(t1.time_start)";
+		usage_req_inx[USAGE_ALLOC] = "sum(t1.alloc_secs)";
+		group_by = xstrdup_printf("group by %s, t1.id_tres order by %s",
+					  usage_req_inx[USAGE_ID],
+					  usage_req_inx[USAGE_ID]);
+	} else
+		group_by = xstrdup_printf("order by %s, time_start",
+					  usage_req_inx[USAGE_ID]);
+
 	xstrfmtcat(tmp, "%s", usage_req_inx[i]);
 	for (i=1; i<USAGE_COUNT; i++) {
 		xstrfmtcat(tmp, ", %s", usage_req_inx[i]);
@@ -453,26 +468,28 @@ static int _get_object_usage(mysql_conn_t *mysql_conn,
 			"\"%s_%s\" as t2, \"%s_%s\" as t3 "
 			"where (t1.time_start < %ld && t1.time_start >= %ld) "
 			"&& t1.id=t2.id_assoc && (%s) && "
-			"t2.lft between t3.lft and t3.rgt "
-			"order by t3.id_assoc, time_start;",
+			"t2.lft between t3.lft and t3.rgt %s;",
 			tmp, cluster_name, my_usage_table,
 			cluster_name, assoc_table, cluster_name, assoc_table,
-			end, start, id_str);
+			end, start, id_str, group_by);
 		break;
 	case DBD_GET_WCKEY_USAGE:
 		query = xstrdup_printf(
 			"select %s from \"%s_%s\" as t1 "
 			"where (time_start < %ld && time_start >= %ld) "
-			"&& (%s) order by id, time_start;",
-			tmp, cluster_name, my_usage_table, end, start, id_str);
+			"&& (%s) %s;",
+			tmp, cluster_name, my_usage_table, end, start, id_str,
+			group_by);
 		break;
 	default:
 		error("Unknown usage type %d", type);
 		xfree(tmp);
+		xfree(group_by);
 		return SLURM_ERROR;
 		break;
 	}
 	xfree(tmp);
+	xfree(group_by);
 
 	DB_DEBUG(DB_USAGE, mysql_conn->conn, "query\n%s", query);
 	result = mysql_db_query_ret(mysql_conn, query, 0);
@@ -625,7 +642,8 @@ static int _get_cluster_usage(mysql_conn_t *mysql_conn, uid_t uid,
 */
 extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 			      slurmdbd_msg_type_t type, List object_list,
-			      char *cluster_name, time_t start, time_t end)
+			      char *cluster_name, time_t start, time_t end,
+			      bool summed)
 {
 	int rc = SLURM_SUCCESS;
 	char *my_usage_table = NULL;
@@ -688,7 +706,7 @@ extern int get_usage_for_list(mysql_conn_t *mysql_conn,
 	}
 
 	if (_get_object_usage(mysql_conn, type, my_usage_table, cluster_name,
-			      id_str, start, end, &usage_list)
+			      id_str, start, end, summed, &usage_list)
 	    != SLURM_SUCCESS) {
 		xfree(id_str);
 		return SLURM_ERROR;
@@ -878,7 +896,7 @@ is_user:
 	}
 
 	_get_object_usage(mysql_conn, type, my_usage_table, cluster_name,
-			  id_str, start, end, my_list);
+			  id_str, start, end, false, my_list);
 	xfree(id_str);
 
 	return rc;
@@ -891,7 +909,9 @@ extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn, time_t sent_start,
 	int rc = SLURM_SUCCESS;
 	int rolledup = 0;
 	int roll_started = 0;
+	int max_threads = 0;
 	char *cluster_name = NULL;
+	List cluster_list;
 	ListIterator itr;
 	pthread_mutex_t rolledup_lock = PTHREAD_MUTEX_INITIALIZER;
 	pthread_cond_t rolledup_cond;
@@ -909,10 +929,35 @@ extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn, time_t sent_start,
 	//START_TIMER;
 	xassert(!*rollup_stats_list_in);
 	*rollup_stats_list_in = list_create(slurmdb_destroy_rollup_stats);
+
+	if (slurmdbd_conf)
+		max_threads = slurmdbd_conf->rollup_threads;
+
+	/*
+	 * Work from a copy so as_mysql_cluster_list_lock is not held while
+	 * waiting for a rollup thread to free up.
+	 */
+	cluster_list = list_create(xfree_ptr);
 	slurm_rwlock_rdlock(&as_mysql_cluster_list_lock);
 	itr = list_iterator_create(as_mysql_cluster_list);
+	while ((cluster_name = list_next(itr)))
+		list_append(cluster_list, xstrdup(cluster_name));
+	list_iterator_destroy(itr);
+	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
+
+	itr = list_iterator_create(cluster_list);
 	while ((cluster_name = list_next(itr))) {
-		local_rollup_t *local_rollup = xmalloc(sizeof(local_rollup_t));
+		local_rollup_t *local_rollup;
+
+		if (max_threads) {
+			slurm_mutex_lock(&rolledup_lock);
+			while ((roll_started - rolledup) >= max_threads)
+				slurm_cond_wait(&rolledup_cond,
+						&rolledup_lock);
+			slurm_mutex_unlock(&rolledup_lock);
+		}
+
+		local_rollup = xmalloc(sizeof(local_rollup_t));
 		local_rollup->archive_data = archive_data;
 		local_rollup->cluster_name = cluster_name;
 
@@ -932,26 +977,21 @@ extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn, time_t sent_start,
 		list_append(*rollup_stats_list_in, local_rollup->rollup_stats);
 		/* _cluster_rollup_usage is responsible for freeing
 		   this local_rollup */
-		/* If you have many jobs in your system the
-		 * _cluster_rollup_usage call takes up a bunch of time
-		 * and all the while the as_mysql_cluster_list_lock is
-		 * locked.  If a slurmctld is starting up while this
-		 * is locked it will hang waiting to get information
-		 * from the DBD.  So threading this makes a lot of
-		 * sense.  While it only buys a very small victory in
-		 * terms of speed, having the
-		 * as_mysql_cluster_list_lock lock unlock in a timely
-		 * fashion buys a bunch on systems with lots
-		 * (millions) of jobs.
+		/*
+		 * Each cluster is rolled up in its own thread with its own
+		 * database connection, so one big cluster does not hold up
+		 * the others. Parameters=rollup_threads limits how many run
+		 * at once.
 		 */
+		slurm_mutex_lock(&rolledup_lock);
+		roll_started++;
+		slurm_mutex_unlock(&rolledup_lock);
 		slurm_thread_create_detached(NULL, _cluster_rollup_usage,
 					     local_rollup);
-		roll_started++;
 	}
-	slurm_mutex_lock(&rolledup_lock);
 	list_iterator_destroy(itr);
-	slurm_rwlock_unlock(&as_mysql_cluster_list_lock);
 
+	slurm_mutex_lock(&rolledup_lock);
 	while (rolledup < roll_started) {
 		slurm_cond_wait(&rolledup_cond, &rolledup_lock);
 		debug2("Got %d of %d rolled up", rolledup, roll_started);
@@ -960,6 +1000,7 @@ extern int as_mysql_roll_usage(mysql_conn_t *mysql_conn, time_t sent_start,
 	debug2("Everything rolled up");
 	slurm_mutex_destroy(&rolledup_lock);
 	slurm_cond_destroy(&rolledup_cond);
+	FREE_NULL_LIST(cluster_list);
 	/* END_TIMER; */
 	/* info("total time was %s", TIME_STR); */
 
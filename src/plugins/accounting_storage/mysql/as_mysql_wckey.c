@@ -424,7 +424,7 @@ static int _cluster_get_wckeys(mysql_conn_t *mysql_conn,
 	MYSQL_RES *result = NULL;
 	MYSQL_ROW row;
 	char *query = NULL;
-	bool with_usage = 0;
+	uint16_t with_usage = 0;
 
 	if (wckey_cond)
 		with_usage = wckey_cond->with_usage;
@@ -477,7 +477,8 @@ static int _cluster_get_wckeys(mysql_conn_t *mysql_conn,
 		get_usage_for_list(mysql_conn, DBD_GET_WCKEY_USAGE,
 				   wckey_list, cluster_name,
 				   wckey_cond->usage_start,
-				   wckey_cond->usage_end);
+				   wckey_cond->usage_end,
+				   (with_usage == SLURMDB_USAGE_SUMMED));
 	list_transfer(sent_list, wckey_list);
 	FREE_NULL_LIST(wckey_list);
 	return SLURM_SUCCESS;
@@ -41,6 +41,7 @@
 
 #include "src/common/fd.h"
 #include "src/common/slurmdbd_pack.h"
+#include "src/common/xhash.h"
 #include "src/common/xsignal.h"
 #include "src/common/xstring.h"
 
@@ -57,11 +58,40 @@ slurm_persist_conn_t *slurmdbd_conn = NULL;
 #define DBD_MAGIC		0xDEAD3219
 #define DEBUG_PRINT_MAX_MSG_TYPES 10
 #define MAX_DBD_DEFAULT_ACTION MAX_DBD_ACTION_DISCARD
+#define DBD_AGENT_BATCH_MAX	1000	/* records per DBD_SEND_MULT_MSG */
+#define DEFAULT_DBD_AGENT_WINDOW 4	/* DBD_SEND_MULT_MSG in flight */
+#define MAX_DBD_AGENT_WINDOW	64
+#define DBD_SPOOL_SEGMENT_SIZE	(64 * 1024 * 1024) /* bytes per spool file */
+
+/* spool file of agent_list records */
+typedef struct {
+	uint32_t id;		/* dbd.spool.<id> */
+	uint32_t count;		/* records in file */
+	uint64_t first_seq;	/* sequence number of first record */
+	uint32_t live;		/* records not yet released */
+} spool_seg_t;
+
+/* spooled record queued in agent_list */
+typedef struct {
+	buf_t *buffer;		/* record in agent_list, the spool_recs key */
+	uint64_t seq;		/* sequence number in the spool */
+} spool_rec_t;
+
+/* agent_list records sent in one DBD_SEND_MULT_MSG */
+typedef struct {
+	buf_t **msgs;
+	uint32_t count;
+} agent_batch_t;
 
 static pthread_mutex_t agent_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  agent_cond = PTHREAD_COND_INITIALIZER;
 static List      agent_list     = (List) NULL;
 static pthread_t agent_tid      = 0;
+/*
+ * Number of records at the head of agent_list that have been sent and not yet
+ * acknowledged. These must not be purged. Protected by agent_lock.
+ */
+static uint32_t  agent_inflight = 0;
 
 static bool      halt_agent          = 0;
 static time_t    slurmdbd_shutdown   = 0;
@@ -70,6 +100,599 @@ static pthread_mutex_t slurmdbd_lock = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  slurmdbd_cond = PTHREAD_COND_INITIALIZER;
 
 static int max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
+static int agent_window = DEFAULT_DBD_AGENT_WINDOW;
+
+/*
+ * SlurmctldParameters=dbd_agent_spool: every record added to agent_list is
+ * also appended to a dbd.spool.<id> file with the next sequence number.
+ * Records leaving agent_list (acknowledged in any order, purged or skipped
+ * on load) have their sequence numbers appended to the spool as a tombstone,
+ * so they are not replayed. Files are removed once all of their records have
+ * been released and all older files are gone. All of the spool state is
+ * protected by agent_lock.
+ */
+static bool spool_enabled = false;
+static List spool_segs = NULL;		/* spool_seg_t, oldest first */
+static spool_seg_t *spool_cur = NULL;	/* file open for append */
+static int spool_fd = -1;		/* fd of spool_cur */
+static uint32_t spool_size = 0;		/* bytes written to spool_cur */
+static uint32_t spool_next_id = 0;	/* id of next spool file */
+static uint64_t spool_next_seq = 0;	/* sequence number of next record */
+static xhash_t *spool_recs = NULL;	/* spool_rec_t by agent_list buffer */
+/* sequence numbers released since the last tombstone was written */
+static uint64_t *spool_released = NULL;
+static uint32_t spool_released_cnt = 0;
+static uint32_t spool_released_size = 0;
+
+static void _free_agent_batch(void *x)
+{
+	agent_batch_t *batch = x;
+
+	if (!batch)
+		return;
+
+	xfree(batch->msgs);
+	xfree(batch);
+}
+
+/*
+ * Spool file format: A dbd.spool.head file holds the id of the oldest spool
+ * file. Each dbd.spool.<id> file starts with a header record of "VER%d" and
+ * the sequence number of its first record. Later records are either queued
+ * records, starting with their message type, or tombstones, being a zero
+ * message type and an array of released sequence numbers. Each is written as
+ * the record size, FNV-1a hash of the record, the record and DBD_MAGIC. A
+ * record that fails to validate ends the file, as happens when slurmctld dies
+ * in the middle of appending it.
+ */
+static uint32_t _spool_hash(const char *data, uint32_t size)
+{
+	uint32_t hash = 2166136261U;
+
+	for (uint32_t i = 0; i < size; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+static char *_spool_fname(uint32_t id)
+{
+	return xstrdup_printf("%s/dbd.spool.%u",
+			      slurm_conf.state_save_location, id);
+}
+
+static int _spool_write(int fd, const void *data, size_t size)
+{
+	const char *ptr = data;
+
+	while (size) {
+		ssize_t wrote = write(fd, ptr, size);
+
+		if (wrote > 0) {
+			ptr += wrote;
+			size -= wrote;
+		} else if ((wrote == -1) && (errno == EINTR))
+			continue;
+		else
+			return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static int _spool_write_rec(int fd, buf_t *buffer)
+{
+	uint32_t hdr[2], magic = DBD_MAGIC;
+
+	hdr[0] = get_buf_offset(buffer);
+	hdr[1] = _spool_hash(get_buf_data(buffer), hdr[0]);
+
+	if (_spool_write(fd, hdr, sizeof(hdr)) ||
+	    _spool_write(fd, get_buf_data(buffer), hdr[0]) ||
+	    _spool_write(fd, &magic, sizeof(magic)))
+		return SLURM_ERROR;
+
+	spool_size += sizeof(hdr) + hdr[0] + sizeof(magic);
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Read next spool record from the mmap()ed spool file in spool_buf
+ * RET record or NULL on end of file or invalid record
+ */
+static buf_t *_spool_read_rec(buf_t *spool_buf)
+{
+	uint32_t hdr[2], magic, offset = get_buf_offset(spool_buf);
+	char *data = get_buf_data(spool_buf) + offset;
+	buf_t *buffer;
+
+	if (remaining_buf(spool_buf) < (sizeof(hdr) + sizeof(magic)))
+		return NULL;
+	memcpy(hdr, data, sizeof(hdr));
+	if ((hdr[0] > MAX_DBD_MSG_LEN) ||
+	    ((remaining_buf(spool_buf) - sizeof(hdr) - sizeof(magic)) <
+	     hdr[0]))
+		return NULL;
+	memcpy(&magic, (data + sizeof(hdr) + hdr[0]), sizeof(magic));
+	if ((magic != DBD_MAGIC) ||
+	    (hdr[1] != _spool_hash((data + sizeof(hdr)), hdr[0])))
+		return NULL;
+
+	buffer = init_buf(hdr[0]);
+	memcpy(get_buf_data(buffer), (data + sizeof(hdr)), hdr[0]);
+	set_buf_offset(buffer, hdr[0]);
+	set_buf_offset(spool_buf,
+		       (offset + sizeof(hdr) + hdr[0] + sizeof(magic)));
+
+	return buffer;
+}
+
+static void _spool_save_head(void)
+{
+	char *fname = NULL, str[32];
+	spool_seg_t *seg = (spool_segs ? list_peek(spool_segs) : NULL);
+	int fd;
+
+	snprintf(str, sizeof(str), "%u\n", (seg ? seg->id : spool_next_id));
+
+	xstrfmtcat(fname, "%s/dbd.spool.head", slurm_conf.state_save_location);
+	if (((fd = open(fname, (O_WRONLY | O_CREAT | O_TRUNC), 0600)) < 0) ||
+	    _spool_write(fd, str, strlen(str)))
+		error("%s: unable to write %s: %m", __func__, fname);
+	if (fd >= 0)
+		(void) close(fd);
+	xfree(fname);
+}
+
+static void _spool_close(void)
+{
+	if (spool_fd < 0)
+		return;
+
+	if (fsync_and_close(spool_fd, "dbd.spool"))
+		error("%s: error from fsync_and_close", __func__);
+	spool_fd = -1;
+	spool_cur = NULL;
+}
+
+/* Remove oldest spool file */
+static void _spool_remove_first(void)
+{
+	spool_seg_t *seg = list_pop(spool_segs);
+	char *fname = _spool_fname(seg->id);
+
+	if (seg == spool_cur) {
+		(void) close(spool_fd);
+		spool_fd = -1;
+		spool_cur = NULL;
+	}
+
+	if ((unlink(fname) == -1) && (errno != ENOENT))
+		error("%s: unable to remove %s: %m", __func__, fname);
+
+	xfree(fname);
+	xfree(seg);
+}
+
+static int _spool_open(void)
+{
+	char *fname, ver_str[10];
+	spool_seg_t *seg;
+	buf_t *buffer;
+	int rc;
+
+	_spool_close();
+
+	seg = xmalloc(sizeof(*seg));
+	seg->id = spool_next_id++;
+	seg->first_seq = spool_next_seq;
+	fname = _spool_fname(seg->id);
+
+	if ((spool_fd = open(fname, (O_WRONLY | O_CREAT | O_TRUNC | O_APPEND),
+			     0600)) < 0) {
+		error("%s: unable to create %s: %m", __func__, fname);
+		xfree(fname);
+		xfree(seg);
+		return SLURM_ERROR;
+	}
+	fd_set_close_on_exec(spool_fd);
+	xfree(fname);
+
+	spool_size = 0;
+	snprintf(ver_str, sizeof(ver_str), "VER%d", SLURM_PROTOCOL_VERSION);
+	buffer = init_buf(strlen(ver_str) + 16);
+	packstr(ver_str, buffer);
+	pack64(seg->first_seq, buffer);
+	rc = _spool_write_rec(spool_fd, buffer);
+	free_buf(buffer);
+
+	/* add even on failure so the file gets removed */
+	list_append(spool_segs, seg);
+	spool_cur = seg;
+
+	/* head file must name the oldest file before anything is in it */
+	if (list_count(spool_segs) == 1)
+		_spool_save_head();
+
+	return rc;
+}
+
+/*
+ * Stop spooling after an error. _save_dbd_state() will then write all of
+ * agent_list to dbd.messages and remove the spool files.
+ */
+static void _spool_fail(void)
+{
+	error("slurmdbd agent spool failed, pending RPCs will only be saved on shutdown");
+	if (spool_fd >= 0)
+		(void) close(spool_fd);
+	spool_fd = -1;
+	spool_cur = NULL;
+	spool_enabled = false;
+}
+
+static void _spool_rec_id(void *item, const char **key, uint32_t *key_len)
+{
+	spool_rec_t *rec = item;
+
+	*key = (const char *) &rec->buffer;
+	*key_len = sizeof(rec->buffer);
+}
+
+/* Track a spooled record added to agent_list */
+static void _spool_rec_add(buf_t *buffer, spool_seg_t *seg, uint64_t seq)
+{
+	spool_rec_t *rec = xmalloc(sizeof(*rec));
+
+	rec->buffer = buffer;
+	rec->seq = seq;
+	if (!spool_recs)
+		spool_recs = xhash_init(_spool_rec_id, xfree_ptr);
+	xhash_add(spool_recs, rec);
+	if (seg)
+		seg->live++;
+}
+
+/* Queue seq to be written in the next tombstone */
+static void _spool_tombstone(uint64_t seq)
+{
+	if (spool_released_cnt >= spool_released_size) {
+		spool_released_size = MAX(1024, (spool_released_size * 2));
+		xrecalloc(spool_released, spool_released_size,
+			  sizeof(*spool_released));
+	}
+	spool_released[spool_released_cnt++] = seq;
+}
+
+/* Append record just added to agent_list to the spool */
+static void _spool_append(buf_t *buffer)
+{
+	if (!spool_enabled)
+		return;
+
+	if (((spool_fd < 0) || (spool_size >= DBD_SPOOL_SEGMENT_SIZE)) &&
+	    _spool_open()) {
+		_spool_fail();
+		return;
+	}
+
+	if (_spool_write_rec(spool_fd, buffer)) {
+		error("%s: write failed: %m", __func__);
+		_spool_fail();
+		return;
+	}
+
+	_spool_rec_add(buffer, spool_cur, spool_next_seq++);
+	spool_cur->count++;
+}
+
+static int _find_spool_seg(void *x, void *key)
+{
+	spool_seg_t *seg = x;
+	uint64_t seq = *(uint64_t *) key;
+
+	return ((seq >= seg->first_seq) &&
+		(seq < (seg->first_seq + seg->count)));
+}
+
+/*
+ * Record that a record is leaving agent_list, its sequence number is written
+ * in a tombstone by the next _spool_trim()
+ */
+static void _spool_release(buf_t *buffer)
+{
+	spool_rec_t *rec;
+	spool_seg_t *seg;
+
+	if (!spool_recs ||
+	    !(rec = xhash_pop(spool_recs, (const char *) &buffer,
+			      sizeof(buffer))))
+		return;
+
+	if ((seg = list_find_first(spool_segs, _find_spool_seg, &rec->seq)))
+		seg->live--;
+	_spool_tombstone(rec->seq);
+	xfree(rec);
+}
+
+/* Write the sequence numbers released since the last call as a tombstone */
+static void _spool_write_tombstone(void)
+{
+	buf_t *buffer;
+
+	if (!spool_released_cnt)
+		return;
+
+	if (((spool_fd < 0) || (spool_size >= DBD_SPOOL_SEGMENT_SIZE)) &&
+	    _spool_open()) {
+		_spool_fail();
+		return;
+	}
+
+	buffer = init_buf(sizeof(uint16_t) + sizeof(uint32_t) +
+			  (spool_released_cnt * sizeof(uint64_t)));
+	pack16(0, buffer);
+	pack64_array(spool_released, spool_released_cnt, buffer);
+	if (_spool_write_rec(spool_fd, buffer)) {
+		error("%s: write failed: %m", __func__);
+		_spool_fail();
+	}
+	free_buf(buffer);
+	spool_released_cnt = 0;
+}
+
+/*
+ * Persist released records and remove every spool file whose records have
+ * all been released, oldest first
+ */
+static void _spool_trim(void)
+{
+	spool_seg_t *seg;
+	bool removed = false;
+
+	if (!spool_enabled || !spool_segs)
+		return;
+
+	if (!list_count(agent_list)) {
+		/* everything processed: start over */
+		while (list_count(spool_segs))
+			_spool_remove_first();
+		spool_released_cnt = 0;
+		_spool_save_head();
+		return;
+	}
+
+	_spool_write_tombstone();
+
+	/* tombstones in a file only refer to records in it or older files */
+	while ((seg = list_peek(spool_segs)) && (seg != spool_cur) &&
+	       !seg->live) {
+		_spool_remove_first();
+		removed = true;
+	}
+
+	if (removed)
+		_spool_save_head();
+}
+
+/* Free the records tracked for the spool, they stay in agent_list */
+static void _spool_free_recs(void)
+{
+	xhash_free(spool_recs);
+	xfree(spool_released);
+	spool_released_cnt = 0;
+	spool_released_size = 0;
+}
+
+/* Remove all spool files */
+static void _spool_remove_all(void)
+{
+	char *fname = NULL;
+
+	if (!spool_segs)
+		return;
+
+	while (list_count(spool_segs))
+		_spool_remove_first();
+	FREE_NULL_LIST(spool_segs);
+	_spool_free_recs();
+
+	xstrfmtcat(fname, "%s/dbd.spool.head", slurm_conf.state_save_location);
+	if ((unlink(fname) == -1) && (errno != ENOENT))
+		error("%s: unable to remove %s: %m", __func__, fname);
+	xfree(fname);
+}
+
+/* Record from an older protocol version is repacked with the current one */
+static buf_t *_repack_dbd_rec(buf_t *buffer, uint16_t rpc_version)
+{
+	persist_msg_t msg = {0};
+	int rc;
+
+	if (rpc_version == SLURM_PROTOCOL_VERSION)
+		return buffer;
+
+	/* unpack and repack with new
+	 * PROTOCOL_VERSION just so we keep
+	 * things up to date.
+	 */
+	set_buf_offset(buffer, 0);
+	rc = unpack_slurmdbd_msg(&msg, rpc_version, buffer);
+	free_buf(buffer);
+	if (rc == SLURM_SUCCESS)
+		return pack_slurmdbd_msg(&msg, SLURM_PROTOCOL_VERSION);
+	return NULL;
+}
+
+static uint16_t _dbd_rec_msg_type(buf_t *buffer)
+{
+	uint32_t offset = get_buf_offset(buffer);
+	uint16_t msg_type = 0;
+
+	if (offset < 2)
+		return 0;
+	set_buf_offset(buffer, 0);
+	(void) unpack16(&msg_type, buffer);	/* checked by offset */
+	set_buf_offset(buffer, offset);
+
+	return msg_type;
+}
+
+static int _seq_cmp(const void *x, const void *y)
+{
+	uint64_t a = *(uint64_t *) x, b = *(uint64_t *) y;
+
+	return ((a > b) - (a < b));
+}
+
+/*
+ * Load all records left in the spool files into agent_list, except those
+ * named by a tombstone
+ * NOTE: agent_lock must be locked
+ * RET number of records recovered
+ */
+static int _spool_load(void)
+{
+	char *fname = NULL;
+	int fd, recovered = 0;
+	uint32_t first = 0, tomb_cnt = 0;
+	uint64_t *tombs = NULL;
+	char str[32] = "";
+	spool_rec_t *rec;
+	List recs;
+
+	if (spool_segs)
+		return 0;	/* already loaded */
+	spool_segs = list_create(xfree_ptr);
+
+	xstrfmtcat(fname, "%s/dbd.spool.head", slurm_conf.state_save_location);
+	if ((fd = open(fname, O_RDONLY)) >= 0) {
+		ssize_t len = read(fd, str, (sizeof(str) - 1));
+
+		if (len > 0)
+			str[len] = '\0';
+		(void) close(fd);
+	}
+	xfree(fname);
+
+	if (sscanf(str, "%u", &first) != 1) {
+		debug4("%s: no dbd.spool.head file", __func__);
+		spool_next_id = 0;
+		spool_next_seq = 0;
+		return 0;
+	}
+
+	spool_next_id = first;
+	recs = list_create(NULL);
+
+	while (true) {
+		spool_seg_t *seg;
+		buf_t *spool_buf, *buffer;
+		char *ver_str = NULL;
+		uint32_t ver_str_len;
+		uint16_t rpc_version = 0;
+
+		fname = _spool_fname(spool_next_id);
+		if (access(fname, F_OK)) {
+			xfree(fname);
+			break;
+		}
+
+		seg = xmalloc(sizeof(*seg));
+		seg->id = spool_next_id++;
+		seg->first_seq = spool_next_seq;
+		list_append(spool_segs, seg);
+
+		if (!(spool_buf = create_mmap_buf(fname))) {
+			/* empty or unreadable file */
+			xfree(fname);
+			continue;
+		}
+		xfree(fname);
+
+		if ((buffer = _spool_read_rec(spool_buf))) {
+			set_buf_offset(buffer, 0);
+			safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+			safe_unpack64(&seg->first_seq, buffer);
+unpack_error:
+			free_buf(buffer);
+		}
+		if (ver_str) {
+			/* get the version after VER */
+			rpc_version = slurm_atoul(ver_str + 3);
+			xfree(ver_str);
+		}
+		spool_next_seq = seg->first_seq;
+
+		while ((buffer = _spool_read_rec(spool_buf))) {
+			if (!_dbd_rec_msg_type(buffer)) {
+				uint64_t *seqs = NULL;
+				uint32_t cnt = 0;
+
+				set_buf_offset(buffer, sizeof(uint16_t));
+				if (!unpack64_array(&seqs, &cnt, buffer)) {
+					xrecalloc(tombs, (tomb_cnt + cnt),
+						  sizeof(*tombs));
+					memcpy((tombs + tomb_cnt), seqs,
+					       (cnt * sizeof(*tombs)));
+					tomb_cnt += cnt;
+				}
+				xfree(seqs);
+				free_buf(buffer);
+				continue;
+			}
+
+			rec = xmalloc(sizeof(*rec));
+			rec->buffer = _repack_dbd_rec(buffer, rpc_version);
+			rec->seq = spool_next_seq++;
+			seg->count++;
+			list_append(recs, rec);
+		}
+
+		if (remaining_buf(spool_buf))
+			error("%s: ignoring %u invalid bytes at end of spool file %u",
+			      __func__, remaining_buf(spool_buf), seg->id);
+		free_buf(spool_buf);
+	}
+
+	if (tomb_cnt)
+		qsort(tombs, tomb_cnt, sizeof(*tombs), _seq_cmp);
+
+	while ((rec = list_pop(recs))) {
+		if (tomb_cnt &&
+		    bsearch(&rec->seq, tombs, tomb_cnt, sizeof(*tombs),
+			    _seq_cmp)) {
+			/* released before slurmctld stopped */
+			FREE_NULL_BUFFER(rec->buffer);
+		} else if (!rec->buffer) {
+			error("no buffer given");
+			_spool_tombstone(rec->seq);
+		} else if (_dbd_rec_msg_type(rec->buffer) ==
+			   DBD_REGISTER_CTLD) {
+			/* see _save_dbd_state() */
+			free_buf(rec->buffer);
+			_spool_tombstone(rec->seq);
+		} else {
+			list_enqueue(agent_list, rec->buffer);
+			_spool_rec_add(rec->buffer,
+				       list_find_first(spool_segs,
+						       _find_spool_seg,
+						       &rec->seq),
+				       rec->seq);
+			recovered++;
+		}
+		xfree(rec);
+	}
+	FREE_NULL_LIST(recs);
+	xfree(tombs);
+
+	verbose("recovered %d pending RPCs from %d spool files",
+		recovered, list_count(spool_segs));
+
+	return recovered;
+}
 
 static int _unpack_return_code(uint16_t rpc_version, buf_t *buffer)
 {
@@ -152,7 +775,11 @@ static int _get_return_code(void)
 	return rc;
 }
 
-static int _handle_mult_rc_ret(void)
+/*
+ * Process the reply to a DBD_SEND_MULT_MSG and release each acknowledged
+ * record of batch from agent_list.
+ */
+static int _handle_mult_rc_ret(agent_batch_t *batch)
 {
 	buf_t *buffer;
 	uint16_t msg_type;
@@ -178,23 +805,37 @@ static int _handle_mult_rc_ret(void)
 
 		slurm_mutex_lock(&agent_lock);
 		if (agent_list) {
+			uint32_t acked = 0;
 			ListIterator itr =
 				list_iterator_create(list_msg->my_list);
 			while ((out_buf = list_next(itr))) {
-				buf_t *b;
 				if ((rc = _unpack_return_code(
 					     slurmdbd_conn->version, out_buf))
 				    != SLURM_SUCCESS)
 					break;
 
-				if ((b = list_dequeue(agent_list))) {
-					free_buf(b);
+				if (acked >= batch->count) {
+					error("DBD_GOT_MULT_MSG "
+					      "unpack message error");
+					continue;
+				}
+
+				/*
+				 * Record is at head of agent_list unless an
+				 * earlier batch in flight failed
+				 */
+				if (list_delete_ptr(agent_list,
+						    batch->msgs[acked])) {
+					_spool_release(batch->msgs[acked]);
+					acked++;
+					agent_inflight--;
 				} else {
 					error("DBD_GOT_MULT_MSG "
 					      "unpack message error");
 				}
 			}
 			list_iterator_destroy(itr);
+			_spool_trim();
 		}
 		slurm_mutex_unlock(&agent_lock);
 		slurmdbd_free_list_msg(list_msg);
@@ -299,6 +940,8 @@ static void _load_dbd_state(void)
 	int fd, recovered = 0;
 	uint16_t rpc_version = 0;
 
+	(void) _spool_load();
+
 	xstrfmtcat(dbd_fname, "%s/dbd.messages", slurm_conf.state_save_location);
 	fd = open(dbd_fname, O_RDONLY);
 	if (fd < 0) {
@@ -339,29 +982,13 @@ static void _load_dbd_state(void)
 				buffer = _load_dbd_rec(fd);
 			if (buffer == NULL)
 				break;
-			if (rpc_version != SLURM_PROTOCOL_VERSION) {
-				/* unpack and repack with new
-				 * PROTOCOL_VERSION just so we keep
-				 * things up to date.
-				 */
-				persist_msg_t msg = {0};
-				int rc;
-				set_buf_offset(buffer, 0);
-				rc = unpack_slurmdbd_msg(
-					&msg, rpc_version, buffer);
-				free_buf(buffer);
-				if (rc == SLURM_SUCCESS)
-					buffer = pack_slurmdbd_msg(
-						&msg, SLURM_PROTOCOL_VERSION);
-				else
-					buffer = NULL;
-			}
-			if (!buffer) {
+			if (!(buffer = _repack_dbd_rec(buffer, rpc_version))) {
 				error("no buffer given");
 				continue;
 			}
 			if (!list_enqueue(agent_list, buffer))
 				fatal("list_enqueue, no memory");
+			_spool_append(buffer);
 			recovered++;
 			buffer = NULL;
 		}
@@ -369,6 +996,11 @@ static void _load_dbd_state(void)
 	end_it:
 		verbose("recovered %d pending RPCs", recovered);
 		(void) close(fd);
+
+		/* records are in the spool now */
+		if (spool_enabled && (unlink(dbd_fname) == -1))
+			error("%s: unable to remove %s: %m",
+			      __func__, dbd_fname);
 	}
 	xfree(dbd_fname);
 }
@@ -421,6 +1053,21 @@ static void _save_dbd_state(void)
 
 	xstrfmtcat(dbd_fname, "%s/dbd.messages", slurm_conf.state_save_location);
 	(void) unlink(dbd_fname);	/* clear save state */
+
+	if (spool_enabled) {
+		/* records are already in the spool files */
+		_spool_write_tombstone();
+		_spool_close();
+		_spool_save_head();
+		verbose("spooled %d pending RPCs", list_count(agent_list));
+
+		/* reloaded from the spool files by next agent */
+		FREE_NULL_LIST(spool_segs);
+		_spool_free_recs();
+		xfree(dbd_fname);
+		return;
+	}
+
 	fd = open(dbd_fname, O_WRONLY | O_CREAT | O_TRUNC, 0600);
 	if (fd < 0) {
 		error("Creating state save file %s", dbd_fname);
@@ -469,6 +1116,9 @@ end_it:
 		rc = fsync_and_close(fd, "dbd.messages");
 		if (rc)
 			error("error from fsync_and_close");
+
+		/* spooled records are all in dbd.messages now */
+		_spool_remove_all();
 	}
 	xfree(dbd_fname);
 }
@@ -480,11 +1130,16 @@ static int _purge_step_req(void)
 	int purged = 0;
 	ListIterator iter;
 	uint16_t msg_type;
-	uint32_t offset;
+	uint32_t offset, skip = agent_inflight;
 	buf_t *buffer;
 
 	iter = list_iterator_create(agent_list);
 	while ((buffer = list_next(iter))) {
+		/* records in flight must stay until acknowledged */
+		if (skip) {
+			skip--;
+			continue;
+		}
 		offset = get_buf_offset(buffer);
 		if (offset < 2)
 			continue;
@@ -494,6 +1149,7 @@ static int _purge_step_req(void)
 		if ((msg_type == DBD_STEP_START) ||
 		    (msg_type == DBD_STEP_COMPLETE)) {
 			list_remove(iter);
+			_spool_release(buffer);
 			purged++;
 		}
 	}
@@ -509,11 +1165,16 @@ static int _purge_job_start_req(void)
 	int purged = 0;
 	ListIterator iter;
 	uint16_t msg_type;
-	uint32_t offset;
+	uint32_t offset, skip = agent_inflight;
 	buf_t *buffer;
 
 	iter = list_iterator_create(agent_list);
 	while ((buffer = list_next(iter))) {
+		/* records in flight must stay until acknowledged */
+		if (skip) {
+			skip--;
+			continue;
+		}
 		offset = get_buf_offset(buffer);
 		if (offset < 2)
 			continue;
@@ -522,6 +1183,7 @@ static int _purge_job_start_req(void)
 		set_buf_offset(buffer, offset);
 		if (msg_type == DBD_JOB_START) {
 			list_remove(iter);
+			_spool_release(buffer);
 			purged++;
 		}
 	}
@@ -546,6 +1208,7 @@ static void _max_dbd_msg_action(uint32_t *msg_cnt)
 		*msg_cnt -= _purge_step_req();
 	if (*msg_cnt >= (slurm_conf.max_dbd_msgs - 1))
 		*msg_cnt -= _purge_job_start_req();
+	_spool_trim();
 }
 
 static void _sig_handler(int signal)
@@ -598,6 +1261,157 @@ static void _print_agent_list_msg_types(void)
 	xfree(mlist);
 }
 
+/*
+ * Pack the next agent_list records not already in flight into a
+ * DBD_SEND_MULT_MSG.
+ * NOTE: agent_lock must be locked
+ * OUT batch_ptr - records packed into message
+ * RET packed message or NULL if no records are waiting to be sent
+ */
+static buf_t *_pack_next_batch(agent_batch_t **batch_ptr)
+{
+	persist_msg_t list_req = {0};
+	dbd_list_msg_t list_msg = {0};
+	agent_batch_t *batch;
+	ListIterator itr;
+	buf_t *buffer;
+	uint32_t cnt, skip = agent_inflight;
+
+	cnt = list_count(agent_list);
+	if (cnt <= agent_inflight)
+		return NULL;
+	cnt = MIN((cnt - agent_inflight), DBD_AGENT_BATCH_MAX);
+
+	batch = xmalloc(sizeof(*batch));
+	batch->msgs = xcalloc(cnt, sizeof(*batch->msgs));
+
+	list_msg.my_list = list_create(NULL);
+	itr = list_iterator_create(agent_list);
+	while ((buffer = list_next(itr))) {
+		if (skip) {
+			skip--;
+			continue;
+		}
+
+		list_enqueue(list_msg.my_list, buffer);
+		batch->msgs[batch->count++] = buffer;
+		if (batch->count >= cnt)
+			break;
+	}
+	list_iterator_destroy(itr);
+
+	list_req.msg_type = DBD_SEND_MULT_MSG;
+	list_req.conn = slurmdbd_conn;
+	list_req.data = &list_msg;
+	buffer = pack_slurmdbd_msg(&list_req, SLURM_PROTOCOL_VERSION);
+	FREE_NULL_LIST(list_msg.my_list);
+
+	agent_inflight += batch->count;
+	*batch_ptr = batch;
+
+	return buffer;
+}
+
+/*
+ * Send pending agent_list records as DBD_SEND_MULT_MSG batches, keeping up to
+ * agent_window batches in flight. slurmdbd processes and answers the messages
+ * of a connection in order, so each reply belongs to the oldest outstanding
+ * batch. Only returns once nothing is outstanding, so a direct
+ * slurmdbd_agent_send_recv() never receives a reply meant for the agent.
+ * NOTE: slurmdbd_lock must be locked and agent_lock unlocked
+ * RET SLURM_SUCCESS or first error
+ */
+static int _send_batches(void)
+{
+	int rc = SLURM_SUCCESS, rc2;
+	List outstanding = list_create(_free_agent_batch);
+	agent_batch_t *batch = NULL;
+	buf_t *buffer;
+
+	while (true) {
+		/* keep window full unless failed or asked to stop */
+		while ((rc == SLURM_SUCCESS) && !halt_agent &&
+		       !*slurmdbd_conn->shutdown &&
+		       (list_count(outstanding) < agent_window)) {
+			slurm_mutex_lock(&agent_lock);
+			buffer = _pack_next_batch(&batch);
+			slurm_mutex_unlock(&agent_lock);
+
+			if (!buffer)
+				break;
+
+			rc = slurm_persist_send_msg(slurmdbd_conn, buffer);
+			free_buf(buffer);
+
+			if (rc != SLURM_SUCCESS) {
+				if (!*slurmdbd_conn->shutdown)
+					error("Failure sending message: %d: %m",
+					      rc);
+				_free_agent_batch(batch);
+				break;
+			}
+
+			log_flag(AGENT, "slurmdbd agent sent %u records with %d batches in flight",
+				 batch->count, (list_count(outstanding) + 1));
+			list_enqueue(outstanding, batch);
+		}
+
+		if (!(batch = list_dequeue(outstanding)))
+			break;
+
+		/* replies continue to be drained after a failure */
+		rc2 = _handle_mult_rc_ret(batch);
+		if (rc == SLURM_SUCCESS)
+			rc = rc2;
+		_free_agent_batch(batch);
+	}
+
+	/* anything not acknowledged is pending again */
+	slurm_mutex_lock(&agent_lock);
+	agent_inflight = 0;
+	slurm_mutex_unlock(&agent_lock);
+
+	FREE_NULL_LIST(outstanding);
+
+	return rc;
+}
+
+/*
+ * Send the single record at the head of agent_list and wait for its reply.
+ * NOTE: slurmdbd_lock must be locked and agent_lock unlocked
+ * RET SLURM_SUCCESS or error
+ */
+static int _send_single(buf_t *buffer)
+{
+	int rc;
+
+	/* NOTE: agent_lock is clear here, so we can add more
+	 * requests to the queue while waiting for this RPC to
+	 * complete. */
+	rc = slurm_persist_send_msg(slurmdbd_conn, buffer);
+	if (rc != SLURM_SUCCESS) {
+		if (!*slurmdbd_conn->shutdown)
+			error("Failure sending message: %d: %m", rc);
+	} else {
+		rc = _get_return_code();
+		if ((rc == EAGAIN) && !*slurmdbd_conn->shutdown)
+			error("Failure with "
+			      "message need to resend: %d: %m", rc);
+	}
+
+	slurm_mutex_lock(&agent_lock);
+	agent_inflight = 0;
+	if (agent_list && (rc == SLURM_SUCCESS)) {
+		buffer = list_dequeue(agent_list);
+		_spool_release(buffer);
+		free_buf(buffer);
+		_spool_trim();
+	}
+	slurm_mutex_unlock(&agent_lock);
+
+	return rc;
+}
+
 static void *_agent(void *x)
 {
 	int rc;
@@ -606,23 +1420,16 @@ static void *_agent(void *x)
 	struct timespec abs_time;
 	static time_t fail_time = 0;
 	int sigarray[] = {SIGUSR1, 0};
-	persist_msg_t list_req = {0};
-	dbd_list_msg_t list_msg;
 	DEF_TIMERS;
 
-	list_req.msg_type = DBD_SEND_MULT_MSG;
-	list_req.conn = slurmdbd_conn;
-	list_req.data = &list_msg;
-	memset(&list_msg, 0, sizeof(dbd_list_msg_t));
-
 	/* Prepare to catch SIGUSR1 to interrupt pending
 	 * I/O and terminate in a timely fashion. */
 	xsignal(SIGUSR1, _sig_handler);
 	xsignal_unblock(sigarray);
 
-	log_flag(AGENT, "slurmdbd agent_count=%d with msg_type=%s",
+	log_flag(AGENT, "slurmdbd agent_count=%d with msg_type=%s window=%d",
 		 list_count(agent_list),
-		 slurmdbd_msg_type_2_str(list_req.msg_type, 1));
+		 slurmdbd_msg_type_2_str(DBD_SEND_MULT_MSG, 1), agent_window);
 
 	while (*slurmdbd_conn->shutdown == 0) {
 		slurm_mutex_lock(&slurmdbd_lock);
@@ -665,69 +1472,39 @@ static void *_agent(void *x)
 		           (slurm_conf.debug_flags & DEBUG_FLAG_AGENT))
 			info("agent_count:%d", cnt);
 		/* Leave item on the queue until processing complete */
-		if (agent_list) {
-			int handle_agent_count = 1000;
-			if (cnt > handle_agent_count) {
-				int agent_count = 0;
-				ListIterator agent_itr =
-					list_iterator_create(agent_list);
-				list_msg.my_list = list_create(NULL);
-				while ((buffer = list_next(agent_itr))) {
-					list_enqueue(list_msg.my_list, buffer);
-					agent_count++;
-					if (agent_count > handle_agent_count)
-						break;
-				}
-				list_iterator_destroy(agent_itr);
-				buffer = pack_slurmdbd_msg(
-					&list_req, SLURM_PROTOCOL_VERSION);
-			} else if (cnt > 1) {
-				list_msg.my_list = agent_list;
-				buffer = pack_slurmdbd_msg(
-					&list_req, SLURM_PROTOCOL_VERSION);
-			} else
-				buffer = list_peek(agent_list);
-		} else
-			buffer = NULL;
-		slurm_mutex_unlock(&agent_lock);
-		if (buffer == NULL) {
-			slurm_mutex_unlock(&slurmdbd_lock);
+		if (agent_list && (cnt > 1)) {
+			slurm_mutex_unlock(&agent_lock);
+			rc = _send_batches();
+		} else {
+			if (agent_list && (buffer = list_peek(agent_list)))
+				agent_inflight = 1;
+			else
+				buffer = NULL;
+			slurm_mutex_unlock(&agent_lock);
 
-			slurm_mutex_lock(&assoc_cache_mutex);
-			if (slurmdbd_conn->fd >= 0 &&
-			    (running_cache != RUNNING_CACHE_STATE_NOTRUNNING))
-				slurm_cond_signal(&assoc_cache_cond);
-			slurm_mutex_unlock(&assoc_cache_mutex);
+			if (buffer == NULL) {
+				slurm_mutex_unlock(&slurmdbd_lock);
 
-			END_TIMER2("slurmdbd agent: empty buffer");
-			continue;
-		}
+				slurm_mutex_lock(&assoc_cache_mutex);
+				if (slurmdbd_conn->fd >= 0 &&
+				    (running_cache !=
+				     RUNNING_CACHE_STATE_NOTRUNNING))
+					slurm_cond_signal(&assoc_cache_cond);
+				slurm_mutex_unlock(&assoc_cache_mutex);
 
-		/* NOTE: agent_lock is clear here, so we can add more
-		 * requests to the queue while waiting for this RPC to
-		 * complete. */
-		rc = slurm_persist_send_msg(slurmdbd_conn, buffer);
-		if (rc != SLURM_SUCCESS) {
-			if (*slurmdbd_conn->shutdown) {
-				slurm_mutex_unlock(&slurmdbd_lock);
-				END_TIMER2("slurmdbd agent: shutdown");
-				break;
-			}
-			error("Failure sending message: %d: %m", rc);
-		} else if (list_msg.my_list) {
-			rc = _handle_mult_rc_ret();
-		} else {
-			rc = _get_return_code();
-			if (rc == EAGAIN) {
-				if (*slurmdbd_conn->shutdown) {
-					slurm_mutex_unlock(&slurmdbd_lock);
-					END_TIMER2("slurmdbd agent: EAGAIN on shutdown");
-					break;
-				}
-				error("Failure with "
-				      "message need to resend: %d: %m", rc);
+				END_TIMER2("slurmdbd agent: empty buffer");
+				continue;
 			}
+
+			rc = _send_single(buffer);
+		}
+
+		if ((rc != SLURM_SUCCESS) && *slurmdbd_conn->shutdown) {
+			slurm_mutex_unlock(&slurmdbd_lock);
+			END_TIMER2("slurmdbd agent: shutdown");
+			break;
 		}
+
 		slurm_mutex_unlock(&slurmdbd_lock);
 		slurm_mutex_lock(&assoc_cache_mutex);
 		if (slurmdbd_conn->fd >= 0 &&
@@ -737,29 +1514,8 @@ static void *_agent(void *x)
 
 		slurm_mutex_lock(&agent_lock);
 		if (agent_list && (rc == SLURM_SUCCESS)) {
-			/*
-			 * If we sent a mult_msg we just need to free buffer,
-			 * we don't need to requeue, just mark list_msg.my_list
-			 * as NULL as that is the sign we sent a mult_msg.
-			 */
-			if (list_msg.my_list) {
-				if (list_msg.my_list != agent_list)
-					FREE_NULL_LIST(list_msg.my_list);
-				list_msg.my_list = NULL;
-			} else
-				buffer = list_dequeue(agent_list);
-
-			free_buf(buffer);
 			fail_time = 0;
 		} else {
-			/* We need to free a mult_msg even on failure */
-			if (list_msg.my_list) {
-				if (list_msg.my_list != agent_list)
-					FREE_NULL_LIST(list_msg.my_list);
-				list_msg.my_list = NULL;
-				free_buf(buffer);
-			}
-
 			fail_time = time(NULL);
 
 			if (slurm_conf.debug_flags & DEBUG_FLAG_AGENT) {
@@ -779,6 +1535,7 @@ static void *_agent(void *x)
 		 list_count(agent_list));
 
 	FREE_NULL_LIST(agent_list);
+	agent_inflight = 0;
 	slurm_mutex_unlock(&agent_lock);
 	return NULL;
 }
@@ -948,6 +1705,7 @@ extern int slurmdbd_agent_send(uint16_t rpc_version, persist_msg_t *req)
 	if (cnt < slurm_conf.max_dbd_msgs) {
 		if (list_enqueue(agent_list, buffer) == NULL)
 			fatal("list_enqueue: memory allocation failure");
+		_spool_append(buffer);
 	} else {
 		error("agent queue is full (%u), discarding %s:%u request",
 		      cnt,
@@ -1007,4 +1765,19 @@ extern void slurmdbd_agent_config_setup(void)
 		xfree(type);
 	} else
 		max_dbd_msg_action = MAX_DBD_DEFAULT_ACTION;
+
+	spool_enabled = (xstrcasestr(slurm_conf.slurmctld_params,
+				     "dbd_agent_spool") != NULL);
+
+	/*                          01234567890123456 */
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "dbd_agent_window="))) {
+		int window = atoi(tmp_ptr + 17);
+
+		if ((window < 1) || (window > MAX_DBD_AGENT_WINDOW))
+			fatal("Invalid SlurmctldParameters dbd_agent_window=%d, must be between 1 and %d",
+			      window, MAX_DBD_AGENT_WINDOW);
+		agent_window = window;
+	} else
+		agent_window = DEFAULT_DBD_AGENT_WINDOW;
 }
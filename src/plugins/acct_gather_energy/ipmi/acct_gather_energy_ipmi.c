@@ -144,6 +144,8 @@ typedef struct sensor_status {
 static sensor_status_t *sensors = NULL;
 static uint16_t sensors_len = 0;
 static uint64_t *start_current_energies = NULL;
+/* watts read by _thread_update_node_energy, one per sensor */
+static uint32_t *sensor_watts = NULL;
 
 /* array of struct describing the configuration of the sensors */
 typedef struct description {
@@ -460,9 +462,10 @@ static int _find_power_sensor(void)
 }
 
 /*
- * _read_ipmi_values read the Power sensor and update last_update_watt and times
+ * _read_ipmi_values read the Power sensors into watts. Talking to the BMC can
+ * take long, so the published sensor values are left alone.
  */
-static int _read_ipmi_values(void)
+static int _read_ipmi_values(uint32_t *watts)
 {
 	/* read sensors list */
 	void *sensor_reading;
@@ -504,8 +507,7 @@ static int _read_ipmi_values(void)
 		sensor_reading =
 		    ipmi_monitoring_sensor_read_sensor_reading(ipmi_ctx);
 		if (sensor_reading) {
-			sensors[i].last_update_watt =
-			    (uint32_t) (*((double *)sensor_reading));
+			watts[i] = (uint32_t) (*((double *)sensor_reading));
 		} else {
 			error("ipmi read an empty value for power consumption");
 			return SLURM_ERROR;
@@ -513,9 +515,6 @@ static int _read_ipmi_values(void)
 		++i;
 	} while (ipmi_monitoring_sensor_iterator_next(ipmi_ctx));
 
-	previous_update_time = last_update_time;
-	last_update_time = time(NULL);
-
 	return SLURM_SUCCESS;
 }
 
@@ -550,18 +549,20 @@ static void _update_energy(acct_gather_energy_t *e, uint32_t last_update_watt,
 }
 
 /*
- * _thread_update_node_energy calls _read_ipmi_values and updates all values
- * for node consumption
+ * _update_node_energy publishes the watts read by _read_ipmi_values and updates
+ * all values for node consumption. ipmi_mutex must be locked.
  */
-static int _thread_update_node_energy(void)
+static int _update_node_energy(int rc, uint32_t *watts)
 {
-	int rc = SLURM_SUCCESS;
 	uint16_t i;
 	static uint32_t readings = 0;
 
-	rc = _read_ipmi_values();
-
 	if (rc == SLURM_SUCCESS) {
+		for (i = 0; i < sensors_len; ++i)
+			sensors[i].last_update_watt = watts[i];
+		previous_update_time = last_update_time;
+		last_update_time = time(NULL);
+
 		/* sensors list */
 		for (i = 0; i < sensors_len; ++i) {
 			if (sensors[i].energy.current_watts == NO_VAL)
@@ -590,6 +591,26 @@ static int _thread_update_node_energy(void)
 	return rc;
 }
 
+/*
+ * _thread_update_node_energy calls _read_ipmi_values and updates all values
+ * for node consumption. ipmi_mutex must be locked.
+ */
+static int _thread_update_node_energy(void)
+{
+	return _update_node_energy(_read_ipmi_values(sensor_watts),
+				   sensor_watts);
+}
+
+/*
+ * Return true if slurmd's polling thread keeps the sensor values fresh, so
+ * readers can use them rather than querying the BMC themselves.
+ */
+static bool _polling_thread_running(void)
+{
+	return (running_in_slurmd() && flag_thread_started &&
+		!flag_energy_accounting_shutdown);
+}
+
 /*
  * _thread_init initializes values and conf for the ipmi thread
  */
@@ -620,6 +641,7 @@ static int _thread_init(void)
 					sensors[i].last_update_watt;
 			}
 		}
+		sensor_watts = xcalloc(MAX(sensors_len, 1), sizeof(uint32_t));
 		if (slurm_ipmi_conf.reread_sdr_cache)
 			//IPMI cache is reread only on initialization
 			//This option need a big EnergyIPMITimeout
@@ -698,6 +720,8 @@ static void *_thread_ipmi_run(void *no_data)
 // need input (attr)
 	struct timeval tvnow;
 	struct timespec abs;
+	uint32_t *watts;
+	int rc;
 
 	flag_energy_accounting_shutdown = false;
 	log_flag(ENERGY, "ipmi-thread: launched");
@@ -719,8 +743,9 @@ static void *_thread_ipmi_run(void *no_data)
 
 	(void) pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED, NULL);
 
-	slurm_mutex_unlock(&ipmi_mutex);
+	/* set under the lock, readers use it to stop querying the BMC */
 	flag_thread_started = true;
+	slurm_mutex_unlock(&ipmi_mutex);
 
 	slurm_mutex_lock(&launch_mutex);
 	slurm_cond_signal(&launch_cond);
@@ -731,11 +756,28 @@ static void *_thread_ipmi_run(void *no_data)
 	abs.tv_sec = tvnow.tv_sec;
 	abs.tv_nsec = tvnow.tv_usec * 1000;
 
+	watts = xcalloc(MAX(sensors_len, 1), sizeof(uint32_t));
+
 	//loop until slurm stop
 	while (!flag_energy_accounting_shutdown) {
+		/*
+		 * Reading the BMC regularly takes 100ms+, do it unlocked so
+		 * the last values can still be served to the steps meanwhile.
+		 */
+		rc = _read_ipmi_values(watts);
+
 		slurm_mutex_lock(&ipmi_mutex);
 
-		_thread_update_node_energy();
+		_update_node_energy(rc, watts);
+
+		/*
+		 * A shutdown signaled during the unlocked read would be lost,
+		 * check for it before waiting.
+		 */
+		if (flag_energy_accounting_shutdown) {
+			slurm_mutex_unlock(&ipmi_mutex);
+			break;
+		}
 
 		/* Sleep until the next time. */
 		abs.tv_sec += slurm_ipmi_conf.freq;
@@ -744,6 +786,8 @@ static void *_thread_ipmi_run(void *no_data)
 		slurm_mutex_unlock(&ipmi_mutex);
 	}
 
+	xfree(watts);
+
 	log_flag(ENERGY, "ipmi-thread: ended");
 
 	return NULL;
@@ -925,17 +969,20 @@ extern int fini(void)
 	slurm_mutex_lock(&ipmi_mutex);
 	/* clean up the run thread */
 	slurm_cond_signal(&ipmi_cond);
+	slurm_mutex_unlock(&ipmi_mutex);
+
+	if (thread_ipmi_id_run)
+		pthread_join(thread_ipmi_id_run, NULL);
 
+	/* the run thread reads the sensors without the lock */
+	slurm_mutex_lock(&ipmi_mutex);
 	if (ipmi_ctx)
 		ipmi_monitoring_ctx_destroy(ipmi_ctx);
 	reset_slurm_ipmi_conf(&slurm_ipmi_conf);
-
 	slurm_mutex_unlock(&ipmi_mutex);
 
-	if (thread_ipmi_id_run)
-		pthread_join(thread_ipmi_id_run, NULL);
-
 	xfree(sensors);
+	xfree(sensor_watts);
 	xfree(start_current_energies);
 
 	for (i = 0; i < descriptions_len; ++i) {
@@ -970,7 +1017,12 @@ extern int acct_gather_energy_p_get_data(enum acct_energy_type data_type,
 	case ENERGY_DATA_NODE_ENERGY_UP:
 		slurm_mutex_lock(&ipmi_mutex);
 		if (running_in_slurmd()) {
-			if (_thread_init() == SLURM_SUCCESS)
+			/*
+			 * The polling thread keeps the values at most
+			 * EnergyIPMIFrequency old, don't wait on the BMC.
+			 */
+			if (!_polling_thread_running() &&
+			    (_thread_init() == SLURM_SUCCESS))
 				_thread_update_node_energy();
 		} else {
 			_get_joules_task(10);
@@ -1001,7 +1053,12 @@ extern int acct_gather_energy_p_get_data(enum acct_energy_type data_type,
 	case ENERGY_DATA_JOULES_TASK:
 		slurm_mutex_lock(&ipmi_mutex);
 		if (running_in_slurmd()) {
-			if (_thread_init() == SLURM_SUCCESS)
+			/*
+			 * The polling thread keeps the values at most
+			 * EnergyIPMIFrequency old, don't wait on the BMC.
+			 */
+			if (!_polling_thread_running() &&
+			    (_thread_init() == SLURM_SUCCESS))
 				_thread_update_node_energy();
 		} else {
 			_get_joules_task(10);
@@ -106,7 +106,9 @@ typedef struct {
 } lustre_stats_t;
 
 static lustre_stats_t lstats = {0,0,0,0,0};
+/* last values handed out as TRES usage and as profile samples */
 static lustre_stats_t lstats_prev = {0,0,0,0,0};
+static lustre_stats_t lstats_prof_prev = {0,0,0,0,0};
 
 static pthread_mutex_t lustre_lock = PTHREAD_MUTEX_INITIALIZER;
 static int tres_pos = -1;
@@ -191,6 +193,10 @@ static int _check_lustre_fs(void)
  * read_bytes          17996 samples [bytes] 0 4194304 30994606834
  * write_bytes         9007 samples [bytes] 2 4194304 31008331389
  *
+ * The TRES usage is gathered for every process of the step on each poll, so
+ * counters read during the current second are reused rather than scanning
+ * all the stats files again for each process.
+ *
  */
 static int _read_lustre_counters(bool logged)
 {
@@ -200,6 +206,10 @@ static int _read_lustre_counters(bool logged)
 	FILE *fff;
 	char buffer[BUFSIZ];
 	static bool first = true;
+	time_t now = time(NULL);
+
+	if (!first && (lstats.update_time == now))
+		return SLURM_SUCCESS;
 
 	lustre_dir = _llite_path();
 	if (!lustre_dir) {
@@ -215,6 +225,10 @@ static int _read_lustre_counters(bool logged)
 		return SLURM_ERROR;
 	}
 
+	/* the stats files hold totals, sum them from scratch */
+	lstats.write_bytes = lstats.read_bytes = 0;
+	lstats.write_samples = lstats.read_samples = 0;
+
 	while ((entry = readdir(proc_dir))) {
 		char *path_stats = NULL;
 		bool bread;
@@ -275,10 +289,11 @@ static int _read_lustre_counters(bool logged)
 	} /* while ((entry = readdir(proc_dir))) */
 	closedir(proc_dir);
 
-	lstats.update_time = time(NULL);
+	lstats.update_time = now;
 
 	if (first) {
 		memcpy(&lstats_prev, &lstats, sizeof(lustre_stats_t));
+		memcpy(&lstats_prof_prev, &lstats, sizeof(lustre_stats_t));
 		first = false;
 	}
 
@@ -355,14 +370,14 @@ static int _update_node_filesystem(void)
 
 	/* Compute the current values read from all lustre-xxxx directories */
 	data[FIELD_READ].u64 =
-		lstats.read_samples - lstats_prev.read_samples;
+		lstats.read_samples - lstats_prof_prev.read_samples;
 	data[FIELD_READMB].d =
-		(double)(lstats.read_bytes - lstats_prev.read_bytes) /
+		(double)(lstats.read_bytes - lstats_prof_prev.read_bytes) /
 		(1 << 20);
 	data[FIELD_WRITE].u64 =
-		lstats.write_samples - lstats_prev.write_samples;
+		lstats.write_samples - lstats_prof_prev.write_samples;
 	data[FIELD_WRITEMB].d =
-		(double)(lstats.write_bytes - lstats_prev.write_bytes) /
+		(double)(lstats.write_bytes - lstats_prof_prev.write_bytes) /
 		(1 << 20);
 
 	/* record sample */
@@ -373,7 +388,7 @@ static int _update_node_filesystem(void)
 					      lstats.update_time);
 
 	/* Save current as previous. */
-	memcpy(&lstats_prev, &lstats, sizeof(lustre_stats_t));
+	memcpy(&lstats_prof_prev, &lstats, sizeof(lustre_stats_t));
 
 	slurm_mutex_unlock(&lustre_lock);
 
@@ -128,6 +128,8 @@ typedef struct {
 } ofed_sens_t;
 
 static ofed_sens_t ofed_sens = {0,0,0,0,0,0,0,0};
+/* values as of the last profile sample */
+static ofed_sens_t ofed_sens_prof_prev = {0,0,0,0,0,0,0,0};
 
 static uint8_t pc[1024];
 
@@ -175,9 +177,17 @@ static int _read_ofed_values(void)
 
 	uint16_t cap_mask;
 	uint64_t send_val, recv_val, send_pkts, recv_pkts;
+	time_t now = time(NULL);
+
+	/*
+	 * The TRES usage is gathered for every process of the step on each
+	 * poll, don't query the port again for counters read this second.
+	 */
+	if (!first && (ofed_sens.update_time == now))
+		return SLURM_SUCCESS;
 
 	ofed_sens.last_update_time = ofed_sens.update_time;
-	ofed_sens.update_time = time(NULL);
+	ofed_sens.update_time = now;
 
 	if (first) {
 		int mgmt_classes[4] = {IB_SMI_CLASS, IB_SMI_DIRECT_CLASS,
@@ -299,14 +309,27 @@ static int _update_node_interconnect(void)
 		return rc;
 	}
 
-	data[FIELD_PACKIN].u64 = ofed_sens.rcvpkts;
-	data[FIELD_PACKOUT].u64 = ofed_sens.xmtpkts;
-	data[FIELD_MBIN].d = (double) ofed_sens.rcvdata / (1 << 20);
-	data[FIELD_MBOUT].d = (double) ofed_sens.xmtdata / (1 << 20);
+	/*
+	 * The counters may also have been read for TRES usage since the last
+	 * sample, so work from the totals rather than the last read's delta.
+	 */
+	data[FIELD_PACKIN].u64 = ofed_sens.total_rcvpkts -
+				 ofed_sens_prof_prev.total_rcvpkts;
+	data[FIELD_PACKOUT].u64 = ofed_sens.total_xmtpkts -
+				  ofed_sens_prof_prev.total_xmtpkts;
+	data[FIELD_MBIN].d = (double) (ofed_sens.total_rcvdata -
+				       ofed_sens_prof_prev.total_rcvdata) /
+			     (1 << 20);
+	data[FIELD_MBOUT].d = (double) (ofed_sens.total_xmtdata -
+					ofed_sens_prof_prev.total_xmtdata) /
+			      (1 << 20);
 
 	log_flag(INTERCONNECT, "ofed-thread = %d sec, transmitted %"PRIu64" bytes, received %"PRIu64" bytes",
-		 (int) (ofed_sens.update_time - ofed_sens.last_update_time),
-		 ofed_sens.xmtdata, ofed_sens.rcvdata);
+		 (int) (ofed_sens.update_time -
+			ofed_sens_prof_prev.update_time),
+		 ofed_sens.total_xmtdata - ofed_sens_prof_prev.total_xmtdata,
+		 ofed_sens.total_rcvdata - ofed_sens_prof_prev.total_rcvdata);
+	memcpy(&ofed_sens_prof_prev, &ofed_sens, sizeof(ofed_sens_t));
 	slurm_mutex_unlock(&ofed_lock);
 
 	log_flag(PROFILE, "PROFILE-Network: %s",
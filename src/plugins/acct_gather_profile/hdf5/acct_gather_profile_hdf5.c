@@ -52,6 +52,7 @@
 #include <fcntl.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <unistd.h>
 #include <math.h>
 
@@ -64,12 +65,19 @@
 #include "src/slurmd/common/proctrack.h"
 #include "hdf5_api.h"
 
-#define HDF5_CHUNK_SIZE 10
+#if HAVE_SYS_PRCTL_H
+#  include <sys/prctl.h>
+#endif
+
+/* Records per chunk, default of ProfileHDF5ChunkSize */
+#define HDF5_CHUNK_SIZE 256
 /* Compression level, a value of 0 through 9. Level 0 is faster but offers the
  * least compression; level 9 is slower but offers maximum compression.
- * A setting of -1 indicates that no compression is desired. */
-/* TODO: Make this configurable with a parameter */
+ * A setting of -1 indicates that no compression is desired.
+ * Default of ProfileHDF5Compress. */
 #define HDF5_COMPRESS 0
+/* Seconds between writes of buffered samples */
+#define HDF5_FLUSH_INTERVAL 60
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -101,6 +109,8 @@ const char plugin_type[] = "acct_gather_profile/hdf5";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 typedef struct {
+	uint32_t chunk_size;
+	int compress;
 	char *dir;
 	uint32_t def;
 } slurm_hdf5_conf_t;
@@ -108,8 +118,17 @@ typedef struct {
 typedef struct {
 	hid_t  table_id;
 	size_t type_size;
+	uint8_t *buf;		/* records not yet written */
+	size_t buf_cnt;
 } table_t;
 
+/* Records detached from a table by the writer thread */
+typedef struct {
+	hid_t  table_id;
+	uint8_t *buf;
+	size_t buf_cnt;
+} pending_t;
+
 // Global HDF5 Variables
 //	The HDF5 file and base objects will remain open for the duration of the
 //	step. This avoids reconstruction on every acct_gather_sample and
@@ -132,10 +151,90 @@ static table_t *tables = NULL;
 static size_t   tables_max_len = 0;
 static size_t   tables_cur_len = 0;
 
+/*
+ * Samples are buffered per table under buf_mutex and appended to the file by
+ * the writer thread, a chunk at a time, so the gathering threads never wait
+ * on file I/O. All HDF5 calls made once the file is open hold hdf5_mutex.
+ */
+static pthread_mutex_t buf_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  buf_cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t hdf5_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t writer_thread_id = 0;
+static bool writer_flush = false;
+static bool writer_stop = false;
+
 static void _reset_slurm_profile_conf(void)
 {
 	xfree(hdf5_conf.dir);
 	hdf5_conf.def = ACCT_GATHER_PROFILE_NONE;
+	hdf5_conf.chunk_size = HDF5_CHUNK_SIZE;
+	hdf5_conf.compress = HDF5_COMPRESS;
+}
+
+/* Append the buffered records of every table to the file */
+static void _write_pending(void)
+{
+	pending_t *pending;
+	size_t i, cnt;
+
+	slurm_mutex_lock(&buf_mutex);
+	cnt = tables_cur_len;
+	pending = xcalloc(MAX(cnt, 1), sizeof(pending_t));
+	for (i = 0; i < cnt; i++) {
+		pending[i].table_id = tables[i].table_id;
+		pending[i].buf = tables[i].buf;
+		pending[i].buf_cnt = tables[i].buf_cnt;
+		tables[i].buf = NULL;
+		tables[i].buf_cnt = 0;
+	}
+	writer_flush = false;
+	slurm_mutex_unlock(&buf_mutex);
+
+	slurm_mutex_lock(&hdf5_mutex);
+	for (i = 0; i < cnt; i++) {
+		if (!pending[i].buf_cnt)
+			continue;
+		if (H5PTappend(pending[i].table_id, pending[i].buf_cnt,
+			       pending[i].buf) < 0)
+			error("PROFILE: Impossible to add %zu records to the table %zu",
+			      pending[i].buf_cnt, i);
+		xfree(pending[i].buf);
+	}
+	slurm_mutex_unlock(&hdf5_mutex);
+
+	xfree(pending);
+}
+
+static void *_writer_thread(void *arg)
+{
+	struct timespec ts = {0, 0};
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "acctg_hdf5", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m",
+		      __func__, "acctg_hdf5");
+	}
+#endif
+
+	while (true) {
+		slurm_mutex_lock(&buf_mutex);
+		if (!writer_stop && !writer_flush) {
+			ts.tv_sec = time(NULL) + HDF5_FLUSH_INTERVAL;
+			slurm_cond_timedwait(&buf_cond, &buf_mutex, &ts);
+		}
+		if (writer_stop) {
+			slurm_mutex_unlock(&buf_mutex);
+			break;
+		}
+		slurm_mutex_unlock(&buf_mutex);
+
+		_write_pending();
+	}
+
+	/* Write whatever the step left behind */
+	_write_pending();
+
+	return NULL;
 }
 
 static uint32_t _determine_profile(void)
@@ -209,6 +308,8 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 					       int *full_options_cnt)
 {
 	s_p_options_t options[] = {
+		{"ProfileHDF5ChunkSize", S_P_UINT32},
+		{"ProfileHDF5Compress", S_P_LONG},
 		{"ProfileHDF5Dir", S_P_STRING},
 		{"ProfileHDF5Default", S_P_STRING},
 		{NULL} };
@@ -220,10 +321,23 @@ extern void acct_gather_profile_p_conf_options(s_p_options_t **full_options,
 extern void acct_gather_profile_p_conf_set(s_p_hashtbl_t *tbl)
 {
 	char *tmp = NULL;
+	long compress;
+
 	_reset_slurm_profile_conf();
 	if (tbl) {
 		s_p_get_string(&hdf5_conf.dir, "ProfileHDF5Dir", tbl);
 
+		if (s_p_get_uint32(&hdf5_conf.chunk_size,
+				   "ProfileHDF5ChunkSize", tbl) &&
+		    !hdf5_conf.chunk_size)
+			fatal("ProfileHDF5ChunkSize must be greater than zero");
+
+		if (s_p_get_long(&compress, "ProfileHDF5Compress", tbl)) {
+			if ((compress < -1) || (compress > 9))
+				fatal("ProfileHDF5Compress must be -1 through 9");
+			hdf5_conf.compress = compress;
+		}
+
 		if (s_p_get_string(&tmp, "ProfileHDF5Default", tbl)) {
 			hdf5_conf.def = acct_gather_profile_from_string(tmp);
 			if (hdf5_conf.def == ACCT_GATHER_PROFILE_NOT_SET) {
@@ -346,6 +460,10 @@ extern int acct_gather_profile_p_node_step_start(stepd_step_rec_t* job)
 	put_string_attribute(gid_node, ATTR_STARTTIME,
 			     slurm_ctime2(&step_start_time));
 
+	writer_stop = false;
+	writer_flush = false;
+	slurm_thread_create(&writer_thread_id, _writer_thread, NULL);
+
 	return rc;
 }
 
@@ -383,9 +501,21 @@ extern int acct_gather_profile_p_node_step_end(void)
 
 	log_flag(PROFILE, "PROFILE: node_step_end (shutdown)");
 
+	/* write the buffered samples and stop the writer */
+	if (writer_thread_id) {
+		slurm_mutex_lock(&buf_mutex);
+		writer_stop = true;
+		slurm_cond_signal(&buf_cond);
+		slurm_mutex_unlock(&buf_mutex);
+		pthread_join(writer_thread_id, NULL);
+		writer_thread_id = 0;
+	}
+
+	slurm_mutex_lock(&hdf5_mutex);
 	/* close tables */
 	for (i = 0; i < tables_cur_len; ++i) {
 		H5PTclose(tables[i].table_id);
+		xfree(tables[i].buf);
 	}
 	/* close groups */
 	for (i = 0; i < groups_len; ++i) {
@@ -404,6 +534,7 @@ extern int acct_gather_profile_p_node_step_end(void)
 		H5Fclose(file_id);
 	profile_fini();
 	file_id = -1;
+	slurm_mutex_unlock(&hdf5_mutex);
 
 	return rc;
 }
@@ -433,7 +564,11 @@ extern int acct_gather_profile_p_task_end(pid_t taskpid)
 
 extern int64_t acct_gather_profile_p_create_group(const char* name)
 {
-	hid_t gid_group = make_group(gid_node, name);
+	hid_t gid_group;
+
+	slurm_mutex_lock(&hdf5_mutex);
+	gid_group = make_group(gid_node, name);
+	slurm_mutex_unlock(&hdf5_mutex);
 	if (gid_group < 0) {
 		return SLURM_ERROR;
 	}
@@ -452,7 +587,7 @@ extern int acct_gather_profile_p_create_dataset(
 {
 	size_t type_size;
 	size_t offset, field_size;
-	hid_t dtype_id;
+	hid_t dtype_id = -1;
 	hid_t field_id;
 	hid_t table_id;
 	acct_gather_profile_dataset_t *dataset_loc = dataset;
@@ -478,20 +613,22 @@ extern int acct_gather_profile_p_create_dataset(
 		dataset_loc++;
 	}
 
+	slurm_mutex_lock(&hdf5_mutex);
+
 	/* create the datatype for the dataset */
 	if ((dtype_id = H5Tcreate(H5T_COMPOUND, type_size)) < 0) {
 		debug3("PROFILE: failed to create datatype for table %s",
 		       name);
-		return SLURM_ERROR;
+		goto fail;
 	}
 
 	/* insert fields */
 	if (H5Tinsert(dtype_id, "ElapsedTime", 0,
 		      H5T_NATIVE_UINT64) < 0)
-		return SLURM_ERROR;
+		goto fail;
 	if (H5Tinsert(dtype_id, "EpochTime", sizeof(uint64_t),
 		      H5T_NATIVE_UINT64) < 0)
-		return SLURM_ERROR;
+		goto fail;
 
 	dataset_loc = dataset;
 
@@ -513,7 +650,7 @@ extern int acct_gather_profile_p_create_dataset(
 		}
 		if (H5Tinsert(dtype_id, dataset_loc->name,
 			      offset, field_id) < 0)
-			return SLURM_ERROR;
+			goto fail;
 		offset += field_size;
 		dataset_loc++;
 	}
@@ -521,15 +658,16 @@ extern int acct_gather_profile_p_create_dataset(
 	/* create the table */
 	if (parent < 0)
 		parent = gid_node; /* default parent is the node group */
-	table_id = H5PTcreate_fl(parent, name, dtype_id, HDF5_CHUNK_SIZE,
-	                         HDF5_COMPRESS);
+	table_id = H5PTcreate_fl(parent, name, dtype_id, hdf5_conf.chunk_size,
+	                         hdf5_conf.compress);
 	if (table_id < 0) {
 		error("PROFILE: Impossible to create the table %s", name);
-		H5Tclose(dtype_id);
-		return SLURM_ERROR;
+		goto fail;
 	}
 	H5Tclose(dtype_id); /* close the datatype since H5PT keeps a copy */
+	slurm_mutex_unlock(&hdf5_mutex);
 
+	slurm_mutex_lock(&buf_mutex);
 	/* resize the tables array if full */
 	if (tables_cur_len == tables_max_len) {
 		if (tables_max_len == 0)
@@ -541,16 +679,25 @@ extern int acct_gather_profile_p_create_dataset(
 	/* reserve a new table */
 	tables[tables_cur_len].table_id  = table_id;
 	tables[tables_cur_len].type_size = type_size;
+	tables[tables_cur_len].buf = NULL;
+	tables[tables_cur_len].buf_cnt = 0;
 	++tables_cur_len;
+	slurm_mutex_unlock(&buf_mutex);
 
 	return tables_cur_len - 1;
+
+fail:
+	if (dtype_id >= 0)
+		H5Tclose(dtype_id);
+	slurm_mutex_unlock(&hdf5_mutex);
+	return SLURM_ERROR;
 }
 
 extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 						 time_t sample_time)
 {
-	table_t *ds = &tables[table_id];
-	uint8_t send_data[ds->type_size];
+	table_t *ds;
+	uint8_t *send_data;
 	int header_size = 0;
 	debug("acct_gather_profile_p_add_sample_data %d", table_id);
 
@@ -573,6 +720,15 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 	if (g_profile_running <= ACCT_GATHER_PROFILE_NONE)
 		return SLURM_ERROR;
 
+	slurm_mutex_lock(&buf_mutex);
+	ds = &tables[table_id];
+	if (!ds->buf)
+		ds->buf = xmalloc(hdf5_conf.chunk_size * ds->type_size);
+	else if (!(ds->buf_cnt % hdf5_conf.chunk_size))
+		xrealloc(ds->buf, (ds->buf_cnt + hdf5_conf.chunk_size) *
+				  ds->type_size);
+	send_data = ds->buf + (ds->buf_cnt * ds->type_size);
+
 	/* prepend timestampe and relative time */
 	((uint64_t *)send_data)[0] = difftime(sample_time, step_start_time);
 	header_size += sizeof(uint64_t);
@@ -581,12 +737,12 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 
 	memcpy(send_data + header_size, data, ds->type_size - header_size);
 
-	/* append the record to the table */
-	if (H5PTappend(ds->table_id, 1, send_data) < 0) {
-		error("PROFILE: Impossible to add data to the table %d; "
-		      "maybe the table has not been created?", table_id);
-		return SLURM_ERROR;
+	/* the writer appends a full chunk at a time */
+	if (++ds->buf_cnt >= hdf5_conf.chunk_size) {
+		writer_flush = true;
+		slurm_cond_signal(&buf_cond);
 	}
+	slurm_mutex_unlock(&buf_mutex);
 
 	return SLURM_SUCCESS;
 }
@@ -597,6 +753,16 @@ extern void acct_gather_profile_p_conf_values(List *data)
 
 	xassert(*data);
 
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5ChunkSize");
+	key_pair->value = xstrdup_printf("%u", hdf5_conf.chunk_size);
+	list_append(*data, key_pair);
+
+	key_pair = xmalloc(sizeof(config_key_pair_t));
+	key_pair->name = xstrdup("ProfileHDF5Compress");
+	key_pair->value = xstrdup_printf("%d", hdf5_conf.compress);
+	list_append(*data, key_pair);
+
 	key_pair = xmalloc(sizeof(config_key_pair_t));
 	key_pair->name = xstrdup("ProfileHDF5Dir");
 	key_pair->value = xstrdup(hdf5_conf.dir);
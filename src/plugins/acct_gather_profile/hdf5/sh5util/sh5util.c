@@ -138,6 +138,15 @@ typedef struct {
 	int step_id;
 } sh5util_file_t;
 
+/* Records read from a table at a time */
+#define SH5UTIL_READ_BLOCK 1024
+
+enum {
+	FIELD_KIND_OTHER,
+	FIELD_KIND_UINT64,
+	FIELD_KIND_DOUBLE,
+};
+
 static FILE* output_file;
 static bool group_mode = false;
 static const char *current_step;
@@ -914,44 +923,67 @@ static int _tables_list(hid_t fid_job, List tables)
  * @param node_name Name of the node containing this table
  * @param output    output file
  */
+/* Classify each field type once instead of on every record */
+static void _field_kinds(size_t nb_fields, hid_t *types, int *kinds)
+{
+	size_t j;
+
+	for (j = 0; j < nb_fields; ++j) {
+		if (H5Tequal(types[j], H5T_NATIVE_UINT64))
+			kinds[j] = FIELD_KIND_UINT64;
+		else if (H5Tequal(types[j], H5T_NATIVE_DOUBLE))
+			kinds[j] = FIELD_KIND_DOUBLE;
+		else
+			kinds[j] = FIELD_KIND_OTHER;
+	}
+}
+
 static void _extract_totals(size_t nb_fields, size_t *offsets, hid_t *types,
                             hsize_t type_size, hid_t table_id,
                             table_t *table, FILE *output)
 {
-	hsize_t nrecords;
-	size_t i, j;
-	uint8_t *data;
+	hsize_t nrecords, nread, i, k;
+	size_t j;
+	uint8_t *data, *rec = NULL;
+	int kinds[nb_fields];
 
 	/* allocate space for aggregate values: 4 values (min, max,
 	 * sum, avg) on 8 bytes (uint64_t/double) for each field */
 	uint64_t *agg_i;
 	double *agg_d;
 
-	data = xmalloc(type_size);
+	_field_kinds(nb_fields, types, kinds);
+	data = xmalloc(type_size * SH5UTIL_READ_BLOCK);
 	agg_i = xmalloc(nb_fields * 4 * sizeof(uint64_t));
 	agg_d = (double *)agg_i;
 	H5PTget_num_packets(table_id, &nrecords);
 
-	/* compute min/max/sum */
-	for (i = 0; i < nrecords; ++i) {
-		H5PTget_next(table_id, 1, data);
-		for (j = 0; j < nb_fields; ++j) {
-			if (H5Tequal(types[j], H5T_NATIVE_UINT64)) {
-				uint64_t v = *(uint64_t *)(data + offsets[j]);
-				uint64_t *a = agg_i + j * 4;
-				if (i == 0 || v < a[0]) /* min */
-					a[0] = v;
-				if (v > a[1]) /* max */
-					a[1] = v;
-				a[2] += v; /* sum */
-			} else if (H5Tequal(types[j], H5T_NATIVE_DOUBLE)) {
-				double v = *(double *)(data + offsets[j]);
-				double *a = agg_d + j * 4;
-				if (i == 0 || v < a[0]) /* min */
-					a[0] = v;
-				if (v > a[1]) /* max */
-					a[1] = v;
-				a[2] += v; /* sum */
+	/* compute min/max/sum, reading a block of records at a time */
+	for (i = 0; i < nrecords; i += nread) {
+		nread = MIN(SH5UTIL_READ_BLOCK, nrecords - i);
+		H5PTget_next(table_id, nread, data);
+		for (k = 0; k < nread; k++) {
+			rec = data + (k * type_size);
+			for (j = 0; j < nb_fields; ++j) {
+				if (kinds[j] == FIELD_KIND_UINT64) {
+					uint64_t v = *(uint64_t *)
+						(rec + offsets[j]);
+					uint64_t *a = agg_i + j * 4;
+					if (!(i + k) || v < a[0]) /* min */
+						a[0] = v;
+					if (v > a[1]) /* max */
+						a[1] = v;
+					a[2] += v; /* sum */
+				} else if (kinds[j] == FIELD_KIND_DOUBLE) {
+					double v = *(double *)
+						(rec + offsets[j]);
+					double *a = agg_d + j * 4;
+					if (!(i + k) || v < a[0]) /* min */
+						a[0] = v;
+					if (v > a[1]) /* max */
+						a[1] = v;
+					a[2] += v; /* sum */
+				}
 			}
 		}
 	}
@@ -959,9 +991,9 @@ static void _extract_totals(size_t nb_fields, size_t *offsets, hid_t *types,
 	/* compute avg */
 	if (nrecords) {
 		for (j = 0; j < nb_fields; ++j) {
-			if (H5Tequal(types[j], H5T_NATIVE_UINT64)) {
+			if (kinds[j] == FIELD_KIND_UINT64) {
 				agg_d[j*4+3] = (double)agg_i[j*4+2] / nrecords;
-			} else if (H5Tequal(types[j], H5T_NATIVE_DOUBLE)) {
+			} else if (kinds[j] == FIELD_KIND_DOUBLE) {
 				agg_d[j*4+3] = (double)agg_d[j*4+2] / nrecords;
 			}
 		}
@@ -974,17 +1006,17 @@ static void _extract_totals(size_t nb_fields, size_t *offsets, hid_t *types,
 		fprintf(output, ",%s", table->name);
 
 	/* elapsed time (first field in the last record) */
-	fprintf(output, ",%"PRIu64, *(uint64_t *)data);
+	fprintf(output, ",%"PRIu64, rec ? *(uint64_t *)rec : 0);
 
 	/* aggregate values */
 	for (j = 0; j < nb_fields; ++j) {
-		if (H5Tequal(types[j], H5T_NATIVE_UINT64)) {
+		if (kinds[j] == FIELD_KIND_UINT64) {
 			fprintf(output, ",%"PRIu64",%"PRIu64",%"PRIu64",%lf",
 			        agg_i[j * 4 + 0],
 			        agg_i[j * 4 + 1],
 			        agg_i[j * 4 + 2],
 			        agg_d[j * 4 + 3]);
-		} else if (H5Tequal(types[j], H5T_NATIVE_DOUBLE)) {
+		} else if (kinds[j] == FIELD_KIND_DOUBLE) {
 			fprintf(output, ",%lf,%lf,%lf,%lf",
 			        agg_d[j * 4 + 0],
 			        agg_d[j * 4 + 1],
@@ -1084,31 +1116,48 @@ static int _extract_series_table(hid_t fid_job, table_t *table, List fields,
 		                table_id, table, output);
 	} else {
 		/* Timeseries level */
-		H5PTget_num_packets(table_id, &nrecords);
-		uint8_t data[type_size];
+		int kinds[nb_fields];
+		uint8_t *data, *rec;
+		hsize_t nread, k;
 
-		/* print the expected fields of all the records */
-		for (i = 0; i < nrecords; ++i) {
-			H5PTget_next(table_id, 1, data);
-			fprintf(output, "%s,%s", table->step, table->node);
-			if (group_mode)
-				fprintf(output, ",%s", table->name);
+		H5PTget_num_packets(table_id, &nrecords);
+		_field_kinds(nb_fields, types, kinds);
+		for (j = 0; j < nb_fields; ++j) {
+			if (kinds[j] == FIELD_KIND_OTHER) {
+				error("Unknown type");
+				goto error;
+			}
+		}
+		data = xmalloc(type_size * SH5UTIL_READ_BLOCK);
 
-			for (j = 0; j < nb_fields; ++j) {
-				if (H5Tequal(types[j], H5T_NATIVE_UINT64)) {
-					fprintf(output, ",%"PRIu64,
-					        *(uint64_t *)(data+offsets[j]));
-				} else if (H5Tequal(types[j],
-				                    H5T_NATIVE_DOUBLE)) {
-					fprintf(output, ",%lf",
-					        *(double *)(data + offsets[j]));
-				} else {
-					error("Unknown type");
-					goto error;
+		/*
+		 * print the expected fields of all the records, reading a
+		 * block of records at a time
+		 */
+		for (i = 0; i < nrecords; i += nread) {
+			nread = MIN(SH5UTIL_READ_BLOCK, nrecords - i);
+			H5PTget_next(table_id, nread, data);
+			for (k = 0; k < nread; k++) {
+				rec = data + (k * type_size);
+				fprintf(output, "%s,%s",
+					table->step, table->node);
+				if (group_mode)
+					fprintf(output, ",%s", table->name);
+
+				for (j = 0; j < nb_fields; ++j) {
+					if (kinds[j] == FIELD_KIND_UINT64)
+						fprintf(output, ",%"PRIu64,
+							*(uint64_t *)
+							(rec + offsets[j]));
+					else
+						fprintf(output, ",%lf",
+							*(double *)
+							(rec + offsets[j]));
 				}
+				fputc('\n', output);
 			}
-			fputc('\n', output);
 		}
+		xfree(data);
 	}
 
 	H5PTclose(table_id);
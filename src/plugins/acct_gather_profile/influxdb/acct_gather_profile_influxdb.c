@@ -55,6 +55,7 @@
 #include <inttypes.h>
 #include <unistd.h>
 #include <math.h>
+#include <pthread.h>
 #include <curl/curl.h>
 
 #include "src/common/slurm_xlator.h"
@@ -66,6 +67,9 @@
 #include "src/common/macros.h"
 #include "src/slurmd/common/proctrack.h"
 
+#if HAVE_SYS_PRCTL_H
+#  include <sys/prctl.h>
+#endif
 
 /*
  * These variables are required by the generic plugin interface.  If they
@@ -96,6 +100,13 @@ const char plugin_name[] = "AcctGatherProfile influxdb plugin";
 const char plugin_type[] = "acct_gather_profile/influxdb";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
+/* Maximum number of full sample buffers waiting to be sent */
+#define INFLUXDB_MAX_BATCHES 64
+/* Seconds to wait before retrying a failed send */
+#define INFLUXDB_RETRY_DELAY 5
+/* Seconds allowed for a single HTTP request */
+#define INFLUXDB_TIMEOUT 10
+
 typedef struct {
 	char *host;
 	char *database;
@@ -118,6 +129,13 @@ struct http_response {
 	size_t size;
 };
 
+/* Buffer of line protocol points waiting for the sender thread */
+typedef struct {
+	char *data;
+	uint32_t points;
+	uint32_t retries;
+} batch_t;
+
 union data_t{
 	uint64_t u;
 	double	 d;
@@ -129,6 +147,16 @@ static stepd_step_rec_t *g_job = NULL;
 
 static char *datastr = NULL;
 static int datastrlen = 0;
+static uint32_t datastr_points = 0;
+
+/* Protects the sample buffer, batches list and counters below */
+static pthread_mutex_t send_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t send_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t send_thread_id = 0;
+static bool send_stop = false;
+static List batches = NULL;
+static uint64_t points_dropped = 0;	/* never sent */
+static uint64_t points_late = 0;	/* sent after a retry */
 
 static table_t *tables = NULL;
 static size_t tables_max_len = 0;
@@ -189,53 +217,89 @@ static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 	return realsize;
 }
 
-/* Try to send data to influxdb */
-static int _send_data(const char *data)
+static void _free_batch(void *x)
+{
+	batch_t *batch = x;
+
+	if (!batch)
+		return;
+	xfree(batch->data);
+	xfree(batch);
+}
+
+/*
+ * Move the sample buffer to the send queue and wake up the sender thread.
+ * If the queue is full the oldest batch is dropped, so that a slow or
+ * unreachable server never stalls sampling or grows slurmstepd without bound.
+ * Call with send_mutex locked.
+ */
+static void _queue_datastr(void)
+{
+	batch_t *batch;
+
+	if (!datastrlen)
+		return;
+
+	while (list_count(batches) >= INFLUXDB_MAX_BATCHES) {
+		batch = list_pop(batches);
+		points_dropped += batch->points;
+		log_flag(PROFILE, "%s %s: send queue full, dropping %u points",
+			 plugin_type, __func__, batch->points);
+		_free_batch(batch);
+	}
+
+	batch = xmalloc(sizeof(*batch));
+	batch->data = datastr;
+	batch->points = datastr_points;
+	list_enqueue(batches, batch);
+
+	datastr = xmalloc(BUF_SIZE);
+	datastrlen = 0;
+	datastr_points = 0;
+	slurm_cond_signal(&send_cond);
+}
+
+/*
+ * Every compute node which is sampling data will try to establish a
+ * different connection to the influxdb server. In order to reduce the
+ * number of connections, every time a new sampled data comes in, it
+ * is saved in the 'datastr' buffer. Once this buffer is full, it is handed
+ * to the sender thread which posts it, instead of sending one per sample.
+ */
+static void _buffer_data(const char *data, uint32_t points)
+{
+	size_t length = strlen(data);
+
+	slurm_mutex_lock(&send_mutex);
+	if ((datastrlen + length) > BUF_SIZE)
+		_queue_datastr();
+	xstrcat(datastr, data);
+	datastrlen += length;
+	datastr_points += points;
+	log_flag(PROFILE, "%s %s: %zu bytes of data added to buffer. New buffer size: %d",
+		 plugin_type, __func__, length, datastrlen);
+	slurm_mutex_unlock(&send_mutex);
+}
+
+/*
+ * Try to send a batch of data to influxdb.
+ * On failure, retry is set if the server may accept the batch later.
+ */
+static int _send_data(CURL *curl_handle, const char *url, batch_t *batch,
+		      bool *retry)
 {
-	CURL *curl_handle = NULL;
 	CURLcode res;
 	struct http_response chunk;
 	int rc = SLURM_SUCCESS;
 	long response_code;
 	static int error_cnt = 0;
-	char *url = NULL;
-	size_t length;
 
 	debug3("%s %s called", plugin_type, __func__);
 
-	/*
-	 * Every compute node which is sampling data will try to establish a
-	 * different connection to the influxdb server. In order to reduce the
-	 * number of connections, every time a new sampled data comes in, it
-	 * is saved in the 'datastr' buffer. Once this buffer is full, then we
-	 * try to open the connection and send this buffer, instead of opening
-	 * one per sample.
-	 */
-	if (data && ((datastrlen + strlen(data)) <= BUF_SIZE)) {
-		xstrcat(datastr, data);
-		length = strlen(data);
-		datastrlen += length;
-		log_flag(PROFILE, "%s %s: %zu bytes of data added to buffer. New buffer size: %d",
-			 plugin_type, __func__, length, datastrlen);
-		return rc;
-	}
-
 	DEF_TIMERS;
 	START_TIMER;
 
-	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
-		error("%s %s: curl_global_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_global_init;
-	} else if ((curl_handle = curl_easy_init()) == NULL) {
-		error("%s %s: curl_easy_init: %m", plugin_type, __func__);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
-	}
-
-	xstrfmtcat(url, "%s/write?db=%s&rp=%s&precision=s", influxdb_conf.host,
-		   influxdb_conf.database, influxdb_conf.rt_policy);
-
+	*retry = true;
 	chunk.message = xmalloc(1);
 	chunk.size = 0;
 
@@ -243,18 +307,21 @@ static int _send_data(const char *data)
 	if (influxdb_conf.password)
 		curl_easy_setopt(curl_handle, CURLOPT_PASSWORD,
 				 influxdb_conf.password);
-	curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, datastr);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(datastr));
+	curl_easy_setopt(curl_handle, CURLOPT_POST, 1L);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, batch->data);
+	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE,
+			 (long) strlen(batch->data));
 	if (influxdb_conf.username)
 		curl_easy_setopt(curl_handle, CURLOPT_USERNAME,
 				 influxdb_conf.username);
+	curl_easy_setopt(curl_handle, CURLOPT_TIMEOUT, (long) INFLUXDB_TIMEOUT);
+	curl_easy_setopt(curl_handle, CURLOPT_NOSIGNAL, 1L);
 	curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, _write_callback);
 	curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &chunk);
 
 	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
 		if ((error_cnt++ % 100) == 0)
-			error("%s %s: curl_easy_perform failed to send data (discarded). Reason: %s",
+			error("%s %s: curl_easy_perform failed to send data. Reason: %s",
 			      plugin_type, __func__, curl_easy_strerror(res));
 		rc = SLURM_ERROR;
 		goto cleanup;
@@ -284,34 +351,120 @@ static int _send_data(const char *data)
 		       plugin_type, __func__, response_code);
 		if (slurm_conf.debug_flags & DEBUG_FLAG_PROFILE) {
 			/* Strip any trailing newlines. */
-			while (chunk.message[strlen(chunk.message) - 1] == '\n')
-				chunk.message[strlen(chunk.message) - 1] = '\0';
+			while (chunk.size &&
+			       (chunk.message[chunk.size - 1] == '\n'))
+				chunk.message[--chunk.size] = '\0';
 			info("%s %s: JSON response body: %s", plugin_type,
 			     __func__, chunk.message);
 		}
+		/* The server will not accept this data if we try again */
+		if ((response_code >= 400) && (response_code < 500))
+			*retry = false;
 	}
 
 cleanup:
 	xfree(chunk.message);
+
+	END_TIMER;
+	log_flag(PROFILE, "%s %s: took %s to send data",
+		 plugin_type, __func__, TIME_STR);
+
+	return rc;
+}
+
+/*
+ * Post queued batches to influxdb. A batch that fails to send is put back
+ * at the head of the queue and retried after INFLUXDB_RETRY_DELAY seconds,
+ * while new samples keep being queued (dropping the oldest ones if the
+ * server stays unavailable). Once asked to stop, the remaining batches are
+ * sent until the first failure.
+ */
+static void *_send_thread(void *arg)
+{
+	CURL *curl_handle = NULL;
+	char *url = NULL;
+	batch_t *batch;
+	struct timespec ts = {0, 0};
+	time_t deadline;
+	bool stop, retry;
+	int rc;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "acctg_influxdb", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m",
+		      __func__, "acctg_influxdb");
+	}
+#endif
+
+	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
+		error("%s %s: curl_global_init: %m", plugin_type, __func__);
+		goto cleanup_global_init;
+	} else if ((curl_handle = curl_easy_init()) == NULL) {
+		error("%s %s: curl_easy_init: %m", plugin_type, __func__);
+		goto cleanup_easy_init;
+	}
+
+	xstrfmtcat(url, "%s/write?db=%s&rp=%s&precision=s", influxdb_conf.host,
+		   influxdb_conf.database, influxdb_conf.rt_policy);
+
+	slurm_mutex_lock(&send_mutex);
+	while (true) {
+		while (!send_stop && !list_count(batches))
+			slurm_cond_wait(&send_cond, &send_mutex);
+		stop = send_stop;
+		if (!(batch = list_pop(batches)))
+			break;
+		slurm_mutex_unlock(&send_mutex);
+
+		rc = _send_data(curl_handle, url, batch, &retry);
+
+		slurm_mutex_lock(&send_mutex);
+		if (rc == SLURM_SUCCESS) {
+			if (batch->retries)
+				points_late += batch->points;
+			_free_batch(batch);
+			continue;
+		}
+
+		if (stop || !retry) {
+			points_dropped += batch->points;
+			_free_batch(batch);
+			/* Don't hold up the end of the step on a dead server */
+			if (stop)
+				break;
+			continue;
+		}
+
+		batch->retries++;
+		if (list_count(batches) >= INFLUXDB_MAX_BATCHES) {
+			points_dropped += batch->points;
+			_free_batch(batch);
+		} else
+			list_push(batches, batch);
+
+		deadline = time(NULL) + INFLUXDB_RETRY_DELAY;
+		while (!send_stop && (time(NULL) < deadline)) {
+			ts.tv_sec = deadline;
+			slurm_cond_timedwait(&send_cond, &send_mutex, &ts);
+		}
+	}
+	slurm_mutex_unlock(&send_mutex);
+
 	xfree(url);
 cleanup_easy_init:
 	curl_easy_cleanup(curl_handle);
 cleanup_global_init:
 	curl_global_cleanup();
 
-	END_TIMER;
-	log_flag(PROFILE, "%s %s: took %s to send data",
-		 plugin_type, __func__, TIME_STR);
-
-	if (data) {
-		datastr = xstrdup(data);
-		datastrlen = strlen(data);
-	} else {
-		datastr[0] = '\0';
-		datastrlen = 0;
+	/* Anything left could not be sent */
+	slurm_mutex_lock(&send_mutex);
+	while ((batch = list_pop(batches))) {
+		points_dropped += batch->points;
+		_free_batch(batch);
 	}
+	slurm_mutex_unlock(&send_mutex);
 
-	return rc;
+	return NULL;
 }
 
 /*
@@ -326,6 +479,7 @@ extern int init(void)
 		return SLURM_SUCCESS;
 
 	datastr = xmalloc(BUF_SIZE);
+	batches = list_create(_free_batch);
 	return SLURM_SUCCESS;
 }
 
@@ -334,6 +488,7 @@ extern int fini(void)
 	debug3("%s %s called", plugin_type, __func__);
 
 	_free_tables();
+	FREE_NULL_LIST(batches);
 	xfree(datastr);
 	xfree(influxdb_conf.host);
 	xfree(influxdb_conf.database);
@@ -445,6 +600,10 @@ extern int acct_gather_profile_p_node_step_start(stepd_step_rec_t* job)
 	debug2("%s %s: option --profile=%s", plugin_type, __func__,
 	       profile_str);
 	g_profile_running = _determine_profile();
+
+	if (g_profile_running > ACCT_GATHER_PROFILE_NONE)
+		slurm_thread_create(&send_thread_id, _send_thread, NULL);
+
 	return rc;
 }
 
@@ -461,6 +620,22 @@ extern int acct_gather_profile_p_node_step_end(void)
 
 	xassert(running_in_slurmstepd());
 
+	if (!send_thread_id)
+		return rc;
+
+	slurm_mutex_lock(&send_mutex);
+	_queue_datastr();
+	send_stop = true;
+	slurm_cond_signal(&send_cond);
+	slurm_mutex_unlock(&send_mutex);
+
+	pthread_join(send_thread_id, NULL);
+	send_thread_id = 0;
+
+	if (points_dropped || points_late)
+		info("%s %s: %"PRIu64" points dropped, %"PRIu64" points sent late",
+		     plugin_type, __func__, points_dropped, points_late);
+
 	return rc;
 }
 
@@ -486,7 +661,9 @@ extern int acct_gather_profile_p_task_end(pid_t taskpid)
 {
 	debug3("%s %s called", plugin_type, __func__);
 
-	_send_data(NULL);
+	slurm_mutex_lock(&send_mutex);
+	_queue_datastr();
+	slurm_mutex_unlock(&send_mutex);
 	return SLURM_SUCCESS;
 }
 
@@ -583,7 +760,8 @@ extern int acct_gather_profile_p_add_sample_data(int table_id, void *data,
 		}
 	}
 
-	_send_data(str);
+	if (str)
+		_buffer_data(str, table->size);
 	xfree(str);
 
 	return SLURM_SUCCESS;
@@ -36,6 +36,7 @@
 
 #include <jwt.h>
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
@@ -43,6 +44,7 @@
 
 #include "slurm/slurm_errno.h"
 #include "src/common/slurm_xlator.h"
+#include "src/common/macros.h"
 #include "src/common/pack.h"
 #include "src/common/uid.h"
 
@@ -100,6 +102,24 @@ char *token = NULL;
 __thread char *thread_token = NULL;
 __thread char *thread_username = NULL;
 
+/*
+ * Cache of recently verified tokens. A client such as slurmrestd sends the
+ * same token with every RPC for the token's lifetime, so remembering the
+ * outcome saves a jwt_decode() and signature check per message. Only the
+ * exact token string is matched, and entries are dropped once the token
+ * expires.
+ */
+#define JWT_CACHE_SIZE 64
+typedef struct {
+	char *token;
+	char *username;
+	time_t expiration;
+	time_t last_used;
+} token_cache_t;
+
+static token_cache_t token_cache[JWT_CACHE_SIZE];
+static pthread_mutex_t token_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*
  * This plugin behaves differently than the others in that it needs to operate
  * asynchronously. If we're running in one of the daemons, it's presumed that
@@ -116,6 +136,66 @@ __thread char *thread_username = NULL;
  *		requestor for a given username and duration.
  */
 
+/* Return an xmalloc()'d username if token was verified recently */
+static char *_cache_lookup(const char *token)
+{
+	char *username = NULL;
+	time_t now = time(NULL);
+
+	slurm_mutex_lock(&token_cache_lock);
+	for (int i = 0; i < JWT_CACHE_SIZE; i++) {
+		token_cache_t *entry = &token_cache[i];
+
+		if (!entry->token || xstrcmp(entry->token, token))
+			continue;
+		if (entry->expiration >= now) {
+			entry->last_used = now;
+			username = xstrdup(entry->username);
+		} else {
+			xfree(entry->token);
+			xfree(entry->username);
+		}
+		break;
+	}
+	slurm_mutex_unlock(&token_cache_lock);
+
+	return username;
+}
+
+/* Remember a verified token, replacing the least recently used entry */
+static void _cache_add(const char *token, const char *username,
+		       time_t expiration)
+{
+	token_cache_t *entry = &token_cache[0];
+
+	slurm_mutex_lock(&token_cache_lock);
+	for (int i = 0; i < JWT_CACHE_SIZE; i++) {
+		if (!token_cache[i].token) {
+			entry = &token_cache[i];
+			break;
+		}
+		if (token_cache[i].last_used < entry->last_used)
+			entry = &token_cache[i];
+	}
+	xfree(entry->token);
+	xfree(entry->username);
+	entry->token = xstrdup(token);
+	entry->username = xstrdup(username);
+	entry->expiration = expiration;
+	entry->last_used = time(NULL);
+	slurm_mutex_unlock(&token_cache_lock);
+}
+
+static void _cache_purge(void)
+{
+	slurm_mutex_lock(&token_cache_lock);
+	for (int i = 0; i < JWT_CACHE_SIZE; i++) {
+		xfree(token_cache[i].token);
+		xfree(token_cache[i].username);
+	}
+	slurm_mutex_unlock(&token_cache_lock);
+}
+
 const char *jwt_key_field = "jwt_key=";
 const char *jwks_key_field = "jwks=";
 
@@ -240,6 +320,7 @@ extern int fini(void)
 {
 	FREE_NULL_DATA(jwks);
 	free_buf(key);
+	_cache_purge();
 
 	return SLURM_SUCCESS;
 }
@@ -312,6 +393,7 @@ int auth_p_verify(auth_token_t *cred, char *auth_info)
 	const char *alg;
 	jwt_t *unverified_jwt = NULL, *jwt = NULL;
 	char *username = NULL;
+	time_t expiration;
 
 	if (!cred)
 		return SLURM_ERROR;
@@ -330,6 +412,9 @@ int auth_p_verify(auth_token_t *cred, char *auth_info)
 		goto fail;
 	}
 
+	if ((username = _cache_lookup(cred->token)))
+		goto check_user;
+
 	if (jwt_decode(&unverified_jwt, cred->token, NULL, 0)) {
 		error("%s: initial jwt_decode failure", __func__);
 		goto fail;
@@ -389,7 +474,7 @@ int auth_p_verify(auth_token_t *cred, char *auth_info)
 	 * check the expiration, and sort out the appropriate username
 	 */
 
-	if (jwt_get_grant_int(jwt, "exp") < time(NULL)) {
+	if ((expiration = jwt_get_grant_int(jwt, "exp")) < time(NULL)) {
 		error("%s: token expired", __func__);
 		goto fail;
 	}
@@ -404,6 +489,11 @@ int auth_p_verify(auth_token_t *cred, char *auth_info)
 		goto fail;
 	}
 
+	jwt_free(jwt);
+	jwt = NULL;
+	_cache_add(cred->token, username, expiration);
+
+check_user:
 	if (!cred->username)
 		cred->username = username;
 	else if (!xstrcmp(cred->username, username)) {
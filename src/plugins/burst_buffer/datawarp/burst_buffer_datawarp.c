@@ -172,6 +172,9 @@ typedef struct bb_sessions {
 typedef struct {
 	char   **args;
 	uint32_t job_id;
+	char    *path_file;
+	char   **paths_args;	/* "paths" operation, run before pre_run */
+	uint32_t paths_timeout;	/* in msec */
 	uint32_t timeout;
 	uint32_t user_id;
 } pre_run_args_t;
@@ -4066,12 +4069,10 @@ extern int bb_p_job_begin(job_record_t *job_ptr)
 	char *client_nodes_file_nid = NULL;
 	pre_run_args_t *pre_run_args;
 	char **pre_run_argv = NULL, **script_argv = NULL;
-	char *job_dir = NULL, *path_file, *resp_msg;
-	int arg_inx, hash_inx, rc = SLURM_SUCCESS, status = 0;
+	char *job_dir = NULL;
+	int arg_inx, hash_inx, rc = SLURM_SUCCESS;
 	bb_job_t *bb_job;
-	uint32_t timeout;
 	bool do_pre_run;
-	DEF_TIMERS;
 	pthread_t tid;
 
 	if ((job_ptr->burst_buffer == NULL) ||
@@ -4136,10 +4137,15 @@ extern int bb_p_job_begin(job_record_t *job_ptr)
 		xfree(client_nodes_file_nid);
 	}
 
-	/* Run "paths" function, get DataWarp environment variables */
+	/*
+	 * Setup "paths" function, which gets the DataWarp environment
+	 * variables. It is run from the _start_pre_run() thread ahead of
+	 * pre_run so that the scheduler does not wait on dw_wlm_cli while
+	 * holding the job write lock. Launch is deferred until that thread
+	 * is done, so the environment is in place before the job starts.
+	 */
 	if (do_pre_run) {
-		/* Setup "paths" operation */
-		timeout = bb_state.bb_config.validate_timeout * 1000;
+		pre_run_args = xmalloc(sizeof(pre_run_args_t));
 		script_argv = xcalloc(10, sizeof(char *)); /* NULL terminate */
 		script_argv[0] = xstrdup("dw_wlm_cli");
 		script_argv[1] = xstrdup("--function");
@@ -4150,37 +4156,10 @@ extern int bb_p_job_begin(job_record_t *job_ptr)
 		xstrfmtcat(script_argv[6], "%u", job_ptr->job_id);
 		script_argv[7] = xstrdup("--pathfile");
 		xstrfmtcat(script_argv[8], "%s/path", job_dir);
-		path_file = script_argv[8];
-		START_TIMER;
-		resp_msg = run_command("paths",
-				       bb_state.bb_config.get_sys_state,
-				       script_argv, NULL, timeout, 0,
-				       &status);
-		END_TIMER;
-		if ((DELTA_TIMER > 200000) ||	/* 0.2 secs */
-		    (slurm_conf.debug_flags & DEBUG_FLAG_BURST_BUF))
-			info("paths ran for %s",
-			     TIME_STR);
-		_log_script_argv(script_argv, resp_msg);
-#if 1
-		//FIXME: Cray API returning "job_file_valid True" but exit 1 in some cases
-		if ((!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) &&
-		    (!resp_msg ||
-		     strncmp(resp_msg, "job_file_valid True", 19))) {
-#else
-		if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
-#endif
-			error("paths for %pJ status:%u response:%s",
-			      job_ptr, status, resp_msg);
-			xfree(resp_msg);
-			rc = ESLURM_INVALID_BURST_BUFFER_REQUEST;
-			free_command_argv(script_argv);
-			goto fini;
-		} else {
-			_update_job_env(job_ptr, path_file);
-			xfree(resp_msg);
-		}
-		free_command_argv(script_argv);
+		pre_run_args->path_file = xstrdup(script_argv[8]);
+		pre_run_args->paths_args = script_argv;
+		pre_run_args->paths_timeout =
+			bb_state.bb_config.validate_timeout * 1000;
 
 		/* Setup "pre_run" operation */
 		pre_run_argv = xcalloc(12, sizeof(char *));
@@ -4201,7 +4180,6 @@ extern int bb_p_job_begin(job_record_t *job_ptr)
 			pre_run_argv[arg_inx++] =
 				xstrdup(client_nodes_file_nid);
 		}
-		pre_run_args = xmalloc(sizeof(pre_run_args_t));
 		pre_run_args->args    = pre_run_argv;
 		pre_run_args->job_id  = job_ptr->job_id;
 		pre_run_args->timeout = bb_state.bb_config.other_timeout * 1000;
@@ -4214,7 +4192,6 @@ extern int bb_p_job_begin(job_record_t *job_ptr)
 		slurm_thread_create(&tid, _start_pre_run, pre_run_args);
 	}
 
-fini:
 	xfree(client_nodes_file_nid);
 	xfree(job_dir);
 	return rc;
@@ -4240,6 +4217,61 @@ static void _kill_job(job_record_t *job_ptr, bool hold_job)
 	deallocate_nodes(job_ptr, false, false, false);
 }
 
+static void _free_pre_run_args(pre_run_args_t *pre_run_args)
+{
+	free_command_argv(pre_run_args->args);
+	free_command_argv(pre_run_args->paths_args);
+	xfree(pre_run_args->path_file);
+	xfree(pre_run_args);
+}
+
+/*
+ * Run the "paths" operation and load the DataWarp environment variables
+ * it reports into the job.
+ * RET true on success, otherwise resp_msg and status describe the failure
+ */
+static bool _run_paths(pre_run_args_t *pre_run_args, char **resp_msg,
+		       int *status)
+{
+	/* Locks: write job */
+	slurmctld_lock_t job_write_lock = {
+		NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK, READ_LOCK };
+	job_record_t *job_ptr;
+	DEF_TIMERS;
+
+	START_TIMER;
+	*resp_msg = run_command("paths",
+				bb_state.bb_config.get_sys_state,
+				pre_run_args->paths_args, NULL,
+				pre_run_args->paths_timeout, pthread_self(),
+				status);
+	END_TIMER;
+	if ((DELTA_TIMER > 200000) ||	/* 0.2 secs */
+	    (slurm_conf.debug_flags & DEBUG_FLAG_BURST_BUF))
+		info("paths for JobId=%u ran for %s",
+		     pre_run_args->job_id, TIME_STR);
+	_log_script_argv(pre_run_args->paths_args, *resp_msg);
+#if 1
+	//FIXME: Cray API returning "job_file_valid True" but exit 1 in some cases
+	if ((!WIFEXITED(*status) || (WEXITSTATUS(*status) != 0)) &&
+	    (!*resp_msg ||
+	     strncmp(*resp_msg, "job_file_valid True", 19))) {
+#else
+	if (!WIFEXITED(*status) || (WEXITSTATUS(*status) != 0)) {
+#endif
+		return false;
+	}
+	xfree(*resp_msg);
+	*status = 0;
+
+	lock_slurmctld(job_write_lock);
+	if ((job_ptr = find_job_record(pre_run_args->job_id)))
+		_update_job_env(job_ptr, pre_run_args->path_file);
+	unlock_slurmctld(job_write_lock);
+
+	return true;
+}
+
 static void *_start_pre_run(void *x)
 {
 	/* Locks: read job */
@@ -4249,7 +4281,7 @@ static void *_start_pre_run(void *x)
 	slurmctld_lock_t job_write_lock = {
 		NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK, READ_LOCK };
 	pre_run_args_t *pre_run_args = (pre_run_args_t *) x;
-	char *resp_msg = NULL;
+	char *resp_msg = NULL, *op = "dws_pre_run", *comment_op = "pre_run";
 	bb_job_t *bb_job = NULL;
 	int status = 0;
 	job_record_t *job_ptr;
@@ -4259,12 +4291,20 @@ static void *_start_pre_run(void *x)
 	DEF_TIMERS;
 	track_script_rec_add(pre_run_args->job_id, 0, pthread_self());
 
+	if (pre_run_args->paths_args &&
+	    !_run_paths(pre_run_args, &resp_msg, &status)) {
+		/* Handled like a pre_run failure */
+		op = comment_op = "paths";
+		goto fini;
+	}
+
 	/* Wait for node boot to complete */
 	while (!nodes_ready) {
 		lock_slurmctld(job_read_lock);
 		job_ptr = find_job_record(pre_run_args->job_id);
 		if (!job_ptr || IS_JOB_COMPLETED(job_ptr)) {
 			unlock_slurmctld(job_read_lock);
+			_free_pre_run_args(pre_run_args);
 			track_script_remove(pthread_self());
 			return NULL;
 		}
@@ -4284,14 +4324,20 @@ static void *_start_pre_run(void *x)
 			       timeout, pthread_self(),
 			       &status);
 	END_TIMER;
+	if ((DELTA_TIMER > 500000) ||	/* 0.5 secs */
+	    (slurm_conf.debug_flags & DEBUG_FLAG_BURST_BUF)) {
+		info("dws_pre_run for JobId=%u ran for %s",
+		     pre_run_args->job_id, TIME_STR);
+	}
+	_log_script_argv(pre_run_args->args, resp_msg);
 
+fini:
 	if (track_script_broadcast(pthread_self(), status)) {
 		/* I was killed by slurmtrack, bail out right now */
-		info("dws_pre_run for JobId=%u terminated by slurmctld",
-		     pre_run_args->job_id);
+		info("%s for JobId=%u terminated by slurmctld",
+		     op, pre_run_args->job_id);
 		xfree(resp_msg);
-		free_command_argv(pre_run_args->args);
-		xfree(pre_run_args);
+		_free_pre_run_args(pre_run_args);
 		track_script_remove(pthread_self());
 		return NULL;
 	}
@@ -4300,21 +4346,16 @@ static void *_start_pre_run(void *x)
 	lock_slurmctld(job_write_lock);
 	slurm_mutex_lock(&bb_state.bb_mutex);
 	job_ptr = find_job_record(pre_run_args->job_id);
-	if ((DELTA_TIMER > 500000) ||	/* 0.5 secs */
-	    (slurm_conf.debug_flags & DEBUG_FLAG_BURST_BUF)) {
-		info("dws_pre_run for %pJ ran for %s",
-		     job_ptr, TIME_STR);
-	}
 	if (job_ptr)
 		bb_job = _get_bb_job(job_ptr);
-	_log_script_argv(pre_run_args->args, resp_msg);
 	if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0)) {
 		/* Pre-run failure */
 		trigger_burst_buffer();
-		error("dws_pre_run for %pJ status:%u response:%s",
-		      job_ptr, status, resp_msg);
+		error("%s for %pJ status:%u response:%s",
+		      op, job_ptr, status, resp_msg);
 		if (job_ptr) {
-			_update_system_comment(job_ptr, "pre_run", resp_msg, 0);
+			_update_system_comment(job_ptr, comment_op,
+					       resp_msg, 0);
 			if (IS_JOB_RUNNING(job_ptr))
 				run_kill_job = true;
 			if (bb_job) {
@@ -4346,8 +4387,7 @@ static void *_start_pre_run(void *x)
 	unlock_slurmctld(job_write_lock);
 
 	xfree(resp_msg);
-	free_command_argv(pre_run_args->args);
-	xfree(pre_run_args);
+	_free_pre_run_args(pre_run_args);
 
 	track_script_remove(pthread_self());
 
@@ -66,6 +66,40 @@ static char *_cgroup_procs_writable_path(xcgroup_t *cg)
 	return _cgroup_procs_check(cg, S_IWUSR);
 }
 
+/*
+ * Read the whole content of fd in page sized chunks until EOF and return it
+ * NUL terminated in an xmalloc'd buffer, or NULL on error. Files like
+ * cgroup.procs have no meaningful st_size and can be large for steps with
+ * many processes, so don't size them up a byte at a time first.
+ */
+static char *_file_read_all(int fd, size_t *fsize)
+{
+	size_t buf_size = 4096, len = 0;
+	char *buf = xmalloc(buf_size);
+	ssize_t rc;
+
+	while (1) {
+		if ((buf_size - len) < 2) {
+			buf_size *= 2;
+			xrealloc(buf, buf_size);
+		}
+		rc = read(fd, buf + len, buf_size - len - 1);
+		if (rc < 0) {
+			if (errno == EINTR)
+				continue;
+			xfree(buf);
+			return NULL;
+		}
+		if (rc == 0)
+			break;
+		len += rc;
+	}
+
+	buf[len] = '\0';
+	*fsize = len;
+	return buf;
+}
+
 static int _set_uint32_param(xcgroup_t *cg, char *param, uint32_t value)
 {
 	int fstatus = SLURM_ERROR;
@@ -173,7 +207,6 @@ extern int common_file_write_uint64s(char *file_path, uint64_t *values, int nb)
 extern int common_file_read_uint64s(char *file_path, uint64_t **pvalues,
 				    int *pnb)
 {
-	int rc;
 	int fd;
 
 	size_t fsize;
@@ -194,24 +227,15 @@ extern int common_file_read_uint64s(char *file_path, uint64_t **pvalues,
 		return SLURM_ERROR;
 	}
 
-	/* get file size */
-	fsize = common_file_getsize(fd);
-	if (fsize == -1) {
-		close(fd);
-		return SLURM_ERROR;
-	}
-
 	/* read file contents */
-	buf = xmalloc(fsize + 1);
-	do {
-		rc = read(fd, buf, fsize);
-	} while (rc < 0 && errno == EINTR);
+	buf = _file_read_all(fd, &fsize);
 	close(fd);
-	buf[fsize]='\0';
+	if (!buf)
+		return SLURM_ERROR;
 
 	/* count values (splitted by \n) */
 	i=0;
-	if (rc > 0) {
+	if (fsize > 0) {
 		p = buf;
 		while (xstrchr(p, '\n') != NULL) {
 			i++;
@@ -282,7 +306,6 @@ rwfail:
 extern int common_file_read_uint32s(char *file_path, uint32_t **pvalues,
 				    int *pnb)
 {
-	int rc;
 	int fd;
 
 	size_t fsize;
@@ -303,24 +326,15 @@ extern int common_file_read_uint32s(char *file_path, uint32_t **pvalues,
 		return SLURM_ERROR;
 	}
 
-	/* get file size */
-	fsize = common_file_getsize(fd);
-	if (fsize == -1) {
-		close(fd);
-		return SLURM_ERROR;
-	}
-
 	/* read file contents */
-	buf = xmalloc(fsize + 1);
-	do {
-		rc = read(fd, buf, fsize);
-	} while (rc < 0 && errno == EINTR);
+	buf = _file_read_all(fd, &fsize);
 	close(fd);
-	buf[fsize]='\0';
+	if (!buf)
+		return SLURM_ERROR;
 
 	/* count values (splitted by \n) */
 	i=0;
-	if (rc > 0) {
+	if (fsize > 0) {
 		p = buf;
 		while (xstrchr(p, '\n') != NULL) {
 			i++;
@@ -379,7 +393,6 @@ extern int common_file_read_content(char *file_path, char **content,
 				    size_t *csize)
 {
 	int fstatus;
-	int rc;
 	int fd;
 	size_t fsize;
 	char *buf;
@@ -397,27 +410,14 @@ extern int common_file_read_content(char *file_path, char **content,
 		return fstatus;
 	}
 
-	/* get file size */
-	fsize=common_file_getsize(fd);
-	if (fsize == -1) {
-		close(fd);
-		return fstatus;
-	}
-
 	/* read file contents */
-	buf = xmalloc(fsize + 1);
-	buf[fsize]='\0';
-	do {
-		rc = read(fd, buf, fsize);
-	} while (rc < 0 && errno == EINTR);
+	buf = _file_read_all(fd, &fsize);
 
 	/* set output values */
-	if (rc >= 0) {
+	if (buf) {
 		*content = buf;
-		*csize = rc;
+		*csize = fsize;
 		fstatus = SLURM_SUCCESS;
-	} else {
-		xfree(buf);
 	}
 
 	/* close file */
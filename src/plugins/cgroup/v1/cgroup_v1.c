@@ -990,7 +990,7 @@ static int _read_fd(int fd, uint64_t *buf)
 {
 	int rc = SLURM_ERROR;
 	size_t len = sizeof(uint64_t);
-	uint64_t *buf_ptr = buf;
+	char *buf_ptr = (char *) buf;
 	ssize_t nread;
 
 	while (len > 0 && (nread = read(fd, buf_ptr, len)) != 0) {
@@ -243,7 +243,17 @@ extern int cred_p_verify_sign(void *key, char *buffer, uint32_t buf_size,
 	int buf_out_size;
 	int rc = SLURM_SUCCESS;
 	munge_err_t err;
-	munge_ctx_t ctx = (munge_ctx_t) key;
+	munge_ctx_t ctx;
+
+	/*
+	 * Several slurmd threads may verify credentials at the same time
+	 * with the same key. A munge context is not safe to share between
+	 * threads, so decode with a private copy.
+	 */
+	if (!(ctx = munge_ctx_copy((munge_ctx_t) key))) {
+		error("%s: munge_ctx_copy failed", __func__);
+		return EMUNGE_NO_MEMORY;
+	}
 
 again:
 	err = munge_decode(signature, ctx, &buf_out, &buf_out_size,
@@ -287,5 +297,6 @@ again:
 end_it:
 	if (buf_out)
 		free(buf_out);
+	munge_ctx_destroy(ctx);
 	return rc;
 }
@@ -72,6 +72,17 @@
 #define GPU_HIGH	((unsigned int) -4)
 
 static bitstr_t	*saved_gpus = NULL;
+
+/*
+ * Device handles already looked up since _nvml_init(), indexed by GPU index.
+ * They are only valid until _nvml_shutdown().
+ */
+typedef struct {
+	nvmlDevice_t device;
+	bool valid;
+} nvml_handle_t;
+static nvml_handle_t *handle_cache = NULL;
+static int handle_cache_cnt = 0;
 /*
  * These variables are required by the generic plugin interface.  If they
  * are not found in the plugin, the plugin loader will ignore it.
@@ -192,6 +203,8 @@ static void _nvml_shutdown(void)
 	START_TIMER;
 	nvml_rc = nvmlShutdown();
 	END_TIMER;
+	xfree(handle_cache);
+	handle_cache_cnt = 0;
 	debug3("nvmlShutdown() took %ld microseconds", DELTA_TIMER);
 	if (nvml_rc != NVML_SUCCESS)
 		error("Failed to shut down NVML: %s", nvmlErrorString(nvml_rc));
@@ -306,7 +319,8 @@ static void _parse_gpu_freq(char *gpu_freq, unsigned int *gpu_freq_num,
 
 
 /*
- * Get the handle to the GPU for the passed index
+ * Get the handle to the GPU for the passed index. Handles are cached until
+ * _nvml_shutdown(), so each device is only looked up once.
  *
  * index 	(IN) The GPU index (corresponds to PCI Bus ID order)
  * device	(OUT) The device handle
@@ -316,12 +330,26 @@ static void _parse_gpu_freq(char *gpu_freq, unsigned int *gpu_freq_num,
 static bool _nvml_get_handle(int index, nvmlDevice_t *device)
 {
 	nvmlReturn_t nvml_rc;
+
+	if ((index < handle_cache_cnt) && handle_cache[index].valid) {
+		*device = handle_cache[index].device;
+		return true;
+	}
+
 	nvml_rc = nvmlDeviceGetHandleByIndex(index, device);
 	if (nvml_rc != NVML_SUCCESS) {
 		error("NVML: Failed to get device handle for GPU %d: %s", index,
 		      nvmlErrorString(nvml_rc));
 		return false;
 	}
+
+	if (index >= handle_cache_cnt) {
+		xrecalloc(handle_cache, index + 1, sizeof(nvml_handle_t));
+		handle_cache_cnt = index + 1;
+	}
+	handle_cache[index].device = *device;
+	handle_cache[index].valid = true;
+
 	return true;
 }
 
@@ -788,6 +816,7 @@ static void _reset_freq(bitstr_t *gpus)
 	int gpu_len = bit_size(gpus);
 	int i = -1, count = 0, count_set = 0;
 	bool freq_reset = false;
+	bool log_debug2 = (get_log_level() >= LOG_LEVEL_DEBUG2);
 
 	/*
 	 * Reset the frequency of each device allocated to the step
@@ -801,15 +830,20 @@ static void _reset_freq(bitstr_t *gpus)
 		if (!_nvml_get_handle(i, &device))
 			continue;
 
-		debug2("Memory frequency before reset: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency before reset: %u",
-		       _nvml_get_gfx_freq(device));
+		/* Each frequency query is an NVML call, only do it if logged */
+		if (log_debug2) {
+			debug2("Memory frequency before reset: %u",
+			       _nvml_get_mem_freq(device));
+			debug2("Graphics frequency before reset: %u",
+			       _nvml_get_gfx_freq(device));
+		}
 		freq_reset =_nvml_reset_freqs(device);
-		debug2("Memory frequency after reset: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency after reset: %u",
-		       _nvml_get_gfx_freq(device));
+		if (log_debug2) {
+			debug2("Memory frequency after reset: %u",
+			       _nvml_get_mem_freq(device));
+			debug2("Graphics frequency after reset: %u",
+			       _nvml_get_gfx_freq(device));
+		}
 
 		// TODO: Check to make sure that the frequency reset
 
@@ -851,6 +885,7 @@ static void _set_freq(bitstr_t *gpus, char *gpu_freq)
 	bool task_cgroup = false;
 	bool constrained_devices = false;
 	bool cgroups_active = false;
+	bool log_debug2 = (get_log_level() >= LOG_LEVEL_DEBUG2);
 
 	/*
 	 * Parse frequency information
@@ -913,15 +948,20 @@ static void _set_freq(bitstr_t *gpus, char *gpu_freq)
 		debug2("Setting frequency of NVML device %u", i);
 		_nvml_get_nearest_freqs(device, &mem_freq_num, &gpu_freq_num);
 
-		debug2("Memory frequency before set: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency before set: %u",
-		       _nvml_get_gfx_freq(device));
+		/* Each frequency query is an NVML call, only do it if logged */
+		if (log_debug2) {
+			debug2("Memory frequency before set: %u",
+			       _nvml_get_mem_freq(device));
+			debug2("Graphics frequency before set: %u",
+			       _nvml_get_gfx_freq(device));
+		}
 		freq_set = _nvml_set_freqs(device, mem_freq_num, gpu_freq_num);
-		debug2("Memory frequency after set: %u",
-		       _nvml_get_mem_freq(device));
-		debug2("Graphics frequency after set: %u",
-		       _nvml_get_gfx_freq(device));
+		if (log_debug2) {
+			debug2("Memory frequency after set: %u",
+			       _nvml_get_mem_freq(device));
+			debug2("Graphics frequency after set: %u",
+			       _nvml_get_gfx_freq(device));
+		}
 
 		if (mem_freq_num) {
 			xstrfmtcat(tmp, "%smemory_freq:%u", sep, mem_freq_num);
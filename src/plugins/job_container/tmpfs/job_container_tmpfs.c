@@ -50,16 +50,32 @@
 #include <ftw.h>
 #include <sys/mount.h>
 #include <linux/limits.h>
+#include <pthread.h>
 #include <semaphore.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #include "src/common/slurm_xlator.h"
 #include "src/common/log.h"
+#include "src/common/macros.h"
 #include "src/common/run_command.h"
+#include "src/common/xstring.h"
 
 #include "read_jcconf.h"
 
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+
+/* Seconds to wait before preparing pool namespaces again after a failure */
+#define POOL_RETRY_SECS 60
+
 static int _create_ns(uint32_t job_id, uid_t uid, bool remount);
 static int _delete_ns(uint32_t job_id);
+static int _rm_data(const char *path, const struct stat *st_buf,
+		    int type, struct FTW *ftwbuf);
+static void *_pool_thread(void *no_data);
 
 #if defined (__APPLE__)
 extern slurmd_conf_t *conf __attribute__((weak_import));
@@ -76,6 +92,18 @@ static int step_ns_fd = -1;
 static bool force_rm = true;
 static List running_job_ids = NULL;
 
+/*
+ * Namespaces prepared ahead of jobs (PoolSize) and directories of finished
+ * namespaces waiting to be removed, both handled by pool_thread in slurmd.
+ */
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t pool_thread = 0;
+static bool pool_shutdown = false;
+static uint32_t pool_seq = 0;
+static List pool_list = NULL;	/* paths of prepared namespaces */
+static List reap_list = NULL;	/* paths of directories to remove */
+
 static int _create_paths(uint32_t job_id,
 			 char *job_mount,
 			 char *ns_holder,
@@ -146,11 +174,41 @@ static int _append_job_in_list(void *element, void *arg)
 	return SLURM_SUCCESS;
 }
 
+/* Remove a pool or reaper directory left over by a previous slurmd */
+static int _remove_leftover(const char *d_name)
+{
+	char path[PATH_MAX];
+	char ns_holder[PATH_MAX];
+
+	if ((snprintf(path, PATH_MAX, "%s/%s", jc_conf->basepath, d_name)
+	     >= PATH_MAX) ||
+	    (snprintf(ns_holder, PATH_MAX, "%s/.ns", path) >= PATH_MAX)) {
+		error("%s: Unable to build %s path", __func__, d_name);
+		return SLURM_ERROR;
+	}
+
+	debug3("removing leftover namespace directory %s", path);
+	if (umount2(ns_holder, MNT_DETACH))
+		debug3("umount2 %s failed: %m", ns_holder);
+
+	force_rm = false;
+	if (nftw(path, _rm_data, 64, FTW_DEPTH|FTW_PHYS) < 0) {
+		error("%s: Directory traversal failed: %s: %s",
+		      __func__, path, strerror(errno));
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 static int _restore_ns(const char *d_name)
 {
 	int rc = SLURM_SUCCESS;
 	uint32_t job_id;
 
+	if (!xstrncmp(d_name, ".pool.", 6) || !xstrncmp(d_name, ".reap.", 6))
+		return _remove_leftover(d_name);
+
 	if (!(job_id = slurm_atoul(d_name))) {
 		debug3("ignoring %s, could not convert to jobid.", d_name);
 		return SLURM_SUCCESS;
@@ -210,6 +268,17 @@ extern int fini(void)
 		error("%s: Configuration not loaded", __func__);
 		return SLURM_ERROR;
 	}
+	if (pool_thread) {
+		slurm_mutex_lock(&pool_mutex);
+		pool_shutdown = true;
+		slurm_cond_broadcast(&pool_cond);
+		slurm_mutex_unlock(&pool_mutex);
+		pthread_join(pool_thread, NULL);
+		pool_thread = 0;
+		/* Anything left is removed when slurmd starts again */
+		FREE_NULL_LIST(pool_list);
+		FREE_NULL_LIST(reap_list);
+	}
 	if (step_ns_fd != -1) {
 		close(step_ns_fd);
 		step_ns_fd = -1;
@@ -340,6 +409,13 @@ extern int container_p_restore(char *dir_name, bool recover)
 	if (rc)
 		error("Encountered an error while restoring job containers.");
 
+	/* Prepare namespaces ahead of jobs and remove finished ones */
+	if (!pool_thread) {
+		pool_list = list_create(xfree_ptr);
+		reap_list = list_create(xfree_ptr);
+		slurm_thread_create(&pool_thread, _pool_thread, NULL);
+	}
+
 	return rc;
 }
 
@@ -415,11 +491,13 @@ static int _rm_data(const char *path, const struct stat *st_buf,
 	return rc;
 }
 
-static int _create_ns(uint32_t job_id, uid_t uid, bool remount)
+/*
+ * Construct the namespace held by ns_holder in job_mount, with src_bind
+ * mounted as its /tmp. A uid of -1 leaves the owner of src_bind unchanged.
+ */
+static int _build_ns(uint32_t job_id, char *job_mount, char *ns_holder,
+		     char *src_bind, uid_t uid, bool remount)
 {
-	char job_mount[PATH_MAX];
-	char ns_holder[PATH_MAX];
-	char src_bind[PATH_MAX];
 	char *result = NULL;
 	int fd;
 	int rc = 0;
@@ -427,15 +505,6 @@ static int _create_ns(uint32_t job_id, uid_t uid, bool remount)
 	sem_t *sem2 = NULL;
 	pid_t cpid;
 
-#ifdef HAVE_NATIVE_CRAY
-	return 0;
-#endif
-
-	if (_create_paths(job_id, job_mount, ns_holder, src_bind)
-	    != SLURM_SUCCESS) {
-		return -1;
-	}
-
 	rc = mkdir(job_mount, 0700);
 	if (rc && errno != EEXIST) {
 		error("%s: mkdir %s failed: %s",
@@ -657,8 +726,236 @@ exit2:
 	return rc;
 }
 
+static int _create_ns(uint32_t job_id, uid_t uid, bool remount)
+{
+	char job_mount[PATH_MAX];
+	char ns_holder[PATH_MAX];
+	char src_bind[PATH_MAX];
+
+#ifdef HAVE_NATIVE_CRAY
+	return 0;
+#endif
+
+	if (_create_paths(job_id, job_mount, ns_holder, src_bind)
+	    != SLURM_SUCCESS) {
+		return -1;
+	}
+
+	return _build_ns(job_id, job_mount, ns_holder, src_bind, uid, remount);
+}
+
+static int _rename_noreplace(const char *old_path, const char *new_path)
+{
+#ifdef SYS_renameat2
+	return syscall(SYS_renameat2, AT_FDCWD, old_path, AT_FDCWD, new_path,
+		       RENAME_NOREPLACE);
+#else
+	errno = ENOSYS;
+	return -1;
+#endif
+}
+
+/*
+ * Move a namespace directory aside and queue it for pool_thread to remove.
+ * RET true if queued, false if the caller needs to remove it.
+ */
+static bool _queue_reap(const char *path)
+{
+	char reap_path[PATH_MAX];
+	bool queued = false;
+
+	slurm_mutex_lock(&pool_mutex);
+	if (!reap_list || pool_shutdown)
+		goto fini;
+
+	if (snprintf(reap_path, PATH_MAX, "%s/.reap.%u", jc_conf->basepath,
+		     ++pool_seq) >= PATH_MAX) {
+		error("%s: Unable to build reap path for %s", __func__, path);
+		goto fini;
+	}
+	if (rename(path, reap_path)) {
+		error("%s: rename %s to %s failed: %m",
+		      __func__, path, reap_path);
+		goto fini;
+	}
+	list_append(reap_list, xstrdup(reap_path));
+	slurm_cond_signal(&pool_cond);
+	queued = true;
+
+fini:
+	slurm_mutex_unlock(&pool_mutex);
+	return queued;
+}
+
+/* Unmount and remove a prepared namespace that will not be used */
+static void _discard_pool_ns(char *pool_mount)
+{
+	char ns_holder[PATH_MAX];
+
+	if ((snprintf(ns_holder, PATH_MAX, "%s/.ns", pool_mount)
+	     < PATH_MAX) &&
+	    umount2(ns_holder, MNT_DETACH))
+		error("%s: umount2 %s failed: %m", __func__, ns_holder);
+
+	if (!_queue_reap(pool_mount)) {
+		force_rm = false;
+		if (nftw(pool_mount, _rm_data, 64, FTW_DEPTH|FTW_PHYS) < 0)
+			error("%s: Directory traversal failed: %s: %s",
+			      __func__, pool_mount, strerror(errno));
+	}
+	xfree(pool_mount);
+}
+
+/* Prepare a namespace for the pool, RET its path or NULL on failure */
+static char *_create_pool_ns(void)
+{
+	char pool_mount[PATH_MAX];
+	char ns_holder[PATH_MAX];
+	char src_bind[PATH_MAX];
+
+	do {
+		slurm_mutex_lock(&pool_mutex);
+		if (snprintf(pool_mount, PATH_MAX, "%s/.pool.%u",
+			     jc_conf->basepath, ++pool_seq) >= PATH_MAX) {
+			slurm_mutex_unlock(&pool_mutex);
+			error("%s: Unable to build pool mount path", __func__);
+			return NULL;
+		}
+		slurm_mutex_unlock(&pool_mutex);
+	} while (!access(pool_mount, F_OK));
+
+	if ((snprintf(ns_holder, PATH_MAX, "%s/.ns", pool_mount)
+	     >= PATH_MAX) ||
+	    (snprintf(src_bind, PATH_MAX, "%s/.src", pool_mount)
+	     >= PATH_MAX)) {
+		error("%s: Unable to build %s paths", __func__, pool_mount);
+		return NULL;
+	}
+
+	/* The owner of /tmp is set when a job claims the namespace */
+	if (_build_ns(0, pool_mount, ns_holder, src_bind, (uid_t) -1, false))
+		return NULL;
+
+	debug3("prepared namespace %s", pool_mount);
+	return xstrdup(pool_mount);
+}
+
+/*
+ * Hand a prepared namespace from the pool to job_id.
+ * RET SLURM_SUCCESS if the job's namespace exists afterwards
+ */
+static int _claim_pool_ns(uint32_t job_id, uid_t uid)
+{
+	char job_mount[PATH_MAX];
+	char src_bind[PATH_MAX];
+	char pool_src[PATH_MAX];
+	char *pool_mount = NULL;
+
+	slurm_mutex_lock(&pool_mutex);
+	if (pool_list && (pool_mount = list_pop(pool_list)))
+		slurm_cond_signal(&pool_cond);
+	slurm_mutex_unlock(&pool_mutex);
+	if (!pool_mount)
+		return SLURM_ERROR;
+
+	if ((_create_paths(job_id, job_mount, NULL, src_bind)
+	     != SLURM_SUCCESS) ||
+	    (snprintf(pool_src, PATH_MAX, "%s/.src", job_mount)
+	     >= PATH_MAX)) {
+		_discard_pool_ns(pool_mount);
+		return SLURM_ERROR;
+	}
+
+	if (_rename_noreplace(pool_mount, job_mount)) {
+		if (errno == EEXIST) {
+			/*
+			 * This is coming from sbcast likely, keep the
+			 * prepared namespace for the next job
+			 */
+			slurm_mutex_lock(&pool_mutex);
+			list_push(pool_list, pool_mount);
+			slurm_mutex_unlock(&pool_mutex);
+			return SLURM_SUCCESS;
+		}
+		error("%s: rename %s to %s failed: %m",
+		      __func__, pool_mount, job_mount);
+		if ((errno == ENOSYS) || (errno == EINVAL)) {
+			error("%s: disabling PoolSize", __func__);
+			slurm_mutex_lock(&pool_mutex);
+			jc_conf->pool_size = 0;
+			slurm_mutex_unlock(&pool_mutex);
+		}
+		_discard_pool_ns(pool_mount);
+		return SLURM_ERROR;
+	}
+	xfree(pool_mount);
+
+	if (rename(pool_src, src_bind)) {
+		error("%s: rename %s to %s failed: %m",
+		      __func__, pool_src, src_bind);
+		_delete_ns(job_id);
+		return SLURM_ERROR;
+	}
+	if (chown(src_bind, uid, -1)) {
+		error("%s: chown failed for %s: %s",
+		      __func__, src_bind, strerror(errno));
+		_delete_ns(job_id);
+		return SLURM_ERROR;
+	}
+
+	debug3("job %u uses a prepared namespace", job_id);
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Remove the directories of finished namespaces, then keep PoolSize
+ * namespaces prepared for the next jobs.
+ */
+static void *_pool_thread(void *no_data)
+{
+	struct timespec retry = { 0, 0 };
+	char *path;
+
+	slurm_mutex_lock(&pool_mutex);
+	while (!pool_shutdown) {
+		if ((path = list_pop(reap_list))) {
+			slurm_mutex_unlock(&pool_mutex);
+			force_rm = false;
+			if (nftw(path, _rm_data, 64, FTW_DEPTH|FTW_PHYS) < 0)
+				error("%s: Directory traversal failed: %s: %s",
+				      __func__, path, strerror(errno));
+			xfree(path);
+			slurm_mutex_lock(&pool_mutex);
+			continue;
+		}
+
+		if ((list_count(pool_list) < jc_conf->pool_size) &&
+		    (time(NULL) >= retry.tv_sec)) {
+			slurm_mutex_unlock(&pool_mutex);
+			path = _create_pool_ns();
+			slurm_mutex_lock(&pool_mutex);
+			if (path)
+				list_append(pool_list, path);
+			else
+				retry.tv_sec = time(NULL) + POOL_RETRY_SECS;
+			continue;
+		}
+
+		if (retry.tv_sec > time(NULL))
+			slurm_cond_timedwait(&pool_cond, &pool_mutex, &retry);
+		else
+			slurm_cond_wait(&pool_cond, &pool_mutex);
+	}
+	slurm_mutex_unlock(&pool_mutex);
+
+	return NULL;
+}
+
 extern int container_p_create(uint32_t job_id, uid_t uid)
 {
+	if (_claim_pool_ns(job_id, uid) == SLURM_SUCCESS)
+		return SLURM_SUCCESS;
+
 	return _create_ns(job_id, uid, false);
 }
 
@@ -767,7 +1064,12 @@ static int _delete_ns(uint32_t job_id)
 	 *	a post order traversal and delete directory after processing
 	 *      contents
 	 * NOTE: Can happen EBUSY here so we need to ignore this.
+	 * Leave this to pool_thread if it runs, so the job end is not
+	 * delayed by removing the job's files.
 	 */
+	if (_queue_reap(job_mount))
+		return SLURM_SUCCESS;
+
 	force_rm = false;
 	if (nftw(job_mount, _rm_data, 64, FTW_DEPTH|FTW_PHYS) < 0) {
 		error("%s: Directory traversal failed: %s: %s",
@@ -60,6 +60,7 @@ static s_p_hashtbl_t *_create_ns_hashtbl(void)
 		{"AutoBasePath", S_P_BOOLEAN},
 		{"BasePath", S_P_STRING},
 		{"InitScript", S_P_STRING},
+		{"PoolSize", S_P_UINT32},
 		{NULL}
 	};
 
@@ -97,6 +98,8 @@ static int _parse_jc_conf_internal(void **dest, slurm_parser_enum_t type,
 	if (!s_p_get_string(&slurm_jc_conf.initscript, "InitScript", tbl))
 		debug3("empty init script detected");
 
+	s_p_get_uint32(&slurm_jc_conf.pool_size, "PoolSize", tbl);
+
 end_it:
 	s_p_hashtbl_destroy(tbl);
 
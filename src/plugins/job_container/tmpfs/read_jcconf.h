@@ -48,6 +48,7 @@ typedef struct slurm_jc_conf {
 	bool auto_basepath;
 	char *basepath;
 	char *initscript;
+	uint32_t pool_size;	/* namespaces prepared ahead of jobs */
 } slurm_jc_conf_t;
 
 extern char *tmpfs_conf_file;
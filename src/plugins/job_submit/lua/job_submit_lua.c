@@ -100,6 +100,7 @@ static lua_State *L = NULL;
 static char *user_msg = NULL;
 time_t last_lua_jobs_update = (time_t) 0;
 time_t last_lua_resv_update = (time_t) 0;
+static time_t last_lua_part_update = (time_t) 0;
 static const char *req_fxns[] = {
 	"slurm_job_submit",
 	"slurm_job_modify",
@@ -190,7 +191,27 @@ static int _job_rec_field_index(lua_State *L)
 	return slurm_lua_job_record_field(L, job_ptr, name);
 }
 
-/* Get the list of existing slurmctld job records. */
+/* Return the job_record behind a slurm.jobs entry at index, or NULL */
+static job_record_t *_job_rec_entry_ptr(lua_State *st, int index)
+{
+	job_record_t *job_ptr = NULL;
+
+	if (lua_getmetatable(st, index)) {
+		lua_getfield(st, -1, "_job_rec_ptr");
+		job_ptr = lua_touserdata(st, -1);
+		lua_pop(st, 2);
+	}
+
+	return job_ptr;
+}
+
+/*
+ * Get the list of existing slurmctld job records.
+ *
+ * last_job_update changes with every job update, including each submission,
+ * so rather than building a new table for all the jobs every time, only
+ * drop the entries of the jobs which are gone and add the new ones.
+ */
 static void _update_jobs_global(lua_State *st)
 {
 	char job_id_buf[11]; /* Big enough for a uint32_t */
@@ -202,10 +223,49 @@ static void _update_jobs_global(lua_State *st)
 	}
 
 	lua_getglobal(st, "slurm");
-	lua_newtable(st);
+	lua_getfield(st, -1, "jobs");
+	if (!lua_istable(st, -1)) {
+		lua_pop(st, 1);
+		lua_newtable(st);
+		lua_pushvalue(st, -1);
+		lua_setfield(st, -3, "jobs");
+	}
+
+	/* Remove the jobs which no longer exist. */
+	lua_pushnil(st);
+	while (lua_next(st, -2)) {
+		bool found = false;
+
+		if (lua_type(st, -2) == LUA_TSTRING) {
+			uint32_t job_id = strtoul(lua_tostring(st, -2), NULL,
+						  10);
+			job_ptr = _job_rec_entry_ptr(st, -1);
+			if (job_ptr && (find_job_record(job_id) == job_ptr))
+				found = true;
+		}
+		lua_pop(st, 1);
+		if (!found) {
+			/* Clearing fields during the traversal is allowed */
+			lua_pushvalue(st, -1);
+			lua_pushnil(st);
+			lua_rawset(st, -4);
+		}
+	}
 
 	iter = list_iterator_create(job_list);
 	while ((job_ptr = list_next(iter))) {
+		/* Lua copies passed strings, so we can reuse the buffer. */
+		snprintf(job_id_buf, sizeof(job_id_buf),
+		         "%d", job_ptr->job_id);
+
+		lua_getfield(st, -1, job_id_buf);
+		if (!lua_isnil(st, -1)) {
+			/* Already there and checked above */
+			lua_pop(st, 1);
+			continue;
+		}
+		lua_pop(st, 1);
+
 		/* Create an empty table, with a metatable that looks up the
 		 * data for the individual job.
 		 */
@@ -221,16 +281,12 @@ static void _update_jobs_global(lua_State *st)
 		lua_setfield(st, -2, "_job_rec_ptr");
 		lua_setmetatable(st, -2);
 
-		/* Lua copies passed strings, so we can reuse the buffer. */
-		snprintf(job_id_buf, sizeof(job_id_buf),
-		         "%d", job_ptr->job_id);
 		lua_setfield(st, -2, job_id_buf);
 	}
 	last_lua_jobs_update = last_job_update;
 	list_iterator_destroy(iter);
 
-	lua_setfield(st, -2, "jobs");
-	lua_pop(st, 1);
+	lua_pop(st, 2);
 }
 
 static int _resv_field(const slurmctld_resv_t *resv_ptr,
@@ -1149,35 +1205,83 @@ static bool _user_can_use_part(uint32_t user_id, uint32_t submit_uid,
 	return false;
 }
 
+/* Add the record of part_ptr to the partition cache at the top of the stack */
+static void _add_part_rec(part_record_t *part_ptr)
+{
+	lua_pushlightuserdata(L, part_ptr);
+
+	/* Create an empty table, with a metatable that looks up the
+	 * data for the partition.
+	 */
+	lua_newtable(L);
+
+	lua_newtable(L);
+	lua_pushcfunction(L, _part_rec_field_index);
+	lua_setfield(L, -2, "__index");
+	/* Store the part_record in the metatable, so the index
+	 * function knows which job it's getting data for.
+	 */
+	lua_pushlightuserdata(L, part_ptr);
+	lua_setfield(L, -2, "_part_rec_ptr");
+	lua_setmetatable(L, -2);
+
+	lua_rawset(L, -3);
+}
+
+/*
+ * Push the table of partition records, indexed by part_record_t pointer.
+ * It is kept in the registry and only rebuilt when the partitions change,
+ * so the records don't have to be created again on each submission.
+ */
+static void _push_part_cache(void)
+{
+	ListIterator part_iterator;
+	part_record_t *part_ptr;
+
+	lua_getfield(L, LUA_REGISTRYINDEX, "_part_rec_cache");
+	if (lua_istable(L, -1) && (last_lua_part_update >= last_part_update))
+		return;
+	lua_pop(L, 1);
+
+	lua_newtable(L);
+	part_iterator = list_iterator_create(part_list);
+	while ((part_ptr = list_next(part_iterator)))
+		_add_part_rec(part_ptr);
+	list_iterator_destroy(part_iterator);
+
+	lua_pushvalue(L, -1);
+	lua_setfield(L, LUA_REGISTRYINDEX, "_part_rec_cache");
+	last_lua_part_update = last_part_update;
+}
+
 static void _push_partition_list(uint32_t user_id, uint32_t submit_uid)
 {
 	ListIterator part_iterator;
 	part_record_t *part_ptr;
 
+	_push_part_cache();
 	lua_newtable(L);
 	part_iterator = list_iterator_create(part_list);
 	while ((part_ptr = list_next(part_iterator))) {
 		if (!_user_can_use_part(user_id, submit_uid, part_ptr))
 			continue;
 
-		/* Create an empty table, with a metatable that looks up the
-		 * data for the partition.
-		 */
-		lua_newtable(L);
-
-		lua_newtable(L);
-		lua_pushcfunction(L, _part_rec_field_index);
-		lua_setfield(L, -2, "__index");
-		/* Store the part_record in the metatable, so the index
-		 * function knows which job it's getting data for.
-		 */
 		lua_pushlightuserdata(L, part_ptr);
-		lua_setfield(L, -2, "_part_rec_ptr");
-		lua_setmetatable(L, -2);
-
+		lua_rawget(L, -3);
+		if (lua_isnil(L, -1)) {
+			/* Added within the second the cache was built */
+			lua_pop(L, 1);
+			lua_pushvalue(L, -2);
+			_add_part_rec(part_ptr);
+			lua_pushlightuserdata(L, part_ptr);
+			lua_rawget(L, -2);
+			lua_remove(L, -2);
+		}
 		lua_setfield(L, -2, part_ptr->name);
 	}
 	list_iterator_destroy(part_iterator);
+	/* Leave only the list on the stack */
+	lua_remove(L, -2);
 }
 
 
@@ -1229,6 +1333,7 @@ static void _register_local_output_functions(lua_State *L)
 	_update_jobs_global(L);
 	last_lua_resv_update = 0;
 	_update_resvs_global(L);
+	last_lua_part_update = 0;
 }
 
 static void _register_lua_slurm_struct_functions(lua_State *st)
@@ -179,7 +179,7 @@ extern int fini (void)
  * Assumption:
  *    Any file with a name of the form "/proc/[0-9]+/stat"
  *    is a Linux-style stat entry. We disregard the data if they look
- *    wrong.
+ *    wrong. Only the task leaders' entries are read.
  */
 extern void jobacct_gather_p_poll_data(List task_list, bool pgid_plugin,
 				       uint64_t cont_id, bool profile)
@@ -191,6 +191,12 @@ extern void jobacct_gather_p_poll_data(List task_list, bool pgid_plugin,
 		memset(&callbacks, 0, sizeof(jag_callbacks_t));
 		first = 0;
 		callbacks.prec_extra = _prec_extra;
+		/*
+		 * CPU and memory totals of each task come from its cgroup and
+		 * no offspring data is gathered, so only the task leaders
+		 * need to be read from /proc.
+		 */
+		callbacks.get_precs = jag_common_get_task_precs;
 	}
 
 	jag_common_poll_data(task_list, pgid_plugin, cont_id, &callbacks,
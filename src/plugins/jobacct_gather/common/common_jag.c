@@ -40,10 +40,19 @@
 
 #include <dirent.h>
 #include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
 #include <signal.h>
+#include <sys/socket.h>
 #include <time.h>
 #include <ctype.h>
 
+#if defined(__linux__)
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#endif
+
 #include "src/common/slurm_xlator.h"
 #include "src/common/assoc_mgr.h"
 #include "src/common/slurm_jobacct_gather.h"
@@ -52,6 +61,7 @@
 #include "src/common/slurm_acct_gather_energy.h"
 #include "src/common/slurm_acct_gather_filesystem.h"
 #include "src/common/slurm_acct_gather_interconnect.h"
+#include "src/common/xhash.h"
 #include "src/common/xstring.h"
 #include "src/slurmd/common/proctrack.h"
 
@@ -78,6 +88,20 @@ static int my_pagesize = 0;
 static DIR  *slash_proc = NULL;
 static int energy_profile = ENERGY_DATA_NODE_ENERGY_UP;
 
+/*
+ * JobAcctGatherParams=UseProcConnector: processes of the step are tracked
+ * from kernel proc connector fork/exit events instead of being rediscovered
+ * on every poll.
+ */
+static bool use_proc_conn = false;
+static int proc_conn_fd = -1;
+static pthread_t proc_conn_tid = 0;
+static bool proc_conn_stop = false;
+static pthread_mutex_t proc_conn_mutex = PTHREAD_MUTEX_INITIALIZER;
+static xhash_t *proc_conn_pids = NULL;	/* tgids of step processes */
+static bool proc_conn_valid = false;	/* false if events may be lost */
+static pid_t proc_conn_root = 0;	/* slurmstepd, parent of the tasks */
+
 static int _find_prec(void *x, void *key)
 {
 	jag_prec_t *prec = (jag_prec_t *) x;
@@ -598,6 +622,255 @@ bail_out:
 	return;
 }
 
+static void _proc_conn_pid_id(void *item, const char **key, uint32_t *key_len)
+{
+	*key = item;
+	*key_len = sizeof(pid_t);
+}
+
+/* Add a pid to the tracked set, must hold proc_conn_mutex */
+static void _proc_conn_add(pid_t pid)
+{
+	pid_t *pid_ptr;
+
+	if (xhash_get(proc_conn_pids, (char *) &pid, sizeof(pid)))
+		return;
+	pid_ptr = xmalloc(sizeof(pid_t));
+	*pid_ptr = pid;
+	xhash_add(proc_conn_pids, pid_ptr);
+}
+
+#if defined(__linux__)
+static void _proc_conn_event(struct proc_event *ev)
+{
+	pid_t parent, child;
+
+	switch (ev->what) {
+	case PROC_EVENT_FORK:
+		/* Threads share their parent's record */
+		if (ev->event_data.fork.child_pid !=
+		    ev->event_data.fork.child_tgid)
+			break;
+		parent = ev->event_data.fork.parent_tgid;
+		child = ev->event_data.fork.child_tgid;
+		slurm_mutex_lock(&proc_conn_mutex);
+		if ((parent == proc_conn_root) ||
+		    xhash_get(proc_conn_pids, (char *) &parent,
+			      sizeof(parent)))
+			_proc_conn_add(child);
+		slurm_mutex_unlock(&proc_conn_mutex);
+		break;
+	case PROC_EVENT_EXIT:
+		if (ev->event_data.exit.process_pid !=
+		    ev->event_data.exit.process_tgid)
+			break;
+		child = ev->event_data.exit.process_tgid;
+		slurm_mutex_lock(&proc_conn_mutex);
+		xhash_delete(proc_conn_pids, (char *) &child, sizeof(child));
+		slurm_mutex_unlock(&proc_conn_mutex);
+		break;
+	default:
+		break;
+	}
+}
+
+static void *_proc_conn_thread(void *arg)
+{
+	char buf[8192] __attribute__((aligned(NLMSG_ALIGNTO)));
+	struct pollfd pfd = { .fd = proc_conn_fd, .events = POLLIN };
+	struct nlmsghdr *nlh;
+	struct cn_msg *cn;
+	ssize_t len;
+
+	while (!proc_conn_stop) {
+		if (poll(&pfd, 1, 1000) <= 0)
+			continue;
+
+		len = recv(proc_conn_fd, buf, sizeof(buf), 0);
+		if (len < 0) {
+			if (errno == ENOBUFS) {
+				/* Events were dropped, rebuild on next poll */
+				log_flag(JAG, "proc connector overrun");
+				slurm_mutex_lock(&proc_conn_mutex);
+				proc_conn_valid = false;
+				slurm_mutex_unlock(&proc_conn_mutex);
+			} else if ((errno != EINTR) && (errno != EAGAIN)) {
+				error("%s: recv: %m", __func__);
+				break;
+			}
+			continue;
+		}
+
+		for (nlh = (struct nlmsghdr *) buf; NLMSG_OK(nlh, len);
+		     nlh = NLMSG_NEXT(nlh, len)) {
+			if ((nlh->nlmsg_type == NLMSG_ERROR) ||
+			    (nlh->nlmsg_type == NLMSG_NOOP))
+				continue;
+			cn = NLMSG_DATA(nlh);
+			if ((cn->id.idx != CN_IDX_PROC) ||
+			    (cn->id.val != CN_VAL_PROC))
+				continue;
+			_proc_conn_event((struct proc_event *) cn->data);
+		}
+	}
+
+	return NULL;
+}
+
+static int _proc_conn_subscribe(enum proc_cn_mcast_op op)
+{
+	char buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(op))]
+		__attribute__((aligned(NLMSG_ALIGNTO)));
+	struct nlmsghdr *nlh = (struct nlmsghdr *) buf;
+	struct cn_msg *cn;
+
+	memset(buf, 0, sizeof(buf));
+	nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+	nlh->nlmsg_type = NLMSG_DONE;
+	nlh->nlmsg_pid = 0;
+	cn = NLMSG_DATA(nlh);
+	cn->id.idx = CN_IDX_PROC;
+	cn->id.val = CN_VAL_PROC;
+	cn->len = sizeof(op);
+	memcpy(cn->data, &op, sizeof(op));
+
+	if (send(proc_conn_fd, nlh, nlh->nlmsg_len, 0) < 0) {
+		error("%s: send: %m", __func__);
+		return SLURM_ERROR;
+	}
+	return SLURM_SUCCESS;
+}
+
+/* Subscribe to proc connector events, fall back to polling on failure */
+static void _proc_conn_start(void)
+{
+	struct sockaddr_nl addr = {
+		.nl_family = AF_NETLINK,
+		.nl_groups = CN_IDX_PROC,
+	};
+
+	proc_conn_fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC,
+			      NETLINK_CONNECTOR);
+	if (proc_conn_fd < 0) {
+		error("%s: socket: %m", __func__);
+		goto fail;
+	}
+	if (bind(proc_conn_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0) {
+		error("%s: bind: %m", __func__);
+		goto fail;
+	}
+
+	proc_conn_pids = xhash_init(_proc_conn_pid_id, xfree_ptr);
+	proc_conn_root = getpid();
+	proc_conn_stop = false;
+
+	if (_proc_conn_subscribe(PROC_CN_MCAST_LISTEN))
+		goto fail;
+
+	slurm_thread_create(&proc_conn_tid, _proc_conn_thread, NULL);
+	log_flag(JAG, "tracking step processes with the proc connector");
+	return;
+
+fail:
+	error("%s: proc connector unavailable, polling process list",
+	      __func__);
+	if (proc_conn_fd >= 0)
+		close(proc_conn_fd);
+	proc_conn_fd = -1;
+	xhash_free(proc_conn_pids);
+	use_proc_conn = false;
+}
+
+static void _proc_conn_fini(void)
+{
+	if (proc_conn_fd < 0)
+		return;
+
+	proc_conn_stop = true;
+	if (proc_conn_tid)
+		pthread_join(proc_conn_tid, NULL);
+	proc_conn_tid = 0;
+	(void) _proc_conn_subscribe(PROC_CN_MCAST_IGNORE);
+	close(proc_conn_fd);
+	proc_conn_fd = -1;
+	xhash_free(proc_conn_pids);
+}
+#else
+static void _proc_conn_start(void)
+{
+	error("%s: proc connector not supported on this system", __func__);
+	use_proc_conn = false;
+}
+
+static void _proc_conn_fini(void)
+{
+	return;
+}
+#endif
+
+static void _proc_conn_collect(void *item, void *arg)
+{
+	pid_t **pids_pptr = arg;
+
+	*(*pids_pptr)++ = *(pid_t *) item;
+}
+
+/*
+ * Get the pids of the step from the tracked set. If events were lost, the
+ * set is rebuilt from the proctrack container (or just the task leaders
+ * with the pgid plugin). The task leaders are always added, as a task may
+ * have been forked before it was added to the step.
+ */
+static void _proc_conn_get_pids(List task_list, bool pgid_plugin,
+				uint64_t cont_id, pid_t **pids, int *npids)
+{
+	struct jobacctinfo *jobacct;
+	ListIterator itr;
+	pid_t *pid_ptr;
+
+	slurm_mutex_lock(&proc_conn_mutex);
+	if (!proc_conn_valid) {
+		xhash_clear(proc_conn_pids);
+		if (!pgid_plugin) {
+			pid_t *cont_pids = NULL;
+			int cont_npids = 0;
+
+			proctrack_g_get_pids(cont_id, &cont_pids, &cont_npids);
+			for (int i = 0; i < cont_npids; i++)
+				_proc_conn_add(cont_pids[i]);
+			xfree(cont_pids);
+		}
+		proc_conn_valid = true;
+	}
+
+	itr = list_iterator_create(task_list);
+	while ((jobacct = list_next(itr)))
+		_proc_conn_add(jobacct->pid);
+	list_iterator_destroy(itr);
+
+	if ((*npids = xhash_count(proc_conn_pids))) {
+		pid_ptr = *pids = xcalloc(*npids, sizeof(pid_t));
+		xhash_walk(proc_conn_pids, _proc_conn_collect, &pid_ptr);
+	}
+	slurm_mutex_unlock(&proc_conn_mutex);
+}
+
+/* Update the consumed energy of a task with no processes to poll */
+static void _update_energy(struct jobacctinfo *jobacct)
+{
+	if (!jobacct)
+		return;
+
+	acct_gather_energy_g_get_sum(energy_profile, &jobacct->energy);
+	jobacct->tres_usage_in_tot[TRES_ARRAY_ENERGY] =
+		jobacct->energy.consumed_energy;
+	jobacct->tres_usage_out_tot[TRES_ARRAY_ENERGY] =
+		jobacct->energy.current_watts;
+	log_flag(JAG, "energy = %"PRIu64" watts = %"PRIu64,
+		 jobacct->tres_usage_in_tot[TRES_ARRAY_ENERGY],
+		 jobacct->tres_usage_out_tot[TRES_ARRAY_ENERGY]);
+}
+
 static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 		       jag_callbacks_t *callbacks)
 {
@@ -612,27 +885,18 @@ static List _get_precs(List task_list, bool pgid_plugin, uint64_t cont_id,
 
 	jobacct = list_peek(task_list);
 
-	if (!pgid_plugin) {
+	if (!pgid_plugin || use_proc_conn) {
 		pid_t *pids = NULL;
 		int npids = 0;
 		/* get only the processes in the proctrack container */
-		proctrack_g_get_pids(cont_id, &pids, &npids);
+		if (use_proc_conn)
+			_proc_conn_get_pids(task_list, pgid_plugin, cont_id,
+					    &pids, &npids);
+		else
+			proctrack_g_get_pids(cont_id, &pids, &npids);
 		if (!npids) {
 			/* update consumed energy even if pids do not exist */
-			if (jobacct) {
-				acct_gather_energy_g_get_sum(
-					energy_profile,
-					&jobacct->energy);
-				jobacct->tres_usage_in_tot[TRES_ARRAY_ENERGY] =
-					jobacct->energy.consumed_energy;
-				jobacct->tres_usage_out_tot[TRES_ARRAY_ENERGY] =
-					jobacct->energy.current_watts;
-				log_flag(JAG, "energy = %"PRIu64" watts = %"PRIu64,
-					 jobacct->tres_usage_in_tot[
-						TRES_ARRAY_ENERGY],
-					 jobacct->tres_usage_out_tot[
-						TRES_ARRAY_ENERGY]);
-			}
+			_update_energy(jobacct);
 
 			log_flag(JAG, "no pids in this container %"PRIu64"",
 				 cont_id);
@@ -743,6 +1007,40 @@ finished:
 	return prec_list;
 }
 
+extern List jag_common_get_task_precs(List task_list, bool pgid_plugin,
+				      uint64_t cont_id,
+				      jag_callbacks_t *callbacks)
+{
+	char	proc_stat_file[256];	/* Allow ~20x extra length */
+	char	proc_io_file[256];	/* Allow ~20x extra length */
+	char	proc_smaps_file[256];	/* Allow ~20x extra length */
+	struct jobacctinfo *jobacct;
+	ListIterator itr;
+
+	xassert(task_list);
+
+	if (!list_count(task_list)) {
+		log_flag(JAG, "no tasks in this container %"PRIu64"", cont_id);
+		return prec_list;
+	}
+
+	itr = list_iterator_create(task_list);
+	while ((jobacct = list_next(itr))) {
+		snprintf(proc_stat_file, 256, "/proc/%d/stat", jobacct->pid);
+		snprintf(proc_io_file, 256, "/proc/%d/io", jobacct->pid);
+		snprintf(proc_smaps_file, 256, "/proc/%d/smaps", jobacct->pid);
+		_handle_stats(proc_stat_file, proc_io_file, proc_smaps_file,
+			      callbacks, jobacct->tres_count);
+	}
+	list_iterator_destroy(itr);
+
+	/* update consumed energy even if the tasks are gone */
+	if (!list_count(prec_list))
+		_update_energy(list_peek(task_list));
+
+	return prec_list;
+}
+
 static void _record_profile(struct jobacctinfo *jobacct)
 {
 	enum {
@@ -885,10 +1183,19 @@ extern void jag_common_init(long in_hertz)
 	}
 
 	my_pagesize = getpagesize();
+
+	if (xstrcasestr(slurm_conf.job_acct_gather_params,
+			"UseProcConnector")) {
+		use_proc_conn = true;
+		_proc_conn_start();
+	}
 }
 
 extern void jag_common_fini(void)
 {
+	_proc_conn_fini();
+	use_proc_conn = false;
+
 	FREE_NULL_LIST(prec_list);
 
 	if (slash_proc)
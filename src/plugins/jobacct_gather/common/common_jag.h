@@ -68,6 +68,16 @@ extern void jag_common_init(long in_hertz);
 extern void jag_common_fini(void);
 extern void destroy_jag_prec(void *object);
 
+/*
+ * Build the process records of only the task leaders in task_list, skipping
+ * the rest of the container. For use as get_precs by plugins whose
+ * prec_extra gets per task totals elsewhere and that don't gather
+ * offspring data.
+ */
+extern List jag_common_get_task_precs(List task_list, bool pgid_plugin,
+				      uint64_t cont_id,
+				      jag_callbacks_t *callbacks);
+
 extern void jag_common_poll_data(
 	List task_list, bool pgid_plugin, uint64_t cont_id,
 	jag_callbacks_t *callbacks, bool profile);
@@ -100,6 +100,8 @@ const char plugin_type[] = "jobcomp/elasticsearch";
 const uint32_t plugin_version = SLURM_VERSION_NUMBER;
 
 #define INDEX_RETRY_INTERVAL 30
+#define MAX_BULK_SIZE 10000
+#define MIME_TYPE_NDJSON "application/x-ndjson"
 
 /* These are defined here so when we link with something other than
  * the slurmctld we will have these symbols defined. They will get
@@ -120,10 +122,18 @@ struct http_response {
 };
 
 struct job_node {
+	bool indexed;
 	time_t last_index_retry;
 	char * serialized_job;
 };
 
+/* Used to match bulk response items with the job records sent */
+typedef struct {
+	int inx;
+	int job_cnt;
+	struct job_node **jnodes;
+} bulk_resp_args_t;
+
 char *save_state_file = "elasticsearch_state";
 char *log_url = NULL;
 
@@ -137,6 +147,13 @@ static bool thread_shutdown = false;
 
 static long curl_timeout = 0;
 static long curl_connecttimeout = 0;
+static uint32_t bulk_size = 0;
+
+/*
+ * Only used by the job handler thread. Reusing the handle keeps the
+ * connection to the server alive between requests.
+ */
+static CURL *index_handle = NULL;
 
 /* Get the user name for the give user_id */
 static void _get_user_name(uint32_t user_id, char *user_name, int buf_size)
@@ -277,6 +294,33 @@ static size_t _write_callback(void *contents, size_t size, size_t nmemb,
 	return realsize;
 }
 
+/* Get the reused indexing handle ready for a new POST request */
+static CURL *_get_index_handle(const char *url, const char *body, size_t len,
+			       struct curl_slist *slist,
+			       struct http_response *chunk)
+{
+	if (!index_handle && !(index_handle = curl_easy_init())) {
+		error("%s: curl_easy_init: %m", plugin_type);
+		return NULL;
+	}
+	curl_easy_reset(index_handle);
+
+	curl_easy_setopt(index_handle, CURLOPT_URL, url);
+	curl_easy_setopt(index_handle, CURLOPT_POST, 1L);
+	curl_easy_setopt(index_handle, CURLOPT_POSTFIELDS, body);
+	curl_easy_setopt(index_handle, CURLOPT_POSTFIELDSIZE, (long) len);
+	curl_easy_setopt(index_handle, CURLOPT_HTTPHEADER, slist);
+	curl_easy_setopt(index_handle, CURLOPT_WRITEFUNCTION, _write_callback);
+	curl_easy_setopt(index_handle, CURLOPT_WRITEDATA, (void *) chunk);
+	curl_easy_setopt(index_handle, CURLOPT_TIMEOUT, curl_timeout);
+	curl_easy_setopt(index_handle, CURLOPT_CONNECTTIMEOUT,
+			 curl_connecttimeout);
+	if ((curl_timeout > 0) || (curl_connecttimeout > 0))
+		curl_easy_setopt(index_handle, CURLOPT_NOSIGNAL, 1L);
+
+	return index_handle;
+}
+
 /* Try to index job into elasticsearch */
 static int _index_job(const char *jobcomp)
 {
@@ -292,35 +336,23 @@ static int _index_job(const char *jobcomp)
 		return SLURM_ERROR;
 	}
 
-	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
-		error("%s: curl_global_init: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_global_init;
-	} else if ((curl_handle = curl_easy_init()) == NULL) {
-		error("%s: curl_easy_init: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
-	}
-
 	slist = curl_slist_append(slist, "Content-Type: " MIME_TYPE_JSON);
 
 	if (slist == NULL) {
 		error("%s: curl_slist_append: %m", plugin_type);
-		rc = SLURM_ERROR;
-		goto cleanup_easy_init;
+		return SLURM_ERROR;
 	}
 
 	chunk.message = xmalloc(1);
 	chunk.size = 0;
 
-	curl_easy_setopt(curl_handle, CURLOPT_URL, log_url);
-	curl_easy_setopt(curl_handle, CURLOPT_POST, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDS, jobcomp);
-	curl_easy_setopt(curl_handle, CURLOPT_POSTFIELDSIZE, strlen(jobcomp));
-	curl_easy_setopt(curl_handle, CURLOPT_HTTPHEADER, slist);
-	curl_easy_setopt(curl_handle, CURLOPT_HEADER, 1);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEFUNCTION, _write_callback);
-	curl_easy_setopt(curl_handle, CURLOPT_WRITEDATA, (void *) &chunk);
+	if (!(curl_handle = _get_index_handle(log_url, jobcomp,
+					      strlen(jobcomp), slist,
+					      &chunk))) {
+		rc = SLURM_ERROR;
+		goto cleanup;
+	}
+	curl_easy_setopt(curl_handle, CURLOPT_HEADER, 1L);
 
 	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
 		log_flag(ESEARCH, "%s: Could not connect to: %s , reason: %s",
@@ -365,10 +397,117 @@ static int _index_job(const char *jobcomp)
 cleanup:
 	curl_slist_free_all(slist);
 	xfree(chunk.message);
-cleanup_easy_init:
-	curl_easy_cleanup(curl_handle);
-cleanup_global_init:
-	curl_global_cleanup();
+	return rc;
+}
+
+static data_for_each_cmd_t _check_bulk_item(const data_t *data, void *arg)
+{
+	bulk_resp_args_t *args = arg;
+	const data_t *status;
+
+	if (args->inx >= args->job_cnt)
+		return DATA_FOR_EACH_FAIL;
+
+	/*
+	 * HTTP 200 (OK)	- request succeed.
+	 * HTTP 201 (Created)	- request succeed and resource created.
+	 */
+	status = data_resolve_dict_path_const(data, "/index/status");
+	if (status && (data_get_type(status) == DATA_TYPE_INT_64) &&
+	    ((data_get_int(status) == 200) || (data_get_int(status) == 201)))
+		args->jnodes[args->inx]->indexed = true;
+	args->inx++;
+
+	return DATA_FOR_EACH_CONT;
+}
+
+/*
+ * Index a batch of jobs with one request to the _bulk API. Each job indexed
+ * is flagged in its job_node, the others are left for a later retry.
+ */
+static int _index_bulk(struct job_node **jnodes, int job_cnt)
+{
+	CURL *curl_handle = NULL;
+	CURLcode res;
+	struct http_response chunk;
+	struct curl_slist *slist = NULL;
+	char *body = NULL, *pos = NULL, *url = NULL;
+	data_t *resp = NULL;
+	const data_t *items;
+	long status = 0;
+	int rc = SLURM_SUCCESS;
+	bulk_resp_args_t args = {
+		.job_cnt = job_cnt,
+		.jnodes = jnodes,
+	};
+
+	if (log_url == NULL) {
+		error("%s: JobCompLoc parameter not configured", plugin_type);
+		return SLURM_ERROR;
+	}
+
+	slist = curl_slist_append(slist, "Content-Type: " MIME_TYPE_NDJSON);
+	if (slist == NULL) {
+		error("%s: curl_slist_append: %m", plugin_type);
+		return SLURM_ERROR;
+	}
+
+	for (int i = 0; i < job_cnt; i++)
+		xstrfmtcatat(body, &pos, "{\"index\":{}}\n%s\n",
+			     jnodes[i]->serialized_job);
+
+	url = xstrdup(log_url);
+	if (url[strlen(url) - 1] == '/')
+		url[strlen(url) - 1] = '\0';
+	xstrcat(url, "/_bulk");
+
+	chunk.message = xmalloc(1);
+	chunk.size = 0;
+
+	if (!(curl_handle = _get_index_handle(url, body, pos - body, slist,
+					      &chunk))) {
+		rc = SLURM_ERROR;
+		goto cleanup;
+	}
+
+	if ((res = curl_easy_perform(curl_handle)) != CURLE_OK) {
+		log_flag(ESEARCH, "%s: Could not connect to: %s , reason: %s",
+			 plugin_type, url, curl_easy_strerror(res));
+		rc = SLURM_ERROR;
+		goto cleanup;
+	}
+
+	curl_easy_getinfo(curl_handle, CURLINFO_RESPONSE_CODE, &status);
+	if (status != 200) {
+		log_flag(ESEARCH, "%s: HTTP status code %ld received from %s",
+			 plugin_type, status, url);
+		log_flag(ESEARCH, "%s: HTTP response:\n%s",
+			 plugin_type, chunk.message);
+		rc = SLURM_ERROR;
+		goto cleanup;
+	}
+
+	if (data_g_deserialize(&resp, chunk.message, chunk.size,
+			       MIME_TYPE_JSON) ||
+	    !(items = data_key_get_const(resp, "items")) ||
+	    (data_get_type(items) != DATA_TYPE_LIST)) {
+		error("%s: Unable to parse bulk response from %s",
+		      plugin_type, url);
+		rc = SLURM_ERROR;
+		goto cleanup;
+	}
+	(void) data_list_for_each_const(items, _check_bulk_item, &args);
+
+	if (args.inx != job_cnt)
+		log_flag(ESEARCH, "%s: bulk response from %s has %d items for %d jobs",
+			 plugin_type, url, args.inx, job_cnt);
+
+cleanup:
+	FREE_NULL_DATA(resp);
+	curl_slist_free_all(slist);
+	xfree(chunk.message);
+	xfree(body);
+	xfree(url);
 	return rc;
 }
 
@@ -773,10 +912,63 @@ extern int jobcomp_p_log_record(job_record_t *job_ptr)
 	return SLURM_SUCCESS;
 }
 
-extern void *_process_jobs(void *x)
+static int _find_indexed(void *x, void *key)
+{
+	struct job_node *jnode = x;
+
+	return jnode->indexed;
+}
+
+/* Send the jobs ready for (re)indexing in batches of bulk_size */
+static void _process_jobs_bulk(struct job_node **jnodes)
 {
 	ListIterator iter;
 	struct job_node *jnode = NULL;
+	int job_cnt = 0, success_cnt = 0, fail_cnt = 0, wait_retry_cnt = 0;
+	time_t now = time(NULL);
+
+	iter = list_iterator_create(jobslist);
+	while (!thread_shutdown) {
+		jnode = list_next(iter);
+		if (jnode && jnode->last_index_retry &&
+		    (difftime(now, jnode->last_index_retry) <
+		     INDEX_RETRY_INTERVAL)) {
+			wait_retry_cnt++;
+			continue;
+		}
+		if (jnode)
+			jnodes[job_cnt++] = jnode;
+		if (!job_cnt || (jnode && (job_cnt < bulk_size)))
+			goto next;
+
+		(void) _index_bulk(jnodes, job_cnt);
+		now = time(NULL);
+		for (int i = 0; i < job_cnt; i++) {
+			if (jnodes[i]->indexed) {
+				success_cnt++;
+			} else {
+				jnodes[i]->last_index_retry = now;
+				fail_cnt++;
+			}
+		}
+		job_cnt = 0;
+next:
+		if (!jnode)
+			break;
+	}
+	list_iterator_destroy(iter);
+
+	if (success_cnt)
+		(void) list_delete_all(jobslist, _find_indexed, NULL);
+	if ((success_cnt || fail_cnt))
+		log_flag(ESEARCH, "%s: bulk index success:%d fail:%d wait_retry:%d",
+			 plugin_type, success_cnt, fail_cnt, wait_retry_cnt);
+}
+
+extern void *_process_jobs(void *x)
+{
+	ListIterator iter;
+	struct job_node *jnode = NULL, **jnodes = NULL;
 	struct timespec ts = {0, 0};
 	time_t now;
 
@@ -786,9 +978,16 @@ extern void *_process_jobs(void *x)
 	slurm_cond_timedwait(&location_cond, &location_mutex, &ts);
 	slurm_mutex_unlock(&location_mutex);
 
+	if (bulk_size)
+		jnodes = xcalloc(bulk_size, sizeof(struct job_node *));
+
 	while (!thread_shutdown) {
 		int success_cnt = 0, fail_cnt = 0, wait_retry_cnt = 0;
 		sleep(1);
+		if (bulk_size) {
+			_process_jobs_bulk(jnodes);
+			continue;
+		}
 		iter = list_iterator_create(jobslist);
 		while ((jnode = (struct job_node *)list_next(iter)) &&
 		       !thread_shutdown) {
@@ -813,6 +1012,12 @@ extern void *_process_jobs(void *x)
 				 plugin_type, success_cnt, fail_cnt,
 				 wait_retry_cnt);
 	}
+
+	xfree(jnodes);
+	if (index_handle) {
+		curl_easy_cleanup(index_handle);
+		index_handle = NULL;
+	}
 	return NULL;
 }
 
@@ -853,6 +1058,23 @@ extern int init(void)
 		log_flag(ESEARCH, "%s: setting curl connect timeout: %lds",
 			 plugin_type, curl_timeout);
 	}
+	/*                                                      1234567890 */
+	if ((tmp_ptr = xstrcasestr(slurm_conf.job_comp_params, "bulk_size="))) {
+		bulk_size = xstrntol(tmp_ptr + 10, NULL, 10, 10);
+		if (bulk_size > MAX_BULK_SIZE) {
+			error("%s: bulk_size=%u is too large, using %u",
+			      plugin_type, bulk_size, MAX_BULK_SIZE);
+			bulk_size = MAX_BULK_SIZE;
+		}
+
+		log_flag(ESEARCH, "%s: indexing up to %u jobs per bulk request",
+			 plugin_type, bulk_size);
+	}
+
+	if (curl_global_init(CURL_GLOBAL_ALL) != 0) {
+		error("%s: curl_global_init: %m", plugin_type);
+		return SLURM_ERROR;
+	}
 
 	jobslist = list_create(_jobslist_del);
 	slurm_thread_create(&job_handler_thread, _process_jobs, NULL);
@@ -871,6 +1093,7 @@ extern int fini(void)
 	_save_state();
 	list_destroy(jobslist);
 	xfree(log_url);
+	curl_global_cleanup();
 	return SLURM_SUCCESS;
 }
 
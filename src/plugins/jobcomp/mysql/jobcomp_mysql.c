@@ -101,9 +101,29 @@ storage_field_t jobcomp_table_fields[] = {
 	{ NULL, NULL}
 };
 
+#define MAX_PEND_RECORDS 100000
+#define RECONNECT_INTERVAL 10
+
 /* File descriptor used for logging */
 static pthread_mutex_t  jobcomp_lock = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Job records are written to the database by an agent thread so a slow
+ * database does not extend the time slurmctld holds the job write lock.
+ * The agent is only started by the first jobcomp_p_log_record() call.
+ */
+static pthread_t agent_tid = 0;
+static pthread_mutex_t agent_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t agent_cond = PTHREAD_COND_INITIALIZER;
+static bool agent_exit = false;
+static List query_list = NULL;
+
+/*
+ * Protects jobcomp_mysql_conn. The agent thread uses the connection while
+ * jobcomp_p_set_location() may be called again on reconfigure.
+ */
+static pthread_mutex_t conn_lock = PTHREAD_MUTEX_INITIALIZER;
+
 
 static int _mysql_jobcomp_check_tables()
 {
@@ -157,6 +177,95 @@ static char *_get_group_name(uint32_t group_id)
 	return ret_name;
 }
 
+static int _connect(char *location);
+
+/* Return true if connected to the database, conn_lock must be locked */
+static bool _connected(void)
+{
+	return (_connect(slurm_conf.job_comp_loc) == SLURM_SUCCESS);
+}
+
+static void *_agent(void *args)
+{
+	struct timespec ts = {0, 0};
+	char *query;
+	bool connected;
+
+	while (1) {
+		slurm_mutex_lock(&agent_lock);
+		if (list_is_empty(query_list) && !agent_exit)
+			slurm_cond_wait(&agent_cond, &agent_lock);
+		slurm_mutex_unlock(&agent_lock);
+
+		if (list_is_empty(query_list)) {
+			if (agent_exit)
+				break;
+			continue;
+		}
+
+		slurm_mutex_lock(&conn_lock);
+		connected = _connected();
+		slurm_mutex_unlock(&conn_lock);
+
+		if (!connected) {
+			if (agent_exit) {
+				error("%s: database unavailable, %d job records discarded",
+				      plugin_type, list_count(query_list));
+				break;
+			}
+			slurm_mutex_lock(&agent_lock);
+			ts.tv_sec = time(NULL) + RECONNECT_INTERVAL;
+			if (!agent_exit)
+				slurm_cond_timedwait(&agent_cond, &agent_lock,
+						     &ts);
+			slurm_mutex_unlock(&agent_lock);
+			continue;
+		}
+
+		while ((query = list_pop(query_list))) {
+			debug3("(%s:%d) query\n%s",
+			       THIS_FILE, __LINE__, query);
+			slurm_mutex_lock(&conn_lock);
+			connected = ((mysql_db_query(jobcomp_mysql_conn,
+						     query) == SLURM_SUCCESS) ||
+				     (mysql_db_ping(jobcomp_mysql_conn) == 0));
+			slurm_mutex_unlock(&conn_lock);
+			if (!connected) {
+				/* Lost the connection, retry this one later */
+				list_push(query_list, query);
+				break;
+			}
+			xfree(query);
+		}
+	}
+
+	return NULL;
+}
+
+static void _agent_fini(void)
+{
+	slurm_mutex_lock(&agent_lock);
+	if (agent_tid) {
+		agent_exit = true;
+		slurm_cond_broadcast(&agent_cond);
+		slurm_mutex_unlock(&agent_lock);
+		pthread_join(agent_tid, NULL);
+		slurm_mutex_lock(&agent_lock);
+		agent_tid = 0;
+		agent_exit = false;
+	}
+	FREE_NULL_LIST(query_list);
+	slurm_mutex_unlock(&agent_lock);
+}
+
+static void _close_conn(void)
+{
+	if (jobcomp_mysql_conn) {
+		destroy_mysql_conn(jobcomp_mysql_conn);
+		jobcomp_mysql_conn = NULL;
+	}
+}
+
 /*
  * init() is called when the plugin is loaded, before any other functions
  * are called.  Put global initialization here.
@@ -179,14 +288,15 @@ extern int init ( void )
 
 extern int fini ( void )
 {
-	if (jobcomp_mysql_conn) {
-		destroy_mysql_conn(jobcomp_mysql_conn);
-		jobcomp_mysql_conn = NULL;
-	}
+	_agent_fini();
+	slurm_mutex_lock(&conn_lock);
+	_close_conn();
+	slurm_mutex_unlock(&conn_lock);
 	return SLURM_SUCCESS;
 }
 
-extern int jobcomp_p_set_location(char *location)
+/* Connect to the database unless connected, conn_lock must be locked */
+static int _connect(char *location)
 {
 	mysql_db_info_t *db_info;
 	int rc = SLURM_SUCCESS;
@@ -216,7 +326,7 @@ extern int jobcomp_p_set_location(char *location)
 
 	debug2("mysql_connect() called for db %s", db_name);
 	/* Just make sure our connection is gone. */
-	fini();
+	_close_conn();
 	jobcomp_mysql_conn = create_mysql_conn(0, 0, NULL);
 
 	db_info = create_mysql_db_info(SLURM_MYSQL_PLUGIN_JC);
@@ -235,6 +345,17 @@ extern int jobcomp_p_set_location(char *location)
 	return rc;
 }
 
+extern int jobcomp_p_set_location(char *location)
+{
+	int rc;
+
+	slurm_mutex_lock(&conn_lock);
+	rc = _connect(location);
+	slurm_mutex_unlock(&conn_lock);
+
+	return rc;
+}
+
 extern int jobcomp_p_log_record(job_record_t *job_ptr)
 {
 	int rc = SLURM_SUCCESS;
@@ -246,10 +367,19 @@ extern int jobcomp_p_log_record(job_record_t *job_ptr)
 	char *query = NULL, *on_dup = NULL;
 	uint32_t time_limit, start_time, end_time;
 
-	if (!jobcomp_mysql_conn || mysql_db_ping(jobcomp_mysql_conn) != 0) {
-		if (jobcomp_p_set_location(slurm_conf.job_comp_loc))
-			return SLURM_ERROR;
+	slurm_mutex_lock(&agent_lock);
+	if (!agent_tid) {
+		if (!query_list)
+			query_list = list_create(xfree_ptr);
+		slurm_thread_create(&agent_tid, _agent, NULL);
+	}
+	if (list_count(query_list) >= MAX_PEND_RECORDS) {
+		slurm_mutex_unlock(&agent_lock);
+		error("%s: Limit of %d job records waiting for the database reached. %pJ discarded",
+		      plugin_type, MAX_PEND_RECORDS, job_ptr);
+		return SLURM_ERROR;
 	}
+	slurm_mutex_unlock(&agent_lock);
 
 	usr_str = _get_user_name(job_ptr->user_id);
 	grp_str = _get_group_name(job_ptr->group_id);
@@ -384,13 +514,15 @@ extern int jobcomp_p_log_record(job_record_t *job_ptr)
 	}
 	xstrfmtcat(query, ") ON DUPLICATE KEY UPDATE %s;", on_dup);
 
-	debug3("(%s:%d) query\n%s",
-	       THIS_FILE, __LINE__, query);
-	rc = mysql_db_query(jobcomp_mysql_conn, query);
+	slurm_mutex_lock(&agent_lock);
+	if (list_is_empty(query_list))
+		slurm_cond_broadcast(&agent_cond);
+	list_append(query_list, query);
+	slurm_mutex_unlock(&agent_lock);
+
 	xfree(usr_str);
 	xfree(grp_str);
 	xfree(jname);
-	xfree(query);
 	xfree(on_dup);
 
 	return rc;
@@ -405,12 +537,10 @@ extern List jobcomp_p_get_jobs(slurmdb_job_cond_t *job_cond)
 {
 	List job_list = NULL;
 
-	if (!jobcomp_mysql_conn || mysql_db_ping(jobcomp_mysql_conn) != 0) {
-		if (jobcomp_p_set_location(slurm_conf.job_comp_loc))
-			return job_list;
-	}
-
-	job_list = mysql_jobcomp_process_get_jobs(job_cond);
+	slurm_mutex_lock(&conn_lock);
+	if (_connected())
+		job_list = mysql_jobcomp_process_get_jobs(job_cond);
+	slurm_mutex_unlock(&conn_lock);
 
 	return job_list;
 }
@@ -420,10 +550,12 @@ extern List jobcomp_p_get_jobs(slurmdb_job_cond_t *job_cond)
  */
 extern int jobcomp_p_archive(slurmdb_archive_cond_t *arch_cond)
 {
-	if (!jobcomp_mysql_conn || mysql_db_ping(jobcomp_mysql_conn) != 0) {
-		if (jobcomp_p_set_location(slurm_conf.job_comp_loc))
-			return SLURM_ERROR;
-	}
+	int rc = SLURM_ERROR;
+
+	slurm_mutex_lock(&conn_lock);
+	if (_connected())
+		rc = mysql_jobcomp_process_archive(arch_cond);
+	slurm_mutex_unlock(&conn_lock);
 
-	return mysql_jobcomp_process_archive(arch_cond);
+	return rc;
 }
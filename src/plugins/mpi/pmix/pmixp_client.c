@@ -772,18 +772,29 @@ extern int pmixp_lib_fence(const pmixp_proc_t procs[], size_t nprocs,
 	pmixp_coll_type_t type = pmixp_info_srv_fence_coll_type();
 
 	if (PMIXP_COLL_TYPE_FENCE_MAX == type) {
+		uint32_t ring_max = pmixp_info_srv_fence_ring_max_nodes();
+
 		type = PMIXP_COLL_TYPE_FENCE_TREE;
+		coll = pmixp_state_coll_get(type, procs, nprocs);
 		/*
 		 * Practice shows the Tree algorithm has better performance
 		 * performance for fence with zero data. Only use the Ring
 		 * algorithm if there is data to collect.
+		 *
+		 * A ring also takes one hop per node while the tree depth
+		 * grows with the log of the node count, so the ring can be
+		 * limited to fences spanning at most ring_max nodes. The node
+		 * count is the same on every participant, which keeps them
+		 * agreeing on the algorithm.
 		 */
-		if (collect && (ndata > 0)) {
+		if (coll && collect && (ndata > 0) &&
+		    (!ring_max || ((uint32_t) coll->peers_cnt <= ring_max))) {
 			type = PMIXP_COLL_TYPE_FENCE_RING;
+			coll = pmixp_state_coll_get(type, procs, nprocs);
 		}
-	}
+	} else
+		coll = pmixp_state_coll_get(type, procs, nprocs);
 
-	coll = pmixp_state_coll_get(type, procs, nprocs);
 	if (!coll) {
 		status = PMIX_ERROR;
 		goto error;
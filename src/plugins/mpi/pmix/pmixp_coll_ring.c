@@ -255,7 +255,7 @@ static int _ring_forward_data(pmixp_coll_ring_ctx_t *coll_ctx, uint32_t contrib_
 	hdr.seq = coll_ctx->seq;
 	hdr.hop_seq = hop_seq;
 	hdr.contrib_id = contrib_id;
-	pmixp_ep_t *ep = (pmixp_ep_t*)xmalloc(sizeof(*ep));
+	pmixp_ep_t ep;
 	pmixp_coll_ring_cbdata_t *cbdata = NULL;
 	uint32_t offset = 0;
 	buf_t *buf = _get_fwd_buf(coll_ctx);
@@ -273,8 +273,8 @@ static int _ring_forward_data(pmixp_coll_ring_ctx_t *coll_ctx, uint32_t contrib_
 		rc = SLURM_ERROR;
 		goto exit;
 	}
-	ep->type = PMIXP_EP_NOIDEID;
-	ep->ep.nodeid = ring->next_peerid;
+	ep.type = PMIXP_EP_NOIDEID;
+	ep.ep.nodeid = ring->next_peerid;
 
 	/* pack ring info */
 	_pack_coll_ring_info(coll, &hdr, buf);
@@ -290,7 +290,7 @@ static int _ring_forward_data(pmixp_coll_ring_ctx_t *coll_ctx, uint32_t contrib_
 	cbdata->coll = coll;
 	cbdata->coll_ctx = coll_ctx;
 	cbdata->seq = coll_ctx->seq;
-	rc = pmixp_server_send_nb(ep, PMIXP_MSG_RING, coll_ctx->seq, buf,
+	rc = pmixp_server_send_nb(&ep, PMIXP_MSG_RING, coll_ctx->seq, buf,
 				  _ring_sent_cb, cbdata);
 exit:
 	return rc;
@@ -534,15 +534,21 @@ inline static int _pmixp_coll_contrib(pmixp_coll_ring_ctx_t *coll_ctx,
 	/* change the state */
 	coll->ts = time(NULL);
 
-	/* save contribution */
-	if (!size_buf(coll_ctx->ring_buf)) {
-		grow_buf(coll_ctx->ring_buf, size * coll->peers_cnt);
-	} else if(remaining_buf(coll_ctx->ring_buf) < size) {
-		uint32_t new_size = size_buf(coll_ctx->ring_buf) + size *
-			_ring_remain_contrib(coll_ctx);
-		grow_buf(coll_ctx->ring_buf, new_size);
+	/*
+	 * Save contribution. Contributions are usually of similar size, so
+	 * reserve room for all of the ones still expected at once instead
+	 * of reallocating (and copying) the whole ring buffer on each hop.
+	 */
+	if (remaining_buf(coll_ctx->ring_buf) < size) {
+		uint64_t want = (uint64_t) size * _ring_remain_contrib(coll_ctx);
+		uint64_t avail = remaining_buf(coll_ctx->ring_buf);
+
+		if ((want < size) ||
+		    ((size_buf(coll_ctx->ring_buf) + want - avail) >
+		     MAX_BUF_SIZE))
+			want = size;
+		grow_buf(coll_ctx->ring_buf, want - avail);
 	}
-	grow_buf(coll_ctx->ring_buf, size);
 	data_ptr = get_buf_data(coll_ctx->ring_buf) +
 		get_buf_offset(coll_ctx->ring_buf);
 	memcpy(data_ptr, data, size);
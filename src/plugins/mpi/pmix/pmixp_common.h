@@ -155,6 +155,8 @@
 /* The prefered fence type, values:[auto|tree|ring] */
 #define PMIXP_COLL_FENCE "SLURM_PMIX_FENCE"
 #define SLURM_PMIXP_FENCE_BARRIER "SLURM_PMIX_FENCE_BARRIER"
+/* Largest node count the auto fence runs as a ring, 0 means no limit */
+#define PMIXP_COLL_FENCE_RING_MAX "SLURM_PMIX_FENCE_RING_MAX_NODES"
 
 typedef enum {
 	PMIXP_P2P_INLINE,
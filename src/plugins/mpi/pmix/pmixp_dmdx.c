@@ -48,16 +48,21 @@ typedef enum {
 	DMDX_RESPONSE
 } dmdx_type_t;
 
+typedef struct {
+	void *cbfunc;
+	void *cbdata;
+} dmdx_waiter_t;
+
 typedef struct {
 	uint32_t seq_num;
 	time_t ts;
-#ifndef NDEBUG
-	/* we need this only for verification */
+	/* used to coalesce requests for the same process */
 	char nspace[PMIXP_MAX_NSLEN];
 	int rank;
-#endif
 	void *cbfunc;
 	void *cbdata;
+	/* additional local callers waiting on this request */
+	List waiters;
 } dmdx_req_info_t;
 
 typedef struct {
@@ -80,6 +85,21 @@ void _dmdx_free_caddy(dmdx_caddy_t *caddy)
 	xfree(caddy);
 }
 
+static void _dmdx_free_req(void *x)
+{
+	dmdx_req_info_t *req = (dmdx_req_info_t *)x;
+
+	FREE_NULL_LIST(req->waiters);
+	xfree(req);
+}
+
+/*
+ * Protects _dmdx_requests and _dmdx_seq_num. Requests are issued from
+ * the libpmix thread while responses and timeouts are processed by the
+ * plugin's service thread, so lookups that are followed by a
+ * modification of the request have to be atomic.
+ */
+static pthread_mutex_t _dmdx_mutex = PTHREAD_MUTEX_INITIALIZER;
 static List _dmdx_requests;
 static uint32_t _dmdx_seq_num = 1;
 
@@ -88,7 +108,7 @@ static void _respond_with_error(int seq_num, int nodeid,
 
 int pmixp_dmdx_init(void)
 {
-	_dmdx_requests = list_create(xfree_ptr);
+	_dmdx_requests = list_create(_dmdx_free_req);
 	_dmdx_seq_num = 1;
 	return SLURM_SUCCESS;
 }
@@ -232,6 +252,50 @@ static void _dmdx_pmix_cb(int status, char *data, size_t sz,
 	_dmdx_free_caddy(caddy);
 }
 
+static int _dmdx_req_cmp(void *x, void *key)
+{
+	dmdx_req_info_t *req = (dmdx_req_info_t *)x;
+	uint32_t seq_num = *((uint32_t *)key);
+	return (req->seq_num == seq_num);
+}
+
+static int _dmdx_req_proc_cmp(void *x, void *key)
+{
+	dmdx_req_info_t *req = (dmdx_req_info_t *)x;
+	pmixp_proc_t *proc = (pmixp_proc_t *)key;
+	return (((uint32_t) req->rank == proc->rank) &&
+		!xstrncmp(req->nspace, proc->nspace, PMIXP_MAX_NSLEN));
+}
+
+/*
+ * Deliver the result of a request to all callers waiting on it.
+ * Every additional waiter gets its own copy of the blob as libpmix
+ * releases each one independently. The original caller takes ownership
+ * of buf (if any), so it is served last.
+ */
+static void _dmdx_req_complete(dmdx_req_info_t *req, int status,
+			       char *data, uint32_t size, buf_t *buf)
+{
+	dmdx_waiter_t *waiter;
+
+	if (req->waiters) {
+		while ((waiter = list_pop(req->waiters))) {
+			char *copy = NULL;
+			if (data && size) {
+				copy = xmalloc(size);
+				memcpy(copy, data, size);
+			}
+			pmixp_lib_modex_invoke(waiter->cbfunc, status,
+					       copy, size, waiter->cbdata,
+					       copy ? xfree_ptr : NULL, copy);
+			xfree(waiter);
+		}
+	}
+
+	pmixp_lib_modex_invoke(req->cbfunc, status, data, size, req->cbdata,
+			       buf ? pmixp_free_buf : NULL, (void *)buf);
+}
+
 int pmixp_dmdx_get(const char *nspace, int rank,
 		   void *cbfunc, void *cbdata)
 {
@@ -240,14 +304,28 @@ int pmixp_dmdx_get(const char *nspace, int rank,
 	int rc;
 	uint32_t seq;
 	pmixp_ep_t ep;
+	pmixp_proc_t proc = { { 0 } };
 
-	/* need to send the request */
-	ep.type = PMIXP_EP_NOIDEID;
-	ep.ep.nodeid = pmixp_nspace_resolve(nspace, rank);
-
-	buf = pmixp_server_buf_new();
-	/* setup message header */
-	_setup_header(buf, DMDX_REQUEST, nspace, rank, SLURM_SUCCESS);
+	/*
+	 * If the same process is already being fetched, wait for that
+	 * response instead of sending a duplicate request to the remote
+	 * node. Data delivered to libpmix is cached there, so only
+	 * requests racing with an outstanding one end up here.
+	 */
+	strncpy(proc.nspace, nspace, PMIXP_MAX_NSLEN);
+	proc.rank = rank;
+	slurm_mutex_lock(&_dmdx_mutex);
+	if ((req = list_find_first(_dmdx_requests, _dmdx_req_proc_cmp,
+				   &proc))) {
+		dmdx_waiter_t *waiter = xmalloc(sizeof(*waiter));
+		waiter->cbfunc = cbfunc;
+		waiter->cbdata = cbdata;
+		if (!req->waiters)
+			req->waiters = list_create(xfree_ptr);
+		list_append(req->waiters, waiter);
+		slurm_mutex_unlock(&_dmdx_mutex);
+		return SLURM_SUCCESS;
+	}
 
 	/* store cur seq. num and move to the next request */
 	seq = _dmdx_seq_num++;
@@ -258,11 +336,18 @@ int pmixp_dmdx_get(const char *nspace, int rank,
 	req->cbfunc = cbfunc;
 	req->cbdata = cbdata;
 	req->ts = time(NULL);
-#ifndef NDEBUG
 	strncpy(req->nspace, nspace, PMIXP_MAX_NSLEN);
 	req->rank = rank;
-#endif
 	list_append(_dmdx_requests, req);
+	slurm_mutex_unlock(&_dmdx_mutex);
+
+	/* need to send the request */
+	ep.type = PMIXP_EP_NOIDEID;
+	ep.ep.nodeid = pmixp_nspace_resolve(nspace, rank);
+
+	buf = pmixp_server_buf_new();
+	/* setup message header */
+	_setup_header(buf, DMDX_REQUEST, nspace, rank, SLURM_SUCCESS);
 
 	/* send the request */
 	rc = pmixp_server_send_nb(&ep, PMIXP_MSG_DMDX, seq, buf,
@@ -274,8 +359,14 @@ int pmixp_dmdx_get(const char *nspace, int rank,
 		PMIXP_ERROR("Cannot send direct modex request to %s, size %d",
 			    nodename, get_buf_offset(buf));
 		xfree(nodename);
-		pmixp_lib_modex_invoke(cbfunc, SLURM_ERROR, NULL, 0,
-				       cbdata, NULL, NULL);
+		/* stop tracking, the response will never come */
+		slurm_mutex_lock(&_dmdx_mutex);
+		req = list_remove_first(_dmdx_requests, _dmdx_req_cmp, &seq);
+		slurm_mutex_unlock(&_dmdx_mutex);
+		if (req) {
+			_dmdx_req_complete(req, SLURM_ERROR, NULL, 0, NULL);
+			_dmdx_free_req(req);
+		}
 		rc = SLURM_ERROR;
 	}
 
@@ -359,13 +450,6 @@ exit:
 	 * anyway. We've notified libpmix, that's enough */
 }
 
-static int _dmdx_req_cmp(void *x, void *key)
-{
-	dmdx_req_info_t *req = (dmdx_req_info_t *)x;
-	uint32_t seq_num = *((uint32_t *)key);
-	return (req->seq_num == seq_num);
-}
-
 static void _dmdx_resp(buf_t *buf, int nodeid, uint32_t seq_num)
 {
 	dmdx_req_info_t *req;
@@ -376,14 +460,14 @@ static void _dmdx_resp(buf_t *buf, int nodeid, uint32_t seq_num)
 	uint32_t size = 0;
 
 	/* find the request tracker */
-	ListIterator it = list_iterator_create(_dmdx_requests);
-	req = (dmdx_req_info_t *)list_find(it, _dmdx_req_cmp, &seq_num);
+	slurm_mutex_lock(&_dmdx_mutex);
+	req = list_remove_first(_dmdx_requests, _dmdx_req_cmp, &seq_num);
+	slurm_mutex_unlock(&_dmdx_mutex);
 	if (NULL == req) {
 		char *nodename = pmixp_info_job_host(nodeid);
 		/* We haven't sent this request! */
 		PMIXP_ERROR("Received DMDX response with bad seq_num=%d from %s!",
 			    seq_num, nodename);
-		list_iterator_destroy(it);
 		rc = SLURM_ERROR;
 		xfree(nodename);
 		goto exit;
@@ -393,28 +477,22 @@ static void _dmdx_resp(buf_t *buf, int nodeid, uint32_t seq_num)
 	rc = _read_info(buf, &ns, &rank, &sender_ns, &status);
 	if (SLURM_SUCCESS != rc) {
 		/* notify libpmix about an error */
-		pmixp_lib_modex_invoke(req->cbfunc, SLURM_ERROR, NULL, 0,
-				       req->cbdata, NULL, NULL);
+		_dmdx_req_complete(req, SLURM_ERROR, NULL, 0, NULL);
 		goto exit;
 	}
 
 	/* get the modex blob */
 	if (SLURM_SUCCESS != (rc = unpackmem_ptr(&data, &size, buf))) {
 		/* notify libpmix about an error */
-		pmixp_lib_modex_invoke(req->cbfunc, SLURM_ERROR, NULL, 0,
-				       req->cbdata, NULL, NULL);
+		_dmdx_req_complete(req, SLURM_ERROR, NULL, 0, NULL);
 		goto exit;
 	}
 
 	/* call back to libpmix-server */
-	pmixp_lib_modex_invoke(req->cbfunc, status, data, size,
-			       req->cbdata, pmixp_free_buf, (void *)buf);
-
-	/* release tracker & list iterator */
-	req = NULL;
-	list_delete_item(it);
-	list_iterator_destroy(it);
+	_dmdx_req_complete(req, status, data, size, buf);
 exit:
+	if (req)
+		_dmdx_free_req(req);
 	if (SLURM_SUCCESS != rc) {
 		/* we are not expect libpmix to call the callback
 		 * to cleanup this buffer */
@@ -447,33 +525,45 @@ void pmixp_dmdx_process(buf_t *buf, int nodeid, uint32_t seq)
 
 void pmixp_dmdx_timeout_cleanup(void)
 {
-	ListIterator it = list_iterator_create(_dmdx_requests);
+	ListIterator it;
 	dmdx_req_info_t *req = NULL;
+	List stale = NULL;
 	time_t ts = time(NULL);
 
 	/* run through all requests and discard stale one's */
+	slurm_mutex_lock(&_dmdx_mutex);
+	it = list_iterator_create(_dmdx_requests);
 	while ((req = list_next(it))) {
 		if ((ts - req->ts) > pmixp_info_timeout()) {
-#ifndef NDEBUG
-			/* respond with the timeout to libpmix */
-			int nodeid = pmixp_nspace_resolve(req->nspace,
-							  req->rank);
-			char *nodename = pmixp_info_job_host(nodeid);
-			xassert(NULL != nodename);
-			PMIXP_ERROR("timeout: ns=%s, rank=%d, host=%s, ts=%lu",
-				    req->nspace, req->rank,
-				    (NULL != nodename) ? nodename : "unknown",
-				    ts);
-			if (NULL != nodename) {
-				xfree(nodename);
-			}
-#endif
-			/* PMIX_ERR_TIMEOUT */
-			pmixp_lib_modex_invoke(req->cbfunc, SLURM_ERROR, NULL, 0,
-					       req->cbdata, NULL, NULL);
-			/* release tracker & list iterator */
-			list_delete_item(it);
+			if (!stale)
+				stale = list_create(_dmdx_free_req);
+			list_append(stale, list_remove(it));
 		}
 	}
 	list_iterator_destroy(it);
+	slurm_mutex_unlock(&_dmdx_mutex);
+
+	if (!stale)
+		return;
+
+	/* respond outside of the lock, libpmix may issue new requests */
+	while ((req = list_pop(stale))) {
+#ifndef NDEBUG
+		/* respond with the timeout to libpmix */
+		int nodeid = pmixp_nspace_resolve(req->nspace, req->rank);
+		char *nodename = pmixp_info_job_host(nodeid);
+		xassert(NULL != nodename);
+		PMIXP_ERROR("timeout: ns=%s, rank=%d, host=%s, ts=%lu",
+			    req->nspace, req->rank,
+			    (NULL != nodename) ? nodename : "unknown",
+			    ts);
+		if (NULL != nodename) {
+			xfree(nodename);
+		}
+#endif
+		/* PMIX_ERR_TIMEOUT */
+		_dmdx_req_complete(req, SLURM_ERROR, NULL, 0, NULL);
+		_dmdx_free_req(req);
+	}
+	FREE_NULL_LIST(stale);
 }
@@ -59,6 +59,7 @@ static bool _srv_use_direct_conn_ucx = false;
 #endif
 static int _srv_fence_coll_type = PMIXP_COLL_TYPE_FENCE_MAX;
 static bool _srv_fence_coll_barrier = false;
+static uint32_t _srv_fence_ring_max_nodes = 0;
 
 pmix_jobinfo_t _pmixp_job_info;
 
@@ -123,6 +124,11 @@ bool pmixp_info_srv_fence_coll_barrier(void)
 	return _srv_fence_coll_barrier;
 }
 
+uint32_t pmixp_info_srv_fence_ring_max_nodes(void)
+{
+	return _srv_fence_ring_max_nodes;
+}
+
 /* Job information */
 int pmixp_info_set(const stepd_step_rec_t *job, char ***env)
 {
@@ -503,6 +509,12 @@ static int _env_set(char ***env)
 			_srv_fence_coll_type = PMIXP_COLL_CPERF_RING;
 		}
 	}
+	p = getenvp(*env, PMIXP_COLL_FENCE_RING_MAX);
+	if (p) {
+		int tmp = atoi(p);
+		if (tmp >= 0)
+			_srv_fence_ring_max_nodes = tmp;
+	}
 	p = getenvp(*env, SLURM_PMIXP_FENCE_BARRIER);
 	if (p) {
 		if (!xstrcmp("1",p) || !xstrcasecmp("true", p) ||
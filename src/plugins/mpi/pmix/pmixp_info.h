@@ -93,6 +93,7 @@ bool pmixp_info_srv_direct_conn_early(void);
 bool pmixp_info_srv_direct_conn_ucx(void);
 int pmixp_info_srv_fence_coll_type(void);
 bool pmixp_info_srv_fence_coll_barrier(void);
+uint32_t pmixp_info_srv_fence_ring_max_nodes(void);
 
 
 static inline int pmixp_info_timeout(void)
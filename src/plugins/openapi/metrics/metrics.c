@@ -0,0 +1,495 @@
+/*****************************************************************************\
+ *  metrics.c - Slurm REST API OpenMetrics exporter
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <inttypes.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/data.h"
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/read_config.h"
+#include "src/common/ref.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/uid.h"
+#include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmrestd/openapi.h"
+#include "src/slurmrestd/operations.h"
+
+/*
+ * These variables are required by the generic plugin interface.  If they
+ * are not found in the plugin, the plugin loader will ignore it.
+ *
+ * plugin_name - a string giving a human-readable description of the
+ * plugin.  There is no maximum length, but the symbol must refer to
+ * a valid string.
+ *
+ * plugin_type - a string suggesting the type of the plugin or its
+ * applicability to a particular form of data or method of data handling.
+ * If the low-level plugin API is used, the contents of this string are
+ * unimportant and may be anything.  Slurm uses the higher-level plugin
+ * interface which requires this string to be of the form
+ *
+ *	<application>/<method>
+ *
+ * where <application> is a description of the intended application of
+ * the plugin (e.g., "select" for Slurm node selection) and <method>
+ * is a description of how this plugin satisfies that application.  Slurm will
+ * only load select plugins if the plugin_type string has a
+ * prefix of "select/".
+ *
+ * plugin_version - an unsigned 32-bit integer containing the Slurm version
+ * (major.minor.micro combined into a single number).
+ */
+const char plugin_name[] = "REST OpenMetrics exporter";
+const char plugin_type[] = "openapi/metrics";
+const uint32_t plugin_id = 103;
+const uint32_t plugin_version = SLURM_VERSION_NUMBER;
+
+decl_static_data(openapi_json);
+
+#define METRICS_MIME_TYPE \
+	"application/openmetrics-text; version=1.0.0; charset=utf-8"
+#define DEFAULT_REFRESH_INTERVAL 10	/* seconds */
+
+/*
+ * All scrapers are served from the last snapshot taken from slurmctld so the
+ * controller sees at most one set of queries per refresh interval no matter
+ * how many scrapers there are. cache_lock is held while refreshing so
+ * concurrent scrapers wait for the new snapshot instead of querying too.
+ * With PrivateData restricting the node or partition data, what slurmctld
+ * returns depends on the requester, so no snapshot is shared.
+ */
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static char *cache = NULL;		/* rendered metrics */
+static int cache_rc = SLURM_SUCCESS;	/* result of last refresh */
+static time_t cache_time = 0;		/* time of last refresh */
+static int refresh_interval = DEFAULT_REFRESH_INTERVAL;
+
+/* Return label value escaped for OpenMetrics, must xfree() */
+static char *_label_value(const char *value)
+{
+	char *escaped, *pos;
+
+	if (!value)
+		return xstrdup("");
+
+	pos = escaped = xmalloc((strlen(value) * 2) + 1);
+	for (const char *c = value; *c; c++) {
+		if ((*c == '\\') || (*c == '"')) {
+			*pos++ = '\\';
+			*pos++ = *c;
+		} else if (*c == '\n') {
+			*pos++ = '\\';
+			*pos++ = 'n';
+		} else {
+			*pos++ = *c;
+		}
+	}
+
+	return escaped;
+}
+
+static void _family(char **out, const char *name, const char *type,
+		    const char *help)
+{
+	xstrfmtcat(*out, "# TYPE %s %s\n# HELP %s %s\n",
+		   name, type, name, help);
+}
+
+static void _usec(char **out, const char *name, const char *labels,
+		  uint64_t usec)
+{
+	xstrfmtcat(*out, "%s%s %.6f\n", name, (labels ? labels : ""),
+		   (usec / (double) USEC_IN_SEC));
+}
+
+static void _quantiles(char **out, const char *name, const char *rpc,
+		       uint32_t *pct)
+{
+	static const char *quantile[] = { "0.5", "0.9", "0.99" };
+
+	for (int i = 0; i < ARRAY_SIZE(quantile); i++)
+		xstrfmtcat(*out, "%s{%s%squantile=\"%s\"} %.6f\n", name,
+			   (rpc ? rpc : ""), (rpc ? "," : ""), quantile[i],
+			   (pct[i] / (double) USEC_IN_SEC));
+}
+
+static void _dump_scheduler(char **out, stats_info_response_msg_t *s)
+{
+	_family(out, "slurm_server_threads", "gauge",
+		"Active slurmctld server threads");
+	xstrfmtcat(*out, "slurm_server_threads %u\n", s->server_thread_count);
+	_family(out, "slurm_agent_queue_size", "gauge",
+		"Outgoing RPCs queued by the slurmctld agent");
+	xstrfmtcat(*out, "slurm_agent_queue_size %u\n", s->agent_queue_size);
+	_family(out, "slurm_dbd_agent_queue_size", "gauge",
+		"Messages queued for slurmdbd");
+	xstrfmtcat(*out, "slurm_dbd_agent_queue_size %u\n",
+		   s->dbd_agent_queue_size);
+
+	_family(out, "slurm_jobs", "gauge", "Jobs by state");
+	xstrfmtcat(*out, "slurm_jobs{state=\"pending\"} %u\n",
+		   s->jobs_pending);
+	xstrfmtcat(*out, "slurm_jobs{state=\"running\"} %u\n",
+		   s->jobs_running);
+	_family(out, "slurm_job_events", "counter",
+		"Job state changes since statistics were reset");
+	xstrfmtcat(*out, "slurm_job_events_total{event=\"submitted\"} %u\n",
+		   s->jobs_submitted);
+	xstrfmtcat(*out, "slurm_job_events_total{event=\"started\"} %u\n",
+		   s->jobs_started);
+	xstrfmtcat(*out, "slurm_job_events_total{event=\"completed\"} %u\n",
+		   s->jobs_completed);
+	xstrfmtcat(*out, "slurm_job_events_total{event=\"canceled\"} %u\n",
+		   s->jobs_canceled);
+	xstrfmtcat(*out, "slurm_job_events_total{event=\"failed\"} %u\n",
+		   s->jobs_failed);
+
+	_family(out, "slurm_schedule_cycles", "counter",
+		"Main scheduler cycles");
+	xstrfmtcat(*out, "slurm_schedule_cycles_total %u\n",
+		   s->schedule_cycle_counter);
+	_family(out, "slurm_schedule_cycle_seconds", "counter",
+		"Time spent in main scheduler cycles");
+	_usec(out, "slurm_schedule_cycle_seconds_total", NULL,
+	      s->schedule_cycle_sum);
+	_family(out, "slurm_schedule_cycle_last_seconds", "gauge",
+		"Duration of the last main scheduler cycle");
+	_usec(out, "slurm_schedule_cycle_last_seconds", NULL,
+	      s->schedule_cycle_last);
+	_family(out, "slurm_schedule_queue_length", "gauge",
+		"Jobs considered by the last main scheduler cycle");
+	xstrfmtcat(*out, "slurm_schedule_queue_length %u\n",
+		   s->schedule_queue_len);
+
+	_family(out, "slurm_backfill_cycles", "counter", "Backfill cycles");
+	xstrfmtcat(*out, "slurm_backfill_cycles_total %u\n",
+		   s->bf_cycle_counter);
+	_family(out, "slurm_backfill_cycle_seconds", "counter",
+		"Time spent in backfill cycles");
+	_usec(out, "slurm_backfill_cycle_seconds_total", NULL,
+	      s->bf_cycle_sum);
+	_family(out, "slurm_backfill_cycle_last_seconds", "gauge",
+		"Duration of the last backfill cycle");
+	_usec(out, "slurm_backfill_cycle_last_seconds", NULL,
+	      s->bf_cycle_last);
+	_family(out, "slurm_backfill_jobs", "counter",
+		"Jobs started by the backfill scheduler");
+	xstrfmtcat(*out, "slurm_backfill_jobs_total %u\n",
+		   s->bf_backfilled_jobs);
+	_family(out, "slurm_backfill_queue_length", "gauge",
+		"Jobs considered by the last backfill cycle");
+	xstrfmtcat(*out, "slurm_backfill_queue_length %u\n", s->bf_queue_len);
+	_family(out, "slurm_backfill_active", "gauge",
+		"Whether a backfill cycle is running");
+	xstrfmtcat(*out, "slurm_backfill_active %u\n", s->bf_active);
+}
+
+static void _dump_rpcs(char **out, stats_info_response_msg_t *s)
+{
+	_family(out, "slurm_rpcs", "counter", "RPCs processed by type");
+	for (int i = 0; i < s->rpc_type_size; i++)
+		xstrfmtcat(*out, "slurm_rpcs_total{rpc=\"%s\"} %u\n",
+			   rpc_num2string(s->rpc_type_id[i]),
+			   s->rpc_type_cnt[i]);
+	_family(out, "slurm_rpc_seconds", "counter",
+		"Time spent processing RPCs by type");
+	for (int i = 0; i < s->rpc_type_size; i++) {
+		char *label = xstrdup_printf("{rpc=\"%s\"}",
+					     rpc_num2string(s->rpc_type_id[i]));
+		_usec(out, "slurm_rpc_seconds_total", label,
+		      s->rpc_type_time[i]);
+		xfree(label);
+	}
+
+	_family(out, "slurm_user_rpcs", "counter", "RPCs processed by user");
+	for (int i = 0; i < s->rpc_user_size; i++) {
+		char *user = _label_value(
+			uid_to_string_cached(s->rpc_user_id[i]));
+
+		xstrfmtcat(*out, "slurm_user_rpcs_total{user=\"%s\"} %u\n",
+			   user, s->rpc_user_cnt[i]);
+		xfree(user);
+	}
+
+	_family(out, "slurm_rpc_exec_seconds", "summary",
+		"Recent RPC execution time, excluding slurmctld lock wait");
+	for (int i = 0; i < s->rpc_lat_cnt; i++) {
+		char *rpc = xstrdup_printf("rpc=\"%s\"",
+					   rpc_num2string(s->rpc_lat_type_id[i]));
+		_quantiles(out, "slurm_rpc_exec_seconds", rpc,
+			   &s->rpc_lat_exec[i * 4]);
+		xfree(rpc);
+	}
+	_family(out, "slurm_rpc_lock_wait_seconds", "summary",
+		"Recent slurmctld lock wait time of RPCs");
+	for (int i = 0; i < s->rpc_lat_cnt; i++) {
+		char *rpc = xstrdup_printf("rpc=\"%s\"",
+					   rpc_num2string(s->rpc_lat_type_id[i]));
+		_quantiles(out, "slurm_rpc_lock_wait_seconds", rpc,
+			   &s->rpc_lat_wait[i * 4]);
+		xstrfmtcat(*out, "slurm_rpc_lock_wait_seconds_sum{%s} %.6f\n",
+			   rpc, (s->rpc_lat_wait_sum[i] / (double) USEC_IN_SEC));
+		xfree(rpc);
+	}
+	_family(out, "slurm_rpc_queue_delay_seconds", "summary",
+		"Recent time from accepting a connection to processing its RPC");
+	_quantiles(out, "slurm_rpc_queue_delay_seconds", NULL, s->rpc_delay);
+	xstrfmtcat(*out, "slurm_rpc_queue_delay_seconds_count %"PRIu64"\n",
+		   s->rpc_delay_cnt);
+	_usec(out, "slurm_rpc_queue_delay_seconds_sum", NULL,
+	      s->rpc_delay_sum);
+}
+
+static int _dump_nodes(char **out, node_info_msg_t *nodes)
+{
+	uint32_t state_cnt[NODE_STATE_END] = { 0 };
+	uint32_t drain_cnt = 0, no_resp_cnt = 0;
+	uint64_t cpus = 0, alloc_cpus = 0, mem = 0, alloc_mem = 0;
+
+	for (int i = 0; i < nodes->record_count; i++) {
+		node_info_t *node = &nodes->node_array[i];
+		uint16_t node_alloc_cpus = 0;
+		uint64_t node_alloc_mem = 0;
+		int rc;
+
+		if (!node->name)
+			continue;
+
+		if ((node->node_state & NODE_STATE_BASE) < NODE_STATE_END)
+			state_cnt[node->node_state & NODE_STATE_BASE]++;
+		if (node->node_state & NODE_STATE_DRAIN)
+			drain_cnt++;
+		if (node->node_state & NODE_STATE_NO_RESPOND)
+			no_resp_cnt++;
+
+		if ((rc = slurm_get_select_nodeinfo(
+			     node->select_nodeinfo, SELECT_NODEDATA_SUBCNT,
+			     NODE_STATE_ALLOCATED, &node_alloc_cpus)) ||
+		    (rc = slurm_get_select_nodeinfo(
+			     node->select_nodeinfo, SELECT_NODEDATA_MEM_ALLOC,
+			     NODE_STATE_ALLOCATED, &node_alloc_mem))) {
+			error("%s: slurm_get_select_nodeinfo(%s): %s",
+			      __func__, node->name, slurm_strerror(rc));
+			return rc;
+		}
+
+		cpus += node->cpus;
+		alloc_cpus += node_alloc_cpus;
+		mem += node->real_memory;
+		alloc_mem += node_alloc_mem;
+	}
+
+	_family(out, "slurm_nodes", "gauge", "Nodes by base state");
+	for (int i = 0; i < NODE_STATE_END; i++) {
+		char *state = xstrdup(node_state_string(i));
+
+		xstrtolower(state);
+		xstrfmtcat(*out, "slurm_nodes{state=\"%s\"} %u\n",
+			   state, state_cnt[i]);
+		xfree(state);
+	}
+	_family(out, "slurm_nodes_flagged", "gauge", "Nodes by state flag");
+	xstrfmtcat(*out, "slurm_nodes_flagged{flag=\"drain\"} %u\n",
+		   drain_cnt);
+	xstrfmtcat(*out, "slurm_nodes_flagged{flag=\"not_responding\"} %u\n",
+		   no_resp_cnt);
+
+	_family(out, "slurm_cpus", "gauge", "CPUs of all nodes");
+	xstrfmtcat(*out, "slurm_cpus{state=\"total\"} %"PRIu64"\n", cpus);
+	xstrfmtcat(*out, "slurm_cpus{state=\"allocated\"} %"PRIu64"\n",
+		   alloc_cpus);
+	_family(out, "slurm_memory_bytes", "gauge", "Memory of all nodes");
+	xstrfmtcat(*out, "slurm_memory_bytes{state=\"total\"} %"PRIu64"\n",
+		   (mem * 1024 * 1024));
+	xstrfmtcat(*out, "slurm_memory_bytes{state=\"allocated\"} %"PRIu64"\n",
+		   (alloc_mem * 1024 * 1024));
+
+	return SLURM_SUCCESS;
+}
+
+static void _dump_partitions(char **out, partition_info_msg_t *parts)
+{
+	char **names = xcalloc(parts->record_count, sizeof(*names));
+
+	for (int i = 0; i < parts->record_count; i++)
+		names[i] = _label_value(parts->partition_array[i].name);
+
+	_family(out, "slurm_partition_nodes", "gauge", "Nodes in partition");
+	for (int i = 0; i < parts->record_count; i++)
+		xstrfmtcat(*out, "slurm_partition_nodes{partition=\"%s\"} %u\n",
+			   names[i], parts->partition_array[i].total_nodes);
+	_family(out, "slurm_partition_cpus", "gauge", "CPUs in partition");
+	for (int i = 0; i < parts->record_count; i++)
+		xstrfmtcat(*out, "slurm_partition_cpus{partition=\"%s\"} %u\n",
+			   names[i], parts->partition_array[i].total_cpus);
+	_family(out, "slurm_partition_up", "gauge",
+		"Whether partition accepts and schedules jobs");
+	for (int i = 0; i < parts->record_count; i++)
+		xstrfmtcat(*out, "slurm_partition_up{partition=\"%s\"} %d\n",
+			   names[i],
+			   (parts->partition_array[i].state_up == PARTITION_UP));
+
+	for (int i = 0; i < parts->record_count; i++)
+		xfree(names[i]);
+	xfree(names);
+}
+
+/* Query slurmctld as the requester and render the metrics into out */
+static int _collect(time_t now, char **out)
+{
+	stats_info_request_msg_t req = { .command_id = STAT_COMMAND_GET };
+	stats_info_response_msg_t *stats = NULL;
+	node_info_msg_t *nodes = NULL;
+	partition_info_msg_t *parts = NULL;
+	int rc;
+
+	if ((rc = slurm_get_statistics(&stats, &req)) ||
+	    (rc = slurm_load_node(0, &nodes, SHOW_ALL)) ||
+	    (rc = slurm_load_partitions(0, &parts, SHOW_ALL))) {
+		if (!(rc = errno))
+			rc = SLURM_ERROR;
+		goto fail;
+	}
+
+	_dump_scheduler(out, stats);
+	_dump_rpcs(out, stats);
+	if ((rc = _dump_nodes(out, nodes)))
+		goto fail;
+	_dump_partitions(out, parts);
+
+	_family(out, "slurm_metrics_refresh_timestamp_seconds", "gauge",
+		"Time metrics were last taken from slurmctld");
+	xstrfmtcat(*out, "slurm_metrics_refresh_timestamp_seconds %ld\n",
+		   (long) now);
+	xstrcat(*out, "# EOF\n");
+
+fail:
+	if (rc) {
+		error("%s: unable to collect metrics: %s",
+		      __func__, slurm_strerror(rc));
+		xfree(*out);
+	}
+	slurm_free_stats_response_msg(stats);
+	slurm_free_node_info_msg(nodes);
+	slurm_free_partition_info_msg(parts);
+
+	return rc;
+}
+
+/* Take a new snapshot from slurmctld, cache_lock must be held */
+static void _refresh(time_t now)
+{
+	cache_time = now;
+
+	/* Do not serve stale metrics as current */
+	xfree(cache);
+	cache_rc = _collect(now, &cache);
+}
+
+static int _op_handler_metrics(const char *context_id,
+			       http_request_method_t method,
+			       data_t *parameters, data_t *query, int tag,
+			       data_t *resp, rest_auth_context_t *auth)
+{
+	int rc;
+	time_t now = time(NULL);
+
+	if (slurm_conf.private_data &
+	    (PRIVATE_DATA_NODES | PRIVATE_DATA_PARTITIONS)) {
+		char *out = NULL;
+
+		if (!(rc = _collect(now, &out)))
+			data_set_string_own(resp, out);
+		return rc;
+	}
+
+	slurm_mutex_lock(&cache_lock);
+	if ((now < cache_time) || ((now - cache_time) >= refresh_interval))
+		_refresh(now);
+	if (!(rc = cache_rc))
+		data_set_string(resp, cache);
+	slurm_mutex_unlock(&cache_lock);
+
+	return rc;
+}
+
+extern data_t *slurm_openapi_p_get_specification(void)
+{
+	data_t *spec = NULL;
+
+	static_ref_json_to_data_t(spec, openapi_json);
+
+	return spec;
+}
+
+extern void slurm_openapi_p_init(void)
+{
+	char *buffer;
+
+	if ((buffer = getenv("SLURMRESTD_METRICS_INTERVAL"))) {
+		char *end = NULL;
+		long interval = strtol(buffer, &end, 10);
+
+		if (!buffer[0] || (end && end[0]) || (interval < 0) ||
+		    (interval > INT_MAX))
+			fatal("Invalid env SLURMRESTD_METRICS_INTERVAL: %s",
+			      buffer);
+		refresh_interval = interval;
+	}
+
+	bind_operation_raw_handler("/metrics", _op_handler_metrics, 0,
+				   METRICS_MIME_TYPE);
+}
+
+extern void slurm_openapi_p_fini(void)
+{
+	unbind_operation_handler(_op_handler_metrics);
+
+	slurm_mutex_lock(&cache_lock);
+	xfree(cache);
+	cache_time = 0;
+	slurm_mutex_unlock(&cache_lock);
+}
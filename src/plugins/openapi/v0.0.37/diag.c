@@ -44,6 +44,7 @@
 #include "src/common/log.h"
 #include "src/common/read_config.h"
 #include "src/common/ref.h"
+#include "src/common/slurm_protocol_defs.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -64,6 +65,8 @@ static int _op_handler_diag(const char *context_id,
 			    rest_auth_context_t *auth)
 {
 	int rc;
+	uint32_t i, j, k;
+	data_t *locks, *holders, *queues, *sibs, *lat, *delay;
 	stats_info_response_msg_t *resp = NULL;
 	stats_info_request_msg_t *req = xmalloc(sizeof(*req));
 	req->command_id = STAT_COMMAND_GET;
@@ -85,6 +88,8 @@ static int _op_handler_diag(const char *context_id,
 	data_set_int(data_key_set(d, "agent_count"), resp->agent_count);
 	data_set_int(data_key_set(d, "agent_thread_count"),
 		     resp->agent_thread_count);
+	data_set_int(data_key_set(d, "agent_merge_count"),
+		     resp->agent_merge_count);
 	data_set_int(data_key_set(d, "dbd_agent_queue_size"),
 		     resp->dbd_agent_queue_size);
 	data_set_int(data_key_set(d, "gettimeofday_latency"),
@@ -109,6 +114,14 @@ static int _op_handler_diag(const char *context_id,
 		      ((resp->req_time - resp->req_time_start) / 60))) : 0));
 	data_set_int(data_key_set(d, "schedule_queue_length"),
 		     resp->schedule_queue_len);
+	data_set_int(data_key_set(d, "schedule_queue_build_mean"),
+		     (resp->schedule_cycle_counter ?
+		      (resp->schedule_queue_build_sum /
+		       resp->schedule_cycle_counter) : 0));
+	data_set_int(data_key_set(d, "schedule_select_mean"),
+		     (resp->schedule_cycle_counter ?
+		      (resp->schedule_select_sum /
+		       resp->schedule_cycle_counter) : 0));
 	data_set_int(data_key_set(d, "jobs_submitted"), resp->jobs_submitted);
 	data_set_int(data_key_set(d, "jobs_started"), resp->jobs_started);
 	data_set_int(data_key_set(d, "jobs_completed"), resp->jobs_completed);
@@ -143,6 +156,134 @@ static int _op_handler_diag(const char *context_id,
 	data_set_int(data_key_set(d, "bf_when_last_cycle"),
 		     resp->bf_when_last_cycle);
 	data_set_bool(data_key_set(d, "bf_active"), (resp->bf_active != 0));
+	data_set_int(data_key_set(d, "bf_queue_build_mean"),
+		     (resp->bf_cycle_counter > 0) ?
+		      (resp->bf_queue_build_sum / resp->bf_cycle_counter) : 0);
+	data_set_int(data_key_set(d, "bf_select_mean"),
+		     (resp->bf_cycle_counter > 0) ?
+		      (resp->bf_select_sum / resp->bf_cycle_counter) : 0);
+	data_set_int(data_key_set(d, "bf_yield_mean"),
+		     (resp->bf_cycle_counter > 0) ?
+		      (resp->bf_yield_sum / resp->bf_cycle_counter) : 0);
+
+	locks = data_set_list(data_key_set(d, "lock_statistics"));
+	for (i = 0; i < resp->lock_stats_cnt; i++) {
+		data_t *l = data_set_dict(data_list_append(locks));
+		data_t *wait_hist, *hold_hist;
+
+		data_set_string(data_key_set(l, "name"), resp->lock_name[i]);
+		data_set_int(data_key_set(l, "count"), resp->lock_count[i]);
+		data_set_int(data_key_set(l, "wait_time_total"),
+			     resp->lock_wait_sum[i]);
+		data_set_int(data_key_set(l, "wait_time_max"),
+			     resp->lock_wait_max[i]);
+		data_set_int(data_key_set(l, "hold_time_total"),
+			     resp->lock_hold_sum[i]);
+		data_set_int(data_key_set(l, "hold_time_max"),
+			     resp->lock_hold_max[i]);
+		wait_hist = data_set_list(data_key_set(l,
+						       "wait_time_histogram"));
+		hold_hist = data_set_list(data_key_set(l,
+						       "hold_time_histogram"));
+		for (j = 0; j < resp->lock_hist_cnt; j++) {
+			k = (i * resp->lock_hist_cnt) + j;
+			data_set_int(data_list_append(wait_hist),
+				     resp->lock_wait_hist[k]);
+			data_set_int(data_list_append(hold_hist),
+				     resp->lock_hold_hist[k]);
+		}
+	}
+
+	holders = data_set_list(data_key_set(d, "lock_holders"));
+	for (i = 0; i < resp->lock_holder_cnt; i++) {
+		data_t *h = data_set_dict(data_list_append(holders));
+
+		data_set_string(data_key_set(h, "function"),
+				resp->lock_holder_caller[i]);
+		if (resp->lock_holder_rpc_type[i])
+			data_set_string(data_key_set(h, "rpc"),
+					rpc_num2string(
+						resp->lock_holder_rpc_type[i]));
+		else
+			data_set_null(data_key_set(h, "rpc"));
+		data_set_int(data_key_set(h, "count"),
+			     resp->lock_holder_count[i]);
+		data_set_int(data_key_set(h, "hold_time_total"),
+			     resp->lock_holder_hold_sum[i]);
+		data_set_int(data_key_set(h, "hold_time_max"),
+			     resp->lock_holder_hold_max[i]);
+	}
+
+	queues = data_set_list(data_key_set(d, "rpc_queues"));
+	for (i = 0; i < resp->rpcq_cnt; i++) {
+		data_t *q = data_set_dict(data_list_append(queues));
+
+		data_set_string(data_key_set(q, "rpc"),
+				rpc_num2string(resp->rpcq_type_id[i]));
+		data_set_int(data_key_set(q, "depth"), resp->rpcq_depth[i]);
+		data_set_int(data_key_set(q, "depth_max"),
+			     resp->rpcq_depth_max[i]);
+		data_set_int(data_key_set(q, "count"), resp->rpcq_msg_cnt[i]);
+		data_set_int(data_key_set(q, "batches"),
+			     resp->rpcq_batch_cnt[i]);
+		data_set_int(data_key_set(q, "batch_max"),
+			     resp->rpcq_batch_max[i]);
+		data_set_int(data_key_set(q, "wait_time_total"),
+			     resp->rpcq_wait_sum[i]);
+		data_set_int(data_key_set(q, "wait_time_max"),
+			     resp->rpcq_wait_max[i]);
+	}
+
+	sibs = data_set_list(data_key_set(d, "federation_siblings"));
+	for (i = 0; i < resp->fed_sib_cnt; i++) {
+		data_t *f = data_set_dict(data_list_append(sibs));
+
+		data_set_string(data_key_set(f, "cluster"),
+				resp->fed_sib_name[i]);
+		data_set_int(data_key_set(f, "queued"), resp->fed_sib_depth[i]);
+		data_set_int(data_key_set(f, "count"),
+			     resp->fed_sib_msg_cnt[i]);
+		data_set_int(data_key_set(f, "messages"),
+			     resp->fed_sib_batch_cnt[i]);
+		data_set_int(data_key_set(f, "batch_max"),
+			     resp->fed_sib_batch_max[i]);
+		data_set_int(data_key_set(f, "failed"),
+			     resp->fed_sib_fail_cnt[i]);
+		data_set_int(data_key_set(f, "lag_total"),
+			     resp->fed_sib_lag_sum[i]);
+		data_set_int(data_key_set(f, "lag_max"),
+			     resp->fed_sib_lag_max[i]);
+		data_set_int(data_key_set(f, "lag_current"),
+			     resp->fed_sib_lag_now[i]);
+	}
+
+	lat = data_set_list(data_key_set(d, "rpc_latency"));
+	for (i = 0; i < resp->rpc_lat_cnt; i++) {
+		data_t *l = data_set_dict(data_list_append(lat));
+		uint32_t *exec = &resp->rpc_lat_exec[i * 4];
+		uint32_t *wait = &resp->rpc_lat_wait[i * 4];
+
+		data_set_string(data_key_set(l, "rpc"),
+				rpc_num2string(resp->rpc_lat_type_id[i]));
+		data_set_int(data_key_set(l, "exec_p50"), exec[0]);
+		data_set_int(data_key_set(l, "exec_p90"), exec[1]);
+		data_set_int(data_key_set(l, "exec_p99"), exec[2]);
+		data_set_int(data_key_set(l, "exec_max"), exec[3]);
+		data_set_int(data_key_set(l, "lock_wait_p50"), wait[0]);
+		data_set_int(data_key_set(l, "lock_wait_p90"), wait[1]);
+		data_set_int(data_key_set(l, "lock_wait_p99"), wait[2]);
+		data_set_int(data_key_set(l, "lock_wait_max"), wait[3]);
+		data_set_int(data_key_set(l, "lock_wait_total"),
+			     resp->rpc_lat_wait_sum[i]);
+	}
+
+	delay = data_set_dict(data_key_set(d, "rpc_queue_delay"));
+	data_set_int(data_key_set(delay, "count"), resp->rpc_delay_cnt);
+	data_set_int(data_key_set(delay, "total"), resp->rpc_delay_sum);
+	data_set_int(data_key_set(delay, "p50"), resp->rpc_delay[0]);
+	data_set_int(data_key_set(delay, "p90"), resp->rpc_delay[1]);
+	data_set_int(data_key_set(delay, "p99"), resp->rpc_delay[2]);
+	data_set_int(data_key_set(delay, "max"), resp->rpc_delay[3]);
 
 cleanup:
 	if (rc) {
@@ -59,6 +59,7 @@
 #include "src/common/strlcpy.h"
 #include "src/common/tres_bind.h"
 #include "src/common/tres_frequency.h"
+#include "src/common/uid.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
@@ -253,6 +254,7 @@ typedef enum {
 	URL_TAG_JOBS,
 	URL_TAG_JOB,
 	URL_TAG_JOB_SUBMIT,
+	URL_TAG_JOB_SCHED_TRACE,
 } url_tag_t;
 
 typedef struct {
@@ -1159,32 +1161,120 @@ static data_t *dump_job_info(slurm_job_info_t *job, data_t *jd)
 	return jd;
 }
 
+/* Get an optional string query parameter, RET NULL if not given */
+static char *_get_str_param(data_t *query, const char *param)
+{
+	data_t *data = data_key_get(query, param);
+
+	if (!data ||
+	    (data_convert_type(data, DATA_TYPE_STRING) != DATA_TYPE_STRING))
+		return NULL;
+
+	return xstrdup(data_get_string(data));
+}
+
+/*
+ * Parse the "states" and "users" query parameters into the lists of
+ * slurm_load_jobs_filter(), which slurmctld applies before packing jobs.
+ */
+static int _get_job_filter_lists(data_t *query, data_t *errors,
+				 List *state_list, List *uid_list)
+{
+	char *str, *tok, *save_ptr = NULL;
+	uint32_t *uint32_ptr;
+	uid_t uid;
+	int rc = SLURM_SUCCESS;
+
+	if ((str = _get_str_param(query, "states"))) {
+		*state_list = list_create(xfree_ptr);
+		tok = strtok_r(str, ",", &save_ptr);
+		while (tok) {
+			uint32_ptr = xmalloc(sizeof(uint32_t));
+			*uint32_ptr = job_state_num(tok);
+			list_append(*state_list, uint32_ptr);
+			if (*uint32_ptr == NO_VAL) {
+				rc = resp_error(errors,
+						ESLURM_REST_INVALID_QUERY,
+						"HTTP request: states",
+						"invalid job state: %s", tok);
+				break;
+			}
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(str);
+	}
+
+	save_ptr = NULL;
+	if (!rc && (str = _get_str_param(query, "users"))) {
+		*uid_list = list_create(xfree_ptr);
+		tok = strtok_r(str, ",", &save_ptr);
+		while (tok) {
+			if (uid_from_string(tok, &uid) < 0) {
+				rc = resp_error(errors,
+						ESLURM_REST_INVALID_QUERY,
+						"HTTP request: users",
+						"invalid user: %s", tok);
+				break;
+			}
+			uint32_ptr = xmalloc(sizeof(uint32_t));
+			*uint32_ptr = uid;
+			list_append(*uid_list, uint32_ptr);
+			tok = strtok_r(NULL, ",", &save_ptr);
+		}
+		xfree(str);
+	}
+
+	return rc;
+}
+
+/*
+ * Jobs are streamed one at a time instead of building a data_t tree of all
+ * jobs, which can be very large.
+ */
 static int _op_handler_jobs(const char *context_id,
 			    http_request_method_t method,
 			    data_t *parameters, data_t *query, int tag,
-			    data_t *resp, rest_auth_context_t *auth)
+			    data_stream_t *resp, rest_auth_context_t *auth)
 {
 	int rc = SLURM_SUCCESS;
 	job_info_msg_t *job_info_ptr = NULL;
-	data_t *errors = populate_response_format(resp);
-	data_t *jobs = data_set_list(data_key_set(resp, "jobs"));
+	data_t *hdr = data_new();
+	data_t *errors = populate_response_format(hdr);
 	time_t update_time = 0; /* default to unix epoch */
+	char *accounts = NULL, *partitions = NULL;
+	List state_list = NULL, uid_list = NULL;
 
 	debug4("%s: jobs handler called by %s", __func__, context_id);
 
+	data_stream_dict_begin(resp);
+	data_stream_key(resp, "meta");
+	data_stream_value(resp, data_key_get(hdr, "meta"));
+	data_stream_key(resp, "jobs");
+	data_stream_list_begin(resp);
+
 	if ((rc = get_date_param(query, "update_time", &update_time)))
 	    goto done;
 
-	rc = slurm_load_jobs(update_time, &job_info_ptr,
-			     SHOW_ALL | SHOW_DETAIL);
+	if ((rc = _get_job_filter_lists(query, errors, &state_list,
+					&uid_list)))
+		goto done;
+	accounts = _get_str_param(query, "accounts");
+	partitions = _get_str_param(query, "partitions");
+
+	rc = slurm_load_jobs_filter(update_time, &job_info_ptr,
+				    SHOW_ALL | SHOW_DETAIL, accounts, NULL,
+				    partitions, state_list, uid_list);
 
 	if (rc == SLURM_NO_CHANGE_IN_DATA) {
 		/* no-op: nothing to do here */
 	} else if ((rc == SLURM_SUCCESS) && job_info_ptr &&
 		   job_info_ptr->record_count) {
 		for (size_t i = 0; i < job_info_ptr->record_count; ++i) {
-			dump_job_info(job_info_ptr->job_array + i,
-				      data_list_append(jobs));
+			data_t *job = data_new();
+
+			dump_job_info(job_info_ptr->job_array + i, job);
+			data_stream_value(resp, job);
+			FREE_NULL_DATA(job);
 		}
 	} else if (rc) {
 		resp_error(errors, rc, "slurm_load_jobs",
@@ -1192,7 +1282,17 @@ static int _op_handler_jobs(const char *context_id,
 	}
 
 done:
+	data_stream_end(resp);
+	data_stream_key(resp, "errors");
+	data_stream_value(resp, errors);
+	data_stream_end(resp);
+
+	FREE_NULL_DATA(hdr);
 	slurm_free_job_info_msg(job_info_ptr);
+	xfree(accounts);
+	xfree(partitions);
+	FREE_NULL_LIST(state_list);
+	FREE_NULL_LIST(uid_list);
 
 	return rc;
 }
@@ -1222,6 +1322,52 @@ static int _handle_job_get(const char *context_id, http_request_method_t method,
 	return rc;
 }
 
+static int _handle_job_sched_trace_get(const char *context_id,
+				       http_request_method_t method,
+				       data_t *parameters, data_t *query,
+				       int tag, data_t *resp,
+				       const uint32_t job_id,
+				       data_t *const errors)
+{
+	int rc;
+	sched_trace_msg_t *trace_msg = NULL;
+	data_t *attempts;
+
+	if ((rc = slurm_load_job_sched_trace(job_id, &trace_msg)))
+		return resp_error(errors, errno, "slurm_load_job_sched_trace",
+				  "Failed while looking for job: %u", job_id);
+
+	data_set_int(data_key_set(resp, "job_id"), trace_msg->job_id);
+	data_set_int(data_key_set(resp, "attempt_count"),
+		     trace_msg->attempts);
+	data_set_int(data_key_set(resp, "total_usec"), trace_msg->total_usec);
+	attempts = data_set_list(data_key_set(resp, "attempts"));
+
+	for (int i = 0; i < trace_msg->record_count; i++) {
+		sched_trace_rec_t *rec = &trace_msg->trace_array[i];
+		data_t *d = data_set_dict(data_list_append(attempts));
+
+		data_set_int(data_key_set(d, "time"), rec->time);
+		data_set_string(data_key_set(d, "scheduler"),
+				((rec->scheduler == SCHED_TRACE_BACKFILL) ?
+				 "backfill" : "main"));
+		data_set_string(data_key_set(d, "reason"),
+				job_reason_string(rec->reason));
+		data_set_string(data_key_set(d, "result"),
+				slurm_strerror(rec->error_code));
+		data_set_int(data_key_set(d, "total_usec"), rec->total_usec);
+		data_set_int(data_key_set(d, "select_usec"), rec->select_usec);
+		data_set_int(data_key_set(d, "accounting_policy_usec"),
+			     rec->acct_usec);
+		data_set_int(data_key_set(d, "reservation_usec"),
+			     rec->resv_usec);
+	}
+
+	slurm_free_sched_trace_msg(trace_msg);
+
+	return SLURM_SUCCESS;
+}
+
 static int _handle_job_delete(const char *context_id,
 			      http_request_method_t method,
 			      data_t *parameters, data_t *query, int tag,
@@ -1345,6 +1491,11 @@ static int _op_handler_job(const char *context_id, http_request_method_t method,
 	} else if (tag == URL_TAG_JOB && method == HTTP_REQUEST_GET) {
 		rc = _handle_job_get(context_id, method, parameters, query, tag,
 				     resp, job_id, errors);
+	} else if (tag == URL_TAG_JOB_SCHED_TRACE &&
+		   method == HTTP_REQUEST_GET) {
+		rc = _handle_job_sched_trace_get(context_id, method, parameters,
+						 query, tag, resp, job_id,
+						 errors);
 	} else if (tag == URL_TAG_JOB &&
 		   method == HTTP_REQUEST_DELETE) {
 		int signal = 0;
@@ -1571,10 +1722,12 @@ extern void init_op_jobs(void)
 			      __func__);
 	}
 
-	bind_operation_handler("/slurm/v0.0.37/jobs/", _op_handler_jobs,
-			       URL_TAG_JOBS);
+	bind_operation_stream_handler("/slurm/v0.0.37/jobs/",
+				      _op_handler_jobs, URL_TAG_JOBS);
 	bind_operation_handler("/slurm/v0.0.37/job/{job_id}", _op_handler_job,
 			       URL_TAG_JOB);
+	bind_operation_handler("/slurm/v0.0.37/job/{job_id}/sched_trace",
+			       _op_handler_job, URL_TAG_JOB_SCHED_TRACE);
 	bind_operation_handler("/slurm/v0.0.37/job/submit",
 			       _op_handler_submit_job, URL_TAG_JOB_SUBMIT);
 }
@@ -1588,5 +1741,5 @@ extern void destroy_op_jobs(void)
 
 	unbind_operation_handler(_op_handler_submit_job);
 	unbind_operation_handler(_op_handler_job);
-	unbind_operation_handler(_op_handler_jobs);
+	unbind_operation_stream_handler(_op_handler_jobs);
 }
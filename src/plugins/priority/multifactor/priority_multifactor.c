@@ -147,9 +147,30 @@ static uint32_t flags;       /* Priority Flags */
 static time_t g_last_ran = 0; /* when the last poll ran */
 static double decay_factor = 1; /* The decay factor when decaying time. */
 
+/*
+ * Priority factors of the eligible jobs, one record per job and partition,
+ * from which sprio requests are served without the job locks. The cache is
+ * rebuilt by the decay thread if it was used since the previous pass, or on
+ * request if job or partition records changed since it was built.
+ */
+typedef struct {
+	priority_factors_object_t obj;	/* partition owned by the record */
+	char *account;
+	char *mcs_label;
+} prio_cache_rec_t;
+
+static pthread_mutex_t prio_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static List prio_cache_list = NULL;	/* prio_cache_rec_t list */
+static time_t prio_cache_time = 0;	/* when prio_cache_list was built */
+static time_t prio_cache_expire = 0;	/* a pending job becomes eligible */
+static bool prio_cache_used = false;
+static uint32_t prio_calc_gen = 0;	/* bumped by each decay pass */
+static uint32_t prio_cache_gen = 0;	/* prio_calc_gen of prio_cache_list */
+
 /* variables defined in priority_multifactor.h */
 
 static void _priority_p_set_assoc_usage_debug(slurmdb_assoc_rec_t *assoc);
+static void _refresh_prio_cache(void);
 static void _set_assoc_usage_efctv(slurmdb_assoc_rec_t *assoc);
 
 /*
@@ -404,24 +425,21 @@ static int _set_children_usage_efctv(List children_list)
 
 /* job_ptr should already have the partition priority and such added here
  * before had we will be adding to it
+ *
+ * NOTE: acct_mgr_assoc_lock must be locked before this is called.
  */
 static double _get_fairshare_priority(job_record_t *job_ptr)
 {
 	slurmdb_assoc_rec_t *job_assoc;
 	slurmdb_assoc_rec_t *fs_assoc = NULL;
 	double priority_fs = 0.0;
-	assoc_mgr_lock_t locks = { READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK,
-				   NO_LOCK, NO_LOCK, NO_LOCK };
 
 	if (!calc_fairshare)
 		return 0;
 
-	assoc_mgr_lock(&locks);
-
 	job_assoc = job_ptr->assoc_ptr;
 
 	if (!job_assoc) {
-		assoc_mgr_unlock(&locks);
 		error("Job %u has no association.  Unable to "
 		      "compute fairshare.", job_ptr->job_id);
 		return 0;
@@ -451,17 +469,16 @@ static double _get_fairshare_priority(job_record_t *job_ptr)
 			 fs_assoc->usage->usage_efctv,
 			 fs_assoc->usage->shares_norm, priority_fs);
 	}
-	assoc_mgr_unlock(&locks);
 
 	return priority_fs;
 }
 
-static void _get_tres_factors(job_record_t *job_ptr, part_record_t *part_ptr,
-			      double *tres_factors)
+/* Fill tres_values with the job's allocated (or else requested) TRES counts */
+static void _get_tres_values(job_record_t *job_ptr, double *tres_values)
 {
 	int i;
 
-	xassert(tres_factors);
+	xassert(tres_values);
 
 	/* can't memcpy because of different types
 	 * uint64_t vs. double */
@@ -472,18 +489,42 @@ static void _get_tres_factors(job_record_t *job_ptr, part_record_t *part_ptr,
 			value = job_ptr->tres_alloc_cnt[i];
 		else if (job_ptr->tres_req_cnt)
 			value = job_ptr->tres_req_cnt[i];
+		tres_values[i] = value;
+	}
+}
+
+/* Normalize the values from _get_tres_values() against part_ptr's TRES */
+static void _norm_tres_factors(double *tres_values, part_record_t *part_ptr,
+			       double *tres_factors)
+{
+	int i;
+
+	xassert(tres_factors);
+
+	if (flags & PRIORITY_FLAGS_NO_NORMAL_TRES) {
+		memcpy(tres_factors, tres_values,
+		       sizeof(double) * slurmctld_tres_cnt);
+		return;
+	}
+	if (!part_ptr || !part_ptr->tres_cnt)
+		return;
 
-		if (flags & PRIORITY_FLAGS_NO_NORMAL_TRES)
-			tres_factors[i] = value;
-		else if (value &&
-			 part_ptr &&
-			 part_ptr->tres_cnt &&
-			 part_ptr->tres_cnt[i])
-			tres_factors[i] = value /
+	for (i = 0; i < slurmctld_tres_cnt; i++) {
+		if (tres_values[i] && part_ptr->tres_cnt[i])
+			tres_factors[i] = tres_values[i] /
 				(double)part_ptr->tres_cnt[i];
 	}
 }
 
+static void _get_tres_factors(job_record_t *job_ptr, part_record_t *part_ptr,
+			      double *tres_factors)
+{
+	double tres_values[slurmctld_tres_cnt];
+
+	_get_tres_values(job_ptr, tres_values);
+	_norm_tres_factors(tres_values, part_ptr, tres_factors);
+}
+
 static double _get_tres_prio_weighted(double *tres_factors)
 {
 	int i;
@@ -590,6 +631,7 @@ static uint32_t _get_priority_internal(time_t start_time,
 	if (job_ptr->part_ptr_list) {
 		part_record_t *part_ptr;
 		double priority_part;
+		double tres_values[slurmctld_tres_cnt];
 		ListIterator part_iterator;
 		int i = 0;
 
@@ -598,6 +640,10 @@ static uint32_t _get_priority_internal(time_t start_time,
 			job_ptr->priority_array = xcalloc(i, sizeof(uint32_t));
 		}
 
+		/* The job's TRES counts are the same for every partition */
+		if (weight_tres)
+			_get_tres_values(job_ptr, tres_values);
+
 		i = 0;
 		list_sort(job_ptr->part_ptr_list, priority_sort_part_tier);
 		part_iterator = list_iterator_create(job_ptr->part_ptr_list);
@@ -608,8 +654,8 @@ static uint32_t _get_priority_internal(time_t start_time,
 				double part_tres_factors[slurmctld_tres_cnt];
 				memset(part_tres_factors, 0,
 				       sizeof(double) * slurmctld_tres_cnt);
-				_get_tres_factors(job_ptr, part_ptr,
-						  part_tres_factors);
+				_norm_tres_factors(tres_values, part_ptr,
+						   part_tres_factors);
 				part_tres = _get_tres_prio_weighted(
 							part_tres_factors);
 			}
@@ -1197,6 +1243,7 @@ static void *_decay_thread(void *no_data)
 	double run_delta = 0.0, real_decay = 0.0;
 	struct timeval tvnow;
 	struct timespec abs;
+	bool cache_used;
 
 	/* Write lock on jobs, read lock on nodes and partitions */
 	slurmctld_lock_t job_write_lock =
@@ -1373,6 +1420,19 @@ static void *_decay_thread(void *no_data)
 
 		_write_last_decay_ran(g_last_ran, last_reset);
 
+		/*
+		 * The priority factors were just recalculated without changing
+		 * last_job_update, so the snapshot is stale. Take a new one if
+		 * sprio asked for them since the last pass.
+		 */
+		slurm_mutex_lock(&prio_cache_lock);
+		prio_calc_gen++;
+		cache_used = prio_cache_used;
+		prio_cache_used = false;
+		slurm_mutex_unlock(&prio_cache_lock);
+		if (cache_used)
+			_refresh_prio_cache();
+
 		running_decay = 0;
 
 		/* Sleep until the next time. */
@@ -1386,135 +1446,211 @@ static void *_decay_thread(void *no_data)
 	return NULL;
 }
 
-/* If the specified job record satisfies the filter specifications in req_msg
- * and part_ptr_list (partition name filters), then add its priority specs
- * to ret_list */
-static void _filter_job(job_record_t *job_ptr,
-			priority_factors_request_msg_t *req_msg,
-			List part_ptr_list, List ret_list)
+/* Free a priority_factors_object_t which owns its partition name */
+static void _destroy_factors_obj(void *object)
 {
-	priority_factors_object_t *obj = NULL;
-	part_record_t *job_part_ptr = NULL, *filter_part_ptr = NULL;
-	List req_job_list, req_user_list;
-	int filter = 0, inx;
-	ListIterator iterator, job_iter, filter_iter;
-	uint32_t *job_id;
-	uint32_t *user_id;
+	priority_factors_object_t *obj = object;
 
-	/* Filter by job ID */
-	req_job_list = req_msg->job_id_list;
-	if (req_job_list) {
-		filter = 1;
-		iterator = list_iterator_create(req_job_list);
-		while ((job_id = list_next(iterator))) {
-			if (*job_id == job_ptr->job_id) {
-				filter = 0;
-				break;
-			}
-		}
-		list_iterator_destroy(iterator);
-		if (filter == 1)
-			return;
+	if (obj) {
+		xfree(obj->partition);
+		slurm_destroy_priority_factors_object(obj);
 	}
+}
 
-	/* Filter by user/UID */
-	req_user_list = req_msg->uid_list;
-	if (req_user_list) {
-		filter = 1;
-		iterator = list_iterator_create(req_user_list);
-		while ((user_id = list_next(iterator))) {
-			if (*user_id == job_ptr->user_id) {
-				filter = 0;
-				break;
-			}
-		}
-		list_iterator_destroy(iterator);
-		if (filter == 1)
-			return;
+static void _destroy_prio_cache_rec(void *object)
+{
+	prio_cache_rec_t *rec = object;
+
+	if (rec) {
+		xfree(rec->account);
+		xfree(rec->mcs_label);
+		xfree(rec->obj.partition);
+		xfree(rec->obj.priority_tres);
+		xfree(rec->obj.tres_names);
+		xfree(rec->obj.tres_weights);
+		xfree(rec);
 	}
+}
 
-	/*
-	 * Job is not in any partition, so there is nothing to return.
-	 * This can happen if the Partition was deleted, CALCULATE_RUNNING
-	 * is enabled, and this job is still waiting out MinJobAge before
-	 * being removed from the system.
-	 */
-	if (!job_ptr->part_ptr && !job_ptr->part_ptr_list)
-		return;
-
-	/* Filter by partition, job in one partition */
-	if (!job_ptr->part_ptr_list) {
-		job_part_ptr =  job_ptr->part_ptr;
-		filter = 0;
-		if (part_ptr_list) {
-			filter = 1;
-			filter_iter = list_iterator_create(part_ptr_list);
-			while ((filter_part_ptr = list_next(filter_iter))) {
-				if (filter_part_ptr == job_part_ptr) {
-					filter = 0;
-					break;
-				}
-			}
-			list_iterator_destroy(filter_iter);
-		}
+/* Add the priority factors of job_ptr in part_ptr to the cache list */
+static void _add_prio_cache_rec(job_record_t *job_ptr, part_record_t *part_ptr,
+				bool multi_part, List cache_list)
+{
+	prio_cache_rec_t *rec = xmalloc(sizeof(*rec));
+	priority_factors_object_t *obj = &rec->obj;
 
-		if (filter == 0) {
-			obj = xmalloc(sizeof(priority_factors_object_t));
-			if (job_ptr->direct_set_prio) {
-				obj->direct_prio = job_ptr->priority;
-			} else {
-				slurm_copy_priority_factors_object(obj,
-							job_ptr->prio_factors);
-			}
-			obj->job_id = job_ptr->job_id;
-			obj->partition = job_part_ptr->name;
-			obj->user_id = job_ptr->user_id;
-			list_append(ret_list, obj);
+	if (!multi_part && job_ptr->direct_set_prio) {
+		obj->direct_prio = job_ptr->priority;
+	} else {
+		slurm_copy_priority_factors_object(obj, job_ptr->prio_factors);
+		xfree(obj->partition);
+	}
+	if (multi_part) {
+		obj->priority_part =
+			((flags & PRIORITY_FLAGS_NO_NORMAL_PART) ?
+			 part_ptr->priority_job_factor :
+			 part_ptr->norm_priority) *
+			(double)weight_part;
+		if (obj->priority_tres) {
+			_get_tres_factors(job_ptr, part_ptr,
+					  obj->priority_tres);
+			_get_tres_prio_weighted(obj->priority_tres);
 		}
-		return;
 	}
+	obj->job_id = job_ptr->job_id;
+	obj->partition = xstrdup(part_ptr->name);
+	obj->user_id = job_ptr->user_id;
+	rec->account = xstrdup(job_ptr->account);
+	rec->mcs_label = xstrdup(job_ptr->mcs_label);
 
-	/* Filter by partition, job in multiple partitions */
-	inx = 0;
-	job_iter = list_iterator_create(job_ptr->part_ptr_list);
-	while ((job_part_ptr = list_next(job_iter))) {
-		filter = 0;
-		if (part_ptr_list) {
-			filter = 1;
-			filter_iter = list_iterator_create(part_ptr_list);
-			while ((filter_part_ptr = list_next(filter_iter))) {
-				if (filter_part_ptr == job_part_ptr) {
-					filter = 0;
-					break;
-				}
-			}
-			list_iterator_destroy(filter_iter);
+	list_append(cache_list, rec);
+}
+
+/*
+ * Rebuild the priority factors cache from the current job records.
+ * Takes the job and partition read locks, not to be called with
+ * prio_cache_lock held.
+ */
+static void _refresh_prio_cache(void)
+{
+	List cache_list = list_create(_destroy_prio_cache_rec);
+	ListIterator itr, part_itr;
+	job_record_t *job_ptr;
+	part_record_t *part_ptr;
+	time_t now, use_time, expire = 0;
+	uint32_t calc_gen;
+	/* Read lock on jobs, nodes, and partitions */
+	slurmctld_lock_t job_read_lock =
+		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+
+	/* a decay pass while reading the jobs leaves the new cache stale */
+	slurm_mutex_lock(&prio_cache_lock);
+	calc_gen = prio_calc_gen;
+	slurm_mutex_unlock(&prio_cache_lock);
+
+	lock_slurmctld(job_read_lock);
+	now = time(NULL);
+	itr = list_iterator_create(job_list);
+	while ((job_ptr = list_next(itr))) {
+		if (!(flags & PRIORITY_FLAGS_CALCULATE_RUNNING) &&
+		    !IS_JOB_PENDING(job_ptr))
+			continue;
+
+		/* Job is not active on this cluster. */
+		if (IS_JOB_REVOKED(job_ptr))
+			continue;
+
+		/*
+		 * This means the job is not eligible yet, the cache
+		 * expires when it becomes eligible
+		 */
+		if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
+			use_time = job_ptr->details->submit_time;
+		else
+			use_time = job_ptr->details->begin_time;
+
+		if (!use_time)
+			continue;
+		if (use_time > now) {
+			if (!expire || (use_time < expire))
+				expire = use_time;
+			continue;
 		}
 
-		if (filter == 0) {
-			obj = xmalloc(sizeof(priority_factors_object_t));
-			slurm_copy_priority_factors_object(obj,
-						job_ptr->prio_factors);
-			obj->priority_part =
-				((flags & PRIORITY_FLAGS_NO_NORMAL_PART) ?
-				 job_part_ptr->priority_job_factor :
-				 job_part_ptr->norm_priority) *
-				(double)weight_part;
-			obj->job_id = job_ptr->job_id;
-			obj->partition = job_part_ptr->name;
-			obj->user_id = job_ptr->user_id;
-
-			if (obj->priority_tres) {
-				_get_tres_factors(job_ptr, job_part_ptr,
-						  obj->priority_tres);
-				_get_tres_prio_weighted(obj->priority_tres);
-			}
+		/*
+		 * 0 means the job is held
+		 */
+		if (job_ptr->priority == 0)
+			continue;
+
+		/*
+		 * Job is not in any partition, so there is nothing to return.
+		 * This can happen if the Partition was deleted,
+		 * CALCULATE_RUNNING is enabled, and this job is still waiting
+		 * out MinJobAge before being removed from the system.
+		 */
+		if (!job_ptr->part_ptr && !job_ptr->part_ptr_list)
+			continue;
 
-			list_append(ret_list, obj);
+		if (!job_ptr->part_ptr_list) {
+			_add_prio_cache_rec(job_ptr, job_ptr->part_ptr, false,
+					    cache_list);
+			continue;
 		}
-		inx++;
+
+		part_itr = list_iterator_create(job_ptr->part_ptr_list);
+		while ((part_ptr = list_next(part_itr)))
+			_add_prio_cache_rec(job_ptr, part_ptr, true,
+					    cache_list);
+		list_iterator_destroy(part_itr);
 	}
-	list_iterator_destroy(job_iter);
+	list_iterator_destroy(itr);
+	unlock_slurmctld(job_read_lock);
+
+	log_flag(PRIO, "%s: cached priority factors of %d job partitions",
+		 __func__, list_count(cache_list));
+
+	slurm_mutex_lock(&prio_cache_lock);
+	FREE_NULL_LIST(prio_cache_list);
+	prio_cache_list = cache_list;
+	prio_cache_time = now;
+	prio_cache_expire = expire;
+	prio_cache_gen = calc_gen;
+	slurm_mutex_unlock(&prio_cache_lock);
+}
+
+/* Return true if the cache no longer matches the job records */
+static bool _prio_cache_stale(time_t now)
+{
+	return (!prio_cache_list ||
+		(prio_cache_gen != prio_calc_gen) ||
+		(last_job_update >= prio_cache_time) ||
+		(last_part_update >= prio_cache_time) ||
+		(prio_cache_expire && (prio_cache_expire <= now)));
+}
+
+static int _find_uint32(void *x, void *key)
+{
+	return (*(uint32_t *) x == *(uint32_t *) key);
+}
+
+static int _find_part_name(void *x, void *key)
+{
+	return !xstrcmp((char *) x, (char *) key);
+}
+
+/*
+ * If the cached record satisfies the filter specifications in req_msg
+ * and part_name_list (partition name filters), then add a copy of its
+ * priority specs to ret_list
+ */
+static void _filter_job(prio_cache_rec_t *rec,
+			priority_factors_request_msg_t *req_msg,
+			List part_name_list, List ret_list)
+{
+	priority_factors_object_t *obj = NULL;
+
+	/* Filter by job ID */
+	if (req_msg->job_id_list &&
+	    !list_find_first(req_msg->job_id_list, _find_uint32,
+			     &rec->obj.job_id))
+		return;
+
+	/* Filter by user/UID */
+	if (req_msg->uid_list &&
+	    !list_find_first(req_msg->uid_list, _find_uint32,
+			     &rec->obj.user_id))
+		return;
+
+	/* Filter by partition */
+	if (part_name_list &&
+	    !list_find_first(part_name_list, _find_part_name,
+			     rec->obj.partition))
+		return;
+
+	obj = xmalloc(sizeof(priority_factors_object_t));
+	slurm_copy_priority_factors_object(obj, &rec->obj);
+	list_append(ret_list, obj);
 }
 
 static void _internal_setup(void)
@@ -1782,6 +1918,10 @@ int fini ( void )
 
 	slurm_mutex_unlock(&decay_lock);
 
+	slurm_mutex_lock(&prio_cache_lock);
+	FREE_NULL_LIST(prio_cache_list);
+	slurm_mutex_unlock(&prio_cache_lock);
+
 	/* Now join outside the lock */
 	if (decay_handler_thread)
 		pthread_join(decay_handler_thread, NULL);
@@ -1839,6 +1979,11 @@ extern void priority_p_reconfig(bool assoc_clear)
 
 	site_factor_g_reconfig();
 
+	/* Factors may be weighted differently now */
+	slurm_mutex_lock(&prio_cache_lock);
+	FREE_NULL_LIST(prio_cache_list);
+	slurm_mutex_unlock(&prio_cache_lock);
+
 	debug2("%s reconfigured", plugin_name);
 
 	return;
@@ -1901,79 +2046,49 @@ extern List priority_p_get_priority_factors_list(
 {
 	List ret_list = NULL, part_filter_list = NULL;
 	ListIterator itr;
-	job_record_t *job_ptr = NULL;
-	part_record_t *part_ptr;
+	prio_cache_rec_t *rec;
 	time_t start_time = time(NULL);
-	char *part_str, *tok, *last = NULL;
-	/* Read lock on jobs, nodes, and partitions */
-	slurmctld_lock_t job_read_lock =
-		{ NO_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, NO_LOCK };
+	bool stale, private_data, operator;
 
 	xassert(req_msg);
 
-	lock_slurmctld(job_read_lock);
+	slurm_mutex_lock(&prio_cache_lock);
+	prio_cache_used = true;
+	stale = _prio_cache_stale(start_time);
+	slurm_mutex_unlock(&prio_cache_lock);
+	if (stale)
+		_refresh_prio_cache();
+
 	if (req_msg->partitions) {
-		part_filter_list = list_create(NULL);
-		part_str = xstrdup(req_msg->partitions);
-		tok = strtok_r(part_str, ",", &last);
-		while (tok) {
-			if ((part_ptr = find_part_record(tok)))
-				list_append(part_filter_list, part_ptr);
-			tok = strtok_r(NULL, ",", &last);
-		}
-		xfree(part_str);
+		part_filter_list = list_create(xfree_ptr);
+		slurm_addto_char_list_with_case(part_filter_list,
+						req_msg->partitions, false);
 	}
-
-	if (job_list && list_count(job_list)) {
-		time_t use_time;
-
-		ret_list = list_create(slurm_destroy_priority_factors_object);
-		itr = list_iterator_create(job_list);
-		while ((job_ptr = list_next(itr))) {
-			if (!(flags & PRIORITY_FLAGS_CALCULATE_RUNNING) &&
-			    !IS_JOB_PENDING(job_ptr))
-				continue;
-
-			/* Job is not active on this cluster. */
-			if (IS_JOB_REVOKED(job_ptr))
-				continue;
-
-			/*
-			 * This means the job is not eligible yet
-			 */
-			if (flags & PRIORITY_FLAGS_ACCRUE_ALWAYS)
-				use_time = job_ptr->details->submit_time;
-			else
-				use_time = job_ptr->details->begin_time;
-
-			if (!use_time || (use_time > start_time))
-				continue;
-
-			/*
-			 * 0 means the job is held
-			 */
-			if (job_ptr->priority == 0)
-				continue;
-
-			if ((slurm_conf.private_data & PRIVATE_DATA_JOBS) &&
-			    (job_ptr->user_id != uid) &&
-			    !validate_operator(uid) &&
+	private_data = (slurm_conf.private_data & PRIVATE_DATA_JOBS);
+	operator = validate_operator(uid);
+
+	slurm_mutex_lock(&prio_cache_lock);
+	if (prio_cache_list && list_count(prio_cache_list)) {
+		ret_list = list_create(_destroy_factors_obj);
+		itr = list_iterator_create(prio_cache_list);
+		while ((rec = list_next(itr))) {
+			if (private_data && (rec->obj.user_id != uid) &&
+			    !operator &&
 			    (((slurm_mcs_get_privatedata() == 0) &&
 			      !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
-			                                    job_ptr->account))||
+			                                    rec->account)) ||
 			     ((slurm_mcs_get_privatedata() == 1) &&
-			      (mcs_g_check_mcs_label(uid, job_ptr->mcs_label)
+			      (mcs_g_check_mcs_label(uid, rec->mcs_label)
 			       != 0))))
 				continue;
 
-			_filter_job(job_ptr, req_msg, part_filter_list,
-				    ret_list);
+			_filter_job(rec, req_msg, part_filter_list, ret_list);
 		}
 		list_iterator_destroy(itr);
 		if (!list_count(ret_list))
 			FREE_NULL_LIST(ret_list);
 	}
-	unlock_slurmctld(job_read_lock);
+	slurm_mutex_unlock(&prio_cache_lock);
 	FREE_NULL_LIST(part_filter_list);
 
 	return ret_list;
@@ -2050,10 +2165,25 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 		job_ptr->prio_factors =
 			xmalloc(sizeof(priority_factors_object_t));
 	} else {
-		xfree(job_ptr->prio_factors->tres_weights);
-		xfree(job_ptr->prio_factors->priority_tres);
+		double *priority_tres = job_ptr->prio_factors->priority_tres;
+		double *tres_weights = job_ptr->prio_factors->tres_weights;
+		uint32_t tres_cnt = job_ptr->prio_factors->tres_cnt;
+
+		/*
+		 * This runs for every pending job on each decay cycle, so
+		 * keep the TRES arrays if they still have the right size.
+		 * They are refilled below.
+		 */
+		if (!weight_tres || (tres_cnt != slurmctld_tres_cnt)) {
+			xfree(tres_weights);
+			xfree(priority_tres);
+			tres_cnt = 0;
+		}
 		memset(job_ptr->prio_factors, 0,
 		       sizeof(priority_factors_object_t));
+		job_ptr->prio_factors->priority_tres = priority_tres;
+		job_ptr->prio_factors->tres_weights = tres_weights;
+		job_ptr->prio_factors->tres_cnt = tres_cnt;
 	}
 
 	if (weight_age && job_ptr->details->accrue_time) {
@@ -2073,11 +2203,6 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 			job_ptr->prio_factors->priority_age = 1.0;
 	}
 
-	if (job_ptr->assoc_ptr && weight_fs) {
-		job_ptr->prio_factors->priority_fs =
-			_get_fairshare_priority(job_ptr);
-	}
-
 	/* FIXME: this should work off the product of TRESBillingWeights */
 	if (weight_js) {
 		uint32_t cpu_cnt = 0, min_nodes = 1;
@@ -2155,6 +2280,11 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 	job_ptr->prio_factors->priority_site = job_ptr->site_factor;
 
 	assoc_mgr_lock(&locks);
+	if (job_ptr->assoc_ptr && weight_fs) {
+		job_ptr->prio_factors->priority_fs =
+			_get_fairshare_priority(job_ptr);
+	}
+
 	if (job_ptr->assoc_ptr && weight_assoc)
 		job_ptr->prio_factors->priority_assoc =
 			(flags & PRIORITY_FLAGS_NO_NORMAL_ASSOC) ?
@@ -2180,10 +2310,13 @@ extern void set_priority_factors(time_t start_time, job_record_t *job_ptr)
 				xcalloc(slurmctld_tres_cnt, sizeof(double));
 			job_ptr->prio_factors->tres_weights =
 				xcalloc(slurmctld_tres_cnt, sizeof(double));
-			memcpy(job_ptr->prio_factors->tres_weights, weight_tres,
-			       sizeof(double) * slurmctld_tres_cnt);
 			job_ptr->prio_factors->tres_cnt = slurmctld_tres_cnt;
+		} else {
+			memset(job_ptr->prio_factors->priority_tres, 0,
+			       sizeof(double) * slurmctld_tres_cnt);
 		}
+		memcpy(job_ptr->prio_factors->tres_weights, weight_tres,
+		       sizeof(double) * slurmctld_tres_cnt);
 
 		_get_tres_factors(job_ptr, job_ptr->part_ptr,
 				  job_ptr->prio_factors->priority_tres);
@@ -43,6 +43,7 @@
 #include <stdlib.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 
 #include "slurm/slurm.h"
 #include "slurm/slurm_errno.h"
@@ -165,32 +166,42 @@ extern int proctrack_p_add (stepd_step_rec_t *job, pid_t pid)
 	return cgroup_g_step_addto(CG_TRACK, &pid, 1);
 }
 
+extern int proctrack_p_add_pids(stepd_step_rec_t *job, pid_t *pids, int npids)
+{
+	return cgroup_g_step_addto(CG_TRACK, pids, npids);
+}
+
 extern int proctrack_p_signal (uint64_t id, int signal)
 {
 	pid_t* pids = NULL;
 	int npids = 0;
 	int i;
 	int slurm_task;
+	bool frozen = false;
+
+	/* directly manage SIGSTOP using cgroup freezer subsystem */
+	if (signal == SIGSTOP)
+		return cgroup_g_step_suspend();
+
+	/*
+	 * Freeze the step before reading its pids in case of SIGKILL, so that
+	 * nothing can fork while we walk the list and every process gets the
+	 * signal in one pass. The frozen processes die as soon as they are
+	 * thawed below.
+	 */
+	if ((signal == SIGKILL) && (cgroup_g_step_suspend() == SLURM_SUCCESS))
+		frozen = true;
 
 	/* get all the pids associated with the step */
 	if (cgroup_g_step_get_pids(&pids, &npids) != SLURM_SUCCESS) {
 		debug3("unable to get pids list for cont_id=%"PRIu64"", id);
+		if (signal == SIGKILL)
+			cgroup_g_step_resume();
 		/* that could mean that all the processes already exit */
 		/* the container so return success */
 		return SLURM_SUCCESS;
 	}
 
-	/* directly manage SIGSTOP using cgroup freezer subsystem */
-	if (signal == SIGSTOP) {
-		xfree(pids);
-		return cgroup_g_step_suspend();
-	}
-
-	/* start by resuming in case of SIGKILL */
-	if (signal == SIGKILL) {
-		cgroup_g_step_resume();
-	}
-
 	for (i = 0 ; i<npids ; i++) {
 		/* do not kill slurmstepd (it should not be part
 		 * of the list, but just to not forget about that ;))
@@ -198,16 +209,31 @@ extern int proctrack_p_signal (uint64_t id, int signal)
 		if (pids[i] == (pid_t)id)
 			continue;
 
+		/* everything gets SIGKILL, no need to look at /proc */
+		if (signal == SIGKILL) {
+			kill(pids[i], signal);
+			continue;
+		}
+
 		/* only signal slurm tasks unless signal is SIGKILL */
 		slurm_task = _slurm_cgroup_is_pid_a_slurm_task(id, pids[i]);
-		if (slurm_task == 1 || signal == SIGKILL) {
-			debug2("killing process %d (%s) with signal %d", pids[i],
-			       (slurm_task==1)?"slurm_task":"inherited_task",
-			       signal);
+		if (slurm_task == 1) {
+			debug2("killing process %d (slurm_task) with signal %d",
+			       pids[i], signal);
 			kill(pids[i], signal);
 		}
 	}
 
+	if (signal == SIGKILL) {
+		debug2("killed %d processes of cont_id=%"PRIu64"%s",
+		       npids, id, frozen ? " (frozen)" : "");
+		/*
+		 * Resume even if the freeze failed, a previously suspended
+		 * step must be thawed for SIGKILL to be delivered.
+		 */
+		cgroup_g_step_resume();
+	}
+
 	xfree(pids);
 
 	/* resume tasks after signaling slurm tasks with SIGCONT to be sure */
@@ -237,7 +263,7 @@ extern bool proctrack_p_has_pid(uint64_t cont_id, pid_t pid)
 
 extern int proctrack_p_wait(uint64_t cont_id)
 {
-	int delay = 1;
+	int delay = 125;	/* msec */
 
 	if (cont_id == 0 || cont_id == 1) {
 		errno = EINVAL;
@@ -248,12 +274,16 @@ extern int proctrack_p_wait(uint64_t cont_id)
 	/* This indicates that all tasks have exited the container */
 	while (proctrack_p_destroy(cont_id) != SLURM_SUCCESS) {
 		proctrack_p_signal(cont_id, SIGKILL);
-		sleep(delay);
-		if (delay < 120) {
+		/*
+		 * Killed processes are usually gone within a few msec, so
+		 * start polling fast and back off from there.
+		 */
+		usleep(delay * 1000);
+		if (delay < 120000) {
 			delay *= 2;
 		} else {
 			error("Unable to destroy container %"PRIu64" in cgroup plugin, giving up after %d sec",
-			      cont_id, delay);
+			      cont_id, delay / 1000);
 			break;
 		}
 	}
@@ -300,6 +300,16 @@ try_again:
 	return SLURM_SUCCESS;
 }
 
+int proctrack_p_add_pids(stepd_step_rec_t *job, pid_t *pids, int npids)
+{
+	for (int i = 0; i < npids; i++) {
+		if (proctrack_p_add(job, pids[i]) != SLURM_SUCCESS)
+			return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
 int proctrack_p_signal(uint64_t id, int sig)
 {
 	DEF_TIMERS;
@@ -104,6 +104,11 @@ extern int proctrack_p_add ( stepd_step_rec_t *job, pid_t pid )
 	return SLURM_SUCCESS;
 }
 
+extern int proctrack_p_add_pids(stepd_step_rec_t *job, pid_t *pids, int npids)
+{
+	return SLURM_SUCCESS;
+}
+
 extern int proctrack_p_signal ( uint64_t id, int signal )
 {
 	return kill_proc_tree((pid_t)id, signal);
@@ -120,6 +120,12 @@ extern int proctrack_p_add ( stepd_step_rec_t *job, pid_t pid )
 	return SLURM_SUCCESS;
 }
 
+extern int proctrack_p_add_pids(stepd_step_rec_t *job, pid_t *pids, int npids)
+{
+	job->cont_id = (uint64_t)job->pgid;
+	return SLURM_SUCCESS;
+}
+
 extern int proctrack_p_signal  ( uint64_t id, int signal )
 {
 	pid_t pid = (pid_t) id;
@@ -120,6 +120,89 @@ extern int fini(void)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Return true if a node is fit to be the first node of a branch, which
+ * receives the message from its parent and relays it to the rest of the
+ * branch
+ */
+static bool _leader_ok(node_record_t *node_ptr)
+{
+	if (IS_NODE_DOWN(node_ptr) || IS_NODE_NO_RESPOND(node_ptr) ||
+	    IS_NODE_POWER_SAVE(node_ptr) || IS_NODE_POWER_UP(node_ptr) ||
+	    IS_NODE_FUTURE(node_ptr))
+		return false;
+	return true;
+}
+
+/*
+ * TopologyParam=RouteLoad: move the responding node with the lowest CPU
+ * load to the front of each branch's hostlist so that it is the branch's
+ * relay, rather than always using the lowest numbered node.
+ * NOTE: Call in the slurmctld with a read lock on nodes
+ */
+static void _pick_leaders(hostlist_t *sp_hl, int count)
+{
+	hostlist_iterator_t itr;
+	node_record_t *node_ptr, *leader_ptr;
+	hostlist_t new_hl;
+	char *name;
+	int i;
+
+	for (i = 0; i < count; i++) {
+		if (hostlist_count(sp_hl[i]) < 2)
+			continue;
+		leader_ptr = NULL;
+		itr = hostlist_iterator_create(sp_hl[i]);
+		while ((name = hostlist_next(itr))) {
+			node_ptr = find_node_record(name);
+			free(name);
+			if (!node_ptr || !_leader_ok(node_ptr))
+				continue;
+			if (!leader_ptr ||
+			    (node_ptr->cpu_load < leader_ptr->cpu_load))
+				leader_ptr = node_ptr;
+		}
+		hostlist_iterator_destroy(itr);
+		if (!leader_ptr)
+			continue;
+
+		name = hostlist_nth(sp_hl[i], 0);
+		if (!xstrcmp(name, leader_ptr->name)) {
+			free(name);
+			continue;
+		}
+		free(name);
+
+		new_hl = hostlist_create(leader_ptr->name);
+		hostlist_delete_host(sp_hl[i], leader_ptr->name);
+		while ((name = hostlist_shift(sp_hl[i]))) {
+			hostlist_push_host(new_hl, name);
+			free(name);
+		}
+		hostlist_destroy(sp_hl[i]);
+		sp_hl[i] = new_hl;
+		log_flag(ROUTE, "ROUTE: ... sublist[%d] leader %s", i,
+			 leader_ptr->name);
+	}
+}
+
+/* Split on the leaf switch based upon TreeWidth, then pick leaders */
+static int _split_treewidth(hostlist_t hl, hostlist_t **sp_hl, int *count,
+			    uint16_t tree_width, bool pick_leaders)
+{
+	slurmctld_lock_t node_read_lock = { .node = READ_LOCK };
+	int rc;
+
+	rc = route_split_hostlist_treewidth(hl, sp_hl, count, tree_width);
+	if ((rc == SLURM_SUCCESS) && pick_leaders) {
+		lock_slurmctld(node_read_lock);
+		_pick_leaders(*sp_hl, *count);
+		unlock_slurmctld(node_read_lock);
+	}
+
+	return rc;
+}
+
 /*****************************************************************************\
  *  API Implementations
 \*****************************************************************************/
@@ -146,6 +229,8 @@ extern int route_p_split_hostlist(hostlist_t hl,
 	bitstr_t *nodes_bitmap = NULL;		/* nodes in message list */
 	bitstr_t *fwd_bitmap = NULL;		/* nodes in forward list */
 	slurmctld_lock_t node_read_lock = { .node = READ_LOCK };
+	bool pick_leaders = run_in_slurmctld &&
+		xstrcasestr(slurm_conf.topology_param, "RouteLoad");
 
 	msg_count = hostlist_count(hl);
 	slurm_mutex_lock(&route_lock);
@@ -208,15 +293,15 @@ extern int route_p_split_hostlist(hostlist_t hl,
 		}
 		FREE_NULL_BITMAP(nodes_bitmap);
 		xfree(*sp_hl);
-		return route_split_hostlist_treewidth(
-			hl, sp_hl, count, tree_width);
+		return _split_treewidth(hl, sp_hl, count, tree_width,
+					pick_leaders);
 	}
 	if (switch_record_table[j].level == 0) {
 		/* This is a leaf switch. Construct list based on TreeWidth */
 		FREE_NULL_BITMAP(nodes_bitmap);
 		xfree(*sp_hl);
-		return route_split_hostlist_treewidth(
-			hl, sp_hl, count, tree_width);
+		return _split_treewidth(hl, sp_hl, count, tree_width,
+					pick_leaders);
 	}
 	/* loop through children, construction a hostlist for each child switch
 	 * with nodes in the message list */
@@ -247,6 +332,12 @@ extern int route_p_split_hostlist(hostlist_t hl,
 	}
 	FREE_NULL_BITMAP(nodes_bitmap);
 
+	if (pick_leaders) {
+		lock_slurmctld(node_read_lock);
+		_pick_leaders(*sp_hl, hl_ndx);
+		unlock_slurmctld(node_read_lock);
+	}
+
 	*count = hl_ndx;
 	return SLURM_SUCCESS;
 
@@ -75,6 +75,7 @@
 #include "src/common/node_select.h"
 #include "src/common/parse_time.h"
 #include "src/common/power.h"
+#include "src/common/probes.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_mcs.h"
@@ -93,6 +94,7 @@
 #include "src/slurmctld/node_scheduler.h"
 #include "src/slurmctld/preempt.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/sched_trace.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/srun_comm.h"
 #include "backfill.h"
@@ -101,6 +103,7 @@
 #define BACKFILL_RESOLUTION	60
 #define BACKFILL_WINDOW		(24 * 60 * 60)
 #define BF_MAX_JOB_ARRAY_RESV	20
+#define BF_SHAPE_CACHE_SIZE	32
 
 #define SLURMCTLD_THREAD_LIMIT	5
 #define YIELD_INTERVAL		2000000	/* time in micro-seconds */
@@ -125,11 +128,16 @@
 #define MAX_BF_MAX_JOB_USER_PART       MAX_BF_MAX_JOB_TEST
 #define MAX_BF_MAX_JOB_PART            MAX_BF_MAX_JOB_TEST
 
+#define NODE_SPACE_SKIP_LEVELS		12
+
 typedef struct node_space_map {
 	time_t begin_time;
 	time_t end_time;
 	bitstr_t *avail_bitmap;
+	bool shared;	/* avail_bitmap belongs to another table */
 	int next;	/* next record, by time, zero termination */
+	int skip_levels; /* count of skip_next links, bf_node_space_skiplist */
+	int *skip_next;	/* next record at skip list levels 1 to skip_levels */
 } node_space_map_t;
 
 typedef struct node_space_handler {
@@ -137,6 +145,57 @@ typedef struct node_space_handler {
 	int *node_space_recs;
 } node_space_handler_t;
 
+/*
+ * Backfill reservation made for a running job, preserved between backfill
+ * cycles when bf_incremental is configured
+ */
+typedef struct bf_running_resv {
+	uint32_t job_id;
+	time_t end_time;	/* reservation end, rounded to bf_resolution */
+	bitstr_t *node_bitmap;	/* nodes allocated to the job */
+	bool seen;		/* job found running during this cycle */
+} bf_running_resv_t;
+
+/*
+ * Group of partitions sharing nodes, directly or through other partitions.
+ * Used with bf_part_groups, each group has its own node_space table.
+ */
+typedef struct bf_part_group {
+	bitstr_t *node_bitmap;		/* nodes of all partitions in group */
+	node_space_map_t *node_space;	/* resource/time table for group */
+	int node_space_recs;		/* records used in node_space */
+} bf_part_group_t;
+
+typedef struct bf_part_group_map {
+	part_record_t *part_ptr;
+	int group;			/* index into bf_part_groups */
+} bf_part_group_map_t;
+
+/*
+ * Outcome of testing a job with a given resource request (its "shape"), kept
+ * with bf_job_shape_cache while the node_space table and node states are
+ * unchanged so later jobs with the same request can reuse the result
+ */
+typedef struct bf_shape_rec {
+	char *key;		/* from _bf_shape_key() */
+	time_t start_time;	/* expected start time, 0 if unable to run */
+} bf_shape_rec_t;
+
+/*
+ * License availability over time, used with bf_licenses. Like node_space,
+ * records cover consecutive time ranges of the backfill window, in order.
+ */
+typedef struct bf_lic_space {
+	time_t begin_time;
+	time_t end_time;
+	uint32_t *avail;	/* count available, indexed as bf_lic_names */
+} bf_lic_space_t;
+
+typedef struct bf_running_delta {
+	List add_list;		/* running jobs lacking a current reservation */
+	time_t begin_time;	/* begin time of the node_space table */
+} bf_running_delta_t;
+
 /*
  * HetJob scheduling structures
  * NOTE: An individial hetjob component can be submitted to multiple
@@ -147,6 +206,11 @@ typedef struct het_job_rec {
 	job_record_t *job_ptr;
 	time_t latest_start;		/* Time when expected to start */
 	part_record_t *part_ptr;
+	bool placed;			/* Placed this cycle */
+	bitstr_t *resv_bitmap;		/* Nodes reserved this cycle, NULL if
+					 * none */
+	uint32_t resv_end;		/* End of planned reservation */
+	uint32_t resv_start;		/* Start of planned reservation */
 } het_job_rec_t;
 
 typedef struct het_job_map {
@@ -156,16 +220,6 @@ typedef struct het_job_map {
 	time_t prev_start;		/* Expected start time from last test */
 } het_job_map_t;
 
-typedef struct deadlock_job_struct {
-	uint32_t het_job_id;
-	time_t start_time;
-} deadlock_job_struct_t;
-
-typedef struct deadlock_part_struct {
-	List deadlock_job_list;
-	part_record_t *part_ptr;
-} deadlock_part_struct_t;
-
 /* Diagnostic  statistics */
 extern diag_stats_t slurmctld_diag_stats;
 uint32_t bf_sleep_usec = 0;
@@ -191,7 +245,6 @@ static int bf_max_job_array_resv = BF_MAX_JOB_ARRAY_RESV;
 static int bf_min_age_reserve = 0;
 static bool bf_running_job_reserve = false;
 static uint32_t bf_min_prio_reserve = 0;
-static List deadlock_global_list;
 static bool bf_hetjob_immediate = false;
 static uint16_t bf_hetjob_prio = 0;
 static bool bf_one_resv_per_job = false;
@@ -210,6 +263,28 @@ static int yield_sleep   = YIELD_SLEEP;
 static List het_job_list = NULL;
 static xhash_t *user_usage_map = NULL; /* look up user usage when no assoc */
 static bitstr_t *planned_bitmap = NULL;
+static bool bf_incremental = false;
+static bool bf_node_space_skiplist = false;
+static bool bf_part_groups_enable = false;
+static bool bf_job_shape_cache = false;
+static bf_shape_rec_t bf_shape_cache[BF_SHAPE_CACHE_SIZE];
+static int bf_shape_next = 0;		/* next bf_shape_cache record to use */
+static bf_part_group_t *bf_part_groups = NULL;
+static int bf_part_group_cnt = 0;
+static int bf_part_group_cur = -1;	/* group of the active node_space */
+static bf_part_group_map_t *bf_part_group_map = NULL;
+static int bf_part_group_map_cnt = 0;
+static node_space_map_t *bf_part_group_base = NULL; /* shared by groups */
+static node_space_map_t *bf_base_space = NULL; /* running job reservations */
+static int bf_base_recs = 0;
+static bitstr_t *bf_base_avail = NULL;	/* available nodes in bf_base_space */
+static xhash_t *bf_base_resv_map = NULL; /* bf_running_resv_t by job ID */
+static bool bf_licenses = false;
+static char **bf_lic_names = NULL;	/* licenses in bf_lic_space */
+static int bf_lic_cnt = 0;
+static bf_lic_space_t *bf_lic_space = NULL;
+static int bf_lic_space_cnt = 0;	/* records used in bf_lic_space */
+static int bf_lic_space_size = 0;	/* records allocated in bf_lic_space */
 
 /*********************** local functions *********************/
 static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
@@ -218,6 +293,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 			     int *node_space_recs);
 static void _adjust_hetjob_prio(uint32_t *prio, uint32_t val);
 static int  _attempt_backfill(void);
+static void _bf_base_space_clear(void);
 static int  _clear_job_estimates(void *x, void *arg);
 static int  _clear_qos_blocked_times(void *x, void *arg);
 static void _do_diag_stats(struct timeval *tv1, struct timeval *tv2,
@@ -227,8 +303,6 @@ static uint32_t _get_job_max_tl(job_record_t *job_ptr, time_t now,
 static bool _hetjob_any_resv(job_record_t *het_leader);
 static uint32_t _hetjob_calc_prio(job_record_t *het_leader);
 static uint32_t _hetjob_calc_prio_tier(job_record_t *het_leader);
-static void _het_job_deadlock_fini(void);
-static bool _het_job_deadlock_test(job_record_t *job_ptr);
 static bool _job_part_valid(job_record_t *job_ptr, part_record_t *part_ptr);
 static void _load_config(void);
 static bool _many_pending_rpcs(void);
@@ -238,6 +312,12 @@ static int  _num_feature_count(job_record_t *job_ptr, bool *has_xand,
 			       bool *has_xor);
 static int  _het_job_find_map(void *x, void *key);
 static void _het_job_map_del(void *x);
+static void _het_job_rec_del(void *x);
+static void _het_job_resv_add(job_record_t *job_ptr, uint32_t start_time,
+			      uint32_t end_reserve, bitstr_t *node_bitmap,
+			      bool reserve, node_space_map_t *node_space,
+			      int *node_space_recs);
+static void _het_job_resv_clear(void);
 static void _het_job_start_clear(void);
 static time_t _het_job_start_find(job_record_t *job_ptr);
 static void _het_job_start_set(job_record_t *job_ptr, time_t latest_start,
@@ -260,6 +340,209 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 static int  _yield_locks(int64_t usec);
 static void _bf_map_key_id(void *item, const char **key, uint32_t *key_len);
 static void _bf_map_free(void *item);
+static void _bf_shape_clear(void);
+
+/*
+ * Skip list over the node_space table, enabled by bf_node_space_skiplist.
+ * Level 0 of the skip list is the "next" field, higher levels are stored in
+ * "skip_next". Record zero is the head of the table and has all levels.
+ * Records of a skip list indexed table never have zero length, so their
+ * begin_time values strictly increase along the table.
+ */
+
+/* Return the record following record "j" at skip list level "level" */
+static int _ns_link(node_space_map_t *node_space, int j, int level)
+{
+	if (level == 0)
+		return node_space[j].next;
+	if (level > node_space[j].skip_levels)
+		return 0;
+	return node_space[j].skip_next[level - 1];
+}
+
+static void _ns_set_link(node_space_map_t *node_space, int j, int level,
+			 int next)
+{
+	if (level == 0)
+		node_space[j].next = next;
+	else
+		node_space[j].skip_next[level - 1] = next;
+}
+
+/* Set the skip list height for record "j", a function of its index */
+static void _ns_rec_levels(node_space_map_t *node_space, int j)
+{
+	int levels;
+
+	if (j == 0)
+		levels = NODE_SPACE_SKIP_LEVELS - 1;
+	else
+		levels = MIN((ffs(j) - 1) / 2, NODE_SPACE_SKIP_LEVELS - 1);
+
+	xfree(node_space[j].skip_next);
+	node_space[j].skip_levels = levels;
+	if (levels)
+		node_space[j].skip_next = xcalloc(levels, sizeof(int));
+}
+
+/* Free the bitmap and skip list links of one node_space record */
+static void _ns_rec_free(node_space_map_t *node_space_rec)
+{
+	if (node_space_rec->shared)
+		node_space_rec->avail_bitmap = NULL;
+	else
+		FREE_NULL_BITMAP(node_space_rec->avail_bitmap);
+	node_space_rec->shared = false;
+	xfree(node_space_rec->skip_next);
+	node_space_rec->skip_levels = 0;
+}
+
+/* Give a node_space record its own copy of a shared bitmap to change */
+static void _ns_rec_own(node_space_map_t *node_space_rec)
+{
+	if (!node_space_rec->shared)
+		return;
+	node_space_rec->avail_bitmap = bit_copy(node_space_rec->avail_bitmap);
+	node_space_rec->shared = false;
+}
+
+/* Build (or rebuild) the skip list links of a node_space table */
+static void _ns_skip_build(node_space_map_t *node_space)
+{
+	int last[NODE_SPACE_SKIP_LEVELS];
+	int j, level;
+
+	if (!bf_node_space_skiplist)
+		return;
+
+	memset(last, 0, sizeof(last));
+	_ns_rec_levels(node_space, 0);
+	for (j = node_space[0].next; j; j = node_space[j].next) {
+		_ns_rec_levels(node_space, j);
+		for (level = 1; level <= node_space[j].skip_levels; level++) {
+			_ns_set_link(node_space, last[level], level, j);
+			last[level] = j;
+		}
+	}
+}
+
+/*
+ * Find the last record with a begin_time no later than "when"
+ * OUT update - if set, last record at each skip list level found in the
+ *	search, NODE_SPACE_SKIP_LEVELS entries
+ * RET index of the record, zero if "when" is before the table begins
+ */
+static int _ns_skip_find(node_space_map_t *node_space, time_t when,
+			 int *update)
+{
+	int j = 0, level, n;
+
+	for (level = NODE_SPACE_SKIP_LEVELS - 1; level >= 0; level--) {
+		while ((n = _ns_link(node_space, j, level)) &&
+		       (node_space[n].begin_time <= when))
+			j = n;
+		if (update)
+			update[level] = j;
+	}
+
+	return j;
+}
+
+/*
+ * Split record "j" at time "when", returns the index of the record starting
+ * at "when". "update" is the result of _ns_skip_find() for "when".
+ */
+static int _ns_skip_split(node_space_map_t *node_space, int *node_space_recs,
+			  int j, time_t when, int *update)
+{
+	int i = *node_space_recs, level;
+
+	node_space[i].begin_time = when;
+	node_space[i].end_time = node_space[j].end_time;
+	node_space[j].end_time = when;
+	node_space[i].avail_bitmap = bit_copy(node_space[j].avail_bitmap);
+	node_space[i].next = 0;
+	_ns_rec_levels(node_space, i);
+	for (level = 0; level <= node_space[i].skip_levels; level++) {
+		_ns_set_link(node_space, i, level,
+			     _ns_link(node_space, update[level], level));
+		_ns_set_link(node_space, update[level], level, i);
+	}
+	(*node_space_recs)++;
+
+	return i;
+}
+
+/* Merge record "j" into the preceding record "i" */
+static void _ns_skip_merge(node_space_map_t *node_space, int i, int j)
+{
+	int update[NODE_SPACE_SKIP_LEVELS];
+	int level;
+
+	(void) _ns_skip_find(node_space, node_space[j].begin_time - 1, update);
+	xassert(update[0] == i);
+	for (level = 0; level <= node_space[j].skip_levels; level++) {
+		if (_ns_link(node_space, update[level], level) != j)
+			continue;
+		_ns_set_link(node_space, update[level], level,
+			     _ns_link(node_space, j, level));
+	}
+	node_space[i].end_time = node_space[j].end_time;
+	_ns_rec_free(&node_space[j]);
+}
+
+/*
+ * Skip list variant of _add_reservation(). Locates the records at the start
+ * and end of the reservation in logarithmic time, only touches the records
+ * covered by the reservation and merges identical neighboring records within
+ * that range.
+ */
+static void _add_reservation_skip(uint32_t start_time, uint32_t end_reserve,
+				  bitstr_t *res_bitmap,
+				  node_space_map_t *node_space,
+				  int *node_space_recs)
+{
+	int update[NODE_SPACE_SKIP_LEVELS];
+	int first, i, j;
+
+	first = _ns_skip_find(node_space, start_time, update);
+	if (node_space[first].end_time <= start_time)
+		return;		/* Starts after the end of the table */
+	if (node_space[first].begin_time < start_time)
+		first = _ns_skip_split(node_space, node_space_recs, first,
+				       start_time, update);
+
+	j = _ns_skip_find(node_space, end_reserve, update);
+	if ((node_space[j].begin_time < end_reserve) &&
+	    (node_space[j].end_time > end_reserve))
+		(void) _ns_skip_split(node_space, node_space_recs, j,
+				      end_reserve, update);
+
+	for (j = first; ; ) {
+		if (node_space[j].begin_time >= end_reserve)
+			break;
+		_ns_rec_own(&node_space[j]);
+		bit_and(node_space[j].avail_bitmap, res_bitmap);
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+
+	/*
+	 * Drop records with identical bitmaps, starting with the one preceding
+	 * the reservation and ending with the one following it.
+	 */
+	i = _ns_skip_find(node_space, start_time - 1, NULL);
+	while ((j = node_space[i].next)) {
+		if (node_space[i].begin_time > end_reserve)
+			break;
+		if (!bit_equal(node_space[i].avail_bitmap,
+			       node_space[j].avail_bitmap)) {
+			i = j;
+			continue;
+		}
+		_ns_skip_merge(node_space, i, j);
+	}
+}
 
 /* Log resources to be allocated to a pending job */
 static void _dump_job_sched(job_record_t *job_ptr, time_t end_time,
@@ -403,7 +686,11 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 	ListIterator feat_iter;
 	job_feature_t *feat_ptr;
 	job_feature_t *feature_base;
+	struct timeval start_tv = {0, 0};
 
+	(void) slurm_delta_tv(&start_tv);
+	SLURM_PROBE1(backfill__job_start, job_ptr->job_id);
+	sched_trace_select_start();
 	if (has_xand || feat_cnt) {
 		/*
 		 * Cache the feature information and test the individual
@@ -631,6 +918,9 @@ static int  _try_sched(job_record_t *job_ptr, bitstr_t **avail_bitmap,
 	}
 
 	FREE_NULL_LIST(preemptee_candidates);
+	slurmctld_diag_stats.bf_select_sum += slurm_delta_tv(&start_tv);
+	sched_trace_select_end(rc);
+	SLURM_PROBE2(backfill__job_done, job_ptr->job_id, rc);
 	return rc;
 }
 
@@ -938,6 +1228,33 @@ static void _load_config(void)
 	else
 		bf_running_job_reserve = false;
 
+	if (xstrcasestr(sched_params, "bf_incremental"))
+		bf_incremental = true;
+	else
+		bf_incremental = false;
+
+	if (xstrcasestr(sched_params, "bf_node_space_skiplist"))
+		bf_node_space_skiplist = true;
+	else
+		bf_node_space_skiplist = false;
+
+	if (xstrcasestr(sched_params, "bf_part_groups"))
+		bf_part_groups_enable = true;
+	else
+		bf_part_groups_enable = false;
+
+	if (xstrcasestr(sched_params, "bf_licenses"))
+		bf_licenses = true;
+	else
+		bf_licenses = false;
+
+	if (xstrcasestr(sched_params, "bf_job_shape_cache"))
+		bf_job_shape_cache = true;
+	else
+		bf_job_shape_cache = false;
+	/* Configuration may have changed resolution, window or node table */
+	_bf_base_space_clear();
+
 	if ((tmp_ptr = xstrcasestr(sched_params, "max_rpc_cnt=")))
 		max_rpc_cnt = atoi(tmp_ptr + 12);
 	else if ((tmp_ptr = xstrcasestr(sched_params, "max_rpc_count=")))
@@ -977,6 +1294,7 @@ static void _do_diag_stats(struct timeval *tv1, struct timeval *tv2,
 	slurmctld_diag_stats.bf_cycle_counter++;
 	slurmctld_diag_stats.bf_cycle_sum += real_time;
 	slurmctld_diag_stats.bf_cycle_last = real_time;
+	slurmctld_diag_stats.bf_yield_sum += bf_sleep_usec;
 
 	slurmctld_diag_stats.bf_depth_sum += slurmctld_diag_stats.bf_last_depth;
 	slurmctld_diag_stats.bf_depth_try_sum +=
@@ -1048,11 +1366,13 @@ extern void *backfill_agent(void *args)
 		slurm_mutex_unlock(&check_bf_running_lock);
 
 		lock_slurmctld(all_locks);
+		node_set_cache_begin();
 		if ((backfill_cnt++ % 2) == 0)
 			_het_job_start_clear();
 		(void) _attempt_backfill();
 		last_backfill_time = time(NULL);
 		(void) bb_g_job_try_stage_in();
+		node_set_cache_end();
 		unlock_slurmctld(all_locks);
 
 		slurm_mutex_lock(&check_bf_running_lock);
@@ -1061,9 +1381,13 @@ extern void *backfill_agent(void *args)
 
 		short_sleep = false;
 	}
+	lock_slurmctld(all_locks);
+	sched_plan_set(NULL);
+	unlock_slurmctld(all_locks);
 	FREE_NULL_LIST(het_job_list);
 	xhash_free(user_usage_map); /* May have been init'ed if used */
 	FREE_NULL_BITMAP(planned_bitmap);
+	_bf_base_space_clear();
 
 	return NULL;
 }
@@ -1084,6 +1408,11 @@ static int _clear_job_estimates(void *x, void *arg)
 }
 
 /*
+ * Release locks to any threads waiting for them. Locks are kept if no thread
+ * is waiting, otherwise they are handed to the waiting threads and reacquired
+ * once those have been granted them, waiting at most usec microseconds. With
+ * max_rpc_cnt set and many RPCs pending, sleep until they drain instead.
+ *
  * Return non-zero to break the backfill loop if change in job, node or
  * partition state or the backfill scheduler needs to be stopped.
  */
@@ -1092,28 +1421,44 @@ static int _yield_locks(int64_t usec)
 	slurmctld_lock_t all_locks = {
 		READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
 	time_t job_update, node_update, part_update;
-	bool load_config = false;
+	bool busy, load_config = false;
 	int yield_rpc_cnt;
 
 	yield_rpc_cnt = MAX((max_rpc_cnt / 10), 20);
+	slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+	busy = (max_rpc_cnt > 0) &&
+	       (slurmctld_config.server_thread_count > yield_rpc_cnt);
+	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+	if (!busy && !lock_slurmctld_waiters(all_locks))
+		return 0;
+
+	_bf_shape_clear();	/* Job and node state may change while unlocked */
 	job_update  = last_job_update;
 	node_update = last_node_update;
 	part_update = last_part_update;
 
-	unlock_slurmctld(all_locks);
-	while (!stop_backfill) {
-		bf_sleep_usec += _my_sleep(usec);
-		slurm_mutex_lock(&slurmctld_config.thread_count_lock);
-		if ((max_rpc_cnt == 0) ||
-		    (slurmctld_config.server_thread_count <= yield_rpc_cnt)) {
+	node_set_cache_end();
+	sched_trace_end();
+	if (!busy) {
+		bf_sleep_usec += yield_slurmctld(all_locks, usec);
+	} else {
+		unlock_slurmctld(all_locks);
+		while (!stop_backfill) {
+			bf_sleep_usec += _my_sleep(usec);
+			slurm_mutex_lock(&slurmctld_config.thread_count_lock);
+			if (slurmctld_config.server_thread_count <=
+			    yield_rpc_cnt) {
+				slurm_mutex_unlock(
+					&slurmctld_config.thread_count_lock);
+				break;
+			}
+			verbose("continuing to yield locks, %d RPCs pending",
+				slurmctld_config.server_thread_count);
 			slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
-			break;
 		}
-		verbose("continuing to yield locks, %d RPCs pending",
-			slurmctld_config.server_thread_count);
-		slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+		lock_slurmctld(all_locks);
 	}
-	lock_slurmctld(all_locks);
+	node_set_cache_begin();
 	slurm_mutex_lock(&config_lock);
 	if (config_flag)
 		load_config = true;
@@ -1346,23 +1691,34 @@ static int _foreach_het_job_details(void *x, void *arg)
 	return SLURM_SUCCESS;
 }
 
+/* Return true if a backfill reservation should be made for a running job */
+static bool _bf_running_job_resv_ok(job_record_t *job_ptr)
+{
+	if (!job_ptr || !IS_JOB_RUNNING(job_ptr))
+		return false;
+	if (!job_ptr->job_resrcs || !(job_ptr->job_resrcs->whole_node ==
+				      WHOLE_NODE_REQUIRED))
+		return false;
+	if (slurm_job_preempt_mode(job_ptr) != PREEMPT_MODE_OFF)
+		return false;
+
+	return true;
+}
+
 static int _bf_reserve_running(void *x, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *) x;
 	node_space_handler_t *ns_h = (node_space_handler_t *) arg;
 	node_space_map_t *node_space = ns_h->node_space;
 	int *ns_recs_ptr = ns_h->node_space_recs;
-	time_t start_time = job_ptr->start_time;
-	time_t end_time = job_ptr->end_time;
+	time_t start_time, end_time;
 
-	if (!job_ptr || ! IS_JOB_RUNNING(job_ptr))
-		return SLURM_SUCCESS;
-	if (!job_ptr->job_resrcs || !(job_ptr->job_resrcs->whole_node ==
-				      WHOLE_NODE_REQUIRED))
-		return SLURM_SUCCESS;
-	if (slurm_job_preempt_mode(job_ptr) != PREEMPT_MODE_OFF)
+	if (!_bf_running_job_resv_ok(job_ptr))
 		return SLURM_SUCCESS;
 
+	start_time = job_ptr->start_time;
+	end_time = job_ptr->end_time;
+
 	bitstr_t *tmp_bitmap = bit_copy(job_ptr->node_bitmap);
 
 	bit_not(tmp_bitmap);
@@ -1376,6 +1732,379 @@ static int _bf_reserve_running(void *x, void *arg)
 	return SLURM_SUCCESS;
 }
 
+/* Free a node_space table and all of its records */
+static void _node_space_free(node_space_map_t *node_space)
+{
+	int i;
+
+	if (!node_space)
+		return;
+
+	for (i = 0; ; ) {
+		_ns_rec_free(&node_space[i]);
+		if ((i = node_space[i].next) == 0)
+			break;
+	}
+	xfree(node_space);
+}
+
+/*
+ * Move the records of a node_space table into a sched_plan_t appended to
+ * plan_list, leaving the table without bitmaps
+ * IN plan_list - NULL to discard the table's plan
+ * IN node_bitmap - nodes the table applies to, consumed. NULL for all nodes
+ */
+static void _bf_plan_add(List plan_list, node_space_map_t *node_space,
+			 bitstr_t *node_bitmap)
+{
+	sched_plan_t *plan;
+	int i, recs = 0;
+
+	if (!plan_list || !node_space) {
+		FREE_NULL_BITMAP(node_bitmap);
+		return;
+	}
+
+	for (i = 0; ; ) {
+		recs++;
+		if ((i = node_space[i].next) == 0)
+			break;
+	}
+
+	plan = xmalloc(sizeof(sched_plan_t));
+	plan->node_bitmap = node_bitmap;
+	plan->recs = xcalloc(recs, sizeof(sched_plan_rec_t));
+	for (i = 0; ; ) {
+		plan->recs[plan->rec_cnt].begin_time = node_space[i].begin_time;
+		plan->recs[plan->rec_cnt].end_time = node_space[i].end_time;
+		_ns_rec_own(&node_space[i]);
+		plan->recs[plan->rec_cnt].avail_bitmap =
+			node_space[i].avail_bitmap;
+		node_space[i].avail_bitmap = NULL;
+		plan->rec_cnt++;
+		if ((i = node_space[i].next) == 0)
+			break;
+	}
+	list_append(plan_list, plan);
+}
+
+/*
+ * Copy a node_space table, packing its records in time order
+ * IN node_space - table to copy
+ * IN extra_recs - count of unused records to add for later growth
+ * IN share - reference the bitmaps of node_space rather than copying them,
+ *	node_space must then outlive the new table. A record gets its own
+ *	copy once it is changed.
+ * OUT node_space_recs - count of records in use in the new table
+ * RET new table, release using _node_space_free()
+ */
+static node_space_map_t *_node_space_copy(node_space_map_t *node_space,
+					  int extra_recs, bool share,
+					  int *node_space_recs)
+{
+	node_space_map_t *new_space;
+	int i, recs = 0;
+
+	for (i = 0; ; ) {
+		recs++;
+		if ((i = node_space[i].next) == 0)
+			break;
+	}
+	new_space = xmalloc(sizeof(node_space_map_t) * (recs + extra_recs));
+	for (i = 0, recs = 0; ; recs++) {
+		new_space[recs].begin_time = node_space[i].begin_time;
+		new_space[recs].end_time = node_space[i].end_time;
+		if (share) {
+			new_space[recs].avail_bitmap =
+				node_space[i].avail_bitmap;
+			new_space[recs].shared = true;
+		} else {
+			new_space[recs].avail_bitmap =
+				bit_copy(node_space[i].avail_bitmap);
+		}
+		if ((i = node_space[i].next) == 0)
+			break;
+		new_space[recs].next = recs + 1;
+	}
+	*node_space_recs = recs + 1;
+	_ns_skip_build(new_space);
+
+	return new_space;
+}
+
+static void _bf_running_resv_free(void *item)
+{
+	bf_running_resv_t *resv = (bf_running_resv_t *) item;
+
+	if (!resv)
+		return;
+
+	FREE_NULL_BITMAP(resv->node_bitmap);
+	xfree(resv);
+}
+
+static void _bf_running_resv_key_id(void *item, const char **key,
+				    uint32_t *key_len)
+{
+	bf_running_resv_t *resv = (bf_running_resv_t *) item;
+
+	xassert(resv);
+
+	*key = (char *) &resv->job_id;
+	*key_len = sizeof(uint32_t);
+}
+
+/* Discard running job reservations preserved from earlier backfill cycles */
+static void _bf_base_space_clear(void)
+{
+	_node_space_free(bf_base_space);
+	bf_base_space = NULL;
+	bf_base_recs = 0;
+	FREE_NULL_BITMAP(bf_base_avail);
+	xhash_free(bf_base_resv_map);
+}
+
+/*
+ * Identify running jobs with no matching preserved reservation.
+ * Jobs whose reservation is unchanged are flagged as seen, others are added to
+ * the add_list. Preserved reservations not seen get removed by the caller.
+ */
+static int _bf_running_resv_delta(void *x, void *arg)
+{
+	job_record_t *job_ptr = (job_record_t *) x;
+	bf_running_delta_t *delta = (bf_running_delta_t *) arg;
+	bf_running_resv_t *resv;
+	time_t end_time;
+
+	if (!_bf_running_job_resv_ok(job_ptr))
+		return SLURM_SUCCESS;
+
+	end_time = (job_ptr->end_time / backfill_resolution) *
+		   backfill_resolution;
+	if (end_time <= delta->begin_time)
+		return SLURM_SUCCESS;	/* Past time limit, no effect on plan */
+	resv = xhash_get(bf_base_resv_map, (char *) &job_ptr->job_id,
+			 sizeof(uint32_t));
+	if (resv && (resv->end_time == end_time) &&
+	    bit_equal(resv->node_bitmap, job_ptr->node_bitmap)) {
+		resv->seen = true;
+		return SLURM_SUCCESS;
+	}
+	/* New job or its end time/allocation changed (old record not seen) */
+	list_append(delta->add_list, job_ptr);
+
+	return SLURM_SUCCESS;
+}
+
+static void _bf_running_resv_unseen(void *item, void *arg)
+{
+	bf_running_resv_t *resv = (bf_running_resv_t *) item;
+	List rm_list = (List) arg;
+
+	if (!resv->seen)
+		list_append(rm_list, resv);
+}
+
+typedef struct {
+	node_space_map_t *node_space;
+	int *node_space_recs;
+	bitstr_t *rm_bitmap;
+	time_t old_end_time;
+} bf_running_reapply_t;
+
+/*
+ * Re-apply a preserved reservation which either extends beyond the end of the
+ * preserved table or overlaps with nodes of a removed reservation. Adding an
+ * existing reservation again is harmless.
+ */
+static void _bf_running_resv_reapply(void *item, void *arg)
+{
+	bf_running_resv_t *resv = (bf_running_resv_t *) item;
+	bf_running_reapply_t *reapply = (bf_running_reapply_t *) arg;
+	bitstr_t *tmp_bitmap;
+
+	resv->seen = false;
+	if ((resv->end_time <= reapply->old_end_time) &&
+	    (!reapply->rm_bitmap ||
+	     !bit_overlap_any(resv->node_bitmap, reapply->rm_bitmap)))
+		return;
+
+	tmp_bitmap = bit_copy(resv->node_bitmap);
+	bit_not(tmp_bitmap);
+	_add_reservation(reapply->node_space[0].begin_time, resv->end_time,
+			 tmp_bitmap, reapply->node_space,
+			 reapply->node_space_recs);
+	FREE_NULL_BITMAP(tmp_bitmap);
+}
+
+/*
+ * Release the nodes of a removed running job reservation. Running whole node
+ * jobs can not share nodes, so no other reservation covers those nodes.
+ */
+static void _rm_reservation(time_t end_reserve, bitstr_t *node_bitmap,
+			    node_space_map_t *node_space)
+{
+	bitstr_t *tmp_bitmap = bit_copy(node_bitmap);
+	int j;
+
+	_bf_shape_clear();
+	bit_and(tmp_bitmap, bf_base_avail);
+	for (j = 0; ; ) {
+		if (node_space[j].begin_time >= end_reserve)
+			break;
+		bit_or(node_space[j].avail_bitmap, tmp_bitmap);
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
+	FREE_NULL_BITMAP(tmp_bitmap);
+}
+
+/*
+ * Build the initial node_space table holding reservations for running jobs,
+ * starting from the table preserved by the previous backfill cycle and only
+ * applying changes since then (jobs which started, ended or had their time
+ * limit changed). The table is built from scratch if the available nodes
+ * changed.
+ * IN begin_time - start of the backfill window
+ * IN end_time - end of the backfill window
+ * IN extra_recs - count of unused records to add for pending job reservations
+ * OUT node_space_recs - count of records in use in the new table
+ * RET new table, release using _node_space_free()
+ */
+static node_space_map_t *_bf_base_space_build(time_t begin_time,
+					      time_t end_time, int extra_recs,
+					      int *node_space_recs)
+{
+	node_space_map_t *node_space;
+	bf_running_delta_t delta;
+	bf_running_reapply_t reapply;
+	bf_running_resv_t *resv;
+	job_record_t *job_ptr;
+	bitstr_t *cur_avail, *tmp_bitmap;
+	List rm_list;
+	ListIterator iter;
+	time_t old_end_time;
+	int i, first, reused = 0;
+
+	cur_avail = bit_copy(avail_node_bitmap);
+	/* Make "resuming" nodes available to be scheduled in backfill */
+	bit_or(cur_avail, rs_node_bitmap);
+	if (bf_base_space &&
+	    ((bf_base_space[bf_base_recs - 1].end_time <= begin_time) ||
+	     (bf_base_space[bf_base_recs - 1].end_time > end_time) ||
+	     !bit_equal(bf_base_avail, cur_avail))) {
+		log_flag(BACKFILL, "rebuilding running job reservations");
+		_bf_base_space_clear();
+	}
+	if (!bf_base_space) {
+		bf_base_space = xmalloc(sizeof(node_space_map_t));
+		bf_base_space[0].begin_time = begin_time;
+		bf_base_space[0].end_time = end_time;
+		bf_base_space[0].avail_bitmap = bit_copy(cur_avail);
+		bf_base_space[0].next = 0;
+		bf_base_recs = 1;
+		bf_base_resv_map = xhash_init(_bf_running_resv_key_id,
+					      _bf_running_resv_free);
+		bf_base_avail = cur_avail;
+	} else
+		FREE_NULL_BITMAP(cur_avail);
+
+	delta.add_list = list_create(NULL);
+	delta.begin_time = begin_time;
+	list_for_each(job_list, _bf_running_resv_delta, &delta);
+
+	node_space = _node_space_copy(bf_base_space,
+				      (xhash_count(bf_base_resv_map) +
+				       list_count(delta.add_list)) * 2 +
+				      extra_recs + 1, false,
+				      node_space_recs);
+
+	/* Discard records which ended before this cycle */
+	for (first = 0; node_space[first].end_time <= begin_time; first++)
+		_ns_rec_free(&node_space[first]);
+	if (first) {
+		*node_space_recs -= first;
+		memmove(node_space, node_space + first,
+			sizeof(node_space_map_t) * (*node_space_recs));
+		memset(node_space + *node_space_recs, 0,
+		       sizeof(node_space_map_t) * first);
+		for (i = 0; i < (*node_space_recs - 1); i++)
+			node_space[i].next = i + 1;
+		node_space[*node_space_recs - 1].next = 0;
+	}
+	node_space[0].begin_time = begin_time;
+
+	/* Extend the table to the end of this cycle's backfill window */
+	old_end_time = node_space[*node_space_recs - 1].end_time;
+	if ((old_end_time < end_time) &&
+	    bit_equal(node_space[*node_space_recs - 1].avail_bitmap,
+		      bf_base_avail)) {
+		node_space[*node_space_recs - 1].end_time = end_time;
+	} else if (old_end_time < end_time) {
+		i = *node_space_recs;
+		node_space[i].begin_time = old_end_time;
+		node_space[i].end_time = end_time;
+		node_space[i].avail_bitmap = bit_copy(bf_base_avail);
+		node_space[i].next = 0;
+		node_space[i - 1].next = i;
+		(*node_space_recs)++;
+	}
+	/* Records were moved or added, rebuild any skip list links */
+	_ns_skip_build(node_space);
+
+	/* Remove reservations of jobs no longer running as recorded */
+	rm_list = list_create(NULL);
+	xhash_walk(bf_base_resv_map, _bf_running_resv_unseen, rm_list);
+	reapply.rm_bitmap = NULL;
+	iter = list_iterator_create(rm_list);
+	while ((resv = list_next(iter))) {
+		_rm_reservation(resv->end_time, resv->node_bitmap, node_space);
+		if (!reapply.rm_bitmap)
+			reapply.rm_bitmap = bit_copy(resv->node_bitmap);
+		else
+			bit_or(reapply.rm_bitmap, resv->node_bitmap);
+		xhash_delete(bf_base_resv_map, (char *) &resv->job_id,
+			     sizeof(uint32_t));
+	}
+	list_iterator_destroy(iter);
+	FREE_NULL_LIST(rm_list);
+
+	reused = xhash_count(bf_base_resv_map);
+	reapply.node_space = node_space;
+	reapply.node_space_recs = node_space_recs;
+	reapply.old_end_time = old_end_time;
+	xhash_walk(bf_base_resv_map, _bf_running_resv_reapply, &reapply);
+	FREE_NULL_BITMAP(reapply.rm_bitmap);
+
+	/* Add reservations for newly started (or modified) jobs */
+	iter = list_iterator_create(delta.add_list);
+	while ((job_ptr = list_next(iter))) {
+		resv = xmalloc(sizeof(bf_running_resv_t));
+		resv->job_id = job_ptr->job_id;
+		resv->end_time = (job_ptr->end_time / backfill_resolution) *
+				 backfill_resolution;
+		resv->node_bitmap = bit_copy(job_ptr->node_bitmap);
+		xhash_add(bf_base_resv_map, resv);
+
+		tmp_bitmap = bit_copy(job_ptr->node_bitmap);
+		bit_not(tmp_bitmap);
+		_add_reservation(begin_time, resv->end_time, tmp_bitmap,
+				 node_space, node_space_recs);
+		FREE_NULL_BITMAP(tmp_bitmap);
+	}
+	list_iterator_destroy(iter);
+
+	log_flag(BACKFILL, "running job reservations: %d reused, %d added, table size %d",
+		 reused, list_count(delta.add_list), *node_space_recs);
+	FREE_NULL_LIST(delta.add_list);
+
+	/* Preserve the table for the next cycle */
+	_node_space_free(bf_base_space);
+	bf_base_space = _node_space_copy(node_space, 0, false, &bf_base_recs);
+
+	return node_space;
+}
+
 static int _set_hetjob_details(void *x, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *) x;
@@ -1401,7 +2130,75 @@ static int _set_hetjob_details(void *x, void *arg)
 			      _foreach_het_job_details, details);
 	}
 
-	return SLURM_SUCCESS;
+	return SLURM_SUCCESS;
+}
+
+/* Discard all bf_job_shape_cache records */
+static void _bf_shape_clear(void)
+{
+	int i;
+
+	for (i = 0; i < BF_SHAPE_CACHE_SIZE; i++)
+		xfree(bf_shape_cache[i].key);
+	bf_shape_next = 0;
+}
+
+/*
+ * Build a job_shape_key() for a job extended with the node counts, time limit
+ * and reservation mode calculated for this partition by the backfill loop
+ * RET key to be xfree'd by caller or NULL if the job can not use the cache
+ */
+static char *_bf_shape_key(job_record_t *job_ptr, uint32_t min_nodes,
+			   uint32_t req_nodes, uint32_t max_nodes,
+			   uint32_t time_limit, uint32_t job_no_reserve)
+{
+	char *key;
+
+	if (!bf_job_shape_cache || assoc_limit_stop ||
+	    !(key = job_shape_key(job_ptr)))
+		return NULL;
+
+	xstrfmtcat(key, ":%u:%u:%u:%u:%u", min_nodes, req_nodes, max_nodes,
+		   time_limit, job_no_reserve);
+
+	return key;
+}
+
+/* Find the bf_job_shape_cache record for a key, NULL if none */
+static bf_shape_rec_t *_bf_shape_find(char *key)
+{
+	int i;
+
+	if (!key)
+		return NULL;
+
+	for (i = 0; i < BF_SHAPE_CACHE_SIZE; i++) {
+		if (bf_shape_cache[i].key && !xstrcmp(bf_shape_cache[i].key, key))
+			return &bf_shape_cache[i];
+	}
+
+	return NULL;
+}
+
+/*
+ * Record the outcome of testing a job in bf_job_shape_cache, replacing the
+ * oldest record once the cache is full
+ * key IN/OUT - from _bf_shape_key(), ownership moves to the cache
+ * start_time IN - expected start time, 0 if unable to run
+ */
+static void _bf_shape_add(char **key, time_t start_time)
+{
+	bf_shape_rec_t *shape_ptr;
+
+	if (!*key)
+		return;
+
+	shape_ptr = &bf_shape_cache[bf_shape_next];
+	bf_shape_next = (bf_shape_next + 1) % BF_SHAPE_CACHE_SIZE;
+	xfree(shape_ptr->key);
+	shape_ptr->key = *key;
+	shape_ptr->start_time = start_time;
+	*key = NULL;
 }
 
 /* Fetch key from xhash_t item. Called from function ptr */
@@ -1612,10 +2409,355 @@ static void _handle_planned(bool set)
 		last_node_update = time(NULL);
 }
 
+/* Free the partition groups and their node_space tables */
+static void _bf_part_groups_free(void)
+{
+	int i;
+
+	for (i = 0; i < bf_part_group_cnt; i++) {
+		FREE_NULL_BITMAP(bf_part_groups[i].node_bitmap);
+		_node_space_free(bf_part_groups[i].node_space);
+	}
+	xfree(bf_part_groups);
+	bf_part_group_cnt = 0;
+	bf_part_group_cur = -1;
+	xfree(bf_part_group_map);
+	bf_part_group_map_cnt = 0;
+	_node_space_free(bf_part_group_base);
+	bf_part_group_base = NULL;
+}
+
+/*
+ * Split partitions into groups with disjoint node sets. Partitions sharing
+ * any node, directly or through other partitions, are in the same group.
+ * Backfill reservations made in one group never affect the nodes of another
+ * group, so each group gets its own copy of the initial node_space table.
+ * This keeps each table limited to the reservations relevant to the jobs
+ * evaluated against it. The copies share the bitmaps of the initial table
+ * until a group changes them.
+ * IN node_space - initial node_space table, kept as bf_part_group_base when
+ *	groups are used
+ * IN extra_recs - count of unused records to add to each copy
+ * RET true if more than one group was found
+ */
+static bool _bf_part_groups_build(node_space_map_t *node_space,
+				  int extra_recs)
+{
+	ListIterator part_iterator;
+	part_record_t *part_ptr;
+	int i, j, g, group_cnt = 0;
+
+	bf_part_group_map = xcalloc(list_count(part_list),
+				    sizeof(bf_part_group_map_t));
+	bf_part_groups = xcalloc(list_count(part_list),
+				 sizeof(bf_part_group_t));
+	part_iterator = list_iterator_create(part_list);
+	while ((part_ptr = list_next(part_iterator))) {
+		if (!part_ptr->node_bitmap)
+			continue;
+		g = -1;
+		for (j = 0; j < group_cnt; j++) {
+			if (!bf_part_groups[j].node_bitmap ||
+			    !bit_overlap_any(bf_part_groups[j].node_bitmap,
+					     part_ptr->node_bitmap))
+				continue;
+			if (g == -1) {
+				g = j;
+				bit_or(bf_part_groups[g].node_bitmap,
+				       part_ptr->node_bitmap);
+				continue;
+			}
+			/* Partition links groups "g" and "j", merge them */
+			bit_or(bf_part_groups[g].node_bitmap,
+			       bf_part_groups[j].node_bitmap);
+			FREE_NULL_BITMAP(bf_part_groups[j].node_bitmap);
+			for (i = 0; i < bf_part_group_map_cnt; i++) {
+				if (bf_part_group_map[i].group == j)
+					bf_part_group_map[i].group = g;
+			}
+		}
+		if (g == -1) {
+			g = group_cnt++;
+			bf_part_groups[g].node_bitmap =
+				bit_copy(part_ptr->node_bitmap);
+		}
+		bf_part_group_map[bf_part_group_map_cnt].part_ptr = part_ptr;
+		bf_part_group_map[bf_part_group_map_cnt].group = g;
+		bf_part_group_map_cnt++;
+	}
+	list_iterator_destroy(part_iterator);
+
+	/* Pack the groups still in use */
+	for (i = 0, bf_part_group_cnt = 0; i < group_cnt; i++) {
+		if (!bf_part_groups[i].node_bitmap)
+			continue;
+		for (j = 0; j < bf_part_group_map_cnt; j++) {
+			if (bf_part_group_map[j].group == i)
+				bf_part_group_map[j].group = bf_part_group_cnt;
+		}
+		bf_part_groups[bf_part_group_cnt++].node_bitmap =
+			bf_part_groups[i].node_bitmap;
+	}
+
+	if (bf_part_group_cnt <= 1) {
+		_bf_part_groups_free();
+		return false;
+	}
+
+	bf_part_group_base = node_space;
+	for (i = 0; i < bf_part_group_cnt; i++) {
+		bf_part_groups[i].node_space =
+			_node_space_copy(node_space, extra_recs, true,
+					 &bf_part_groups[i].node_space_recs);
+	}
+	log_flag(BACKFILL, "%d partitions in %d groups with disjoint nodes",
+		 bf_part_group_map_cnt, bf_part_group_cnt);
+
+	return true;
+}
+
+/* Return the index of the partition group containing part_ptr, -1 if none */
+static int _bf_part_group_find(part_record_t *part_ptr)
+{
+	int i;
+
+	for (i = 0; i < bf_part_group_map_cnt; i++) {
+		if (bf_part_group_map[i].part_ptr == part_ptr)
+			return bf_part_group_map[i].group;
+	}
+
+	return -1;
+}
+
+/*
+ * Return the node_space table to use for a job in the given partition:
+ * that partition group's table if partition groups are in use, otherwise
+ * the default node_space table. A partition outside of all groups gets the
+ * initial table, without the backfill reservations of this cycle.
+ */
+static node_space_map_t *_bf_part_group_space(part_record_t *part_ptr,
+					      node_space_map_t *node_space)
+{
+	int g;
+
+	if (!bf_part_group_cnt)
+		return node_space;
+	if ((g = _bf_part_group_find(part_ptr)) < 0)
+		return bf_part_group_base;
+
+	return bf_part_groups[g].node_space;
+}
+
+/*
+ * Make the node_space table of part_ptr's partition group the active one
+ * RET false if partition groups are in use and part_ptr is in none of them,
+ *	as for a partition without nodes when the groups were built
+ */
+static bool _bf_part_group_switch(part_record_t *part_ptr,
+				  node_space_map_t **node_space,
+				  int *node_space_recs)
+{
+	int g;
+
+	if (!bf_part_group_cnt)
+		return true;
+	if ((g = _bf_part_group_find(part_ptr)) < 0)
+		return false;
+	if (g == bf_part_group_cur)
+		return true;
+
+	if (bf_part_group_cur >= 0)
+		bf_part_groups[bf_part_group_cur].node_space_recs =
+			*node_space_recs;
+	bf_part_group_cur = g;
+	*node_space = bf_part_groups[g].node_space;
+	*node_space_recs = bf_part_groups[g].node_space_recs;
+
+	return true;
+}
+
+/* Return the bf_lic_names index of a license, -1 if not found */
+static int _bf_lic_inx(char *name)
+{
+	int i;
+
+	for (i = 0; i < bf_lic_cnt; i++) {
+		if (!xstrcmp(bf_lic_names[i], name))
+			return i;
+	}
+
+	return -1;
+}
+
+/*
+ * Make sure a bf_lic_space record begins at the given time
+ * RET index of the record beginning at "when", bf_lic_space_cnt if "when" is
+ *	at or after the end of the table
+ */
+static int _bf_lic_split(time_t when)
+{
+	int i;
+
+	for (i = 0; i < bf_lic_space_cnt; i++) {
+		if (when <= bf_lic_space[i].begin_time)
+			return i;
+		if (when < bf_lic_space[i].end_time)
+			break;
+	}
+	if (i >= bf_lic_space_cnt)
+		return bf_lic_space_cnt;
+
+	if (bf_lic_space_cnt >= bf_lic_space_size) {
+		bf_lic_space_size *= 2;
+		xrecalloc(bf_lic_space, bf_lic_space_size,
+			  sizeof(bf_lic_space_t));
+	}
+	memmove(&bf_lic_space[i + 1], &bf_lic_space[i],
+		sizeof(bf_lic_space_t) * (bf_lic_space_cnt - i));
+	bf_lic_space_cnt++;
+	bf_lic_space[i + 1].avail = xcalloc(bf_lic_cnt, sizeof(uint32_t));
+	memcpy(bf_lic_space[i + 1].avail, bf_lic_space[i].avail,
+	       sizeof(uint32_t) * bf_lic_cnt);
+	bf_lic_space[i].end_time = when;
+	bf_lic_space[i + 1].begin_time = when;
+
+	return i + 1;
+}
+
+/*
+ * Update bf_lic_space for licenses used from start_time to end_time
+ * IN release - true if the licenses become available, false if used
+ */
+static void _bf_lic_update(List license_list, time_t start_time,
+			   time_t end_time, bool release)
+{
+	ListIterator iter;
+	licenses_t *license_entry;
+	int i, first, last, inx;
+
+	if (!license_list || (start_time >= end_time))
+		return;
+
+	first = _bf_lic_split(start_time);
+	last = _bf_lic_split(end_time);
+	iter = list_iterator_create(license_list);
+	while ((license_entry = list_next(iter))) {
+		if ((inx = _bf_lic_inx(license_entry->name)) < 0)
+			continue;
+		for (i = first; i < last; i++) {
+			if (release)
+				bf_lic_space[i].avail[inx] +=
+					license_entry->total;
+			else if (bf_lic_space[i].avail[inx] >
+				 license_entry->total)
+				bf_lic_space[i].avail[inx] -=
+					license_entry->total;
+			else
+				bf_lic_space[i].avail[inx] = 0;
+		}
+	}
+	list_iterator_destroy(iter);
+}
+
+/*
+ * Test if licenses are available from start_time to end_time
+ * RET 0 if available, otherwise the earliest time the job might start: the
+ *	end of the last time range lacking one of the licenses
+ */
+static time_t _bf_lic_test(List license_list, time_t start_time,
+			   time_t end_time)
+{
+	ListIterator iter;
+	licenses_t *license_entry;
+	time_t later_start = 0;
+	int i, inx;
+
+	if (!license_list)
+		return later_start;
+
+	iter = list_iterator_create(license_list);
+	while ((license_entry = list_next(iter))) {
+		if ((inx = _bf_lic_inx(license_entry->name)) < 0)
+			continue;	/* rejected by license_job_test() */
+		for (i = 0; i < bf_lic_space_cnt; i++) {
+			if (bf_lic_space[i].end_time <= start_time)
+				continue;
+			if (bf_lic_space[i].begin_time >= end_time)
+				break;
+			if ((bf_lic_space[i].avail[inx] < license_entry->total) &&
+			    (bf_lic_space[i].end_time > later_start))
+				later_start = bf_lic_space[i].end_time;
+		}
+	}
+	list_iterator_destroy(iter);
+
+	return later_start;
+}
+
+/*
+ * Build bf_lic_space for the backfill window: licenses not in use now, with
+ * those of running jobs returned at their end time
+ */
+static void _bf_lic_build(time_t start_time, time_t end_time)
+{
+	ListIterator iter;
+	licenses_t *license_entry;
+	job_record_t *job_ptr;
+	List avail_list;
+
+	if (!(avail_list = license_copy_avail()))
+		return;
+
+	bf_lic_cnt = list_count(avail_list);
+	bf_lic_names = xcalloc(bf_lic_cnt, sizeof(char *));
+	bf_lic_space_size = 16;
+	bf_lic_space = xcalloc(bf_lic_space_size, sizeof(bf_lic_space_t));
+	bf_lic_space_cnt = 1;
+	bf_lic_space[0].begin_time = start_time;
+	bf_lic_space[0].end_time = end_time;
+	bf_lic_space[0].avail = xcalloc(bf_lic_cnt, sizeof(uint32_t));
+	bf_lic_cnt = 0;
+	iter = list_iterator_create(avail_list);
+	while ((license_entry = list_next(iter))) {
+		bf_lic_names[bf_lic_cnt] = license_entry->name;
+		license_entry->name = NULL;
+		bf_lic_space[0].avail[bf_lic_cnt++] = license_entry->total;
+	}
+	list_iterator_destroy(iter);
+	FREE_NULL_LIST(avail_list);
+
+	iter = list_iterator_create(job_list);
+	while ((job_ptr = list_next(iter))) {
+		if (!IS_JOB_RUNNING(job_ptr) || !job_ptr->license_list ||
+		    (job_ptr->end_time >= end_time))
+			continue;
+		_bf_lic_update(job_ptr->license_list,
+			       MAX(job_ptr->end_time, start_time), end_time,
+			       true);
+	}
+	list_iterator_destroy(iter);
+}
+
+static void _bf_lic_free(void)
+{
+	int i;
+
+	for (i = 0; i < bf_lic_space_cnt; i++)
+		xfree(bf_lic_space[i].avail);
+	xfree(bf_lic_space);
+	bf_lic_space_cnt = 0;
+	bf_lic_space_size = 0;
+	for (i = 0; i < bf_lic_cnt; i++)
+		xfree(bf_lic_names[i]);
+	xfree(bf_lic_names);
+	bf_lic_cnt = 0;
+}
+
 static int _attempt_backfill(void)
 {
 	DEF_TIMERS;
-	List job_queue;
+	List job_queue, plan_list = NULL;
+	job_queue_heap_t *job_heap;
 	job_queue_rec_t *job_queue_rec;
 	int bb, i, j, node_space_recs, mcs_select = 0;
 	slurmdb_qos_rec_t *qos_ptr = NULL;
@@ -1639,7 +2781,7 @@ static int _attempt_backfill(void)
 	uint32_t start_time;
 	time_t config_update = slurm_conf.last_update;
 	time_t part_update = last_part_update;
-	struct timeval start_tv;
+	struct timeval start_tv, phase_tv = {0, 0};
 	uint32_t test_array_job_id = 0;
 	uint32_t test_array_count = 0;
 	uint32_t job_no_reserve;
@@ -1648,9 +2790,12 @@ static int _attempt_backfill(void)
 	int test_fini;
 	uint32_t qos_flags = 0;
 	time_t qos_blocked_until = 0, qos_part_blocked_until = 0;
+	time_t lic_start;
 	time_t tmp_preempt_start_time = 0;
 	bool tmp_preempt_in_progress = false;
 	bitstr_t *tmp_bitmap = NULL;
+	bf_shape_rec_t *shape_ptr;
+	char *shape_key = NULL;
 	/* QOS Read lock */
 	assoc_mgr_lock_t qos_read_lock =
 		{ NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK,
@@ -1661,6 +2806,7 @@ static int _attempt_backfill(void)
 
 	if (!fed_mgr_sibs_synced()) {
 		info("returning, federation siblings not synced yet");
+		sched_plan_set(NULL);
 		return SLURM_SUCCESS;
 	}
 
@@ -1675,8 +2821,11 @@ static int _attempt_backfill(void)
 	gettimeofday(&start_tv, NULL);
 
 	_handle_planned(false);
+	_bf_shape_clear();
 
+	(void) slurm_delta_tv(&phase_tv);
 	job_queue = build_job_queue(true, true);
+	slurmctld_diag_stats.bf_queue_build_sum += slurm_delta_tv(&phase_tv);
 	job_test_count = list_count(job_queue);
 	if (job_test_count == 0) {
 		if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL)
@@ -1684,6 +2833,7 @@ static int _attempt_backfill(void)
 		else
 			debug("no jobs to backfill");
 		FREE_NULL_LIST(job_queue);
+		sched_plan_set(NULL);
 		return 0;
 	} else
 		debug("%u jobs to backfill", job_test_count);
@@ -1704,20 +2854,27 @@ static int _attempt_backfill(void)
 	slurmctld_diag_stats.bf_last_depth_try = 0;
 	slurmctld_diag_stats.bf_when_last_cycle = now;
 
-	node_space = xmalloc(sizeof(node_space_map_t) *
-			     (max_backfill_job_cnt * 2 + 1));
-	node_space[0].begin_time = sched_start;
 	window_end = sched_start + backfill_window;
-	node_space[0].end_time = window_end;
-
-	node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
-	/* Make "resuming" nodes available to be scheduled in backfill */
-	bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
-
-	node_space[0].next = 0;
-	node_space_recs = 1;
+	if (bf_running_job_reserve && bf_incremental) {
+		node_space = _bf_base_space_build(sched_start, window_end,
+						  max_backfill_job_cnt * 2 + 1,
+						  &node_space_recs);
+	} else {
+		node_space = xmalloc(sizeof(node_space_map_t) *
+				     (max_backfill_job_cnt * 2 + 1));
+		node_space[0].begin_time = sched_start;
+		node_space[0].end_time = window_end;
+
+		node_space[0].avail_bitmap = bit_copy(avail_node_bitmap);
+		/* Make "resuming" nodes available to be scheduled in backfill */
+		bit_or(node_space[0].avail_bitmap, rs_node_bitmap);
+
+		node_space[0].next = 0;
+		node_space_recs = 1;
+		_ns_skip_build(node_space);
+	}
 
-	if (bf_running_job_reserve) {
+	if (bf_running_job_reserve && !bf_incremental) {
 		node_space_handler_t node_space_handler;
 		node_space_handler.node_space = node_space;
 		node_space_handler.node_space_recs = &node_space_recs;
@@ -1729,6 +2886,17 @@ static int _attempt_backfill(void)
 	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 		_dump_node_space_table(node_space);
 
+	if (bf_licenses)
+		_bf_lic_build(sched_start, window_end);
+
+	if (bf_part_groups_enable &&
+	    _bf_part_groups_build(node_space, max_backfill_job_cnt * 2 + 1)) {
+		node_space = NULL;
+		bf_part_group_cur = -1;
+		(void) _bf_part_group_switch(bf_part_group_map[0].part_ptr,
+					     &node_space, &node_space_recs);
+	}
+
 	if (assoc_limit_stop) {
 		assoc_mgr_lock(&qos_read_lock);
 		list_for_each(assoc_mgr_qos_list,
@@ -1736,7 +2904,7 @@ static int _attempt_backfill(void)
 		assoc_mgr_unlock(&qos_read_lock);
 	}
 
-	sort_job_queue(job_queue);
+	job_heap = job_queue_heap_create(job_queue);
 
 	/* Ignore nodes that have been set as available during this cycle. */
 	bit_clear_all(bf_ignore_node_bitmap);
@@ -1746,6 +2914,7 @@ static int _attempt_backfill(void)
 		bool get_boot_time = false;
 
 		/* Run some final guaranteed logic after each job iteration */
+		sched_trace_end();
 		if (job_ptr) {
 			job_resv_clear_magnetic_flag(job_ptr);
 			fill_array_reasons(job_ptr, reject_array_job);
@@ -1754,7 +2923,7 @@ static int _attempt_backfill(void)
 			_restore_preempt_state(job_ptr, &tmp_preempt_start_time,
 			                       &tmp_preempt_in_progress);
 		}
-		job_queue_rec = (job_queue_rec_t *) list_pop(job_queue);
+		job_queue_rec = job_queue_heap_pop(job_heap);
 		if (!job_queue_rec) {
 			log_flag(BACKFILL, "reached end of job queue");
 			break;
@@ -1962,6 +3131,7 @@ static int _attempt_backfill(void)
 		orig_time_limit = job_ptr->time_limit;
 
 next_task:
+		sched_trace_begin(job_ptr, SCHED_TRACE_BACKFILL);
 		/*
 		 * Save the current preemption state. Reset preemption state
 		 * in the job_ptr so a job array can preempt multiple jobs.
@@ -2017,10 +3187,17 @@ next_task:
 				 job_ptr->part_ptr->name);
 			continue;
 		}
+		if (!_bf_part_group_switch(part_ptr, &node_space,
+					   &node_space_recs)) {
+			log_flag(BACKFILL, "partition %s not in a partition group",
+				 job_ptr->part_ptr->name);
+			continue;
+		}
 
-		if ((!job_independent(job_ptr)) ||
-		    (license_job_test(job_ptr, time(NULL), true) !=
-		     SLURM_SUCCESS)) {
+		if (!job_independent(job_ptr) ||
+		    (((j = license_job_test(job_ptr, time(NULL), true)) !=
+		      SLURM_SUCCESS) &&
+		     (!bf_licenses || (j != EAGAIN)))) {
 			log_flag(BACKFILL, "%pJ not runable now",
 				 job_ptr);
 			continue;
@@ -2098,6 +3275,23 @@ next_task:
 			}
 		}
 
+		xfree(shape_key);
+		shape_key = _bf_shape_key(job_ptr, min_nodes, req_nodes,
+					  max_nodes, time_limit,
+					  job_no_reserve);
+		if ((shape_ptr = _bf_shape_find(shape_key))) {
+			log_flag(BACKFILL, "%pJ has the same request as a job already tested, expected start %ld",
+				 job_ptr, shape_ptr->start_time);
+			_set_job_time_limit(job_ptr, orig_time_limit);
+			if (shape_ptr->start_time &&
+			    ((orig_start_time == 0) ||
+			     (orig_start_time >= shape_ptr->start_time)))
+				job_ptr->start_time = shape_ptr->start_time;
+			else
+				job_ptr->start_time = orig_start_time;
+			continue;
+		}
+
  TRY_LATER:
 		if (slurmctld_config.shutdown_time ||
 		    (difftime(time(NULL), orig_sched_start) >=
@@ -2164,6 +3358,7 @@ next_task:
 			 */
 			if (!_job_runnable_now(job_ptr))
 				continue;
+			sched_trace_begin(job_ptr, SCHED_TRACE_BACKFILL);
 			if (!avail_front_end(job_ptr)) {
 				log_flag(BACKFILL, "%pJ no frontend available after bf yield",
 					 job_ptr);
@@ -2204,6 +3399,20 @@ next_task:
 		if (resv_overlap)
 			resv_end = find_resv_end(start_res,
 						 backfill_resolution);
+		if (bf_licenses &&
+		    (lic_start = _bf_lic_test(job_ptr->license_list,
+					      MAX(start_res, now), end_time))) {
+			log_flag(BACKFILL, "%pJ licenses unavailable until %ld",
+				 job_ptr, lic_start);
+			if ((lic_start < window_end) && !job_no_reserve) {
+				later_start = lic_start;
+				job_ptr->start_time = 0;
+				goto TRY_LATER;
+			}
+			_set_job_time_limit(job_ptr, orig_time_limit);
+			job_ptr->start_time = orig_start_time;
+			continue;
+		}
 		/* Identify usable nodes for this job */
 		bit_and(avail_bitmap, part_ptr->node_bitmap);
 		bit_and(avail_bitmap, up_node_bitmap);
@@ -2211,7 +3420,11 @@ next_task:
 		filter_by_node_owner(job_ptr, avail_bitmap);
 		filter_by_node_mcs(job_ptr, mcs_select, avail_bitmap);
 		tmp_bitmap = bit_copy(avail_bitmap);
-		for (j = 0; ; ) {
+		if (bf_node_space_skiplist)
+			j = _ns_skip_find(node_space, start_res, NULL);
+		else
+			j = 0;
+		for ( ; ; ) {
 			if ((node_space[j].end_time > start_res) &&
 			     node_space[j].next && (later_start == 0)) {
 				int tmp = node_space[j].next;
@@ -2359,7 +3572,11 @@ next_task:
 			orig_end_time = end_time;
 			end_time += boot_time;
 
-			for (j = 0; ; ) {
+			if (bf_node_space_skiplist)
+				j = _ns_skip_find(node_space, start_res, NULL);
+			else
+				j = 0;
+			for ( ; ; ) {
 				if (node_space[j].end_time <= start_res)
 					;
 				else if (node_space[j].begin_time <= end_time) {
@@ -2395,6 +3612,7 @@ next_task:
 				goto TRY_LATER;
 			}
 			job_ptr->start_time = orig_start_time;
+			_bf_shape_add(&shape_key, 0);
 			continue;	/* not runable in this partition */
 		}
 
@@ -2576,6 +3794,11 @@ skip_start:
 				if (save_time_limit != job_ptr->time_limit)
 					jobacct_storage_job_start_direct(
 							acct_db_conn, job_ptr);
+				if (bf_licenses)
+					_bf_lic_update(job_ptr->license_list,
+						       job_ptr->start_time,
+						       job_ptr->end_time,
+						       false);
 				job_start_cnt++;
 				if (max_backfill_jobs_start &&
 				    (job_start_cnt >= max_backfill_jobs_start)){
@@ -2615,6 +3838,7 @@ skip_start:
 		}
 
 		if ((job_ptr->start_time > now) && (job_no_reserve != 0)) {
+			_bf_shape_add(&shape_key, job_ptr->start_time);
 			if ((orig_start_time != 0) &&
 			    (orig_start_time < job_ptr->start_time)) {
 				/* Can start earlier in different partition */
@@ -2649,6 +3873,7 @@ skip_start:
 			if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL)
 				_dump_job_sched(job_ptr, end_reserve,
 						avail_bitmap);
+			_bf_shape_add(&shape_key, job_ptr->start_time);
 			if ((orig_start_time != 0) &&
 			    (orig_start_time < job_ptr->start_time)) {
 				/* Can start earlier in different partition */
@@ -2703,8 +3928,17 @@ skip_start:
 			goto TRY_LATER;
 		}
 
-		if (_het_job_deadlock_test(job_ptr)) {
+		if (bf_licenses && (job_ptr->start_time > now) &&
+		    (lic_start = _bf_lic_test(job_ptr->license_list,
+					      start_time, end_reserve))) {
+			/* Licenses reserved for another job meanwhile */
+			if ((lic_start < window_end) && !job_no_reserve) {
+				later_start = lic_start;
+				job_ptr->start_time = 0;
+				goto TRY_LATER;
+			}
 			_set_job_time_limit(job_ptr, orig_time_limit);
+			job_ptr->start_time = orig_start_time;
 			continue;
 		}
 
@@ -2761,6 +3995,11 @@ skip_start:
 		if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL)
 			_dump_job_sched(job_ptr, end_reserve, avail_bitmap);
 		if (qos_flags & QOS_FLAG_NO_RESERVE) {
+			if (job_ptr->het_job_id)
+				_het_job_resv_add(job_ptr, start_time,
+						  end_reserve, avail_bitmap,
+						  false, node_space,
+						  &node_space_recs);
 			_set_job_time_limit(job_ptr, orig_time_limit);
 			continue;
 		}
@@ -2791,11 +4030,23 @@ skip_start:
 			 */
 			bit_or(planned_bitmap, avail_bitmap);
 		}
-		bit_not(avail_bitmap);
-		if ((!bf_one_resv_per_job || !orig_start_time) &&
-		    !(job_ptr->bit_flags & JOB_MAGNETIC)) {
+		if (job_ptr->het_job_id) {
+			/* Components are reserved as they are placed */
+			_het_job_resv_add(job_ptr, start_time, end_reserve,
+					  avail_bitmap,
+					  ((!bf_one_resv_per_job ||
+					    !orig_start_time) &&
+					   !(job_ptr->bit_flags &
+					     JOB_MAGNETIC)),
+					  node_space, &node_space_recs);
+		} else if ((!bf_one_resv_per_job || !orig_start_time) &&
+			   !(job_ptr->bit_flags & JOB_MAGNETIC)) {
+			bit_not(avail_bitmap);
 			_add_reservation(start_time, end_reserve, avail_bitmap,
 					 node_space, &node_space_recs);
+			if (bf_licenses)
+				_bf_lic_update(job_ptr->license_list,
+					       start_time, end_reserve, false);
 		}
 		if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL_MAP)
 			_dump_node_space_table(node_space);
@@ -2828,6 +4079,7 @@ skip_start:
 				goto next_task;
 		}
 	}
+	sched_trace_end();
 
 	_handle_planned(true);
 
@@ -2838,7 +4090,7 @@ skip_start:
 		job_resv_clear_magnetic_flag(job_ptr);
 	}
 
-	_het_job_deadlock_fini();
+	_het_job_resv_clear();
 	if (!bf_hetjob_immediate &&
 	    (!max_backfill_jobs_start ||
 	     (job_start_cnt < max_backfill_jobs_start)))
@@ -2847,13 +4099,32 @@ skip_start:
 	FREE_NULL_BITMAP(avail_bitmap);
 	FREE_NULL_BITMAP(exc_core_bitmap);
 	FREE_NULL_BITMAP(resv_bitmap);
+	xfree(shape_key);
+	_bf_shape_clear();
+	_bf_lic_free();
 
-	for (i = 0; ; ) {
-		FREE_NULL_BITMAP(node_space[i].avail_bitmap);
-		if ((i = node_space[i].next) == 0)
-			break;
+	/*
+	 * Keep the plan for will-run requests until the next cycle, unless the
+	 * cycle broke out on a state change and its plan is incomplete
+	 */
+	if (!rc)
+		plan_list = list_create(sched_plan_free);
+	if (bf_part_group_cnt) {
+		bf_part_groups[bf_part_group_cur].node_space_recs =
+			node_space_recs;
+		for (i = 0, node_space_recs = 0; i < bf_part_group_cnt; i++) {
+			node_space_recs += bf_part_groups[i].node_space_recs;
+			_bf_plan_add(plan_list, bf_part_groups[i].node_space,
+				     bf_part_groups[i].node_bitmap);
+			bf_part_groups[i].node_bitmap = NULL;
+		}
+		_bf_part_groups_free();
+	} else {
+		_bf_plan_add(plan_list, node_space, NULL);
+		_node_space_free(node_space);
 	}
-	xfree(node_space);
+	sched_plan_set(plan_list);
+	job_queue_heap_destroy(job_heap);
 	FREE_NULL_LIST(job_queue);
 
 	gettimeofday(&bf_time2, NULL);
@@ -2884,6 +4155,7 @@ static int _start_job(job_record_t *job_ptr, bitstr_t *resv_bitmap)
 	bool is_job_array_head = false;
 	static uint32_t fail_jobid = 0;
 
+	_bf_shape_clear();
 	if (job_ptr->details->exc_node_bitmap) {
 		orig_exc_nodes = bit_copy(job_ptr->details->exc_node_bitmap);
 		bit_or(job_ptr->details->exc_node_bitmap, resv_bitmap);
@@ -3057,7 +4329,15 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 	}
 #endif
 
+	_bf_shape_clear();
 	start_time = MAX(start_time, node_space[0].begin_time);
+	if (bf_node_space_skiplist) {
+		if (end_reserve > start_time)
+			_add_reservation_skip(start_time, end_reserve,
+					      res_bitmap, node_space,
+					      node_space_recs);
+		return;
+	}
 	for (j = 0; ; ) {
 		if (node_space[j].end_time > start_time) {
 			/* insert start entry record */
@@ -3105,8 +4385,10 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 
 	for (j = 0; ; ) {
 		if ((node_space[j].begin_time >= start_time) &&
-		    (node_space[j].end_time <= end_reserve))
+		    (node_space[j].end_time <= end_reserve)) {
+			_ns_rec_own(&node_space[j]);
 			bit_and(node_space[j].avail_bitmap, res_bitmap);
+		}
 		if ((node_space[j].begin_time >= end_reserve) ||
 		    ((j = node_space[j].next) == 0))
 			break;
@@ -3124,7 +4406,7 @@ static void _add_reservation(uint32_t start_time, uint32_t end_reserve,
 		}
 		node_space[i].end_time = node_space[j].end_time;
 		node_space[i].next = node_space[j].next;
-		FREE_NULL_BITMAP(node_space[j].avail_bitmap);
+		_ns_rec_free(&node_space[j]);
 		break;
 	}
 }
@@ -3142,9 +4424,14 @@ static bool _test_resv_overlap(node_space_map_t *node_space,
 			       uint32_t end_reserve)
 {
 	bool overlap = false;
-	int j;
+	int j = 0;
 
-	for (j=0; ; ) {
+	if (bf_node_space_skiplist)
+		j = _ns_skip_find(node_space, start_time, NULL);
+	for ( ; ; ) {
+		if (bf_node_space_skiplist &&
+		    (node_space[j].begin_time >= end_reserve))
+			break;
 		if ((node_space[j].end_time   > start_time) &&
 		    (node_space[j].begin_time < end_reserve) &&
 		    (!bit_super_set(use_bitmap, node_space[j].avail_bitmap))) {
@@ -3167,6 +4454,16 @@ static void _het_job_map_del(void *x)
 	xfree(map);
 }
 
+/*
+ * Delete het_job_rec_t record from het_job_rec_list
+ */
+static void _het_job_rec_del(void *x)
+{
+	het_job_rec_t *rec = (het_job_rec_t *) x;
+	FREE_NULL_BITMAP(rec->resv_bitmap);
+	xfree(rec);
+}
+
 /*
  * Return 1 if a het_job_map_t record with a specific het_job_id is found.
  * Always return 1 if "key" is zero.
@@ -3324,7 +4621,7 @@ static void _het_job_start_set(job_record_t *job_ptr, time_t latest_start,
 			map = xmalloc(sizeof(het_job_map_t));
 			map->comp_time_limit = comp_time_limit;
 			map->het_job_id = job_ptr->het_job_id;
-			map->het_job_rec_list = list_create(xfree_ptr);
+			map->het_job_rec_list = list_create(_het_job_rec_del);
 			list_append(map->het_job_rec_list, rec);
 			list_append(het_job_list, map);
 		}
@@ -3566,7 +4863,10 @@ static int _het_job_start_now(het_job_map_t *map, node_space_map_t *node_space)
 			 * beforehand for _reset_job_time_limit.
 			 */
 			if (reset_time)
-				_reset_job_time_limit(job_ptr, now, node_space);
+				_reset_job_time_limit(
+					job_ptr, now,
+					_bf_part_group_space(job_ptr->part_ptr,
+							     node_space));
 		}
 		if (reset_time)
 			jobacct_storage_job_start_direct(acct_db_conn, job_ptr);
@@ -3709,172 +5009,270 @@ static void _het_job_start_test(node_space_map_t *node_space, uint32_t het_job_i
 	}
 }
 
-static void _deadlock_global_list_del(void *x)
+/* Return the node_space table and its record count used for a partition */
+static node_space_map_t *_het_job_resv_space(part_record_t *part_ptr,
+					     node_space_map_t *node_space,
+					     int **node_space_recs)
 {
-	deadlock_part_struct_t *dl_part_ptr = (deadlock_part_struct_t *) x;
-	FREE_NULL_LIST(dl_part_ptr->deadlock_job_list);
-	xfree(dl_part_ptr);
+	int g;
+
+	if (!bf_part_group_cnt || ((g = _bf_part_group_find(part_ptr)) < 0) ||
+	    (g == bf_part_group_cur))
+		return node_space;
+
+	*node_space_recs = &bf_part_groups[g].node_space_recs;
+	return bf_part_groups[g].node_space;
 }
 
-static int _deadlock_part_list_srch(void *x, void *key)
+static int _het_job_resv_clear_rec(void *x, void *arg)
 {
-	deadlock_job_struct_t *dl_job = (deadlock_job_struct_t *) x;
-	job_record_t *job_ptr = (job_record_t *) key;
-	if (dl_job->het_job_id == job_ptr->het_job_id)
-		return 1;
-	return 0;
+	het_job_rec_t *rec = (het_job_rec_t *) x;
+
+	rec->placed = false;
+	FREE_NULL_BITMAP(rec->resv_bitmap);
+	return SLURM_SUCCESS;
 }
 
-static int _deadlock_part_list_srch2(void *x, void *key)
+static int _het_job_resv_clear_map(void *x, void *arg)
 {
-	deadlock_job_struct_t *dl_job = (deadlock_job_struct_t *) x;
-	deadlock_job_struct_t *dl_job2 = (deadlock_job_struct_t *) key;
-	if (dl_job->het_job_id == dl_job2->het_job_id)
-		return 1;
-	return 0;
+	het_job_map_t *map = (het_job_map_t *) x;
+
+	list_for_each(map->het_job_rec_list, _het_job_resv_clear_rec, NULL);
+	return SLURM_SUCCESS;
 }
 
-static int _deadlock_global_list_srch(void *x, void *key)
+/* Split the node_space record covering "when" so a record starts there */
+static void _ns_split(node_space_map_t *node_space, int *node_space_recs,
+		      time_t when)
 {
-	deadlock_part_struct_t *dl_part = (deadlock_part_struct_t *) x;
-	if (dl_part->part_ptr == (part_record_t *) key)
-		return 1;
-	return 0;
+	int update[NODE_SPACE_SKIP_LEVELS];
+	int i, j;
+
+	if (bf_node_space_skiplist) {
+		j = _ns_skip_find(node_space, when, update);
+		if ((node_space[j].begin_time < when) &&
+		    (node_space[j].end_time > when))
+			(void) _ns_skip_split(node_space, node_space_recs, j,
+					      when, update);
+		return;
+	}
+
+	for (j = 0; ; ) {
+		if ((node_space[j].begin_time < when) &&
+		    (node_space[j].end_time > when)) {
+			i = *node_space_recs;
+			node_space[i].begin_time = when;
+			node_space[i].end_time = node_space[j].end_time;
+			node_space[j].end_time = when;
+			node_space[i].avail_bitmap =
+				bit_copy(node_space[j].avail_bitmap);
+			node_space[i].next = node_space[j].next;
+			node_space[j].next = i;
+			(*node_space_recs)++;
+			break;
+		}
+		if ((j = node_space[j].next) == 0)
+			break;
+	}
 }
 
-static int _deadlock_job_list_sort(void *x, void *y)
+/*
+ * Release the nodes of a hetjob component's reservation. The nodes were
+ * free when reserved, so no other reservation holds them in that time.
+ */
+static void _het_job_rec_release(het_job_rec_t *rec,
+				 node_space_map_t *node_space,
+				 int *node_space_recs)
 {
-	deadlock_job_struct_t *dl_job_ptr1 = *(deadlock_job_struct_t **) x;
-	deadlock_job_struct_t *dl_job_ptr2 = *(deadlock_job_struct_t **) y;
-	if (dl_job_ptr1->start_time > dl_job_ptr2->start_time)
-		return -1;
-	else if (dl_job_ptr1->start_time < dl_job_ptr2->start_time)
-		return 1;
-	return 0;
+	node_space_map_t *rec_space;
+	int *rec_recs = node_space_recs, j;
+	time_t start_time;
+
+	if (!rec->resv_bitmap)
+		return;
+
+	rec_space = _het_job_resv_space(rec->part_ptr, node_space, &rec_recs);
+	_bf_shape_clear();
+	start_time = MAX(rec->resv_start, rec_space[0].begin_time);
+	if (rec->resv_end > start_time) {
+		/* Records may have been merged across the reservation edges */
+		_ns_split(rec_space, rec_recs, start_time);
+		_ns_split(rec_space, rec_recs, rec->resv_end);
+		for (j = 0; ; ) {
+			if (rec_space[j].begin_time >= rec->resv_end)
+				break;
+			if (rec_space[j].begin_time >= start_time) {
+				_ns_rec_own(&rec_space[j]);
+				bit_or(rec_space[j].avail_bitmap,
+				       rec->resv_bitmap);
+			}
+			if ((j = rec_space[j].next) == 0)
+				break;
+		}
+	}
+	if (bf_licenses)
+		_bf_lic_update(rec->job_ptr->license_list, rec->resv_start,
+			       rec->resv_end, true);
+}
+
+/* Reserve the nodes of a hetjob component from its resv_start */
+static void _het_job_rec_reserve(het_job_rec_t *rec,
+				 node_space_map_t *node_space,
+				 int *node_space_recs)
+{
+	node_space_map_t *rec_space;
+	int *rec_recs = node_space_recs;
+	bitstr_t *resv_bitmap;
+
+	rec_space = _het_job_resv_space(rec->part_ptr, node_space, &rec_recs);
+	resv_bitmap = bit_copy(rec->resv_bitmap);
+	bit_not(resv_bitmap);
+	_add_reservation(rec->resv_start, rec->resv_end, resv_bitmap,
+			 rec_space, rec_recs);
+	FREE_NULL_BITMAP(resv_bitmap);
+	if (bf_licenses)
+		_bf_lic_update(rec->job_ptr->license_list, rec->resv_start,
+			       rec->resv_end, false);
 }
 
 /*
- * Call at end of backup execution to release memory allocated by
- * _het_job_deadlock_test()
+ * Call at end of backfill cycle to forget the hetjob component placements
+ * of _het_job_resv_add(), which are only valid for this cycle's node_space
  */
-static void _het_job_deadlock_fini(void)
+static void _het_job_resv_clear(void)
 {
-	FREE_NULL_LIST(deadlock_global_list);
+	list_for_each(het_job_list, _het_job_resv_clear_map, NULL);
 }
 
 /*
- * Determine if job can run at it's "start_time" or later.
- * job_ptr IN - job to test, set reason to "HET_JOB_DEADLOCK" if it will deadlock
- * RET true if the job can not run due to possible deadlock with other hetjob
+ * Reserve the nodes and time a hetjob component is planned to use as it is
+ * placed. Once every component is placed, move their reservations to the
+ * latest of the components' start times, as the hetjob starts all of them
+ * together.
  *
- * NOTE: If there are a large number of hetjobs this will be painfully slow
- *       as the algorithm must be order n^2
+ * Holding the components' resources only from their common start time keeps
+ * hetjobs from blocking each others components in different partitions. If
+ * some component's nodes are not free at the common start time the whole
+ * hetjob does not fit: its reservations are released and that time becomes
+ * the earliest start considered for all components, so they are placed again
+ * from there.
+ * IN reserve - false if the component is placed without a reservation
  */
-static bool _het_job_deadlock_test(job_record_t *job_ptr)
+static void _het_job_resv_add(job_record_t *job_ptr, uint32_t start_time,
+			      uint32_t end_reserve, bitstr_t *node_bitmap,
+			      bool reserve, node_space_map_t *node_space,
+			      int *node_space_recs)
 {
-	deadlock_job_struct_t  *dl_job_ptr  = NULL, *dl_job_ptr2 = NULL;
-	deadlock_job_struct_t  *dl_job_ptr3 = NULL;
-	deadlock_part_struct_t *dl_part_ptr = NULL, *dl_part_ptr2 = NULL;
-	ListIterator job_iter, part_iter;
-	bool have_deadlock = false;
+	job_record_t *het_leader;
+	het_job_map_t *map;
+	het_job_rec_t *rec;
+	ListIterator iter;
+	node_space_map_t *rec_space;
+	bitstr_t *claim_bitmap = NULL;
+	int *rec_recs, placed = 0, reserved = 0;
+	uint32_t het_start = 0;
+	bool resv_ok = true, moved = false;
+
+	map = list_find_first(het_job_list, _het_job_find_map,
+			      &job_ptr->het_job_id);
+	if (!map)
+		return;
+	rec = list_find_first(map->het_job_rec_list, _het_job_find_rec,
+			      &job_ptr->job_id);
+	/* Only keep the partition where the component starts earliest */
+	if (!rec || (rec->part_ptr != job_ptr->part_ptr))
+		return;
+	/* Replace an earlier placement of this component */
+	_het_job_rec_release(rec, node_space, node_space_recs);
+	FREE_NULL_BITMAP(rec->resv_bitmap);
+	rec->placed = true;
+	rec->resv_start = start_time;
+	rec->resv_end = end_reserve;
+	if (reserve) {
+		rec->resv_bitmap = bit_copy(node_bitmap);
+		_het_job_rec_reserve(rec, node_space, node_space_recs);
+	}
 
-	if (!job_ptr->het_job_id || !job_ptr->part_ptr)
-		return false;
+	het_leader = find_job_record(job_ptr->het_job_id);
+	if (!het_leader || !het_leader->het_job_list)
+		return;
 
-	/*
-	 * Find the list representing the ordering of jobs in this specific
-	 * partition and add this job in the list, sorted by job start time
-	 */
-	if (!deadlock_global_list) {
-		deadlock_global_list = list_create(_deadlock_global_list_del);
-	} else {
-		dl_part_ptr = list_find_first(deadlock_global_list,
-					      _deadlock_global_list_srch,
-					      job_ptr->part_ptr);
-	}
-	if (!dl_part_ptr) {
-		dl_part_ptr = xmalloc(sizeof(deadlock_part_struct_t));
-		dl_part_ptr->deadlock_job_list = list_create(xfree_ptr);
-		dl_part_ptr->part_ptr = job_ptr->part_ptr;
-		list_append(deadlock_global_list, dl_part_ptr);
-	} else {
-		dl_job_ptr = list_find_first(dl_part_ptr->deadlock_job_list,
-					     _deadlock_part_list_srch,
-					     job_ptr);
+	iter = list_iterator_create(map->het_job_rec_list);
+	while ((rec = list_next(iter))) {
+		if (!rec->placed)
+			continue;
+		placed++;
+		het_start = MAX(het_start, rec->resv_start);
+		if (rec->resv_bitmap)
+			reserved++;
 	}
-	if (!dl_job_ptr) {
-		dl_job_ptr = xmalloc(sizeof(deadlock_job_struct_t));
-		dl_job_ptr->het_job_id = job_ptr->het_job_id;
-		dl_job_ptr->start_time = job_ptr->start_time;
-		list_append(dl_part_ptr->deadlock_job_list, dl_job_ptr);
-	} else if (dl_job_ptr->start_time < job_ptr->start_time) {
-		dl_job_ptr->start_time = job_ptr->start_time;
+	list_iterator_reset(iter);
+	while (!moved && (rec = list_next(iter)))
+		moved = (rec->resv_bitmap && (rec->resv_start < het_start));
+	if ((placed < list_count(het_leader->het_job_list)) || !moved) {
+		list_iterator_destroy(iter);
+		return;
 	}
-	list_sort(dl_part_ptr->deadlock_job_list, _deadlock_job_list_sort);
 
-	/*
-	 * Log current table of hetjob start times by partition
-	 */
-	if (slurm_conf.debug_flags & DEBUG_FLAG_BACKFILL) {
-		part_iter = list_iterator_create(deadlock_global_list);
-		while ((dl_part_ptr2 = (deadlock_part_struct_t *)
-				       list_next(part_iter))){
-			info("Partition %s Hetjobs:",
-			     dl_part_ptr2->part_ptr->name);
-			job_iter = list_iterator_create(dl_part_ptr2->
-							deadlock_job_list);
-			while ((dl_job_ptr2 = (deadlock_job_struct_t *)
-					      list_next(job_iter))) {
-				info("   Hetjob %u to start at %"PRIu64,
-				     dl_job_ptr2->het_job_id,
-				     (uint64_t) dl_job_ptr2->start_time);
-			}
-			list_iterator_destroy(job_iter);
+	/* Moving a reservation may split up to four node_space records */
+	list_iterator_reset(iter);
+	while ((rec = list_next(iter))) {
+		rec_recs = node_space_recs;
+		(void) _het_job_resv_space(rec->part_ptr, node_space,
+					   &rec_recs);
+		if ((*rec_recs + (reserved * 4)) >=
+		    (max_backfill_job_cnt * 2)) {
+			log_flag(HETJOB, "Hetjob %u components not moved to %u, table size limit reached",
+				 map->het_job_id, het_start);
+			list_iterator_destroy(iter);
+			return;
 		}
-		list_iterator_destroy(part_iter);
 	}
 
-	/*
-	 * Determine if any hetjobs scheduled to start earlier than this job
-	 * in this partition are scheduled to start after it in some other
-	 * partition
-	 */
-	part_iter = list_iterator_create(deadlock_global_list);
-	while ((dl_part_ptr2 = (deadlock_part_struct_t *)list_next(part_iter))){
-		if (dl_part_ptr2 == dl_part_ptr) /* Current partition, skip it */
-			continue;
-		dl_job_ptr2 = list_find_first(dl_part_ptr2->deadlock_job_list,
-					      _deadlock_part_list_srch,
-					      job_ptr);
-		if (!dl_job_ptr2) /* Hetjob not in this partition, no check */
-			continue;
-		job_iter = list_iterator_create(dl_part_ptr->deadlock_job_list);
-		while ((dl_job_ptr2 = (deadlock_job_struct_t *)
-				      list_next(job_iter))) {
-			if (dl_job_ptr2->het_job_id == dl_job_ptr->het_job_id)
-				break;	/* Self */
-			dl_job_ptr3 = list_find_first(
-						dl_part_ptr2->deadlock_job_list,
-						_deadlock_part_list_srch2,
-						dl_job_ptr2);
-			if (dl_job_ptr3 &&
-			    (dl_job_ptr3->start_time < dl_job_ptr->start_time)){
-				have_deadlock = true;
-				break;
-			}
-		}
-		list_iterator_destroy(job_iter);
+	list_iterator_reset(iter);
+	while ((rec = list_next(iter)))
+		_het_job_rec_release(rec, node_space, node_space_recs);
 
-		if (have_deadlock)
-			log_flag(HETJOB, "Hetjob %u in partition %s would deadlock with hetjob %u in partition %s, skipping it",
-				 dl_job_ptr->het_job_id,
-				 dl_part_ptr->part_ptr->name,
-				 dl_job_ptr3->het_job_id,
-				 dl_part_ptr2->part_ptr->name);
-		if (have_deadlock)
+	/* Components may not share nodes, they all run from het_start */
+	claim_bitmap = bit_alloc(node_record_count);
+	list_iterator_reset(iter);
+	while ((rec = list_next(iter))) {
+		if (!rec->resv_bitmap)
+			continue;
+		rec_recs = node_space_recs;
+		rec_space = _het_job_resv_space(rec->part_ptr, node_space,
+						&rec_recs);
+		if (bit_overlap_any(claim_bitmap, rec->resv_bitmap) ||
+		    _test_resv_overlap(rec_space, rec->resv_bitmap, het_start,
+				       het_start + rec->resv_end -
+				       rec->resv_start)) {
+			resv_ok = false;
 			break;
+		}
+		bit_or(claim_bitmap, rec->resv_bitmap);
+	}
+	FREE_NULL_BITMAP(claim_bitmap);
+
+	if (!resv_ok) {
+		log_flag(HETJOB, "Hetjob %u components not free together at %u, reservations released",
+			 map->het_job_id, het_start);
+		map->prev_start = MAX(map->prev_start, het_start);
+		list_iterator_destroy(iter);
+		_het_job_resv_clear_map(map, NULL);
+		return;
 	}
-	list_iterator_destroy(part_iter);
 
-	return have_deadlock;
+	list_iterator_reset(iter);
+	while ((rec = list_next(iter))) {
+		if (rec->job_ptr->start_time < het_start)
+			rec->job_ptr->start_time = het_start;
+		if (!rec->resv_bitmap)
+			continue;
+		rec->resv_end = het_start + rec->resv_end - rec->resv_start;
+		rec->resv_start = het_start;
+		_het_job_rec_reserve(rec, node_space, node_space_recs);
+	}
+	list_iterator_destroy(iter);
+	log_flag(HETJOB, "Hetjob %u components reserved together from %u",
+		 map->het_job_id, het_start);
 }
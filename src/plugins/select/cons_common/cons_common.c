@@ -795,6 +795,7 @@ extern void common_fini(void)
 	part_data_destroy_res(select_part_record);
 	select_part_record = NULL;
 	cr_fini_global_core_data();
+	common_job_test_fini();
 }
 
 /*
@@ -838,9 +839,9 @@ extern bitstr_t **common_mark_avail_cores(
 		n_last = bit_fls(node_bitmap);
 	else
 		n_last = -2;
-	for (n = n_first; n <= n_last; n++) {
-		if (!bit_test(node_bitmap, n))
-			continue;
+	for (n = n_first;
+	     ((n = bit_ffs_from_bit(node_bitmap, n)) >= 0) &&
+	     (n <= n_last); n++) {
 
 		node_res_ptr = &select_node_record[n];
 		node_ptr = node_res_ptr->node_ptr;
@@ -1069,6 +1070,19 @@ extern int select_p_node_init(node_record_t *node_ptr, int node_cnt)
 		backfill_busy_nodes = true;
 	else
 		backfill_busy_nodes = false;
+	if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
+				   "node_eval_threads="))) {
+		node_eval_threads = atoi(tmp_ptr + 18);
+		if ((node_eval_threads < 0) || (node_eval_threads > 64)) {
+			error("Invalid SchedulerParameters node_eval_threads: %d",
+			      node_eval_threads);
+			node_eval_threads = 0;		/* Use default value */
+		} else if (node_eval_threads && !is_cons_tres) {
+			error("SchedulerParameters node_eval_threads is only supported by select/cons_tres, ignoring it");
+			node_eval_threads = 0;
+		}
+	} else
+		node_eval_threads = 0;
 
 	preempt_type = slurm_get_preempt_type();
 	preempt_by_part = false;
@@ -1446,9 +1460,9 @@ extern int select_p_job_resized(job_record_t *job_ptr, node_record_t *node_ptr)
 		i_last  = bit_fls(job->node_bitmap);
 	else
 		i_last = -2;
-	for (i = i_first, n = 0; i <= i_last; i++) {
-		if (!bit_test(job->node_bitmap, i))
-			continue;
+	for (i = i_first, n = 0;
+	     ((i = bit_ffs_from_bit(job->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		if (i != node_inx) {
 			n++;
 			continue;
@@ -2239,9 +2253,10 @@ extern bitstr_t *select_p_resv_test(resv_desc_msg_t *resv_desc_ptr,
 				i_last = bit_fls(switches_bitmap[j]);
 			else
 				i_last = i_first - 1;
-			for (i = i_first; i <= i_last; i++) {
-				if (!bit_test(switches_bitmap[j], i))
-					continue;
+			for (i = i_first;
+			     ((i = bit_ffs_from_bit(switches_bitmap[j],
+						    i)) >= 0) &&
+			     (i <= i_last); i++) {
 
 				c = _get_avail_cores_on_node(
 					i, exc_core_bitmap);
@@ -2353,9 +2368,11 @@ extern bitstr_t *select_p_resv_test(resv_desc_msg_t *resv_desc_ptr,
 		else
 			i_last = i_first - 1;
 
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(switches_bitmap[best_fit_location], i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(
+				   switches_bitmap[best_fit_location],
+				   i)) >= 0) &&
+		     (i <= i_last); i++) {
 			bit_clear(switches_bitmap[best_fit_location], i);
 			switches_node_cnt[best_fit_location]--;
 
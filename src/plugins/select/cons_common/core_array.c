@@ -280,9 +280,9 @@ extern bitstr_t **core_bitmap_to_array(bitstr_t *core_bitmap)
 
 	i_last = bit_fls(core_bitmap);
 
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(core_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(core_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		for (j = node_inx; j < select_node_cnt; j++) {
 			if (i < select_node_record[j].cume_cores) {
 				node_inx = j;
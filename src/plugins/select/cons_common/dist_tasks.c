@@ -117,6 +117,22 @@ static int _cmp_int_descend(const void *a, const void *b)
 }
 
 
+/*
+ * Return the first available core of core_map in the range [start, end),
+ * or end if there is none. Whole clear words are skipped.
+ */
+static uint32_t _next_core(bitstr_t *core_map, uint32_t start, uint32_t end)
+{
+	bitoff_t bit;
+
+	if (start >= end)
+		return end;
+	bit = bit_ffs_from_bit(core_map, start);
+	if ((bit < 0) || (bit >= end))
+		return end;
+	return bit;
+}
+
 /* qsort compare function for board combination socket list
  * NOTE: sockets_core_cnt is a global symbol in this module */
 static int _cmp_sock(const void *a, const void *b)
@@ -178,9 +194,9 @@ static void _clear_spec_cores(job_record_t *job_ptr,
 		i_last = bit_fls(job_res->node_bitmap);
 	else
 		i_last = -2;
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(job_res->node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		job_res->cpus[++alloc_node] = 0;
 
 		if (is_cons_tres) {
@@ -470,6 +486,7 @@ static void _block_sync_core_bitmap(job_record_t *job_ptr,
 				    const uint16_t cr_type)
 {
 	uint32_t c, s, i, j, b, z, csize, core_cnt;
+	uint32_t sock_first, sock_last, sock_cnt;
 	int n, n_first, n_last;
 	uint16_t cpus, num_bits, vpus = 1;
 	uint16_t cpus_per_task = job_ptr->details->cpus_per_task;
@@ -600,17 +617,13 @@ static void _block_sync_core_bitmap(job_record_t *job_ptr,
 			sort_brds_core_cnt[b] = 0;
 		}
 		for (s = 0; s < nsockets_nb; s++) {
-			sockets_core_cnt[s] = 0;
+			sockets_core_cnt[s] = bit_set_count_range(
+				job_res->core_bitmap, c + (s * ncores_nb),
+				c + ((s + 1) * ncores_nb));
 			sockets_used[s] = false;
 			b = s / sock_per_brd;
-			for (j = c + (s * ncores_nb);
-			     j < c + ((s+1) * ncores_nb); j++) {
-				if (bit_test(job_res->core_bitmap, j)) {
-					sockets_core_cnt[s]++;
-					boards_core_cnt[b]++;
-					sort_brds_core_cnt[b]++;
-				}
-			}
+			boards_core_cnt[b] += sockets_core_cnt[s];
+			sort_brds_core_cnt[b] += sockets_core_cnt[s];
 		}
 
 		/* Sort boards in descending order of available core count */
@@ -780,57 +793,53 @@ static void _block_sync_core_bitmap(job_record_t *job_ptr,
 			         sockets_core_cnt[best_fit_location]);
 
 			sockets_used[best_fit_location] = true;
-			for (j = (c + (best_fit_location * ncores_nb));
-			     j < (c + ((best_fit_location + 1) * ncores_nb));
-			     j++ ) {
-				/*
-				 * if no more CPUs to select
-				 * release remaining cores unless
-				 * we are allocating whole sockets
-				 */
-				if (cpus == 0) {
-					if (alloc_sockets) {
-						bit_set(job_res->core_bitmap,
-							j);
-						core_cnt++;
-					} else {
-						bit_clear(job_res->core_bitmap,
-							  j);
-					}
-					continue;
-				}
-
-				/*
-				 * remove cores from socket count and
-				 * cpus count using hyperthreading requirement
-				 */
-				if (bit_test(job_res->core_bitmap, j)) {
-					sockets_core_cnt[best_fit_location]--;
-					core_cnt++;
-					if (cpus < vpus)
-						cpus = 0;
-					else if ((ntasks_per_core == 1) &&
-						 (cpus_per_task > vpus)) {
-						int used = MIN(tmp_cpt, vpus);
-						cpus -= used;
+			sock_first = c + (best_fit_location * ncores_nb);
+			sock_last = sock_first + ncores_nb;
+			sock_cnt = 0;
+			/*
+			 * remove cores from socket count and
+			 * cpus count using hyperthreading requirement,
+			 * visiting only the available cores of the socket
+			 */
+			for (j = sock_first;
+			     (cpus > 0) &&
+			     ((j = _next_core(job_res->core_bitmap, j,
+					      sock_last)) < sock_last);
+			     j++) {
+				sockets_core_cnt[best_fit_location]--;
+				sock_cnt++;
+				if (cpus < vpus)
+					cpus = 0;
+				else if ((ntasks_per_core == 1) &&
+					 (cpus_per_task > vpus)) {
+					int used = MIN(tmp_cpt, vpus);
+					cpus -= used;
 
-						if (tmp_cpt <= used)
-							tmp_cpt = cpus_per_task;
-						else
-							tmp_cpt -= used;
-					} else {
-						cpus -= vpus;
-					}
-				} else if (alloc_sockets) {
-					/*
-					 * If the core is not used, add it
-					 * anyway if allocating whole sockets
-					 */
-					bit_set(job_res->core_bitmap, j);
-					core_cnt++;
+					if (tmp_cpt <= used)
+						tmp_cpt = cpus_per_task;
+					else
+						tmp_cpt -= used;
+				} else {
+					cpus -= vpus;
 				}
 			}
 
+			/*
+			 * If allocating whole sockets, add the unused cores
+			 * of the socket anyway. Otherwise release the cores
+			 * left over once no more CPUs are needed.
+			 */
+			if (alloc_sockets) {
+				bit_nset(job_res->core_bitmap, sock_first,
+					 sock_last - 1);
+				core_cnt += ncores_nb;
+			} else {
+				if ((cpus == 0) && (j < sock_last))
+					bit_nclear(job_res->core_bitmap, j,
+						   sock_last - 1);
+				core_cnt += sock_cnt;
+			}
+
 			/* loop again if more CPUs required */
 			if (cpus > 0)
 				continue;
@@ -973,10 +982,10 @@ static int _cyclic_sync_core_bitmap(job_record_t *job_ptr,
 					  job_ptr->details->cpus_per_task;
 			cpus_cnt = xmalloc(sizeof(uint32_t) * sockets);
 			for (s = 0; s < sockets; s++) {
-				for (j = sock_start[s]; j < sock_end[s]; j++) {
-					if (bit_test(core_map, j))
-						cpus_cnt[s] += vpus;
-				}
+				cpus_cnt[s] = vpus *
+					bit_set_count_range(core_map,
+							    sock_start[s],
+							    sock_end[s]);
 				total_cpus += cpus_cnt[s];
 			}
 			for (s = 0; s < sockets && total_cpus > cpus; s++) {
@@ -1001,41 +1010,41 @@ static int _cyclic_sync_core_bitmap(job_record_t *job_ptr,
 			cpus_per_task = job_ptr->details->cpus_per_task;
 			cpus_cnt = xmalloc(sizeof(uint32_t) * sockets);
 			for (s = 0; s < sockets; s++) {
-				for (j = sock_start[s]; j < sock_end[s]; j++) {
-					if (bit_test(core_map, j))
-						cpus_cnt[s] += vpus;
-				}
+				cpus_cnt[s] = vpus *
+					bit_set_count_range(core_map,
+							    sock_start[s],
+							    sock_end[s]);
 				cpus_cnt[s] -= (cpus_cnt[s] % cpus_per_task);
 			}
 			tmp_cpt = cpus_per_task;
 			for (s = 0; ((s < sockets) && (cpus > 0)); s++) {
-				while ((sock_start[s] < sock_end[s]) &&
-				       (cpus_cnt[s] > 0) && (cpus > 0)) {
-					if (bit_test(core_map, sock_start[s])) {
-						int used;
-						sock_used[s] = true;
-						core_cnt++;
-
-						if ((ntasks_per_core == 1) &&
-						    (cpus_per_task > vpus)) {
-							used = MIN(tmp_cpt,
-								   vpus);
-							if (tmp_cpt <= used)
-								tmp_cpt = cpus_per_task;
-							else
-								tmp_cpt -= used;
-						} else
-							used = vpus;
-
-						if (cpus_cnt[s] < vpus)
-							cpus_cnt[s] = 0;
-						else
-							cpus_cnt[s] -= used;
-						if (cpus < vpus)
-							cpus = 0;
+				while ((cpus_cnt[s] > 0) && (cpus > 0) &&
+				       ((sock_start[s] =
+					 _next_core(core_map, sock_start[s],
+						    sock_end[s])) <
+					sock_end[s])) {
+					int used;
+					sock_used[s] = true;
+					core_cnt++;
+
+					if ((ntasks_per_core == 1) &&
+					    (cpus_per_task > vpus)) {
+						used = MIN(tmp_cpt, vpus);
+						if (tmp_cpt <= used)
+							tmp_cpt = cpus_per_task;
 						else
-							cpus -= used;
-					}
+							tmp_cpt -= used;
+					} else
+						used = vpus;
+
+					if (cpus_cnt[s] < vpus)
+						cpus_cnt[s] = 0;
+					else
+						cpus_cnt[s] -= used;
+					if (cpus < vpus)
+						cpus = 0;
+					else
+						cpus -= used;
 					sock_start[s]++;
 				}
 			}
@@ -1048,17 +1057,14 @@ static int _cyclic_sync_core_bitmap(job_record_t *job_ptr,
 			for (s = 0; s < sockets && cpus > 0; s++) {
 				if (sock_avoid[s])
 					continue;
-				while (sock_start[s] < sock_end[s]) {
-					if (bit_test(core_map, sock_start[s])) {
-						sock_used[s] = true;
-						core_cnt++;
-						break;
-					} else
-						sock_start[s]++;
-				}
+				sock_start[s] = _next_core(core_map,
+							   sock_start[s],
+							   sock_end[s]);
 				if (sock_start[s] == sock_end[s])
 					/* this socket is unusable */
 					continue;
+				sock_used[s] = true;
+				core_cnt++;
 				if (cpus < vpus)
 					cpus = 0;
 				else
@@ -1125,15 +1131,15 @@ static int _cyclic_sync_core_bitmap(job_record_t *job_ptr,
 				bit_nclear(core_map, sock_start[s],
 					   sock_end[s]-1);
 			}
+			/*
+			 * Mark all cores as used, the rest of the socket was
+			 * cleared above unless allocating whole sockets
+			 */
 			if ((select_node_record[n].vpus >= 1) &&
-			    (alloc_sockets || alloc_cores) && sock_used[s]) {
-				for (j = sock_start[s]; j < sock_end[s]; j++) {
-					/* Mark all cores as used */
-					if (alloc_sockets)
-						bit_set(core_map, j);
-					if (bit_test(core_map, j))
-						core_cnt++;
-				}
+			    alloc_sockets && sock_used[s]) {
+				bit_nset(core_map, sock_start[s],
+					 sock_end[s] - 1);
+				core_cnt += sock_end[s] - sock_start[s];
 			}
 		}
 		if ((alloc_cores || alloc_sockets) &&
@@ -2157,9 +2157,9 @@ extern int gres_select_filter_select_and_set(List *sock_gres_list,
 		i_last  = bit_fls(job_res->node_bitmap);
 	else
 		i_last = -2;
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(job_res->node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		sock_gres_iter =
 			list_iterator_create(sock_gres_list[++node_inx]);
 		while ((sock_gres = (sock_gres_t *) list_next(sock_gres_iter))){
@@ -2278,9 +2278,9 @@ extern int gres_select_filter_select_and_set(List *sock_gres_list,
 		 * sockets and are thus generally less desirable to use.
 		 */
 		node_inx = -1;
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(job_res->node_bitmap, i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			sock_gres_iter = list_iterator_create(
 				sock_gres_list[++node_inx]);
 			while ((sock_gres = (sock_gres_t *)
@@ -253,9 +253,9 @@ extern bool gres_select_util_job_mem_set(List job_gres_list,
 			continue;
 		rc = true;
 		node_off = -1;
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(job_res->node_bitmap, i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			node_off++;
 			if (job_res->whole_node == 1) {
 				gres_state_t *node_gres_ptr;
@@ -114,9 +114,9 @@ static int _handle_job_res(job_resources_t *job_resrcs_ptr,
 		i_last = bit_fls(job_resrcs_ptr->node_bitmap);
 	else
 		i_last = -2;
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(job_resrcs_ptr->node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(job_resrcs_ptr->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 
 		cores_per_node = select_node_record[i].tot_cores;
 
@@ -330,9 +330,9 @@ extern int job_res_add_job(job_record_t *job_ptr, job_res_job_action_t action)
 	else
 		i_last = -2;
 
-	for (i = i_first, n = -1; i <= i_last; i++) {
-		if (!bit_test(job->node_bitmap, i))
-			continue;
+	for (i = i_first, n = -1;
+	     ((i = bit_ffs_from_bit(job->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		n++;
 		if (job->cpus[n] == 0)
 			continue;  /* node removed by job resize */
@@ -507,9 +507,9 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 		i_last = bit_fls(job->node_bitmap);
 	else
 		i_last = -2;
-	for (i = i_first, n = -1; i <= i_last; i++) {
-		if (!bit_test(job->node_bitmap, i))
-			continue;
+	for (i = i_first, n = -1;
+	     ((i = bit_ffs_from_bit(job->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		n++;
 
 		if (node_map && !bit_test(node_map, i))
@@ -519,10 +519,7 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 
 		node_ptr = node_record_table_ptr + i;
 		if (action != JOB_RES_ACTION_RESUME) {
-			if (node_usage[i].gres_list)
-				gres_list = node_usage[i].gres_list;
-			else
-				gres_list = node_ptr->gres_list;
+			gres_list = node_data_own_gres(node_usage, i);
 			gres_ctld_job_dealloc(job_ptr->gres_list_req, gres_list,
 					      n, job_ptr->job_id,
 					      node_ptr->name, old_job,
@@ -573,6 +570,7 @@ extern int job_res_rm_job(part_res_record_t *part_record_ptr,
 
 		if (!p_ptr->row)
 			return SLURM_SUCCESS;
+		part_data_own_rows(p_ptr);
 
 		/* remove the job from the job_list */
 		n = 0;
@@ -40,6 +40,7 @@
 #include "gres_select_util.h"
 
 #include "src/common/node_select.h"
+#include "src/common/workq.h"
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/gres_ctld.h"
@@ -55,7 +56,8 @@ typedef struct {
 } wrapper_rm_job_args_t;
 
 typedef struct {
-	List preemptee_candidates;
+	job_record_t **preemptee_index; /* preemptee_candidates, by address */
+	int preemptee_cnt;
 	List cr_job_list;
 	node_use_record_t *future_usage;
 	part_res_record_t *future_part;
@@ -63,11 +65,41 @@ typedef struct {
 	bool *qos_preemptor;
 } cr_job_list_args_t;
 
+/* Minimum number of candidate nodes evaluated by each node eval worker */
+#define NODE_EVAL_MIN_NODES 64
+
+typedef struct {
+	avail_res_t **avail_res_array;
+	bitstr_t **core_map;
+	uint16_t cr_type;
+	job_record_t *job_ptr;
+	bitstr_t *node_map;
+	node_use_record_t *node_usage;
+	bitstr_t **part_core_map;
+	uint32_t s_p_n;
+	bool test_only;
+	bool will_run;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	int pending;		/* count of node ranges not yet evaluated */
+} node_eval_batch_t;
+
+typedef struct {
+	node_eval_batch_t *batch;
+	int i_first;
+	int i_last;
+} node_eval_args_t;
+
 uint64_t def_cpu_per_gpu = 0;
 uint64_t def_mem_per_gpu = 0;
+int node_eval_threads = 0;
 bool preempt_strict_order = false;
 int preempt_reorder_cnt	= 1;
 
+static workq_t *node_eval_workq = NULL;
+static int node_eval_workq_cnt = 0;
+
 /* When any cores on a node are removed from being available for a job,
  * then remove the entire node from being available. */
 static void _block_whole_nodes(bitstr_t *node_bitmap,
@@ -91,9 +123,9 @@ static void _block_whole_nodes(bitstr_t *node_bitmap,
 		cr_new_core_bitmap = *new_core_bitmap;
 	}
 
-	for (i_node = first_node; i_node <= last_node; i_node++) {
-		if (!bit_test(node_bitmap, i_node))
-			continue;
+	for (i_node = first_node;
+	     ((i_node = bit_ffs_from_bit(node_bitmap, i_node)) >= 0) &&
+	     (i_node <= last_node); i_node++) {
 		if (is_cons_tres) {
 			first_core = 0;
 			last_core = select_node_record[i_node].tot_cores;
@@ -182,14 +214,6 @@ static int _cr_job_list_sort(void *x, void *y)
 	return (int) SLURM_DIFFTIME(job1_ptr->end_time, job2_ptr->end_time);
 }
 
-static int _find_job (void *x, void *key)
-{
-	job_record_t *job_ptr = (job_record_t *) x;
-	if (job_ptr == (job_record_t *) key)
-		return 1;
-	return 0;
-}
-
 extern void _free_avail_res_array(avail_res_t **avail_res_array)
 {
 	int n;
@@ -308,6 +332,105 @@ static uint32_t _socks_per_node(job_record_t *job_ptr)
 	return s_p_n;
 }
 
+/* Evaluate the candidate nodes of a batch from i_first to i_last */
+static void _eval_node_range(node_eval_batch_t *batch, int i_first,
+			     int i_last)
+{
+	int i;
+
+	for (i = i_first; i <= i_last; i++) {
+		if (!bit_test(batch->node_map, i))
+			continue;
+		batch->avail_res_array[i] =
+			(*cons_common_callbacks.can_job_run_on_node)(
+				batch->job_ptr, batch->core_map, i,
+				batch->s_p_n, batch->node_usage,
+				batch->cr_type, batch->test_only,
+				batch->will_run, batch->part_core_map);
+	}
+}
+
+static void _eval_node_work(void *x)
+{
+	node_eval_args_t *args = x;
+	node_eval_batch_t *batch = args->batch;
+
+	_eval_node_range(batch, args->i_first, args->i_last);
+
+	slurm_mutex_lock(&batch->mutex);
+	if (--batch->pending == 0)
+		slurm_cond_signal(&batch->cond);
+	slurm_mutex_unlock(&batch->mutex);
+}
+
+/*
+ * Split the candidate nodes of a batch into ranges, evaluate all but the
+ * first range using the node eval workers and the first range in the calling
+ * thread, then wait for the workers to finish. Each node's avail_res_array
+ * and core_map entry is only ever written by the thread evaluating it.
+ * RET false if the batch is too small to be worth splitting
+ */
+static bool _eval_nodes_threaded(node_eval_batch_t *batch, int i_first,
+				 int i_last)
+{
+	node_eval_args_t *args;
+	int i, j, node_cnt, range_cnt, per_range, set_cnt;
+
+	if (node_eval_threads <= 0)
+		return false;
+	node_cnt = bit_set_count_range(batch->node_map, i_first, i_last + 1);
+	range_cnt = MIN(node_eval_threads + 1, node_cnt / NODE_EVAL_MIN_NODES);
+	if (range_cnt < 2)
+		return false;
+
+	if (node_eval_workq_cnt != node_eval_threads) {
+		FREE_NULL_WORKQ(node_eval_workq);
+		node_eval_workq = new_workq(node_eval_threads);
+		node_eval_workq_cnt = node_eval_threads;
+	}
+
+	/* Split on set bits so each range has a similar number of nodes */
+	per_range = (node_cnt + range_cnt - 1) / range_cnt;
+	args = xcalloc(range_cnt, sizeof(node_eval_args_t));
+	args[0].batch = batch;
+	args[0].i_first = i_first;
+	for (i = i_first, j = 0, set_cnt = 0; i <= i_last; i++) {
+		if (!bit_test(batch->node_map, i))
+			continue;
+		if ((++set_cnt == per_range) && (j < (range_cnt - 1))) {
+			args[j].i_last = i;
+			j++;
+			args[j].batch = batch;
+			args[j].i_first = i + 1;
+			set_cnt = 0;
+		}
+	}
+	args[j].i_last = i_last;
+	range_cnt = j + 1;
+
+	slurm_mutex_init(&batch->mutex);
+	slurm_cond_init(&batch->cond, NULL);
+	batch->pending = range_cnt - 1;
+	for (i = 1; i < range_cnt; i++) {
+		if (workq_add_work(node_eval_workq, _eval_node_work, &args[i],
+				   "node_eval")) {
+			/* Queue shut down, evaluate this range here */
+			_eval_node_work(&args[i]);
+		}
+	}
+	_eval_node_range(batch, args[0].i_first, args[0].i_last);
+
+	slurm_mutex_lock(&batch->mutex);
+	while (batch->pending)
+		slurm_cond_wait(&batch->cond, &batch->mutex);
+	slurm_mutex_unlock(&batch->mutex);
+	slurm_mutex_destroy(&batch->mutex);
+	slurm_cond_destroy(&batch->cond);
+	xfree(args);
+
+	return true;
+}
+
 /*
  * Determine resource availability for pending job
  *
@@ -331,7 +454,7 @@ static avail_res_t **_get_res_avail(job_record_t *job_ptr,
 {
 	int i, i_first, i_last;
 	avail_res_t **avail_res_array = NULL;
-	uint32_t s_p_n = _socks_per_node(job_ptr);
+	node_eval_batch_t batch;
 
 	xassert(*cons_common_callbacks.can_job_run_on_node);
 
@@ -341,14 +464,23 @@ static avail_res_t **_get_res_avail(job_record_t *job_ptr,
 		i_last = bit_fls(node_map);
 	else
 		i_last = -2;
+
+	memset(&batch, 0, sizeof(batch));
+	batch.avail_res_array = avail_res_array;
+	batch.core_map = core_map;
+	batch.cr_type = cr_type;
+	batch.job_ptr = job_ptr;
+	batch.node_map = node_map;
+	batch.node_usage = node_usage;
+	batch.part_core_map = part_core_map;
+	batch.s_p_n = _socks_per_node(job_ptr);
+	batch.test_only = test_only;
+	batch.will_run = will_run;
+	if ((i_first != -1) &&
+	    !_eval_nodes_threaded(&batch, i_first, i_last))
+		_eval_node_range(&batch, i_first, i_last);
+
 	for (i = i_first; i <= i_last; i++) {
-		if (bit_test(node_map, i))
-			avail_res_array[i] =
-				(*cons_common_callbacks.can_job_run_on_node)(
-					job_ptr, core_map, i,
-					s_p_n, node_usage,
-					cr_type, test_only, will_run,
-					part_core_map);
 		/*
 		 * FIXME: This is a hack to make cons_res more bullet proof as
 		 * there are places that don't always behave correctly with a
@@ -446,11 +578,54 @@ static int _is_node_busy(part_res_record_t *p_ptr, uint32_t node_i,
 	return 0;
 }
 
-static bool _is_preemptable(job_record_t *job_ptr, List preemptee_candidates)
+static int _cmp_job_ptr(const void *x, const void *y)
+{
+	uintptr_t j1 = (uintptr_t) *(job_record_t **) x;
+	uintptr_t j2 = (uintptr_t) *(job_record_t **) y;
+
+	if (j1 < j2)
+		return -1;
+	if (j1 > j2)
+		return 1;
+	return 0;
+}
+
+/*
+ * Build an array of the preemption candidates sorted by address so that
+ * _is_preemptable() does not need to walk the candidate list for every
+ * running job.
+ * RET array to be freed with xfree() or NULL if no candidates
+ */
+static job_record_t **_build_preemptee_index(List preemptee_candidates,
+					     int *preemptee_cnt)
 {
-	if (!preemptee_candidates)
+	job_record_t **preemptee_index, *tmp_job_ptr;
+	ListIterator job_iterator;
+	int i = 0;
+
+	*preemptee_cnt = 0;
+	if (!preemptee_candidates || !list_count(preemptee_candidates))
+		return NULL;
+
+	preemptee_index = xcalloc(list_count(preemptee_candidates),
+				  sizeof(job_record_t *));
+	job_iterator = list_iterator_create(preemptee_candidates);
+	while ((tmp_job_ptr = list_next(job_iterator)))
+		preemptee_index[i++] = tmp_job_ptr;
+	list_iterator_destroy(job_iterator);
+	qsort(preemptee_index, i, sizeof(job_record_t *), _cmp_job_ptr);
+	*preemptee_cnt = i;
+
+	return preemptee_index;
+}
+
+static bool _is_preemptable(job_record_t *job_ptr,
+			    job_record_t **preemptee_index, int preemptee_cnt)
+{
+	if (!preemptee_index)
 		return false;
-	if (list_find_first(preemptee_candidates, _find_job, job_ptr))
+	if (bsearch(&job_ptr, preemptee_index, preemptee_cnt,
+		    sizeof(job_record_t *), _cmp_job_ptr))
 		return true;
 	return false;
 }
@@ -659,9 +834,9 @@ static int _verify_node_state(part_res_record_t *cr_part_ptr,
 		i_last = -2;
 	else
 		i_last  = bit_fls(node_bitmap);
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		node_ptr = select_node_record[i].node_ptr;
 		/* node-level memory check */
 		if (min_mem && (cr_type & CR_MEMORY)) {
@@ -1504,9 +1679,9 @@ alloc_job:
 		}
 		node_gres_list = xcalloc(job_res->nhosts, sizeof(List));
 		sock_gres_list = xcalloc(job_res->nhosts, sizeof(List));
-		for (i = i_first, j = 0; i <= i_last; i++) {
-			if (!bit_test(job_res->node_bitmap, i))
-				continue;
+		for (i = i_first, j = 0;
+		     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			if (have_gres_per_task) {
 				gres_task_limit[j] =
 					gres_select_util_get_task_limit(
@@ -1549,9 +1724,9 @@ alloc_job:
 	build_cnt = build_job_resources_cpu_array(job_res);
 	if (job_ptr->details->whole_node == 1) {
 		job_ptr->total_cpus = 0;
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(job_res->node_bitmap, i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			/*
 			 * This could make the job_res->cpus incorrect.
 			 * Don't use job_res->cpus when allocating
@@ -1566,9 +1741,9 @@ alloc_job:
 		int s, last_s, sock_cnt = 0;
 
 		job_ptr->total_cpus = 0;
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(job_res->node_bitmap, i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			sock_cnt = 0;
 			for (s = 0; s < select_node_record[i].tot_sockets; s++){
 				last_s = -1;
@@ -1610,9 +1785,9 @@ alloc_job:
 	} else {
 		/* load memory allocated array */
 		save_mem = details_ptr->pn_min_memory;
-		for (i = i_first, j = 0; i <= i_last; i++) {
-			if (!bit_test(job_res->node_bitmap, i))
-				continue;
+		for (i = i_first, j = 0;
+		     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			nodename = select_node_record[i].node_ptr->name;
 			avail_mem = select_node_record[i].real_memory -
 				select_node_record[i].mem_spec_limit;
@@ -1809,7 +1984,8 @@ static int _build_cr_job_list(void *x, void *arg)
 			return 0;
 		}
 	}
-	if (!_is_preemptable(job_ptr_preempt, args->preemptee_candidates)) {
+	if (!_is_preemptable(job_ptr_preempt, args->preemptee_index,
+			     args->preemptee_cnt)) {
 		/* Queue job for later removal from data structures */
 		list_append(args->cr_job_list, tmp_job_ptr);
 	} else if (tmp_job_ptr == job_ptr_preempt) {
@@ -1892,14 +2068,16 @@ static int _will_run_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 	/* Build list of running and suspended jobs */
 	cr_job_list = list_create(NULL);
 	args = (cr_job_list_args_t) {
-		.preemptee_candidates = preemptee_candidates,
 		.cr_job_list = cr_job_list,
 		.future_usage = future_usage,
 		.future_part = future_part,
 		.orig_map = orig_map,
 		.qos_preemptor = &qos_preemptor,
 	};
+	args.preemptee_index = _build_preemptee_index(preemptee_candidates,
+						      &args.preemptee_cnt);
 	list_for_each(job_list, _build_cr_job_list, &args);
+	xfree(args.preemptee_index);
 
 	/* Test with all preemptable jobs gone */
 	if (preemptee_candidates) {
@@ -2057,7 +2235,7 @@ static int _run_now(job_record_t *job_ptr, bitstr_t *node_bitmap,
 		    List preemptee_candidates, List *preemptee_job_list,
 		    bitstr_t **exc_cores)
 {
-	int rc;
+	int rc, first_rc = SLURM_SUCCESS;
 	bitstr_t *orig_node_map = NULL, *save_node_map;
 	job_record_t *tmp_job_ptr = NULL;
 	ListIterator job_iterator, preemptee_iterator;
@@ -2072,10 +2250,20 @@ static int _run_now(job_record_t *job_ptr, bitstr_t *node_bitmap,
 	save_node_map = bit_copy(node_bitmap);
 top:	orig_node_map = bit_copy(save_node_map);
 
-	rc = _job_test(job_ptr, node_bitmap, min_nodes, max_nodes, req_nodes,
-		       SELECT_MODE_RUN_NOW, tmp_cr_type, job_node_req,
-		       select_part_record, select_node_usage, exc_cores, false,
-		       false, preempt_mode);
+	/*
+	 * Only the order of the preemption candidates changes between passes,
+	 * so the test against the current state would fail again just like
+	 * the first time.
+	 */
+	if (pass_count)
+		rc = first_rc;
+	else
+		rc = first_rc = _job_test(job_ptr, node_bitmap, min_nodes,
+					  max_nodes, req_nodes,
+					  SELECT_MODE_RUN_NOW, tmp_cr_type,
+					  job_node_req, select_part_record,
+					  select_node_usage, exc_cores, false,
+					  false, preempt_mode);
 
 	if ((rc != SLURM_SUCCESS) && preemptee_candidates && preempt_by_qos) {
 		/* Determine QOS preempt mode of first job */
@@ -2356,3 +2544,9 @@ extern int common_job_test(job_record_t *job_ptr, bitstr_t *node_bitmap,
 
 	return rc;
 }
+
+extern void common_job_test_fini(void)
+{
+	FREE_NULL_WORKQ(node_eval_workq);
+	node_eval_workq_cnt = 0;
+}
@@ -42,6 +42,7 @@
 
 extern uint64_t def_cpu_per_gpu;
 extern uint64_t def_mem_per_gpu;
+extern int node_eval_threads;
 extern bool preempt_strict_order;
 extern int preempt_reorder_cnt;
 
@@ -82,4 +83,7 @@ extern int common_job_test(job_record_t *job_ptr, bitstr_t *bitmap,
 			   List *preemptee_job_list,
 			   bitstr_t **exc_cores);
 
+/* Stop the node evaluation workers, if any were started */
+extern void common_job_test_fini(void);
+
 #endif /* _CONS_COMMON_JOB_TEST */
@@ -49,7 +49,8 @@ extern void node_data_destroy(node_use_record_t *node_usage,
 	xfree(node_data);
 	if (node_usage) {
 		for (i = 0; i < select_node_cnt; i++) {
-			FREE_NULL_LIST(node_usage[i].gres_list);
+			if (!node_usage[i].gres_list_shared)
+				FREE_NULL_LIST(node_usage[i].gres_list);
 		}
 		xfree(node_usage);
 	}
@@ -90,7 +91,13 @@ extern void node_data_dump(void)
 	}
 }
 
-/* Create a duplicate node_use_record list */
+/*
+ * Create a duplicate node_use_record list
+ *
+ * The GRES state of the copy is shared with orig_ptr (or the node table)
+ * until node_data_own_gres() is called for a node, so the original must
+ * outlive the copy.
+ */
 extern node_use_record_t *node_data_dup_use(
 	node_use_record_t *orig_ptr, bitstr_t *node_map)
 {
@@ -124,7 +131,21 @@ extern node_use_record_t *node_data_dup_use(
 			gres_list = orig_ptr[i].gres_list;
 		else
 			gres_list = node_record_table_ptr[i].gres_list;
-		new_ptr[i].gres_list = gres_node_state_dup(gres_list);
+		new_ptr[i].gres_list = gres_list;
+		new_ptr[i].gres_list_shared = (gres_list != NULL);
 	}
 	return new_use_ptr;
 }
+
+extern List node_data_own_gres(node_use_record_t *node_usage, int node_inx)
+{
+	node_use_record_t *use_ptr = &node_usage[node_inx];
+
+	if (use_ptr->gres_list_shared) {
+		use_ptr->gres_list = gres_node_state_dup(use_ptr->gres_list);
+		use_ptr->gres_list_shared = false;
+	}
+	if (use_ptr->gres_list)
+		return use_ptr->gres_list;
+	return node_record_table_ptr[node_inx].gres_list;
+}
@@ -67,6 +67,9 @@ typedef struct {
 				       * defined in in src/common/gres.h.
 				       * Local data used only in state copy
 				       * to emulate future node state */
+	bool gres_list_shared;	      /* gres_list belongs to the record this
+				       * one was duplicated from, see
+				       * node_data_own_gres() */
 	uint16_t node_state;	      /* see node_cr_state comments */
 } node_use_record_t;
 
@@ -82,4 +85,11 @@ extern void node_data_dump(void);
 extern node_use_record_t *node_data_dup_use(node_use_record_t *orig_ptr,
 					    bitstr_t *node_map);
 
+/*
+ * Give a node_use_record_t created by node_data_dup_use() its own copy of
+ * the node's GRES state. Must be called before modifying that GRES state.
+ * RET the node's gres_list to modify
+ */
+extern List node_data_own_gres(node_use_record_t *node_usage, int node_inx);
+
 #endif /*_CONS_COMMON_NODE_DATA_H */
@@ -371,10 +371,9 @@ extern void part_data_destroy_res(part_res_record_t *this_ptr)
 		this_ptr = this_ptr->next;
 		tmp->part_ptr = NULL;
 
-		if (tmp->row) {
+		if (tmp->row && !tmp->rows_shared)
 			part_data_destroy_row(tmp->row, tmp->num_rows);
-			tmp->row = NULL;
-		}
+		tmp->row = NULL;
 		xfree(tmp);
 	}
 }
@@ -431,7 +430,12 @@ extern void part_data_dump_res(part_res_record_t *p_ptr)
 	}
 }
 
-/* Create a duplicate part_res_record list */
+/*
+ * Create a duplicate part_res_record list
+ *
+ * The row data of the copy is shared with orig_ptr until
+ * part_data_own_rows() is called for it, so orig_ptr must outlive the copy.
+ */
 extern part_res_record_t *part_data_dup_res(
 	part_res_record_t *orig_ptr, bitstr_t *node_map)
 {
@@ -449,8 +453,8 @@ extern part_res_record_t *part_data_dup_res(
 		    bit_overlap_any(node_map,
 				    orig_ptr->part_ptr->node_bitmap)) {
 			new_ptr->num_rows = orig_ptr->num_rows;
-			new_ptr->row = part_data_dup_row(orig_ptr->row,
-							 orig_ptr->num_rows);
+			new_ptr->row = orig_ptr->row;
+			new_ptr->rows_shared = (orig_ptr->row != NULL);
 		}
 		if (orig_ptr->next) {
 			new_ptr->next = xmalloc(sizeof(part_res_record_t));
@@ -461,6 +465,15 @@ extern part_res_record_t *part_data_dup_res(
 	return new_part_ptr;
 }
 
+extern void part_data_own_rows(part_res_record_t *p_ptr)
+{
+	if (!p_ptr->rows_shared)
+		return;
+
+	p_ptr->row = part_data_dup_row(p_ptr->row, p_ptr->num_rows);
+	p_ptr->rows_shared = false;
+}
+
 /* sort the rows of a partition from "most allocated" to "least allocated" */
 extern void part_data_sort_res(part_res_record_t *p_ptr)
 {
@@ -473,6 +486,7 @@ extern void part_data_sort_res(part_res_record_t *p_ptr)
 		for (j = i + 1; j < p_ptr->num_rows; j++) {
 			if (p_ptr->row[j].row_set_count >
 			    p_ptr->row[i].row_set_count) {
+				part_data_own_rows(p_ptr);
 				_swap_rows(&(p_ptr->row[i]), &(p_ptr->row[j]));
 			}
 		}
@@ -481,21 +495,33 @@ extern void part_data_sort_res(part_res_record_t *p_ptr)
 	return;
 }
 
-/* Create a duplicate part_row_data struct */
+/*
+ * Create a duplicate part_row_data struct
+ *
+ * Trailing rows with no jobs are left without a row_bitmap, which callers
+ * already treat as an empty row, rather than copying a bitmap per node of
+ * all clear bits. _handle_job_res() builds the row_bitmap if a job is added.
+ */
 extern part_row_data_t *part_data_dup_row(part_row_data_t *orig_row,
 					       uint16_t num_rows)
 {
 	part_row_data_t *new_row;
-	int i, n;
+	int i, n, used_rows;
 
 	if (num_rows == 0 || !orig_row)
 		return NULL;
 
+	for (used_rows = num_rows; used_rows > 0; used_rows--) {
+		if (orig_row[used_rows - 1].num_jobs ||
+		    orig_row[used_rows - 1].row_set_count)
+			break;
+	}
+
 	new_row = xcalloc(num_rows, sizeof(part_row_data_t));
 	for (i = 0; i < num_rows; i++) {
 		new_row[i].num_jobs = orig_row[i].num_jobs;
 		new_row[i].job_list_size = orig_row[i].job_list_size;
-		if (orig_row[i].row_bitmap) {
+		if (orig_row[i].row_bitmap && (i < used_rows)) {
 			new_row[i].row_bitmap = build_core_array();
 			for (n = 0; n < core_array_size; n++) {
 				if (!orig_row[i].row_bitmap[n])
@@ -58,6 +58,9 @@ typedef struct part_res_record {
 	uint16_t num_rows;	      /* Number of elements in "row" array */
 	part_record_t *part_ptr; /* controller part record pointer */
 	part_row_data_t *row;    /* array of rows containing jobs */
+	bool rows_shared;	 /* row array belongs to the record this one
+				  * was duplicated from, see
+				  * part_data_own_rows() */
 } part_res_record_t;
 
 extern part_res_record_t *select_part_record;
@@ -96,6 +99,12 @@ extern void part_data_dump_res(part_res_record_t *p_ptr);
 extern part_res_record_t *part_data_dup_res(
 	part_res_record_t *orig_ptr, bitstr_t *node_map);
 
+/*
+ * Give a partition record created by part_data_dup_res() its own copy of the
+ * row data. Must be called before modifying the rows of such a record.
+ */
+extern void part_data_own_rows(part_res_record_t *p_ptr);
+
 /* sort the rows of a partition from "most allocated" to "least allocated" */
 extern void part_data_sort_res(part_res_record_t *p_ptr);
 
@@ -121,9 +121,9 @@ extern int dist_tasks_compute_c_b(job_record_t *job_ptr,
 		i_last  = bit_fls(job_res->node_bitmap);
 	else
 		i_last = -2;
-	for (i = i_first, n = 0; i <= i_last; i++) {
-		if (!bit_test(job_res->node_bitmap, i))
-			continue;
+	for (i = i_first, n = 0;
+	     ((i = bit_ffs_from_bit(job_res->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		vpus[n++] = select_node_record[i].vpus;
 	}
 
@@ -154,9 +154,9 @@ static List _build_node_weight_list(bitstr_t *node_bitmap)
 	if (i_first == -1)
 		return node_list;
 	i_last = bit_fls(node_bitmap);
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		node_ptr = node_record_table_ptr + i;
 		nwt = list_find_first(node_list, _node_weight_find, node_ptr);
 		if (!nwt) {
@@ -1425,6 +1425,29 @@ static void _topo_choose_best_switch(uint32_t *dist, int *switch_node_cnt,
 		*best_switch = i;
 	}
 }
+/*
+ * Build the node bitmaps of all switches, limited to nodes reachable from the
+ * top level switch. switch_node_bitmap[top_switch_inx] must already be set.
+ * Switches sharing no nodes with the top level switch are left without a
+ * bitmap rather than copying and clearing a full size bitmap for each.
+ */
+static void _topo_switch_bitmaps(bitstr_t **switch_node_bitmap,
+				 int top_switch_inx)
+{
+	bitstr_t *top_bitmap = switch_node_bitmap[top_switch_inx];
+	int i;
+
+	for (i = 0; i < switch_record_cnt; i++) {
+		if ((i == top_switch_inx) ||
+		    !bit_overlap_any(switch_record_table[i].node_bitmap,
+				     top_bitmap))
+			continue;
+		switch_node_bitmap[i] =
+			bit_copy(switch_record_table[i].node_bitmap);
+		bit_and(switch_node_bitmap[i], top_bitmap);
+	}
+}
+
 static int _topo_weight_find(void *x, void *key)
 {
 	topo_weight_info_t *nw = (topo_weight_info_t *) x;
@@ -1658,9 +1681,8 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 		nw = list_peek(node_weight_list);
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
-		switch_node_bitmap[i] = bit_copy(switch_ptr->node_bitmap);
 		if (req_nodes_bitmap &&
-		    bit_overlap_any(req_nodes_bitmap, switch_node_bitmap[i])) {
+		    bit_overlap_any(req_nodes_bitmap, switch_ptr->node_bitmap)) {
 			switch_required[i] = 1;
 			if (switch_record_table[i].level == 0) {
 				leaf_switch_count++;
@@ -1673,7 +1695,7 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 		}
 		if (!req_nodes_bitmap &&
 		    (list_find_first(node_weight_list, _topo_node_find,
-				    switch_node_bitmap[i]))) {
+				    switch_ptr->node_bitmap))) {
 			if ((top_switch_inx == -1) ||
 			    (switch_record_table[i].level >
 			     switch_record_table[top_switch_inx].level)) {
@@ -1693,6 +1715,8 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 		rc = SLURM_ERROR;
 		goto fini;
 	}
+	switch_node_bitmap[top_switch_inx] =
+		bit_copy(switch_record_table[top_switch_inx].node_bitmap);
 
 	/* Check that all specificly required nodes are on shared network */
 	if (req_nodes_bitmap &&
@@ -1708,12 +1732,7 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 	 * Remove nodes from consideration that can not be reached from this
 	 * top level switch
 	 */
-	for (i = 0; i < switch_record_cnt; i++) {
-		if (top_switch_inx != i) {
-			  bit_and(switch_node_bitmap[i],
-				  switch_node_bitmap[top_switch_inx]);
-		}
-	}
+	_topo_switch_bitmaps(switch_node_bitmap, top_switch_inx);
 
 	/*
 	 * Identify the best set of nodes (i.e. nodes with the lowest weight,
@@ -1832,7 +1851,7 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 
 		for (i = 0, switch_ptr = switch_record_table;
 		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_required[i])
+			if (switch_required[i] || !switch_node_bitmap[i])
 				continue;
 			if (bit_overlap_any(req2_nodes_bitmap,
 					    switch_node_bitmap[i])) {
@@ -1868,6 +1887,10 @@ static int _eval_nodes_dfly(job_record_t *job_ptr,
 	avail_nodes_bitmap = bit_alloc(node_record_count);
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
+		if (!switch_node_bitmap[i]) {
+			switch_node_cnt[i] = 0;
+			continue;
+		}
 		bit_and(switch_node_bitmap[i], best_nodes_bitmap);
 		bit_or(avail_nodes_bitmap, switch_node_bitmap[i]);
 		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
@@ -2073,7 +2096,8 @@ fini:
 		     i < switch_record_cnt; i++, switch_ptr++) {
 			if (switch_record_table[i].level != 0)
 				continue;
-			if (bit_overlap_any(switch_node_bitmap[i], node_map))
+			if (switch_node_bitmap[i] &&
+			    bit_overlap_any(switch_node_bitmap[i], node_map))
 				leaf_switch_count++;
 		}
 		if (time_waiting >= job_ptr->wait4switch) {
@@ -2274,11 +2298,10 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
-		switch_node_bitmap[i] = bit_copy(switch_ptr->node_bitmap);
-		bit_and(switch_node_bitmap[i], node_map);
-		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
+		switch_node_cnt[i] = bit_overlap(switch_ptr->node_bitmap,
+						 node_map);
 		if (req_nodes_bitmap &&
-		    bit_overlap_any(req_nodes_bitmap, switch_node_bitmap[i])) {
+		    bit_overlap_any(req_nodes_bitmap, switch_ptr->node_bitmap)) {
 			switch_required[i] = 1;
 			if ((top_switch_inx == -1) ||
 			    (switch_record_table[i].level >
@@ -2291,7 +2314,7 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 			continue;
 		if (!req_nodes_bitmap &&
 		    (nw = list_find_first(node_weight_list, _topo_node_find,
-				    switch_node_bitmap[i]))) {
+				    switch_ptr->node_bitmap))) {
 			if ((top_switch_inx == -1) ||
 			    ((switch_record_table[i].level >=
 			      switch_record_table[top_switch_inx].level) &&
@@ -2302,6 +2325,12 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 		}
 	}
 
+	if (top_switch_inx != -1) {
+		switch_node_bitmap[top_switch_inx] =
+			bit_copy(switch_record_table[top_switch_inx].node_bitmap);
+		bit_and(switch_node_bitmap[top_switch_inx], node_map);
+	}
+
 	if (!req_nodes_bitmap) {
 		bit_clear_all(node_map);
 	}
@@ -2333,12 +2362,7 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 	 * Remove nodes from consideration that can not be reached from this
 	 * top level switch.
 	 */
-	for (i = 0; i < switch_record_cnt; i++) {
-		if (top_switch_inx != i) {
-			  bit_and(switch_node_bitmap[i],
-				  switch_node_bitmap[top_switch_inx]);
-		}
-	}
+	_topo_switch_bitmaps(switch_node_bitmap, top_switch_inx);
 
 	if (req_nodes_bitmap) {
 		bit_and(node_map, req_nodes_bitmap);
@@ -2473,7 +2497,7 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 
 		for (i = 0, switch_ptr = switch_record_table;
 		     i < switch_record_cnt; i++, switch_ptr++) {
-			if (switch_required[i])
+			if (switch_required[i] || !switch_node_bitmap[i])
 				continue;
 			if (bit_overlap_any(req2_nodes_bitmap,
 					    switch_node_bitmap[i])) {
@@ -2507,6 +2531,10 @@ static int _eval_nodes_topo(job_record_t *job_ptr,
 	avail_nodes_bitmap = bit_alloc(node_record_count);
 	for (i = 0, switch_ptr = switch_record_table; i < switch_record_cnt;
 	     i++, switch_ptr++) {
+		if (!switch_node_bitmap[i]) {
+			switch_node_cnt[i] = 0;
+			continue;
+		}
 		bit_and(switch_node_bitmap[i], best_nodes_bitmap);
 		bit_or(avail_nodes_bitmap, switch_node_bitmap[i]);
 		switch_node_cnt[i] = bit_set_count(switch_node_bitmap[i]);
@@ -2662,7 +2690,8 @@ fini:
 		     i < switch_record_cnt; i++, switch_ptr++) {
 			if (switch_record_table[i].level != 0)
 				continue;
-			if (bit_overlap_any(switch_node_bitmap[i], node_map))
+			if (switch_node_bitmap[i] &&
+			    bit_overlap_any(switch_node_bitmap[i], node_map))
 				leaf_switch_count++;
 		}
 		if (time_waiting >= job_ptr->wait4switch) {
@@ -3120,9 +3149,9 @@ extern int choose_nodes(job_record_t *job_ptr, bitstr_t *node_map,
 		i_last = bit_fls(node_map);
 	else
 		i_last = i_first - 1;
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(node_map, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(node_map, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		/*
 		 * Make sure we don't say we can use a node exclusively
 		 * that is bigger than our whole-job maximum CPU count.
@@ -3189,9 +3218,9 @@ extern int choose_nodes(job_record_t *job_ptr, bitstr_t *node_map,
 		int nochange = 1;
 		bit_or(node_map, orig_node_map);
 		core_array_or(avail_core, orig_core_array);
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(node_map, i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(node_map, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			if ((avail_res_array[i]->avail_res_cnt > 0) &&
 			    (avail_res_array[i]->avail_res_cnt <= count)) {
 				if (req_node_map && bit_test(req_node_map, i))
@@ -175,9 +175,9 @@ static bitstr_t *_pick_first_cores(bitstr_t *avail_node_bitmap,
 		}
 		bit_set(picked_node_bitmap, i);
 		c_cnt = 0;
-		for (c = 0; c < select_node_record[i].tot_cores; c++) {
-			if (!bit_test(avail_cores[i], c))
-				continue;
+		for (c = 0;
+		     ((c = bit_ffs_from_bit(avail_cores[i], c)) >= 0) &&
+		     (c < select_node_record[i].tot_cores); c++) {
 			if (++c_cnt > core_cnt[local_node_offset])
 				bit_clear(avail_cores[i], c);
 		}
@@ -346,9 +346,9 @@ static bitstr_t *_sequential_pick(bitstr_t *avail_node_bitmap,
 				c_target = core_cnt[local_node_offset];
 			}
 			c_cnt = 0;
-			for (c = 0; c < select_node_record[i].tot_cores; c++) {
-				if (!bit_test(avail_cores[i], c))
-					continue;
+			for (c = 0;
+			     ((c = bit_ffs_from_bit(avail_cores[i], c)) >= 0) &&
+			     (c < select_node_record[i].tot_cores); c++) {
 				if (c_cnt >= c_target)
 					bit_clear(avail_cores[i], c);
 				else
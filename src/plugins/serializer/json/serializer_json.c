@@ -36,19 +36,21 @@
 
 #include "config.h"
 
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include "slurm/slurm.h"
 
 #include "src/common/slurm_xlator.h"
+#include "src/common/data.h"
 #include "src/common/log.h"
 #include "src/common/xassert.h"
+#include "src/common/xmalloc.h"
 #include "src/common/xstring.h"
 
-#if HAVE_JSON_C_INC
-#include <json-c/json.h>
-#else
-#include <json/json.h>
-#endif
-
 /*
  * These variables are required by the generic plugin interface.  If they
  * are not found in the plugin, the plugin loader will ignore it.
@@ -83,7 +85,29 @@ const char *mime_types[] = {
 	NULL
 };
 
-static json_object *_data_to_json(const data_t *d);
+/*
+ * Requests and responses are converted directly between JSON text and
+ * data_t in one pass, without building an intermediate json-c object tree.
+ */
+
+#define JSON_MAX_DEPTH 32	/* nesting limit, same as json-c default */
+#define JSON_PRETTY_INDENT 2	/* spaces per nesting level when pretty */
+#define JSON_REPLACEMENT_CHAR 0xfffd	/* U+FFFD for unpaired surrogates */
+
+typedef struct {
+	const char *src;	/* text being parsed */
+	const char *pos;	/* next character to parse */
+	const char *end;	/* end of text */
+	const char *err;	/* description of parse error or NULL */
+} json_parser_t;
+
+typedef struct {
+	char *buf;
+	size_t len;
+	size_t size;
+	bool pretty;
+	int level;
+} json_writer_t;
 
 extern int serializer_p_init(void)
 {
@@ -99,130 +123,544 @@ extern int serializer_p_fini(void)
 	return SLURM_SUCCESS;
 }
 
+static void _skip_space(json_parser_t *p)
+{
+	while ((p->pos < p->end) &&
+	       ((*p->pos == ' ') || (*p->pos == '\t') || (*p->pos == '\n') ||
+		(*p->pos == '\r')))
+		p->pos++;
+}
+
+static int _parse_hex4(json_parser_t *p, uint32_t *value)
+{
+	*value = 0;
+
+	if ((p->end - p->pos) < 4)
+		return SLURM_ERROR;
+
+	for (int i = 0; i < 4; i++) {
+		char c = *p->pos++;
+
+		*value <<= 4;
+		if ((c >= '0') && (c <= '9'))
+			*value |= c - '0';
+		else if ((c >= 'a') && (c <= 'f'))
+			*value |= c - 'a' + 10;
+		else if ((c >= 'A') && (c <= 'F'))
+			*value |= c - 'A' + 10;
+		else
+			return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+/* Append code point as UTF-8, return number of bytes written */
+static int _utf8_encode(uint32_t cp, char *out)
+{
+	if (cp < 0x80) {
+		out[0] = cp;
+		return 1;
+	} else if (cp < 0x800) {
+		out[0] = 0xc0 | (cp >> 6);
+		out[1] = 0x80 | (cp & 0x3f);
+		return 2;
+	} else if (cp < 0x10000) {
+		out[0] = 0xe0 | (cp >> 12);
+		out[1] = 0x80 | ((cp >> 6) & 0x3f);
+		out[2] = 0x80 | (cp & 0x3f);
+		return 3;
+	}
+
+	out[0] = 0xf0 | (cp >> 18);
+	out[1] = 0x80 | ((cp >> 12) & 0x3f);
+	out[2] = 0x80 | ((cp >> 6) & 0x3f);
+	out[3] = 0x80 | (cp & 0x3f);
+	return 4;
+}
 
-static json_object *_try_parse(const char *src, size_t stringlen,
-			       struct json_tokener *tok)
+/*
+ * Combine surrogate in cp with the low surrogate escape that follows.
+ * Unpaired surrogates can not be encoded as valid UTF-8 and are replaced by
+ * U+FFFD, leaving any following escape to be decoded on its own.
+ */
+static uint32_t _parse_surrogate(json_parser_t *p, uint32_t cp)
 {
-	json_object *jobj = json_tokener_parse_ex(tok, src, stringlen);
+	const char *next = p->pos;
+	uint32_t low;
+
+	if ((cp <= 0xdbff) && ((p->end - p->pos) >= 6) &&
+	    (p->pos[0] == '\\') && (p->pos[1] == 'u')) {
+		p->pos += 2;
+		if (!_parse_hex4(p, &low) && (low >= 0xdc00) &&
+		    (low <= 0xdfff))
+			return 0x10000 + ((cp - 0xd800) << 10) +
+			       (low - 0xdc00);
+		p->pos = next;
+	}
 
-	if (jobj == NULL) {
-		enum json_tokener_error jerr = json_tokener_get_error(tok);
-		error("%s: JSON parsing error %zu bytes: %s",
-		      __func__, stringlen, json_tokener_error_desc(jerr));
+	return JSON_REPLACEMENT_CHAR;
+}
+
+/*
+ * Parse string starting after the opening quote.
+ * RET xmalloc()ed string or NULL on error
+ */
+static char *_parse_string(json_parser_t *p)
+{
+	const char *start = p->pos, *text_end = p->end;
+	char *str, *out;
+
+	/* find the closing quote to size the result */
+	while ((p->pos < p->end) && (*p->pos != '"')) {
+		if ((*p->pos == '\\') && ((p->pos + 1) < p->end))
+			p->pos++;
+		p->pos++;
+	}
+	if (p->pos >= p->end) {
+		p->err = "unterminated string";
 		return NULL;
 	}
-	if (tok->char_offset < stringlen)
-		info("%s: WARNING: Extra %zu characters after JSON string detected",
-		     __func__, (stringlen - tok->char_offset));
 
-	return jobj;
+	/* unescaping never makes the string longer */
+	out = str = xmalloc((p->pos - start) + 1);
+	/* decode up to the closing quote */
+	p->end = p->pos;
+	p->pos = start;
+
+	while (p->pos < p->end) {
+		const char *run = p->pos;
+		uint32_t cp;
+
+		while ((p->pos < p->end) && (*p->pos != '\\'))
+			p->pos++;
+		memcpy(out, run, (p->pos - run));
+		out += p->pos - run;
+		if (p->pos >= p->end)
+			break;
+
+		p->pos++; /* skip backslash */
+		switch (*p->pos++) {
+		case '"':
+			*out++ = '"';
+			break;
+		case '\\':
+			*out++ = '\\';
+			break;
+		case '/':
+			*out++ = '/';
+			break;
+		case 'b':
+			*out++ = '\b';
+			break;
+		case 'f':
+			*out++ = '\f';
+			break;
+		case 'n':
+			*out++ = '\n';
+			break;
+		case 'r':
+			*out++ = '\r';
+			break;
+		case 't':
+			*out++ = '\t';
+			break;
+		case 'u':
+			if (_parse_hex4(p, &cp))
+				goto invalid;
+			/* combine UTF-16 surrogate pair */
+			if ((cp >= 0xd800) && (cp <= 0xdfff))
+				cp = _parse_surrogate(p, cp);
+			/* \uXXXX is 6 bytes, at most 4 bytes of UTF-8 */
+			out += _utf8_encode(cp, out);
+			break;
+		default:
+			goto invalid;
+		}
+	}
+	*out = '\0';
+
+	/* leave position at the closing quote */
+	p->end = text_end;
+	return str;
+
+invalid:
+	p->err = "invalid escape sequence in string";
+	p->end = text_end;
+	xfree(str);
+	return NULL;
 }
 
-static data_t *_json_to_data(json_object *jobj, data_t *d)
+static int _parse_number(json_parser_t *p, data_t *d)
 {
-	size_t arraylen = 0;
+	const char *start = p->pos;
+	bool is_float = false;
+	char buf[64], *endptr;
+	size_t len;
+
+	if ((p->pos < p->end) && (*p->pos == '-'))
+		p->pos++;
+	while (p->pos < p->end) {
+		char c = *p->pos;
+
+		if ((c == '.') || (c == 'e') || (c == 'E') ||
+		    (((c == '+') || (c == '-')) && (p->pos > start) &&
+		     ((p->pos[-1] == 'e') || (p->pos[-1] == 'E'))))
+			is_float = true;
+		else if ((c < '0') || (c > '9'))
+			break;
+		p->pos++;
+	}
 
-	if (!d)
-		d = data_new();
+	len = p->pos - start;
+	if (!len || (len >= sizeof(buf))) {
+		p->err = "invalid number";
+		return SLURM_ERROR;
+	}
+	memcpy(buf, start, len);
+	buf[len] = '\0';
+
+	if (!is_float) {
+		int64_t value;
+
+		errno = 0;
+		value = strtoll(buf, &endptr, 10);
+		if (!errno && (*endptr == '\0') && (endptr != buf) &&
+		    (buf[len - 1] != '-')) {
+			data_set_int(d, value);
+			return SLURM_SUCCESS;
+		}
+		/* out of range integers are kept as floats */
+	}
 
-	switch (json_object_get_type(jobj)) {
-	case json_type_null:
-		data_set_null(d);
-		break;
-	case json_type_boolean:
-		data_set_bool(d, json_object_get_boolean(jobj));
-		break;
-	case json_type_double:
-		data_set_float(d, json_object_get_double(jobj));
-		break;
-	case json_type_int:
-		data_set_int(d, json_object_get_int64(jobj));
-		break;
-	case json_type_object:
+	errno = 0;
+	data_set_float(d, strtod(buf, &endptr));
+	if ((*endptr != '\0') || (errno && (errno != ERANGE))) {
+		p->err = "invalid number";
+		return SLURM_ERROR;
+	}
+
+	return SLURM_SUCCESS;
+}
+
+static int _parse_literal(json_parser_t *p, const char *literal)
+{
+	size_t len = strlen(literal);
+
+	if (((p->end - p->pos) < len) || memcmp(p->pos, literal, len)) {
+		p->err = "invalid literal";
+		return SLURM_ERROR;
+	}
+
+	p->pos += len;
+	return SLURM_SUCCESS;
+}
+
+static int _parse_value(json_parser_t *p, data_t *d, int depth)
+{
+	char *str;
+
+	_skip_space(p);
+	if (p->pos >= p->end) {
+		p->err = "unexpected end of data";
+		return SLURM_ERROR;
+	}
+
+	switch (*p->pos) {
+	case '{':
+		if (++depth > JSON_MAX_DEPTH) {
+			p->err = "nesting too deep";
+			return SLURM_ERROR;
+		}
+		p->pos++;
 		data_set_dict(d);
-		/* warning: json_object_object_foreach is an evil macro */
-		json_object_object_foreach(jobj, key, val) {
-			_json_to_data(val, data_key_set(d, key));
+		_skip_space(p);
+		if ((p->pos < p->end) && (*p->pos == '}')) {
+			p->pos++;
+			return SLURM_SUCCESS;
 		}
-		break;
-	case json_type_array:
-		arraylen = json_object_array_length(jobj);
+		while (true) {
+			data_t *child;
+
+			_skip_space(p);
+			if ((p->pos >= p->end) || (*p->pos != '"')) {
+				p->err = "expected object key";
+				return SLURM_ERROR;
+			}
+			p->pos++;
+			if (!(str = _parse_string(p)))
+				return SLURM_ERROR;
+			p->pos++;
+			/* duplicate keys keep the last value */
+			child = data_key_set(d, str);
+			xfree(str);
+
+			_skip_space(p);
+			if ((p->pos >= p->end) || (*p->pos != ':')) {
+				p->err = "expected ':' after object key";
+				return SLURM_ERROR;
+			}
+			p->pos++;
+			if (_parse_value(p, child, depth))
+				return SLURM_ERROR;
+
+			_skip_space(p);
+			if ((p->pos < p->end) && (*p->pos == ',')) {
+				p->pos++;
+			} else if ((p->pos < p->end) && (*p->pos == '}')) {
+				p->pos++;
+				return SLURM_SUCCESS;
+			} else {
+				p->err = "expected ',' or '}' in object";
+				return SLURM_ERROR;
+			}
+		}
+	case '[':
+		if (++depth > JSON_MAX_DEPTH) {
+			p->err = "nesting too deep";
+			return SLURM_ERROR;
+		}
+		p->pos++;
 		data_set_list(d);
-		for (size_t i = 0; i < arraylen; i++)
-			_json_to_data(json_object_array_get_idx(jobj, i),
-				      data_list_append(d));
-		break;
-	case json_type_string:
-		data_set_string(d, json_object_get_string(jobj));
-		break;
+		_skip_space(p);
+		if ((p->pos < p->end) && (*p->pos == ']')) {
+			p->pos++;
+			return SLURM_SUCCESS;
+		}
+		while (true) {
+			if (_parse_value(p, data_list_append(d), depth))
+				return SLURM_ERROR;
+
+			_skip_space(p);
+			if ((p->pos < p->end) && (*p->pos == ',')) {
+				p->pos++;
+			} else if ((p->pos < p->end) && (*p->pos == ']')) {
+				p->pos++;
+				return SLURM_SUCCESS;
+			} else {
+				p->err = "expected ',' or ']' in array";
+				return SLURM_ERROR;
+			}
+		}
+	case '"':
+		p->pos++;
+		if (!(str = _parse_string(p)))
+			return SLURM_ERROR;
+		p->pos++;
+		data_set_string_own(d, str);
+		return SLURM_SUCCESS;
+	case 't':
+		if (_parse_literal(p, "true"))
+			return SLURM_ERROR;
+		data_set_bool(d, true);
+		return SLURM_SUCCESS;
+	case 'f':
+		if (_parse_literal(p, "false"))
+			return SLURM_ERROR;
+		data_set_bool(d, false);
+		return SLURM_SUCCESS;
+	case 'n':
+		if (_parse_literal(p, "null"))
+			return SLURM_ERROR;
+		data_set_null(d);
+		return SLURM_SUCCESS;
+	/* non-finite floats as written by _write_float() and json-c */
+	case 'N':
+		if (_parse_literal(p, "NaN"))
+			return SLURM_ERROR;
+		data_set_float(d, NAN);
+		return SLURM_SUCCESS;
+	case 'I':
+		if (_parse_literal(p, "Infinity"))
+			return SLURM_ERROR;
+		data_set_float(d, INFINITY);
+		return SLURM_SUCCESS;
+	case '-':
+		if (((p->end - p->pos) > 1) && (p->pos[1] == 'I')) {
+			p->pos++;
+			if (_parse_literal(p, "Infinity"))
+				return SLURM_ERROR;
+			data_set_float(d, -INFINITY);
+			return SLURM_SUCCESS;
+		}
+		return _parse_number(p, d);
 	default:
-		fatal_abort("%s: unknown JSON type", __func__);
-	};
+		return _parse_number(p, d);
+	}
+}
+
+static void _write_mem(json_writer_t *w, const char *mem, size_t len)
+{
+	if ((w->len + len + 1) > w->size) {
+		w->size = MAX((w->size * 2), (w->len + len + 1));
+		xrealloc_nz(w->buf, w->size);
+	}
+	memcpy(w->buf + w->len, mem, len);
+	w->len += len;
+}
+
+#define _write_str(w, str) _write_mem(w, str, strlen(str))
+
+static void _write_string(json_writer_t *w, const char *str)
+{
+	static const char hex[] = "0123456789abcdef";
+	const char *run = str;
+
+	_write_mem(w, "\"", 1);
+	for (const char *c = str; *c; c++) {
+		unsigned char uc = *c;
+		char esc[7] = { '\\', 0 };
+		int esc_len = 2;
+
+		if (uc == '"')
+			esc[1] = '"';
+		else if (uc == '\\')
+			esc[1] = '\\';
+		else if (uc == '\n')
+			esc[1] = 'n';
+		else if (uc == '\r')
+			esc[1] = 'r';
+		else if (uc == '\t')
+			esc[1] = 't';
+		else if (uc == '\b')
+			esc[1] = 'b';
+		else if (uc == '\f')
+			esc[1] = 'f';
+		else if (uc < 0x20) {
+			esc[1] = 'u';
+			esc[2] = '0';
+			esc[3] = '0';
+			esc[4] = hex[uc >> 4];
+			esc[5] = hex[uc & 0xf];
+			esc_len = 6;
+		} else
+			continue;
+
+		_write_mem(w, run, (c - run));
+		_write_mem(w, esc, esc_len);
+		run = c + 1;
+	}
+	_write_str(w, run);
+	_write_mem(w, "\"", 1);
+}
 
-	return d;
+static void _write_indent(json_writer_t *w)
+{
+	static const char spaces[] = "                                ";
+	int len = w->level * JSON_PRETTY_INDENT;
+
+	_write_mem(w, "\n", 1);
+	while (len > 0) {
+		int n = MIN(len, (sizeof(spaces) - 1));
+		_write_mem(w, spaces, n);
+		len -= n;
+	}
 }
 
-static data_for_each_cmd_t _convert_dict_json(const char *key,
-					      const data_t *data,
-					      void *arg)
+static void _write_value(json_writer_t *w, const data_t *d);
+
+static data_for_each_cmd_t _write_dict_entry(const char *key,
+					     const data_t *data, void *arg)
 {
-	json_object *jobj = arg;
-	json_object *jobject = _data_to_json(data);
+	json_writer_t *w = arg;
+
+	if (w->buf[w->len - 1] != '{')
+		_write_mem(w, ",", 1);
+	if (w->pretty)
+		_write_indent(w);
+	_write_string(w, key);
+	if (w->pretty)
+		_write_mem(w, ": ", 2);
+	else
+		_write_mem(w, ":", 1);
+	_write_value(w, data);
 
-	json_object_object_add(jobj, key, jobject);
 	return DATA_FOR_EACH_CONT;
 }
 
-static data_for_each_cmd_t _convert_list_json(const data_t *data, void *arg)
+static data_for_each_cmd_t _write_list_entry(const data_t *data, void *arg)
 {
-	json_object *jobj = arg;
-	json_object *jarray = _data_to_json(data);
+	json_writer_t *w = arg;
+
+	if (w->buf[w->len - 1] != '[')
+		_write_mem(w, ",", 1);
+	if (w->pretty)
+		_write_indent(w);
+	_write_value(w, data);
 
-	json_object_array_add(jobj, jarray);
 	return DATA_FOR_EACH_CONT;
 }
 
-static json_object *_data_to_json(const data_t *d)
+static void _write_float(json_writer_t *w, double value)
 {
-	if (!d)
-		return NULL;
+	char buf[64];
+	int len;
+
+	if (isnan(value)) {
+		_write_str(w, "NaN");
+		return;
+	} else if (isinf(value)) {
+		_write_str(w, ((value < 0) ? "-Infinity" : "Infinity"));
+		return;
+	}
+
+	len = snprintf(buf, sizeof(buf), "%.17g", value);
+	_write_mem(w, buf, len);
+	/* keep the value a float when parsed again */
+	if (!strpbrk(buf, ".eE"))
+		_write_mem(w, ".0", 2);
+}
+
+static void _write_value(json_writer_t *w, const data_t *d)
+{
+	char buf[32];
+	int len;
+
+	if (!d) {
+		_write_str(w, "null");
+		return;
+	}
 
 	switch (data_get_type(d)) {
 	case DATA_TYPE_NULL:
-		return NULL;
+		_write_str(w, "null");
 		break;
 	case DATA_TYPE_BOOL:
-		return json_object_new_boolean(data_get_bool(d));
+		_write_str(w, (data_get_bool(d) ? "true" : "false"));
 		break;
 	case DATA_TYPE_FLOAT:
-		return json_object_new_double(data_get_float(d));
+		_write_float(w, data_get_float(d));
 		break;
 	case DATA_TYPE_INT_64:
-		return json_object_new_int64(data_get_int(d));
+		len = snprintf(buf, sizeof(buf), "%"PRId64, data_get_int(d));
+		_write_mem(w, buf, len);
 		break;
 	case DATA_TYPE_DICT:
-	{
-		json_object *jobj = json_object_new_object();
-		if (data_dict_for_each_const(d, _convert_dict_json, jobj) < 0)
-			error("%s: unexpected error calling _convert_dict_json()",
+		_write_mem(w, "{", 1);
+		w->level++;
+		if (data_dict_for_each_const(d, _write_dict_entry, w) < 0)
+			error("%s: unexpected error calling _write_dict_entry()",
 			      __func__);
-		return jobj;
-	}
+		w->level--;
+		if (w->pretty && (w->buf[w->len - 1] != '{'))
+			_write_indent(w);
+		_write_mem(w, "}", 1);
+		break;
 	case DATA_TYPE_LIST:
-	{
-		json_object *jobj = json_object_new_array();
-		if (data_list_for_each_const(d, _convert_list_json, jobj) < 0)
-			error("%s: unexpected error calling _convert_list_json()",
+		_write_mem(w, "[", 1);
+		w->level++;
+		if (data_list_for_each_const(d, _write_list_entry, w) < 0)
+			error("%s: unexpected error calling _write_list_entry()",
 			      __func__);
-		return jobj;
-	}
+		w->level--;
+		if (w->pretty && (w->buf[w->len - 1] != '['))
+			_write_indent(w);
+		_write_mem(w, "]", 1);
+		break;
 	case DATA_TYPE_STRING:
 	{
 		const char *str = data_get_string_const(d);
-		if (str)
-			return json_object_new_string(str);
-		else
-			return json_object_new_string("");
+		_write_string(w, (str ? str : ""));
 		break;
 	}
 	default:
@@ -233,27 +671,20 @@ static json_object *_data_to_json(const data_t *d)
 extern int serializer_p_serialize(char **dest, const data_t *data,
 				  data_serializer_flags_t flags)
 {
-	struct json_object *jobj = _data_to_json(data);
-	int jflags = 0;
+	json_writer_t w = { 0 };
 
 	/* can't be pretty and compact at the same time! */
 	xassert((flags & (DATA_SER_FLAGS_PRETTY | DATA_SER_FLAGS_COMPACT)) !=
 		(DATA_SER_FLAGS_PRETTY | DATA_SER_FLAGS_COMPACT));
 
-	switch (flags) {
-	case DATA_SER_FLAGS_PRETTY:
-		jflags = JSON_C_TO_STRING_SPACED | JSON_C_TO_STRING_PRETTY;
-		break;
-	case DATA_SER_FLAGS_COMPACT: /* fallthrough */
-	default:
-		jflags = JSON_C_TO_STRING_PLAIN;
-	}
+	w.pretty = (flags == DATA_SER_FLAGS_PRETTY);
+	w.size = BUFSIZ;
+	w.buf = xmalloc_nz(w.size);
 
-	/* string will die with jobj */
-	*dest = xstrdup(json_object_to_json_string_ext(jobj, jflags));
+	_write_value(&w, data);
+	w.buf[w.len] = '\0';
 
-	/* put is equiv to free() */
-	json_object_put(jobj);
+	*dest = w.buf;
 
 	return SLURM_SUCCESS;
 }
@@ -261,31 +692,30 @@ extern int serializer_p_serialize(char **dest, const data_t *data,
 extern int serializer_p_deserialize(data_t **dest, const char *src,
 				    size_t len)
 {
-	json_object *jobj = NULL;
-	data_t *data = NULL;
-	struct json_tokener *tok = json_tokener_new();
-
-	if (!tok)
-		return ENOMEM;
+	json_parser_t p;
+	data_t *data;
 
 	if (!src)
 		return ESLURM_DATA_PTR_NULL;
 
-	/* json-c has hard limit of 32 bits */
-	if (len >= INT32_MAX) {
-		error("%s: unable to parse JSON: too large",
-		      __func__);
-		return ESLURM_DATA_TOO_LARGE;
+	p.src = p.pos = src;
+	p.end = src + len;
+	p.err = NULL;
+
+	data = data_new();
+	if (_parse_value(&p, data, 0)) {
+		error("%s: JSON parsing error %zu bytes: %s at offset %zu",
+		      __func__, len, p.err, (size_t) (p.pos - p.src));
+		FREE_NULL_DATA(data);
+	} else {
+		_skip_space(&p);
+		/* text is often sent with a trailing NUL */
+		if ((p.pos < p.end) && !((*p.pos == '\0') &&
+					 ((p.pos + 1) == p.end)))
+			info("%s: WARNING: Extra %zu characters after JSON string detected",
+			     __func__, (size_t) (p.end - p.pos));
 	}
 
-	jobj = _try_parse(src, len, tok);
-	if (jobj) {
-		data = _json_to_data(jobj, NULL);
-		json_object_put(jobj);
-	}
-
-	json_tokener_free(tok);
-
 	*dest = data;
 	return SLURM_SUCCESS;
 }
@@ -139,25 +139,38 @@ static void _lllp_free_masks(const uint32_t maxtasks, bitstr_t **masks)
 static void _match_masks_to_ldom(const uint32_t maxtasks, bitstr_t **masks)
 {
 	uint32_t i, b, size;
+	uint16_t nnid, max_nnid = 0;
+	bitstr_t **ldom_masks;
 
 	if (!masks || !masks[0])
 		return;
 	size = bit_size(masks[0]);
-	for(i = 0; i < maxtasks; i++) {
-		for (b = 0; b < size; b++) {
-			if (bit_test(masks[i], b)) {
-				/* get the NUMA node for this CPU, and then
-				 * set all CPUs in the mask that exist in
-				 * the same CPU */
-				int c;
-				uint16_t nnid = slurm_get_numa_node(b);
-				for (c = 0; c < size; c++) {
-					if (slurm_get_numa_node(c) == nnid)
-						bit_set(masks[i], c);
-				}
-			}
+
+	/* build the CPU mask of each NUMA node once for all the tasks */
+	for (b = 0; b < size; b++)
+		max_nnid = MAX(max_nnid, slurm_get_numa_node(b));
+	ldom_masks = xcalloc(max_nnid + 1, sizeof(bitstr_t *));
+	for (b = 0; b < size; b++) {
+		nnid = slurm_get_numa_node(b);
+		if (!ldom_masks[nnid])
+			ldom_masks[nnid] = bit_alloc(size);
+		bit_set(ldom_masks[nnid], b);
+	}
+
+	/* set all CPUs of each NUMA node the mask has a CPU in */
+	for (i = 0; i < maxtasks; i++) {
+		if (!masks[i])
+			continue;
+		for (nnid = 0; nnid <= max_nnid; nnid++) {
+			if (ldom_masks[nnid] &&
+			    bit_overlap_any(masks[i], ldom_masks[nnid]))
+				bit_or(masks[i], ldom_masks[nnid]);
 		}
 	}
+
+	for (nnid = 0; nnid <= max_nnid; nnid++)
+		FREE_NULL_BITMAP(ldom_masks[nnid]);
+	xfree(ldom_masks);
 }
 #endif
 
@@ -828,59 +841,45 @@ static bitstr_t *_get_avail_map(launch_tasks_request_msg_t *req,
 	return hw_map;
 }
 
-/* helper function for _expand_masks() */
-static void _blot_mask(bitstr_t *mask, bitstr_t *avail_map, uint16_t blot)
+/*
+ * helper function for _expand_masks()
+ * for each task, set every bit of avail_map in the blot sized blocks
+ * (cores or sockets) the task's mask has a bit in. The available bits of a
+ * block are only computed once for all the tasks and merged into the masks
+ * a word at a time.
+ */
+static void _blot_masks(const uint32_t maxtasks, bitstr_t **masks,
+			bitstr_t *avail_map, int blot)
 {
-	uint16_t i, j, size = 0;
-	int prev = -1;
+	int i, b, blot_inx, blot_cnt, start, size;
+	bitstr_t **blot_maps;
 
-	if (!mask)
-		return;
-	size = bit_size(mask);
-	for (i = 0; i < size; i++) {
-		if (bit_test(mask, i)) {
-			/* fill in this blot */
-			uint16_t start = (i / blot) * blot;
-			if (start != prev) {
-				for (j = start; j < start + blot; j++) {
-					if (bit_test(avail_map, j))
-						bit_set(mask, j);
-				}
-				prev = start;
-			}
-		}
-	}
-}
-
-/* helper function for _expand_masks()
- * for each task, consider which other bits are set in avail_map
- * on the same socket */
-static void _blot_mask_sockets(const uint32_t maxtasks, const uint32_t task,
-			       bitstr_t **masks, uint16_t hw_sockets,
-			       uint16_t hw_cores, uint16_t hw_threads,
-			       bitstr_t *avail_map)
-{
-  	uint16_t i, j, size = 0;
-	int blot;
+	size = bit_size(avail_map);
+	blot_cnt = (size + blot - 1) / blot;
+	blot_maps = xcalloc(blot_cnt, sizeof(bitstr_t *));
 
-	if (!masks[task])
- 		return;
-
-	blot = bit_size(avail_map) / hw_sockets;
-	if (blot <= 0)
-		blot = 1;
-	size = bit_size(masks[task]);
-	for (i = 0; i < size; i++) {
-		if (bit_test(masks[task], i)) {
-			/* check if other bits are set in avail_map on this
-			 * socket and set each corresponding bit in masks */
-			uint16_t start = (i / blot) * blot;
-			for (j = start; j < start+blot; j++) {
-				if (bit_test(avail_map, j))
-					bit_set(masks[task], j);
+	for (i = 0; i < maxtasks; i++) {
+		if (!masks[i])
+			continue;
+		b = bit_ffs(masks[i]);
+		while (b >= 0) {
+			blot_inx = b / blot;
+			start = blot_inx * blot;
+			if (!blot_maps[blot_inx]) {
+				blot_maps[blot_inx] = bit_alloc(size);
+				bit_nset(blot_maps[blot_inx], start,
+					 MIN(start + blot, size) - 1);
+				bit_and(blot_maps[blot_inx], avail_map);
 			}
+			bit_or(masks[i], blot_maps[blot_inx]);
+			/* the rest of this block is done, go to the next */
+			b = bit_ffs_from_bit(masks[i], start + blot);
 		}
 	}
+
+	for (i = 0; i < blot_cnt; i++)
+		FREE_NULL_BITMAP(blot_maps[i]);
+	xfree(blot_maps);
 }
 
 /* for each mask, expand the mask around the set bits to include the
@@ -890,25 +889,23 @@ static void _expand_masks(uint16_t cpu_bind_type, const uint32_t maxtasks,
 			  uint16_t hw_cores, uint16_t hw_threads,
 			  bitstr_t *avail_map)
 {
-	uint32_t i;
+	int blot;
 
 	if (cpu_bind_type & CPU_BIND_TO_THREADS)
 		return;
 	if (cpu_bind_type & CPU_BIND_TO_CORES) {
 		if (hw_threads < 2)
 			return;
-		for (i = 0; i < maxtasks; i++) {
-			_blot_mask(masks[i], avail_map, hw_threads);
-		}
+		_blot_masks(maxtasks, masks, avail_map, hw_threads);
 		return;
 	}
 	if (cpu_bind_type & CPU_BIND_TO_SOCKETS) {
 		if (hw_threads*hw_cores < 2)
 			return;
-		for (i = 0; i < maxtasks; i++) {
-   			_blot_mask_sockets(maxtasks, i, masks, hw_sockets,
-					   hw_cores, hw_threads, avail_map);
-		}
+		blot = bit_size(avail_map) / hw_sockets;
+		if (blot <= 0)
+			blot = 1;
+		_blot_masks(maxtasks, masks, avail_map, blot);
 		return;
 	}
 }
@@ -1310,16 +1307,14 @@ static bitstr_t *_lllp_map_abstract_mask(bitstr_t *bitmask)
 	newmask = (bitstr_t *) bit_alloc(num_bits);
 
 	/* remap to physical machine */
-	for (i = 0; i < num_bits; i++) {
-		if (bit_test(bitmask,i)) {
-			bit = BLOCK_MAP(i);
-			if (bit < bit_size(newmask))
-				bit_set(newmask, bit);
-			else
-				error("can't go from %d -> %d since we "
-				      "only have %"BITSTR_FMT" bits",
-				      i, bit, bit_size(newmask));
-		}
+	for (i = bit_ffs(bitmask); i >= 0;
+	     i = bit_ffs_from_bit(bitmask, i + 1)) {
+		bit = BLOCK_MAP(i);
+		if (bit < num_bits)
+			bit_set(newmask, bit);
+		else
+			error("can't go from %d -> %d since we "
+			      "only have %d bits", i, bit, num_bits);
 	}
 	return newmask;
 }
@@ -108,7 +108,7 @@ typedef struct slurm_conf_switches {
 static s_p_hashtbl_t *conf_hashtbl = NULL;
 static char* topo_conf = NULL;
 
-static void _check_better_path(int i, int j ,int k);
+static void _compute_switches_dist(void);
 static void _destroy_switches(void *ptr);
 static void _free_switch_record_table(void);
 static int  _get_switch_inx(const char *name);
@@ -445,30 +445,7 @@ static void _validate_switches(void)
 		}
 	}
 
-	for (i = 0; i < switch_record_cnt; i++) {
-		switch_record_table[i].switches_dist = xcalloc(
-			switch_record_cnt, sizeof(uint32_t));
-	}
-	for (i = 0; i < switch_record_cnt; i++) {
-		for (j = i + 1; j < switch_record_cnt; j++) {
-			switch_record_table[i].switches_dist[j] = INFINITE;
-			switch_record_table[j].switches_dist[i] = INFINITE;
-		}
-		for (j = 0; j < switch_record_table[i].num_switches; j++) {
-			uint16_t child = switch_record_table[i].switch_index[j];
-
-			switch_record_table[i].switches_dist[child] = 1;
-			switch_record_table[child].switches_dist[i] = 1;
-		}
-	}
-	for (i = 0; i < switch_record_cnt; i++) {
-		for (j = 0; j < switch_record_cnt; j++) {
-			int k;
-			for (k = 0; k < switch_record_cnt; k++) {
-				_check_better_path(i, j ,k);
-			}
-		}
-	}
+	_compute_switches_dist();
 	if (!have_root && running_in_daemon())
 		info("TOPOLOGY: warning -- no switch can reach all nodes through its descendants. If this is not intentional, fix the topology.conf file.");
 
@@ -677,18 +654,67 @@ static int _node_name2bitmap(char *node_names, bitstr_t **bitmap,
 	return SLURM_SUCCESS;
 }
 
-static void _check_better_path(int i, int j ,int k)
+/*
+ * Fill in switches_dist[] for every switch with the number of links between
+ * each pair of switches (INFINITE if not connected). Every link has the same
+ * weight, so a breadth-first search from each switch gives the same result
+ * as an all-pairs shortest path pass in O(switches * links) rather than
+ * O(switches^3) time.
+ */
+static void _compute_switches_dist(void)
 {
-	int tmp;
-
-	if ((switch_record_table[j].switches_dist[i] == INFINITE) ||
-	    (switch_record_table[i].switches_dist[k] == INFINITE)) {
-		tmp = INFINITE;
-	} else {
-		tmp = switch_record_table[j].switches_dist[i] +
-		      switch_record_table[i].switches_dist[k];
+	int i, j, head, tail, link_cnt = 0;
+	int *link_off, *link_pos, *links, *queue;
+	uint32_t *dist;
+
+	if (!switch_record_cnt)
+		return;
+
+	/* Build undirected adjacency lists from the child switch arrays */
+	link_off = xcalloc(switch_record_cnt + 1, sizeof(int));
+	for (i = 0; i < switch_record_cnt; i++) {
+		for (j = 0; j < switch_record_table[i].num_switches; j++) {
+			link_off[i + 1]++;
+			link_off[switch_record_table[i].switch_index[j] + 1]++;
+		}
+	}
+	for (i = 0; i < switch_record_cnt; i++)
+		link_off[i + 1] += link_off[i];
+	link_cnt = link_off[switch_record_cnt];
+	links = xcalloc(MAX(link_cnt, 1), sizeof(int));
+	link_pos = xcalloc(switch_record_cnt, sizeof(int));
+	for (i = 0; i < switch_record_cnt; i++)
+		link_pos[i] = link_off[i];
+	for (i = 0; i < switch_record_cnt; i++) {
+		for (j = 0; j < switch_record_table[i].num_switches; j++) {
+			int child = switch_record_table[i].switch_index[j];
+			links[link_pos[i]++] = child;
+			links[link_pos[child]++] = i;
+		}
 	}
+	xfree(link_pos);
 
-	if (switch_record_table[j].switches_dist[k] > tmp)
-		switch_record_table[j].switches_dist[k] = tmp;
+	queue = xcalloc(switch_record_cnt, sizeof(int));
+	for (i = 0; i < switch_record_cnt; i++) {
+		dist = xcalloc(switch_record_cnt, sizeof(uint32_t));
+		for (j = 0; j < switch_record_cnt; j++)
+			dist[j] = INFINITE;
+		dist[i] = 0;
+		head = tail = 0;
+		queue[tail++] = i;
+		while (head < tail) {
+			int sw = queue[head++];
+			for (j = link_off[sw]; j < link_off[sw + 1]; j++) {
+				int peer = links[j];
+				if (dist[peer] != INFINITE)
+					continue;
+				dist[peer] = dist[sw] + 1;
+				queue[tail++] = peer;
+			}
+		}
+		switch_record_table[i].switches_dist = dist;
+	}
+	xfree(queue);
+	xfree(links);
+	xfree(link_off);
 }
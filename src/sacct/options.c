@@ -1574,6 +1574,7 @@ extern void sacct_fini(void)
 	FREE_NULL_LIST(jobs);
 	FREE_NULL_LIST(g_qos_list);
 	FREE_NULL_LIST(g_tres_list);
+	print_fini();
 
 	if (params.opt_completion)
 		slurmdb_jobcomp_fini();
@@ -39,12 +39,26 @@
 #include "sacct.h"
 #include "src/common/cpu_frequency.h"
 #include "src/common/parse_time.h"
+#include "src/common/uid.h"
 #include "slurm.h"
 
 print_field_t *field = NULL;
 int curr_inx = 1;
 char outbuf[FORMAT_STRING_SIZE];
 
+typedef struct {
+	uint32_t id;
+	char *name;		/* NULL if the id has no name */
+} id_name_t;
+
+typedef struct {
+	int cnt;
+	id_name_t *entry;	/* sorted by id */
+} id_cache_t;
+
+static id_cache_t gid_cache = { 0, NULL };
+static id_cache_t uid_cache = { 0, NULL };
+
 #define SACCT_TRES_AVE  0x0001
 #define SACCT_TRES_OUT  0x0002
 #define SACCT_TRES_MIN  0x0004
@@ -86,6 +100,47 @@ static char *_elapsed_time(uint64_t secs, uint64_t usecs)
 	return str;
 }
 
+static int _id_name_cmp(const void *a, const void *b)
+{
+	uint32_t id_a = ((id_name_t *) a)->id;
+	uint32_t id_b = ((id_name_t *) b)->id;
+
+	return (id_a > id_b) - (id_a < id_b);
+}
+
+/*
+ * Resolve a uid or gid to its name once per distinct id. Both lookups can go
+ * to a remote directory service and were done for every record printed.
+ * The returned string belongs to the cache.
+ */
+static char *_id_name_cached(id_cache_t *cache, uint32_t id, bool group)
+{
+	id_name_t key = { .id = id }, *entry;
+
+	entry = bsearch(&key, cache->entry, cache->cnt, sizeof(id_name_t),
+			_id_name_cmp);
+	if (entry)
+		return entry->name;
+
+	if (group)
+		key.name = gid_to_string_or_null((gid_t) id);
+	else
+		key.name = uid_to_string_or_null((uid_t) id);
+	xrecalloc(cache->entry, cache->cnt + 1, sizeof(id_name_t));
+	cache->entry[cache->cnt++] = key;
+	qsort(cache->entry, cache->cnt, sizeof(id_name_t), _id_name_cmp);
+
+	return key.name;
+}
+
+static void _id_cache_free(id_cache_t *cache)
+{
+	for (int i = 0; i < cache->cnt; i++)
+		xfree(cache->entry[i].name);
+	xfree(cache->entry);
+	cache->cnt = 0;
+}
+
 static char *_find_qos_name_from_list(List qos_list, int qosid)
 {
 	slurmdb_qos_rec_t *qos;
@@ -280,7 +335,6 @@ extern void print_fields(type_t type, void *object)
 	slurmdb_step_rec_t *step = (slurmdb_step_rec_t *)object;
 	jobcomp_job_rec_t *job_comp = (jobcomp_job_rec_t *)object;
 	struct passwd *pw = NULL;
-	struct	group *gr = NULL;
 	int cpu_tres_rec_count = 0;
 	int step_cpu_tres_rec_count = 0;
 	char tmp1[128];
@@ -943,8 +997,9 @@ extern void print_fields(type_t type, void *object)
 				break;
 			}
 			tmp_char = NULL;
-			if ((gr=getgrgid(tmp_int)))
-				tmp_char=gr->gr_name;
+			if (tmp_int != NO_VAL)
+				tmp_char = _id_name_cached(&gid_cache, tmp_int,
+							   true);
 
 			field->print_routine(field,
 					     tmp_char,
@@ -2295,8 +2350,10 @@ extern void print_fields(type_t type, void *object)
 			case JOB:
 				if (job->user)
 					tmp_char = job->user;
-				else if ((pw=getpwuid(job->uid)))
-						tmp_char = pw->pw_name;
+				else
+					tmp_char = _id_name_cached(&uid_cache,
+								   job->uid,
+								   false);
 				break;
 			case JOBSTEP:
 
@@ -2400,3 +2457,9 @@ extern void print_fields(type_t type, void *object)
 	}
 	printf("\n");
 }
+
+extern void print_fini(void)
+{
+	_id_cache_free(&gid_cache);
+	_id_cache_free(&uid_cache);
+}
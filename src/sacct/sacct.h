@@ -228,6 +228,7 @@ void aggregate_stats(slurmdb_stats_t *dest, slurmdb_stats_t *from);
 
 /* print.c */
 void print_fields(type_t type, void *object);
+void print_fini(void);
 
 /* options.c */
 int  get_data(void);
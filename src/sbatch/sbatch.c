@@ -68,12 +68,14 @@
 
 #define MAX_RETRIES 15
 #define MAX_WAIT_SLEEP_TIME 32
+#define MAX_SUBMIT_LIST_JOBS 1000	/* jobs per --submit-list RPC */
 
 static void  _add_bb_to_script(char **script_body, char *burst_buffer_file);
 static void  _env_merge_filter(job_desc_msg_t *desc);
 static int   _fill_job_desc_from_opts(job_desc_msg_t *desc);
 static void *_get_script_buffer(const char *filename, int *size);
 static int   _job_wait(uint32_t job_id);
+static bool  _retry_submit(int *retries);
 static char *_script_wrap(char *command_string);
 static void  _set_exit_code(void);
 static void  _set_prio_process_env(void);
@@ -81,6 +83,11 @@ static int   _set_rlimit_env(void);
 static void  _set_spank_env(void);
 static void  _set_submit_dir_env(void);
 static int   _set_umask_env(void);
+static int   _submit_list(int argc, char **argv, char *script_name,
+			  bool quiet);
+static job_desc_msg_t *_submit_list_job_desc(int argc, char **argv,
+					     int job_argc, char **job_argv);
+static int   _submit_list_send(List job_req_list, int *job_line, bool quiet);
 
 int main(int argc, char **argv)
 {
@@ -130,6 +137,9 @@ int main(int argc, char **argv)
 		log_alter(logopt, 0, NULL);
 	}
 
+	if (sbopt.submit_list)
+		exit(_submit_list(argc, argv, script_name, quiet));
+
 	if (sbopt.wrap != NULL) {
 		script_body = _script_wrap(sbopt.wrap);
 	} else {
@@ -283,35 +293,17 @@ int main(int argc, char **argv)
 	}
 
 	while (true) {
-		static char *msg;
 		if (job_req_list)
 			rc = slurm_submit_batch_het_job(job_req_list, &resp);
 		else
 			rc = slurm_submit_batch_job(desc, &resp);
 		if (rc >= 0)
 			break;
-		if (errno == ESLURM_ERROR_ON_DESC_TO_RECORD_COPY) {
-			msg = "Slurm job queue full, sleeping and retrying";
-		} else if (errno == ESLURM_NODES_BUSY) {
-			msg = "Job creation temporarily disabled, retrying";
-		} else if (errno == EAGAIN) {
-			msg = "Slurm temporarily unable to accept job, "
-			      "sleeping and retrying";
-		} else
-			msg = NULL;
-		if ((msg == NULL) || (retries >= MAX_RETRIES)) {
+		if (!_retry_submit(&retries)) {
 			error("Batch job submission failed: %m");
 			exit(error_exit);
 		}
-
-		if (retries)
-			debug("%s", msg);
-		else if (errno == ESLURM_NODES_BUSY)
-			info("%s", msg); /* Not an error, powering up nodes */
-		else
-			error("%s", msg);
 		slurm_free_submit_response_response_msg(resp);
-		sleep(++retries);
 	}
 
 	if (!resp) {
@@ -355,6 +347,280 @@ int main(int argc, char **argv)
 	return rc;
 }
 
+/*
+ * Decide whether a failed submission should be retried based upon errno.
+ * Sleeps before returning true, returns false with errno preserved otherwise.
+ */
+static bool _retry_submit(int *retries)
+{
+	char *msg;
+
+	if (errno == ESLURM_ERROR_ON_DESC_TO_RECORD_COPY) {
+		msg = "Slurm job queue full, sleeping and retrying";
+	} else if (errno == ESLURM_NODES_BUSY) {
+		msg = "Job creation temporarily disabled, retrying";
+	} else if (errno == EAGAIN) {
+		msg = "Slurm temporarily unable to accept job, "
+		      "sleeping and retrying";
+	} else
+		msg = NULL;
+	if ((msg == NULL) || (*retries >= MAX_RETRIES))
+		return false;
+
+	if (*retries)
+		debug("%s", msg);
+	else if (errno == ESLURM_NODES_BUSY)
+		info("%s", msg); /* Not an error, powering up nodes */
+	else
+		error("%s", msg);
+	sleep(++(*retries));
+	return true;
+}
+
+/*
+ * Build the job description for one line of a --submit-list file.
+ * Options are rebuilt from scratch for every job: command line options apply
+ * to all jobs while #SBATCH directives apply only to their own script.
+ * IN argc, argv - sbatch command line
+ * IN job_argc, job_argv - batch script and its arguments, consumed
+ * RET job description or NULL if the batch script can not be used
+ */
+static job_desc_msg_t *_submit_list_job_desc(int argc, char **argv,
+					     int job_argc, char **job_argv)
+{
+	job_desc_msg_t *desc;
+	char *fullpath, *script_body;
+	int i, script_size = 0, argc_off = 0;
+	bool more_het_comps = false;
+
+	(void) process_options_first_pass(argc, argv);
+
+	if ((fullpath = search_path(opt.chdir, job_argv[0], false, R_OK,
+				    false))) {
+		xfree(job_argv[0]);
+		job_argv[0] = fullpath;
+	}
+	if (!(script_body = _get_script_buffer(job_argv[0], &script_size)))
+		goto fail;
+
+	sbopt.script_argc = job_argc;
+	sbopt.script_argv = job_argv;
+	init_envs(&het_job_env);
+	process_options_second_pass(argc, argv, &argc_off, 0, &more_het_comps,
+				    xbasename(job_argv[0]), script_body,
+				    script_size);
+	if (more_het_comps) {
+		error("%s: heterogeneous jobs are not supported by --submit-list",
+		      job_argv[0]);
+		xfree(script_body);
+		goto fail;
+	}
+
+	if (opt.burst_buffer_file) {
+		buf_t *buf = create_mmap_buf(opt.burst_buffer_file);
+		if (!buf) {
+			error("Invalid --bbf specification");
+			exit(error_exit);
+		}
+		_add_bb_to_script(&script_body, get_buf_data(buf));
+		free_buf(buf);
+	}
+
+	if (spank_init_post_opt() < 0) {
+		error("Plugin stack post-option processing failed");
+		exit(error_exit);
+	}
+
+	if (opt.get_user_env_time < 0)
+		(void) _set_rlimit_env();
+	if (sbopt.export_file != NULL)
+		env_unset_environment();
+
+	_set_prio_process_env();
+	_set_spank_env();
+	_set_submit_dir_env();
+	_set_umask_env();
+
+	desc = slurm_opt_create_job_desc(&opt);
+	if (_fill_job_desc_from_opts(desc) == -1)
+		exit(error_exit);
+	set_env_from_opts(&opt, &desc->environment, -1);
+	set_envs(&desc->environment, &het_job_env, -1);
+	desc->env_size = envcount(desc->environment);
+	desc->script = script_body;
+
+	/* The job description owns its fields, it is freed once submitted */
+	desc->array_inx = xstrdup(sbopt.array_inx);
+	desc->batch_features = xstrdup(sbopt.batch_features);
+	opt.submit_line = NULL;
+	sbopt.script_argc = 0;
+	sbopt.script_argv = NULL;
+
+	return desc;
+
+fail:
+	for (i = 0; i < job_argc; i++)
+		xfree(job_argv[i]);
+	xfree(job_argv);
+	sbopt.script_argc = 0;
+	sbopt.script_argv = NULL;
+	return NULL;
+}
+
+/*
+ * Submit the jobs built from a --submit-list file and report the outcome of
+ * each one.
+ * IN job_req_list - list of job_desc_msg_t to submit
+ * IN job_line - line number within the file of each job
+ * IN quiet - suppress the job ID output
+ * RET 0 if all jobs were submitted, error_exit otherwise
+ */
+static int _submit_list_send(List job_req_list, int *job_line, bool quiet)
+{
+	submit_response_list_msg_t *resp = NULL;
+	int retries = 0, rc = 0;
+	uint32_t i;
+
+	while (slurm_submit_batch_job_list(job_req_list, &resp) < 0) {
+		if (!_retry_submit(&retries)) {
+			error("Batch job submission failed: %m");
+			return error_exit;
+		}
+	}
+
+	if (!resp || (resp->job_cnt != list_count(job_req_list))) {
+		error("Batch job submission failed: %s",
+		      slurm_strerror(SLURM_UNEXPECTED_MSG_ERROR));
+		slurm_free_submit_response_list_msg(resp);
+		return error_exit;
+	}
+
+	for (i = 0; i < resp->job_cnt; i++) {
+		if (!resp->job_id[i]) {
+			error("%s line %d: Batch job submission failed: %s",
+			      sbopt.submit_list, job_line[i],
+			      slurm_strerror(resp->error_code[i]));
+			print_multi_line_string(resp->job_submit_user_msg[i],
+						-1, LOG_LEVEL_ERROR);
+			rc = error_exit;
+			continue;
+		}
+
+		print_multi_line_string(resp->job_submit_user_msg[i], -1,
+					LOG_LEVEL_INFO);
+		cli_filter_g_post_submit(0, resp->job_id[i], NO_VAL);
+
+		if (quiet)
+			continue;
+		if (!sbopt.parsable) {
+			printf("Submitted batch job %u", resp->job_id[i]);
+			if (working_cluster_rec)
+				printf(" on cluster %s",
+				       working_cluster_rec->name);
+			printf("\n");
+		} else {
+			printf("%u", resp->job_id[i]);
+			if (working_cluster_rec)
+				printf(";%s", working_cluster_rec->name);
+			printf("\n");
+		}
+	}
+	slurm_free_submit_response_list_msg(resp);
+
+	return rc;
+}
+
+/*
+ * Submit one independent batch job for each line of the --submit-list file.
+ * Each line names a batch script followed by its arguments, blank lines and
+ * lines starting with '#' are ignored. Jobs are sent to slurmctld in groups
+ * of up to MAX_SUBMIT_LIST_JOBS per RPC.
+ * RET 0 if all jobs were submitted, error_exit otherwise
+ */
+static int _submit_list(int argc, char **argv, char *script_name, bool quiet)
+{
+	FILE *fp;
+	char *line = NULL, *tok, *save_ptr;
+	char **job_argv;
+	size_t line_size = 0;
+	int i, job_argc, job_cnt = 0, lineno = 0, rc = 0;
+	int job_line[MAX_SUBMIT_LIST_JOBS];
+	List job_req_list;
+	job_desc_msg_t *desc;
+
+	if (script_name || sbopt.wrap) {
+		error("A batch script may not be specified with --submit-list");
+		return error_exit;
+	}
+	for (i = 1; i < argc; i++) {
+		if (!xstrcmp(argv[i], ":")) {
+			error("Heterogeneous jobs are not supported by --submit-list");
+			return error_exit;
+		}
+	}
+	if (sbopt.wait || sbopt.test_only) {
+		error("--submit-list is incompatible with --wait and --test-only");
+		return error_exit;
+	}
+	if (!(fp = fopen(sbopt.submit_list, "r"))) {
+		error("Unable to open file %s: %m", sbopt.submit_list);
+		return error_exit;
+	}
+
+	job_req_list = list_create((ListDelF) slurm_free_job_desc_msg);
+	while (getline(&line, &line_size, fp) != -1) {
+		lineno++;
+		job_argc = 0;
+		job_argv = NULL;
+		tok = strtok_r(line, " \t\n", &save_ptr);
+		if (!tok || (tok[0] == '#'))
+			continue;
+		while (tok) {
+			xrecalloc(job_argv, job_argc + 2, sizeof(char *));
+			job_argv[job_argc++] = xstrdup(tok);
+			tok = strtok_r(NULL, " \t\n", &save_ptr);
+		}
+
+		if (!(desc = _submit_list_job_desc(argc, argv, job_argc,
+						  job_argv))) {
+			error("%s line %d: Batch job submission failed",
+			      sbopt.submit_list, lineno);
+			rc = error_exit;
+			continue;
+		}
+
+		if (opt.clusters && !working_cluster_rec &&
+		    (slurmdb_get_first_avail_cluster(desc, opt.clusters,
+						     &working_cluster_rec) !=
+		     SLURM_SUCCESS)) {
+			print_db_notok(opt.clusters, 0);
+			exit(error_exit);
+		}
+
+		job_line[list_count(job_req_list)] = lineno;
+		list_append(job_req_list, desc);
+		job_cnt++;
+		if (list_count(job_req_list) >= MAX_SUBMIT_LIST_JOBS) {
+			if (_submit_list_send(job_req_list, job_line, quiet))
+				rc = error_exit;
+			list_flush(job_req_list);
+		}
+	}
+	if (list_count(job_req_list) &&
+	    _submit_list_send(job_req_list, job_line, quiet))
+		rc = error_exit;
+
+	if (!job_cnt && !rc) {
+		error("%s contains no batch jobs", sbopt.submit_list);
+		rc = error_exit;
+	}
+	FREE_NULL_LIST(job_req_list);
+	free(line);
+	fclose(fp);
+
+	return rc;
+}
+
 /* Insert the contents of "burst_buffer_file" into "script_body" */
 static void  _add_bb_to_script(char **script_body, char *burst_buffer_file)
 {
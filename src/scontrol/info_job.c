@@ -399,6 +399,55 @@ extern void scontrol_print_job(char * job_id_str)
 	}
 }
 
+/*
+ * scontrol_print_job_sched_trace - print the specified job's most recent
+ *	scheduling attempts
+ * IN job_id_str - job's id
+ */
+extern void scontrol_print_job_sched_trace(char *job_id_str)
+{
+	sched_trace_msg_t *trace_msg = NULL;
+	sched_trace_rec_t *rec;
+	char *end_ptr = NULL, time_str[32];
+	uint32_t job_id = 0;
+	int i;
+
+	if (job_id_str)
+		job_id = (uint32_t) strtoul(job_id_str, &end_ptr, 10);
+	if (!job_id || (end_ptr[0] != '\0')) {
+		exit_code = 1;
+		slurm_seterrno(ESLURM_INVALID_JOB_ID);
+		if (quiet_flag != 1)
+			slurm_perror("scontrol_print_job_sched_trace error");
+		return;
+	}
+
+	if (slurm_load_job_sched_trace(job_id, &trace_msg)) {
+		exit_code = 1;
+		if (quiet_flag != 1)
+			slurm_perror("slurm_load_job_sched_trace error");
+		return;
+	}
+
+	printf("JobId=%u Attempts=%u SchedTime=%.3fs\n", trace_msg->job_id,
+	       trace_msg->attempts, trace_msg->total_usec / 1000000.0);
+	for (i = 0, rec = trace_msg->trace_array;
+	     i < trace_msg->record_count; i++, rec++) {
+		slurm_make_time_str(&rec->time, time_str, sizeof(time_str));
+		printf("   Time=%s Scheduler=%s Reason=%s Result=%s%s"
+		       "TotalUsec=%u SelectUsec=%u AcctPolicyUsec=%u ResvUsec=%u\n",
+		       time_str,
+		       (rec->scheduler == SCHED_TRACE_BACKFILL) ?
+		       "Backfill" : "Main",
+		       job_reason_string(rec->reason),
+		       slurm_strerror(rec->error_code),
+		       one_liner ? " " : "\n   ",
+		       rec->total_usec, rec->select_usec, rec->acct_usec,
+		       rec->resv_usec);
+	}
+	slurm_free_sched_trace_msg(trace_msg);
+}
+
 /*
  * scontrol_print_step - print the specified job step's information
  * IN job_step_id_str - job step's id or NULL to print information
@@ -50,6 +50,7 @@
 #define OPT_LONG_LOCAL   0x103
 #define OPT_LONG_SIBLING 0x104
 #define OPT_LONG_FEDR    0x105
+#define OPT_LONG_SCHED_TRACE 0x106
 
 /* Global externs from scontrol.h */
 char *command_name;
@@ -63,6 +64,7 @@ int federation_flag = 0;/* show federated jobs */
 int local_flag = 0;     /* show only local jobs -- not remote remote sib jobs */
 int one_liner = 0;	/* one record per line if =1 */
 int quiet_flag = 0;	/* quiet=1, verbose=-1, normal=0 */
+int sched_trace_flag = 0; /* show job scheduling attempts */
 int sibling_flag = 0;   /* show sibling jobs (if any fed job). */
 int verbosity = 0;	/* count of "-v" options */
 uint32_t cluster_flags; /* what type of cluster are we talking to */
@@ -113,6 +115,7 @@ int main(int argc, char **argv)
 		{"local",    0, 0, OPT_LONG_LOCAL},
 		{"oneliner", 0, 0, 'o'},
 		{"quiet",    0, 0, 'Q'},
+		{"sched-trace", 0, 0, OPT_LONG_SCHED_TRACE},
 		{"sibling",  0, 0, OPT_LONG_SIBLING},
 		{"uid",	     1, 0, 'u'},
 		{"usage",    0, 0, 'h'},
@@ -201,6 +204,9 @@ int main(int argc, char **argv)
 		case (int)'Q':
 			quiet_flag = 1;
 			break;
+		case OPT_LONG_SCHED_TRACE:
+			sched_trace_flag = 1;
+			break;
 		case OPT_LONG_SIBLING:
 			sibling_flag = 1;
 			break;
@@ -1630,6 +1636,14 @@ static void _show_it(int argc, char **argv)
 	    !xstrncasecmp(argv[1], "dwstat",    MAX(tag_len, 2)))
 		allow_opt = true;
 
+	/* Interactive mode form of "scontrol --sched-trace show job <id>" */
+	if ((argc == 4) && !xstrcasecmp(argv[2], "--sched-trace") &&
+	    (!xstrncasecmp(argv[1], "jobs", 1) ||
+	     !xstrncasecmp(argv[1], "jobid", 1))) {
+		scontrol_print_job_sched_trace(argv[3]);
+		return;
+	}
+
 	if ((argc > 3) && !allow_opt) {
 		exit_code = 1;
 		if (quiet_flag != 1)
@@ -1700,7 +1714,10 @@ static void _show_it(int argc, char **argv)
 			exit_code = 1;
 	} else if (xstrncasecmp(tag, "jobs", MAX(tag_len, 1)) == 0 ||
 		   xstrncasecmp(tag, "jobid", MAX(tag_len, 1)) == 0 ) {
-		scontrol_print_job (val);
+		if (sched_trace_flag)
+			scontrol_print_job_sched_trace(val);
+		else
+			scontrol_print_job (val);
 	} else if (xstrncasecmp(tag, "licenses", MAX(tag_len, 2)) == 0) {
 		scontrol_print_licenses(val);
 	} else if (xstrncasecmp(tag, "nodes", MAX(tag_len, 1)) == 0) {
@@ -1863,6 +1880,8 @@ scontrol [<OPTION>] [<COMMAND>]                                            \n\
                     NOTE: SlurmDBD must be up.                             \n\
      -o, --oneliner Equivalent to \"oneliner\" command                     \n\
      -Q, --quiet    Equivalent to \"quiet\" command                        \n\
+     --sched-trace  With \"show job <job_id>\", report the job's recent     \n\
+	            scheduling attempts instead of the job record.         \n\
      --sibling      Report information about all sibling jobs on a         \n\
 	            federated cluster. Implies --federation option.        \n\
      -u,--uid       Update job as user \"uid\" instead of the invoking user.\n\
@@ -1924,6 +1943,8 @@ scontrol [<OPTION>] [<COMMAND>]                                            \n\
      schedloglevel <level>    set scheduler log level                      \n\
      show <ENTITY> [<ID>]     display state of identified entity, default  \n\
 			      is all records.                              \n\
+     show job --sched-trace <job_id>                                       \n\
+                              display the job's recent scheduling attempts \n\
      shutdown <OPTS>          shutdown slurm daemons                       \n\
 			      (the primary controller will be stopped)     \n\
      suspend <job_list>       susend specified job (see resume)            \n\
@@ -86,6 +86,7 @@ extern int input_words;	/* number of words of input permitted */
 extern int local_flag;	/* show only local jobs -- not remote remote sib jobs */
 extern int one_liner;	/* one record per line if =1 */
 extern int quiet_flag;	/* quiet=1, verbose=-1, normal=0 */
+extern int sched_trace_flag; /* show job scheduling attempts */
 extern int sibling_flag; /* show sibling jobs (if any fed job). */
 extern uint32_t cluster_flags; /* what type of cluster are we talking to */
 extern uint32_t euid; /* send request to the slurmctld in behave of this user */
@@ -132,6 +133,7 @@ extern void	scontrol_print_front_end(char *node_name,
 					 front_end_info_msg_t  *
 					 front_end_buffer_ptr);
 extern void	scontrol_print_job (char * job_id_str);
+extern void	scontrol_print_job_sched_trace(char *job_id_str);
 extern void	scontrol_print_hosts (char * node_list);
 extern void	scontrol_print_licenses(const char *feature);
 extern void	scontrol_print_node (char *node_name,
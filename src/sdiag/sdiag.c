@@ -59,6 +59,10 @@ stats_info_response_msg_t *buf;
 uint32_t *rpc_type_ave_time = NULL, *rpc_user_ave_time = NULL;
 
 static int  _print_stats(void);
+static void _print_lock_stats(void);
+static void _print_rpc_latency(void);
+static void _print_rpc_queue_stats(void);
+static void _print_fed_sib_stats(void);
 static void _sort_rpc(void);
 
 stats_info_request_msg_t req;
@@ -118,6 +122,7 @@ static int _print_stats(void)
 	printf("Agent queue size:     %d\n", buf->agent_queue_size);
 	printf("Agent count:          %d\n", buf->agent_count);
 	printf("Agent thread count:   %d\n", buf->agent_thread_count);
+	printf("Agent merged RPCs:    %u\n", buf->agent_merge_count);
 	printf("DBD Agent queue size: %d\n\n", buf->dbd_agent_queue_size);
 
 	printf("Jobs submitted: %d\n", buf->jobs_submitted);
@@ -147,6 +152,13 @@ static int _print_stats(void)
 		       ((buf->req_time - buf->req_time_start) / 60)));
 	}
 	printf("\tLast queue length: %u\n", buf->schedule_queue_len);
+	if (buf->schedule_cycle_counter > 0) {
+		printf("\tMean queue build time: %"PRIu64"\n",
+		       buf->schedule_queue_build_sum /
+		       buf->schedule_cycle_counter);
+		printf("\tMean node selection time: %"PRIu64"\n",
+		       buf->schedule_select_sum / buf->schedule_cycle_counter);
+	}
 
 	if (buf->bf_active) {
 		printf("\nBackfilling stats (WARNING: data obtained"
@@ -191,6 +203,12 @@ static int _print_stats(void)
 	if (buf->bf_cycle_counter > 0) {
 		printf("\tMean table size: %u\n",
 		       buf->bf_table_size_sum / buf->bf_cycle_counter);
+		printf("\tMean queue build time: %"PRIu64"\n",
+		       buf->bf_queue_build_sum / buf->bf_cycle_counter);
+		printf("\tMean node selection time: %"PRIu64"\n",
+		       buf->bf_select_sum / buf->bf_cycle_counter);
+		printf("\tMean lock yield time: %"PRIu64"\n",
+		       buf->bf_yield_sum / buf->bf_cycle_counter);
 	}
 
 	printf("\nLatency for 1000 calls to gettimeofday(): %d microseconds\n",
@@ -240,9 +258,152 @@ static int _print_stats(void)
 		       buf->rpc_dump_hostlist[i]);
 	}
 
+	_print_rpc_latency();
+	_print_lock_stats();
+	_print_rpc_queue_stats();
+	_print_fed_sib_stats();
+
 	return 0;
 }
 
+static void _print_rpc_latency(void)
+{
+	uint32_t *exec, *wait;
+	int i;
+
+	if (!buf->rpc_lat_cnt && !buf->rpc_delay_cnt)
+		return;
+
+	printf("\nRemote Procedure Call latency by message type (microseconds, "
+	       "percentiles of last %u)\n", buf->rpc_lat_window);
+	for (i = 0; i < buf->rpc_lat_cnt; i++) {
+		exec = &buf->rpc_lat_exec[i * 4];
+		wait = &buf->rpc_lat_wait[i * 4];
+		printf("\t%-40s exec p50:%-6u p90:%-6u p99:%-8u max:%-8u"
+		       " lock_wait p50:%-6u p90:%-6u p99:%-8u max:%-8u"
+		       " total:%"PRIu64"\n",
+		       rpc_num2string(buf->rpc_lat_type_id[i]),
+		       exec[0], exec[1], exec[2], exec[3],
+		       wait[0], wait[1], wait[2], wait[3],
+		       buf->rpc_lat_wait_sum[i]);
+	}
+
+	printf("\nRemote Procedure Call queueing delay (microseconds)\n");
+	printf("\tcount:%-8"PRIu64" ave:%-6"PRIu64" p50:%-6u p90:%-6u"
+	       " p99:%-8u max:%u\n",
+	       buf->rpc_delay_cnt,
+	       buf->rpc_delay_sum / MAX(buf->rpc_delay_cnt, 1),
+	       buf->rpc_delay[0], buf->rpc_delay[1], buf->rpc_delay[2],
+	       buf->rpc_delay[3]);
+}
+
+static void _print_lock_hist(char *label, uint64_t *hist)
+{
+	uint64_t limit = 10;
+	int i;
+
+	printf("\t\t%s:", label);
+	for (i = 0; (i + 1) < buf->lock_hist_cnt; i++, limit *= 10) {
+		if (limit < 1000)
+			printf(" <%"PRIu64"us:%"PRIu64, limit, hist[i]);
+		else if (limit < 1000000)
+			printf(" <%"PRIu64"ms:%"PRIu64, limit / 1000, hist[i]);
+		else
+			printf(" <%"PRIu64"s:%"PRIu64, limit / 1000000,
+			       hist[i]);
+	}
+	if (buf->lock_hist_cnt)
+		printf(" more:%"PRIu64, hist[i]);
+	printf("\n");
+}
+
+static void _print_lock_stats(void)
+{
+	uint64_t ave_wait, ave_hold;
+	int i;
+
+	if (!buf->lock_stats_cnt)
+		return;
+
+	printf("\nSlurmctld lock statistics (microseconds)\n");
+	for (i = 0; i < buf->lock_stats_cnt; i++) {
+		if (!buf->lock_count[i])
+			continue;
+		ave_wait = buf->lock_wait_sum[i] / buf->lock_count[i];
+		ave_hold = buf->lock_hold_sum[i] / buf->lock_count[i];
+		printf("\t%-12s count:%-8"PRIu64" ave_wait:%-6"PRIu64
+		       " max_wait:%-8"PRIu64" ave_hold:%-6"PRIu64
+		       " max_hold:%"PRIu64"\n",
+		       buf->lock_name[i], buf->lock_count[i], ave_wait,
+		       buf->lock_wait_max[i], ave_hold, buf->lock_hold_max[i]);
+		_print_lock_hist("wait",
+				 &buf->lock_wait_hist[i * buf->lock_hist_cnt]);
+		_print_lock_hist("hold",
+				 &buf->lock_hold_hist[i * buf->lock_hist_cnt]);
+	}
+
+	printf("\nSlurmctld lock holders by total hold time (microseconds)\n");
+	for (i = 0; i < buf->lock_holder_cnt; i++) {
+		printf("\t%-36s %-32s count:%-8"PRIu64" ave_hold:%-6"PRIu64
+		       " max_hold:%-8"PRIu64" total_hold:%"PRIu64"\n",
+		       buf->lock_holder_caller[i] ?
+		       buf->lock_holder_caller[i] : "unknown",
+		       buf->lock_holder_rpc_type[i] ?
+		       rpc_num2string(buf->lock_holder_rpc_type[i]) : "-",
+		       buf->lock_holder_count[i],
+		       buf->lock_holder_hold_sum[i] /
+		       MAX(buf->lock_holder_count[i], 1),
+		       buf->lock_holder_hold_max[i],
+		       buf->lock_holder_hold_sum[i]);
+	}
+}
+
+static void _print_rpc_queue_stats(void)
+{
+	int i;
+
+	if (!buf->rpcq_cnt)
+		return;
+
+	printf("\nSlurmctld RPC queue statistics (microseconds)\n");
+	for (i = 0; i < buf->rpcq_cnt; i++) {
+		printf("\t%-40s depth:%-6u max_depth:%-6u count:%-8u"
+		       " batches:%-8u ave_batch:%-4u max_batch:%-6u"
+		       " ave_wait:%-8"PRIu64" max_wait:%"PRIu64"\n",
+		       rpc_num2string(buf->rpcq_type_id[i]),
+		       buf->rpcq_depth[i], buf->rpcq_depth_max[i],
+		       buf->rpcq_msg_cnt[i], buf->rpcq_batch_cnt[i],
+		       buf->rpcq_msg_cnt[i] / MAX(buf->rpcq_batch_cnt[i], 1),
+		       buf->rpcq_batch_max[i],
+		       buf->rpcq_wait_sum[i] / MAX(buf->rpcq_msg_cnt[i], 1),
+		       buf->rpcq_wait_max[i]);
+	}
+}
+
+static void _print_fed_sib_stats(void)
+{
+	int i;
+
+	if (!buf->fed_sib_cnt)
+		return;
+
+	printf("\nFederation sibling RPC statistics (microseconds)\n");
+	for (i = 0; i < buf->fed_sib_cnt; i++) {
+		printf("\t%-20s queued:%-6u count:%-8u messages:%-8u"
+		       " ave_batch:%-4u max_batch:%-4u failed:%-6u"
+		       " ave_lag:%-8"PRIu64" max_lag:%-8"PRIu64
+		       " current_lag:%"PRIu64"\n",
+		       buf->fed_sib_name[i], buf->fed_sib_depth[i],
+		       buf->fed_sib_msg_cnt[i], buf->fed_sib_batch_cnt[i],
+		       buf->fed_sib_msg_cnt[i] /
+		       MAX(buf->fed_sib_batch_cnt[i], 1),
+		       buf->fed_sib_batch_max[i], buf->fed_sib_fail_cnt[i],
+		       buf->fed_sib_lag_sum[i] /
+		       MAX(buf->fed_sib_msg_cnt[i], 1),
+		       buf->fed_sib_lag_max[i], buf->fed_sib_lag_now[i]);
+	}
+}
+
 static void _sort_rpc(void)
 {
 	int i, j;
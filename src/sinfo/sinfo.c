@@ -370,8 +370,9 @@ static List _query_server(bool clear_old)
 							    params.nodes,
 							    show_flags);
 		} else {
-			error_code = slurm_load_node(old_node_ptr->last_update,
-						     &new_node_ptr, show_flags);
+			error_code = slurm_load_node_delta(old_node_ptr,
+							   &new_node_ptr,
+							   show_flags);
 		}
 		if (error_code == SLURM_SUCCESS)
 			slurm_free_node_info_msg(old_node_ptr);
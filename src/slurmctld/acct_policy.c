@@ -43,6 +43,7 @@
 
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/acct_policy.h"
+#include "src/slurmctld/sched_trace.h"
 #include "src/common/node_select.h"
 #include "src/common/slurm_priority.h"
 
@@ -3453,8 +3454,8 @@ extern bool acct_policy_job_runnable_state(job_record_t *job_ptr)
  *	association limits prevent the job from ever running (lowered
  *	limits since job submission), then cancel the job.
  */
-extern bool acct_policy_job_runnable_pre_select(job_record_t *job_ptr,
-						bool assoc_mgr_locked)
+static bool _job_runnable_pre_select(job_record_t *job_ptr,
+				     bool assoc_mgr_locked)
 {
 	slurmdb_qos_rec_t *qos_ptr_1, *qos_ptr_2;
 	slurmdb_qos_rec_t qos_rec;
@@ -3679,13 +3680,26 @@ end_it:
 	return rc;
 }
 
+/* Time accounting policy checks of the scheduling attempt in progress */
+extern bool acct_policy_job_runnable_pre_select(job_record_t *job_ptr,
+						bool assoc_mgr_locked)
+{
+	uint64_t start = sched_trace_phase_start();
+	bool rc;
+
+	rc = _job_runnable_pre_select(job_ptr, assoc_mgr_locked);
+	sched_trace_phase_end(SCHED_TRACE_ACCT, start);
+
+	return rc;
+}
+
 /*
  * acct_policy_job_runnable_post_select - After nodes have been
  *	selected for the job verify the counts don't exceed aggregated limits.
  */
-extern bool acct_policy_job_runnable_post_select(job_record_t *job_ptr,
-						 uint64_t *tres_req_cnt,
-						 bool assoc_mgr_locked)
+static bool _job_runnable_post_select(job_record_t *job_ptr,
+				      uint64_t *tres_req_cnt,
+				      bool assoc_mgr_locked)
 {
 	slurmdb_qos_rec_t *qos_ptr_1, *qos_ptr_2;
 	slurmdb_qos_rec_t qos_rec;
@@ -4065,6 +4079,21 @@ end_it:
 	return rc;
 }
 
+/* Time accounting policy checks of the scheduling attempt in progress */
+extern bool acct_policy_job_runnable_post_select(job_record_t *job_ptr,
+						 uint64_t *tres_req_cnt,
+						 bool assoc_mgr_locked)
+{
+	uint64_t start = sched_trace_phase_start();
+	bool rc;
+
+	rc = _job_runnable_post_select(job_ptr, tres_req_cnt,
+				       assoc_mgr_locked);
+	sched_trace_phase_end(SCHED_TRACE_ACCT, start);
+
+	return rc;
+}
+
 extern uint32_t acct_policy_get_max_nodes(job_record_t *job_ptr,
 					  uint32_t *wait_reason)
 {
@@ -4488,6 +4517,16 @@ extern int acct_policy_handle_accrue_time(job_record_t *job_ptr,
 		return SLURM_ERROR;
 	}
 
+	/*
+	 * A pending job that is already accruing has nothing to update
+	 * unless it is an array that may split off more accruing tasks.
+	 * This is the common case on every scheduling pass, so avoid taking
+	 * the assoc and QOS write locks for it.
+	 */
+	if (details_ptr->accrue_time && IS_JOB_PENDING(job_ptr) &&
+	    (!job_ptr->array_recs || !job_ptr->array_recs->task_cnt))
+		return SLURM_SUCCESS;
+
 	if (!assoc_mgr_locked)
 		assoc_mgr_lock(&locks);
 
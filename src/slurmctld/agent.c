@@ -86,10 +86,14 @@
 #include "src/common/macros.h"
 #include "src/common/node_select.h"
 #include "src/common/parse_time.h"
+#include "src/common/probes.h"
 #include "src/common/run_command.h"
+#include "src/common/slurm_route.h"
 #include "src/common/slurm_protocol_api.h"
 #include "src/common/slurm_protocol_interface.h"
+#include "src/common/slurm_protocol_pack.h"
 #include "src/common/uid.h"
+#include "src/common/xhash.h"
 #include "src/common/xsignal.h"
 #include "src/common/xassert.h"
 #include "src/common/xmalloc.h"
@@ -171,6 +175,8 @@ typedef struct queued_request {
 	time_t       first_attempt;	/* Time of first check for batch
 					 * launch RPC *only* */
 	time_t       last_attempt;	/* Time of last xmit attempt */
+	buf_t       *msg_buf;		/* packed msg_args, used to find
+					 * duplicate requests to merge */
 } queued_request_t;
 
 typedef struct mail_info {
@@ -186,17 +192,21 @@ static void _reboot_from_ctld(agent_arg_t *agent_arg_ptr);
 static int  _signal_defer(queued_request_t *queued_req_ptr);
 static inline int _comm_err(char *node_name, slurm_msg_type_t msg_type);
 static void _list_delete_retry(void *retry_entry);
+static void _retry_list_add(queued_request_t *queued_req_ptr);
+static int  _agent_thread_cnt(agent_arg_t *agent_arg_ptr);
 static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr);
 static task_info_t *_make_task_data(agent_info_t *agent_info_ptr, int inx);
 static void _notify_slurmctld_jobs(agent_info_t *agent_ptr);
 static void _notify_slurmctld_nodes(agent_info_t *agent_ptr,
 		int no_resp_cnt, int retry_cnt);
 static void _purge_agent_args(agent_arg_t *agent_arg_ptr);
+static void _record_node_load(List ret_list);
 static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count);
 static int  _setup_requeue(agent_arg_t *agent_arg_ptr, thd_t *thread_ptr,
 			   int *count, int *spot);
 static void _sig_handler(int dummy);
 static void *_thread_per_group_rpc(void *args);
+static bool  _use_msg_tree(slurm_msg_type_t msg_type);
 static int   _valid_agent_arg(agent_arg_t *agent_arg_ptr);
 static void *_wdog(void *args);
 
@@ -213,6 +223,11 @@ static List defer_list = NULL;		/* agent_arg_t list for requests
 					 * requiring job write lock */
 static List mail_list = NULL;		/* pending e-mail requests */
 static List retry_list = NULL;		/* agent_arg_t list for retry */
+static xhash_t *retry_hash = NULL;	/* mergeable retry_list entries keyed
+					 * by their msg_buf */
+static uint32_t retry_merge_cnt = 0;	/* requests merged into others on
+					 * retry_list, protected by
+					 * retry_mutex */
 
 
 static pthread_mutex_t agent_cnt_mutex = PTHREAD_MUTEX_INITIALIZER;
@@ -270,6 +285,8 @@ void *agent(void *args)
 		 rpc_num2string(agent_arg_ptr->msg_type),
 		 retry_list_size());
 
+	rpc_thread_cnt = _agent_thread_cnt(agent_arg_ptr);
+
 	slurm_mutex_lock(&agent_cnt_mutex);
 
 	if (sched_update != slurm_conf.last_update) {
@@ -284,7 +301,6 @@ void *agent(void *args)
 		sched_update = slurm_conf.last_update;
 	}
 
-	rpc_thread_cnt = 2 + MIN(agent_arg_ptr->node_count, AGENT_THREAD_COUNT);
 	while (1) {
 		if (slurmctld_config.shutdown_time ||
 		    ((agent_thread_cnt+rpc_thread_cnt) <= MAX_SERVER_THREADS)) {
@@ -423,6 +439,64 @@ static int _valid_agent_arg(agent_arg_t *agent_arg_ptr)
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Return true if a message of this type is sent to possibly many slurmd
+ * and a reply is wanted, in which case message forwarding is used
+ */
+static bool _use_msg_tree(slurm_msg_type_t msg_type)
+{
+	if ((msg_type != REQUEST_JOB_NOTIFY)		&&
+	    (msg_type != REQUEST_REBOOT_NODES)		&&
+	    (msg_type != REQUEST_RECONFIGURE)		&&
+	    (msg_type != REQUEST_RECONFIGURE_WITH_CONFIG) &&
+	    (msg_type != REQUEST_SHUTDOWN)		&&
+	    (msg_type != SRUN_EXEC)			&&
+	    (msg_type != SRUN_TIMEOUT)			&&
+	    (msg_type != SRUN_NODE_FAIL)		&&
+	    (msg_type != SRUN_REQUEST_SUSPEND)		&&
+	    (msg_type != SRUN_USER_MSG)			&&
+	    (msg_type != SRUN_STEP_MISSING)		&&
+	    (msg_type != SRUN_STEP_SIGNAL)		&&
+	    (msg_type != SRUN_JOB_COMPLETE))
+		return true;
+
+	return false;
+}
+
+/*
+ * Return the count of threads an agent will use: the agent and its
+ * watchdog, plus the RPC threads. A message sent through the forwarding
+ * tree uses a single RPC thread here, but start_msg_tree() starts a thread
+ * for each hostlist the route plugin splits the nodes into. Split a copy
+ * of the hostlist the same way to count those too, so that
+ * MAX_SERVER_THREADS really bounds the threads used for large fanouts.
+ */
+static int _agent_thread_cnt(agent_arg_t *agent_arg_ptr)
+{
+	int node_cnt = agent_arg_ptr->node_count;
+
+#ifndef HAVE_FRONT_END
+	if (!agent_arg_ptr->addr && agent_arg_ptr->hostlist &&
+	    _use_msg_tree(agent_arg_ptr->msg_type)) {
+		hostlist_t hl = hostlist_copy(agent_arg_ptr->hostlist);
+		hostlist_t *sp_hl = NULL;
+		int hl_count = 0;
+
+		hostlist_uniq(hl);
+		if (route_g_split_hostlist(hl, &sp_hl, &hl_count,
+					   slurm_conf.tree_width))
+			hl_count = MIN(node_cnt, slurm_conf.tree_width);
+		for (int i = 0; sp_hl && (i < hl_count); i++)
+			hostlist_destroy(sp_hl[i]);
+		xfree(sp_hl);
+		hostlist_destroy(hl);
+
+		return MIN(2 + 1 + hl_count, MAX_SERVER_THREADS);
+	}
+#endif
+	return 2 + MIN(node_cnt, AGENT_THREAD_COUNT);
+}
+
 static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
 {
 	int i = 0, j = 0;
@@ -446,19 +520,7 @@ static agent_info_t *_make_agent_info(agent_arg_t *agent_arg_ptr)
 	agent_info_ptr->msg_args_pptr  = &agent_arg_ptr->msg_args;
 	agent_info_ptr->protocol_version = agent_arg_ptr->protocol_version;
 
-	if ((agent_arg_ptr->msg_type != REQUEST_JOB_NOTIFY)	&&
-	    (agent_arg_ptr->msg_type != REQUEST_REBOOT_NODES)	&&
-	    (agent_arg_ptr->msg_type != REQUEST_RECONFIGURE)	&&
-	    (agent_arg_ptr->msg_type != REQUEST_RECONFIGURE_WITH_CONFIG) &&
-	    (agent_arg_ptr->msg_type != REQUEST_SHUTDOWN)	&&
-	    (agent_arg_ptr->msg_type != SRUN_EXEC)		&&
-	    (agent_arg_ptr->msg_type != SRUN_TIMEOUT)		&&
-	    (agent_arg_ptr->msg_type != SRUN_NODE_FAIL)		&&
-	    (agent_arg_ptr->msg_type != SRUN_REQUEST_SUSPEND)	&&
-	    (agent_arg_ptr->msg_type != SRUN_USER_MSG)		&&
-	    (agent_arg_ptr->msg_type != SRUN_STEP_MISSING)	&&
-	    (agent_arg_ptr->msg_type != SRUN_STEP_SIGNAL)	&&
-	    (agent_arg_ptr->msg_type != SRUN_JOB_COMPLETE)) {
+	if (_use_msg_tree(agent_arg_ptr->msg_type)) {
 #ifdef HAVE_FRONT_END
 		span = set_span(agent_arg_ptr->node_count,
 				agent_arg_ptr->node_count);
@@ -832,6 +894,47 @@ static inline int _comm_err(char *node_name, slurm_msg_type_t msg_type)
 	return rc;
 }
 
+/*
+ * Record the CPU load, free memory and energy data reported in the responses
+ * of a ret_list. A message sent through the tree returns one response per
+ * node, so take the node write lock once for the whole list rather than once
+ * per node.
+ */
+static void _record_node_load(List ret_list)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	bool locked = false;
+	/* Lock: Write node */
+	slurmctld_lock_t node_write_lock = {
+		NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
+
+	itr = list_iterator_create(ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if ((ret_data_info->type != RESPONSE_PING_SLURMD) &&
+		    (ret_data_info->type != RESPONSE_ACCT_GATHER_UPDATE))
+			continue;
+		if (!locked) {
+			lock_slurmctld(node_write_lock);
+			locked = true;
+		}
+		if (ret_data_info->type == RESPONSE_PING_SLURMD) {
+			ping_slurmd_resp_msg_t *ping_resp =
+				ret_data_info->data;
+			reset_node_load(ret_data_info->node_name,
+					ping_resp->cpu_load);
+			reset_node_free_mem(ret_data_info->node_name,
+					    ping_resp->free_mem);
+		} else {
+			update_node_record_acct_gather_data(
+				ret_data_info->data);
+		}
+	}
+	list_iterator_destroy(itr);
+	if (locked)
+		unlock_slurmctld(node_write_lock);
+}
+
 /* return a value for which WEXITSTATUS() returns 1 */
 static int _wif_status(void)
 {
@@ -885,9 +988,6 @@ static void *_thread_per_group_rpc(void *args)
 	/* Lock: Read node */
 	slurmctld_lock_t node_read_lock = {
 		NO_LOCK, NO_LOCK, READ_LOCK, NO_LOCK, NO_LOCK };
-	/* Lock: Write node */
-	slurmctld_lock_t node_write_lock = {
-		NO_LOCK, NO_LOCK, WRITE_LOCK, NO_LOCK, NO_LOCK };
 	uint32_t job_id;
 
 	xassert(args != NULL);
@@ -924,6 +1024,7 @@ static void *_thread_per_group_rpc(void *args)
 
 	log_flag(AGENT, "%s: sending %s to %s",
 		 __func__, rpc_num2string(msg_type), thread_ptr->nodelist);
+	SLURM_PROBE2(agent__send, msg_type, thread_ptr->nodelist);
 
 	if (task_ptr->get_reply) {
 		if (thread_ptr->addr) {
@@ -984,22 +1085,12 @@ static void *_thread_per_group_rpc(void *args)
 	}
 
 	//info("got %d messages back", list_count(ret_list));
+	_record_node_load(ret_list);
+
 	itr = list_iterator_create(ret_list);
 	while ((ret_data_info = list_next(itr))) {
 		rc = slurm_get_return_code(ret_data_info->type,
 					   ret_data_info->data);
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_PING_SLURMD) {
-			ping_slurmd_resp_msg_t *ping_resp;
-			ping_resp = (ping_slurmd_resp_msg_t *)
-				    ret_data_info->data;
-			lock_slurmctld(node_write_lock);
-			reset_node_load(ret_data_info->node_name,
-					ping_resp->cpu_load);
-			reset_node_free_mem(ret_data_info->node_name,
-					    ping_resp->free_mem);
-			unlock_slurmctld(node_write_lock);
-		}
 		/* SPECIAL CASE: Mark node as IDLE if job already complete */
 		if (is_kill_msg &&
 		    (rc == ESLURMD_KILL_JOB_ALREADY_COMPLETE)) {
@@ -1014,14 +1105,6 @@ static void *_thread_per_group_rpc(void *args)
 			unlock_slurmctld(job_write_lock);
 		}
 
-		/* SPECIAL CASE: Record node's CPU load */
-		if (ret_data_info->type == RESPONSE_ACCT_GATHER_UPDATE) {
-			lock_slurmctld(node_write_lock);
-			update_node_record_acct_gather_data(
-				ret_data_info->data);
-			unlock_slurmctld(node_write_lock);
-		}
-
 		/* SPECIAL CASE: Requeue/hold non-startable batch job,
 		 * Requeue job prolog failure or duplicate job ID */
 		if ((msg_type == REQUEST_BATCH_JOB_LAUNCH) &&
@@ -1194,6 +1277,7 @@ cleanup:
 			unlock_slurmctld(job_write_lock);
 		}
 	}
+	SLURM_PROBE3(agent__done, msg_type, thread_ptr->nodelist, thread_state);
 	/* handled at end of thread just in case resend is needed */
 	destroy_forward(&msg.forward);
 	slurm_mutex_lock(thread_mutex_ptr);
@@ -1280,6 +1364,7 @@ static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count)
 
 	if (count == 0)
 		return;
+	SLURM_PROBE2(agent__retry, agent_info_ptr->msg_type, count);
 
 	/* build agent argument with just the RPCs to retry */
 	agent_arg_ptr = xmalloc(sizeof(agent_arg_t));
@@ -1344,9 +1429,7 @@ static void _queue_agent_retry(agent_info_t * agent_info_ptr, int count)
 	queued_req_ptr->agent_arg_ptr = agent_arg_ptr;
 	queued_req_ptr->last_attempt  = time(NULL);
 	slurm_mutex_lock(&retry_mutex);
-	if (retry_list == NULL)
-		retry_list = list_create(_list_delete_retry);
-	(void) list_append(retry_list, (void *) queued_req_ptr);
+	_retry_list_add(queued_req_ptr);
 	slurm_mutex_unlock(&retry_mutex);
 }
 
@@ -1363,9 +1446,112 @@ static void _list_delete_retry(void *retry_entry)
 
 	queued_req_ptr = (queued_request_t *) retry_entry;
 	_purge_agent_args(queued_req_ptr->agent_arg_ptr);
+	FREE_NULL_BUFFER(queued_req_ptr->msg_buf);
 	xfree(queued_req_ptr);
 }
 
+/* Key a mergeable queued request on its packed msg_buf */
+static void _retry_hash_id(void *item, const char **key, uint32_t *key_len)
+{
+	queued_request_t *queued_req_ptr = item;
+
+	*key = get_buf_data(queued_req_ptr->msg_buf);
+	*key_len = get_buf_offset(queued_req_ptr->msg_buf);
+}
+
+/*
+ * Remove a request taken off retry_list from retry_hash
+ * NOTE: Call with retry_mutex locked
+ */
+static void _retry_hash_remove(queued_request_t *queued_req_ptr)
+{
+	if (!retry_hash || !queued_req_ptr->msg_buf)
+		return;
+
+	(void) xhash_pop(retry_hash, get_buf_data(queued_req_ptr->msg_buf),
+			 get_buf_offset(queued_req_ptr->msg_buf));
+}
+
+/* Return true if requests of this type to different nodes can be merged */
+static bool _mergeable_msg_type(slurm_msg_type_t msg_type)
+{
+	switch (msg_type) {
+	case REQUEST_ABORT_JOB:
+	case REQUEST_ACCT_GATHER_UPDATE:
+	case REQUEST_HEALTH_CHECK:
+	case REQUEST_KILL_PREEMPTED:
+	case REQUEST_KILL_TIMELIMIT:
+	case REQUEST_NODE_REGISTRATION_STATUS:
+	case REQUEST_PING:
+	case REQUEST_TERMINATE_JOB:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Add a request to retry_list. A request for the same RPC with the same
+ * payload as one already queued (and in the same never tried or retry
+ * state) is merged into it by adding its nodes to the queued request's
+ * hostlist, so that one agent serves both. The RPC, its retry state and
+ * payload are packed into msg_buf, which keys retry_hash.
+ * NOTE: Call with retry_mutex locked
+ */
+static void _retry_list_add(queued_request_t *queued_req_ptr)
+{
+	agent_arg_t *agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
+	queued_request_t *merge_req_ptr;
+	slurm_msg_t msg;
+
+	if (retry_list == NULL)
+		retry_list = list_create(_list_delete_retry);
+	if (retry_hash == NULL)
+		retry_hash = xhash_init(_retry_hash_id, NULL);
+
+	if (agent_arg_ptr->addr || !agent_arg_ptr->hostlist ||
+	    !_mergeable_msg_type(agent_arg_ptr->msg_type)) {
+		list_append(retry_list, queued_req_ptr);
+		return;
+	}
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = agent_arg_ptr->msg_type;
+	msg.data = agent_arg_ptr->msg_args;
+	if (agent_arg_ptr->protocol_version)
+		msg.protocol_version = agent_arg_ptr->protocol_version;
+	queued_req_ptr->msg_buf = init_buf(BUF_SIZE);
+	pack32(agent_arg_ptr->msg_type, queued_req_ptr->msg_buf);
+	pack16(agent_arg_ptr->protocol_version, queued_req_ptr->msg_buf);
+	pack16(agent_arg_ptr->retry, queued_req_ptr->msg_buf);
+	pack8(queued_req_ptr->last_attempt ? 1 : 0, queued_req_ptr->msg_buf);
+	if (pack_msg(&msg, queued_req_ptr->msg_buf) != SLURM_SUCCESS) {
+		FREE_NULL_BUFFER(queued_req_ptr->msg_buf);
+		list_append(retry_list, queued_req_ptr);
+		return;
+	}
+
+	if (!(merge_req_ptr = xhash_get(
+		      retry_hash, get_buf_data(queued_req_ptr->msg_buf),
+		      get_buf_offset(queued_req_ptr->msg_buf)))) {
+		xhash_add(retry_hash, queued_req_ptr);
+		list_append(retry_list, queued_req_ptr);
+		return;
+	}
+
+	hostlist_push_list(merge_req_ptr->agent_arg_ptr->hostlist,
+			   agent_arg_ptr->hostlist);
+	hostlist_uniq(merge_req_ptr->agent_arg_ptr->hostlist);
+	merge_req_ptr->agent_arg_ptr->node_count =
+		hostlist_count(merge_req_ptr->agent_arg_ptr->hostlist);
+	log_flag(AGENT, "%s: merged %s request into one for %u nodes",
+		 __func__, rpc_num2string(agent_arg_ptr->msg_type),
+		 merge_req_ptr->agent_arg_ptr->node_count);
+	retry_merge_cnt++;
+	_list_delete_retry(queued_req_ptr);
+}
+
+
 /* Start a thread to manage queued agent requests */
 static void *_agent_init(void *arg)
 {
@@ -1626,6 +1812,7 @@ static void _agent_retry(int min_wait, bool mail_too)
 		while ((queued_req_ptr = list_next(retry_iter))) {
  			if (queued_req_ptr->last_attempt == 0) {
 				list_remove(retry_iter);
+				_retry_hash_remove(queued_req_ptr);
 				break;		/* Process this request now */
 			}
 		}
@@ -1643,6 +1830,7 @@ static void _agent_retry(int min_wait, bool mail_too)
 			age = difftime(now, queued_req_ptr->last_attempt);
 			if (age > min_wait) {
 				list_remove(retry_iter);
+				_retry_hash_remove(queued_req_ptr);
 				break;
 			}
 		}
@@ -1652,6 +1840,7 @@ static void _agent_retry(int min_wait, bool mail_too)
 
 	if (queued_req_ptr) {
 		agent_arg_ptr = queued_req_ptr->agent_arg_ptr;
+		FREE_NULL_BUFFER(queued_req_ptr->msg_buf);
 		xfree(queued_req_ptr);
 		if (agent_arg_ptr) {
 			debug2("Spawning RPC agent for msg_type %s",
@@ -1718,9 +1907,7 @@ void agent_queue_request(agent_arg_t *agent_arg_ptr)
 		slurm_mutex_unlock(&defer_mutex);
 	} else {
 		slurm_mutex_lock(&retry_mutex);
-		if (retry_list == NULL)
-			retry_list = list_create(_list_delete_retry);
-		list_append(retry_list, (void *)queued_req_ptr);
+		_retry_list_add(queued_req_ptr);
 		slurm_mutex_unlock(&retry_mutex);
 	}
 	/* now process the request in a separate pthread
@@ -1735,6 +1922,7 @@ extern void agent_purge(void)
 
 	if (retry_list) {
 		slurm_mutex_lock(&retry_mutex);
+		xhash_free(retry_hash);
 		FREE_NULL_LIST(retry_list);
 		slurm_mutex_unlock(&retry_mutex);
 	}
@@ -2271,6 +2459,18 @@ extern int retry_list_size(void)
 	return list_count(retry_list);
 }
 
+/* Return count of requests merged into others on the retry_list */
+extern uint32_t retry_list_merge_count(void)
+{
+	uint32_t cnt;
+
+	slurm_mutex_lock(&retry_mutex);
+	cnt = retry_merge_cnt;
+	slurm_mutex_unlock(&retry_mutex);
+
+	return cnt;
+}
+
 static void _reboot_from_ctld(agent_arg_t *agent_arg_ptr)
 {
 	char *argv[3], *pname;
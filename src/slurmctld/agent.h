@@ -114,4 +114,7 @@ extern void mail_job_info(job_record_t *job_ptr, uint16_t mail_type);
 /* Return length of agent's retry_list */
 extern int retry_list_size(void);
 
+/* Return count of requests merged into others on agent's retry_list */
+extern uint32_t retry_list_merge_count(void);
+
 #endif /* !_AGENT_H */
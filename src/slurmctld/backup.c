@@ -39,7 +39,9 @@
 
 #include "config.h"
 
+#include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdio.h>
@@ -47,6 +49,7 @@
 #include <string.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
+#include <unistd.h>
 
 #include "slurm/slurm_errno.h"
 
@@ -69,11 +72,13 @@
 
 #define _DEBUG		0
 #define SHUTDOWN_WAIT	2	/* Time to wait for primary server shutdown */
+#define PREFETCH_BUF_SIZE (1024 * 1024)	/* read size for state prefetch */
 
 static int          _background_process_msg(slurm_msg_t * msg);
 static void *       _background_rpc_mgr(void *no_data);
 static void *       _background_signal_hand(void *no_data);
 static void         _backup_reconfig(void);
+static void         _prefetch_state_files(time_t *last_prefetch);
 static int          _shutdown_primary_controller(int wait_time);
 static void *       _trigger_slurmctld_event(void *arg);
 inline static void  _update_cred_key(void);
@@ -119,7 +124,7 @@ static int backup_sigarray[] = {
 void run_backup(void)
 {
 	int i;
-	time_t last_ping = 0;
+	time_t last_ping = 0, last_prefetch = 0;
 	slurmctld_lock_t config_read_lock = {
 		READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
 	slurmctld_lock_t config_write_lock = {
@@ -168,9 +173,10 @@ void run_backup(void)
 			continue;
 
 		last_ping = time(NULL);
-		if (ping_controllers(false) == SLURM_SUCCESS)
+		if (ping_controllers(false) == SLURM_SUCCESS) {
 			last_controller_response = time(NULL);
-		else if (takeover) {
+			_prefetch_state_files(&last_prefetch);
+		} else if (takeover) {
 			/*
 			 * in takeover mode, take control as soon as
 			 * primary no longer respond
@@ -265,6 +271,71 @@ void run_backup(void)
 	return;
 }
 
+/*
+ * With SlurmctldParameters=standby_state_prefetch, read every state file in
+ * StateSaveLocation changed since the last pass so that the state recovered
+ * on takeover is read from the page cache rather than from (typically slow,
+ * shared) storage. Batch job directories are read on demand and skipped.
+ * IN/OUT last_prefetch - start time of the previous pass
+ */
+static void _prefetch_state_files(time_t *last_prefetch)
+{
+	DIR *f_dir;
+	struct dirent *dir_ent;
+	struct stat stat_buf;
+	char *file_name = NULL, *buf;
+	time_t start = time(NULL);
+	int fd, file_cnt = 0;
+	ssize_t amount;
+	uint64_t bytes = 0;
+	DEF_TIMERS;
+
+	/* Lock of slurm_conf not important, as in run_backup() */
+	if (!xstrcasestr(slurm_conf.slurmctld_params, "standby_state_prefetch"))
+		return;
+
+	if (!(f_dir = opendir(slurm_conf.state_save_location))) {
+		debug("%s: opendir(%s): %m",
+		      __func__, slurm_conf.state_save_location);
+		return;
+	}
+
+	START_TIMER;
+	buf = xmalloc(PREFETCH_BUF_SIZE);
+	while ((dir_ent = readdir(f_dir)) &&
+	       !slurmctld_config.shutdown_time && !takeover) {
+		if (dir_ent->d_name[0] == '.')
+			continue;
+		xfree(file_name);
+		file_name = xstrdup_printf("%s/%s",
+					   slurm_conf.state_save_location,
+					   dir_ent->d_name);
+		/* Files older than the last pass are already cached */
+		if (stat(file_name, &stat_buf) ||
+		    !S_ISREG(stat_buf.st_mode) ||
+		    (stat_buf.st_mtime < *last_prefetch))
+			continue;
+		if ((fd = open(file_name, O_RDONLY | O_CLOEXEC)) < 0)
+			continue;
+		while (((amount = read(fd, buf, PREFETCH_BUF_SIZE)) > 0) ||
+		       ((amount < 0) && (errno == EINTR))) {
+			if (amount > 0)
+				bytes += amount;
+		}
+		close(fd);
+		file_cnt++;
+	}
+	xfree(file_name);
+	xfree(buf);
+	closedir(f_dir);
+	END_TIMER;
+
+	*last_prefetch = start;
+	if (file_cnt)
+		debug2("%s: read %d files, %"PRIu64" bytes %s",
+		       __func__, file_cnt, bytes, TIME_STR);
+}
+
 /*
  * _background_signal_hand - Process daemon-wide signals for the
  *	backup controller
@@ -61,6 +61,7 @@
 #include "src/common/assoc_mgr.h"
 #include "src/common/daemonize.h"
 #include "src/common/fd.h"
+#include "src/common/forward.h"
 #include "src/common/gres.h"
 #include "src/common/group_cache.h"
 #include "src/common/hostlist.h"
@@ -71,6 +72,7 @@
 #include "src/common/pack.h"
 #include "src/common/power.h"
 #include "src/common/prep.h"
+#include "src/common/probes.h"
 #include "src/common/proc_args.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_acct_gather_profile.h"
@@ -97,6 +99,7 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
@@ -112,6 +115,7 @@
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_capture.h"
 #include "src/slurmctld/rpc_queue.h"
 #include "src/slurmctld/sched_plugin.h"
 #include "src/slurmctld/slurmctld.h"
@@ -131,6 +135,12 @@
 				 * check-in before we ping them */
 #define SHUTDOWN_WAIT     2	/* Time to wait for backup server shutdown */
 #define JOB_COUNT_INTERVAL 30   /* Time to update running job count */
+#define CTLD_CONN_IDLE_TIMEOUT 5000 /* Time in msec to wait for another
+				     * request on a kept alive connection */
+#define CTLD_MAX_IDLE_CONNS 256	/* Max kept alive connections waiting
+				 * for their next request */
+#define RPC_WORKER_IDLE_TIMEOUT 60 /* Seconds an idle RPC worker thread
+				    * waits for a connection before exiting */
 
 /**************************************************************************\
  * To test for memory leaks, set MEMORY_LEAK_DEBUG to 1 using
@@ -204,6 +214,28 @@ static char *	debug_logfile = NULL;
 static bool	dump_core = false;
 static int      job_sched_cnt = 0;
 static uint32_t max_server_threads = MAX_SERVER_THREADS;
+
+/* Kept alive connections, owned by the RPC manager until readable */
+typedef struct {
+	int fd;
+	time_t idle_since;
+} idle_conn_t;
+static idle_conn_t idle_conns[CTLD_MAX_IDLE_CONNS];
+static int idle_conn_cnt = 0;
+static pthread_mutex_t idle_conn_lock = PTHREAD_MUTEX_INITIALIZER;
+static int rpc_wake_fd[2] = { -1, -1 };
+
+/* A connection with a request to be serviced */
+typedef struct {
+	int fd;
+	struct timeval start;	/* when accepted, or became readable again */
+} rpc_conn_t;
+
+/* Connections waiting for an idle RPC worker thread */
+static List rpc_worker_fds = NULL;
+static int rpc_worker_idle = 0;
+static pthread_mutex_t rpc_worker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t rpc_worker_cond = PTHREAD_COND_INITIALIZER;
 static time_t	next_stats_reset = 0;
 static int	new_nice = 0;
 static int	recover   = DEFAULT_RECOVER;
@@ -233,6 +265,10 @@ static void         _become_slurm_user(void);
 static void         _create_clustername_file(void);
 static void         _default_sigaction(int sig);
 static void         _get_fed_updates();
+static void         _idle_conn_fini(void);
+static int          _idle_conn_poll_setup(struct pollfd **fds, int *fds_size,
+					  int offset);
+static void         _idle_conn_remove(int fd);
 static void         _init_config(void);
 static void         _init_pidfile(void);
 static int          _init_tres(void);
@@ -241,6 +277,7 @@ static void         _parse_commandline(int argc, char **argv);
 static void *       _purge_files_thread(void *no_data);
 static void         _remove_assoc(slurmdb_assoc_rec_t *rec);
 static void         _remove_qos(slurmdb_qos_rec_t *rec);
+static void         _rpc_dispatch(rpc_conn_t *conn);
 static void         _run_primary_prog(bool primary_on);
 static void *       _service_connection(void *arg);
 static void         _set_work_dir(void);
@@ -886,6 +923,7 @@ int main(int argc, char **argv)
 	purge_front_end_state();
 	resv_fini();
 	trigger_fini();
+	event_mgr_fini();
 	assoc_mgr_fini(1);
 	reserve_port_config(NULL);
 
@@ -903,6 +941,7 @@ int main(int argc, char **argv)
 	slurm_auth_fini();
 	switch_fini();
 	route_fini();
+	forward_fini();
 
 	/* purge remaining data structures */
 	group_cache_purge();
@@ -1114,10 +1153,11 @@ static void _sig_handler(int signal)
  */
 static void *_slurmctld_rpc_mgr(void *no_data)
 {
-	int *newsockfd;
+	rpc_conn_t *newsockfd;
 	struct pollfd *fds;
 	slurm_addr_t cli_addr, srv_addr;
-	int fd_next = 0, i, nports;
+	int fd_next = 0, i, nports, nfds, fds_size, nidle;
+	char c;
 	/* Locks: Read config */
 	slurmctld_lock_t config_read_lock = {
 		READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
@@ -1140,7 +1180,9 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 		fatal("slurmctld port count is zero");
 		return NULL;	/* Fix CLANG false positive */
 	}
-	fds = xcalloc(nports, sizeof(struct pollfd));
+	/* listening ports, wake pipe, then any idle kept alive connections */
+	fds_size = nports + 1;
+	fds = xcalloc(fds_size, sizeof(struct pollfd));
 	for (i = 0; i < nports; i++) {
 		fds[i].fd = slurm_init_msg_engine_port(
 			slurm_conf.slurmctld_port + i);
@@ -1158,7 +1200,18 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	}
 	unlock_slurmctld(config_read_lock);
 
+	if (pipe(rpc_wake_fd) < 0)
+		fatal("%s: pipe: %m", __func__);
+	fd_set_nonblocking(rpc_wake_fd[0]);
+	fd_set_nonblocking(rpc_wake_fd[1]);
+	fd_set_close_on_exec(rpc_wake_fd[0]);
+	fd_set_close_on_exec(rpc_wake_fd[1]);
+	fds[nports].fd = rpc_wake_fd[0];
+	fds[nports].events = POLLIN;
+	rpc_worker_fds = list_create(NULL);
+
 	rpc_queue_init();
+	rpc_capture_init();
 
 	/*
 	 * Prepare to catch SIGUSR1 to interrupt accept().
@@ -1174,42 +1227,82 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	 * Process incoming RPCs until told to shutdown
 	 */
 	while (_wait_for_server_thread()) {
-		if (poll(fds, nports, -1) == -1) {
+		newsockfd = NULL;
+		nidle = _idle_conn_poll_setup(&fds, &fds_size, nports + 1);
+		nfds = nports + 1 + nidle;
+
+		/* wake up once a second to expire idle connections */
+		if (poll(fds, nfds, (nidle ? 1000 : -1)) == -1) {
 			if (errno != EINTR)
 				error("slurm_accept_msg_conn poll: %m");
 			server_thread_decr();
 			continue;
 		}
 
-		/* find one to process */
-		for (i = 0; i < nports; i++) {
-			if (fds[(fd_next + i) % nports].revents) {
-				i = (fd_next + i) % nports;
-				break;
-			}
+		if (fds[nports].revents) {
+			while (read(rpc_wake_fd[0], &c, 1) > 0)
+				;
 		}
-		fd_next = (i + 1) % nports;
 
-		newsockfd = xmalloc(sizeof(*newsockfd));
-		if ((*newsockfd = slurm_accept_msg_conn(fds[i].fd, &cli_addr))
-		    == SLURM_ERROR) {
-			if (errno != EINTR)
-				error("slurm_accept_msg_conn: %m");
-			server_thread_decr();
-			xfree(newsockfd);
-			continue;
+		/*
+		 * Prefer idle connections with a new request waiting, they
+		 * have already been accepted. One closed by its client reads
+		 * as zero bytes and is just dropped.
+		 */
+		for (i = nports + 1; i < nfds; i++) {
+			if (!fds[i].revents)
+				continue;
+			if (newsockfd && (fds[i].revents & POLLIN))
+				continue;
+			_idle_conn_remove(fds[i].fd);
+			if (!(fds[i].revents & POLLIN) ||
+			    (recv(fds[i].fd, &c, 1, MSG_PEEK | MSG_DONTWAIT)
+			     <= 0)) {
+				close(fds[i].fd);
+				continue;
+			}
+			newsockfd = xmalloc(sizeof(*newsockfd));
+			newsockfd->fd = fds[i].fd;
+			gettimeofday(&newsockfd->start, NULL);
 		}
-		fd_set_close_on_exec(*newsockfd);
 
-		log_flag(PROTOCOL, "%s: accept() connection from %pA",
-			 __func__, &cli_addr);
+		if (!newsockfd) {
+			/* find one to process */
+			for (i = 0; i < nports; i++) {
+				if (fds[(fd_next + i) % nports].revents) {
+					i = (fd_next + i) % nports;
+					break;
+				}
+			}
+			if (i >= nports) {
+				server_thread_decr();
+				continue;
+			}
+			fd_next = (i + 1) % nports;
+
+			newsockfd = xmalloc(sizeof(*newsockfd));
+			if ((newsockfd->fd = slurm_accept_msg_conn(fds[i].fd,
+								   &cli_addr))
+			    == SLURM_ERROR) {
+				if (errno != EINTR)
+					error("slurm_accept_msg_conn: %m");
+				server_thread_decr();
+				xfree(newsockfd);
+				continue;
+			}
+			fd_set_close_on_exec(newsockfd->fd);
+			gettimeofday(&newsockfd->start, NULL);
+			SLURM_PROBE1(rpc__accept, newsockfd->fd);
+
+			log_flag(PROTOCOL, "%s: accept() connection from %pA",
+				 __func__, &cli_addr);
+		}
 
 		if (slurmctld_config.shutdown_time) {
 			slurmctld_diag_stats.proc_req_raw++;
 			_service_connection(newsockfd);
 		} else {
-			slurm_thread_create_detached(NULL, _service_connection,
-						     newsockfd);
+			_rpc_dispatch(newsockfd);
 		}
 	}
 
@@ -1217,33 +1310,121 @@ static void *_slurmctld_rpc_mgr(void *no_data)
 	for (i = 0; i < nports; i++)
 		close(fds[i].fd);
 	xfree(fds);
+	_idle_conn_fini();
+
+	/* Let idle workers see the shutdown and exit */
+	slurm_mutex_lock(&rpc_worker_lock);
+	slurm_cond_broadcast(&rpc_worker_cond);
+	slurm_mutex_unlock(&rpc_worker_lock);
 
 	rpc_queue_shutdown();
+	rpc_capture_fini();
 
 	server_thread_decr();
 	pthread_exit((void *) 0);
 	return NULL;
 }
 
+/*
+ * Park a kept alive connection with the RPC manager until the client sends
+ * its next request, so that no thread is tied up while it is idle.
+ * RET true if the RPC manager now owns fd
+ */
+static bool _idle_conn_add(int fd)
+{
+	bool added = false;
+	char c = 0;
+
+	slurm_mutex_lock(&idle_conn_lock);
+	if (!slurmctld_config.shutdown_time &&
+	    (idle_conn_cnt < CTLD_MAX_IDLE_CONNS)) {
+		idle_conns[idle_conn_cnt].fd = fd;
+		idle_conns[idle_conn_cnt].idle_since = time(NULL);
+		idle_conn_cnt++;
+		added = true;
+	}
+	slurm_mutex_unlock(&idle_conn_lock);
+
+	/* Wake the RPC manager so it adds fd to its poll set */
+	if (added && (write(rpc_wake_fd[1], &c, 1) < 0) && (errno != EAGAIN))
+		error("%s: write: %m", __func__);
+
+	return added;
+}
+
+/* Remove fd from the idle connections, RPC manager only */
+static void _idle_conn_remove(int fd)
+{
+	slurm_mutex_lock(&idle_conn_lock);
+	for (int i = 0; i < idle_conn_cnt; i++) {
+		if (idle_conns[i].fd == fd) {
+			idle_conns[i] = idle_conns[--idle_conn_cnt];
+			break;
+		}
+	}
+	slurm_mutex_unlock(&idle_conn_lock);
+}
+
+/*
+ * Fill in the poll entries for the idle connections after the first offset
+ * entries of *fds, growing *fds as needed. Connections idle for longer than
+ * CTLD_CONN_IDLE_TIMEOUT are closed.
+ * RET number of idle connections added
+ */
+static int _idle_conn_poll_setup(struct pollfd **fds, int *fds_size,
+				 int offset)
+{
+	time_t now = time(NULL);
+	int cnt = 0;
+
+	slurm_mutex_lock(&idle_conn_lock);
+	for (int i = 0; i < idle_conn_cnt; i++) {
+		if ((now - idle_conns[i].idle_since) >
+		    (CTLD_CONN_IDLE_TIMEOUT / 1000)) {
+			close(idle_conns[i].fd);
+			idle_conns[i--] = idle_conns[--idle_conn_cnt];
+		}
+	}
+	if ((offset + idle_conn_cnt) > *fds_size) {
+		*fds_size = offset + CTLD_MAX_IDLE_CONNS;
+		xrecalloc(*fds, *fds_size, sizeof(struct pollfd));
+	}
+	for (int i = 0; i < idle_conn_cnt; i++, cnt++) {
+		(*fds)[offset + i].fd = idle_conns[i].fd;
+		(*fds)[offset + i].events = POLLIN;
+		(*fds)[offset + i].revents = 0;
+	}
+	slurm_mutex_unlock(&idle_conn_lock);
+
+	return cnt;
+}
+
+static void _idle_conn_fini(void)
+{
+	slurm_mutex_lock(&idle_conn_lock);
+	for (int i = 0; i < idle_conn_cnt; i++)
+		close(idle_conns[i].fd);
+	idle_conn_cnt = 0;
+	slurm_mutex_unlock(&idle_conn_lock);
+}
+
 /*
  * _service_connection - service the RPC
- * IN/OUT arg - really just the connection's file descriptor, freed
+ * IN/OUT arg - really just the connection's rpc_conn_t, freed
  *	upon completion
  * RET - NULL
  */
 static void *_service_connection(void *arg)
 {
-	int fd = *((int *) arg);
+	rpc_conn_t *conn = arg;
+	int fd = conn->fd;
 	slurm_msg_t *msg = xmalloc(sizeof *msg);
-	xfree(arg);
+	struct timeval now;
 
-#if HAVE_SYS_PRCTL_H
-	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
-		error("%s: cannot set my name to %s %m", __func__, "srvcn");
-	}
-#endif
 	slurm_msg_t_init(msg);
 	msg->flags |= SLURM_MSG_KEEP_BUFFER;
+	/* Unpack read only requests into one arena, released with msg */
+	msg->arena = xarena_create();
 	/*
 	 * slurm_receive_msg sets msg connection fd to accepted fd. This allows
 	 * possibility for slurmctld_req() to close accepted connection.
@@ -1257,6 +1438,13 @@ static void *_service_connection(void *arg)
 		goto cleanup;
 	}
 
+	gettimeofday(&now, NULL);
+	record_rpc_queue_delay(((now.tv_sec - conn->start.tv_sec) *
+				USEC_IN_SEC) +
+			       (now.tv_usec - conn->start.tv_usec));
+	xfree(conn);
+	rpc_capture_record(msg, &now);
+
 	if (rpc_enqueue(msg)) {
 		server_thread_decr();
 		return NULL;
@@ -1265,16 +1453,76 @@ static void *_service_connection(void *arg)
 	/* process the request */
 	slurmctld_req(msg);
 
+	/* The client asked to send further requests on this connection */
+	if ((msg->flags & SLURM_CONN_KEEP_ALIVE) && (msg->conn_fd >= 0) &&
+	    _idle_conn_add(msg->conn_fd))
+		msg->conn_fd = -1;
+
 	if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
 		error("close(%d): %m", msg->conn_fd);
 
 cleanup:
+	xfree(conn);
 	slurm_free_msg(msg);
 	server_thread_decr();
 
 	return NULL;
 }
 
+/*
+ * Service connections handed over by the RPC manager. Rather than one
+ * thread per connection, a worker waits for another connection once done
+ * and exits after RPC_WORKER_IDLE_TIMEOUT of idleness.
+ */
+static void *_rpc_worker(void *arg)
+{
+	rpc_conn_t *conn = arg;
+
+#if HAVE_SYS_PRCTL_H
+	if (prctl(PR_SET_NAME, "srvcn", NULL, NULL, NULL) < 0) {
+		error("%s: cannot set my name to %s %m", __func__, "srvcn");
+	}
+#endif
+
+	while (conn) {
+		struct timespec ts = {0, 0};
+
+		_service_connection(conn);
+
+		slurm_mutex_lock(&rpc_worker_lock);
+		rpc_worker_idle++;
+		ts.tv_sec = time(NULL) + RPC_WORKER_IDLE_TIMEOUT;
+		while (!(conn = list_pop(rpc_worker_fds)) &&
+		       !slurmctld_config.shutdown_time) {
+			slurm_cond_timedwait(&rpc_worker_cond,
+					     &rpc_worker_lock, &ts);
+			if (time(NULL) >= ts.tv_sec) {
+				conn = list_pop(rpc_worker_fds);
+				break;
+			}
+		}
+		rpc_worker_idle--;
+		slurm_mutex_unlock(&rpc_worker_lock);
+	}
+
+	return NULL;
+}
+
+/* Hand an accepted connection to an idle worker or start a new one */
+static void _rpc_dispatch(rpc_conn_t *conn)
+{
+	slurm_mutex_lock(&rpc_worker_lock);
+	if (rpc_worker_idle > list_count(rpc_worker_fds)) {
+		list_append(rpc_worker_fds, conn);
+		slurm_cond_signal(&rpc_worker_cond);
+		conn = NULL;
+	}
+	slurm_mutex_unlock(&rpc_worker_lock);
+
+	if (conn)
+		slurm_thread_create_detached(NULL, _rpc_worker, conn);
+}
+
 /* Increment slurmctld_config.server_thread_count and don't return
  * until its value is no larger than MAX_SERVER_THREADS,
  * RET true unless shutdown in progress */
@@ -1975,6 +2223,7 @@ static void *_slurmctld_background(void *no_data)
 			int exp_thread_cnt =
 				slurmctld_config.resume_backup ? 1 : 0;
 			/* wait for RPC's to complete */
+			event_mgr_shutdown();
 			gettimeofday(&now, NULL);
 			ts.tv_sec = now.tv_sec + CONTROL_TIMEOUT;
 			ts.tv_nsec = now.tv_usec * 1000;
@@ -2173,6 +2422,12 @@ static void *_slurmctld_background(void *no_data)
 			last_ctld_bu_ping = now;
 		}
 
+		if (event_mgr_scan_needed()) {
+			lock_slurmctld(job_node_read_lock);
+			event_mgr_scan();
+			unlock_slurmctld(job_node_read_lock);
+		}
+
 		if (difftime(now, last_trigger) > TRIGGER_INTERVAL) {
 			lock_slurmctld(job_node_read_lock);
 			now = time(NULL);
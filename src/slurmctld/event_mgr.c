@@ -0,0 +1,295 @@
+/*****************************************************************************\
+ *  event_mgr.c - job, node and reservation event stream
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <pthread.h>
+
+#include "src/common/macros.h"
+#include "src/common/pack.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/event_mgr.h"
+#include "src/slurmctld/locks.h"
+#include "src/slurmctld/slurmctld.h"
+
+/*
+ * Events are kept in a fixed size ring. A reader keeps the next sequence
+ * number of the previous reply; once that has been overwritten the reply is
+ * flagged as lost and the reader needs to reload state in full.
+ *
+ * Job and node state changes are found by comparing each record with the
+ * state last reported, once a second from the background thread and only
+ * once someone has read events. Records are marked with the event_gen they
+ * were last seen in, records from before a new generation are primed
+ * without being reported. Jobs first seen after that are reported.
+ */
+#define EVENT_RING_SIZE		16384
+#define EVENT_MAX_REPLY		1000	/* events per reply */
+#define EVENT_MAX_WAITERS	16	/* RPCs blocked waiting for events */
+
+static pthread_mutex_t event_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t event_cond = PTHREAD_COND_INITIALIZER;
+static event_info_t event_ring[EVENT_RING_SIZE];
+static uint64_t next_seq = 1;
+static bool event_active = false;
+static int event_waiters = 0;
+
+static uint32_t job_gen = 0, node_gen = 0;
+static bool job_prime = false;
+static node_record_t *last_node_table = NULL;
+static int last_node_cnt = 0;
+static time_t last_scan = 0;
+
+/* Add one event, NOTE: event_mutex must be locked */
+static void _add_event(uint16_t type, char *name, uint32_t job_id,
+		       uint32_t user_id, uint32_t state, time_t now)
+{
+	event_info_t *event = &event_ring[next_seq % EVENT_RING_SIZE];
+
+	xfree(event->name);
+	event->name = xstrdup(name);
+	event->job_id = job_id;
+	event->seq = next_seq++;
+	event->state = state;
+	event->time = now;
+	event->type = type;
+	event->user_id = user_id;
+}
+
+static int _scan_job(void *x, void *arg)
+{
+	job_record_t *job_ptr = x;
+	time_t *now = arg;
+	bool report = true;
+
+	if (job_ptr->event_gen != job_gen) {
+		report = !job_prime;
+		job_ptr->event_gen = job_gen;
+	} else if (job_ptr->event_state == job_ptr->job_state)
+		return 0;
+
+	job_ptr->event_state = job_ptr->job_state;
+	if (report)
+		_add_event(EVENT_TYPE_JOB_STATE, NULL, job_ptr->job_id,
+			   job_ptr->user_id, job_ptr->job_state, *now);
+
+	return 0;
+}
+
+extern void event_mgr_resv(slurmctld_resv_t *resv_ptr, uint16_t type)
+{
+	slurm_mutex_lock(&event_mutex);
+	if (event_active) {
+		_add_event(type, resv_ptr->name, 0, 0, 0, time(NULL));
+		slurm_cond_broadcast(&event_cond);
+	}
+	slurm_mutex_unlock(&event_mutex);
+}
+
+extern bool event_mgr_scan_needed(void)
+{
+	bool rc;
+
+	slurm_mutex_lock(&event_mutex);
+	/* Changes within the last scan's second may not have been seen */
+	rc = event_active && ((last_job_update >= last_scan) ||
+			      (last_node_update >= last_scan));
+	slurm_mutex_unlock(&event_mutex);
+
+	return rc;
+}
+
+extern void event_mgr_scan(void)
+{
+	uint64_t start_seq;
+	time_t now = time(NULL);
+	node_record_t *node_ptr;
+	int i;
+
+	xassert(verify_lock(JOB_LOCK, READ_LOCK));
+	xassert(verify_lock(NODE_LOCK, READ_LOCK));
+
+	slurm_mutex_lock(&event_mutex);
+	start_seq = next_seq;
+	last_scan = now;
+
+	/* The node table was rebuilt, prime the new records */
+	if ((node_record_table_ptr != last_node_table) ||
+	    (node_record_count != last_node_cnt)) {
+		last_node_table = node_record_table_ptr;
+		last_node_cnt = node_record_count;
+		if (++node_gen == 0)
+			node_gen = 1;
+	}
+
+	if (job_list)
+		list_for_each(job_list, _scan_job, &now);
+	job_prime = false;
+
+	for (i = 0, node_ptr = node_record_table_ptr; i < node_record_count;
+	     i++, node_ptr++) {
+		if (!node_ptr->name || (node_ptr->name[0] == '\0'))
+			continue;
+		if (node_ptr->event_gen != node_gen) {
+			node_ptr->event_gen = node_gen;
+			node_ptr->event_state = node_ptr->node_state;
+			continue;
+		}
+		if (node_ptr->event_state == node_ptr->node_state)
+			continue;
+		node_ptr->event_state = node_ptr->node_state;
+		_add_event(EVENT_TYPE_NODE_STATE, node_ptr->name, 0, 0,
+			   node_ptr->node_state, now);
+	}
+
+	if (next_seq != start_seq)
+		slurm_cond_broadcast(&event_cond);
+	slurm_mutex_unlock(&event_mutex);
+}
+
+/* Return true if the event may be sent to uid */
+static bool _event_visible(event_info_t *event, uid_t uid, bool operator)
+{
+	if (operator)
+		return true;
+
+	switch (event->type) {
+	case EVENT_TYPE_JOB_STATE:
+		return (!(slurm_conf.private_data & PRIVATE_DATA_JOBS) ||
+			(event->user_id == uid));
+	case EVENT_TYPE_NODE_STATE:
+		return !(slurm_conf.private_data & PRIVATE_DATA_NODES);
+	default:
+		return !(slurm_conf.private_data &
+			 PRIVATE_DATA_RESERVATIONS);
+	}
+}
+
+extern void event_mgr_pack(uint64_t seq, uint16_t wait, uid_t uid,
+			   char **buffer_ptr, int *buffer_size,
+			   uint16_t protocol_version)
+{
+	uint32_t cnt = 0, tmp_offset;
+	uint64_t first_seq;
+	bool lost = false, operator = validate_operator(uid);
+	event_info_t *event;
+	buf_t *buffer;
+	struct timespec ts = {0, 0};
+
+	buffer_ptr[0] = NULL;
+	*buffer_size = 0;
+
+	slurm_mutex_lock(&event_mutex);
+	if (!event_active) {
+		/* Start reporting, with all current records primed */
+		event_active = true;
+		if (++job_gen == 0)
+			job_gen = 1;
+		job_prime = true;
+		last_node_table = NULL;
+		last_scan = 0;
+	}
+
+	first_seq = (next_seq > EVENT_RING_SIZE) ?
+		    (next_seq - EVENT_RING_SIZE) : 1;
+	if (!seq) {
+		seq = next_seq;
+	} else if ((seq < first_seq) || (seq > next_seq)) {
+		/* Overwritten, or from before a slurmctld restart */
+		lost = true;
+		seq = next_seq;
+	}
+
+	/* Leave time to reply within the client's MessageTimeout */
+	wait = MIN(wait, slurm_conf.msg_timeout / 2);
+	if (!lost && wait && (seq == next_seq) &&
+	    (event_waiters < EVENT_MAX_WAITERS)) {
+		ts.tv_sec = time(NULL) + wait;
+		event_waiters++;
+		while (!slurmctld_config.shutdown_time && (seq == next_seq) &&
+		       (time(NULL) < ts.tv_sec))
+			slurm_cond_timedwait(&event_cond, &event_mutex, &ts);
+		event_waiters--;
+	}
+
+	buffer = init_buf(BUF_SIZE);
+	pack32(cnt, buffer);
+	packbool(lost, buffer);
+	pack64(seq, buffer);	/* replaced below */
+
+	for (; (seq < next_seq) && (cnt < EVENT_MAX_REPLY); seq++) {
+		event = &event_ring[seq % EVENT_RING_SIZE];
+		if (!_event_visible(event, uid, operator))
+			continue;
+		pack64(event->seq, buffer);
+		pack16(event->type, buffer);
+		pack_time(event->time, buffer);
+		pack32(event->state, buffer);
+		pack32(event->job_id, buffer);
+		pack32(event->user_id, buffer);
+		packstr(event->name, buffer);
+		cnt++;
+	}
+	slurm_mutex_unlock(&event_mutex);
+
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(cnt, buffer);
+	packbool(lost, buffer);
+	pack64(seq, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+extern void event_mgr_shutdown(void)
+{
+	slurm_mutex_lock(&event_mutex);
+	slurm_cond_broadcast(&event_cond);
+	slurm_mutex_unlock(&event_mutex);
+}
+
+extern void event_mgr_fini(void)
+{
+	int i;
+
+	slurm_mutex_lock(&event_mutex);
+	for (i = 0; i < EVENT_RING_SIZE; i++)
+		xfree(event_ring[i].name);
+	slurm_mutex_unlock(&event_mutex);
+}
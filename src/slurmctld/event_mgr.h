@@ -0,0 +1,73 @@
+/*****************************************************************************\
+ *  event_mgr.h - header for the job, node and reservation event stream
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_EVENT_MGR_H
+#define _HAVE_EVENT_MGR_H
+
+#include "src/slurmctld/slurmctld.h"
+
+/* Record a reservation event of type EVENT_TYPE_RESV_* */
+extern void event_mgr_resv(slurmctld_resv_t *resv_ptr, uint16_t type);
+
+/*
+ * Return true if job or node records may have changed since the last
+ * event_mgr_scan() and there is at least one event reader
+ */
+extern bool event_mgr_scan_needed(void);
+
+/*
+ * Record job and node state changes since the last scan
+ * NOTE: READ lock_slurmctld job and node before entry
+ */
+extern void event_mgr_scan(void);
+
+/*
+ * Pack the events starting at seq visible to uid, waiting up to wait seconds
+ * for one if none is pending. Sets the event reader active, so the first
+ * request only returns the current position.
+ * NOTE: No slurmctld locks may be held, as this can block
+ * NOTE: the caller must xfree the buffer at *buffer_ptr
+ */
+extern void event_mgr_pack(uint64_t seq, uint16_t wait, uid_t uid,
+			   char **buffer_ptr, int *buffer_size,
+			   uint16_t protocol_version);
+
+/* Wake up any RPC waiting in event_mgr_pack() at shutdown */
+extern void event_mgr_shutdown(void);
+
+/* Free the buffered events */
+extern void event_mgr_fini(void);
+
+#endif	/* !_HAVE_EVENT_MGR_H */
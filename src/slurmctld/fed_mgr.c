@@ -65,6 +65,9 @@
 
 #define FED_SIBLING_BIT(x) ((uint64_t)1 << (x - 1))
 
+/* Most queued RPCs sent to a sibling in one REQUEST_CTLD_MULT_MSG */
+#define FED_AGENT_WINDOW 256
+
 slurmdb_federation_rec_t *fed_mgr_fed_rec     = NULL;
 slurmdb_cluster_rec_t    *fed_mgr_cluster_rec = NULL;
 
@@ -73,6 +76,21 @@ static pthread_mutex_t agent_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_t       agent_thread_id = (pthread_t) 0;
 static int             agent_queue_size = 0;
 
+/* Sibling RPC agent statistics, indexed by sibling fed.id */
+typedef struct {
+	char          *name;
+	uint32_t       depth;		/* RPCs queued at last agent pass */
+	struct timeval oldest;		/* enqueue time of oldest queued RPC */
+	uint32_t       msg_cnt;		/* RPCs acknowledged by the sibling */
+	uint32_t       batch_cnt;	/* aggregated messages sent */
+	uint32_t       batch_max;
+	uint32_t       fail_cnt;	/* aggregated messages not processed */
+	uint64_t       lag_sum;		/* usec from enqueue to acknowledgement */
+	uint64_t       lag_max;
+} fed_sib_stats_t;
+static fed_sib_stats_t fed_sib_stats[MAX_FED_CLUSTERS + 1];
+static pthread_mutex_t fed_sib_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 static pthread_cond_t  job_watch_cond = PTHREAD_COND_INITIALIZER;
 static pthread_mutex_t job_watch_mutex = PTHREAD_MUTEX_INITIALIZER;
 static bool            job_watch_thread_running = false;
@@ -106,10 +124,12 @@ static pthread_mutex_t origin_dep_update_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 typedef struct {
 	buf_t *buffer;
+	bool       in_window;
 	uint32_t   job_id;
 	time_t     last_try;
 	int        last_defer;
 	uint16_t   msg_type;
+	struct timeval queued;
 } agent_queue_t;
 
 enum fed_job_update_type {
@@ -482,6 +502,7 @@ static int _queue_rpc(slurmdb_cluster_rec_t *cluster, slurm_msg_t *req,
 	agent_rec->buffer = buf;
 	agent_rec->job_id = job_id;
 	agent_rec->msg_type = req->msg_type;
+	gettimeofday(&agent_rec->queued, NULL);
 	list_append(cluster->send_rpc, agent_rec);
 	slurm_mutex_lock(&agent_mutex);
 	agent_queue_size++;
@@ -2529,6 +2550,55 @@ static void *_fed_job_update_thread(void *arg)
 	return NULL;
 }
 
+/* Index of a sibling in fed_sib_stats, 0 (never reported) if out of range */
+static int _sib_stats_inx(slurmdb_cluster_rec_t *cluster)
+{
+	if ((cluster->fed.id < 1) || (cluster->fed.id > MAX_FED_CLUSTERS))
+		return 0;
+	return cluster->fed.id;
+}
+
+/* Forget which RPCs were in a window that the sibling did not process */
+static void _clear_window(slurmdb_cluster_rec_t *cluster)
+{
+	ListIterator rpc_iter;
+	agent_queue_t *rpc_rec;
+
+	rpc_iter = list_iterator_create(cluster->send_rpc);
+	while ((rpc_rec = list_next(rpc_iter)))
+		rpc_rec->in_window = false;
+	list_iterator_destroy(rpc_iter);
+}
+
+/* Record the queue depth and oldest queued RPC of a sibling */
+static void _update_sib_stats(slurmdb_cluster_rec_t *cluster)
+{
+	fed_sib_stats_t *stats;
+	agent_queue_t *rpc_rec = NULL;
+	uint32_t depth = 0;
+
+	if (!_sib_stats_inx(cluster) || (cluster == fed_mgr_cluster_rec))
+		return;
+
+	if (cluster->send_rpc) {
+		depth = list_count(cluster->send_rpc);
+		rpc_rec = list_peek(cluster->send_rpc);
+	}
+
+	slurm_mutex_lock(&fed_sib_stats_mutex);
+	stats = &fed_sib_stats[_sib_stats_inx(cluster)];
+	if (xstrcmp(stats->name, cluster->name)) {
+		xfree(stats->name);
+		stats->name = xstrdup(cluster->name);
+	}
+	stats->depth = depth;
+	if (rpc_rec)
+		stats->oldest = rpc_rec->queued;
+	else
+		timerclear(&stats->oldest);
+	slurm_mutex_unlock(&fed_sib_stats_mutex);
+}
+
 /* Start a thread to manage queued agent requests */
 static void *_agent_thread(void *arg)
 {
@@ -2539,7 +2609,11 @@ static void *_agent_thread(void *arg)
 	slurm_msg_t req_msg, resp_msg;
 	ctld_list_msg_t ctld_req_msg;
 	bitstr_t *success_bits;
-	int rc, resp_inx, success_size;
+	int rc, resp_inx, success_size, window_cnt, ack_cnt;
+	bool window_ok;
+	struct timeval ack_time;
+	uint64_t lag, lag_sum, lag_max;
+	fed_sib_stats_t *stats;
 
 	slurmctld_lock_t fed_read_lock = {
 		NO_LOCK, NO_LOCK, NO_LOCK, NO_LOCK, READ_LOCK };
@@ -2575,13 +2649,22 @@ static void *_agent_thread(void *arg)
 		       (cluster = list_next(cluster_iter))) {
 			time_t now = time(NULL);
 			if ((cluster->send_rpc == NULL) ||
-			   (list_count(cluster->send_rpc) == 0))
+			   (list_count(cluster->send_rpc) == 0)) {
+				_update_sib_stats(cluster);
 				continue;
+			}
 
-			/* Move currently pending RPCs to new list */
+next_window:
+			/*
+			 * Move up to FED_AGENT_WINDOW pending RPCs to new list.
+			 * RPCs sent in an earlier window of this pass have
+			 * last_try == now and are skipped.
+			 */
 			ctld_req_msg.my_list = NULL;
+			window_cnt = 0;
 			rpc_iter = list_iterator_create(cluster->send_rpc);
-			while ((rpc_rec = list_next(rpc_iter))) {
+			while ((window_cnt < FED_AGENT_WINDOW) &&
+			       (rpc_rec = list_next(rpc_iter))) {
 				if ((rpc_rec->last_try + rpc_rec->last_defer) >=
 				    now)
 					continue;
@@ -2589,6 +2672,8 @@ static void *_agent_thread(void *arg)
 					ctld_req_msg.my_list =list_create(NULL);
 				list_append(ctld_req_msg.my_list,
 					    rpc_rec->buffer);
+				rpc_rec->in_window = true;
+				window_cnt++;
 				rpc_rec->last_try = now;
 				if (rpc_rec->last_defer == 128) {
 					info("%s: %s JobId=%u request to cluster %s is repeatedly failing",
@@ -2602,8 +2687,10 @@ static void *_agent_thread(void *arg)
 					rpc_rec->last_defer = 2;
 			}
 			list_iterator_destroy(rpc_iter);
-			if (!ctld_req_msg.my_list)
+			if (!ctld_req_msg.my_list) {
+				_update_sib_stats(cluster);
 				continue;
+			}
 
 			/* Build, pack and send the combined RPC */
 			slurm_msg_t_init(&req_msg);
@@ -2619,23 +2706,54 @@ static void *_agent_thread(void *arg)
 				resp_inx = 0;
 				success_bits = _parse_resp_ctld_mult(&resp_msg);
 				success_size = bit_size(success_bits);
+				gettimeofday(&ack_time, NULL);
+				ack_cnt = 0;
+				lag_sum = lag_max = 0;
 				rpc_iter = list_iterator_create(cluster->
 								send_rpc);
 				while ((rpc_rec = list_next(rpc_iter))) {
-					if (rpc_rec->last_try != now)
+					if (!rpc_rec->in_window)
 						continue;
+					rpc_rec->in_window = false;
 					if (resp_inx >= success_size) {
 						error("%s: bitmap too small (%d >= %d)",
 						      __func__, resp_inx,
 						      success_size);
-						break;
+						continue;
 					}
-					if (bit_test(success_bits, resp_inx++))
+					if (bit_test(success_bits,
+						     resp_inx++)) {
+						lag = ((ack_time.tv_sec -
+							rpc_rec->queued.tv_sec) *
+						       USEC_IN_SEC) +
+						      (ack_time.tv_usec -
+						       rpc_rec->queued.tv_usec);
+						lag_sum += lag;
+						lag_max = MAX(lag_max, lag);
+						ack_cnt++;
 						list_delete_item(rpc_iter);
+					}
 				}
 				list_iterator_destroy(rpc_iter);
 				FREE_NULL_BITMAP(success_bits);
+
+				slurm_mutex_lock(&fed_sib_stats_mutex);
+				stats = &fed_sib_stats[_sib_stats_inx(cluster)];
+				stats->batch_cnt++;
+				stats->batch_max = MAX(stats->batch_max,
+						       window_cnt);
+				stats->msg_cnt += ack_cnt;
+				stats->lag_sum += lag_sum;
+				stats->lag_max = MAX(stats->lag_max, lag_max);
+				slurm_mutex_unlock(&fed_sib_stats_mutex);
+				window_ok = true;
 			} else {
+				window_ok = false;
+				_clear_window(cluster);
+				slurm_mutex_lock(&fed_sib_stats_mutex);
+				fed_sib_stats[_sib_stats_inx(cluster)].fail_cnt++;
+				slurm_mutex_unlock(&fed_sib_stats_mutex);
+
 				/* Failed to process combined RPC.
 				 * Leave all RPCs on the queue. */
 				if (rc != SLURM_SUCCESS) {
@@ -2675,6 +2793,18 @@ static void *_agent_thread(void *arg)
 						   resp_msg.data);
 
 			list_destroy(ctld_req_msg.my_list);
+
+			/*
+			 * Each window is acknowledged before the next is sent,
+			 * so a busy sibling never has more than one window
+			 * outstanding and a failed send only leaves that
+			 * window to be retried.
+			 */
+			if (window_ok && (window_cnt == FED_AGENT_WINDOW) &&
+			    !slurmctld_config.shutdown_time)
+				goto next_window;
+
+			_update_sib_stats(cluster);
 		}
 		list_iterator_destroy(cluster_iter);
 
@@ -2960,9 +3090,68 @@ extern int fed_mgr_fini(void)
 
 	FREE_NULL_LIST(fed_job_update_list);
 
+	slurm_mutex_lock(&fed_sib_stats_mutex);
+	for (int i = 0; i <= MAX_FED_CLUSTERS; i++)
+		xfree(fed_sib_stats[i].name);
+	memset(fed_sib_stats, 0, sizeof(fed_sib_stats));
+	slurm_mutex_unlock(&fed_sib_stats_mutex);
+
 	return SLURM_SUCCESS;
 }
 
+extern void fed_mgr_pack_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	struct timeval now;
+	uint32_t cnt = 0;
+	uint64_t lag;
+	int i;
+
+	gettimeofday(&now, NULL);
+	slurm_mutex_lock(&fed_sib_stats_mutex);
+	for (i = 1; i <= MAX_FED_CLUSTERS; i++) {
+		if (fed_sib_stats[i].name)
+			cnt++;
+	}
+	pack32(cnt, buffer);
+	for (i = 1; i <= MAX_FED_CLUSTERS; i++) {
+		fed_sib_stats_t *stats = &fed_sib_stats[i];
+
+		if (!stats->name)
+			continue;
+
+		lag = 0;
+		if (timerisset(&stats->oldest))
+			lag = ((now.tv_sec - stats->oldest.tv_sec) *
+			       USEC_IN_SEC) +
+			      (now.tv_usec - stats->oldest.tv_usec);
+
+		packstr(stats->name, buffer);
+		pack32(stats->depth, buffer);
+		pack32(stats->msg_cnt, buffer);
+		pack32(stats->batch_cnt, buffer);
+		pack32(stats->batch_max, buffer);
+		pack32(stats->fail_cnt, buffer);
+		pack64(stats->lag_sum, buffer);
+		pack64(stats->lag_max, buffer);
+		pack64(lag, buffer);
+	}
+	slurm_mutex_unlock(&fed_sib_stats_mutex);
+}
+
+extern void fed_mgr_reset_stats(void)
+{
+	slurm_mutex_lock(&fed_sib_stats_mutex);
+	for (int i = 0; i <= MAX_FED_CLUSTERS; i++) {
+		fed_sib_stats[i].msg_cnt = 0;
+		fed_sib_stats[i].batch_cnt = 0;
+		fed_sib_stats[i].batch_max = 0;
+		fed_sib_stats[i].fail_cnt = 0;
+		fed_sib_stats[i].lag_sum = 0;
+		fed_sib_stats[i].lag_max = 0;
+	}
+	slurm_mutex_unlock(&fed_sib_stats_mutex);
+}
+
 static void _handle_dependencies_for_modified_fed(uint64_t added_clusters,
 						  uint64_t removed_clusters)
 {
@@ -87,12 +87,14 @@ extern int       fed_mgr_job_revoke(job_record_t *job_ptr, bool job_complete,
 				    uint32_t exit_code, time_t start_time);
 extern int       fed_mgr_job_revoke_sibs(job_record_t *job_ptr);
 extern int       fed_mgr_job_start(job_record_t *job_ptr, time_t start_time);
+extern void      fed_mgr_pack_stats(buf_t *buffer, uint16_t protocol_version);
 extern int       fed_mgr_q_dep_msg(slurm_msg_t *msg);
 extern int       fed_mgr_q_sib_msg(slurm_msg_t *sib_msg, uint32_t rpc_uid);
 extern int       fed_mgr_q_update_origin_dep_msg(slurm_msg_t *msg);
 extern int       fed_mgr_remove_active_sibling(uint32_t job_id, char *sib_name);
 extern void      fed_mgr_remove_fed_job_info(uint32_t job_id);
 extern void      fed_mgr_remove_remote_dependencies(job_record_t *job_ptr);
+extern void      fed_mgr_reset_stats(void);
 extern bool      fed_mgr_sibs_synced();
 extern int       fed_mgr_state_save(char *state_save_location);
 extern void      fed_mgr_test_remote_dependencies(void);
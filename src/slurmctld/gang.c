@@ -89,6 +89,8 @@ struct gs_job {
 	job_record_t *job_ptr;
 	uint16_t sig_state;
 	uint16_t row_state;
+	bool shadow_cast;	/* in the shadow array of every lower
+				 * priority partition */
 };
 
 struct gs_part {
@@ -139,6 +141,10 @@ struct gs_part {
  * the active row of a partition, any jobs in the 'shadow' array
  * are applied first.
  *
+ * A job casts its shadow on every partition with a lower priority
+ * tier or on none of them, so gs_job.shadow_cast records which and
+ * lets the active row rebuild skip re-casting existing shadows.
+ *
  ******************************************
  */
 
@@ -397,7 +403,6 @@ static int _job_fits_in_active_row(job_record_t *job_ptr,
 {
 	job_resources_t *job_res = job_ptr->job_resrcs;
 	int count;
-	bitstr_t *job_map;
 	uint16_t job_gr_type;
 
 	if ((p_ptr->active_resmap == NULL) || (p_ptr->jobs_active == 0))
@@ -411,12 +416,14 @@ static int _job_fits_in_active_row(job_record_t *job_ptr,
 	}
 
 	/* job_gr_type == GS_NODE || job_gr_type == GS_CPU */
-	job_map = bit_copy(job_res->node_bitmap);
-	bit_and(job_map, p_ptr->active_resmap);
 	/* any set bits indicate contention for the same resource */
-	count = bit_set_count(job_map);
-	log_flag(GANG, "gang: %s: %d bits conflict", __func__, count);
-	FREE_NULL_BITMAP(job_map);
+	if (slurm_conf.debug_flags & DEBUG_FLAG_GANG) {
+		count = bit_overlap(job_res->node_bitmap,
+				    p_ptr->active_resmap);
+		log_flag(GANG, "gang: %s: %d bits conflict", __func__, count);
+	} else
+		count = bit_overlap_any(job_res->node_bitmap,
+					p_ptr->active_resmap);
 	if (count == 0)
 		return 1;
 	if (job_gr_type == GS_CPU) {
@@ -672,7 +679,10 @@ static void _cast_shadow(struct gs_job *j_ptr, uint16_t priority)
 {
 	ListIterator part_iterator;
 	struct gs_part *p_ptr;
-	int i;
+
+	if (j_ptr->shadow_cast)
+		return;
+	j_ptr->shadow_cast = true;
 
 	part_iterator = list_iterator_create(gs_part_list);
 	while ((p_ptr = list_next(part_iterator))) {
@@ -686,14 +696,6 @@ static void _cast_shadow(struct gs_job *j_ptr, uint16_t priority)
 			p_ptr->shadow = xmalloc(p_ptr->shadow_size *
 						sizeof(struct gs_job *));
 			/* 'shadow' is initialized to be NULL filled */
-		} else {
-			/* does this shadow already exist? */
-			for (i = 0; i < p_ptr->num_shadows; i++) {
-				if (p_ptr->shadow[i] == j_ptr)
-					break;
-			}
-			if (i < p_ptr->num_shadows)
-				continue;
 		}
 
 		if (p_ptr->num_shadows+1 >= p_ptr->shadow_size) {
@@ -714,6 +716,10 @@ static void _clear_shadow(struct gs_job *j_ptr)
 	struct gs_part *p_ptr;
 	int i;
 
+	if (!j_ptr->shadow_cast)
+		return;
+	j_ptr->shadow_cast = false;
+
 	part_iterator = list_iterator_create(gs_part_list);
 	while ((p_ptr = list_next(part_iterator))) {
 		if (!p_ptr->shadow)
@@ -1429,26 +1435,31 @@ static void _build_active_row(struct gs_part *p_ptr)
  */
 static void _cycle_job_list(struct gs_part *p_ptr)
 {
-	int i, j;
-	struct gs_job *j_ptr;
+	int i, j, k;
+	struct gs_job *j_ptr, **active_list;
 	uint16_t preempt_mode;
 
 	log_flag(GANG, "gang: entering %s", __func__);
-	/* re-prioritize the job_list and set all row_states to GS_NO_ACTIVE */
-	for (i = 0; i < p_ptr->num_jobs; i++) {
-		while (p_ptr->job_list[i]->row_state == GS_ACTIVE) {
+	/*
+	 * re-prioritize the job_list and set all row_states to GS_NO_ACTIVE:
+	 * move the active jobs to the back row, preserving their order among
+	 * each other, in one pass rather than shifting the list once per job
+	 */
+	active_list = xcalloc(p_ptr->num_jobs + 1, sizeof(struct gs_job *));
+	for (i = 0, j = 0, k = 0; i < p_ptr->num_jobs; i++) {
+		j_ptr = p_ptr->job_list[i];
+		if (j_ptr->row_state == GS_ACTIVE) {
 			/* move this job to the back row and "deactivate" it */
-			j_ptr = p_ptr->job_list[i];
 			j_ptr->row_state = GS_NO_ACTIVE;
-			for (j = i; j+1 < p_ptr->num_jobs; j++) {
-				p_ptr->job_list[j] = p_ptr->job_list[j+1];
-			}
-			p_ptr->job_list[j] = j_ptr;
+			active_list[k++] = j_ptr;
+			continue;
 		}
-		if (p_ptr->job_list[i]->row_state == GS_FILLER)
-			p_ptr->job_list[i]->row_state = GS_NO_ACTIVE;
-
+		if (j_ptr->row_state == GS_FILLER)
+			j_ptr->row_state = GS_NO_ACTIVE;
+		p_ptr->job_list[j++] = j_ptr;
 	}
+	memcpy(p_ptr->job_list + j, active_list, k * sizeof(struct gs_job *));
+	xfree(active_list);
 	log_flag(GANG, "gang: %s reordered job list:", __func__);
 	/* Rebuild the active row. */
 	_build_active_row(p_ptr);
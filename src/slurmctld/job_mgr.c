@@ -103,6 +103,7 @@
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/sched_plugin.h"
+#include "src/slurmctld/sched_trace.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
 #include "src/slurmctld/srun_comm.h"
@@ -116,19 +117,51 @@
 #define TOP_PRIORITY 0xffff0000	/* large, but leave headroom for higher */
 #define PURGE_OLD_JOB_IN_SEC 2592000 /* 30 days in seconds */
 
-#define JOB_HASH_INX(_job_id)	(_job_id % hash_table_size)
-#define JOB_ARRAY_HASH_INX(_job_id, _task_id) \
-	((_job_id + _task_id) % hash_table_size)
+/* Fibonacci hashing, spreads sequential job IDs across the table */
+#define JOB_HASH_INX(_key, _table) \
+	((uint32_t) ((_key) * 2654435761U) >> (_table)->shift)
+#define JOB_HASH_DELETED	((void *) &job_hash_deleted)
+#define JOB_HASH_MIN_BITS	10	/* log2 of minimum job hash table size */
+
+#define JOB_JOURNAL_MAGIC	0x4a4a524e	/* start of a job journal batch */
+#define JOB_JOURNAL_MIN_SIZE	(1024 * 1024)	/* journal size below which
+						 * compaction is never done */
 
 /* No need to change we always pack SLURM_PROTOCOL_VERSION */
+#define JOB_SNAPSHOT_CNT 4	/* Count of job info snapshots kept */
+
 #define JOB_STATE_VERSION     "PROTOCOL_VERSION"
 #define JOB_CKPT_VERSION      "PROTOCOL_VERSION"
 
-typedef enum {
-	JOB_HASH_JOB,
-	JOB_HASH_ARRAY_JOB,
-	JOB_HASH_ARRAY_TASK,
-} job_hash_type_t;
+/*
+ * Open addressing hash table with linear probing. The key is stored in the
+ * slot so that probing does not need to dereference the records.
+ */
+typedef struct {
+	uint32_t key;
+	void *ptr;		/* NULL if empty, JOB_HASH_DELETED if removed */
+} job_hash_slot_t;
+
+typedef struct {
+	uint32_t cnt;		/* count of records in table */
+	uint32_t shift;		/* 32 - log2(size) */
+	uint32_t size;		/* count of slots, a power of 2 */
+	job_hash_slot_t *slots;
+	uint32_t used;		/* count of records and removed slots */
+} job_hash_table_t;
+
+/*
+ * All task records of one job array, indexed by array_task_id. The dense
+ * table is bounded by MaxArraySize, tasks beyond it (e.g. recovered from
+ * state saved with a larger MaxArraySize) go in task_hash.
+ */
+typedef struct {
+	uint32_t array_job_id;
+	uint32_t task_cnt;	/* count of task records */
+	job_hash_table_t task_hash; /* task records beyond task_recs */
+	job_record_t **task_recs;
+	uint32_t task_size;	/* count of entries in task_recs */
+} job_array_index_t;
 
 typedef struct {
 	int resp_array_cnt;
@@ -138,13 +171,20 @@ typedef struct {
 } resp_array_struct_t;
 
 typedef struct {
+	List account_list;	/* request filters, NULL for any */
 	buf_t *buffer;
+	bool delta;		/* SHOW_DELTA reply, unchanged jobs by ID */
 	uint32_t  filter_uid;
+	job_info_request_msg_t *filter;
 	bool has_qos_lock;
 	uint32_t *jobs_packed;
+	time_t now;
 	uint16_t  protocol_version;
+	List part_list;		/* request filters, NULL for any */
 	uint16_t  show_flags;
+	bool track;		/* track changes of packed records */
 	uid_t     uid;
+	time_t update_time;	/* SHOW_DELTA request's update_time */
 	slurmdb_user_rec_t user_rec;
 } _foreach_pack_job_info_t;
 
@@ -153,6 +193,20 @@ typedef struct {
 	int rc;
 } job_overlap_args_t;
 
+struct job_info_snapshot {
+	char *data;		/* packed RESPONSE_JOB_INFO message */
+	int size;		/* size of data in bytes */
+	time_t build_time;	/* when the snapshot was packed */
+	time_t job_update;	/* last_job_update when packed */
+	time_t part_update;	/* last_part_update when packed */
+	time_t conf_update;	/* slurm_conf.last_update when packed */
+	uint16_t protocol_version;
+	uint16_t show_flags;
+	bool root;		/* packed for uid 0 */
+	int refcnt;		/* readers using data */
+	bool retired;		/* replaced, free once refcnt is zero */
+};
+
 /* Global variables */
 List   job_list = NULL;		/* job_record list */
 time_t last_job_update;		/* time of last update to job records */
@@ -164,19 +218,52 @@ static int      bf_min_age_reserve = 0;
 static uint32_t delay_boot = 0;
 static uint32_t highest_prio = 0;
 static uint32_t lowest_prio  = TOP_PRIORITY;
-static int      hash_table_size = 0;
 static int      job_count = 0;		/* job's in the system */
 static uint32_t job_id_sequence = 0;	/* first job_id to assign new job */
-static struct   job_record **job_hash = NULL;
-static struct   job_record **job_array_hash_j = NULL;
-static struct   job_record **job_array_hash_t = NULL;
+static job_hash_table_t job_hash = { 0 };	/* job_id to job record */
+static job_hash_table_t job_array_hash = { 0 };	/* array_job_id to
+						 * job_array_index_t */
+static uint32_t job_info_pack_size = BUF_SIZE;	/* size of last job dump */
+static char     job_hash_deleted;
 static bool     kill_invalid_dep;
 static time_t   last_file_write_time = (time_t) 0;
 static uint32_t max_array_size = NO_VAL;
+static bitstr_t *purge_node_bitmap = NULL;	/* deferred missing job purge */
+static time_t   *purge_node_time = NULL;	/* registration time by node */
 static bitstr_t *requeue_exit = NULL;
 static bitstr_t *requeue_exit_hold = NULL;
 static bool     validate_cfgd_licenses = true;
 
+/* job_snapshot_lock protects the snapshots and their configuration */
+static pthread_mutex_t job_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static job_info_snapshot_t *job_snapshot[JOB_SNAPSHOT_CNT];
+static time_t   job_snapshot_conf_update = 0;
+static int      job_snapshot_interval = 0;
+
+/*
+ * Job state journal. job_journal_lock serializes state saves and protects
+ * the journal variables and every job's state_save_hash, except that
+ * _list_delete_job() tests job_journal_enable without it.
+ */
+static pthread_mutex_t job_journal_lock = PTHREAD_MUTEX_INITIALIZER;
+static time_t   job_journal_base = 0;	/* time of the job_state file that
+					 * job hashes match, 0 if none */
+static uint32_t job_journal_base_size = 0;	/* size of that job_state */
+static time_t   job_journal_conf_update = 0;
+static bool     job_journal_enable = false;
+static uint32_t job_journal_size = 0;	/* bytes in job_state.journal */
+
+static pthread_mutex_t job_journal_del_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t *job_journal_del_ids = NULL;	/* jobs purged since the
+						 * last state save */
+static int      job_journal_del_cnt = 0;
+static int      job_journal_del_size = 0;
+
+static pthread_mutex_t job_pack_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool     job_pack_track = false;	/* SHOW_DELTA requested since start */
+static time_t   job_pack_cache_conf_update = 0;
+static bool     job_pack_cache_enable = false;
+
 /* Local functions */
 static void _add_job_hash(job_record_t *job_ptr);
 static void _add_job_array_hash(job_record_t *job_ptr);
@@ -226,11 +313,14 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 static void _pack_pending_job_details(struct job_details *detail_ptr,
 				      buf_t *buffer, uint16_t protocol_version);
 static bool _parse_array_tok(char *tok, bitstr_t *array_bitmap, uint32_t max);
+static void _purge_missing_job(job_record_t *job_ptr, int node_inx,
+			       time_t now);
 static void _purge_missing_jobs(int node_inx, time_t now);
 static int  _read_data_array_from_file(int fd, char *file_name, char ***data,
 				       uint32_t *size, job_record_t *job_ptr);
 static void _remove_defunct_batch_dirs(List batch_dirs);
-static void _remove_job_hash(job_record_t *job_ptr, job_hash_type_t type);
+static void _remove_job_array_hash(job_record_t *job_ptr);
+static void _remove_job_hash(job_record_t *job_ptr);
 static int  _reset_detail_bitmaps(job_record_t *job_ptr);
 static void _reset_step_bitmaps(job_record_t *job_ptr);
 static void _resp_array_add(resp_array_struct_t **resp, job_record_t *job_ptr,
@@ -264,8 +354,8 @@ static bool _validate_min_mem_partition(job_desc_msg_t *job_desc_msg,
 					List part_list);
 static bool _valid_pn_min_mem(job_desc_msg_t * job_desc_msg,
 			      part_record_t *part_ptr);
-static int  _write_data_array_to_file(char *file_name, char **data,
-				      uint32_t size);
+static int  _write_blob_file(char *file_name, const char *data, size_t len,
+			     mode_t mode);
 
 static char *_get_mail_user(const char *user_name, uid_t user_id)
 {
@@ -620,6 +710,7 @@ static job_record_t *_create_job_record(uint32_t num_jobs)
 			       * hasn't been set yet  */
 	job_ptr->billable_tres = (double)NO_VAL;
 	(void) list_append(job_list, job_ptr);
+	slurm_preempt_reset_candidates();
 
 	return job_ptr;
 }
@@ -682,6 +773,77 @@ static void _delete_job_details(job_record_t *job_entry)
 	xfree(job_entry->details);	/* Must be last */
 }
 
+/*
+ * Batch scripts and environments are frequently identical across the jobs
+ * of a workflow. Each distinct content is written once as
+ * "hash.#/blob.<fnv1a>.<length>" and the job's own file is made a hard
+ * link to it. A blob whose link count drops to one is no longer referenced
+ * by any job and is removed.
+ */
+static uint64_t _blob_hash(const char *data, size_t len)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	size_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
+static char *_blob_path(const char *data, size_t len)
+{
+	uint64_t hash = _blob_hash(data, len);
+
+	return xstrdup_printf("%s/hash.%d/blob.%016"PRIx64".%zu",
+			      slurm_conf.state_save_location,
+			      (int) (hash % 10), hash, len);
+}
+
+/* Return true if the file exists and contains exactly the given data */
+static bool _blob_match(char *blob_name, const char *data, size_t len)
+{
+	buf_t *buffer;
+	bool match;
+
+	if (!(buffer = create_mmap_buf(blob_name)))
+		return false;
+	match = ((size_buf(buffer) == len) &&
+		 !memcmp(get_buf_data(buffer), data, len));
+	free_buf(buffer);
+
+	return match;
+}
+
+/*
+ * Unlink a job's script or environment file, removing the blob it links to
+ * once no other job references it.
+ */
+static void _unlink_blob_file(char *file_name)
+{
+	struct stat file_stat, blob_stat;
+	buf_t *buffer;
+	char *blob_name = NULL;
+
+	if (!stat(file_name, &file_stat) && (file_stat.st_nlink > 1) &&
+	    (buffer = create_mmap_buf(file_name))) {
+		blob_name = _blob_path(get_buf_data(buffer),
+				       size_buf(buffer));
+		free_buf(buffer);
+	}
+
+	(void) unlink(file_name);
+
+	if (blob_name && !stat(blob_name, &blob_stat) &&
+	    (blob_stat.st_ino == file_stat.st_ino) &&
+	    (blob_stat.st_dev == file_stat.st_dev) &&
+	    (blob_stat.st_nlink == 1))
+		(void) unlink(blob_name);
+	xfree(blob_name);
+}
+
 /*
  * delete_job_desc_files - delete job descriptor related files
  *
@@ -712,7 +874,7 @@ extern void delete_job_desc_files(uint32_t job_id)
 				continue;
 			xstrfmtcat(file_name, "%s/%s", dir_name,
 				   dir_ent->d_name);
-			(void) unlink(file_name);
+			_unlink_blob_file(file_name);
 			xfree(file_name);
 		}
 		closedir(f_dir);
@@ -796,6 +958,175 @@ static slurmdb_qos_rec_t *_determine_and_validate_qos(
 	return qos_ptr;
 }
 
+/*
+ * Parse SlurmctldParameters=job_state_journal
+ * NOTE: Call with a read lock on the slurmctld configuration
+ */
+static bool _job_state_journal_enabled(void)
+{
+	if (job_journal_conf_update != slurm_conf.last_update) {
+		job_journal_enable = (xstrcasestr(slurm_conf.slurmctld_params,
+						  "job_state_journal") != NULL);
+		job_journal_conf_update = slurm_conf.last_update;
+	}
+
+	return job_journal_enable;
+}
+
+/* Record a purged job for the next job state journal batch */
+static void _job_state_journal_del_add(uint32_t job_id)
+{
+	slurm_mutex_lock(&job_journal_del_lock);
+	if (job_journal_del_cnt >= job_journal_del_size) {
+		job_journal_del_size = MAX(1024, job_journal_del_size * 2);
+		xrecalloc(job_journal_del_ids, job_journal_del_size,
+			  sizeof(uint32_t));
+	}
+	job_journal_del_ids[job_journal_del_cnt++] = job_id;
+	slurm_mutex_unlock(&job_journal_del_lock);
+}
+
+static void _job_state_journal_del_clear(void)
+{
+	slurm_mutex_lock(&job_journal_del_lock);
+	job_journal_del_cnt = 0;
+	slurm_mutex_unlock(&job_journal_del_lock);
+}
+
+/* FNV-1a hash of a job's saved state record, never zero */
+static uint32_t _job_state_hash(buf_t *buffer, uint32_t offset)
+{
+	unsigned char *data = (unsigned char *) get_buf_data(buffer);
+	uint32_t i, end = get_buf_offset(buffer), hash = 2166136261U;
+
+	for (i = offset; i < end; i++) {
+		hash ^= data[i];
+		hash *= 16777619U;
+	}
+
+	return hash ? hash : 1;
+}
+
+/*
+ * Pack one job state journal batch: the jobs purged and the jobs whose saved
+ * state record changed since the last state save. A new journal also gets a
+ * header naming the job_state file it applies to.
+ * RET buffer to write and free or NULL if no job changed
+ * NOTE: Call with job_journal_lock and a read lock on jobs
+ */
+static buf_t *_pack_job_state_journal(time_t now)
+{
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+	buf_t *buffer = init_buf(BUF_SIZE);
+	uint32_t batch_offset, cnt_offset, end_offset, upd_cnt = 0;
+	int i, del_cnt;
+
+	if (!job_journal_size) {
+		packstr(JOB_STATE_VERSION, buffer);
+		pack16(SLURM_PROTOCOL_VERSION, buffer);
+		pack_time(job_journal_base, buffer);
+	}
+
+	pack32(JOB_JOURNAL_MAGIC, buffer);
+	batch_offset = get_buf_offset(buffer);
+	pack32(0, buffer);		/* batch size, filled in below */
+	pack_time(now, buffer);
+	pack32(job_id_sequence, buffer);
+
+	slurm_mutex_lock(&job_journal_del_lock);
+	del_cnt = job_journal_del_cnt;
+	pack32(del_cnt, buffer);
+	for (i = 0; i < del_cnt; i++)
+		pack32(job_journal_del_ids[i], buffer);
+	job_journal_del_cnt = 0;
+	slurm_mutex_unlock(&job_journal_del_lock);
+
+	cnt_offset = get_buf_offset(buffer);
+	pack32(0, buffer);		/* changed job count, filled in below */
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		uint32_t job_offset = get_buf_offset(buffer), hash;
+		pack32(job_ptr->job_id, buffer);
+		_dump_job_state(job_ptr, buffer);
+		hash = _job_state_hash(buffer, job_offset + 4);
+		if (hash == job_ptr->state_save_hash) {
+			set_buf_offset(buffer, job_offset);
+			continue;
+		}
+		job_ptr->state_save_hash = hash;
+		upd_cnt++;
+	}
+	list_iterator_destroy(job_iterator);
+
+	if (!del_cnt && !upd_cnt) {
+		free_buf(buffer);
+		return NULL;
+	}
+
+	end_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, batch_offset);
+	pack32(end_offset - batch_offset - 4, buffer);
+	set_buf_offset(buffer, cnt_offset);
+	pack32(upd_cnt, buffer);
+	set_buf_offset(buffer, end_offset);
+	debug3("%s: %d purged and %u changed jobs", __func__, del_cnt, upd_cnt);
+
+	return buffer;
+}
+
+/*
+ * Append a batch from _pack_job_state_journal() to job_state.journal.
+ * On failure the next state save is a full one.
+ * NOTE: Call with job_journal_lock
+ */
+static int _write_job_state_journal(buf_t *buffer)
+{
+	int error_code = SLURM_SUCCESS, log_fd, flags;
+	int pos = 0, nwrite, amount, rc;
+	char *data, *journal_file;
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+	flags = O_CREAT | O_WRONLY | O_CLOEXEC;
+	flags |= job_journal_size ? O_APPEND : O_TRUNC;
+
+	lock_state_files();
+	log_fd = open(journal_file, flags, 0600);
+	if (log_fd < 0) {
+		error("Can't save state, create file %s error %m",
+		      journal_file);
+		error_code = errno;
+	} else {
+		nwrite = get_buf_offset(buffer);
+		data = (char *)get_buf_data(buffer);
+		while (nwrite > 0) {
+			amount = write(log_fd, &data[pos], nwrite);
+			if ((amount < 0) && (errno != EINTR)) {
+				error("Error writing file %s, %m",
+				      journal_file);
+				error_code = errno;
+				break;
+			}
+			nwrite -= amount;
+			pos    += amount;
+		}
+
+		rc = fsync_and_close(log_fd, "job journal");
+		if (rc && !error_code)
+			error_code = rc;
+	}
+	unlock_state_files();
+
+	if (error_code)
+		job_journal_base = 0;
+	else
+		job_journal_size += get_buf_offset(buffer);
+	xfree(journal_file);
+
+	return error_code;
+}
+
 /*
  * dump_all_job_state - save the state of all jobs to file for checkpoint
  *	Changes here should be reflected in load_last_job_id() and
@@ -807,7 +1138,8 @@ int dump_all_job_state(void)
 	/* Save high-water mark to avoid buffer growth with copies */
 	static int high_buffer_size = (1024 * 1024);
 	int error_code = SLURM_SUCCESS, log_fd;
-	char *old_file, *new_file, *reg_file;
+	char *old_file, *new_file, *reg_file, *journal_file;
+	bool journal;
 	struct stat stat_buf;
 	/* Locks: Read config and job */
 	slurmctld_lock_t job_read_lock =
@@ -817,6 +1149,7 @@ int dump_all_job_state(void)
 	buf_t *buffer = init_buf(high_buffer_size);
 	time_t now = time(NULL);
 	time_t last_state_file_time;
+	uint32_t cnt_offset, end_offset, job_cnt = 0;
 	DEF_TIMERS;
 
 	START_TIMER;
@@ -855,13 +1188,55 @@ int dump_all_job_state(void)
 	       job_id_sequence);
 
 	/* write individual job records */
+	slurm_mutex_lock(&job_journal_lock);
 	lock_slurmctld(job_read_lock);
+	journal = _job_state_journal_enabled();
+	if (journal && job_journal_base &&
+	    (job_journal_base == last_file_write_time) &&
+	    (job_journal_size < MAX(job_journal_base_size,
+				    JOB_JOURNAL_MIN_SIZE))) {
+		buf_t *journal_buf = _pack_job_state_journal(now);
+		unlock_slurmctld(job_read_lock);
+		if (journal_buf) {
+			error_code = _write_job_state_journal(journal_buf);
+			free_buf(journal_buf);
+		}
+		slurm_mutex_unlock(&job_journal_lock);
+		free_buf(buffer);
+		END_TIMER2("dump_all_job_state");
+		return error_code;
+	}
+
 	pack_time(slurmctld_diag_stats.bf_when_last_cycle, buffer);
+
+	/*
+	 * Each job record is preceded by its size so that a damaged record
+	 * can be skipped when loading the file.
+	 */
+	cnt_offset = get_buf_offset(buffer);
+	pack32(0, buffer);		/* job record count, filled in below */
 	job_iterator = list_iterator_create(job_list);
 	while ((job_ptr = list_next(job_iterator))) {
+		uint32_t offset = get_buf_offset(buffer);
+		pack32(0, buffer);	/* record size, filled in below */
 		_dump_job_state(job_ptr, buffer);
+		end_offset = get_buf_offset(buffer);
+		set_buf_offset(buffer, offset);
+		pack32(end_offset - offset - 4, buffer);
+		set_buf_offset(buffer, end_offset);
+		if (journal)
+			job_ptr->state_save_hash =
+				_job_state_hash(buffer, offset + 4);
+		job_cnt++;
 	}
 	list_iterator_destroy(job_iterator);
+	end_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, cnt_offset);
+	pack32(job_cnt, buffer);
+	set_buf_offset(buffer, end_offset);
+	/* This save covers every purged job, start over with the journal */
+	_job_state_journal_del_clear();
+	job_journal_base = 0;
 
 
 	/* write the buffer to file */
@@ -871,6 +1246,8 @@ int dump_all_job_state(void)
 	xstrcat(reg_file, "/job_state");
 	new_file = xstrdup(slurm_conf.state_save_location);
 	xstrcat(new_file, "/job_state.new");
+	journal_file = xstrdup(slurm_conf.state_save_location);
+	xstrcat(journal_file, "/job_state.journal");
 	unlock_slurmctld(job_read_lock);
 
 	if (stat(reg_file, &stat_buf) == 0) {
@@ -928,12 +1305,20 @@ int dump_all_job_state(void)
 			debug4("unable to create link for %s -> %s: %m",
 			       new_file, reg_file);
 		(void) unlink(new_file);
+		(void) unlink(journal_file);
 		last_file_write_time = now;
+		job_journal_size = 0;
+		if (journal) {
+			job_journal_base = now;
+			job_journal_base_size = get_buf_offset(buffer);
+		}
 	}
 	xfree(old_file);
 	xfree(reg_file);
 	xfree(new_file);
+	xfree(journal_file);
 	unlock_state_files();
+	slurm_mutex_unlock(&job_journal_lock);
 
 	free_buf(buffer);
 	END_TIMER2("dump_all_job_state");
@@ -1141,6 +1526,97 @@ unpack_error:
 	return buf_time;
 }
 
+/*
+ * Replay job_state.journal on top of the job_state file just loaded. Batches
+ * are applied in order until the end of the file or a batch which was not
+ * completely written.
+ * IN base_time - time stamp in the header of the job_state file loaded
+ * RET 0 or error code
+ */
+static int _load_job_state_journal(time_t base_time)
+{
+	int error_code = SLURM_SUCCESS, batch_cnt = 0;
+	char *journal_file, *ver_str = NULL;
+	uint32_t ver_str_len, magic, size, batch_end, saved_job_id;
+	uint32_t i, del_cnt, upd_cnt, job_id, job_cnt = 0;
+	uint16_t protocol_version = NO_VAL16;
+	time_t journal_time = 0, batch_time;
+	buf_t *buffer;
+
+	journal_file = xstrdup_printf("%s/job_state.journal",
+				      slurm_conf.state_save_location);
+	lock_state_files();
+	buffer = create_mmap_buf(journal_file);
+	unlock_state_files();
+	if (!buffer) {
+		xfree(journal_file);
+		return SLURM_SUCCESS;
+	}
+
+	safe_unpackstr_xmalloc(&ver_str, &ver_str_len, buffer);
+	if (ver_str && !xstrcmp(ver_str, JOB_STATE_VERSION))
+		safe_unpack16(&protocol_version, buffer);
+	xfree(ver_str);
+	if (protocol_version != NO_VAL16)
+		safe_unpack_time(&journal_time, buffer);
+	if ((protocol_version == NO_VAL16) || (journal_time != base_time)) {
+		info("Ignoring job state journal %s, it does not match the job state file",
+		     journal_file);
+		goto fini;
+	}
+
+	while (remaining_buf(buffer) > 0) {
+		safe_unpack32(&magic, buffer);
+		safe_unpack32(&size, buffer);
+		if ((magic != JOB_JOURNAL_MAGIC) ||
+		    (remaining_buf(buffer) < size)) {
+			error("Job state journal %s is truncated after %d batches",
+			      journal_file, batch_cnt);
+			break;
+		}
+		batch_end = get_buf_offset(buffer) + size;
+
+		safe_unpack_time(&batch_time, buffer);
+		safe_unpack32(&saved_job_id, buffer);
+		if (saved_job_id <= slurm_conf.max_job_id)
+			job_id_sequence = MAX(saved_job_id, job_id_sequence);
+
+		safe_unpack32(&del_cnt, buffer);
+		for (i = 0; i < del_cnt; i++) {
+			safe_unpack32(&job_id, buffer);
+			(void) purge_job_record(job_id);
+		}
+
+		safe_unpack32(&upd_cnt, buffer);
+		for (i = 0; i < upd_cnt; i++) {
+			safe_unpack32(&job_id, buffer);
+			(void) purge_job_record(job_id);
+			error_code = _load_job_state(buffer, protocol_version);
+			if (error_code != SLURM_SUCCESS)
+				goto unpack_error;
+		}
+		if (get_buf_offset(buffer) != batch_end)
+			goto unpack_error;
+		job_cnt += upd_cnt + del_cnt;
+		batch_cnt++;
+	}
+	info("Recovered %u job changes from %d job state journal batches",
+	     job_cnt, batch_cnt);
+
+fini:
+	xfree(journal_file);
+	free_buf(buffer);
+	return error_code;
+
+unpack_error:
+	if (!ignore_state_errors)
+		fatal("Incomplete job state journal, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.");
+	error("Incomplete job state journal %s", journal_file);
+	xfree(journal_file);
+	free_buf(buffer);
+	return SLURM_ERROR;
+}
+
 /*
  * load_all_job_state - load the job state from file, recover from last
  *	checkpoint. Execute this after loading the configuration file data.
@@ -1150,11 +1626,11 @@ unpack_error:
 extern int load_all_job_state(void)
 {
 	int error_code = SLURM_SUCCESS;
-	int job_cnt = 0;
+	int job_cnt = 0, bad_cnt = 0;
 	char *state_file = NULL;
 	buf_t *buffer;
-	time_t buf_time;
-	uint32_t saved_job_id;
+	time_t buf_time, state_time;
+	uint32_t saved_job_id, rec_cnt = NO_VAL, rec_size, rec_end;
 	char *ver_str = NULL;
 	uint32_t ver_str_len;
 	uint16_t protocol_version = NO_VAL16;
@@ -1188,7 +1664,7 @@ extern int load_all_job_state(void)
 		return EFAULT;
 	}
 
-	safe_unpack_time(&buf_time, buffer);
+	safe_unpack_time(&state_time, buffer);
 	safe_unpack32(&saved_job_id, buffer);
 	if (saved_job_id <= slurm_conf.max_job_id)
 		job_id_sequence = MAX(saved_job_id, job_id_sequence);
@@ -1205,16 +1681,52 @@ extern int load_all_job_state(void)
 	 * It ended up being much easier to move the locks for the assoc_mgr
 	 * into the _load_job_state function than any other option.
 	 */
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+		safe_unpack32(&rec_cnt, buffer);
 	while (remaining_buf(buffer) > 0) {
-		error_code = _load_job_state(buffer, protocol_version);
-		if (error_code != SLURM_SUCCESS)
+		if (rec_cnt == NO_VAL) {
+			error_code = _load_job_state(buffer, protocol_version);
+			if (error_code != SLURM_SUCCESS)
+				goto unpack_error;
+			job_cnt++;
+			continue;
+		}
+
+		safe_unpack32(&rec_size, buffer);
+		if (rec_size > remaining_buf(buffer))
 			goto unpack_error;
+		rec_end = get_buf_offset(buffer) + rec_size;
+		error_code = _load_job_state(buffer, protocol_version);
+		if ((error_code == SLURM_SUCCESS) &&
+		    (get_buf_offset(buffer) != rec_end)) {
+			error("Job state record size mismatch");
+			error_code = SLURM_ERROR;
+		}
+		if (error_code != SLURM_SUCCESS) {
+			if (!ignore_state_errors)
+				goto unpack_error;
+			/* Record boundary is known, go on to the next job */
+			set_buf_offset(buffer, rec_end);
+			bad_cnt++;
+			continue;
+		}
 		job_cnt++;
 	}
-	debug3("Set job_id_sequence to %u", job_id_sequence);
-
 	free_buf(buffer);
+	if ((rec_cnt != NO_VAL) && (rec_cnt != (job_cnt + bad_cnt))) {
+		if (!ignore_state_errors)
+			fatal("Incomplete job state save file, found %d of %u jobs, start with '-i' to ignore this. Warning: using -i will lose the data that can't be recovered.",
+			      job_cnt + bad_cnt, rec_cnt);
+		error("Incomplete job state save file, found %d of %u jobs",
+		      job_cnt + bad_cnt, rec_cnt);
+	}
+	if (bad_cnt)
+		error("Could not recover information about %d jobs", bad_cnt);
 	info("Recovered information about %d jobs", job_cnt);
+
+	error_code = _load_job_state_journal(state_time);
+	debug3("Set job_id_sequence to %u", job_id_sequence);
+
 	return error_code;
 
 unpack_error:
@@ -2614,6 +3126,8 @@ static int _load_job_state(buf_t *buffer, uint16_t protocol_version)
 	assoc_mgr_unlock(&locks);
 
 	build_node_details(job_ptr, false);	/* set node_addr */
+	if (IS_JOB_COMPLETED(job_ptr) && !IS_JOB_COMPLETING(job_ptr))
+		xfree(job_ptr->node_addr);	/* see cleanup_completing() */
 	gres_ctld_job_build_details(job_ptr->gres_list_alloc,
 				    &job_ptr->gres_detail_cnt,
 				    &job_ptr->gres_detail_str,
@@ -3098,6 +3612,93 @@ unpack_error:
 	return SLURM_ERROR;
 }
 
+/* Size job hash table to hold at least min_cnt records, dropping removed
+ * slots */
+static void _job_hash_resize(job_hash_table_t *table, uint32_t min_cnt)
+{
+	job_hash_slot_t *old_slots = table->slots;
+	uint32_t i, inx, old_size = table->size;
+	uint32_t bits = JOB_HASH_MIN_BITS;
+
+	/* Keep the load factor at or below 50% */
+	while (((1U << bits) / 2) < min_cnt)
+		bits++;
+
+	table->size = 1U << bits;
+	table->shift = 32 - bits;
+	table->slots = xcalloc(table->size, sizeof(job_hash_slot_t));
+	table->used = table->cnt;
+
+	for (i = 0; i < old_size; i++) {
+		if (!old_slots[i].ptr || (old_slots[i].ptr == JOB_HASH_DELETED))
+			continue;
+		inx = JOB_HASH_INX(old_slots[i].key, table);
+		while (table->slots[inx].ptr)
+			inx = (inx + 1) & (table->size - 1);
+		table->slots[inx] = old_slots[i];
+	}
+	xfree(old_slots);
+}
+
+/* Return the first record with the given key in a job hash table */
+static void *_job_hash_find(job_hash_table_t *table, uint32_t key)
+{
+	uint32_t inx;
+
+	if (!table->size)
+		return NULL;
+
+	inx = JOB_HASH_INX(key, table);
+	while (table->slots[inx].ptr) {
+		if ((table->slots[inx].key == key) &&
+		    (table->slots[inx].ptr != JOB_HASH_DELETED))
+			return table->slots[inx].ptr;
+		inx = (inx + 1) & (table->size - 1);
+	}
+
+	return NULL;
+}
+
+static void _job_hash_insert(job_hash_table_t *table, uint32_t key, void *ptr)
+{
+	uint32_t inx;
+
+	if (((table->used + 1) * 2) > table->size)
+		_job_hash_resize(table, (table->cnt + 1) * 2);
+
+	inx = JOB_HASH_INX(key, table);
+	while (table->slots[inx].ptr &&
+	       (table->slots[inx].ptr != JOB_HASH_DELETED))
+		inx = (inx + 1) & (table->size - 1);
+	if (!table->slots[inx].ptr)
+		table->used++;
+	table->slots[inx].key = key;
+	table->slots[inx].ptr = ptr;
+	table->cnt++;
+}
+
+/* Remove a specific record from a job hash table, return false if not found */
+static bool _job_hash_remove(job_hash_table_t *table, uint32_t key, void *ptr)
+{
+	uint32_t inx;
+
+	if (!table->size)
+		return false;
+
+	inx = JOB_HASH_INX(key, table);
+	while (table->slots[inx].ptr) {
+		if ((table->slots[inx].key == key) &&
+		    (table->slots[inx].ptr == ptr)) {
+			table->slots[inx].ptr = JOB_HASH_DELETED;
+			table->cnt--;
+			return true;
+		}
+		inx = (inx + 1) & (table->size - 1);
+	}
+
+	return false;
+}
+
 /* _add_job_hash - add a job hash entry for given job record, job_id must
  *	already be set
  * IN job_ptr - pointer to job record
@@ -3105,96 +3706,35 @@ unpack_error:
  */
 static void _add_job_hash(job_record_t *job_ptr)
 {
-	int inx;
-
-	inx = JOB_HASH_INX(job_ptr->job_id);
-	job_ptr->job_next = job_hash[inx];
-	job_hash[inx] = job_ptr;
+	_job_hash_insert(&job_hash, job_ptr->job_id, job_ptr);
 }
 
 /* _remove_job_hash - remove a job hash entry for given job record, job_id must
  *	already be set
  * IN job_ptr - pointer to job record
- * IN type - which hash to work with
  * Globals: hash table updated
  */
-static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
+static void _remove_job_hash(job_record_t *job_entry)
 {
-	job_record_t *job_ptr, **job_pptr;
-
 	xassert(job_entry);
 
-	switch (type) {
-	case JOB_HASH_JOB:
-		job_pptr = &job_hash[JOB_HASH_INX(job_entry->job_id)];
-		break;
-	case JOB_HASH_ARRAY_JOB:
-		job_pptr = &job_array_hash_j[
-			JOB_HASH_INX(job_entry->array_job_id)];
-		break;
-	case JOB_HASH_ARRAY_TASK:
-		job_pptr = &job_array_hash_t[
-			JOB_ARRAY_HASH_INX(job_entry->array_job_id,
-					   job_entry->array_task_id)];
-		break;
-	default:
-		fatal("%s: unknown job_hash_type_t %d", __func__, type);
+	if (_job_hash_remove(&job_hash, job_entry->job_id, job_entry) ||
+	    (job_entry->job_id == NO_VAL))
 		return;
-	}
-
-	while ((job_pptr != NULL) && (*job_pptr != NULL) &&
-	       ((job_ptr = *job_pptr) != job_entry)) {
-		xassert(job_ptr->magic == JOB_MAGIC);
-		switch (type) {
-		case JOB_HASH_JOB:
-			job_pptr = &job_ptr->job_next;
-			break;
-		case JOB_HASH_ARRAY_JOB:
-			job_pptr = &job_ptr->job_array_next_j;
-			break;
-		case JOB_HASH_ARRAY_TASK:
-			job_pptr = &job_ptr->job_array_next_t;
-			break;
-		}
-	}
 
-	if (job_pptr == NULL || *job_pptr == NULL) {
-		if (job_entry->job_id == NO_VAL)
-			return;
+	error("%s: Could not find hash entry for JobId=%u",
+	      __func__, job_entry->job_id);
+}
 
-		switch (type) {
-		case JOB_HASH_JOB:
-			error("%s: Could not find hash entry for JobId=%u",
-			      __func__, job_entry->job_id);
-			break;
-		case JOB_HASH_ARRAY_JOB:
-			error("%s: job array hash error %u", __func__,
-			      job_entry->array_job_id);
-			break;
-		case JOB_HASH_ARRAY_TASK:
-			error("%s: job array, task ID hash error %u_%u",
-			      __func__,
-			      job_entry->array_job_id,
-			      job_entry->array_task_id);
-			break;
-		}
-		return;
-	}
+/* Return the record of a job array task, NULL if not found */
+static job_record_t *_array_task_find(job_array_index_t *array_index,
+				      uint32_t task_id)
+{
+	if ((task_id < array_index->task_size) &&
+	    array_index->task_recs[task_id])
+		return array_index->task_recs[task_id];
 
-	switch (type) {
-	case JOB_HASH_JOB:
-		*job_pptr = job_entry->job_next;
-		job_entry->job_next = NULL;
-		break;
-	case JOB_HASH_ARRAY_JOB:
-		*job_pptr = job_entry->job_array_next_j;
-		job_entry->job_array_next_j = NULL;
-		break;
-	case JOB_HASH_ARRAY_TASK:
-		*job_pptr = job_entry->job_array_next_t;
-		job_entry->job_array_next_t = NULL;
-		break;
-	}
+	return _job_hash_find(&array_index->task_hash, task_id);
 }
 
 /* _add_job_array_hash - add a job hash entry for given job record,
@@ -3204,18 +3744,104 @@ static void _remove_job_hash(job_record_t *job_entry, job_hash_type_t type)
  */
 void _add_job_array_hash(job_record_t *job_ptr)
 {
-	int inx;
+	job_array_index_t *array_index;
+	uint32_t task_id = job_ptr->array_task_id;
 
-	if (job_ptr->array_task_id == NO_VAL)
+	if (task_id == NO_VAL)
 		return;	/* Not a job array */
 
-	inx = JOB_HASH_INX(job_ptr->array_job_id);
-	job_ptr->job_array_next_j = job_array_hash_j[inx];
-	job_array_hash_j[inx] = job_ptr;
+	if (!(array_index = _job_hash_find(&job_array_hash,
+					   job_ptr->array_job_id))) {
+		array_index = xmalloc(sizeof(*array_index));
+		array_index->array_job_id = job_ptr->array_job_id;
+		_job_hash_insert(&job_array_hash, job_ptr->array_job_id,
+				 array_index);
+	}
+	if (_array_task_find(array_index, task_id)) {
+		error("%s: duplicate job array record %u_%u",
+		      __func__, job_ptr->array_job_id, task_id);
+		return;
+	}
+	array_index->task_cnt++;
+
+	if ((task_id >= array_index->task_size) &&
+	    (task_id < slurm_conf.max_array_sz)) {
+		array_index->task_size = MIN(MAX(task_id + 1,
+						 array_index->task_size * 2),
+					     slurm_conf.max_array_sz);
+		xrecalloc(array_index->task_recs, array_index->task_size,
+			  sizeof(job_record_t *));
+	}
+	if (task_id < array_index->task_size)
+		array_index->task_recs[task_id] = job_ptr;
+	else
+		_job_hash_insert(&array_index->task_hash, task_id, job_ptr);
+}
+
+/* _remove_job_array_hash - remove the job array hash entry for given job
+ *	record, array_job_id and array_task_id must already be set
+ * IN job_ptr - pointer to job record
+ * Globals: hash table updated
+ */
+static void _remove_job_array_hash(job_record_t *job_ptr)
+{
+	job_array_index_t *array_index;
+	uint32_t task_id = job_ptr->array_task_id;
+
+	array_index = _job_hash_find(&job_array_hash, job_ptr->array_job_id);
+	if (array_index && (task_id < array_index->task_size) &&
+	    (array_index->task_recs[task_id] == job_ptr)) {
+		array_index->task_recs[task_id] = NULL;
+	} else if (!array_index ||
+		   !_job_hash_remove(&array_index->task_hash, task_id,
+				     job_ptr)) {
+		if (job_ptr->job_id != NO_VAL) {
+			error("%s: job array, task ID hash error %u_%u",
+			      __func__, job_ptr->array_job_id, task_id);
+		}
+		return;
+	}
+
+	if (--array_index->task_cnt)
+		return;
+
+	_job_hash_remove(&job_array_hash, array_index->array_job_id,
+			 array_index);
+	xfree(array_index->task_hash.slots);
+	xfree(array_index->task_recs);
+	xfree(array_index);
+}
+
+/*
+ * Return the next task record of a job array, starting from index *inx.
+ * Tasks in the dense table are returned in order of array_task_id, followed
+ * by those in task_hash.
+ * IN array_index - job array's task index, may be NULL
+ * IN/OUT inx - search start index, set to follow the returned record
+ */
+static job_record_t *_next_array_task(job_array_index_t *array_index,
+				      uint32_t *inx)
+{
+	job_hash_slot_t *slot;
+	job_record_t *job_ptr;
+
+	if (!array_index)
+		return NULL;
+
+	while (*inx < array_index->task_size) {
+		job_ptr = array_index->task_recs[(*inx)++];
+		if (job_ptr)
+			return job_ptr;
+	}
+	while (*inx < (array_index->task_size +
+		       array_index->task_hash.size)) {
+		slot = &array_index->task_hash.slots[(*inx)++ -
+						     array_index->task_size];
+		if (slot->ptr && (slot->ptr != JOB_HASH_DELETED))
+			return slot->ptr;
+	}
 
-	inx = JOB_ARRAY_HASH_INX(job_ptr->array_job_id,job_ptr->array_task_id);
-	job_ptr->job_array_next_t = job_array_hash_t[inx];
-	job_array_hash_t[inx] = job_ptr;
+	return NULL;
 }
 
 /* For the job array data structure, build the string representation of the
@@ -3259,7 +3885,8 @@ extern void build_array_str(job_record_t *job_ptr)
 extern bool test_job_array_complete(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3270,14 +3897,10 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (!IS_JOB_COMPLETE(job_ptr))
-				return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
+	array_index = _job_hash_find(&job_array_hash, array_job_id);
+	while ((job_ptr = _next_array_task(array_index, &inx))) {
+		if (!IS_JOB_COMPLETE(job_ptr))
+			return false;
 	}
 	return true;
 }
@@ -3286,7 +3909,8 @@ extern bool test_job_array_complete(uint32_t array_job_id)
 extern bool test_job_array_completed(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3295,14 +3919,10 @@ extern bool test_job_array_completed(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (!IS_JOB_COMPLETED(job_ptr))
-				return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
+	array_index = _job_hash_find(&job_array_hash, array_job_id);
+	while ((job_ptr = _next_array_task(array_index, &inx))) {
+		if (!IS_JOB_COMPLETED(job_ptr))
+			return false;
 	}
 	return true;
 }
@@ -3314,7 +3934,8 @@ extern bool test_job_array_completed(uint32_t array_job_id)
 extern bool _test_job_array_purged(uint32_t array_job_id)
 {
 	job_record_t *job_ptr, *head_job_ptr;
-	int inx;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 
 	head_job_ptr = find_job_record(array_job_id);
 	if (head_job_ptr) {
@@ -3323,14 +3944,10 @@ extern bool _test_job_array_purged(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if ((job_ptr->array_job_id == array_job_id) &&
-		    (job_ptr != head_job_ptr)) {
+	array_index = _job_hash_find(&job_array_hash, array_job_id);
+	while ((job_ptr = _next_array_task(array_index, &inx))) {
+		if (job_ptr != head_job_ptr)
 			return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
 	}
 	return true;
 }
@@ -3339,7 +3956,8 @@ extern bool _test_job_array_purged(uint32_t array_job_id)
 extern bool test_job_array_finished(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3348,14 +3966,10 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (!IS_JOB_FINISHED(job_ptr))
-				return false;
-		}
-		job_ptr = job_ptr->job_array_next_j;
+	array_index = _job_hash_find(&job_array_hash, array_job_id);
+	while ((job_ptr = _next_array_task(array_index, &inx))) {
+		if (!IS_JOB_FINISHED(job_ptr))
+			return false;
 	}
 
 	return true;
@@ -3365,7 +3979,8 @@ extern bool test_job_array_finished(uint32_t array_job_id)
 extern bool test_job_array_pending(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int inx;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 
 	job_ptr = find_job_record(array_job_id);
 	if (job_ptr) {
@@ -3376,14 +3991,10 @@ extern bool test_job_array_pending(uint32_t array_job_id)
 	}
 
 	/* Need to test individual job array records */
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if (job_ptr->array_job_id == array_job_id) {
-			if (IS_JOB_PENDING(job_ptr))
-				return true;
-		}
-		job_ptr = job_ptr->job_array_next_j;
+	array_index = _job_hash_find(&job_array_hash, array_job_id);
+	while ((job_ptr = _next_array_task(array_index, &inx))) {
+		if (IS_JOB_PENDING(job_ptr))
+			return true;
 	}
 	return false;
 }
@@ -3393,15 +4004,14 @@ extern bool test_job_array_pending(uint32_t array_job_id)
 extern int num_pending_job_array_tasks(uint32_t array_job_id)
 {
 	job_record_t *job_ptr;
-	int count = 0, inx;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
+	int count = 0;
 
-	inx = JOB_HASH_INX(array_job_id);
-	job_ptr = job_array_hash_j[inx];
-	while (job_ptr) {
-		if ((job_ptr->array_job_id == array_job_id) &&
-		    IS_JOB_PENDING(job_ptr))
+	array_index = _job_hash_find(&job_array_hash, array_job_id);
+	while ((job_ptr = _next_array_task(array_index, &inx))) {
+		if (IS_JOB_PENDING(job_ptr))
 			count++;
-		job_ptr = job_ptr->job_array_next_j;
 	}
 
 	return count;
@@ -3420,7 +4030,8 @@ extern job_record_t *find_job_array_rec(uint32_t array_job_id,
 					uint32_t array_task_id)
 {
 	job_record_t *job_ptr, *match_job_ptr = NULL;
-	int inx;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 
 	if (array_task_id == NO_VAL)
 		return find_job_record(array_job_id);
@@ -3432,28 +4043,19 @@ extern job_record_t *find_job_array_rec(uint32_t array_job_id,
 		    (job_ptr->array_job_id == array_job_id))
 			return job_ptr;
 
-		inx = JOB_HASH_INX(array_job_id);
-		job_ptr = job_array_hash_j[inx];
-		while (job_ptr) {
-			if (job_ptr->array_job_id == array_job_id) {
-				match_job_ptr = job_ptr;
-				if (!IS_JOB_FINISHED(job_ptr)) {
-					return job_ptr;
-				}
+		array_index = _job_hash_find(&job_array_hash, array_job_id);
+		while ((job_ptr = _next_array_task(array_index, &inx))) {
+			match_job_ptr = job_ptr;
+			if (!IS_JOB_FINISHED(job_ptr)) {
+				return job_ptr;
 			}
-			job_ptr = job_ptr->job_array_next_j;
 		}
 		return match_job_ptr;
 	} else {		/* Find specific task ID */
-		inx = JOB_ARRAY_HASH_INX(array_job_id, array_task_id);
-		job_ptr = job_array_hash_t[inx];
-		while (job_ptr) {
-			if ((job_ptr->array_job_id == array_job_id) &&
-			    (job_ptr->array_task_id == array_task_id)) {
-				return job_ptr;
-			}
-			job_ptr = job_ptr->job_array_next_t;
-		}
+		array_index = _job_hash_find(&job_array_hash, array_job_id);
+		if (array_index &&
+		    (job_ptr = _array_task_find(array_index, array_task_id)))
+			return job_ptr;
 		/* Look for job record with all of the pending tasks */
 		job_ptr = find_job_record(array_job_id);
 		if (job_ptr && job_ptr->array_recs &&
@@ -3480,12 +4082,7 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
 	job_record_t *het_job_leader, *het_job;
 	ListIterator iter;
 
-	het_job_leader = job_hash[JOB_HASH_INX(job_id)];
-	while (het_job_leader) {
-		if (het_job_leader->job_id == job_id)
-			break;
-		het_job_leader = het_job_leader->job_next;
-	}
+	het_job_leader = find_job_record(job_id);
 	if (!het_job_leader)
 		return NULL;
 	if (het_job_leader->het_job_offset == het_job_id)
@@ -3515,16 +4112,7 @@ extern job_record_t *find_het_job_record(uint32_t job_id, uint32_t het_job_id)
  */
 extern job_record_t *find_job_record(uint32_t job_id)
 {
-	job_record_t *job_ptr;
-
-	job_ptr = job_hash[JOB_HASH_INX(job_id)];
-	while (job_ptr) {
-		if (job_ptr->job_id == job_id)
-			return job_ptr;
-		job_ptr = job_ptr->job_next;
-	}
-
-	return NULL;
+	return _job_hash_find(&job_hash, job_id);
 }
 
 /* rebuild a job's partition name list based upon the contents of its
@@ -4551,21 +5139,14 @@ extern void rehash_jobs(void)
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 	xassert(verify_lock(JOB_LOCK, WRITE_LOCK));
 
-	if (job_hash == NULL) {
-		hash_table_size = slurm_conf.max_job_cnt;
-		job_hash = xcalloc(hash_table_size, sizeof(job_record_t *));
-		job_array_hash_j = xcalloc(hash_table_size,
-					   sizeof(job_record_t *));
-		job_array_hash_t = xcalloc(hash_table_size,
-					   sizeof(job_record_t *));
-	} else if (hash_table_size < (slurm_conf.max_job_cnt / 2)) {
-		/* If the MaxJobCount grows by too much, the hash table will
-		 * be ineffective without rebuilding. We don't presently bother
-		 * to rebuild the hash table, but cut MaxJobCount back as
-		 * needed. */
-		error ("MaxJobCount reset too high, restart slurmctld");
-		slurm_conf.max_job_cnt = hash_table_size;
-	}
+	/*
+	 * The tables grow as needed, but size the job table for MaxJobCount
+	 * now to avoid rebuilding it as jobs are added.
+	 */
+	if (job_hash.size < (slurm_conf.max_job_cnt * 2))
+		_job_hash_resize(&job_hash, slurm_conf.max_job_cnt);
+	if (!job_array_hash.size)
+		_job_hash_resize(&job_array_hash, 0);
 }
 
 /* Create an exact copy of an existing job record for a job array.
@@ -4587,7 +5168,7 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	if (!job_ptr_pend)
 		return NULL;
 
-	_remove_job_hash(job_ptr, JOB_HASH_JOB);
+	_remove_job_hash(job_ptr);
 	job_ptr_pend->job_id = job_ptr->job_id;
 	if (_set_job_id(job_ptr) != SLURM_SUCCESS)
 		fatal("%s: _set_job_id error", __func__);
@@ -4610,6 +5191,9 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	job_ptr_pend->details  = save_details;
 	job_ptr_pend->db_flags = 0;
 	job_ptr_pend->step_list = save_step_list;
+	job_ptr_pend->step_layout_cache = NULL;
+	job_ptr_pend->step_node_use = NULL;
+	job_ptr_pend->step_node_use_map = NULL;
 	job_ptr_pend->db_index = save_db_index;
 
 	job_ptr_pend->prio_factors = save_prio_factors;
@@ -4666,8 +5250,8 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	memcpy(job_ptr_pend->limit_set.tres, job_ptr->limit_set.tres,
 	       sizeof(uint16_t) * slurmctld_tres_cnt);
 
-	_add_job_hash(job_ptr);		/* Sets job_next */
-	_add_job_hash(job_ptr_pend);	/* Sets job_next */
+	_add_job_hash(job_ptr);
+	_add_job_hash(job_ptr_pend);
 	_add_job_array_hash(job_ptr);
 	job_ptr_pend->job_resrcs = NULL;
 
@@ -4682,6 +5266,8 @@ extern job_record_t *job_array_split(job_record_t *job_ptr)
 	job_ptr_pend->node_bitmap_cg = NULL;
 	job_ptr_pend->nodes = NULL;
 	job_ptr_pend->nodes_completing = NULL;
+	job_ptr_pend->nodes_cg_str = NULL;
+	job_ptr_pend->nodes_cg_map = NULL;
 	job_ptr_pend->origin_cluster = xstrdup(job_ptr->origin_cluster);
 	job_ptr_pend->partition = xstrdup(job_ptr->partition);
 	job_ptr_pend->part_ptr_list = part_list_copy(job_ptr->part_ptr_list);
@@ -5808,6 +6394,8 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 			  uid_t uid, bool preempt)
 {
 	job_record_t *job_ptr;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 	uint32_t job_id;
 	time_t now = time(NULL);
 	char *end_ptr = NULL, *tok, *tmp;
@@ -5910,19 +6498,13 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 		}
 
 		/* Signal all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
-		if (!job_ptr && !job_ptr_done) {
+		array_index = _job_hash_find(&job_array_hash, job_id);
+		if (!array_index && !job_ptr_done) {
 			info("%s(3): invalid JobId=%u", __func__, job_id);
 			return ESLURM_INVALID_JOB_ID;
 		}
-		while (job_ptr) {
-			if (job_ptr->array_job_id == job_id)
-				break;
-			job_ptr = job_ptr->job_array_next_j;
-		}
-		while (job_ptr) {
-			if ((job_ptr->array_job_id == job_id) &&
-			    (job_ptr != job_ptr_done)) {
+		while ((job_ptr = _next_array_task(array_index, &inx))) {
+			if (job_ptr != job_ptr_done) {
 				rc2 = job_signal(job_ptr, signal, flags, uid,
 						 preempt);
 				jobs_signaled++;
@@ -5932,7 +6514,6 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 					rc = MAX(rc, rc2);
 				}
 			}
-			job_ptr = job_ptr->job_array_next_j;
 		}
 		if ((rc == SLURM_SUCCESS) && (jobs_done == jobs_signaled))
 			return ESLURM_ALREADY_DONE;
@@ -5963,12 +6544,8 @@ extern int job_str_signal(char *job_id_str, uint16_t signal, uint16_t flags,
 	/* Find some job record and validate the user signaling the job */
 	job_ptr = find_job_record(job_id);
 	if (job_ptr == NULL) {
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
-		while (job_ptr) {
-			if (job_ptr->array_job_id == job_id)
-				break;
-			job_ptr = job_ptr->job_array_next_j;
-		}
+		array_index = _job_hash_find(&job_array_hash, job_id);
+		job_ptr = _next_array_task(array_index, &inx);
 	}
 	if ((job_ptr == NULL) ||
 	    ((job_ptr->array_task_id == NO_VAL) &&
@@ -7797,7 +8374,9 @@ static int
 _copy_job_desc_to_file(job_desc_msg_t * job_desc, uint32_t job_id)
 {
 	int error_code = 0, hash;
-	char *dir_name, *file_name;
+	char *dir_name, *file_name, *env_data;
+	size_t env_len, len, offset;
+	uint32_t i;
 	DEF_TIMERS;
 
 	START_TIMER;
@@ -7828,17 +8407,35 @@ _copy_job_desc_to_file(job_desc_msg_t * job_desc, uint32_t job_id)
 		return ESLURM_WRITING_TO_FILE;
 	}
 
-	/* Create environment file, and write data to it */
+	/*
+	 * Create environment file, and write data to it: the element count
+	 * followed by each NUL terminated string
+	 */
+	env_len = sizeof(uint32_t);
+	for (i = 0; i < job_desc->env_size; i++)
+		env_len += strlen(job_desc->environment[i]) + 1;
+	env_data = xmalloc(env_len);
+	memcpy(env_data, &job_desc->env_size, sizeof(uint32_t));
+	offset = sizeof(uint32_t);
+	for (i = 0; i < job_desc->env_size; i++) {
+		len = strlen(job_desc->environment[i]) + 1;
+		memcpy(env_data + offset, job_desc->environment[i], len);
+		offset += len;
+	}
 	file_name = xstrdup_printf("%s/environment", dir_name);
-	error_code = _write_data_array_to_file(file_name,
-					       job_desc->environment,
-					       job_desc->env_size);
+	error_code = _write_blob_file(file_name, env_data, env_len, 0600);
 	xfree(file_name);
+	xfree(env_data);
 
 	if (error_code == 0) {
 		/* Create script file */
 		file_name = xstrdup_printf("%s/script", dir_name);
-		error_code = write_data_to_file(file_name, job_desc->script);
+		if (job_desc->script)
+			error_code = _write_blob_file(
+				file_name, job_desc->script,
+				strlen(job_desc->script) + 1, 0700);
+		else
+			error_code = write_data_to_file(file_name, NULL);
 		xfree(file_name);
 	}
 
@@ -7869,53 +8466,81 @@ static bool _dup_job_file_test(uint32_t job_id)
 	return false;
 }
 
-/*
- * Create file with specified name and write the supplied data array to it
- * IN file_name - file to create and write to
- * IN data - array of pointers to strings (e.g. env)
- * IN size - number of elements in data
- */
-static int
-_write_data_array_to_file(char *file_name, char **data, uint32_t size)
+static int _write_all(char *file_name, const char *data, size_t len,
+		      mode_t mode)
 {
-	int fd, i, pos, nwrite, amount;
+	int fd, amount;
+	size_t pos = 0;
 
-	fd = creat(file_name, 0600);
+	fd = open(file_name, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC, mode);
 	if (fd < 0) {
 		error("Error creating file %s, %m", file_name);
 		return ESLURM_WRITING_TO_FILE;
 	}
 
-	amount = write(fd, &size, sizeof(uint32_t));
-	if (amount < sizeof(uint32_t)) {
-		error("Error writing file %s, %m", file_name);
-		close(fd);
-		return ESLURM_WRITING_TO_FILE;
+	while (pos < len) {
+		amount = write(fd, &data[pos], len - pos);
+		if (amount < 0) {
+			if (errno == EINTR)
+				continue;
+			error("Error writing file %s, %m", file_name);
+			close(fd);
+			return ESLURM_WRITING_TO_FILE;
+		}
+		pos += amount;
 	}
 
-	if (data == NULL) {
-		close(fd);
-		return SLURM_SUCCESS;
+	close(fd);
+	return SLURM_SUCCESS;
+}
+
+/*
+ * Create file with specified name holding the supplied data, as a hard link
+ * to the shared blob with the same content when possible
+ * IN file_name - file to create
+ * IN data - file content
+ * IN len - length of data
+ * IN mode - permissions used if the file or blob is created
+ */
+static int _write_blob_file(char *file_name, const char *data, size_t len,
+			    mode_t mode)
+{
+	char *blob_name = _blob_path(data, len), *tmp_name = NULL;
+	struct stat sbuf;
+	int rc = SLURM_ERROR;
+
+	if (!stat(blob_name, &sbuf)) {
+		/* Different content with the same hash keeps a private copy */
+		if (_blob_match(blob_name, data, len))
+			rc = link(blob_name, file_name);
+	} else if (errno == ENOENT) {
+		/* Blob hash directory may differ from the job's one */
+		tmp_name = xstrdup(blob_name);
+		*strrchr(tmp_name, '/') = '\0';
+		(void) mkdir(tmp_name, 0700);
+		xfree(tmp_name);
+
+		/* Never let a partially written blob be linked to */
+		tmp_name = xstrdup_printf("%s.new", blob_name);
+		if ((_write_all(tmp_name, data, len, mode) == SLURM_SUCCESS) &&
+		    !rename(tmp_name, blob_name))
+			rc = link(blob_name, file_name);
+		else
+			(void) unlink(tmp_name);
+		xfree(tmp_name);
 	}
 
-	for (i = 0; i < size; i++) {
-		nwrite = strlen(data[i]) + 1;
-		pos = 0;
-		while (nwrite > 0) {
-			amount = write(fd, &data[i][pos], nwrite);
-			if ((amount < 0) && (errno != EINTR)) {
-				error("Error writing file %s, %m",
-				      file_name);
-				close(fd);
-				return ESLURM_WRITING_TO_FILE;
-			}
-			nwrite -= amount;
-			pos    += amount;
-		}
+	if (rc) {
+		debug("%s: unable to share %s, writing private copy",
+		      __func__, file_name);
+		rc = _write_all(file_name, data, len, mode);
+	} else if (!stat(blob_name, &sbuf) && (sbuf.st_nlink == 1)) {
+		/* Blob was released by a job deletion during our link */
+		(void) unlink(blob_name);
 	}
+	xfree(blob_name);
 
-	close(fd);
-	return SLURM_SUCCESS;
+	return rc;
 }
 
 /*
@@ -9604,17 +10229,17 @@ extern void free_null_array_recs(job_record_t *job_ptr)
 
 static void _delete_job_common(job_record_t *job_ptr)
 {
+	slurm_preempt_reset_candidates();
+
 	/* Remove record from fed_job_list */
 	fed_mgr_remove_fed_job_info(job_ptr->job_id);
 
 	/* Remove the record from job hash table */
-	_remove_job_hash(job_ptr, JOB_HASH_JOB);
+	_remove_job_hash(job_ptr);
 
-	/* Remove the record from job array hash tables, if applicable */
-	if (job_ptr->array_task_id != NO_VAL) {
-		_remove_job_hash(job_ptr, JOB_HASH_ARRAY_JOB);
-		_remove_job_hash(job_ptr, JOB_HASH_ARRAY_TASK);
-	}
+	/* Remove the record from job array hash table, if applicable */
+	if (job_ptr->array_task_id != NO_VAL)
+		_remove_job_array_hash(job_ptr);
 }
 
 /*
@@ -9631,6 +10256,8 @@ static void _list_delete_job(void *job_entry)
 	xassert (job_ptr->magic == JOB_MAGIC);
 	job_ptr->magic = 0;	/* make sure we don't delete record twice */
 
+	if (job_journal_enable)
+		_job_state_journal_del_add(job_ptr->job_id);
 	_delete_job_common(job_ptr);
 
 	if (job_ptr->array_recs) {
@@ -9677,6 +10304,8 @@ static void _list_delete_job(void *job_entry)
 	FREE_NULL_BITMAP(job_ptr->node_bitmap_cg);
 	xfree(job_ptr->nodes);
 	xfree(job_ptr->nodes_completing);
+	xfree(job_ptr->nodes_cg_str);
+	FREE_NULL_BITMAP(job_ptr->nodes_cg_map);
 	xfree(job_ptr->origin_cluster);
 	if (job_ptr->het_details && job_ptr->het_job_id) {
 		/* xfree struct if hetjob leader and NULL ptr otherwise. */
@@ -9695,10 +10324,12 @@ static void _list_delete_job(void *job_entry)
 	FREE_NULL_LIST(job_ptr->resv_list);
 	xfree(job_ptr->resv_name);
 	xfree(job_ptr->sched_nodes);
+	sched_trace_free(job_ptr);
 	for (i = 0; i < job_ptr->spank_job_env_size; i++)
 		xfree(job_ptr->spank_job_env[i]);
 	xfree(job_ptr->spank_job_env);
 	xfree(job_ptr->state_desc);
+	step_cache_free(job_ptr);
 	FREE_NULL_LIST(job_ptr->step_list);
 	xfree(job_ptr->system_comment);
 	xfree(job_ptr->tres_alloc_cnt);
@@ -9716,6 +10347,7 @@ static void _list_delete_job(void *job_entry)
 	select_g_select_jobinfo_free(job_ptr->select_jobinfo);
 	xfree(job_ptr->user_name);
 	xfree(job_ptr->wckey);
+	job_pack_cache_clear(job_ptr);
 	if (job_array_size > job_count) {
 		error("job_count underflow");
 		job_count = 0;
@@ -9888,10 +10520,238 @@ static bool _hide_job_user_rec(job_record_t *job_ptr, slurmdb_user_rec_t *user,
 	return false;
 }
 
+/*
+ * Parse SlurmctldParameters=job_pack_cache
+ * NOTE: Call with a read lock on the slurmctld configuration
+ */
+static bool _job_pack_cache_enabled(void)
+{
+	if (job_pack_cache_conf_update != slurm_conf.last_update) {
+		slurm_mutex_lock(&job_pack_cache_lock);
+		job_pack_cache_enable = (xstrcasestr(slurm_conf.slurmctld_params,
+						     "job_pack_cache") != NULL);
+		job_pack_cache_conf_update = slurm_conf.last_update;
+		slurm_mutex_unlock(&job_pack_cache_lock);
+	}
+
+	return job_pack_cache_enable;
+}
+
+/*
+ * Return true if the packed form of this job only changes when the job's state
+ * changes, the job is explicitly updated, or the partition or slurmctld
+ * configuration changes.
+ */
+static bool _job_pack_cacheable(job_record_t *job_ptr)
+{
+	job_record_t *array_head;
+
+	if (!IS_JOB_FINISHED(job_ptr) || IS_JOB_COMPLETING(job_ptr))
+		return false;
+	if (job_ptr->array_recs)
+		return false;
+	/* Preemptable time depends upon QOS configuration */
+	if (slurm_conf.preempt_mode != PREEMPT_MODE_OFF)
+		return false;
+	/* Tasks report the array's max_run_tasks, which may be updated */
+	if (job_ptr->array_job_id &&
+	    (array_head = find_job_record(job_ptr->array_job_id)) &&
+	    array_head->array_recs)
+		return false;
+
+	return true;
+}
+
+/*
+ * Discard any cached pack_job() output for this job
+ * NOTE: Call with the job write lock set
+ */
+extern void job_pack_cache_clear(job_record_t *job_ptr)
+{
+	xfree(job_ptr->pack_cache);
+	job_ptr->pack_cache_size = 0;
+}
+
+/*
+ * Pack a job's information, copying it from the job's pack cache when that is
+ * current and saving it there otherwise.
+ * NOTE: Multiple threads may pack jobs at once with the job read lock, so the
+ *	 job's pack cache is protected by the job shard lock
+ */
+static void _pack_job_cached(job_record_t *job_ptr,
+			     _foreach_pack_job_info_t *pack_info)
+{
+	buf_t *buffer = pack_info->buffer;
+	uint32_t offset;
+
+	if (!_job_pack_cache_enabled() || !_job_pack_cacheable(job_ptr)) {
+		pack_job(job_ptr, pack_info->show_flags, buffer,
+			 pack_info->protocol_version, pack_info->uid,
+			 pack_info->has_qos_lock);
+		return;
+	}
+
+	lock_job_shard(job_ptr->job_id, READ_LOCK);
+	if (job_ptr->pack_cache &&
+	    (job_ptr->pack_cache_proto == pack_info->protocol_version) &&
+	    (job_ptr->pack_cache_flags == pack_info->show_flags) &&
+	    (job_ptr->pack_cache_state == job_ptr->job_state) &&
+	    (job_ptr->pack_cache_time > last_part_update) &&
+	    (job_ptr->pack_cache_time > slurm_conf.last_update)) {
+		packmem_array(job_ptr->pack_cache, job_ptr->pack_cache_size,
+			      buffer);
+		unlock_job_shard(job_ptr->job_id);
+		return;
+	}
+	unlock_job_shard(job_ptr->job_id);
+
+	offset = get_buf_offset(buffer);
+	pack_job(job_ptr, pack_info->show_flags, buffer,
+		 pack_info->protocol_version, pack_info->uid,
+		 pack_info->has_qos_lock);
+
+	lock_job_shard(job_ptr->job_id, WRITE_LOCK);
+	xfree(job_ptr->pack_cache);
+	job_ptr->pack_cache_size = get_buf_offset(buffer) - offset;
+	job_ptr->pack_cache = xmalloc_nz(job_ptr->pack_cache_size);
+	memcpy(job_ptr->pack_cache, get_buf_data(buffer) + offset,
+	       job_ptr->pack_cache_size);
+	job_ptr->pack_cache_proto = pack_info->protocol_version;
+	job_ptr->pack_cache_flags = pack_info->show_flags;
+	job_ptr->pack_cache_state = job_ptr->job_state;
+	job_ptr->pack_cache_time = time(NULL);
+	unlock_job_shard(job_ptr->job_id);
+}
+
+static int _find_uint32(void *x, void *key)
+{
+	if (*(uint32_t *) x == *(uint32_t *) key)
+		return 1;
+	return 0;
+}
+
+static int _match_job_id(void *x, void *key)
+{
+	uint32_t job_id = *(uint32_t *) x;
+	job_record_t *job_ptr = key;
+
+	if ((job_id == job_ptr->job_id) ||
+	    (job_id == job_ptr->array_job_id) ||
+	    (job_id == job_ptr->het_job_id))
+		return 1;
+	return 0;
+}
+
+/*
+ * Same test as squeue, except that a base state also matches jobs with
+ * state flags set.
+ */
+static int _match_job_state(void *x, void *key)
+{
+	uint32_t state = *(uint32_t *) x;
+	job_record_t *job_ptr = key;
+
+	if (state & JOB_STATE_FLAGS) {
+		if (state & job_ptr->job_state)
+			return 1;
+	} else if (state == (job_ptr->job_state & JOB_STATE_BASE))
+		return 1;
+	return 0;
+}
+
+static int _find_part_name(void *x, void *key)
+{
+	part_record_t *part_ptr = x;
+
+	if (list_find_first(key, slurm_find_char_in_list, part_ptr->name))
+		return 1;
+	return 0;
+}
+
+/* Return true if job_ptr does not pass the filters of a job info request */
+static bool _job_info_filtered(job_record_t *job_ptr,
+			       _foreach_pack_job_info_t *pack_info)
+{
+	job_info_request_msg_t *filter = pack_info->filter;
+
+	if (filter->uid_list &&
+	    !list_find_first(filter->uid_list, _find_uint32,
+			     &job_ptr->user_id))
+		return true;
+
+	if (filter->job_id_list &&
+	    !list_find_first(filter->job_id_list, _match_job_id, job_ptr))
+		return true;
+
+	if (filter->state_list &&
+	    !list_find_first(filter->state_list, _match_job_state, job_ptr))
+		return true;
+
+	if (pack_info->account_list &&
+	    (!job_ptr->account ||
+	     !list_find_first(pack_info->account_list,
+			      slurm_find_char_in_list, job_ptr->account)))
+		return true;
+
+	if (pack_info->part_list) {
+		if (job_ptr->part_ptr_list) {
+			if (!list_find_first(job_ptr->part_ptr_list,
+					     _find_part_name,
+					     pack_info->part_list))
+				return true;
+		} else if (!job_ptr->part_ptr ||
+			   !list_find_first(pack_info->part_list,
+					    slurm_find_char_in_list,
+					    job_ptr->part_ptr->name))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Record when the packed form of a job last changed, keeping one hash for
+ * each of two sets of show_flags (the record includes the show_flags).
+ * Return true unless this is a SHOW_DELTA reply and the record packed at
+ * offset is unchanged since the request's update_time.
+ * NOTE: Multiple threads may pack jobs at once with the job read lock, so the
+ *	 job's pack hash is protected by the job shard lock
+ */
+static bool _job_pack_changed(job_record_t *job_ptr,
+			      _foreach_pack_job_info_t *pack_info,
+			      uint32_t offset)
+{
+	uint32_t hash = _job_state_hash(pack_info->buffer, offset);
+	uint16_t flags = pack_info->show_flags;
+	time_t change;
+	int slot;
+
+	lock_job_shard(job_ptr->job_id, WRITE_LOCK);
+	if (job_ptr->pack_flags[0] == flags)
+		slot = 0;
+	else if (job_ptr->pack_flags[1] == flags)
+		slot = 1;
+	else {
+		slot = (flags & SHOW_DETAIL) ? 1 : 0;
+		job_ptr->pack_flags[slot] = flags;
+		job_ptr->pack_hash[slot] = 0;
+	}
+	if (hash != job_ptr->pack_hash[slot]) {
+		job_ptr->pack_hash[slot] = hash;
+		job_ptr->pack_change[slot] = pack_info->now;
+	}
+	change = job_ptr->pack_change[slot];
+	unlock_job_shard(job_ptr->job_id);
+
+	return (!pack_info->delta || (change >= pack_info->update_time));
+}
+
 static int _pack_job(void *object, void *arg)
 {
 	job_record_t *job_ptr = (job_record_t *)object;
 	_foreach_pack_job_info_t *pack_info = (_foreach_pack_job_info_t *)arg;
+	buf_t *buffer = pack_info->buffer;
+	uint32_t rec_offset;
 
 	xassert (job_ptr->magic == JOB_MAGIC);
 
@@ -9899,6 +10759,9 @@ static int _pack_job(void *object, void *arg)
 	    (pack_info->filter_uid != job_ptr->user_id))
 		return SLURM_SUCCESS;
 
+	if (pack_info->filter && _job_info_filtered(job_ptr, pack_info))
+		return SLURM_SUCCESS;
+
 	if (((pack_info->show_flags & SHOW_ALL) == 0) &&
 	    (pack_info->uid != 0) &&
 	    _all_parts_hidden(job_ptr, &pack_info->user_rec))
@@ -9908,9 +10771,22 @@ static int _pack_job(void *object, void *arg)
 			       pack_info->show_flags))
 		return SLURM_SUCCESS;
 
-	pack_job(job_ptr, pack_info->show_flags, pack_info->buffer,
-		 pack_info->protocol_version, pack_info->uid,
-		 pack_info->has_qos_lock);
+	if (pack_info->delta)
+		pack8(1, buffer);
+	rec_offset = get_buf_offset(buffer);
+	_pack_job_cached(job_ptr, pack_info);
+
+	/*
+	 * Records unchanged since update_time are rewound to an "unchanged"
+	 * byte and the job ID. Jobs not packed at all are dropped by the
+	 * client, which covers purged jobs and jobs no longer visible.
+	 */
+	if (pack_info->track &&
+	    !_job_pack_changed(job_ptr, pack_info, rec_offset)) {
+		set_buf_offset(buffer, rec_offset - 1);
+		pack8(0, buffer);
+		pack32(job_ptr->job_id, buffer);
+	}
 
 	(*pack_info->jobs_packed)++;
 
@@ -9931,13 +10807,16 @@ static int _foreach_pack_jobid(void *object, void *arg)
 
 /*
  * _pack_init_job_info - create buffer with header packed for a job_info_msg_t
+ * IN size - expected size of the packed message
+ * IN delta - set if this is a SHOW_DELTA reply (21.08+ clients)
  *
  * NOTE: change _unpack_job_info_msg() in common/slurm_protocol_pack.c
  *	whenever the data format changes
  */
-static buf_t *_pack_init_job_info(uint16_t protocol_version)
+static buf_t *_pack_init_job_info(uint32_t size, bool delta,
+				  uint16_t protocol_version)
 {
-	buf_t *buffer = init_buf(BUF_SIZE);
+	buf_t *buffer = init_pool_buf(size);
 
 	/* write message body header : size and time */
 	/* put in a place holder job record count of 0 for now */
@@ -9945,6 +10824,7 @@ static buf_t *_pack_init_job_info(uint16_t protocol_version)
 		pack32(0, buffer);
 		pack_time(time(NULL), buffer);
 		pack_time(slurmctld_diag_stats.bf_when_last_cycle, buffer);
+		pack8(delta, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		pack32(0, buffer);
 		pack_time(time(NULL), buffer);
@@ -9961,39 +10841,78 @@ static buf_t *_pack_init_job_info(uint16_t protocol_version)
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only jobs passing the filters of this request if not NULL
+ * IN update_time - with SHOW_DELTA, only pack records changed since this time
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			  job_info_request_msg_t *filter, time_t update_time,
 			  uint16_t protocol_version)
 {
 	uint32_t jobs_packed = 0, tmp_offset;
 	_foreach_pack_job_info_t pack_info = {0};
 	buf_t *buffer;
 	assoc_mgr_lock_t locks = { .user = READ_LOCK, .qos = READ_LOCK };
+	bool delta = false;
 
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = _pack_init_job_info(protocol_version);
+	/*
+	 * Packed records are only hashed once a SHOW_DELTA request has been
+	 * seen. Until then no job has a hash, so the first delta reply sends
+	 * every record in full.
+	 */
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		if (show_flags & SHOW_DELTA) {
+			job_pack_track = true;
+			delta = (update_time != 0);
+		}
+		pack_info.track = job_pack_track;
+	}
+
+	buffer = _pack_init_job_info(job_info_pack_size, delta,
+				     protocol_version);
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
+	pack_info.delta            = delta;
 	pack_info.filter_uid       = filter_uid;
 	pack_info.jobs_packed      = &jobs_packed;
+	pack_info.now              = time(NULL);
 	pack_info.protocol_version = protocol_version;
-	pack_info.show_flags       = show_flags;
+	pack_info.show_flags       = show_flags & (~SHOW_DELTA);
 	pack_info.uid              = uid;
+	pack_info.update_time      = update_time;
 	pack_info.has_qos_lock = true;
 	pack_info.user_rec.uid = uid;
 
+	if (filter) {
+		pack_info.filter = filter;
+		if (filter->accounts) {
+			pack_info.account_list = list_create(xfree_ptr);
+			slurm_addto_char_list(pack_info.account_list,
+					      filter->accounts);
+		}
+		if (filter->partitions) {
+			pack_info.part_list = list_create(xfree_ptr);
+			slurm_addto_char_list_with_case(pack_info.part_list,
+							filter->partitions,
+							false);
+		}
+	}
+
 	assoc_mgr_lock(&locks);
 	assoc_mgr_fill_in_user(acct_db_conn, &pack_info.user_rec,
 			       accounting_enforce, NULL, true);
 	list_for_each(job_list, _pack_job, &pack_info);
 	assoc_mgr_unlock(&locks);
 
+	FREE_NULL_LIST(pack_info.account_list);
+	FREE_NULL_LIST(pack_info.part_list);
+
 	/* put the real record count in the message body header */
 	tmp_offset = get_buf_offset(buffer);
 	set_buf_offset(buffer, 0);
@@ -10001,6 +10920,8 @@ extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 	set_buf_offset(buffer, tmp_offset);
 
 	*buffer_size = get_buf_offset(buffer);
+	if ((filter_uid == NO_VAL) && !filter && !delta)
+		job_info_pack_size = *buffer_size;
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
 
@@ -10030,7 +10951,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = _pack_init_job_info(protocol_version);
+	buffer = _pack_init_job_info(BUF_SIZE, false, protocol_version);
 
 	/* write individual job records */
 	pack_info.buffer           = buffer;
@@ -10042,20 +10963,233 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
 	pack_info.has_qos_lock = true;
 	pack_info.user_rec.uid = uid;
 
-	assoc_mgr_lock(&locks);
-	assoc_mgr_fill_in_user(acct_db_conn, &pack_info.user_rec,
-			       accounting_enforce, NULL, true);
-	list_for_each(job_ids, _foreach_pack_jobid, &pack_info);
-	assoc_mgr_unlock(&locks);
+	assoc_mgr_lock(&locks);
+	assoc_mgr_fill_in_user(acct_db_conn, &pack_info.user_rec,
+			       accounting_enforce, NULL, true);
+	list_for_each(job_ids, _foreach_pack_jobid, &pack_info);
+	assoc_mgr_unlock(&locks);
+
+	/* put the real record count in the message body header */
+	tmp_offset = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	pack32(jobs_packed, buffer);
+	set_buf_offset(buffer, tmp_offset);
+
+	*buffer_size = get_buf_offset(buffer);
+	buffer_ptr[0] = xfer_buf_data(buffer);
+}
+
+static void _job_snapshot_free(job_info_snapshot_t *snap)
+{
+	free_pool_data(snap->data);
+	xfree(snap);
+}
+
+/* Release a snapshot no longer current. Call with job_snapshot_lock held */
+static void _job_snapshot_retire(job_info_snapshot_t *snap)
+{
+	if (snap->refcnt)
+		snap->retired = true;
+	else
+		_job_snapshot_free(snap);
+}
+
+/* Return true if all partitions are visible to all users */
+static bool _all_parts_public(void)
+{
+	ListIterator part_iterator;
+	part_record_t *part_ptr;
+	bool rc = true;
+
+	part_iterator = list_iterator_create(part_list);
+	while ((part_ptr = list_next(part_iterator))) {
+		if ((part_ptr->flags & PART_FLAG_HIDDEN) ||
+		    part_ptr->allow_groups) {
+			rc = false;
+			break;
+		}
+	}
+	list_iterator_destroy(part_iterator);
+
+	return rc;
+}
+
+/*
+ * job_info_snapshot_get - find a published snapshot of all jobs' packed
+ *	information matching a request, no job lock is needed
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request
+ * IN protocol_version - slurm protocol version of client
+ * IN locked - caller holds the config and partition read locks, otherwise
+ *	they are briefly taken
+ * RET snapshot no older than job_info_snapshot_interval or NULL if none,
+ *	release with job_info_snapshot_put()
+ */
+extern job_info_snapshot_t *job_info_snapshot_get(uint16_t show_flags,
+						  uid_t uid,
+						  uint16_t protocol_version,
+						  bool locked)
+{
+	job_info_snapshot_t *snap = NULL;
+	time_t conf_update, part_update, now = time(NULL);
+	int i;
+	/* Locks: Read config, partition */
+	slurmctld_lock_t part_read_lock = {
+		.conf = READ_LOCK, .part = READ_LOCK };
+
+	/* Visibility of jobs can change with partitions or config */
+	if (!locked)
+		lock_slurmctld(part_read_lock);
+	conf_update = slurm_conf.last_update;
+	part_update = last_part_update;
+	if (!locked)
+		unlock_slurmctld(part_read_lock);
+
+	slurm_mutex_lock(&job_snapshot_lock);
+	for (i = 0; job_snapshot_interval && (i < JOB_SNAPSHOT_CNT); i++) {
+		if (!job_snapshot[i] ||
+		    (job_snapshot[i]->protocol_version != protocol_version) ||
+		    (job_snapshot[i]->show_flags != show_flags) ||
+		    (job_snapshot[i]->root != (uid == 0)))
+			continue;
+		if ((difftime(now, job_snapshot[i]->build_time) <
+		     job_snapshot_interval) &&
+		    (job_snapshot[i]->part_update == part_update) &&
+		    (job_snapshot[i]->conf_update == conf_update)) {
+			snap = job_snapshot[i];
+			snap->refcnt++;
+		}
+		break;
+	}
+	slurm_mutex_unlock(&job_snapshot_lock);
+
+	return snap;
+}
+
+/* job_info_snapshot_data - return packed data of a snapshot and its size */
+extern char *job_info_snapshot_data(job_info_snapshot_t *snap, int *size,
+				    time_t *job_update)
+{
+	*size = snap->size;
+	*job_update = snap->job_update;
+
+	return snap->data;
+}
+
+/* job_info_snapshot_put - release a snapshot from job_info_snapshot_get() */
+extern void job_info_snapshot_put(job_info_snapshot_t *snap)
+{
+	if (!snap)
+		return;
+
+	slurm_mutex_lock(&job_snapshot_lock);
+	snap->refcnt--;
+	if (snap->retired && !snap->refcnt)
+		_job_snapshot_free(snap);
+	slurm_mutex_unlock(&job_snapshot_lock);
+}
+
+/*
+ * job_info_snapshot_publish - pack all jobs' information and publish it as
+ *	a snapshot for use by later requests with the same parameters, when
+ *	SlurmctldParameters=job_info_snapshot_interval is configured and the
+ *	information does not depend upon the requesting user's privileges
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request
+ * IN protocol_version - slurm protocol version of client
+ * RET snapshot to release with job_info_snapshot_put() or NULL if no
+ *	snapshot can be published for this request
+ * NOTE: Call with locks set as for pack_all_jobs()
+ */
+extern job_info_snapshot_t *job_info_snapshot_publish(
+	uint16_t show_flags, uid_t uid, uint16_t protocol_version)
+{
+	job_info_snapshot_t *snap;
+	char *tmp_ptr;
+	int i, interval, slot = 0;
+
+	xassert(verify_lock(CONF_LOCK, READ_LOCK));
+	xassert(verify_lock(PART_LOCK, READ_LOCK));
+
+	/* Concurrent callers only hold read locks */
+	slurm_mutex_lock(&job_snapshot_lock);
+	if (job_snapshot_conf_update != slurm_conf.last_update) {
+		job_snapshot_conf_update = slurm_conf.last_update;
+		job_snapshot_interval = 0;
+		if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+					   "job_info_snapshot_interval="))) {
+			job_snapshot_interval = atoi(tmp_ptr + 27);
+			if (job_snapshot_interval < 0) {
+				error("Invalid SlurmctldParameters job_info_snapshot_interval: %d",
+				      job_snapshot_interval);
+				job_snapshot_interval = 0;
+			}
+		}
+	}
+	interval = job_snapshot_interval;
+	slurm_mutex_unlock(&job_snapshot_lock);
+	if (!interval)
+		return NULL;
+
+	/*
+	 * Only publish data which would be identical for any user with the
+	 * same value of (uid == 0)
+	 */
+	if ((uid != 0) &&
+	    ((slurm_conf.private_data & PRIVATE_DATA_JOBS) ||
+	     (!(show_flags & SHOW_ALL) && !_all_parts_public())))
+		return NULL;
+
+	snap = xmalloc(sizeof(*snap));
+	snap->build_time = time(NULL);
+	snap->job_update = last_job_update;
+	snap->part_update = last_part_update;
+	snap->conf_update = slurm_conf.last_update;
+	snap->protocol_version = protocol_version;
+	snap->show_flags = show_flags;
+	snap->root = (uid == 0);
+	snap->refcnt = 1;
+	pack_all_jobs(&snap->data, &snap->size, show_flags, uid, NO_VAL, NULL,
+		      0, protocol_version);
+
+	slurm_mutex_lock(&job_snapshot_lock);
+	for (i = 0; i < JOB_SNAPSHOT_CNT; i++) {
+		if (!job_snapshot[i]) {
+			slot = i;
+			break;
+		}
+		if ((job_snapshot[i]->protocol_version == protocol_version) &&
+		    (job_snapshot[i]->show_flags == show_flags) &&
+		    (job_snapshot[i]->root == snap->root)) {
+			slot = i;
+			break;
+		}
+		if (job_snapshot[i]->build_time <
+		    job_snapshot[slot]->build_time)
+			slot = i;	/* Replace the oldest snapshot */
+	}
+	if (job_snapshot[slot])
+		_job_snapshot_retire(job_snapshot[slot]);
+	job_snapshot[slot] = snap;
+	snap->refcnt++;
+	slurm_mutex_unlock(&job_snapshot_lock);
+
+	return snap;
+}
 
-	/* put the real record count in the message body header */
-	tmp_offset = get_buf_offset(buffer);
-	set_buf_offset(buffer, 0);
-	pack32(jobs_packed, buffer);
-	set_buf_offset(buffer, tmp_offset);
+/* Free all published job info snapshots */
+static void _job_snapshot_fini(void)
+{
+	int i;
 
-	*buffer_size = get_buf_offset(buffer);
-	buffer_ptr[0] = xfer_buf_data(buffer);
+	slurm_mutex_lock(&job_snapshot_lock);
+	for (i = 0; i < JOB_SNAPSHOT_CNT; i++) {
+		if (!job_snapshot[i])
+			continue;
+		_job_snapshot_retire(job_snapshot[i]);
+		job_snapshot[i] = NULL;
+	}
+	slurm_mutex_unlock(&job_snapshot_lock);
 }
 
 static int _pack_het_job(job_record_t *job_ptr, uint16_t show_flags,
@@ -10098,6 +11232,8 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			uint16_t protocol_version)
 {
 	job_record_t *job_ptr;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 	uint32_t jobs_packed = 0, tmp_offset;
 	buf_t *buffer;
 	assoc_mgr_lock_t locks = { .qos = READ_LOCK, .user = READ_LOCK };
@@ -10107,7 +11243,7 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = _pack_init_job_info(protocol_version);
+	buffer = _pack_init_job_info(BUF_SIZE, false, protocol_version);
 
 	assoc_mgr_lock(&locks);
 	if (slurm_conf.private_data & PRIVATE_DATA_JOBS) {
@@ -10148,11 +11284,11 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 			}
 		}
 
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
-		while (job_ptr) {
+		array_index = _job_hash_find(&job_array_hash, job_id);
+		while ((job_ptr = _next_array_task(array_index, &inx))) {
 			if ((job_ptr->job_id == job_id) && packed_head) {
 				;	/* Already packed */
-			} else if (job_ptr->array_job_id == job_id) {
+			} else {
 				if (_hide_job_user_rec(
 					    job_ptr, &user_rec, show_flags))
 					break;
@@ -10160,14 +11296,13 @@ extern int pack_one_job(char **buffer_ptr, int *buffer_size,
 					 protocol_version, uid, true);
 				jobs_packed++;
 			}
-			job_ptr = job_ptr->job_array_next_j;
 		}
 	}
 
 	assoc_mgr_unlock(&locks);
 
 	if (jobs_packed == 0) {
-		free_buf(buffer);
+		free_pool_buf(buffer);
 		return ESLURM_INVALID_JOB_ID;
 	}
 
@@ -10196,6 +11331,35 @@ static void _pack_job_gres(job_record_t *dump_job_ptr, buf_t *buffer,
 		      dump_job_ptr->gres_detail_cnt, buffer);
 }
 
+/*
+ * Pack the names of a completing job's nodes that are still completing. The
+ * names are only rebuilt when node_bitmap_cg changed since they were last
+ * packed, as squeue and sview keep asking for them until the job completes.
+ * NOTE: Multiple threads may pack jobs at once with the job read lock, so the
+ *	 cached names are protected by the job shard lock
+ */
+static void _pack_nodes_cg(job_record_t *job_ptr, buf_t *buffer,
+			   uint16_t protocol_version)
+{
+	lock_job_shard(job_ptr->job_id, WRITE_LOCK);
+	if (!job_ptr->nodes_cg_str ||
+	    (!job_ptr->node_bitmap_cg != !job_ptr->nodes_cg_map) ||
+	    (job_ptr->node_bitmap_cg &&
+	     !bit_equal(job_ptr->node_bitmap_cg, job_ptr->nodes_cg_map))) {
+		xfree(job_ptr->nodes_cg_str);
+		FREE_NULL_BITMAP(job_ptr->nodes_cg_map);
+		job_ptr->nodes_cg_str = bitmap2node_name(job_ptr->node_bitmap_cg);
+		if (job_ptr->node_bitmap_cg)
+			job_ptr->nodes_cg_map =
+				bit_copy(job_ptr->node_bitmap_cg);
+	}
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+		packvarstr(job_ptr->nodes_cg_str, buffer);
+	else
+		packstr(job_ptr->nodes_cg_str, buffer);
+	unlock_job_shard(job_ptr->job_id);
+}
+
 /*
  * pack_job - dump all configuration information about a specific job in
  *	machine independent form (for network transmission)
@@ -10213,77 +11377,76 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 	struct job_details *detail_ptr;
 	time_t accrue_time = 0, begin_time = 0, start_time = 0, end_time = 0;
 	uint32_t time_limit;
-	char *nodelist = NULL;
 	assoc_mgr_lock_t locks = { .qos = READ_LOCK };
 	xassert(!has_qos_lock || verify_assoc_lock(QOS_LOCK, READ_LOCK));
 
 	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
 		detail_ptr = dump_job_ptr->details;
-		pack32(dump_job_ptr->array_job_id, buffer);
-		pack32(dump_job_ptr->array_task_id, buffer);
+		packvar32(dump_job_ptr->array_job_id, buffer);
+		packvar32(dump_job_ptr->array_task_id, buffer);
 		if (dump_job_ptr->array_recs) {
 			build_array_str(dump_job_ptr);
-			packstr(dump_job_ptr->array_recs->task_id_str, buffer);
-			pack32(dump_job_ptr->array_recs->max_run_tasks, buffer);
+			packvarstr(dump_job_ptr->array_recs->task_id_str, buffer);
+			packvar32(dump_job_ptr->array_recs->max_run_tasks, buffer);
 		} else {
 			job_record_t *array_head = NULL;
-			packnull(buffer);
+			packvarnull(buffer);
 			if (dump_job_ptr->array_job_id) {
 				array_head = find_job_record(
 					dump_job_ptr->array_job_id);
 			}
 			if (array_head && array_head->array_recs) {
-				pack32(array_head->array_recs->max_run_tasks,
+				packvar32(array_head->array_recs->max_run_tasks,
 				       buffer);
 			} else {
-				pack32((uint32_t)0, buffer);
+				packvar32((uint32_t)0, buffer);
 			}
 		}
 
-		pack32(dump_job_ptr->assoc_id, buffer);
-		packstr(dump_job_ptr->container, buffer);
-		pack32(dump_job_ptr->delay_boot, buffer);
-		pack32(dump_job_ptr->job_id, buffer);
-		pack32(dump_job_ptr->user_id, buffer);
-		pack32(dump_job_ptr->group_id, buffer);
-		pack32(dump_job_ptr->het_job_id, buffer);
-		packstr(dump_job_ptr->het_job_id_set, buffer);
-		pack32(dump_job_ptr->het_job_offset, buffer);
-		pack32(dump_job_ptr->profile, buffer);
+		packvar32(dump_job_ptr->assoc_id, buffer);
+		packvarstr(dump_job_ptr->container, buffer);
+		packvar32(dump_job_ptr->delay_boot, buffer);
+		packvar32(dump_job_ptr->job_id, buffer);
+		packvar32(dump_job_ptr->user_id, buffer);
+		packvar32(dump_job_ptr->group_id, buffer);
+		packvar32(dump_job_ptr->het_job_id, buffer);
+		packvarstr(dump_job_ptr->het_job_id_set, buffer);
+		packvar32(dump_job_ptr->het_job_offset, buffer);
+		packvar32(dump_job_ptr->profile, buffer);
 
-		pack32(dump_job_ptr->job_state, buffer);
+		packvar32(dump_job_ptr->job_state, buffer);
 		pack16(dump_job_ptr->batch_flag, buffer);
 		pack16(dump_job_ptr->state_reason, buffer);
 		pack8(dump_job_ptr->power_flags, buffer);
 		pack8(dump_job_ptr->reboot, buffer);
 		pack16(dump_job_ptr->restart_cnt, buffer);
 		pack16(show_flags, buffer);
-		pack_time(dump_job_ptr->deadline, buffer);
+		packvar_time(dump_job_ptr->deadline, buffer);
 
-		pack32(dump_job_ptr->alloc_sid, buffer);
+		packvar32(dump_job_ptr->alloc_sid, buffer);
 		if ((dump_job_ptr->time_limit == NO_VAL) &&
 		    dump_job_ptr->part_ptr)
 			time_limit = dump_job_ptr->part_ptr->max_time;
 		else
 			time_limit = dump_job_ptr->time_limit;
 
-		pack32(time_limit, buffer);
-		pack32(dump_job_ptr->time_min, buffer);
+		packvar32(time_limit, buffer);
+		packvar32(dump_job_ptr->time_min, buffer);
 
 		if (dump_job_ptr->details) {
-			pack32(dump_job_ptr->details->nice, buffer);
-			pack_time(dump_job_ptr->details->submit_time, buffer);
+			packvar32(dump_job_ptr->details->nice, buffer);
+			packvar_time(dump_job_ptr->details->submit_time, buffer);
 			/* Earliest possible begin time */
 			begin_time = dump_job_ptr->details->begin_time;
 			/* When we started accruing time for priority */
 			accrue_time = dump_job_ptr->details->accrue_time;
 		} else { /* Some job details may be purged after completion */
-			pack32(NICE_OFFSET, buffer); /* Best guess */
-			pack_time((time_t)0, buffer);
+			packvar32(NICE_OFFSET, buffer); /* Best guess */
+			packvar_time((time_t)0, buffer);
 		}
 
-		pack_time(begin_time, buffer);
-		pack_time(accrue_time, buffer);
+		packvar_time(begin_time, buffer);
+		packvar_time(accrue_time, buffer);
 
 		if (IS_JOB_STARTED(dump_job_ptr)) {
 			/* Report actual start time, in past */
@@ -10291,10 +11454,11 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 			end_time = dump_job_ptr->end_time;
 		} else if (dump_job_ptr->start_time != 0) {
 			/*
-			 * Report expected start time,
-			 * making sure that time is not in the past
+			 * Report expected start time. The client moves a time
+			 * in the past up to the message's last_update, so the
+			 * record does not change every second.
 			 */
-			start_time = MAX(dump_job_ptr->start_time, time(NULL));
+			start_time = dump_job_ptr->start_time;
 			if (time_limit != NO_VAL) {
 				end_time = MAX(dump_job_ptr->end_time,
 					       (start_time + time_limit * 60));
@@ -10307,60 +11471,56 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 					       (start_time + time_limit * 60));
 			}
 		}
-		pack_time(start_time, buffer);
-		pack_time(end_time, buffer);
+		packvar_time(start_time, buffer);
+		packvar_time(end_time, buffer);
 
-		pack_time(dump_job_ptr->suspend_time, buffer);
-		pack_time(dump_job_ptr->pre_sus_time, buffer);
-		pack_time(dump_job_ptr->resize_time, buffer);
-		pack_time(dump_job_ptr->last_sched_eval, buffer);
-		pack_time(dump_job_ptr->preempt_time, buffer);
-		pack32(dump_job_ptr->priority, buffer);
+		packvar_time(dump_job_ptr->suspend_time, buffer);
+		packvar_time(dump_job_ptr->pre_sus_time, buffer);
+		packvar_time(dump_job_ptr->resize_time, buffer);
+		packvar_time(dump_job_ptr->last_sched_eval, buffer);
+		packvar_time(dump_job_ptr->preempt_time, buffer);
+		packvar32(dump_job_ptr->priority, buffer);
 		packdouble(dump_job_ptr->billable_tres, buffer);
 
-		packstr(slurm_conf.cluster_name, buffer);
+		packvarstr(slurm_conf.cluster_name, buffer);
 		/*
 		 * Only send the allocated nodelist since we are only sending
 		 * the number of cpus and nodes that are currently allocated.
 		 */
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
-			packstr(dump_job_ptr->nodes, buffer);
-		else {
-			nodelist = bitmap2node_name(
-				dump_job_ptr->node_bitmap_cg);
-			packstr(nodelist, buffer);
-			xfree(nodelist);
-		}
+			packvarstr(dump_job_ptr->nodes, buffer);
+		else
+			_pack_nodes_cg(dump_job_ptr, buffer, protocol_version);
 
-		packstr(dump_job_ptr->sched_nodes, buffer);
+		packvarstr(dump_job_ptr->sched_nodes, buffer);
 
 		if (!IS_JOB_PENDING(dump_job_ptr) && dump_job_ptr->part_ptr)
-			packstr(dump_job_ptr->part_ptr->name, buffer);
+			packvarstr(dump_job_ptr->part_ptr->name, buffer);
 		else
-			packstr(dump_job_ptr->partition, buffer);
-		packstr(dump_job_ptr->account, buffer);
-		packstr(dump_job_ptr->admin_comment, buffer);
-		pack32(dump_job_ptr->site_factor, buffer);
-		packstr(dump_job_ptr->network, buffer);
-		packstr(dump_job_ptr->comment, buffer);
-		packstr(dump_job_ptr->container, buffer);
-		packstr(dump_job_ptr->batch_features, buffer);
-		packstr(dump_job_ptr->batch_host, buffer);
-		packstr(dump_job_ptr->burst_buffer, buffer);
-		packstr(dump_job_ptr->burst_buffer_state, buffer);
-		packstr(dump_job_ptr->system_comment, buffer);
+			packvarstr(dump_job_ptr->partition, buffer);
+		packvarstr(dump_job_ptr->account, buffer);
+		packvarstr(dump_job_ptr->admin_comment, buffer);
+		packvar32(dump_job_ptr->site_factor, buffer);
+		packvarstr(dump_job_ptr->network, buffer);
+		packvarstr(dump_job_ptr->comment, buffer);
+		packvarstr(dump_job_ptr->container, buffer);
+		packvarstr(dump_job_ptr->batch_features, buffer);
+		packvarstr(dump_job_ptr->batch_host, buffer);
+		packvarstr(dump_job_ptr->burst_buffer, buffer);
+		packvarstr(dump_job_ptr->burst_buffer_state, buffer);
+		packvarstr(dump_job_ptr->system_comment, buffer);
 
 		if (!has_qos_lock)
 			assoc_mgr_lock(&locks);
 		if (dump_job_ptr->qos_ptr)
-			packstr(dump_job_ptr->qos_ptr->name, buffer);
+			packvarstr(dump_job_ptr->qos_ptr->name, buffer);
 		else {
 			if (assoc_mgr_qos_list) {
-				packstr(slurmdb_qos_str(assoc_mgr_qos_list,
+				packvarstr(slurmdb_qos_str(assoc_mgr_qos_list,
 							dump_job_ptr->qos_id),
 					buffer);
 			} else
-				packnull(buffer);
+				packvarnull(buffer);
 		}
 
 		if (IS_JOB_STARTED(dump_job_ptr) &&
@@ -10369,38 +11529,39 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 		     PREEMPT_MODE_OFF)) {
 			time_t preemptable = acct_policy_get_preemptable_time(
 				dump_job_ptr);
-			pack_time(preemptable, buffer);
+			packvar_time(preemptable, buffer);
 		} else {
-			pack_time(0, buffer);
+			packvar_time(0, buffer);
 		}
 		if (!has_qos_lock)
 			assoc_mgr_unlock(&locks);
 
-		packstr(dump_job_ptr->licenses, buffer);
-		packstr(dump_job_ptr->state_desc, buffer);
-		packstr(dump_job_ptr->resv_name, buffer);
-		packstr(dump_job_ptr->mcs_label, buffer);
+		packvarstr(dump_job_ptr->licenses, buffer);
+		packvarstr(dump_job_ptr->state_desc, buffer);
+		packvarstr(dump_job_ptr->resv_name, buffer);
+		packvarstr(dump_job_ptr->mcs_label, buffer);
 
-		pack32(dump_job_ptr->exit_code, buffer);
-		pack32(dump_job_ptr->derived_ec, buffer);
+		packvar32(dump_job_ptr->exit_code, buffer);
+		packvar32(dump_job_ptr->derived_ec, buffer);
 
-		packstr(dump_job_ptr->gres_used, buffer);
+		packvarstr(dump_job_ptr->gres_used, buffer);
 		if (show_flags & SHOW_DETAIL) {
 			pack_job_resources(dump_job_ptr->job_resrcs, buffer,
 					   protocol_version);
 			_pack_job_gres(dump_job_ptr, buffer, protocol_version);
 		} else {
+			/* Empty job_resources_t and GRES detail array */
 			pack32(NO_VAL, buffer);
 			pack32((uint32_t)0, buffer);
 		}
 
-		packstr(dump_job_ptr->name, buffer);
-		packstr(dump_job_ptr->user_name, buffer);
-		packstr(dump_job_ptr->wckey, buffer);
-		pack32(dump_job_ptr->req_switch, buffer);
-		pack32(dump_job_ptr->wait4switch, buffer);
+		packvarstr(dump_job_ptr->name, buffer);
+		packvarstr(dump_job_ptr->user_name, buffer);
+		packvarstr(dump_job_ptr->wckey, buffer);
+		packvar32(dump_job_ptr->req_switch, buffer);
+		packvar32(dump_job_ptr->wait4switch, buffer);
 
-		packstr(dump_job_ptr->alloc_node, buffer);
+		packvarstr(dump_job_ptr->alloc_node, buffer);
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
 			pack_bit_str_hex(dump_job_ptr->node_bitmap, buffer);
 		else
@@ -10423,40 +11584,40 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 		else
 			_pack_pending_job_details(NULL, buffer,
 						  protocol_version);
-		pack64(dump_job_ptr->bit_flags, buffer);
-		packstr(dump_job_ptr->tres_fmt_alloc_str, buffer);
-		packstr(dump_job_ptr->tres_fmt_req_str, buffer);
+		packvar64(dump_job_ptr->bit_flags, buffer);
+		packvarstr(dump_job_ptr->tres_fmt_alloc_str, buffer);
+		packvarstr(dump_job_ptr->tres_fmt_req_str, buffer);
 		pack16(dump_job_ptr->start_protocol_ver, buffer);
 
 		if (dump_job_ptr->fed_details) {
-			packstr(dump_job_ptr->fed_details->origin_str, buffer);
-			pack64(dump_job_ptr->fed_details->siblings_active,
+			packvarstr(dump_job_ptr->fed_details->origin_str, buffer);
+			packvar64(dump_job_ptr->fed_details->siblings_active,
 			       buffer);
-			packstr(dump_job_ptr->fed_details->siblings_active_str,
+			packvarstr(dump_job_ptr->fed_details->siblings_active_str,
 				buffer);
-			pack64(dump_job_ptr->fed_details->siblings_viable,
+			packvar64(dump_job_ptr->fed_details->siblings_viable,
 			       buffer);
-			packstr(dump_job_ptr->fed_details->siblings_viable_str,
+			packvarstr(dump_job_ptr->fed_details->siblings_viable_str,
 				buffer);
 		} else {
-			packnull(buffer);
-			pack64((uint64_t)0, buffer);
-			packnull(buffer);
-			pack64((uint64_t)0, buffer);
-			packnull(buffer);
-		}
-
-		packstr(dump_job_ptr->cpus_per_tres, buffer);
-		packstr(dump_job_ptr->mem_per_tres, buffer);
-		packstr(dump_job_ptr->tres_bind, buffer);
-		packstr(dump_job_ptr->tres_freq, buffer);
-		packstr(dump_job_ptr->tres_per_job, buffer);
-		packstr(dump_job_ptr->tres_per_node, buffer);
-		packstr(dump_job_ptr->tres_per_socket, buffer);
-		packstr(dump_job_ptr->tres_per_task, buffer);
+			packvarnull(buffer);
+			packvar64((uint64_t)0, buffer);
+			packvarnull(buffer);
+			packvar64((uint64_t)0, buffer);
+			packvarnull(buffer);
+		}
+
+		packvarstr(dump_job_ptr->cpus_per_tres, buffer);
+		packvarstr(dump_job_ptr->mem_per_tres, buffer);
+		packvarstr(dump_job_ptr->tres_bind, buffer);
+		packvarstr(dump_job_ptr->tres_freq, buffer);
+		packvarstr(dump_job_ptr->tres_per_job, buffer);
+		packvarstr(dump_job_ptr->tres_per_node, buffer);
+		packvarstr(dump_job_ptr->tres_per_socket, buffer);
+		packvarstr(dump_job_ptr->tres_per_task, buffer);
 
 		pack16(dump_job_ptr->mail_type, buffer);
-		packstr(dump_job_ptr->mail_user, buffer);
+		packvarstr(dump_job_ptr->mail_user, buffer);
 	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		detail_ptr = dump_job_ptr->details;
 		pack32(dump_job_ptr->array_job_id, buffer);
@@ -10560,12 +11721,8 @@ void pack_job(job_record_t *dump_job_ptr, uint16_t show_flags, buf_t *buffer,
 		 * the number of cpus and nodes that are currently allocated. */
 		if (!IS_JOB_COMPLETING(dump_job_ptr))
 			packstr(dump_job_ptr->nodes, buffer);
-		else {
-			nodelist =
-				bitmap2node_name(dump_job_ptr->node_bitmap_cg);
-			packstr(nodelist, buffer);
-			xfree(nodelist);
-		}
+		else
+			_pack_nodes_cg(dump_job_ptr, buffer, protocol_version);
 
 		packstr(dump_job_ptr->sched_nodes, buffer);
 
@@ -10762,10 +11919,10 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 
 	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
 		if (detail_ptr) {
-			packstr(detail_ptr->features, buffer);
-			packstr(detail_ptr->cluster_features, buffer);
-			packstr(detail_ptr->work_dir, buffer);
-			packstr(detail_ptr->dependency, buffer);
+			packvarstr(detail_ptr->features, buffer);
+			packvarstr(detail_ptr->cluster_features, buffer);
+			packvarstr(detail_ptr->work_dir, buffer);
+			packvarstr(detail_ptr->dependency, buffer);
 
 			if (detail_ptr->argv) {
 				char *cmd_line = NULL, *pos = NULL;
@@ -10774,43 +11931,43 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 					             (i ? " " : ""),
 						     detail_ptr->argv[i]);
 				}
-				packstr(cmd_line, buffer);
+				packvarstr(cmd_line, buffer);
 				xfree(cmd_line);
 			} else
-				packnull(buffer);
+				packvarnull(buffer);
 
 			if (IS_JOB_COMPLETING(job_ptr) && job_ptr->cpu_cnt) {
-				pack32(job_ptr->cpu_cnt, buffer);
-				pack32((uint32_t) 0, buffer);
+				packvar32(job_ptr->cpu_cnt, buffer);
+				packvar32((uint32_t) 0, buffer);
 			} else if (job_ptr->total_cpus &&
 				   !IS_JOB_PENDING(job_ptr)) {
 				/* If job is PENDING ignore total_cpus,
 				 * which may have been set by previous run
 				 * followed by job requeue. */
-				pack32(job_ptr->total_cpus, buffer);
-				pack32((uint32_t) 0, buffer);
+				packvar32(job_ptr->total_cpus, buffer);
+				packvar32((uint32_t) 0, buffer);
 			} else {
-				pack32(detail_ptr->min_cpus, buffer);
+				packvar32(detail_ptr->min_cpus, buffer);
 				if (detail_ptr->max_cpus != NO_VAL)
-					pack32(detail_ptr->max_cpus, buffer);
+					packvar32(detail_ptr->max_cpus, buffer);
 				else
-					pack32((uint32_t) 0, buffer);
+					packvar32((uint32_t) 0, buffer);
 			}
 
 			if (IS_JOB_COMPLETING(job_ptr) && job_ptr->node_cnt) {
-				pack32(job_ptr->node_cnt, buffer);
-				pack32((uint32_t) 0, buffer);
+				packvar32(job_ptr->node_cnt, buffer);
+				packvar32((uint32_t) 0, buffer);
 			} else if (job_ptr->total_nodes) {
-				pack32(job_ptr->total_nodes, buffer);
-				pack32((uint32_t) 0, buffer);
+				packvar32(job_ptr->total_nodes, buffer);
+				packvar32((uint32_t) 0, buffer);
 			} else if (job_ptr->node_cnt_wag) {
 				/* This should catch everything else, but
 				 * just in case this is 0 (startup or
 				 * whatever) we will keep the rest of
 				 * this if statement around.
 				 */
-				pack32(job_ptr->node_cnt_wag, buffer);
-				pack32((uint32_t) detail_ptr->max_nodes,
+				packvar32(job_ptr->node_cnt_wag, buffer);
+				packvar32((uint32_t) detail_ptr->max_nodes,
 				       buffer);
 			} else if (detail_ptr->ntasks_per_node) {
 				/* min_nodes based upon task count and ntasks
@@ -10820,8 +11977,8 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 					    detail_ptr->ntasks_per_node;
 				min_nodes = MAX(min_nodes,
 						detail_ptr->min_nodes);
-				pack32(min_nodes, buffer);
-				pack32(detail_ptr->max_nodes, buffer);
+				packvar32(min_nodes, buffer);
+				packvar32(detail_ptr->max_nodes, buffer);
 			} else if (detail_ptr->cpus_per_task > 1) {
 				/* min_nodes based upon task count and cpus
 				 * per task */
@@ -10835,8 +11992,8 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 						detail_ptr->min_nodes);
 				if (detail_ptr->num_tasks % ntasks_per_node)
 					min_nodes++;
-				pack32(min_nodes, buffer);
-				pack32(detail_ptr->max_nodes, buffer);
+				packvar32(min_nodes, buffer);
+				packvar32(detail_ptr->max_nodes, buffer);
 			} else if (detail_ptr->mc_ptr &&
 				   detail_ptr->mc_ptr->ntasks_per_core &&
 				   (detail_ptr->mc_ptr->ntasks_per_core
@@ -10853,8 +12010,8 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 				min_nodes /= max_core_cnt;
 				min_nodes = MAX(min_nodes,
 						detail_ptr->min_nodes);
-				pack32(min_nodes, buffer);
-				pack32(detail_ptr->max_nodes, buffer);
+				packvar32(min_nodes, buffer);
+				packvar32(detail_ptr->max_nodes, buffer);
 			} else {
 				/* min_nodes based upon task count only */
 				uint32_t min_nodes;
@@ -10863,56 +12020,56 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 				min_nodes /= max_cpu_cnt;
 				min_nodes = MAX(min_nodes,
 						detail_ptr->min_nodes);
-				pack32(min_nodes, buffer);
-				pack32(detail_ptr->max_nodes, buffer);
+				packvar32(min_nodes, buffer);
+				packvar32(detail_ptr->max_nodes, buffer);
 			}
 
 			pack16(detail_ptr->requeue,   buffer);
 			pack16(detail_ptr->ntasks_per_node, buffer);
 			pack16(detail_ptr->ntasks_per_tres, buffer);
 			if (detail_ptr->num_tasks)
-				pack32(detail_ptr->num_tasks, buffer);
+				packvar32(detail_ptr->num_tasks, buffer);
 			else if (IS_JOB_PENDING(job_ptr))
-				pack32(detail_ptr->min_nodes, buffer);
+				packvar32(detail_ptr->min_nodes, buffer);
 			else if (job_ptr->tres_alloc_cnt)
-				pack32((uint32_t)
+				packvar32((uint32_t)
 				       job_ptr->tres_alloc_cnt[TRES_ARRAY_NODE],
 				       buffer);
 			else
-				pack32(NO_VAL, buffer);
+				packvar32(NO_VAL, buffer);
 
 			pack16(shared, buffer);
-			pack32(detail_ptr->cpu_freq_min, buffer);
-			pack32(detail_ptr->cpu_freq_max, buffer);
-			pack32(detail_ptr->cpu_freq_gov, buffer);
+			packvar32(detail_ptr->cpu_freq_min, buffer);
+			packvar32(detail_ptr->cpu_freq_max, buffer);
+			packvar32(detail_ptr->cpu_freq_gov, buffer);
 
 			if (detail_ptr->crontab_entry)
-				packstr(detail_ptr->crontab_entry->cronspec,
+				packvarstr(detail_ptr->crontab_entry->cronspec,
 					buffer);
 			else
-				packnull(buffer);
+				packvarnull(buffer);
 		} else {
-			packnull(buffer);
-			packnull(buffer);
-			packnull(buffer);
-			packnull(buffer);
+			packvarnull(buffer);
+			packvarnull(buffer);
+			packvarnull(buffer);
+			packvarnull(buffer);
 
 			if (job_ptr->total_cpus)
-				pack32(job_ptr->total_cpus, buffer);
+				packvar32(job_ptr->total_cpus, buffer);
 			else
-				pack32(job_ptr->cpu_cnt, buffer);
-			pack32((uint32_t) 0, buffer);
+				packvar32(job_ptr->cpu_cnt, buffer);
+			packvar32((uint32_t) 0, buffer);
 
-			pack32(job_ptr->node_cnt, buffer);
-			pack32((uint32_t) 0, buffer);
+			packvar32(job_ptr->node_cnt, buffer);
+			packvar32((uint32_t) 0, buffer);
 			pack16((uint16_t) 0, buffer);
 			pack16((uint16_t) 0, buffer);
 			pack16((uint16_t) 0, buffer);
-			pack32((uint32_t) 0, buffer);
-			pack32((uint32_t) 0, buffer);
-			pack32((uint32_t) 0, buffer);
+			packvar32((uint32_t) 0, buffer);
+			packvar32((uint32_t) 0, buffer);
+			packvar32((uint32_t) 0, buffer);
 
-			packnull(buffer);
+			packvarnull(buffer);
 		}
 	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		if (detail_ptr) {
@@ -11218,7 +12375,48 @@ static void _pack_default_job_details(job_record_t *job_ptr, buf_t *buffer,
 static void _pack_pending_job_details(struct job_details *detail_ptr,
 				      buf_t *buffer, uint16_t protocol_version)
 {
-	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
+	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+		if (detail_ptr) {
+			pack16(detail_ptr->contiguous, buffer);
+			pack16(detail_ptr->core_spec, buffer);
+			pack16(detail_ptr->cpus_per_task, buffer);
+			pack16(detail_ptr->pn_min_cpus, buffer);
+
+			packvar64(detail_ptr->pn_min_memory, buffer);
+			packvar32(detail_ptr->pn_min_tmp_disk, buffer);
+
+			packvarstr(detail_ptr->req_nodes, buffer);
+			pack_bit_str_hex(detail_ptr->req_node_bitmap, buffer);
+			packvarstr(detail_ptr->exc_nodes, buffer);
+			pack_bit_str_hex(detail_ptr->exc_node_bitmap, buffer);
+
+			packvarstr(detail_ptr->std_err, buffer);
+			packvarstr(detail_ptr->std_in, buffer);
+			packvarstr(detail_ptr->std_out, buffer);
+
+			pack_multi_core_data(detail_ptr->mc_ptr, buffer,
+					     protocol_version);
+		} else {
+			pack16((uint16_t) 0, buffer);
+			pack16((uint16_t) 0, buffer);
+			pack16((uint16_t) 0, buffer);
+			pack16((uint16_t) 0, buffer);
+
+			packvar64((uint64_t) 0, buffer);
+			packvar32((uint32_t) 0, buffer);
+
+			packvarnull(buffer);
+			pack_bit_str_hex(NULL, buffer);
+			packvarnull(buffer);
+			pack_bit_str_hex(NULL, buffer);
+
+			packvarnull(buffer);
+			packvarnull(buffer);
+			packvarnull(buffer);
+
+			pack_multi_core_data(NULL, buffer, protocol_version);
+		}
+	} else if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
 		if (detail_ptr) {
 			pack16(detail_ptr->contiguous, buffer);
 			pack16(detail_ptr->core_spec, buffer);
@@ -11431,6 +12629,7 @@ extern void unlink_job_record(job_record_t *job_ptr)
 	xassert(job_ptr->magic == JOB_MAGIC);
 
 	_delete_job_common(job_ptr);
+	job_pack_cache_clear(job_ptr);
 
 	job_id = xmalloc(sizeof(uint32_t));
 	*job_id = job_ptr->job_id;
@@ -11645,6 +12844,7 @@ static void _reset_step_bitmaps(job_record_t *job_ptr)
 	ListIterator step_iterator;
 	step_record_t *step_ptr;
 
+	step_cache_free(job_ptr);
 	step_iterator = list_iterator_create (job_ptr->step_list);
 	while ((step_ptr = list_next(step_iterator))) {
 		if (step_ptr->state < JOB_RUNNING)
@@ -12175,6 +13375,8 @@ static int _update_job(job_record_t *job_ptr, job_desc_msg_t *job_specs,
 	if (job_ptr->bit_flags & CRON_JOB)
 		return ESLURM_CANNOT_MODIFY_CRON_JOB;
 
+	job_pack_cache_clear(job_ptr);
+
 	/*
 	 * This means we are in the middle of requesting the db_inx from the
 	 * database. So we can't update right now.  You should try again outside
@@ -14532,6 +15734,8 @@ extern int update_job_str(slurm_msg_t *msg, uid_t uid)
 	slurm_msg_t resp_msg;
 	job_desc_msg_t *job_specs = (job_desc_msg_t *) msg->data;
 	job_record_t *job_ptr, *new_job_ptr, *het_job;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 	char *hostname = auth_g_get_host(msg->auth_cred);
 	ListIterator iter;
 	long int long_id;
@@ -14608,15 +15812,14 @@ extern int update_job_str(slurm_msg_t *msg, uid_t uid)
 		}
 
 		/* Update all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
-		if (!job_ptr && !job_ptr_done) {
+		array_index = _job_hash_find(&job_array_hash, job_id);
+		if (!array_index && !job_ptr_done) {
 			info("%s: invalid JobId=%u", __func__, job_id);
 			rc = ESLURM_INVALID_JOB_ID;
 			goto reply;
 		}
-		while (job_ptr) {
-			if ((job_ptr->array_job_id == job_id) &&
-			    (job_ptr != job_ptr_done)) {
+		while ((job_ptr = _next_array_task(array_index, &inx))) {
+			if (job_ptr != job_ptr_done) {
 				rc2 = _update_job(job_ptr, job_specs, uid);
 				if (rc2 == ESLURM_JOB_SETTING_DB_INX) {
 					rc = rc2;
@@ -14624,7 +15827,6 @@ extern int update_job_str(slurm_msg_t *msg, uid_t uid)
 				}
 				_resp_array_add(&resp_array, job_ptr, rc2);
 			}
-			job_ptr = job_ptr->job_array_next_j;
 		}
 		goto reply;
 	} else if (end_ptr[0] == '+') {	/* Hetjob element */
@@ -14928,7 +16130,8 @@ extern void job_post_resize_acctg(job_record_t *job_ptr)
  * IN reg_msg - node registration message
  */
 extern void
-validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
+validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg,
+		      bool defer_purge)
 {
 	int i, node_inx, jobs_on_node;
 	node_record_t *node_ptr;
@@ -15057,7 +16260,18 @@ validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg)
 	}
 
 	jobs_on_node = node_ptr->run_job_cnt + node_ptr->comp_job_cnt;
-	if (jobs_on_node)
+	if (jobs_on_node && defer_purge) {
+		if (purge_node_bitmap &&
+		    (bit_size(purge_node_bitmap) != node_record_count))
+			purge_missing_jobs_deferred();
+		if (!purge_node_bitmap) {
+			purge_node_bitmap = bit_alloc(node_record_count);
+			purge_node_time = xcalloc(node_record_count,
+						  sizeof(time_t));
+		}
+		bit_set(purge_node_bitmap, node_inx);
+		purge_node_time[node_inx] = now;
+	} else if (jobs_on_node)
 		_purge_missing_jobs(node_inx, now);
 
 	if (jobs_on_node != reg_msg->job_count) {
@@ -15085,6 +16299,68 @@ static void _purge_missing_jobs(int node_inx, time_t now)
 {
 	ListIterator job_iterator;
 	job_record_t *job_ptr;
+
+	job_iterator = list_iterator_create(job_list);
+	while ((job_ptr = list_next(job_iterator))) {
+		if ((IS_JOB_CONFIGURING(job_ptr) ||
+		    (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))) ||
+		    (!bit_test(job_ptr->node_bitmap, node_inx)))
+			continue;
+		_purge_missing_job(job_ptr, node_inx, now);
+	}
+	list_iterator_destroy(job_iterator);
+}
+
+/*
+ * Purge missing jobs for every node registered since the last call with
+ * defer_purge set in validate_jobs_on_node(). A storm of registrations
+ * processed as one RPC queue batch then walks job_list once rather than
+ * once per node.
+ * NOTE: Call with job and node write locks held.
+ */
+extern void purge_missing_jobs_deferred(void)
+{
+	ListIterator job_iterator;
+	job_record_t *job_ptr;
+	int i, i_first, i_last;
+
+	if (!purge_node_bitmap)
+		return;
+
+	i_first = bit_ffs(purge_node_bitmap);
+	i_last = bit_fls(purge_node_bitmap);
+
+	job_iterator = list_iterator_create(job_list);
+	while ((i_first >= 0) && (job_ptr = list_next(job_iterator))) {
+		if ((IS_JOB_CONFIGURING(job_ptr) ||
+		    (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))) ||
+		    !job_ptr->node_bitmap ||
+		    !bit_overlap_any(job_ptr->node_bitmap, purge_node_bitmap))
+			continue;
+		for (i = i_first; i <= i_last; i++) {
+			if (!bit_test(purge_node_bitmap, i) ||
+			    !bit_test(job_ptr->node_bitmap, i))
+				continue;
+			/* An earlier node may have completed the job */
+			if (!IS_JOB_RUNNING(job_ptr) &&
+			    !IS_JOB_SUSPENDED(job_ptr))
+				break;
+			_purge_missing_job(job_ptr, i, purge_node_time[i]);
+		}
+	}
+	list_iterator_destroy(job_iterator);
+
+	FREE_NULL_BITMAP(purge_node_bitmap);
+	xfree(purge_node_time);
+}
+
+/*
+ * Purge job_ptr if it is a batch job that should have its script running on
+ * node_inx but is not, otherwise check its steps on the node.
+ */
+static void _purge_missing_job(job_record_t *job_ptr, int node_inx,
+			       time_t now)
+{
 	node_record_t *node_ptr = node_record_table_ptr + node_inx;
 	time_t batch_startup_time, node_boot_time = (time_t) 0, startup_time;
 
@@ -15096,42 +16372,34 @@ static void _purge_missing_jobs(int node_inx, time_t now)
 	batch_startup_time  = now - slurm_conf.batch_start_timeout;
 	batch_startup_time -= MIN(DEFAULT_MSG_TIMEOUT, slurm_conf.msg_timeout);
 
-	job_iterator = list_iterator_create(job_list);
-	while ((job_ptr = list_next(job_iterator))) {
-		if ((IS_JOB_CONFIGURING(job_ptr) ||
-		    (!IS_JOB_RUNNING(job_ptr) && !IS_JOB_SUSPENDED(job_ptr))) ||
-		    (!bit_test(job_ptr->node_bitmap, node_inx)))
-			continue;
-		if ((job_ptr->batch_flag != 0)			&&
-		    (slurm_conf.suspend_time != 0) /* power mgmt on */	&&
-		    (job_ptr->start_time < node_boot_time)) {
-			startup_time = batch_startup_time -
-				slurm_conf.resume_timeout;
-		} else
-			startup_time = batch_startup_time;
-
-		if ((job_ptr->batch_flag != 0)			&&
-		    (job_ptr->het_job_offset == 0)		&&
-		    (job_ptr->time_last_active < startup_time)	&&
-		    (job_ptr->start_time       < startup_time)	&&
-		    (node_ptr == find_node_record(job_ptr->batch_host))) {
-			bool requeue = false;
-			char *requeue_msg = "";
-			if (job_ptr->details && job_ptr->details->requeue) {
-				requeue = true;
-				requeue_msg = ", Requeuing job";
-			}
-			info("Batch %pJ missing from batch node %s (not found BatchStartTime after startup)%s",
-			     job_ptr, job_ptr->batch_host, requeue_msg);
-			job_ptr->exit_code = 1;
-			job_complete(job_ptr->job_id, slurm_conf.slurm_user_id,
-			             requeue, true, NO_VAL);
-		} else {
-			_notify_srun_missing_step(job_ptr, node_inx,
-						  now, node_boot_time);
-		}
+	if ((job_ptr->batch_flag != 0)			&&
+	    (slurm_conf.suspend_time != 0) /* power mgmt on */	&&
+	    (job_ptr->start_time < node_boot_time)) {
+		startup_time = batch_startup_time -
+			slurm_conf.resume_timeout;
+	} else
+		startup_time = batch_startup_time;
+
+	if ((job_ptr->batch_flag != 0)			&&
+	    (job_ptr->het_job_offset == 0)		&&
+	    (job_ptr->time_last_active < startup_time)	&&
+	    (job_ptr->start_time       < startup_time)	&&
+	    (node_ptr == find_node_record(job_ptr->batch_host))) {
+		bool requeue = false;
+		char *requeue_msg = "";
+		if (job_ptr->details && job_ptr->details->requeue) {
+			requeue = true;
+			requeue_msg = ", Requeuing job";
+		}
+		info("Batch %pJ missing from batch node %s (not found BatchStartTime after startup)%s",
+		     job_ptr, job_ptr->batch_host, requeue_msg);
+		job_ptr->exit_code = 1;
+		job_complete(job_ptr->job_id, slurm_conf.slurm_user_id,
+		             requeue, true, NO_VAL);
+	} else {
+		_notify_srun_missing_step(job_ptr, node_inx,
+					  now, node_boot_time);
 	}
-	list_iterator_destroy(job_iterator);
 }
 
 static void _notify_srun_missing_step(job_record_t *job_ptr, int node_inx,
@@ -15472,6 +16740,21 @@ int sync_job_files(void)
 	return SLURM_SUCCESS;
 }
 
+/* Remove a blob file left without job references, e.g. after a crash */
+static void _remove_orphan_blob(char *hash_dir, char *blob)
+{
+	char *blob_name;
+	struct stat sbuf;
+
+	blob_name = xstrdup_printf("%s/%s/%s", slurm_conf.state_save_location,
+				   hash_dir, blob);
+	if (!stat(blob_name, &sbuf) && (sbuf.st_nlink == 1)) {
+		debug3("Removing unreferenced %s", blob_name);
+		(void) unlink(blob_name);
+	}
+	xfree(blob_name);
+}
+
 /* Append to the batch_dirs list the job_id's associated with
  *	every batch job directory in existence
  */
@@ -15503,6 +16786,11 @@ static void _get_batch_job_dir_ids(List batch_dirs)
 			if (!h_dir)
 				continue;
 			while ((hash_ent = readdir(h_dir))) {
+				if (!xstrncmp("blob.", hash_ent->d_name, 5)) {
+					_remove_orphan_blob(dir_ent->d_name,
+							    hash_ent->d_name);
+					continue;
+				}
 				if (xstrncmp("job.#", hash_ent->d_name, 4))
 					continue;
 				long_job_id = strtol(&hash_ent->d_name[4],
@@ -15559,8 +16847,9 @@ static int _test_state_dir_flag(void *x, void *arg)
 static void _validate_job_files(List batch_dirs)
 {
 	job_record_t *job_ptr;
+	job_array_index_t *array_index;
 	ListIterator batch_dir_iter;
-	uint32_t *job_id_ptr, array_job_id;
+	uint32_t *job_id_ptr, array_job_id, inx;
 
 	list_for_each(job_list, _clear_state_dir_flag, NULL);
 
@@ -15573,12 +16862,11 @@ static void _validate_job_files(List batch_dirs)
 		}
 		if (job_ptr && job_ptr->array_recs) { /* Update all tasks */
 			array_job_id = job_ptr->array_job_id;
-			job_ptr = job_array_hash_j[JOB_HASH_INX(array_job_id)];
-			while (job_ptr) {
-				if (job_ptr->array_job_id == array_job_id)
-					job_ptr->bit_flags |= HAS_STATE_DIR;
-				job_ptr = job_ptr->job_array_next_j;
-			}
+			array_index = _job_hash_find(&job_array_hash,
+						     array_job_id);
+			inx = 0;
+			while ((job_ptr = _next_array_task(array_index, &inx)))
+				job_ptr->bit_flags |= HAS_STATE_DIR;
 		}
 	}
 	list_iterator_destroy(batch_dir_iter);
@@ -15875,12 +17163,16 @@ void batch_requeue_fini(job_record_t *job_ptr)
 void job_fini (void)
 {
 	FREE_NULL_LIST(job_list);
-	xfree(job_hash);
-	xfree(job_array_hash_j);
-	xfree(job_array_hash_t);
+	xfree(job_hash.slots);
+	memset(&job_hash, 0, sizeof(job_hash));
+	xfree(job_array_hash.slots);
+	memset(&job_array_hash, 0, sizeof(job_array_hash));
 	FREE_NULL_LIST(purge_files_list);
 	FREE_NULL_BITMAP(requeue_exit);
 	FREE_NULL_BITMAP(requeue_exit_hold);
+	FREE_NULL_BITMAP(purge_node_bitmap);
+	xfree(purge_node_time);
+	_job_snapshot_fini();
 }
 
 /* Record the start of one job array task */
@@ -16784,6 +18076,8 @@ extern int job_suspend2(suspend_msg_t *sus_ptr, uid_t uid,
 	bitstr_t *array_bitmap = NULL;
 	bool valid = true;
 	int32_t i, i_first, i_last;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 	slurm_msg_t resp_msg;
 	return_code_msg_t rc_msg;
 	resp_array_struct_t *resp_array = NULL;
@@ -16834,19 +18128,17 @@ extern int job_suspend2(suspend_msg_t *sus_ptr, uid_t uid,
 		}
 
 		/* Suspend all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
-		if (!job_ptr && !job_ptr_done) {
+		array_index = _job_hash_find(&job_array_hash, job_id);
+		if (!array_index && !job_ptr_done) {
 			rc = ESLURM_INVALID_JOB_ID;
 			goto reply;
 		}
-		while (job_ptr) {
-			if ((job_ptr->array_job_id == job_id) &&
-			    (job_ptr != job_ptr_done)) {
+		while ((job_ptr = _next_array_task(array_index, &inx))) {
+			if (job_ptr != job_ptr_done) {
 				rc2 = _job_suspend(job_ptr, sus_ptr->op,
 						   indf_susp);
 				_resp_array_add(&resp_array, job_ptr, rc2);
 			}
-			job_ptr = job_ptr->job_array_next_j;
 		}
 		goto reply;
 	}
@@ -17256,6 +18548,8 @@ extern int job_requeue2(uid_t uid, requeue_msg_t *req_ptr, slurm_msg_t *msg,
 	bitstr_t *array_bitmap = NULL;
 	bool valid = true;
 	int32_t i, i_first, i_last;
+	job_array_index_t *array_index;
+	uint32_t inx = 0;
 	slurm_msg_t resp_msg;
 	return_code_msg_t rc_msg;
 	uint32_t flags = req_ptr->flags;
@@ -17299,18 +18593,16 @@ extern int job_requeue2(uid_t uid, requeue_msg_t *req_ptr, slurm_msg_t *msg,
 		}
 
 		/* Requeue all tasks of this job array */
-		job_ptr = job_array_hash_j[JOB_HASH_INX(job_id)];
-		if (!job_ptr && !job_ptr_done) {
+		array_index = _job_hash_find(&job_array_hash, job_id);
+		if (!array_index && !job_ptr_done) {
 			rc = ESLURM_INVALID_JOB_ID;
 			goto reply;
 		}
-		while (job_ptr) {
-			if ((job_ptr->array_job_id == job_id) &&
-			    (job_ptr != job_ptr_done)) {
+		while ((job_ptr = _next_array_task(array_index, &inx))) {
+			if (job_ptr != job_ptr_done) {
 				rc2 = _job_requeue(uid, job_ptr, preempt,flags);
 				_resp_array_add(&resp_array, job_ptr, rc2);
 			}
-			job_ptr = job_ptr->job_array_next_j;
 		}
 		goto reply;
 	}
@@ -18526,7 +19818,7 @@ extern void set_remote_working_response(
 	xassert(resp);
 	xassert(job_ptr);
 
-	if (job_ptr->node_cnt && req_cluster &&
+	if (job_ptr->node_cnt && job_ptr->node_addr && req_cluster &&
 	    xstrcmp(slurm_conf.cluster_name, req_cluster)) {
 		if (job_ptr->fed_details &&
 		    fed_mgr_cluster_rec) {
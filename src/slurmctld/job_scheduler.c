@@ -64,6 +64,7 @@
 #include "src/common/node_select.h"
 #include "src/common/prep.h"
 #include "src/common/power.h"
+#include "src/common/probes.h"
 #include "src/common/slurm_accounting_storage.h"
 #include "src/common/slurm_acct_gather.h"
 #include "src/common/strlcpy.h"
@@ -90,6 +91,7 @@
 #include "src/slurmctld/preempt.h"
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/sched_trace.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/srun_comm.h"
 #include "src/slurmctld/state_save.h"
@@ -134,6 +136,7 @@ static uint16_t bf_hetjob_prio = 0;
 static int sched_min_interval = 2;
 
 static int bb_array_stage_cnt = 10;
+static List sched_plan_list = NULL;	/* protected by job write lock */
 extern diag_stats_t slurmctld_diag_stats;
 
 static int _find_singleton_job (void *x, void *key)
@@ -350,6 +353,20 @@ static bool _job_runnable_test1(job_record_t *job_ptr, bool sched_plugin)
 	return true;
 }
 
+/*
+ * Test if a job was last found to be waiting only for its begin time (e.g. a
+ * scrontab entry or a job submitted with --begin) and that time is still in
+ * the future. Until then _job_runnable_test1() would find the same, so the
+ * job can be skipped without testing it again.
+ */
+static bool _job_wait_begin_time(job_record_t *job_ptr, time_t now)
+{
+	return ((job_ptr->state_reason == WAIT_TIME) &&
+		job_ptr->details && (job_ptr->details->begin_time > now) &&
+		!job_ptr->details->depend_list && job_ptr->priority &&
+		IS_JOB_PENDING(job_ptr) && !IS_JOB_COMPLETING(job_ptr));
+}
+
 /*
  * Job and partition tests for ability to run now
  * IN job_ptr - job to test
@@ -582,10 +599,15 @@ extern List build_job_queue(bool clear_start, bool backfill)
 			}
 			break;
 		}
-		tested_jobs++;
 		job_ptr->preempt_in_progress = false;	/* initialize */
 		if (job_ptr->array_recs)
 			job_ptr->array_recs->pend_run_tasks = 0;
+		if (_job_wait_begin_time(job_ptr, now)) {
+			if (clear_start)
+				job_ptr->start_time = (time_t) 0;
+			continue;
+		}
+		tested_jobs++;
 		if (job_ptr->state_reason != WAIT_NO_REASON) {
 			if ((job_ptr->state_reason != WAIT_PRIORITY) &&
 			    (job_ptr->state_reason != WAIT_RESOURCES))
@@ -736,6 +758,103 @@ extern void set_job_elig_time(void)
 	unlock_slurmctld(job_write_lock);
 }
 
+/*
+ * Job shape which failed to start during this _schedule() cycle, used with
+ * SchedulerParameters=sched_job_shape_cache
+ */
+typedef struct {
+	char *key;		/* from job_shape_key() */
+	int error_code;		/* select_nodes() return code */
+	uint32_t state_reason;	/* reason set for the job which failed */
+} failed_shape_t;
+
+static void _failed_shape_free(void *x)
+{
+	failed_shape_t *shape_ptr = x;
+
+	xfree(shape_ptr->key);
+	xfree(shape_ptr);
+}
+
+static int _find_failed_shape(void *x, void *key)
+{
+	failed_shape_t *shape_ptr = x;
+
+	return !xstrcmp(shape_ptr->key, key);
+}
+
+/*
+ * Association/QOS pair found at a job count limit during this _schedule()
+ * cycle. Starting jobs only adds to these counts, so later jobs using the
+ * same pair are held for the same reason until a job starts (which may have
+ * preempted others) without testing the limits again.
+ */
+typedef struct {
+	slurmdb_assoc_rec_t *assoc_ptr;
+	slurmdb_qos_rec_t *qos_ptr;
+	slurmdb_qos_rec_t *part_qos_ptr;
+	uint32_t state_reason;	/* limit the first job was held by */
+} failed_limit_t;
+
+static int _find_failed_limit(void *x, void *key)
+{
+	failed_limit_t *limit_ptr = x;
+	job_record_t *job_ptr = key;
+
+	if ((limit_ptr->assoc_ptr == job_ptr->assoc_ptr) &&
+	    (limit_ptr->qos_ptr == job_ptr->qos_ptr) &&
+	    (limit_ptr->part_qos_ptr == job_ptr->part_ptr->qos_ptr))
+		return 1;
+	return 0;
+}
+
+/* Return true if state_reason is a limit on the count of running jobs */
+static bool _job_cnt_limit_reason(uint32_t state_reason)
+{
+	switch (state_reason) {
+	case WAIT_ASSOC_GRP_JOB:
+	case WAIT_ASSOC_MAX_JOBS:
+	case WAIT_QOS_GRP_JOB:
+	case WAIT_QOS_MAX_JOB_PER_ACCT:
+	case WAIT_QOS_MAX_JOB_PER_USER:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Return true if a job which can not start should not stop lower priority jobs
+ * in its partition from starting, because it has been waiting for less than
+ * bf_min_age_reserve or its priority is below bf_min_prio_reserve (or the
+ * priority threshold of its QOS)
+ */
+static bool _no_part_reserve(job_record_t *job_ptr, time_t now,
+			     int bf_min_age_reserve,
+			     uint32_t bf_min_prio_reserve)
+{
+	uint32_t prio_reserve;
+	int pend_time;
+
+	if (bf_min_age_reserve) {
+		/* Consider other jobs in this partition if job has been
+		 * waiting for less than bf_min_age_reserve time */
+		if (job_ptr->details->begin_time == 0)
+			return true;
+		pend_time = difftime(now, job_ptr->details->begin_time);
+		if (pend_time < bf_min_age_reserve)
+			return true;
+	}
+
+	if (!(prio_reserve = acct_policy_get_prio_thresh(job_ptr, false)))
+		prio_reserve = bf_min_prio_reserve;
+
+	if (prio_reserve && (job_ptr->priority < prio_reserve))
+		return true;
+
+	return false;
+}
+
 /* Test of part_ptr can still run jobs or if its nodes have
  * already been reserved by higher priority jobs (those in
  * the failed_parts array) */
@@ -988,6 +1107,50 @@ extern void fill_array_reasons(job_record_t *job_ptr,
 	}
 }
 
+extern char *job_shape_key(job_record_t *job_ptr)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	multi_core_data_t *mc_ptr;
+	char *key = NULL;
+
+	if (!detail_ptr || job_ptr->het_job_id || job_ptr->resv_name ||
+	    job_ptr->resv_ptr || job_ptr->burst_buffer ||
+	    (job_ptr->deadline && (job_ptr->deadline != NO_VAL)) ||
+	    detail_ptr->req_node_bitmap || detail_ptr->exc_node_bitmap)
+		return NULL;
+
+	xstrfmtcat(key, "%p:%p:%p:%u:%u:%u:%"PRIx64":%u",
+		   job_ptr->part_ptr, job_ptr->qos_ptr, job_ptr->assoc_ptr,
+		   job_ptr->user_id, job_ptr->time_limit, job_ptr->time_min,
+		   job_ptr->bit_flags, job_ptr->reboot);
+	xstrfmtcat(key, ":%u:%u:%u:%u:%u:%"PRIu64":%u:%u:%u:%u:%u:%u:%u:%u:%u:%u:%u",
+		   detail_ptr->min_nodes, detail_ptr->max_nodes,
+		   detail_ptr->min_cpus, detail_ptr->max_cpus,
+		   detail_ptr->pn_min_cpus, detail_ptr->pn_min_memory,
+		   detail_ptr->pn_min_tmp_disk, detail_ptr->cpus_per_task,
+		   detail_ptr->ntasks_per_node, detail_ptr->ntasks_per_tres,
+		   detail_ptr->num_tasks, detail_ptr->share_res,
+		   detail_ptr->whole_node, detail_ptr->contiguous,
+		   detail_ptr->core_spec, detail_ptr->overcommit,
+		   detail_ptr->task_dist);
+	if ((mc_ptr = detail_ptr->mc_ptr)) {
+		xstrfmtcat(key, ":%u:%u:%u:%u:%u:%u:%u:%u:%u",
+			   mc_ptr->boards_per_node, mc_ptr->sockets_per_board,
+			   mc_ptr->sockets_per_node, mc_ptr->cores_per_socket,
+			   mc_ptr->threads_per_core, mc_ptr->ntasks_per_board,
+			   mc_ptr->ntasks_per_socket, mc_ptr->ntasks_per_core,
+			   mc_ptr->plane_size);
+	}
+	xstrfmtcat(key, ":%s:%s:%s:%s:%s:%s:%s:%s:%s:%s",
+		   detail_ptr->features, job_ptr->tres_per_job,
+		   job_ptr->tres_per_node, job_ptr->tres_per_socket,
+		   job_ptr->tres_per_task, job_ptr->cpus_per_tres,
+		   job_ptr->mem_per_tres, job_ptr->licenses,
+		   job_ptr->mcs_label, job_ptr->network);
+
+	return key;
+}
+
 extern void job_queue_append_internal(job_queue_req_t *job_queue_req)
 {
 	job_queue_rec_t *job_queue_rec;
@@ -1007,12 +1170,92 @@ extern void job_queue_append_internal(job_queue_req_t *job_queue_req)
 	list_append(job_queue_req->job_queue, job_queue_rec);
 }
 
+static void _sched_resume_clear(part_record_t *part_ptr)
+{
+	part_ptr->sched_resume_job_id = 0;
+	part_ptr->sched_resume_prio = 0;
+	part_ptr->sched_resume_time = 0;
+}
+
+/*
+ * With sched_continue, skip records of a partition tested by an earlier cycle
+ * which stopped before reaching the end of that partition's jobs. Records are
+ * compared by priority and job ID, approximating the sort_job_queue2() order.
+ * A job ranking ahead of the resume point which was not tested since the
+ * partition's pass began has become eligible meanwhile, so the partition
+ * starts over rather than skip it.
+ */
+static bool _sched_resume_skip(job_queue_rec_t *job_queue_rec)
+{
+	part_record_t *part_ptr = job_queue_rec->part_ptr;
+
+	if (!part_ptr->sched_resume_job_id)
+		return false;
+	if ((job_queue_rec->priority < part_ptr->sched_resume_prio) ||
+	    ((job_queue_rec->priority == part_ptr->sched_resume_prio) &&
+	     (job_queue_rec->job_id > part_ptr->sched_resume_job_id)))
+		return false;
+	if (job_queue_rec->job_ptr->last_sched_eval <
+	    part_ptr->sched_resume_time) {
+		_sched_resume_clear(part_ptr);
+		return false;
+	}
+	return true;
+}
+
+static int _sched_resume_count(void *x, void *arg)
+{
+	part_record_t *part_ptr = (part_record_t *) x;
+
+	part_ptr->sched_heap_cnt = 0;
+
+	return 0;
+}
+
+/*
+ * Clear the resume point of a partition with no records left in the heap,
+ * so its next cycle starts over from its highest priority job
+ */
+static int _sched_resume_left(void *x, void *arg)
+{
+	part_record_t *part_ptr = (part_record_t *) x;
+	bool queue_done = *(bool *) arg;
+
+	if (queue_done || !part_ptr->sched_heap_cnt)
+		_sched_resume_clear(part_ptr);
+	part_ptr->sched_heap_cnt = 0;
+
+	return 0;
+}
+
+/* Count the records of each partition in the main scheduler's heap */
+static void _sched_resume_init(job_queue_heap_t *heap)
+{
+	(void) list_for_each(part_list, _sched_resume_count, NULL);
+	for (int i = 0; i < heap->rec_cnt; i++)
+		heap->rec[i]->part_ptr->sched_heap_cnt++;
+}
+
+/*
+ * Save the main scheduler's progress at the end of a cycle with
+ * sched_continue. Partitions with untested records keep their resume point,
+ * unless the cycle stopped testing them as blocked.
+ */
+static void _sched_resume_save(part_record_t **failed_parts,
+			       int failed_part_cnt, bool queue_done)
+{
+	(void) list_for_each(part_list, _sched_resume_left, &queue_done);
+	for (int i = 0; i < failed_part_cnt; i++)
+		_sched_resume_clear(failed_parts[i]);
+}
+
 static int _schedule(bool full_queue)
 {
 	ListIterator job_iterator = NULL, part_iterator = NULL;
 	List job_queue = NULL;
+	job_queue_heap_t *job_heap = NULL;
 	int failed_part_cnt = 0, failed_resv_cnt = 0, job_cnt = 0;
-	int error_code, i, j, part_cnt, time_limit, pend_time;
+	int error_code, i, j, part_cnt, time_limit;
 	uint32_t job_depth = 0, array_task_id;
 	job_queue_rec_t *job_queue_rec;
 	job_record_t *job_ptr = NULL;
@@ -1028,7 +1271,7 @@ static int _schedule(bool full_queue)
 	static time_t sched_update = 0;
 	static bool fifo_sched = false;
 	static bool assoc_limit_stop = false;
-	static int sched_timeout = 0;
+	static int sched_timeout = 0, sched_timeout_max = 0;
 	static int sched_max_job_start = 0;
 	static int bf_min_age_reserve = 0;
 	static uint32_t bf_min_prio_reserve = 0;
@@ -1036,12 +1279,21 @@ static int _schedule(bool full_queue)
 	static int max_jobs_per_part = 0;
 	static int defer_rpc_cnt = 0;
 	static bool reduce_completing_frag = false;
+	static bool sched_continue = false;
+	static bool shape_cache = false;
+	List failed_shapes = NULL;
+	failed_shape_t *shape_ptr;
+	char *shape_key = NULL;
+	List failed_limits = NULL;
+	failed_limit_t *limit_ptr;
 	time_t now, last_job_sched_start, sched_start;
 	job_record_t *reject_array_job = NULL;
 	part_record_t *reject_array_part = NULL;
 	bool fail_by_part, wait_on_resv;
 	uint32_t deadline_time_limit, save_time_limit = 0;
-	uint32_t prio_reserve;
+	uint32_t resume_job_id = 0, resume_prio = 0;
+	bool queue_done = false;
+	struct timeval phase_tv = {0, 0};
 #if HAVE_SYS_PRCTL_H
 	char get_name[16];
 #endif
@@ -1194,6 +1446,17 @@ static int _schedule(bool full_queue)
 		else
 			reduce_completing_frag = false;
 
+		if (xstrcasestr(slurm_conf.sched_params, "sched_continue"))
+			sched_continue = true;
+		else
+			sched_continue = false;
+
+		if (xstrcasestr(slurm_conf.sched_params,
+				"sched_job_shape_cache"))
+			shape_cache = true;
+		else
+			shape_cache = false;
+
 		if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
 		                           "max_rpc_cnt=")))
 			defer_rpc_cnt = atoi(tmp_ptr + 12);
@@ -1224,6 +1487,7 @@ static int _schedule(bool full_queue)
 			sched_timeout = MAX(time_limit, 1);
 			sched_timeout = MIN(sched_timeout, 2);
 		}
+		sched_timeout_max = MAX(time_limit, sched_timeout);
 
 		if ((tmp_ptr = xstrcasestr(slurm_conf.sched_params,
 		                           "sched_interval="))) {
@@ -1313,9 +1577,16 @@ static int _schedule(bool full_queue)
 		goto out;
 	}
 
+	node_set_cache_begin();
+
 	part_cnt = list_count(part_list);
 	failed_parts = xcalloc(part_cnt, sizeof(part_record_t *));
 	failed_resv = xmalloc(sizeof(struct slurmctld_resv*) * MAX_FAILED_RESV);
+	if (shape_cache)
+		failed_shapes = list_create(_failed_shape_free);
+	if (!assoc_limit_stop &&
+	    (accounting_enforce & ACCOUNTING_ENFORCE_LIMITS))
+		failed_limits = list_create(xfree_ptr);
 	save_avail_node_bitmap = bit_copy(avail_node_bitmap);
 	bit_or(avail_node_bitmap, rs_node_bitmap);
 
@@ -1382,9 +1653,15 @@ static int _schedule(bool full_queue)
 		slurmctld_diag_stats.schedule_queue_len = list_count(job_list);
 		job_iterator = list_iterator_create(job_list);
 	} else {
+		phase_tv.tv_sec = 0;
+		(void) slurm_delta_tv(&phase_tv);
 		job_queue = build_job_queue(false, false);
 		slurmctld_diag_stats.schedule_queue_len = list_count(job_queue);
-		sort_job_queue(job_queue);
+		job_heap = job_queue_heap_create(job_queue);
+		if (sched_continue && !fifo_sched)
+			_sched_resume_init(job_heap);
+		slurmctld_diag_stats.schedule_queue_build_sum +=
+			slurm_delta_tv(&phase_tv);
 	}
 
 	job_ptr = NULL;
@@ -1442,9 +1719,21 @@ next_part:
 					continue;
 			}
 		} else {
-			job_queue_rec = list_pop(job_queue);
-			if (!job_queue_rec)
+			job_queue_rec = job_queue_heap_pop(job_heap);
+			if (!job_queue_rec) {
+				queue_done = true;
 				break;
+			}
+			if (sched_continue && !fifo_sched)
+				job_queue_rec->part_ptr->sched_heap_cnt--;
+			if (sched_continue &&
+			    _sched_resume_skip(job_queue_rec)) {
+				xfree(job_queue_rec);
+				job_ptr = NULL;
+				continue;
+			}
+			resume_job_id = job_queue_rec->job_id;
+			resume_prio = job_queue_rec->priority;
 			array_task_id = job_queue_rec->array_task_id;
 			job_ptr  = job_queue_rec->job_ptr;
 			part_ptr = job_queue_rec->part_ptr;
@@ -1493,7 +1782,13 @@ next_part:
 			is_job_array_head = false;
 
 next_task:
-		if ((time(NULL) - sched_start) >= sched_timeout) {
+		/*
+		 * Past max_sched_time, keep going only while no thread is
+		 * waiting for our locks, up to half of MessageTimeout
+		 */
+		if (((time(NULL) - sched_start) >= sched_timeout) &&
+		    (lock_slurmctld_waiters(job_write_lock) ||
+		     ((time(NULL) - sched_start) >= sched_timeout_max))) {
 			sched_debug("loop taking too long, breaking out");
 			break;
 		}
@@ -1554,6 +1849,13 @@ next_task:
 		}
 		slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
 
+		if (sched_continue && !fifo_sched) {
+			if (!part_ptr->sched_resume_job_id)
+				part_ptr->sched_resume_time = sched_start;
+			part_ptr->sched_resume_job_id = resume_job_id;
+			part_ptr->sched_resume_prio = resume_prio;
+		}
+
 		if (job_limits_check(&job_ptr, false) != WAIT_NO_REASON) {
 			/* should never happen */
 			continue;
@@ -1739,6 +2041,47 @@ next_task:
 			continue;
 		}
 
+		/*
+		 * A job which would reserve its partition on failure still
+		 * needs testing, even when another job with the same request
+		 * did not.
+		 */
+		xfree(shape_key);
+		if (failed_shapes && (shape_key = job_shape_key(job_ptr)) &&
+		    (shape_ptr = list_find_first(failed_shapes,
+						 _find_failed_shape,
+						 shape_key)) &&
+		    ((shape_ptr->error_code != ESLURM_NODES_BUSY) ||
+		     _no_part_reserve(job_ptr, now, bf_min_age_reserve,
+				      bf_min_prio_reserve))) {
+			if (job_ptr->state_reason != shape_ptr->state_reason) {
+				job_ptr->state_reason = shape_ptr->state_reason;
+				xfree(job_ptr->state_desc);
+				last_job_update = now;
+			}
+			sched_debug3("%pJ has the same request as a job which failed to start. State=%s. Reason=%s. Priority=%u. Partition=%s.",
+				     job_ptr,
+				     job_state_string(job_ptr->job_state),
+				     job_reason_string(job_ptr->state_reason),
+				     job_ptr->priority, job_ptr->partition);
+			continue;
+		}
+
+		if (failed_limits && job_ptr->assoc_ptr &&
+		    (limit_ptr = list_find_first(failed_limits,
+						 _find_failed_limit,
+						 job_ptr))) {
+			if (job_ptr->state_reason != limit_ptr->state_reason) {
+				job_ptr->state_reason = limit_ptr->state_reason;
+				xfree(job_ptr->state_desc);
+				last_job_update = now;
+			}
+			sched_debug3("%pJ delayed for accounting policy (same association and QOS as a job held by %s)",
+				     job_ptr,
+				     job_reason_string(limit_ptr->state_reason));
+			continue;
+		}
+
 		last_job_sched_start = MAX(last_job_sched_start,
 					   job_ptr->start_time);
 		if (deadline_time_limit) {
@@ -1752,8 +2095,18 @@ next_task:
 			goto skip_start;
 		}
 
+		phase_tv.tv_sec = 0;
+		(void) slurm_delta_tv(&phase_tv);
+		SLURM_PROBE1(sched__job_start, job_ptr->job_id);
+		sched_trace_begin(job_ptr, SCHED_TRACE_MAIN);
+		sched_trace_select_start();
 		error_code = select_nodes(job_ptr, false, NULL, NULL, false,
 					  SLURMDB_JOB_FLAG_SCHED);
+		sched_trace_select_end(error_code);
+		sched_trace_end();
+		SLURM_PROBE2(sched__job_done, job_ptr->job_id, error_code);
+		slurmctld_diag_stats.schedule_select_sum +=
+			slurm_delta_tv(&phase_tv);
 
 		if (error_code == SLURM_SUCCESS) {
 			/*
@@ -1827,6 +2180,10 @@ skip_start:
 			/* job initiated */
 			sched_debug3("%pJ initiated", job_ptr);
 			last_job_update = now;
+			if (failed_shapes)
+				list_flush(failed_shapes);
+			if (failed_limits)
+				list_flush(failed_limits);
 
 			/* Clear assumed rejected array status */
 			reject_array_job = NULL;
@@ -1865,6 +2222,16 @@ skip_start:
 			/* potentially starve this job */
 			if (assoc_limit_stop)
 				fail_by_part = true;
+			if (failed_limits && job_ptr->assoc_ptr &&
+			    _job_cnt_limit_reason(job_ptr->state_reason)) {
+				limit_ptr = xmalloc(sizeof(failed_limit_t));
+				limit_ptr->assoc_ptr = job_ptr->assoc_ptr;
+				limit_ptr->qos_ptr = job_ptr->qos_ptr;
+				limit_ptr->part_qos_ptr =
+					job_ptr->part_ptr->qos_ptr;
+				limit_ptr->state_reason = job_ptr->state_reason;
+				list_append(failed_limits, limit_ptr);
+			}
 		} else if ((error_code !=
 			    ESLURM_REQUESTED_PART_CONFIG_UNAVAILABLE) &&
 			   (error_code != ESLURM_NODE_NOT_AVAIL)      &&
@@ -1901,27 +2268,26 @@ skip_start:
 					job_ptr->resv_ptr;
 			}
 		}
-		if (fail_by_part && bf_min_age_reserve) {
-			/* Consider other jobs in this partition if job has been
-			 * waiting for less than bf_min_age_reserve time */
-			if (job_ptr->details->begin_time == 0) {
-				fail_by_part = false;
-			} else {
-				pend_time = difftime(
-					now, job_ptr->details->begin_time);
-				if (pend_time < bf_min_age_reserve)
-					fail_by_part = false;
-			}
-		}
-
-		if (!(prio_reserve = acct_policy_get_prio_thresh(
-			      job_ptr, false)))
-			prio_reserve = bf_min_prio_reserve;
-
-		if (fail_by_part && prio_reserve &&
-		    (job_ptr->priority < prio_reserve))
+		if (fail_by_part &&
+		    _no_part_reserve(job_ptr, now, bf_min_age_reserve,
+				     bf_min_prio_reserve))
 			fail_by_part = false;
 
+		if (!fail_by_part && failed_shapes && shape_key &&
+		    ((error_code == ESLURM_NODES_BUSY) ||
+		     (error_code == ESLURM_REQUESTED_NODE_CONFIG_UNAVAILABLE))) {
+			/*
+			 * Skip later jobs with the same request in this
+			 * partition until some job starts
+			 */
+			shape_ptr = xmalloc(sizeof(failed_shape_t));
+			shape_ptr->key = shape_key;
+			shape_ptr->error_code = error_code;
+			shape_ptr->state_reason = job_ptr->state_reason;
+			list_append(failed_shapes, shape_ptr);
+			shape_key = NULL;
+		}
+
 fail_this_part:	if (fail_by_part) {
 			/* Search for duplicates */
 			for (i = 0; i < failed_part_cnt; i++) {
@@ -1945,6 +2311,9 @@ fail_this_part:	if (fail_by_part) {
 	if (bb_wait_cnt)
 		(void) bb_g_job_try_stage_in();
 
+	if (sched_continue && !fifo_sched)
+		_sched_resume_save(failed_parts, failed_part_cnt, queue_done);
+
 	if (job_ptr)
 		job_resv_clear_magnetic_flag(job_ptr);
 	save_last_part_update = last_part_update;
@@ -1952,12 +2321,16 @@ fail_this_part:	if (fail_by_part) {
 	avail_node_bitmap = save_avail_node_bitmap;
 	xfree(failed_parts);
 	xfree(failed_resv);
+	FREE_NULL_LIST(failed_shapes);
+	FREE_NULL_LIST(failed_limits);
+	xfree(shape_key);
 	if (fifo_sched) {
 		if (job_iterator)
 			list_iterator_destroy(job_iterator);
 		if (part_iterator)
 			list_iterator_destroy(part_iterator);
 	} else if (job_queue) {
+		job_queue_heap_destroy(job_heap);
 		FREE_NULL_LIST(job_queue);
 	}
 	xfree(sched_part_ptr);
@@ -1969,6 +2342,7 @@ fail_this_part:	if (fail_by_part) {
 			   slurmctld_config.server_thread_count);
 	}
 	slurm_mutex_unlock(&slurmctld_config.thread_count_lock);
+	node_set_cache_end();
 	unlock_slurmctld(job_write_lock);
 	END_TIMER2("schedule");
 
@@ -1993,6 +2367,69 @@ extern void sort_job_queue(List job_queue)
 	list_sort(job_queue, sort_job_queue2);
 }
 
+/* Restore heap order below heap->rec[inx] */
+static void _job_queue_heap_down(job_queue_heap_t *heap, int inx)
+{
+	job_queue_rec_t *tmp;
+	int child;
+
+	while ((child = (inx * 2) + 1) < heap->rec_cnt) {
+		if (((child + 1) < heap->rec_cnt) &&
+		    (sort_job_queue2(&heap->rec[child + 1],
+				     &heap->rec[child]) < 0))
+			child++;
+		if (sort_job_queue2(&heap->rec[child], &heap->rec[inx]) > 0)
+			break;
+		tmp = heap->rec[inx];
+		heap->rec[inx] = heap->rec[child];
+		heap->rec[child] = tmp;
+		inx = child;
+	}
+}
+
+extern job_queue_heap_t *job_queue_heap_create(List job_queue)
+{
+	job_queue_heap_t *heap = xmalloc(sizeof(job_queue_heap_t));
+	job_queue_rec_t *job_queue_rec;
+	int i;
+
+	heap->rec = xcalloc(MAX(list_count(job_queue), 1),
+			    sizeof(job_queue_rec_t *));
+	while ((job_queue_rec = list_pop(job_queue)))
+		heap->rec[heap->rec_cnt++] = job_queue_rec;
+	for (i = (heap->rec_cnt / 2) - 1; i >= 0; i--)
+		_job_queue_heap_down(heap, i);
+
+	return heap;
+}
+
+extern job_queue_rec_t *job_queue_heap_pop(job_queue_heap_t *heap)
+{
+	job_queue_rec_t *job_queue_rec;
+
+	if (!heap->rec_cnt)
+		return NULL;
+
+	job_queue_rec = heap->rec[0];
+	heap->rec[0] = heap->rec[--heap->rec_cnt];
+	_job_queue_heap_down(heap, 0);
+
+	return job_queue_rec;
+}
+
+extern void job_queue_heap_destroy(job_queue_heap_t *heap)
+{
+	int i;
+
+	if (!heap)
+		return;
+
+	for (i = 0; i < heap->rec_cnt; i++)
+		xfree(heap->rec[i]);
+	xfree(heap->rec);
+	xfree(heap);
+}
+
 /* Note this differs from the ListCmpF typedef since we want jobs sorted
  * in order of decreasing priority then submit time and the by increasing
  * job id */
@@ -3037,14 +3474,26 @@ extern int test_job_dependency(job_record_t *job_ptr, bool *was_changed)
 			/* job is gone, dependency lifted */
 			clear_dep = true;
 		} else {
-			/* Special case, apply test to job array as a whole */
+			/*
+			 * Special case, apply test to job array as a whole.
+			 * Each test walks the array's tasks, so only run the
+			 * ones that can change the outcome: complete implies
+			 * completed, completed implies not pending, and only
+			 * "after" and "expand" look at the pending state.
+			 */
 			if (dep_ptr->array_task_id == INFINITE) {
-				is_complete = test_job_array_complete(
-					dep_ptr->job_id);
 				is_completed = test_job_array_completed(
 					dep_ptr->job_id);
-				is_pending = test_job_array_pending(
-					dep_ptr->job_id);
+				is_complete = is_completed &&
+					test_job_array_complete(
+						dep_ptr->job_id);
+				is_pending = !is_completed &&
+					((dep_ptr->depend_type ==
+					  SLURM_DEPEND_AFTER) ||
+					 (dep_ptr->depend_type ==
+					  SLURM_DEPEND_EXPAND)) &&
+					test_job_array_pending(
+						dep_ptr->job_id);
 			} else {
 				/* Normal job */
 				is_complete = IS_JOB_COMPLETE(djob_ptr);
@@ -3895,6 +4344,82 @@ static void _delayed_job_start_time(job_record_t *job_ptr)
 	job_ptr->start_time += cume_space_time;
 }
 
+extern void sched_plan_free(void *x)
+{
+	sched_plan_t *plan = x;
+	int i;
+
+	if (!plan)
+		return;
+
+	for (i = 0; i < plan->rec_cnt; i++)
+		FREE_NULL_BITMAP(plan->recs[i].avail_bitmap);
+	xfree(plan->recs);
+	FREE_NULL_BITMAP(plan->node_bitmap);
+	xfree(plan);
+}
+
+extern void sched_plan_set(List plan_list)
+{
+	FREE_NULL_LIST(sched_plan_list);
+	sched_plan_list = plan_list;
+}
+
+/*
+ * Find the earliest time at or after start_time at which node_bitmap is
+ * free of planned jobs in every slice of the scheduling plan overlapping
+ * the job's time limit. Times beyond the end of the plan are unknown and
+ * considered free.
+ */
+static time_t _sched_plan_start(job_record_t *job_ptr, bitstr_t *node_bitmap,
+				time_t start_time)
+{
+	ListIterator iter;
+	sched_plan_t *plan;
+	sched_plan_rec_t *rec;
+	bitstr_t *need_bitmap;
+	uint32_t time_limit = job_ptr->time_limit;
+	bool moved = true;
+	int i;
+
+	if (time_limit == NO_VAL)
+		time_limit = job_ptr->part_ptr->max_time;
+
+	while (moved) {
+		moved = false;
+		iter = list_iterator_create(sched_plan_list);
+		while ((plan = list_next(iter))) {
+			if (plan->node_bitmap &&
+			    !bit_overlap_any(plan->node_bitmap, node_bitmap))
+				continue;
+			need_bitmap = bit_copy(node_bitmap);
+			if (plan->node_bitmap)
+				bit_and(need_bitmap, plan->node_bitmap);
+			for (i = 0; i < plan->rec_cnt; i++) {
+				rec = &plan->recs[i];
+				if (rec->end_time <= start_time)
+					continue;
+				if ((time_limit != INFINITE) &&
+				    (rec->begin_time >=
+				     (start_time + ((time_t) time_limit * 60))))
+					break;
+				if (bit_super_set(need_bitmap,
+						  rec->avail_bitmap))
+					continue;
+				start_time = rec->end_time;
+				moved = true;
+			}
+			FREE_NULL_BITMAP(need_bitmap);
+		}
+		list_iterator_destroy(iter);
+		/* Moving forward may conflict with plans already checked */
+		if (list_count(sched_plan_list) == 1)
+			break;
+	}
+
+	return start_time;
+}
+
 static int _part_weight_sort(void *x, void *y)
 {
 	part_record_t *parta = *(part_record_t **) x;
@@ -4079,7 +4604,15 @@ next_part:
 		resp_data = xmalloc(sizeof(will_run_response_msg_t));
 		resp_data->job_id     = job_ptr->job_id;
 		resp_data->proc_cnt = job_ptr->total_cpus;
-		_delayed_job_start_time(job_ptr);
+		/*
+		 * Jobs not yet placed by the backfill scheduler go behind
+		 * the work in its last plan when there is one
+		 */
+		if (!orig_start_time && !job_ptr->resv_name && sched_plan_list)
+			job_ptr->start_time = _sched_plan_start(
+				job_ptr, avail_bitmap, job_ptr->start_time);
+		else
+			_delayed_job_start_time(job_ptr);
 		resp_data->start_time = MAX(job_ptr->start_time,
 					    orig_start_time);
 		resp_data->start_time = MAX(resp_data->start_time, start_res);
@@ -4978,6 +5511,14 @@ void cleanup_completing(job_record_t *job_ptr)
 	gs_job_fini(job_ptr);
 
 	delete_step_records(job_ptr);
+	/*
+	 * The step layout and node usage caches are rebuilt on demand, don't
+	 * keep them around for the MinJobAge lifetime of the finished record.
+	 * The same goes for the node addresses (one slurm_addr_t per node),
+	 * which are rebuilt by build_node_details() if the job is requeued.
+	 */
+	step_cache_free(job_ptr);
+	xfree(job_ptr->node_addr);
 	job_ptr->job_state &= (~JOB_COMPLETING);
 	job_hold_requeue(job_ptr);
 
@@ -56,6 +56,29 @@ typedef struct job_queue_rec {
 					 * in without requesting */
 } job_queue_rec_t;
 
+/*
+ * Pending job queue kept as a binary heap in the order of sort_job_queue2(),
+ * so records are ordered only as they are removed
+ */
+typedef struct job_queue_heap {
+	job_queue_rec_t **rec;		/* heap array, rec[0] is the next job */
+	int rec_cnt;			/* records in the heap */
+} job_queue_heap_t;
+
+/* One time slice of a scheduling plan */
+typedef struct sched_plan_rec {
+	time_t begin_time;
+	time_t end_time;
+	bitstr_t *avail_bitmap;		/* nodes not planned for other jobs */
+} sched_plan_rec_t;
+
+/* Scheduling plan for a set of nodes, records in time order */
+typedef struct sched_plan {
+	bitstr_t *node_bitmap;		/* nodes covered, NULL if all nodes */
+	int rec_cnt;			/* records in use in recs */
+	sched_plan_rec_t *recs;
+} sched_plan_t;
+
 /* Use as return values for test_job_dependency. */
 enum {
 	NO_DEPEND = 0,
@@ -212,6 +235,18 @@ extern int reboot_job_nodes(job_record_t *job_ptr);
  * actually used is first in the string. Needed for job state save/restore */
 extern void rebuild_job_part_list(job_record_t *job_ptr);
 
+/* sched_plan_free - free a sched_plan_t, usable as a ListDelF */
+extern void sched_plan_free(void *x);
+
+/*
+ * sched_plan_set - record the plan of expected job starts made by the
+ *	backfill scheduler, used by job_start_data() to place jobs behind
+ *	queued work
+ * IN plan_list - list of sched_plan_t, consumed. NULL to clear the plan
+ * NOTE: Call with a write job lock
+ */
+extern void sched_plan_set(List plan_list);
+
 /*
  * schedule - attempt to schedule all pending jobs
  *	pending jobs for each partition will be scheduled in priority
@@ -240,6 +275,25 @@ extern void set_job_elig_time(void);
  */
 extern void sort_job_queue(List job_queue);
 
+/*
+ * job_queue_heap_create - move the records of a job_queue into a heap which
+ *	returns them in the order of sort_job_queue(). Building the heap is
+ *	linear in the queue size and each record removed costs O(log n), so
+ *	schedulers which stop early avoid sorting the whole queue.
+ * IN/OUT job_queue - job queue made by build_job_queue(), emptied on return
+ * RET heap to be freed with job_queue_heap_destroy()
+ */
+extern job_queue_heap_t *job_queue_heap_create(List job_queue);
+
+/*
+ * job_queue_heap_pop - remove the highest priority record from a heap
+ * RET job_queue_rec_t to be xfree'd by caller or NULL if the heap is empty
+ */
+extern job_queue_rec_t *job_queue_heap_pop(job_queue_heap_t *heap);
+
+/* job_queue_heap_destroy - free a heap and any records left in it */
+extern void job_queue_heap_destroy(job_queue_heap_t *heap);
+
 /* Note this differs from the ListCmpF typedef since we want jobs sorted
  *	in order of decreasing priority */
 extern int sort_job_queue2(void *x, void *y);
@@ -292,6 +346,19 @@ extern bool update_job_dependency_list(job_record_t *job_ptr,
 extern void fill_array_reasons(job_record_t *job_ptr,
 			       job_record_t *reject_arr_job);
 
+/*
+ * Build a string describing everything about a pending job's request which
+ * determines where it can run in its current partition (its "shape"). Jobs
+ * with identical keys are equivalent to the select plugin, so once one fails
+ * to start the others fail the same way until job or node state changes.
+ *
+ * job_ptr	(IN) The job, with part_ptr set to the partition being tested.
+ * RET		key to be xfree'd by caller or NULL if the job's outcome
+ * 		depends on more than its shape (e.g. a reservation, required
+ * 		or excluded nodes, a deadline, a burst buffer or a hetjob).
+ */
+extern char *job_shape_key(job_record_t *job_ptr);
+
 
 /* Add a job_queue_rec_t to job_queue */
 extern void job_queue_append_internal(job_queue_req_t *job_queue_req);
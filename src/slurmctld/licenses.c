@@ -825,6 +825,36 @@ get_all_license_info(char **buffer_ptr,
 	buffer_ptr[0] = xfer_buf_data(buffer);
 }
 
+/*
+ * license_copy_avail - copy the cluster licenses, e.g. for backfill planning
+ * RET list of licenses_t with "total" set to the count not currently in use,
+ *	NULL if no licenses are configured
+ */
+extern List license_copy_avail(void)
+{
+	ListIterator iter;
+	licenses_t *license_entry, *avail_entry;
+	List avail_list = NULL;
+
+	slurm_mutex_lock(&license_mutex);
+	if (license_list && list_count(license_list)) {
+		avail_list = list_create(license_free_rec);
+		iter = list_iterator_create(license_list);
+		while ((license_entry = list_next(iter))) {
+			avail_entry = xmalloc(sizeof(licenses_t));
+			avail_entry->name = xstrdup(license_entry->name);
+			if (license_entry->total > license_entry->used)
+				avail_entry->total = license_entry->total -
+						     license_entry->used;
+			list_append(avail_list, avail_entry);
+		}
+		list_iterator_destroy(iter);
+	}
+	slurm_mutex_unlock(&license_mutex);
+
+	return avail_list;
+}
+
 extern uint32_t get_total_license_cnt(char *name)
 {
 	uint32_t count = 0;
@@ -162,6 +162,8 @@ get_all_license_info(char **buffer_ptr,
  */
 extern uint32_t get_total_license_cnt(char *name);
 
+extern List license_copy_avail(void);
+
 /* node_read should be locked before coming in here
  * returns tres_str of the license_list.
  */
@@ -39,14 +39,86 @@
 
 #include <errno.h>
 #include <pthread.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sys/types.h>
+#include <time.h>
 
+#include "src/common/list.h"
+#include "src/common/probes.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/slurmctld.h"
 
+#define LOCK_TYPE_CNT		5	/* CONF_LOCK through FED_LOCK */
+#define LOCK_STATS_HIST_CNT	8	/* <10 usec, <100 usec, ... >=10 sec */
+#define LOCK_HOLDER_CNT		256	/* distinct lock holders tracked */
+#define LOCK_THREAD_HOLDER_CNT	16	/* lock holders kept per thread */
+#define LOCK_HOLDER_TOP		20	/* lock holders reported */
+
+/* Lock levels as passed to the lock probes, one hex digit per lock */
+#define LOCK_PROBE_LEVELS(l)						\
+	(((l).conf << 16) | ((l).job << 12) | ((l).node << 8) |		\
+	 ((l).part << 4) | (l).fed)
+
+/* Wait and hold times for one lock type and level, in microseconds */
+typedef struct {
+	uint64_t count;
+	uint64_t hold_hist[LOCK_STATS_HIST_CNT];
+	uint64_t hold_max;
+	uint64_t hold_sum;
+	uint64_t wait_hist[LOCK_STATS_HIST_CNT];
+	uint64_t wait_max;
+	uint64_t wait_sum;
+} lock_stats_t;
+
+/* Time locks were held by a function, for a given RPC type */
+typedef struct {
+	const char *caller;
+	uint64_t count;
+	uint64_t hold_max;
+	uint64_t hold_sum;
+	uint16_t rpc_type;
+} lock_holder_t;
+
+/*
+ * Per thread state used to collect lock statistics. Each thread accumulates
+ * its own statistics so taking a lock does not serialize on a global mutex.
+ * They are merged into the global ones when read and when the thread exits.
+ */
+typedef struct {
+	uint64_t acquired[LOCK_TYPE_CNT]; /* when each lock was acquired */
+	const char *caller;
+	/* when all locks were acquired */
+	uint64_t locked;
+	uint16_t rpc_type;
+	/* lock wait since lock_stats_rpc_wait() */
+	uint64_t rpc_wait;
+
+	/* protects the fields below, only contended while stats are read */
+	pthread_mutex_t mutex;
+	lock_stats_t stats[LOCK_TYPE_CNT][2];	/* [type][level - 1] */
+	lock_holder_t holders[LOCK_THREAD_HOLDER_CNT];
+} lock_thread_t;
+
+static const char *lock_type_names[LOCK_TYPE_CNT] = {
+	"conf", "job", "node", "part", "fed"
+};
+
 static pthread_mutex_t state_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Statistics of exited threads and holders which did not fit in a thread's
+ * table, and the list of live lock_thread_t. Lock before any thread's mutex.
+ */
+static pthread_mutex_t lock_stats_mutex = PTHREAD_MUTEX_INITIALIZER;
+static lock_stats_t lock_stats[LOCK_TYPE_CNT][2];	/* [type][level - 1] */
+static lock_holder_t lock_holders[LOCK_HOLDER_CNT];
+static List lock_threads = NULL;
+static pthread_key_t lock_thread_key;
+static pthread_once_t lock_thread_once = PTHREAD_ONCE_INIT;
+
 static pthread_rwlock_t slurmctld_locks[5] = {
 	PTHREAD_RWLOCK_INITIALIZER,
 	PTHREAD_RWLOCK_INITIALIZER,
@@ -55,6 +127,18 @@ static pthread_rwlock_t slurmctld_locks[5] = {
 	PTHREAD_RWLOCK_INITIALIZER,
 };
 
+/*
+ * Threads blocked waiting for each slurmctld lock and the count of such waits
+ * which have completed, used to yield locks only when someone is waiting
+ */
+static pthread_mutex_t lock_waiter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t lock_waiter_cond = PTHREAD_COND_INITIALIZER;
+static int lock_waiters[LOCK_TYPE_CNT][2];		/* [type][level - 1] */
+static uint64_t lock_waits_done = 0;
+
+static pthread_rwlock_t job_shard_locks[JOB_SHARD_CNT];
+static pthread_once_t job_shard_once = PTHREAD_ONCE_INIT;
+
 #ifndef NDEBUG
 /*
  * Used to protect against double-locking within a single thread. Calling
@@ -75,6 +159,10 @@ static __thread bool slurmctld_locked = false;
 
 static __thread slurmctld_lock_t thread_locks;
 
+/* Bitmaps of job shards locked by this thread, and of those write locked */
+static __thread uint64_t thread_job_shards = 0;
+static __thread uint64_t thread_job_shards_write = 0;
+
 static bool _store_locks(slurmctld_lock_t lock_levels)
 {
 	if (slurmctld_locked)
@@ -91,6 +179,8 @@ static bool _clear_locks(slurmctld_lock_t lock_levels)
 {
 	if (!slurmctld_locked)
 		return false;
+	if (thread_job_shards)
+		return false;	/* Job shard locks must be released first */
 	slurmctld_locked = false;
 
 	if (memcmp((void *) &thread_locks, (void *) &lock_levels,
@@ -106,43 +196,343 @@ extern bool verify_lock(lock_datatype_t datatype, lock_level_t level)
 {
 	return (((lock_level_t *) &thread_locks)[datatype] >= level);
 }
+
+extern bool verify_job_shard_lock(uint32_t job_id, lock_level_t level)
+{
+	uint64_t shard_bit = ((uint64_t) 1) << JOB_SHARD_INX(job_id);
+
+	if (verify_lock(JOB_LOCK, WRITE_LOCK))
+		return true;
+	if (!verify_lock(JOB_LOCK, READ_LOCK))
+		return false;
+	if (level == WRITE_LOCK)
+		return (thread_job_shards_write & shard_bit);
+	if (level == READ_LOCK)
+		return (thread_job_shards & shard_bit);
+	return true;
+}
+
+/* Validate and record acquisition of a job shard lock by this thread */
+static bool _store_job_shard(int shard, lock_level_t level)
+{
+	uint64_t shard_bit = ((uint64_t) 1) << shard;
+
+	if (!verify_lock(JOB_LOCK, READ_LOCK))
+		return false;
+	/* Shards must be locked in increasing order, at most once */
+	if (thread_job_shards >= shard_bit)
+		return false;
+
+	thread_job_shards |= shard_bit;
+	if (level == WRITE_LOCK)
+		thread_job_shards_write |= shard_bit;
+
+	return true;
+}
+
+static bool _clear_job_shard(int shard)
+{
+	uint64_t shard_bit = ((uint64_t) 1) << shard;
+
+	if (!(thread_job_shards & shard_bit))
+		return false;
+
+	thread_job_shards &= ~shard_bit;
+	thread_job_shards_write &= ~shard_bit;
+
+	return true;
+}
 #endif
 
+static void _lock_stats_merge(lock_stats_t *to, lock_stats_t *from)
+{
+	to->count += from->count;
+	to->hold_max = MAX(to->hold_max, from->hold_max);
+	to->hold_sum += from->hold_sum;
+	to->wait_max = MAX(to->wait_max, from->wait_max);
+	to->wait_sum += from->wait_sum;
+	for (int i = 0; i < LOCK_STATS_HIST_CNT; i++) {
+		to->hold_hist[i] += from->hold_hist[i];
+		to->wait_hist[i] += from->wait_hist[i];
+	}
+}
+
+/*
+ * Find the slot of a lock holder in a table of holder_cnt entries, claiming
+ * a free one if needed.
+ * RET the slot or NULL if the table is full
+ */
+static lock_holder_t *_lock_holder_find(lock_holder_t *holders,
+					int holder_cnt, const char *caller,
+					uint16_t rpc_type)
+{
+	lock_holder_t *holder;
+	int inx = (((uintptr_t) caller >> 4) ^ rpc_type) % holder_cnt;
+
+	for (int i = 0; i < holder_cnt; i++) {
+		holder = &holders[(inx + i) % holder_cnt];
+		if (!holder->count) {
+			holder->caller = caller;
+			holder->rpc_type = rpc_type;
+			return holder;
+		}
+		if ((holder->caller == caller) &&
+		    (holder->rpc_type == rpc_type))
+			return holder;
+	}
+
+	return NULL;
+}
+
+static void _lock_holder_merge(lock_holder_t *holders, lock_holder_t *from)
+{
+	lock_holder_t *holder;
+
+	if (!from->count)
+		return;
+	if (!(holder = _lock_holder_find(holders, LOCK_HOLDER_CNT,
+					 from->caller, from->rpc_type)))
+		return;	/* Table full, not tracked until stats are reset */
+
+	holder->count += from->count;
+	holder->hold_max = MAX(holder->hold_max, from->hold_max);
+	holder->hold_sum += from->hold_sum;
+}
+
+/*
+ * Add the statistics of thread to stats and holders
+ * NOTE: Call with thread->mutex locked
+ */
+static void _lock_thread_merge(lock_thread_t *thread,
+			       lock_stats_t stats[LOCK_TYPE_CNT][2],
+			       lock_holder_t *holders)
+{
+	for (int i = 0; i < LOCK_TYPE_CNT; i++) {
+		for (int j = 0; j < 2; j++)
+			_lock_stats_merge(&stats[i][j], &thread->stats[i][j]);
+	}
+	for (int i = 0; i < LOCK_THREAD_HOLDER_CNT; i++)
+		_lock_holder_merge(holders, &thread->holders[i]);
+}
+
+/* Move the lock holders of thread to the global table to make room */
+static void _lock_thread_flush_holders(lock_thread_t *thread)
+{
+	slurm_mutex_lock(&lock_stats_mutex);
+	slurm_mutex_lock(&thread->mutex);
+	for (int i = 0; i < LOCK_THREAD_HOLDER_CNT; i++)
+		_lock_holder_merge(lock_holders, &thread->holders[i]);
+	memset(thread->holders, 0, sizeof(thread->holders));
+	slurm_mutex_unlock(&thread->mutex);
+	slurm_mutex_unlock(&lock_stats_mutex);
+}
+
+/* Key destructor, keep the statistics of the exiting thread */
+static void _lock_thread_destroy(void *x)
+{
+	lock_thread_t *thread = x;
+
+	slurm_mutex_lock(&lock_stats_mutex);
+	list_delete_ptr(lock_threads, thread);
+	slurm_mutex_lock(&thread->mutex);
+	_lock_thread_merge(thread, lock_stats, lock_holders);
+	slurm_mutex_unlock(&thread->mutex);
+	slurm_mutex_unlock(&lock_stats_mutex);
+
+	slurm_mutex_destroy(&thread->mutex);
+	free(thread);
+}
+
+static void _lock_thread_key_init(void)
+{
+	lock_threads = list_create(NULL);
+	if (pthread_key_create(&lock_thread_key, _lock_thread_destroy))
+		fatal("%s: pthread_key_create failed", __func__);
+}
+
+static lock_thread_t *_lock_thread(void)
+{
+	lock_thread_t *thread;
+
+	pthread_once(&lock_thread_once, _lock_thread_key_init);
+	if (!(thread = pthread_getspecific(lock_thread_key))) {
+		/* Allocated with calloc() so the key destructor can free() */
+		if (!(thread = calloc(1, sizeof(*thread))))
+			fatal("%s: calloc failed", __func__);
+		slurm_mutex_init(&thread->mutex);
+		pthread_setspecific(lock_thread_key, thread);
+
+		slurm_mutex_lock(&lock_stats_mutex);
+		list_append(lock_threads, thread);
+		slurm_mutex_unlock(&lock_stats_mutex);
+	}
+
+	return thread;
+}
+
+static uint64_t _lock_time_usec(void)
+{
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (((uint64_t) now.tv_sec * 1000000) + (now.tv_nsec / 1000));
+}
+
+static int _lock_hist_inx(uint64_t usec)
+{
+	uint64_t limit = 10;
+	int i = 0;
+
+	while ((i < (LOCK_STATS_HIST_CNT - 1)) && (usec >= limit)) {
+		limit *= 10;
+		i++;
+	}
+
+	return i;
+}
+
+/* Block on a slurmctld lock, visible to _lock_waiter_cnt() while waiting */
+static void _lock_wait(lock_datatype_t datatype, lock_level_t level)
+{
+	slurm_mutex_lock(&lock_waiter_mutex);
+	lock_waiters[datatype][level - 1]++;
+	slurm_mutex_unlock(&lock_waiter_mutex);
+
+	if (level == READ_LOCK)
+		slurm_rwlock_rdlock(&slurmctld_locks[datatype]);
+	else
+		slurm_rwlock_wrlock(&slurmctld_locks[datatype]);
+
+	slurm_mutex_lock(&lock_waiter_mutex);
+	lock_waiters[datatype][level - 1]--;
+	lock_waits_done++;
+	slurm_cond_broadcast(&lock_waiter_cond);
+	slurm_mutex_unlock(&lock_waiter_mutex);
+}
+
+/*
+ * Count threads waiting for a lock held at lock_levels: writers for a lock
+ * held for read, anyone for a lock held for write.
+ * NOTE: Call with lock_waiter_mutex locked
+ */
+static int _lock_waiter_cnt(slurmctld_lock_t lock_levels)
+{
+	lock_level_t *levels = (lock_level_t *) &lock_levels;
+	int i, cnt = 0;
+
+	for (i = 0; i < LOCK_TYPE_CNT; i++) {
+		if (levels[i] == NO_LOCK)
+			continue;
+		cnt += lock_waiters[i][WRITE_LOCK - 1];
+		if (levels[i] == WRITE_LOCK)
+			cnt += lock_waiters[i][READ_LOCK - 1];
+	}
+
+	return cnt;
+}
+
+/*
+ * Acquire one slurmctld lock and record when it was acquired. The clock is
+ * only read again if the lock had to be waited for.
+ */
+static void _lock_one(lock_datatype_t datatype, lock_level_t level,
+		      lock_thread_t *thread, uint64_t *now, uint64_t *wait)
+{
+	pthread_rwlock_t *lock = &slurmctld_locks[datatype];
+	int rc;
+
+	if (level == READ_LOCK)
+		rc = pthread_rwlock_tryrdlock(lock);
+	else if (level == WRITE_LOCK)
+		rc = pthread_rwlock_trywrlock(lock);
+	else
+		return;
+
+	if (rc) {
+		_lock_wait(datatype, level);
+		thread->acquired[datatype] = _lock_time_usec();
+		wait[datatype] = thread->acquired[datatype] - *now;
+		*now = thread->acquired[datatype];
+	} else {
+		thread->acquired[datatype] = *now;
+		wait[datatype] = 0;
+	}
+}
+
 /* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld(slurmctld_lock_t lock_levels)
+extern void lock_slurmctld_caller(slurmctld_lock_t lock_levels,
+				  const char *caller)
 {
+	lock_level_t *levels = (lock_level_t *) &lock_levels;
+	lock_thread_t *thread = _lock_thread();
+	uint64_t now, wait[LOCK_TYPE_CNT];
+	lock_stats_t *stats;
+	int i;
+
 	xassert(_store_locks(lock_levels));
 
-	if (lock_levels.conf == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[CONF_LOCK]);
-	else if (lock_levels.conf == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[CONF_LOCK]);
+	now = _lock_time_usec();
+	thread->rpc_wait -= now;
+	/* Start of the wait until all locks are acquired, see below */
+	thread->locked = now;
+	SLURM_PROBE2(lock__acquire, LOCK_PROBE_LEVELS(lock_levels), caller);
+	_lock_one(CONF_LOCK, lock_levels.conf, thread, &now, wait);
+	_lock_one(JOB_LOCK, lock_levels.job, thread, &now, wait);
+	_lock_one(NODE_LOCK, lock_levels.node, thread, &now, wait);
+	_lock_one(PART_LOCK, lock_levels.part, thread, &now, wait);
+	_lock_one(FED_LOCK, lock_levels.fed, thread, &now, wait);
+	SLURM_PROBE3(lock__acquired, LOCK_PROBE_LEVELS(lock_levels), caller,
+		     now - thread->locked);
+	thread->caller = caller;
+	thread->locked = now;
+	thread->rpc_wait += now;
+
+	slurm_mutex_lock(&thread->mutex);
+	for (i = 0; i < LOCK_TYPE_CNT; i++) {
+		if (levels[i] == NO_LOCK)
+			continue;
+		stats = &thread->stats[i][levels[i] - 1];
+		stats->count++;
+		stats->wait_hist[_lock_hist_inx(wait[i])]++;
+		stats->wait_max = MAX(stats->wait_max, wait[i]);
+		stats->wait_sum += wait[i];
+	}
+	slurm_mutex_unlock(&thread->mutex);
+}
 
-	if (lock_levels.job == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[JOB_LOCK]);
-	else if (lock_levels.job == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[JOB_LOCK]);
+/*
+ * Record time locks were held by the thread's caller and RPC type
+ * NOTE: Call with thread->mutex locked
+ * RET false if the thread's table is full
+ */
+static bool _lock_holder_add(lock_thread_t *thread, uint64_t hold)
+{
+	lock_holder_t *holder;
 
-	if (lock_levels.node == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[NODE_LOCK]);
-	else if (lock_levels.node == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[NODE_LOCK]);
+	if (!(holder = _lock_holder_find(thread->holders,
+					 LOCK_THREAD_HOLDER_CNT,
+					 thread->caller, thread->rpc_type)))
+		return false;
 
-	if (lock_levels.part == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[PART_LOCK]);
-	else if (lock_levels.part == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[PART_LOCK]);
+	holder->count++;
+	holder->hold_max = MAX(holder->hold_max, hold);
+	holder->hold_sum += hold;
 
-	if (lock_levels.fed == READ_LOCK)
-		slurm_rwlock_rdlock(&slurmctld_locks[FED_LOCK]);
-	else if (lock_levels.fed == WRITE_LOCK)
-		slurm_rwlock_wrlock(&slurmctld_locks[FED_LOCK]);
+	return true;
 }
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
 extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 {
+	lock_level_t *levels = (lock_level_t *) &lock_levels;
+	lock_thread_t *thread = _lock_thread();
+	lock_stats_t *stats;
+	uint64_t hold, now;
+	bool added;
+	int i;
+
 	xassert(_clear_locks(lock_levels));
 
 	if (lock_levels.fed)
@@ -159,6 +549,117 @@ extern void unlock_slurmctld(slurmctld_lock_t lock_levels)
 
 	if (lock_levels.conf)
 		slurm_rwlock_unlock(&slurmctld_locks[CONF_LOCK]);
+
+	now = _lock_time_usec();
+	SLURM_PROBE2(lock__release, LOCK_PROBE_LEVELS(lock_levels),
+		     now - thread->locked);
+	slurm_mutex_lock(&thread->mutex);
+	for (i = 0; i < LOCK_TYPE_CNT; i++) {
+		if (levels[i] == NO_LOCK)
+			continue;
+		stats = &thread->stats[i][levels[i] - 1];
+		hold = now - thread->acquired[i];
+		stats->hold_hist[_lock_hist_inx(hold)]++;
+		stats->hold_max = MAX(stats->hold_max, hold);
+		stats->hold_sum += hold;
+	}
+	added = _lock_holder_add(thread, now - thread->locked);
+	slurm_mutex_unlock(&thread->mutex);
+
+	if (!added) {
+		/* Rare, the thread's table is only full of distinct callers */
+		_lock_thread_flush_holders(thread);
+		slurm_mutex_lock(&thread->mutex);
+		(void) _lock_holder_add(thread, now - thread->locked);
+		slurm_mutex_unlock(&thread->mutex);
+	}
+}
+
+extern int lock_slurmctld_waiters(slurmctld_lock_t lock_levels)
+{
+	int cnt;
+
+	slurm_mutex_lock(&lock_waiter_mutex);
+	cnt = _lock_waiter_cnt(lock_levels);
+	slurm_mutex_unlock(&lock_waiter_mutex);
+
+	return cnt;
+}
+
+extern uint64_t yield_slurmctld_caller(slurmctld_lock_t lock_levels,
+				       uint64_t max_usec, const char *caller)
+{
+	struct timespec deadline;
+	uint64_t start, done;
+	int cnt;
+
+	slurm_mutex_lock(&lock_waiter_mutex);
+	cnt = _lock_waiter_cnt(lock_levels);
+	done = lock_waits_done + cnt;
+	slurm_mutex_unlock(&lock_waiter_mutex);
+	if (!cnt)
+		return 0;
+
+	start = _lock_time_usec();
+	unlock_slurmctld(lock_levels);
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_sec += max_usec / 1000000;
+	deadline.tv_nsec += (max_usec % 1000000) * 1000;
+	if (deadline.tv_nsec >= 1000000000) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000;
+	}
+
+	/*
+	 * Wait until those queued at release have been granted their locks,
+	 * or none of them remain queued due to being granted or another holder
+	 */
+	slurm_mutex_lock(&lock_waiter_mutex);
+	while ((lock_waits_done < done) && _lock_waiter_cnt(lock_levels)) {
+		if (pthread_cond_timedwait(&lock_waiter_cond,
+					   &lock_waiter_mutex, &deadline) ==
+		    ETIMEDOUT)
+			break;
+	}
+	slurm_mutex_unlock(&lock_waiter_mutex);
+
+	lock_slurmctld_caller(lock_levels, caller);
+
+	return MAX(_lock_time_usec() - start, 1);
+}
+
+static void _job_shard_init(void)
+{
+	int i;
+
+	for (i = 0; i < JOB_SHARD_CNT; i++)
+		slurm_rwlock_init(&job_shard_locks[i]);
+}
+
+/* lock_job_shard - lock the shard containing a job */
+extern void lock_job_shard(uint32_t job_id, lock_level_t level)
+{
+	int shard = JOB_SHARD_INX(job_id);
+
+	xassert((level == READ_LOCK) || (level == WRITE_LOCK));
+	xassert(_store_job_shard(shard, level));
+
+	pthread_once(&job_shard_once, _job_shard_init);
+	if (level == WRITE_LOCK)
+		slurm_rwlock_wrlock(&job_shard_locks[shard]);
+	else
+		slurm_rwlock_rdlock(&job_shard_locks[shard]);
+}
+
+/* unlock_job_shard - release a lock from lock_job_shard() */
+extern void unlock_job_shard(uint32_t job_id)
+{
+	int shard = JOB_SHARD_INX(job_id);
+
+	xassert(_clear_job_shard(shard));
+
+	slurm_rwlock_unlock(&job_shard_locks[shard]);
 }
 
 /*
@@ -215,3 +716,125 @@ extern void unlock_state_files(void)
 {
 	slurm_mutex_unlock(&state_mutex);
 }
+
+/* lock_stats_rpc_type - set the RPC type being processed by this thread */
+extern void lock_stats_rpc_type(uint16_t msg_type)
+{
+	lock_thread_t *thread = _lock_thread();
+
+	thread->rpc_type = msg_type;
+	thread->rpc_wait = 0;
+}
+
+/* lock_stats_rpc_wait - time this thread waited for locks since last call */
+extern uint64_t lock_stats_rpc_wait(void)
+{
+	lock_thread_t *thread = _lock_thread();
+	uint64_t wait = thread->rpc_wait;
+
+	thread->rpc_wait = 0;
+	return wait;
+}
+
+static int _sort_lock_holders(const void *x, const void *y)
+{
+	const lock_holder_t *holder1 = x, *holder2 = y;
+
+	if (holder1->hold_sum < holder2->hold_sum)
+		return 1;
+	if (holder1->hold_sum > holder2->hold_sum)
+		return -1;
+	return 0;
+}
+
+/* pack_lock_stats - pack lock wait/hold statistics for REQUEST_STATS_INFO */
+extern void pack_lock_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	lock_stats_t all_stats[LOCK_TYPE_CNT][2];
+	lock_holder_t *all_holders, *holders;
+	lock_thread_t *thread;
+	lock_stats_t *stats;
+	ListIterator itr;
+	char *name = NULL;
+	int i, j, holder_cnt = 0;
+
+	if (protocol_version < SLURM_21_08_PROTOCOL_VERSION)
+		return;
+
+	all_holders = xcalloc(LOCK_HOLDER_CNT, sizeof(lock_holder_t));
+	holders = xcalloc(LOCK_HOLDER_CNT, sizeof(lock_holder_t));
+
+	/* Merge the live threads' statistics into a copy of the global ones */
+	pthread_once(&lock_thread_once, _lock_thread_key_init);
+	slurm_mutex_lock(&lock_stats_mutex);
+	memcpy(all_stats, lock_stats, sizeof(all_stats));
+	memcpy(all_holders, lock_holders, sizeof(lock_holders));
+	itr = list_iterator_create(lock_threads);
+	while ((thread = list_next(itr))) {
+		slurm_mutex_lock(&thread->mutex);
+		_lock_thread_merge(thread, all_stats, all_holders);
+		slurm_mutex_unlock(&thread->mutex);
+	}
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&lock_stats_mutex);
+
+	pack32(LOCK_TYPE_CNT * 2, buffer);
+	pack32(LOCK_STATS_HIST_CNT, buffer);
+	for (i = 0; i < LOCK_TYPE_CNT; i++) {
+		for (j = 0; j < 2; j++) {
+			stats = &all_stats[i][j];
+			xstrfmtcat(name, "%s_%s", lock_type_names[i],
+				   j ? "write" : "read");
+			packstr(name, buffer);
+			xfree(name);
+			pack64(stats->count, buffer);
+			pack64(stats->wait_sum, buffer);
+			pack64(stats->wait_max, buffer);
+			pack64_array(stats->wait_hist, LOCK_STATS_HIST_CNT,
+				     buffer);
+			pack64(stats->hold_sum, buffer);
+			pack64(stats->hold_max, buffer);
+			pack64_array(stats->hold_hist, LOCK_STATS_HIST_CNT,
+				     buffer);
+		}
+	}
+
+	for (i = 0; i < LOCK_HOLDER_CNT; i++) {
+		if (all_holders[i].count)
+			holders[holder_cnt++] = all_holders[i];
+	}
+	xfree(all_holders);
+
+	qsort(holders, holder_cnt, sizeof(lock_holder_t), _sort_lock_holders);
+	holder_cnt = MIN(holder_cnt, LOCK_HOLDER_TOP);
+	pack32(holder_cnt, buffer);
+	for (i = 0; i < holder_cnt; i++) {
+		packstr((char *) holders[i].caller, buffer);
+		pack16(holders[i].rpc_type, buffer);
+		pack64(holders[i].count, buffer);
+		pack64(holders[i].hold_sum, buffer);
+		pack64(holders[i].hold_max, buffer);
+	}
+	xfree(holders);
+}
+
+/* reset_lock_stats - clear lock wait/hold statistics */
+extern void reset_lock_stats(void)
+{
+	lock_thread_t *thread;
+	ListIterator itr;
+
+	pthread_once(&lock_thread_once, _lock_thread_key_init);
+	slurm_mutex_lock(&lock_stats_mutex);
+	memset(lock_stats, 0, sizeof(lock_stats));
+	memset(lock_holders, 0, sizeof(lock_holders));
+	itr = list_iterator_create(lock_threads);
+	while ((thread = list_next(itr))) {
+		slurm_mutex_lock(&thread->mutex);
+		memset(thread->stats, 0, sizeof(thread->stats));
+		memset(thread->holders, 0, sizeof(thread->holders));
+		slurm_mutex_unlock(&thread->mutex);
+	}
+	list_iterator_destroy(itr);
+	slurm_mutex_unlock(&lock_stats_mutex);
+}
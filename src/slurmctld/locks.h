@@ -86,12 +86,26 @@
  * NOTE: When using lock_slurmctld() and assoc_mgr_lock(), always call
  * lock_slurmctld() before calling assoc_mgr_lock() and then call
  * assoc_mgr_unlock() before calling unlock_slurmctld().
+ *
+ * Within the job lock domain, job records are also divided into JOB_SHARD_CNT
+ * shards by job ID, each with its own read/write lock. A job shard lock may
+ * only be taken while holding the job read lock, so a thread holding the job
+ * write lock has exclusive access to every shard. Data documented as being
+ * protected by the job shard lock may be modified while holding the job read
+ * lock and the job's shard write lock, and read while holding the job read
+ * lock and the shard read lock. This permits threads working with different
+ * jobs to proceed concurrently. When holding more than one shard lock, they
+ * must be acquired in increasing shard index order and released before
+ * calling unlock_slurmctld().
 \*****************************************************************************/
 
 #ifndef _SLURMCTLD_LOCKS_H
 #define _SLURMCTLD_LOCKS_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+#include "src/common/pack.h"
 
 /* levels of locking required for each data structure */
 typedef enum {
@@ -117,19 +131,86 @@ typedef enum {
 	FED_LOCK,
 }	lock_datatype_t;
 
+#define JOB_SHARD_CNT 64
+#define JOB_SHARD_INX(_job_id) ((_job_id) % JOB_SHARD_CNT)
+
 #ifndef NDEBUG
 extern bool verify_lock(lock_datatype_t datatype, lock_level_t level);
+
+/*
+ * verify_job_shard_lock - test if this thread may access data protected by
+ *	the job shard lock of a job at the given level
+ * IN job_id - job ID, which determines the shard
+ * IN level - access level required
+ */
+extern bool verify_job_shard_lock(uint32_t job_id, lock_level_t level);
 #endif
 
-/* lock_slurmctld - Issue the required lock requests in a well defined order */
-extern void lock_slurmctld (slurmctld_lock_t lock_levels);
+/*
+ * lock_slurmctld - Issue the required lock requests in a well defined order
+ * The calling function is recorded for the lock statistics reported by sdiag.
+ */
+#define lock_slurmctld(_lock_levels) \
+	lock_slurmctld_caller(_lock_levels, __func__)
+extern void lock_slurmctld_caller(slurmctld_lock_t lock_levels,
+				  const char *caller);
 
 /* unlock_slurmctld - Issue the required unlock requests in a well
  *	defined order */
 extern void unlock_slurmctld (slurmctld_lock_t lock_levels);
 
+/*
+ * lock_slurmctld_waiters - count threads blocked waiting for locks held at
+ *	lock_levels, that is writers waiting on a lock held for read and any
+ *	thread waiting on a lock held for write
+ */
+extern int lock_slurmctld_waiters(slurmctld_lock_t lock_levels);
+
+/*
+ * yield_slurmctld - if any thread is waiting for locks held at lock_levels,
+ *	release them, wait until those threads have been granted the locks,
+ *	then reacquire them
+ * IN lock_levels - locks held by the caller
+ * IN max_usec - longest time to wait for the waiting threads
+ * RET microseconds for which locks were released, 0 if they were kept
+ */
+#define yield_slurmctld(_lock_levels, _max_usec) \
+	yield_slurmctld_caller(_lock_levels, _max_usec, __func__)
+extern uint64_t yield_slurmctld_caller(slurmctld_lock_t lock_levels,
+				       uint64_t max_usec, const char *caller);
+
+/*
+ * lock_job_shard - lock the shard containing a job
+ * IN job_id - job ID, which determines the shard
+ * IN level - READ_LOCK or WRITE_LOCK
+ * NOTE: Call with the job read lock set, see the notes at top of this file
+ */
+extern void lock_job_shard(uint32_t job_id, lock_level_t level);
+
+/* unlock_job_shard - release a lock from lock_job_shard() */
+extern void unlock_job_shard(uint32_t job_id);
+
 extern int report_locks_set(void);
 
+/*
+ * lock_stats_rpc_type - set the RPC type being processed by this thread, to
+ *	be recorded with locks it acquires
+ * IN msg_type - RPC type, 0 if none
+ */
+extern void lock_stats_rpc_type(uint16_t msg_type);
+
+/*
+ * lock_stats_rpc_wait - return the time in microseconds this thread waited
+ *	for slurmctld locks since this was last called or the RPC type was set
+ */
+extern uint64_t lock_stats_rpc_wait(void);
+
+/* pack_lock_stats - pack lock wait/hold statistics for REQUEST_STATS_INFO */
+extern void pack_lock_stats(buf_t *buffer, uint16_t protocol_version);
+
+/* reset_lock_stats - clear lock wait/hold statistics */
+extern void reset_lock_stats(void);
+
 /* un/lock semaphore used for saving state of slurmctld */
 extern void lock_state_files ( void );
 extern void unlock_state_files ( void );
@@ -109,6 +109,8 @@ bitstr_t *share_node_bitmap = NULL;  	/* bitmap of sharable nodes */
 bitstr_t *up_node_bitmap    = NULL;  	/* bitmap of non-down nodes */
 bitstr_t *rs_node_bitmap    = NULL; 	/* bitmap of resuming nodes */
 
+static uint32_t node_info_pack_size = BUF_SIZE * 16; /* size of last dump */
+
 static void 	_dump_node_state(node_record_t *dump_node_ptr, buf_t *buffer);
 static front_end_record_t * _front_end_reg(
 				slurm_node_registration_status_msg_t *reg_msg);
@@ -742,6 +744,20 @@ static bool _node_is_hidden(node_record_t *node_ptr, uid_t uid)
 	return true;
 }
 
+/* FNV-1a hash of a packed node record, used to detect changed records */
+static uint64_t _pack_hash(char *data, uint32_t len)
+{
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	uint32_t i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char) data[i];
+		hash *= 0x100000001b3ULL;
+	}
+
+	return hash;
+}
+
 /*
  * pack_all_node - dump all configuration and node information for all nodes
  *	in machine independent form (for network transmission)
@@ -749,21 +765,24 @@ static bool _node_is_hidden(node_record_t *node_ptr, uid_t uid)
  * OUT buffer_size - set to size of the buffer in bytes
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
+ * IN update_time - with SHOW_DELTA, only pack records changed since this time
  * IN protocol_version - slurm protocol version of client
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
  * NOTE: change slurm_load_node() in api/node_info.c when data format changes
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
-			   uint16_t show_flags, uid_t uid,
+			   uint16_t show_flags, uid_t uid, time_t update_time,
 			   uint16_t protocol_version)
 {
 	int inx;
-	uint32_t nodes_packed, tmp_offset;
+	uint32_t nodes_packed, tmp_offset, rec_offset;
 	buf_t *buffer;
 	time_t now = time(NULL);
 	node_record_t *node_ptr = node_record_table_ptr;
-	bool hidden;
+	bool hidden, delta = false, track = false;
+	int slot = (show_flags & SHOW_DETAIL) ? 1 : 0;
+	uint64_t hash;
 
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 	xassert(verify_lock(PART_LOCK, READ_LOCK));
@@ -771,13 +790,18 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = init_buf (BUF_SIZE*16);
+	buffer = init_pool_buf(node_info_pack_size);
 	nodes_packed = 0;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
-		/* write header: count and time */
+		/* write header: count, time and (21.08+) delta flag */
 		pack32(nodes_packed, buffer);
 		pack_time(now, buffer);
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+			track = true;
+			delta = (show_flags & SHOW_DELTA) && update_time;
+			pack8(delta, buffer);
+		}
 
 		/* write node records */
 		for (inx = 0; inx < node_record_count; inx++, node_ptr++) {
@@ -802,6 +826,9 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 				 (node_ptr->name[0] == '\0'))
 				hidden = true;
 
+			if (delta)
+				pack8(1, buffer);
+			rec_offset = get_buf_offset(buffer);
 			if (hidden) {
 				char *orig_name = node_ptr->name;
 				node_ptr->name = NULL;
@@ -813,6 +840,32 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 					   show_flags);
 			}
 			nodes_packed++;
+
+			/*
+			 * The hash of the packed record tells when it last
+			 * changed, and records unchanged since update_time are
+			 * rewound to a single "unchanged" byte. Changes within
+			 * update_time's second are still sent. Hidden records
+			 * are always sent in full and clear the hash, so the
+			 * record is sent again once it is visible.
+			 */
+			if (!track)
+				continue;
+			if (hidden) {
+				node_ptr->pack_hash[0] = 0;
+				node_ptr->pack_hash[1] = 0;
+				continue;
+			}
+			hash = _pack_hash(get_buf_data(buffer) + rec_offset,
+					  get_buf_offset(buffer) - rec_offset);
+			if (hash != node_ptr->pack_hash[slot]) {
+				node_ptr->pack_hash[slot] = hash;
+				node_ptr->pack_change[slot] = now;
+			}
+			if (delta && (node_ptr->pack_change[slot] < update_time)) {
+				set_buf_offset(buffer, rec_offset - 1);
+				pack8(0, buffer);
+			}
 		}
 	} else {
 		error("select_g_select_jobinfo_pack: protocol_version "
@@ -825,6 +878,7 @@ extern void pack_all_node (char **buffer_ptr, int *buffer_size,
 	set_buf_offset (buffer, tmp_offset);
 
 	*buffer_size = get_buf_offset (buffer);
+	node_info_pack_size = *buffer_size;
 	buffer_ptr[0] = xfer_buf_data (buffer);
 }
 
@@ -862,9 +916,11 @@ extern void pack_one_node (char **buffer_ptr, int *buffer_size,
 	nodes_packed = 0;
 
 	if (protocol_version >= SLURM_MIN_PROTOCOL_VERSION) {
-		/* write header: count and time */
+		/* write header: count, time and (never set) delta flag */
 		pack32(nodes_packed, buffer);
 		pack_time(now, buffer);
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+			pack8(0, buffer);
 
 		/* write node records */
 		if (node_name)
@@ -924,14 +980,14 @@ static void _pack_node(node_record_t *dump_node_ptr, buf_t *buffer,
 	xassert(verify_lock(CONF_LOCK, READ_LOCK));
 
 	if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
-		packstr(dump_node_ptr->name, buffer);
-		packstr(dump_node_ptr->node_hostname, buffer);
-		packstr(dump_node_ptr->comm_name, buffer);
-		packstr(dump_node_ptr->bcast_address, buffer);
+		packvarstr(dump_node_ptr->name, buffer);
+		packvarstr(dump_node_ptr->node_hostname, buffer);
+		packvarstr(dump_node_ptr->comm_name, buffer);
+		packvarstr(dump_node_ptr->bcast_address, buffer);
 		pack16(dump_node_ptr->port, buffer);
-		pack32(dump_node_ptr->next_state, buffer);
-		pack32(dump_node_ptr->node_state, buffer);
-		packstr(dump_node_ptr->version, buffer);
+		packvar32(dump_node_ptr->next_state, buffer);
+		packvar32(dump_node_ptr->node_state, buffer);
+		packvarstr(dump_node_ptr->version, buffer);
 
 		/* Only data from config_record used for scheduling */
 		pack16(dump_node_ptr->config_ptr->cpus, buffer);
@@ -939,36 +995,36 @@ static void _pack_node(node_record_t *dump_node_ptr, buf_t *buffer,
 		pack16(dump_node_ptr->config_ptr->tot_sockets, buffer);
 		pack16(dump_node_ptr->config_ptr->cores, buffer);
 		pack16(dump_node_ptr->config_ptr->threads, buffer);
-		pack64(dump_node_ptr->config_ptr->real_memory, buffer);
-		pack32(dump_node_ptr->config_ptr->tmp_disk, buffer);
+		packvar64(dump_node_ptr->config_ptr->real_memory, buffer);
+		packvar32(dump_node_ptr->config_ptr->tmp_disk, buffer);
 
-		packstr(dump_node_ptr->mcs_label, buffer);
-		pack32(dump_node_ptr->owner, buffer);
+		packvarstr(dump_node_ptr->mcs_label, buffer);
+		packvar32(dump_node_ptr->owner, buffer);
 		pack16(dump_node_ptr->core_spec_cnt, buffer);
-		pack32(dump_node_ptr->cpu_bind, buffer);
-		pack64(dump_node_ptr->mem_spec_limit, buffer);
-		packstr(dump_node_ptr->cpu_spec_list, buffer);
+		packvar32(dump_node_ptr->cpu_bind, buffer);
+		packvar64(dump_node_ptr->mem_spec_limit, buffer);
+		packvarstr(dump_node_ptr->cpu_spec_list, buffer);
 
-		pack32(dump_node_ptr->cpu_load, buffer);
-		pack64(dump_node_ptr->free_mem, buffer);
-		pack32(dump_node_ptr->config_ptr->weight, buffer);
-		pack32(dump_node_ptr->reason_uid, buffer);
+		packvar32(dump_node_ptr->cpu_load, buffer);
+		packvar64(dump_node_ptr->free_mem, buffer);
+		packvar32(dump_node_ptr->config_ptr->weight, buffer);
+		packvar32(dump_node_ptr->reason_uid, buffer);
 
-		pack_time(dump_node_ptr->boot_time, buffer);
-		pack_time(dump_node_ptr->last_busy, buffer);
-		pack_time(dump_node_ptr->reason_time, buffer);
-		pack_time(dump_node_ptr->slurmd_start_time, buffer);
+		packvar_time(dump_node_ptr->boot_time, buffer);
+		packvar_time(dump_node_ptr->last_busy, buffer);
+		packvar_time(dump_node_ptr->reason_time, buffer);
+		packvar_time(dump_node_ptr->slurmd_start_time, buffer);
 
 		select_g_select_nodeinfo_pack(dump_node_ptr->select_nodeinfo,
 					      buffer, protocol_version);
 
-		packstr(dump_node_ptr->arch, buffer);
-		packstr(dump_node_ptr->features, buffer);
-		packstr(dump_node_ptr->features_act, buffer);
+		packvarstr(dump_node_ptr->arch, buffer);
+		packvarstr(dump_node_ptr->features, buffer);
+		packvarstr(dump_node_ptr->features_act, buffer);
 		if (dump_node_ptr->gres)
-			packstr(dump_node_ptr->gres, buffer);
+			packvarstr(dump_node_ptr->gres, buffer);
 		else
-			packstr(dump_node_ptr->config_ptr->gres, buffer);
+			packvarstr(dump_node_ptr->config_ptr->gres, buffer);
 
 		/* Gathering GRES details is slow, so don't by default */
 		if (show_flags & SHOW_DETAIL) {
@@ -977,14 +1033,14 @@ static void _pack_node(node_record_t *dump_node_ptr, buf_t *buffer,
 			gres_used  =
 				gres_get_node_used(dump_node_ptr->gres_list);
 		}
-		packstr(gres_drain, buffer);
-		packstr(gres_used, buffer);
+		packvarstr(gres_drain, buffer);
+		packvarstr(gres_used, buffer);
 		xfree(gres_drain);
 		xfree(gres_used);
 
-		packstr(dump_node_ptr->os, buffer);
-		packstr(dump_node_ptr->comment, buffer);
-		packstr(dump_node_ptr->reason, buffer);
+		packvarstr(dump_node_ptr->os, buffer);
+		packvarstr(dump_node_ptr->comment, buffer);
+		packvarstr(dump_node_ptr->reason, buffer);
 		acct_gather_energy_pack(dump_node_ptr->energy, buffer,
 					protocol_version);
 		ext_sensors_data_pack(dump_node_ptr->ext_sensors, buffer,
@@ -992,7 +1048,7 @@ static void _pack_node(node_record_t *dump_node_ptr, buf_t *buffer,
 		power_mgmt_data_pack(dump_node_ptr->power, buffer,
 				     protocol_version);
 
-		packstr(dump_node_ptr->tres_fmt_str, buffer);
+		packvarstr(dump_node_ptr->tres_fmt_str, buffer);
 	} else if (protocol_version >= SLURM_20_11_PROTOCOL_VERSION) {
 		packstr(dump_node_ptr->name, buffer);
 		packstr(dump_node_ptr->node_hostname, buffer);
@@ -1279,6 +1335,7 @@ int update_node ( update_node_msg_t * update_node_msg )
 			free (this_node_name);
 			break;
 		}
+		validate_node_reservations(node_inx);
 
 		if (hostaddr_list) {
 			char *this_addr = hostlist_shift(hostaddr_list);
@@ -2238,6 +2295,11 @@ extern int drain_nodes(char *nodes, char *reason, uint32_t reason_uid)
 
 		node_ptr->node_state |= NODE_STATE_DRAIN;
 		bit_clear (avail_node_bitmap, node_inx);
+		/*
+		 * node may be in a reservation with floating count of nodes
+		 * that needs to be updated
+		 */
+		validate_node_reservations(node_inx);
 		info ("drain_nodes: node %s state set to DRAIN",
 			this_node_name);
 		if ((node_ptr->reason == NULL) ||
@@ -2262,12 +2324,6 @@ extern int drain_nodes(char *nodes, char *reason, uint32_t reason_uid)
 
 	hostlist_destroy (host_list);
 
-	/*
-	 * check all reservations since nodes may have been in a reservation with
-	 * floating count of nodes that needs to be updated
-	 */
-	validate_all_reservations(false);
-
 	return error_code;
 }
 /* Return true if admin request to change node state from old to new is valid */
@@ -3934,10 +3990,10 @@ static void _make_node_down(node_record_t *node_ptr, time_t event_time)
 					node_ptr, event_time, NULL,
 					node_ptr->reason_uid);
 	/*
-	 * check all reservations since node may have been in a reservation with
+	 * check reservations since node may have been in a reservation with
 	 * floating count of nodes that needs to be updated
 	 */
-	validate_all_reservations(false);
+	validate_node_reservations(node_ptr - node_record_table_ptr);
 }
 
 /*
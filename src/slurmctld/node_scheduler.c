@@ -105,6 +105,30 @@ struct node_set {		/* set of nodes with same configuration */
 #define NODE_SET_OUTSIDE_FLEX	0x02
 #define NODE_SET_POWER_DN	0x04
 
+#define NODE_SET_CACHE_MAX	128	/* max cached node_set arrays */
+
+/*
+ * Node sets built for a job, keyed by everything in the job that the
+ * per-config loop of _build_node_list() looks at. Jobs without a
+ * reservation or excluded nodes that match a key reuse a copy.
+ */
+typedef struct {
+	bool can_reboot;
+	uint16_t cores_per_socket;
+	uint16_t cpus_per_task;
+	char *features;
+	struct node_set *node_set_ptr;
+	int node_set_size;
+	uint16_t ntasks_per_core;
+	part_record_t *part_ptr;
+	uint32_t pn_min_cpus;
+	uint64_t pn_min_memory;
+	uint32_t pn_min_tmp_disk;
+	uint16_t sockets_per_node;
+	bool test_only;
+	uint16_t threads_per_core;
+} node_set_cache_t;
+
 enum {
 	IN_FL,		/* Inside flex reservation */
 	OUT_FL,		/* Outside flex reservation */
@@ -145,6 +169,7 @@ static bitstr_t *_valid_features(job_record_t *job_ptr,
 				 bool can_reboot, bitstr_t *reboot_bitmap);
 
 static uint32_t reboot_weight = 0;
+static List node_set_cache = NULL;
 
 /*
  * _get_ntasks_per_core - Retrieve the value of ntasks_per_core from
@@ -454,6 +479,8 @@ static void _log_feature_nodes(job_feature_t  *job_feat_ptr)
  * For every element in the feature_list, identify the nodes with that feature
  * either active or available and set the feature_list's node_bitmap_active and
  * node_bitmap_avail fields accordingly.
+ * Elements already set since the last change to the node feature lists are
+ * left as they are.
  */
 extern void find_feature_nodes(List feature_list, bool can_reboot)
 {
@@ -465,6 +492,12 @@ extern void find_feature_nodes(List feature_list, bool can_reboot)
 		return;
 	feat_iter = list_iterator_create(feature_list);
 	while ((job_feat_ptr = list_next(feat_iter))) {
+		if ((job_feat_ptr->node_features_gen == node_features_gen) &&
+		    (!job_feat_ptr->changeable ||
+		     (job_feat_ptr->reboot_avail == can_reboot)))
+			continue;
+		job_feat_ptr->node_features_gen = node_features_gen;
+		job_feat_ptr->reboot_avail = can_reboot;
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_active);
 		FREE_NULL_BITMAP(job_feat_ptr->node_bitmap_avail);
 		node_feat_ptr = list_find_first(active_feature_list,
@@ -1179,15 +1212,15 @@ static int _get_req_features(struct node_set *node_set_ptr, int node_set_size,
 				    (prev_node_set_ptr->flags &
 				     NODE_SET_REBOOT))
 					continue;
+				if (bit_super_set(node_set_ptr[i].my_bitmap,
+						  feat_ptr->node_bitmap_active)) {
+					/* No inactive nodes (require reboot) */
+					continue;
+				}
 				inactive_bitmap =
 					bit_copy(node_set_ptr[i].my_bitmap);
 				bit_and_not(inactive_bitmap,
 					    feat_ptr->node_bitmap_active);
-				if (bit_ffs(inactive_bitmap) == -1) {
-					/* No inactive nodes (require reboot) */
-					FREE_NULL_BITMAP(inactive_bitmap);
-					continue;
-				}
 				sort_again = true;
 				if (bit_equal(prev_node_set_ptr->my_bitmap,
 					      inactive_bitmap)) {
@@ -1413,9 +1446,10 @@ static void _sync_node_weight(struct node_set *node_set_ptr, int node_set_size)
 			i_last = bit_fls(node_set_ptr[s].my_bitmap);
 		else
 			i_last = i_first - 1;
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(node_set_ptr[s].my_bitmap, i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(node_set_ptr[s].my_bitmap,
+					    i)) >= 0) &&
+		     (i <= i_last); i++) {
 			node_ptr = node_record_table_ptr + i;
 			node_ptr->sched_weight = node_set_ptr[s].sched_weight;
 		}
@@ -2135,6 +2169,7 @@ static void _end_null_job(job_record_t *job_ptr)
 	gres_ctld_job_clear(job_ptr->gres_list_req);
 	gres_ctld_job_clear(job_ptr->gres_list_alloc);
 	job_ptr->job_state = JOB_RUNNING;
+	slurm_preempt_reset_candidates();
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
 	FREE_NULL_BITMAP(job_ptr->node_bitmap);
 	xfree(job_ptr->nodes);
@@ -2640,6 +2675,7 @@ extern int select_nodes(job_record_t *job_ptr, bool test_only,
 	configuring = IS_JOB_CONFIGURING(job_ptr);
 
 	job_ptr->job_state = JOB_RUNNING;
+	slurm_preempt_reset_candidates();
 	job_ptr->bit_flags |= JOB_WAS_RUNNING;
 
 	if (select_g_select_nodeinfo_set(job_ptr) != SLURM_SUCCESS) {
@@ -3154,9 +3190,9 @@ extern int job_req_node_filter(job_record_t *job_ptr,
 	}
 
 	mc_ptr = detail_ptr->mc_ptr;
-	for (i = 0; i < node_record_count; i++) {
-		if (!bit_test(avail_bitmap, i))
-			continue;
+	for (i = 0;
+	     ((i = bit_ffs_from_bit(avail_bitmap, i)) >= 0) &&
+	     (i < node_record_count); i++) {
 		node_ptr = node_record_table_ptr + i;
 		config_ptr = node_ptr->config_ptr;
 		if ((detail_ptr->pn_min_cpus  > config_ptr->cpus)   ||
@@ -3232,6 +3268,132 @@ static void _split_node_set(struct node_set *node_set_ptr,
 	node_set_ptr[nset_inx_base].node_cnt -= node_set_ptr[nset_inx].node_cnt;
 }
 
+static void _free_node_set(struct node_set *node_set_ptr, int node_set_size)
+{
+	int i;
+
+	for (i = 0; i < node_set_size; i++) {
+		xfree(node_set_ptr[i].features);
+		FREE_NULL_BITMAP(node_set_ptr[i].my_bitmap);
+		FREE_NULL_BITMAP(node_set_ptr[i].feature_bits);
+	}
+	xfree(node_set_ptr);
+}
+
+/* Copy node_set_size records into a new array with room for node_set_len */
+static struct node_set *_copy_node_set(struct node_set *node_set_ptr,
+				       int node_set_size, int node_set_len)
+{
+	struct node_set *new_ptr;
+	int i;
+
+	new_ptr = xcalloc(node_set_len, sizeof(struct node_set));
+	for (i = 0; i < node_set_size; i++) {
+		new_ptr[i] = node_set_ptr[i];
+		new_ptr[i].features = xstrdup(node_set_ptr[i].features);
+		new_ptr[i].feature_bits = bit_copy(node_set_ptr[i].feature_bits);
+		new_ptr[i].my_bitmap = bit_copy(node_set_ptr[i].my_bitmap);
+	}
+
+	return new_ptr;
+}
+
+static void _free_node_set_cache(void *x)
+{
+	node_set_cache_t *cache_ptr = x;
+
+	_free_node_set(cache_ptr->node_set_ptr, cache_ptr->node_set_size);
+	xfree(cache_ptr->features);
+	xfree(cache_ptr);
+}
+
+static int _find_node_set_cache(void *x, void *key)
+{
+	node_set_cache_t *cache_ptr = x, *key_ptr = key;
+
+	if ((cache_ptr->part_ptr != key_ptr->part_ptr) ||
+	    (cache_ptr->can_reboot != key_ptr->can_reboot) ||
+	    (cache_ptr->test_only != key_ptr->test_only) ||
+	    (cache_ptr->pn_min_cpus != key_ptr->pn_min_cpus) ||
+	    (cache_ptr->pn_min_memory != key_ptr->pn_min_memory) ||
+	    (cache_ptr->pn_min_tmp_disk != key_ptr->pn_min_tmp_disk) ||
+	    (cache_ptr->cpus_per_task != key_ptr->cpus_per_task) ||
+	    (cache_ptr->ntasks_per_core != key_ptr->ntasks_per_core) ||
+	    (cache_ptr->sockets_per_node != key_ptr->sockets_per_node) ||
+	    (cache_ptr->cores_per_socket != key_ptr->cores_per_socket) ||
+	    (cache_ptr->threads_per_core != key_ptr->threads_per_core) ||
+	    xstrcmp(cache_ptr->features, key_ptr->features))
+		return 0;
+
+	return 1;
+}
+
+/*
+ * Fill in the node_set cache key for a job.
+ * RET false if the job's node sets can not come from the cache
+ */
+static bool _node_set_cache_key(job_record_t *job_ptr, bool test_only,
+				bool can_reboot, node_set_cache_t *key_ptr)
+{
+	struct job_details *detail_ptr = job_ptr->details;
+	multi_core_data_t *mc_ptr = detail_ptr->mc_ptr;
+
+	if (!node_set_cache || job_ptr->resv_name || job_ptr->resv_ptr ||
+	    detail_ptr->exc_node_bitmap)
+		return false;
+
+	memset(key_ptr, 0, sizeof(node_set_cache_t));
+	key_ptr->part_ptr = job_ptr->part_ptr;
+	key_ptr->features = detail_ptr->features;
+	key_ptr->can_reboot = can_reboot;
+	key_ptr->test_only = test_only;
+	key_ptr->pn_min_cpus = detail_ptr->pn_min_cpus;
+	key_ptr->pn_min_memory = detail_ptr->pn_min_memory & (~MEM_PER_CPU);
+	key_ptr->pn_min_tmp_disk = detail_ptr->pn_min_tmp_disk;
+	key_ptr->cpus_per_task = detail_ptr->cpus_per_task;
+	key_ptr->ntasks_per_core = _get_ntasks_per_core(detail_ptr);
+	if (mc_ptr) {
+		key_ptr->sockets_per_node = mc_ptr->sockets_per_node;
+		key_ptr->cores_per_socket = mc_ptr->cores_per_socket;
+		key_ptr->threads_per_core = mc_ptr->threads_per_core;
+	} else {
+		key_ptr->sockets_per_node = NO_VAL16;
+		key_ptr->cores_per_socket = NO_VAL16;
+		key_ptr->threads_per_core = NO_VAL16;
+	}
+
+	return true;
+}
+
+static void _add_node_set_cache(node_set_cache_t *key_ptr,
+				struct node_set *node_set_ptr,
+				int node_set_size)
+{
+	node_set_cache_t *cache_ptr;
+
+	if (list_count(node_set_cache) >= NODE_SET_CACHE_MAX)
+		return;
+
+	cache_ptr = xmalloc(sizeof(node_set_cache_t));
+	*cache_ptr = *key_ptr;
+	cache_ptr->features = xstrdup(key_ptr->features);
+	cache_ptr->node_set_ptr = _copy_node_set(node_set_ptr, node_set_size,
+						 node_set_size);
+	cache_ptr->node_set_size = node_set_size;
+	list_append(node_set_cache, cache_ptr);
+}
+
+extern void node_set_cache_begin(void)
+{
+	if (!node_set_cache)
+		node_set_cache = list_create(_free_node_set_cache);
+}
+
+extern void node_set_cache_end(void)
+{
+	FREE_NULL_LIST(node_set_cache);
+}
+
 /*
  * _build_node_list - identify which nodes could be allocated to a job
  *	based upon node features, memory, processors, etc. Note that a
@@ -3267,6 +3429,26 @@ static int _build_node_list(job_record_t *job_ptr,
 	bool resv_overlap = false;
 	bitstr_t *node_maps[NM_TYPES] = { NULL, NULL, NULL, NULL, NULL, NULL };
 	bitstr_t *reboot_bitmap = NULL;
+	node_set_cache_t cache_key, *cache_ptr = NULL;
+	bool use_cache;
+
+	use_cache = _node_set_cache_key(job_ptr, test_only, can_reboot,
+					&cache_key);
+	if (use_cache &&
+	    (cache_ptr = list_find_first(node_set_cache, _find_node_set_cache,
+					 &cache_key))) {
+		/* Later node selection uses the job's feature bitmaps */
+		find_feature_nodes(detail_ptr->feature_list,
+				   node_features_g_user_update(
+					   job_ptr->user_id));
+		node_set_len = list_count(config_list) * 16 + 1;
+		node_set_inx = cache_ptr->node_set_size;
+		node_set_ptr = _copy_node_set(cache_ptr->node_set_ptr,
+					      node_set_inx, node_set_len);
+		debug2("%s: %pJ reusing %d cached node sets",
+		       __func__, job_ptr, node_set_inx);
+		goto cached_node_set;
+	}
 
 	if (job_ptr->resv_name) {
 		/*
@@ -3635,6 +3817,10 @@ end_node_set:
 		return rc;
 	}
 
+	if (use_cache)
+		_add_node_set_cache(&cache_key, node_set_ptr, node_set_inx);
+
+cached_node_set:
 	/*
 	 * Clear message about any nodes which fail to satisfy specific
 	 * job requirements as there are some nodes which can be used
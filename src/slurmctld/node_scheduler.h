@@ -159,6 +159,18 @@ extern int get_node_cnts(job_record_t *job_ptr, uint32_t qos_flags,
 			 part_record_t *part_ptr, uint32_t *min_nodes,
 			 uint32_t *req_nodes, uint32_t *max_nodes);
 
+/*
+ * node_set_cache_begin - start caching the node sets built for jobs so that
+ *	later jobs in the same partition with identical feature and per-node
+ *	resource requirements skip rebuilding them
+ * node_set_cache_end - stop caching and free the cached node sets
+ * NOTE: Only valid while the caller continuously holds at least read config
+ *	and partition locks and a write node lock. Call node_set_cache_end()
+ *	before releasing them.
+ */
+extern void node_set_cache_begin(void);
+extern void node_set_cache_end(void);
+
 /* launch_prolog - launch job prolog script by slurmd on allocated nodes
  * IN job_ptr - pointer to the job record
  */
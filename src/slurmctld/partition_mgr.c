@@ -1070,7 +1070,7 @@ extern void pack_all_part(char **buffer_ptr, int *buffer_size,
 	buffer_ptr[0] = NULL;
 	*buffer_size = 0;
 
-	buffer = init_buf(BUF_SIZE);
+	buffer = init_pool_buf(BUF_SIZE);
 
 	/* write header: version and time */
 	parts_packed = 0;
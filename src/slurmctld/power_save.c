@@ -116,14 +116,15 @@ float suspend_cnt_f, resume_cnt_f;
 
 static void  _clear_power_config(void);
 static void  _do_failed_nodes(char *hosts);
-static void  _do_power_work(time_t now);
+static void  _do_power_work(time_t now, char **sleep_nodes,
+			     char **wake_nodes, char **failed_nodes);
 static void  _do_resume(char *host);
 static void  _do_suspend(char *host);
 static int   _init_power_config(void);
 static void *_init_power_save(void *arg);
 static int   _kill_procs(void);
 static void  _reap_procs(void);
-static void  _re_wake(void);
+static char *_re_wake(void);
 static pid_t _run_prog(char *prog, char *arg1, char *arg2, uint32_t job_id);
 static void  _shutdown_power(void);
 static bool  _valid_prog(char *file_name);
@@ -258,7 +259,16 @@ static int _pick_exc_nodes(void *x, void *arg)
 }
 
 /* Perform any power change work to nodes */
-static void _do_power_work(time_t now)
+/*
+ * Update the state of nodes to suspend or resume. The programs are run by the
+ * caller once the node write lock is released, since forking slurmctld with
+ * the locks held stalls every other thread for the duration of the fork.
+ * OUT sleep_nodes - nodes to pass to SuspendProgram, xfree() by caller
+ * OUT wake_nodes - nodes to pass to ResumeProgram, xfree() by caller
+ * OUT failed_nodes - nodes to pass to ResumeFailProgram, xfree() by caller
+ */
+static void _do_power_work(time_t now, char **sleep_nodes,
+			   char **wake_nodes, char **failed_nodes)
 {
 	int i, wake_cnt = 0, susp_total = 0;
 	time_t delta_t;
@@ -473,39 +483,24 @@ static void _do_power_work(time_t now)
 	}
 
 	if (sleep_node_bitmap) {
-		char *nodes;
-		nodes = bitmap2node_name(sleep_node_bitmap);
-		if (nodes)
-			_do_suspend(nodes);
-		else
+		if (!(*sleep_nodes = bitmap2node_name(sleep_node_bitmap)))
 			error("power_save: bitmap2nodename");
-		xfree(nodes);
 		FREE_NULL_BITMAP(sleep_node_bitmap);
 		/* last_node_update could be changed already by another thread!
 		last_node_update = now; */
 	}
 
 	if (wake_node_bitmap) {
-		char *nodes;
-		nodes = bitmap2node_name(wake_node_bitmap);
-		if (nodes)
-			_do_resume(nodes);
-		else
+		if (!(*wake_nodes = bitmap2node_name(wake_node_bitmap)))
 			error("power_save: bitmap2nodename");
-		xfree(nodes);
 		FREE_NULL_BITMAP(wake_node_bitmap);
 		/* last_node_update could be changed already by another thread!
 		last_node_update = now; */
 	}
 
 	if (failed_node_bitmap) {
-		char *nodes;
-		nodes = bitmap2node_name(failed_node_bitmap);
-		if (nodes)
-			_do_failed_nodes(nodes);
-		else
+		if (!(*failed_nodes = bitmap2node_name(failed_node_bitmap)))
 			error("power_save: bitmap2nodename");
-		xfree(nodes);
 		FREE_NULL_BITMAP(failed_node_bitmap);
 	}
 }
@@ -638,10 +633,16 @@ extern int power_job_reboot(job_record_t *job_ptr)
  * from the actual hardware state (e.g. ResumeProgram failed to complete).
  * To address that, when a node that should be powered up for a running
  * job is not responding, they try running ResumeProgram again. */
-static void _re_wake(void)
+/*
+ * Identify allocated nodes that are not responding and were not resumed by
+ * us, they may need a resume request after a slurmctld restart.
+ * RET nodes to pass to ResumeProgram or NULL, xfree() by caller
+ */
+static char *_re_wake(void)
 {
 	node_record_t *node_ptr;
 	bitstr_t *wake_node_bitmap = NULL;
+	char *nodes = NULL;
 	int i;
 
 	node_ptr = node_record_table_ptr;
@@ -659,18 +660,12 @@ static void _re_wake(void)
 	}
 
 	if (wake_node_bitmap) {
-		char *nodes;
-		nodes = bitmap2node_name(wake_node_bitmap);
-		if (nodes) {
-			pid_t pid = _run_prog(resume_prog, nodes, NULL, 0);
-			if (power_save_debug)
-				info("power_save: pid %d rewaking nodes %s",
-				     (int) pid, nodes);
-		} else
+		if (!(nodes = bitmap2node_name(wake_node_bitmap)))
 			error("power_save: bitmap2nodename");
-		xfree(nodes);
 		FREE_NULL_BITMAP(wake_node_bitmap);
 	}
+
+	return nodes;
 }
 
 static void _do_failed_nodes(char *hosts)
@@ -1077,17 +1072,41 @@ static void *_init_power_save(void *arg)
 		if ((now >= (last_power_scan + power_save_min_interval)) &&
 		    ((last_node_update >= last_power_scan) ||
 		     (now >= (last_power_scan + power_save_interval)))) {
+			char *sleep_nodes = NULL, *wake_nodes = NULL;
+			char *failed_nodes = NULL;
+
 			lock_slurmctld(node_write_lock);
-			_do_power_work(now);
+			_do_power_work(now, &sleep_nodes, &wake_nodes,
+				       &failed_nodes);
 			unlock_slurmctld(node_write_lock);
 			last_power_scan = now;
+
+			if (sleep_nodes)
+				_do_suspend(sleep_nodes);
+			if (wake_nodes)
+				_do_resume(wake_nodes);
+			if (failed_nodes)
+				_do_failed_nodes(failed_nodes);
+			xfree(sleep_nodes);
+			xfree(wake_nodes);
+			xfree(failed_nodes);
 		}
 
 		if (slurmd_timeout &&
 		    (now > (boot_time + (slurmd_timeout / 2)))) {
+			char *nodes;
+
 			lock_slurmctld(node_read_lock);
-			_re_wake();
+			nodes = _re_wake();
 			unlock_slurmctld(node_read_lock);
+			if (nodes) {
+				pid_t pid = _run_prog(resume_prog, nodes,
+						      NULL, 0);
+				if (power_save_debug)
+					info("power_save: pid %d rewaking nodes %s",
+					     (int) pid, nodes);
+				xfree(nodes);
+			}
 			/* prevent additional executions */
 			boot_time += (365 * 24 * 60 * 60);
 			slurmd_timeout = 0;
@@ -82,6 +82,21 @@ static plugin_context_t *g_context = NULL;
 static pthread_mutex_t	    g_context_lock = PTHREAD_MUTEX_INITIALIZER;
 static bool init_run = false;
 
+/*
+ * Records which may be preemption candidates: running and suspended jobs
+ * and hetjob leaders. Most of job_list is pending or finished jobs, so
+ * rather than scanning all of it for every pending job tested by the
+ * schedulers, keep the candidates in an array that is rebuilt after
+ * slurm_preempt_reset_candidates(). Records can not be freed, and no job
+ * can start, without that being called, so the array stays valid.
+ * Each entry is still tested again when building a preemptee list.
+ * cand_mutex is needed since readers of job_list may run concurrently.
+ */
+static pthread_mutex_t cand_mutex = PTHREAD_MUTEX_INITIALIZER;
+static job_record_t **cand_array = NULL;
+static int cand_cnt = 0, cand_size = 0;
+static bool cand_valid = false;
+
 static int _is_job_preempt_exempt_internal(void *x, void *key)
 {
 	job_record_t *preemptee_ptr = (job_record_t *)x;
@@ -149,36 +164,65 @@ static int _find_job_by_preempt_mode(void *x, void *arg)
 	return 0;
 }
 
-static int _add_preemptable_job(void *x, void *arg)
+static bool _is_candidate(job_record_t *candidate)
 {
-	job_record_t *candidate = (job_record_t *) x;
-	preempt_candidates_t *candidates = (preempt_candidates_t *) arg;
-	job_record_t *preemptor = candidates->preemptor;
-
 	/*
 	 * We only want to look at the master component of a hetjob.  Since all
 	 * components have to be preemptable it should be here at some point.
 	 */
 	if (candidate->het_job_id && !candidate->het_job_list)
+		return false;
+
+	/*
+	 * Most of job_list is pending or finished jobs, skip them before
+	 * asking the preempt plugin about them.
+	 */
+	if (!candidate->het_job_list &&
+	    !IS_JOB_RUNNING(candidate) && !IS_JOB_SUSPENDED(candidate))
+		return false;
+
+	return true;
+}
+
+static int _cache_candidate(void *x, void *arg)
+{
+	job_record_t *candidate = (job_record_t *) x;
+
+	if (!_is_candidate(candidate))
 		return 0;
 
+	if (cand_cnt >= cand_size) {
+		cand_size = MAX(cand_size * 2, 64);
+		xrecalloc(cand_array, cand_size, sizeof(*cand_array));
+	}
+	cand_array[cand_cnt++] = candidate;
+
+	return 0;
+}
+
+static void _add_preemptable_job(job_record_t *candidate,
+				 preempt_candidates_t *candidates)
+{
+	job_record_t *preemptor = candidates->preemptor;
+
+	if (!_is_candidate(candidate))
+		return;
+
 	if (_is_job_preempt_exempt(candidate, preemptor))
-		return 0;
+		return;
 	/*
 	 * We have to check the entire bitmap space here before we can check
 	 * each part of a hetjob in _is_job_preempt_exempt()
 	 */
 	if (!job_overlap_and_running(preemptor->part_ptr->node_bitmap,
 				     candidate))
-		return 0;
+		return;
 
 	/* This job is a preemption candidate */
 	if (!candidates->preemptee_job_list)
 		candidates->preemptee_job_list = list_create(NULL);
 
 	list_append(candidates->preemptee_job_list, candidate);
-
-	return 0;
 }
 
 static int _sort_by_prio(void *x, void *y)
@@ -263,9 +307,26 @@ extern int slurm_preempt_fini(void)
 	init_run = false;
 	rc = plugin_context_destroy(g_context);
 	g_context = NULL;
+
+	slurm_mutex_lock(&cand_mutex);
+	xfree(cand_array);
+	cand_cnt = cand_size = 0;
+	cand_valid = false;
+	slurm_mutex_unlock(&cand_mutex);
+
 	return rc;
 }
 
+extern void slurm_preempt_reset_candidates(void)
+{
+	/*
+	 * Callers hold the job write lock, so nobody can be using the array.
+	 * Don't take cand_mutex, this is also called from the job_list
+	 * destructor with the list lock held.
+	 */
+	cand_valid = false;
+}
+
 extern List slurm_find_preemptable_jobs(job_record_t *job_ptr)
 {
 	preempt_candidates_t candidates	= { .preemptor = job_ptr };
@@ -291,8 +352,17 @@ extern List slurm_find_preemptable_jobs(job_record_t *job_ptr)
 
 	/* Build an array of pointers to preemption candidates */
 	if (slurm_preemption_enabled() ||
-	    job_uses_max_start_delay_resv(job_ptr))
-		list_for_each(job_list, _add_preemptable_job, &candidates);
+	    job_uses_max_start_delay_resv(job_ptr)) {
+		slurm_mutex_lock(&cand_mutex);
+		if (!cand_valid) {
+			cand_cnt = 0;
+			list_for_each(job_list, _cache_candidate, NULL);
+			cand_valid = true;
+		}
+		for (int i = 0; i < cand_cnt; i++)
+			_add_preemptable_job(cand_array[i], &candidates);
+		slurm_mutex_unlock(&cand_mutex);
+	}
 
 	if (candidates.preemptee_job_list && youngest_order)
 		list_sort(candidates.preemptee_job_list, _sort_by_youngest);
@@ -65,6 +65,14 @@ int slurm_preempt_init(void);
  */
 extern int slurm_preempt_fini(void);
 
+/*
+ * Note that the set of possible preemption candidates may have changed.
+ * Call when a job record is created or deleted, when a job starts running
+ * and when a hetjob leader gets its het_job_list.
+ * NOTE: Caller must hold the job write lock.
+ */
+extern void slurm_preempt_reset_candidates(void);
+
 /*
  * slurm_find_preemptable_jobs - Given a pointer to a pending job, return list
  *	of pointers to preemptable jobs. The jobs should be sorted in order
@@ -67,6 +67,7 @@
 #include "src/common/node_features.h"
 #include "src/common/node_select.h"
 #include "src/common/pack.h"
+#include "src/common/probes.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_acct_gather.h"
 #include "src/common/slurm_auth.h"
@@ -87,6 +88,7 @@
 #include "src/slurmctld/acct_policy.h"
 #include "src/slurmctld/agent.h"
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/fed_mgr.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/gang.h"
@@ -94,10 +96,13 @@
 #include "src/slurmctld/licenses.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/power_save.h"
+#include "src/slurmctld/preempt.h"
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/read_config.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/rpc_queue.h"
 #include "src/slurmctld/sched_plugin.h"
+#include "src/slurmctld/sched_trace.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/slurmctld_plugstack.h"
 #include "src/slurmctld/srun_comm.h"
@@ -114,6 +119,27 @@ static uint32_t rpc_user_id[RPC_USER_SIZE] = { 0 };
 static uint32_t rpc_user_cnt[RPC_USER_SIZE] = { 0 };
 static uint64_t rpc_user_time[RPC_USER_SIZE] = { 0 };
 
+/*
+ * Latency of the most recent RPCs of each type (same index as rpc_type_id),
+ * kept in ring buffers so percentiles can be computed when statistics are
+ * requested. Execution time excludes time waiting for slurmctld locks.
+ */
+#define RPC_LAT_WINDOW 128
+#define RPC_DELAY_WINDOW 1024
+typedef struct {
+	uint32_t cnt;			/* samples recorded */
+	uint32_t exec[RPC_LAT_WINDOW];
+	uint32_t exec_max;
+	uint32_t wait[RPC_LAT_WINDOW];
+	uint32_t wait_max;
+	uint64_t wait_sum;
+} rpc_lat_t;
+static rpc_lat_t rpc_type_lat[RPC_TYPE_SIZE];
+static uint32_t rpc_delay[RPC_DELAY_WINDOW];
+static uint64_t rpc_delay_cnt = 0;
+static uint32_t rpc_delay_max = 0;
+static uint64_t rpc_delay_sum = 0;
+
 static config_response_msg_t *config_for_slurmd = NULL;
 static config_response_msg_t *config_for_clients = NULL;
 
@@ -153,16 +179,30 @@ extern diag_stats_t slurmctld_diag_stats;
 static __thread bool drop_priv = false;
 #endif
 
-extern void record_rpc_stats(slurm_msg_t *msg, long delta)
+extern void record_rpc_stats(slurm_msg_t *msg, long delta, uint64_t lock_wait)
 {
+	uint32_t exec, wait;
+
+	wait = MIN(lock_wait, UINT32_MAX);
+	exec = MIN(MAX(delta - (long) wait, 0), UINT32_MAX);
+
 	slurm_mutex_lock(&rpc_mutex);
 	for (int i = 0; i < RPC_TYPE_SIZE; i++) {
+		rpc_lat_t *lat = &rpc_type_lat[i];
+
 		if (rpc_type_id[i] == 0)
 			rpc_type_id[i] = msg->msg_type;
 		else if (rpc_type_id[i] != msg->msg_type)
 			continue;
 		rpc_type_cnt[i]++;
 		rpc_type_time[i] += delta;
+
+		lat->exec[lat->cnt % RPC_LAT_WINDOW] = exec;
+		lat->wait[lat->cnt % RPC_LAT_WINDOW] = wait;
+		lat->exec_max = MAX(lat->exec_max, exec);
+		lat->wait_max = MAX(lat->wait_max, wait);
+		lat->wait_sum += wait;
+		lat->cnt++;
 		break;
 	}
 	for (int i = 0; i < RPC_USER_SIZE; i++) {
@@ -177,6 +217,74 @@ extern void record_rpc_stats(slurm_msg_t *msg, long delta)
 	slurm_mutex_unlock(&rpc_mutex);
 }
 
+extern void record_rpc_queue_delay(uint64_t delay)
+{
+	uint32_t delay32 = MIN(delay, UINT32_MAX);
+
+	slurm_mutex_lock(&rpc_mutex);
+	rpc_delay[rpc_delay_cnt % RPC_DELAY_WINDOW] = delay32;
+	rpc_delay_cnt++;
+	rpc_delay_max = MAX(rpc_delay_max, delay32);
+	rpc_delay_sum += delay;
+	slurm_mutex_unlock(&rpc_mutex);
+}
+
+static int _cmp_uint32(const void *x, const void *y)
+{
+	uint32_t a = *(uint32_t *) x, b = *(uint32_t *) y;
+
+	if (a < b)
+		return -1;
+	return (a > b);
+}
+
+/*
+ * Pack the 50th, 90th and 99th percentiles of the samples in a ring buffer,
+ * followed by max
+ */
+static void _pack_percentiles(uint32_t *ring, uint64_t cnt, uint32_t window,
+			      uint32_t max, buf_t *buffer)
+{
+	static const int pct[] = { 50, 90, 99 };
+	uint32_t *sorted, n = MIN(cnt, window);
+
+	sorted = xcalloc(MAX(n, 1), sizeof(uint32_t));
+	memcpy(sorted, ring, n * sizeof(uint32_t));
+	qsort(sorted, n, sizeof(uint32_t), _cmp_uint32);
+	for (int i = 0; i < ARRAY_SIZE(pct); i++)
+		pack32(n ? sorted[((n * pct[i]) - 1) / 100] : 0, buffer);
+	pack32(max, buffer);
+	xfree(sorted);
+}
+
+/* Pack RPC latency percentiles and queueing delay, rpc_mutex must be held */
+static void _pack_rpc_latency(buf_t *buffer)
+{
+	uint32_t i;
+
+	for (i = 0; i < RPC_TYPE_SIZE; i++) {
+		if (rpc_type_id[i] == 0)
+			break;
+	}
+	pack32(RPC_LAT_WINDOW, buffer);
+	pack32(i, buffer);
+	for (int j = 0; j < i; j++) {
+		rpc_lat_t *lat = &rpc_type_lat[j];
+
+		pack16(rpc_type_id[j], buffer);
+		_pack_percentiles(lat->exec, lat->cnt, RPC_LAT_WINDOW,
+				  lat->exec_max, buffer);
+		_pack_percentiles(lat->wait, lat->cnt, RPC_LAT_WINDOW,
+				  lat->wait_max, buffer);
+		pack64(lat->wait_sum, buffer);
+	}
+
+	pack64(rpc_delay_cnt, buffer);
+	pack64(rpc_delay_sum, buffer);
+	_pack_percentiles(rpc_delay, rpc_delay_cnt, RPC_DELAY_WINDOW,
+			  rpc_delay_max, buffer);
+}
+
 /* These functions prevent certain RPCs from keeping the slurmctld write locks
  * constantly set, which can prevent other RPCs and system functions from being
  * processed. For example, a steady stream of batch submissions can prevent
@@ -1186,8 +1294,10 @@ static void _slurm_rpc_allocate_het_job(slurm_msg_t * msg)
 	_create_het_job_id_set(jobid_hostset, het_job_offset,
 				&het_job_id_set);
 
-	if (first_job_ptr)
+	if (first_job_ptr) {
 		first_job_ptr->het_job_list = submit_job_list;
+		slurm_preempt_reset_candidates();
+	}
 	iter = list_iterator_create(submit_job_list);
 	while ((job_ptr = list_next(iter))) {
 		job_ptr->het_job_id_set = xstrdup(het_job_id_set);
@@ -1515,11 +1625,40 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 	slurm_msg_t response_msg;
 	job_info_request_msg_t *job_info_request_msg =
 		(job_info_request_msg_t *) msg->data;
+	job_info_snapshot_t *snap = NULL;
+	time_t snap_job_update;
+	bool filtered = (job_info_request_msg->accounts ||
+			 job_info_request_msg->job_id_list ||
+			 job_info_request_msg->partitions ||
+			 job_info_request_msg->state_list ||
+			 job_info_request_msg->uid_list);
+	bool delta = ((job_info_request_msg->show_flags & SHOW_DELTA) &&
+		      job_info_request_msg->last_update);
 	/* Locks: Read config job part */
 	slurmctld_lock_t job_read_lock = {
 		READ_LOCK, READ_LOCK, NO_LOCK, READ_LOCK, READ_LOCK };
 
 	START_TIMER;
+	if (!job_info_request_msg->job_ids && !filtered && !delta &&
+	    (snap = job_info_snapshot_get(job_info_request_msg->show_flags,
+					  msg->auth_uid,
+					  msg->protocol_version,
+					  (msg->flags &
+					   CTLD_QUEUE_PROCESSING)))) {
+		/* Serve from published snapshot without slurmctld locks */
+		dump = job_info_snapshot_data(snap, &dump_size,
+					      &snap_job_update);
+		if ((job_info_request_msg->last_update - 1) >=
+		    snap_job_update) {
+			job_info_snapshot_put(snap);
+			debug3("_slurm_rpc_dump_jobs, no change");
+			slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+			return;
+		}
+		END_TIMER2("_slurm_rpc_dump_jobs");
+		goto send_msg;
+	}
+
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(job_read_lock);
 
@@ -1528,35 +1667,51 @@ static void _slurm_rpc_dump_jobs(slurm_msg_t * msg)
 			unlock_slurmctld(job_read_lock);
 		debug3("_slurm_rpc_dump_jobs, no change");
 		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
+		return;
+	}
+
+	if (job_info_request_msg->job_ids) {
+		pack_spec_jobs(&dump, &dump_size,
+			       job_info_request_msg->job_ids,
+			       job_info_request_msg->show_flags,
+			       msg->auth_uid, NO_VAL,
+			       msg->protocol_version);
+	} else if (filtered || delta) {
+		pack_all_jobs(&dump, &dump_size,
+			      job_info_request_msg->show_flags,
+			      msg->auth_uid, NO_VAL, job_info_request_msg,
+			      job_info_request_msg->last_update,
+			      msg->protocol_version);
+	} else if ((snap = job_info_snapshot_publish(
+			    job_info_request_msg->show_flags,
+			    msg->auth_uid, msg->protocol_version))) {
+		dump = job_info_snapshot_data(snap, &dump_size,
+					      &snap_job_update);
 	} else {
-		if (job_info_request_msg->job_ids) {
-			pack_spec_jobs(&dump, &dump_size,
-				       job_info_request_msg->job_ids,
-				       job_info_request_msg->show_flags,
-				       msg->auth_uid, NO_VAL,
-				       msg->protocol_version);
-		} else {
-			pack_all_jobs(&dump, &dump_size,
-				      job_info_request_msg->show_flags,
-				      msg->auth_uid, NO_VAL,
-				      msg->protocol_version);
-		}
-		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
-			unlock_slurmctld(job_read_lock);
-		END_TIMER2("_slurm_rpc_dump_jobs");
+		pack_all_jobs(&dump, &dump_size,
+			      job_info_request_msg->show_flags,
+			      msg->auth_uid, NO_VAL, NULL, 0,
+			      msg->protocol_version);
+	}
+	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
+		unlock_slurmctld(job_read_lock);
+	END_TIMER2("_slurm_rpc_dump_jobs");
 #if 0
-		info("_slurm_rpc_dump_jobs, size=%d %s", dump_size, TIME_STR);
+	info("_slurm_rpc_dump_jobs, size=%d %s", dump_size, TIME_STR);
 #endif
 
-		response_init(&response_msg, msg);
-		response_msg.msg_type = RESPONSE_JOB_INFO;
-		response_msg.data = dump;
-		response_msg.data_size = dump_size;
+send_msg:
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_JOB_INFO;
+	response_msg.data = dump;
+	response_msg.data_size = dump_size;
 
-		/* send message */
-		slurm_send_node_msg(msg->conn_fd, &response_msg);
-		xfree(dump);
-	}
+	/* send message */
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	if (snap)
+		job_info_snapshot_put(snap);
+	else
+		free_pool_data(dump);
 }
 
 /* _slurm_rpc_dump_jobs - process RPC for job state information */
@@ -1576,7 +1731,7 @@ static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		lock_slurmctld(job_read_lock);
 	pack_all_jobs(&dump, &dump_size, job_info_request_msg->show_flags,
-		      msg->auth_uid, job_info_request_msg->user_id,
+		      msg->auth_uid, job_info_request_msg->user_id, NULL, 0,
 		      msg->protocol_version);
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 		unlock_slurmctld(job_read_lock);
@@ -1592,7 +1747,7 @@ static void _slurm_rpc_dump_jobs_user(slurm_msg_t * msg)
 
 	/* send message */
 	slurm_send_node_msg(msg->conn_fd, &response_msg);
-	xfree(dump);
+	free_pool_data(dump);
 }
 
 /* _slurm_rpc_dump_job_single - process RPC for one job's state information */
@@ -1630,7 +1785,37 @@ static void _slurm_rpc_dump_job_single(slurm_msg_t * msg)
 		response_msg.data_size = dump_size;
 		slurm_send_node_msg(msg->conn_fd, &response_msg);
 	}
-	xfree(dump);
+	free_pool_data(dump);
+}
+
+/* _slurm_rpc_job_sched_trace - process RPC for one job's recent scheduling
+ *	attempts */
+static void _slurm_rpc_job_sched_trace(slurm_msg_t *msg)
+{
+	DEF_TIMERS;
+	int rc;
+	sched_trace_msg_t trace_msg;
+	slurm_msg_t response_msg;
+	job_id_msg_t *job_id_msg = (job_id_msg_t *) msg->data;
+	/* Locks: Read config and job */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, NO_LOCK, NO_LOCK, NO_LOCK };
+
+	START_TIMER;
+	lock_slurmctld(job_read_lock);
+	rc = sched_trace_get(job_id_msg->job_id, msg->auth_uid, &trace_msg);
+	unlock_slurmctld(job_read_lock);
+	END_TIMER2("_slurm_rpc_job_sched_trace");
+
+	if (rc != SLURM_SUCCESS) {
+		slurm_send_rc_msg(msg, rc);
+	} else {
+		response_init(&response_msg, msg);
+		response_msg.msg_type = RESPONSE_JOB_SCHED_TRACE;
+		response_msg.data = &trace_msg;
+		slurm_send_node_msg(msg->conn_fd, &response_msg);
+	}
+	xfree(trace_msg.trace_array);
 }
 
 static void  _slurm_rpc_get_shares(slurm_msg_t *msg)
@@ -1805,7 +1990,8 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 		slurm_send_rc_msg(msg, SLURM_NO_CHANGE_IN_DATA);
 	} else {
 		pack_all_node(&dump, &dump_size, node_req_msg->show_flags,
-			      msg->auth_uid, msg->protocol_version);
+			      msg->auth_uid, node_req_msg->last_update,
+			      msg->protocol_version);
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
 			unlock_slurmctld(node_write_lock);
 		END_TIMER2("_slurm_rpc_dump_nodes");
@@ -1820,7 +2006,7 @@ static void _slurm_rpc_dump_nodes(slurm_msg_t * msg)
 
 		/* send message */
 		slurm_send_node_msg(msg->conn_fd, &response_msg);
-		xfree(dump);
+		free_pool_data(dump);
 	}
 }
 
@@ -1920,7 +2106,44 @@ static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 
 		/* send message */
 		slurm_send_node_msg(msg->conn_fd, &response_msg);
-		xfree(dump);
+		free_pool_data(dump);
+	}
+}
+
+/* Set while processing a queued batch of epilog complete messages */
+static bool epilog_queue_run_sched = false;
+
+/* Trigger scheduling and state save after job epilog completion */
+static void _epilog_complete_sched(void)
+{
+	static time_t config_update = 0;
+	static bool defer_sched = false;
+
+	if (config_update != slurm_conf.last_update) {
+		defer_sched = (xstrcasestr(slurm_conf.sched_params, "defer"));
+		config_update = slurm_conf.last_update;
+	}
+
+	/*
+	 * In defer mode, avoid triggering the scheduler logic
+	 * for every epilog complete message.
+	 * As one epilog message is sent from every node of each
+	 * job at termination, the number of simultaneous schedule
+	 * calls can be very high for large machine or large number
+	 * of managed jobs.
+	 */
+	if (!LOTS_OF_AGENTS && !defer_sched)
+		(void) schedule(0);	/* Has own locking */
+	schedule_node_save();		/* Has own locking */
+	schedule_job_save();		/* Has own locking */
+}
+
+/* Run once for each batch of queued epilog complete messages, no locks held */
+static void _epilog_complete_post(void)
+{
+	if (epilog_queue_run_sched) {
+		epilog_queue_run_sched = false;
+		_epilog_complete_sched();
 	}
 }
 
@@ -1929,8 +2152,6 @@ static void _slurm_rpc_dump_partitions(slurm_msg_t * msg)
 static void  _slurm_rpc_epilog_complete(slurm_msg_t *msg)
 {
 	static int active_rpc_cnt = 0;
-	static time_t config_update = 0;
-	static bool defer_sched = false;
 	DEF_TIMERS;
 	/* Locks: Read configuration, write job, write node */
 	slurmctld_lock_t job_write_lock = {
@@ -1947,15 +2168,9 @@ static void  _slurm_rpc_epilog_complete(slurm_msg_t *msg)
 		return;
 	}
 
-	/* Only throttle on non-composite messages, the lock should
+	/* Only throttle on non-queued messages, the lock should
 	 * already be set earlier. */
 	if (!(msg->flags & CTLD_QUEUE_PROCESSING)) {
-		if (config_update != slurm_conf.last_update) {
-			defer_sched = (xstrcasestr(slurm_conf.sched_params,
-						   "defer"));
-			config_update = slurm_conf.last_update;
-		}
-
 		_throttle_start(&active_rpc_cnt);
 		lock_slurmctld(job_write_lock);
 	}
@@ -1984,20 +2199,15 @@ static void  _slurm_rpc_epilog_complete(slurm_msg_t *msg)
 
 	END_TIMER2("_slurm_rpc_epilog_complete");
 
-	/* Functions below provide their own locking */
-	if (!(msg->flags & CTLD_QUEUE_PROCESSING) && run_scheduler) {
-		/*
-		 * In defer mode, avoid triggering the scheduler logic
-		 * for every epilog complete message.
-		 * As one epilog message is sent from every node of each
-		 * job at termination, the number of simultaneous schedule
-		 * calls can be very high for large machine or large number
-		 * of managed jobs.
-		 */
-		if (!LOTS_OF_AGENTS && !defer_sched)
-			(void) schedule(0);	/* Has own locking */
-		schedule_node_save();		/* Has own locking */
-		schedule_job_save();		/* Has own locking */
+	/*
+	 * Queued messages are processed in batches with the locks held, the
+	 * scheduler is triggered once per batch by _epilog_complete_post().
+	 */
+	if (run_scheduler) {
+		if (msg->flags & CTLD_QUEUE_PROCESSING)
+			epilog_queue_run_sched = true;
+		else
+			_epilog_complete_sched();
 	}
 
 	/* NOTE: RPC has no response */
@@ -2797,7 +3007,8 @@ static void _slurm_rpc_node_registration(slurm_msg_t *msg)
 							  msg->protocol_version,
 							  &newly_up);
 #else
-		validate_jobs_on_node(node_reg_stat_msg);
+		validate_jobs_on_node(node_reg_stat_msg,
+				      (msg->flags & CTLD_QUEUE_PROCESSING));
 		error_code = validate_node_specs(msg, &newly_up);
 #endif
 		if (!(msg->flags & CTLD_QUEUE_PROCESSING))
@@ -3936,8 +4147,10 @@ static void _slurm_rpc_submit_batch_het_job(slurm_msg_t *msg)
 
 	_create_het_job_id_set(jobid_hostset, het_job_offset,
 			       &het_job_id_set);
-	if (first_job_ptr)
+	if (first_job_ptr) {
 		first_job_ptr->het_job_list = submit_job_list;
+		slurm_preempt_reset_candidates();
+	}
 
 	iter = list_iterator_create(submit_job_list);
 	while ((job_ptr = list_next(iter))) {
@@ -3977,9 +4190,10 @@ send_msg:
 		if (submit_job_list) {
 			(void) list_for_each(submit_job_list, _het_job_cancel,
 					     NULL);
-			if (first_job_ptr)
+			if (first_job_ptr) {
 				first_job_ptr->het_job_list = submit_job_list;
-			else
+				slurm_preempt_reset_candidates();
+			} else
 				FREE_NULL_LIST(submit_job_list);
 		}
 	} else {
@@ -4003,6 +4217,163 @@ send_msg:
 	xfree(job_submit_user_msg);
 }
 
+/*
+ * _slurm_rpc_submit_batch_job_list - process RPC to submit many independent
+ *	batch jobs. All requests are validated under a single acquisition of
+ *	the read locks and created under a single acquisition of the write
+ *	locks, with job state saved once. Each job is accepted or rejected on
+ *	its own and the response reports the outcome of every job.
+ */
+static void _slurm_rpc_submit_batch_job_list(slurm_msg_t *msg)
+{
+	static int active_rpc_cnt = 0;
+	ListIterator iter;
+	int error_code;
+	uint32_t i, job_cnt, submit_cnt = 0;
+	DEF_TIMERS;
+	job_record_t *job_ptr;
+	slurm_msg_t response_msg;
+	submit_response_list_msg_t *submit_msg;
+	job_desc_msg_t *job_desc_msg;
+	/* Locks: Read config, read job, read node, read partition */
+	slurmctld_lock_t job_read_lock = {
+		READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK, READ_LOCK };
+	/* Locks: Read config, write job, write node, read partition, read fed */
+	slurmctld_lock_t job_write_lock = {
+		READ_LOCK, WRITE_LOCK, WRITE_LOCK, READ_LOCK, READ_LOCK };
+	List job_req_list = (List) msg->data;
+	gid_t gid = auth_g_get_gid(msg->auth_cred);
+	char *err_msg;
+
+	START_TIMER;
+	if (!job_req_list || !(job_cnt = list_count(job_req_list))) {
+		info("REQUEST_SUBMIT_BATCH_JOB_LIST from uid=%u with empty job list",
+		     msg->auth_uid);
+		slurm_send_rc_msg(msg, SLURM_ERROR);
+		return;
+	}
+	if (slurmctld_config.submissions_disabled) {
+		info("Submissions disabled on system");
+		slurm_send_rc_msg(msg, ESLURM_SUBMISSIONS_DISABLED);
+		return;
+	}
+
+	submit_msg = xmalloc(sizeof(*submit_msg));
+	submit_msg->job_cnt = job_cnt;
+	submit_msg->error_code = xcalloc(job_cnt, sizeof(uint32_t));
+	submit_msg->job_id = xcalloc(job_cnt, sizeof(uint32_t));
+	submit_msg->job_submit_user_msg = xcalloc(job_cnt, sizeof(char *));
+
+	/* Validate the individual requests */
+	lock_slurmctld(job_read_lock);	/* Locks for job_submit plugin use */
+	iter = list_iterator_create(job_req_list);
+	for (i = 0; (job_desc_msg = list_next(iter)); i++) {
+		err_msg = NULL;
+		if ((error_code = _valid_id("REQUEST_SUBMIT_BATCH_JOB_LIST",
+					    job_desc_msg, msg->auth_uid,
+					    gid)))
+			goto next_valid;
+
+		_set_hostname(msg, &job_desc_msg->alloc_node);
+		if ((job_desc_msg->alloc_node == NULL) ||
+		    (job_desc_msg->alloc_node[0] == '\0')) {
+			error("REQUEST_SUBMIT_BATCH_JOB_LIST lacks alloc_node from uid=%u",
+			      msg->auth_uid);
+			error_code = ESLURM_INVALID_NODE_NAME;
+			goto next_valid;
+		}
+
+		dump_job_desc(job_desc_msg);
+
+		job_desc_msg->het_job_offset = NO_VAL;
+		error_code = validate_job_create_req(job_desc_msg,
+						     msg->auth_uid, &err_msg);
+next_valid:
+		submit_msg->error_code[i] = error_code;
+		/* Only modified by job_submit_plugin_submit */
+		submit_msg->job_submit_user_msg[i] = err_msg;
+	}
+	list_iterator_destroy(iter);
+	unlock_slurmctld(job_read_lock);
+
+	/* Create new job allocations */
+	_throttle_start(&active_rpc_cnt);
+	lock_slurmctld(job_write_lock);
+	START_TIMER;	/* Restart after we have locks */
+	iter = list_iterator_create(job_req_list);
+	for (i = 0; (job_desc_msg = list_next(iter)); i++) {
+		uint32_t job_id = 0;
+		bool reject_job = false;
+
+		if (submit_msg->error_code[i])
+			continue;
+
+		err_msg = NULL;
+		error_code = SLURM_SUCCESS;
+		if (fed_mgr_fed_rec) {
+			if (fed_mgr_job_allocate(msg, job_desc_msg, false,
+						 &job_id, &error_code,
+						 &err_msg))
+				reject_job = true;
+		} else {
+			job_ptr = NULL;
+			error_code = job_allocate(job_desc_msg,
+						  job_desc_msg->immediate,
+						  false, NULL, 0,
+						  msg->auth_uid, false,
+						  &job_ptr, &err_msg,
+						  msg->protocol_version);
+			if (!job_ptr ||
+			    (error_code && job_ptr->job_state == JOB_FAILED))
+				reject_job = true;
+			else
+				job_id = job_ptr->job_id;
+
+			if (job_desc_msg->immediate &&
+			    (error_code != SLURM_SUCCESS)) {
+				error_code = ESLURM_CAN_NOT_START_IMMEDIATELY;
+				reject_job = true;
+			}
+		}
+
+		if (reject_job) {
+			if (error_code == SLURM_SUCCESS)
+				error_code = SLURM_ERROR;
+			/* Keep the job submit message ahead of the error */
+			if (err_msg) {
+				char *sep = submit_msg->job_submit_user_msg[i] ?
+					    "\n" : "";
+				xstrfmtcat(submit_msg->job_submit_user_msg[i],
+					   "%s%s", sep, err_msg);
+			}
+		} else {
+			submit_msg->job_id[i] = job_id;
+			submit_cnt++;
+		}
+		submit_msg->error_code[i] = error_code;
+		xfree(err_msg);
+	}
+	list_iterator_destroy(iter);
+	unlock_slurmctld(job_write_lock);
+	_throttle_fini(&active_rpc_cnt);
+
+	END_TIMER2("_slurm_rpc_submit_batch_job_list");
+	info("%s: submitted %u of %u jobs from uid=%u %s",
+	     __func__, submit_cnt, job_cnt, msg->auth_uid, TIME_STR);
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_SUBMIT_BATCH_JOB_LIST;
+	response_msg.data = submit_msg;
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	slurm_free_submit_response_list_msg(submit_msg);
+
+	if (submit_cnt) {
+		schedule_job_save();	/* Has own locks */
+		schedule_node_save();	/* Has own locks */
+		queue_job_scheduler();
+	}
+}
+
 /* _slurm_rpc_update_job - process RPC to update the configuration of a
  * job (e.g. priority)
  */
@@ -4229,7 +4600,6 @@ static void _slurm_rpc_update_node(slurm_msg_t * msg)
 
 	/* Below functions provide their own locks */
 	schedule_node_save();
-	validate_all_reservations(false);
 	queue_job_scheduler();
 	trigger_reconfig();
 }
@@ -5380,6 +5750,10 @@ static void _clear_rpc_stats(void)
 	memset(rpc_user_cnt, 0, sizeof(rpc_user_cnt));
 	memset(rpc_user_id, 0, sizeof(rpc_user_id));
 	memset(rpc_user_time, 0, sizeof(rpc_user_time));
+	memset(rpc_type_lat, 0, sizeof(rpc_type_lat));
+	rpc_delay_cnt = 0;
+	rpc_delay_max = 0;
+	rpc_delay_sum = 0;
 	slurm_mutex_unlock(&rpc_mutex);
 }
 
@@ -5413,7 +5787,11 @@ static void _pack_rpc_stats(int resp, char **buffer_ptr, int *buffer_size,
 		pack64_array(rpc_user_time, i, buffer);
 
 		agent_pack_pending_rpc_stats(buffer);
-
+		pack_lock_stats(buffer, protocol_version);
+		rpc_queue_pack_stats(buffer, protocol_version);
+		fed_mgr_pack_stats(buffer, protocol_version);
+		if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION)
+			_pack_rpc_latency(buffer);
 	}
 
 	slurm_mutex_unlock(&rpc_mutex);
@@ -5441,6 +5819,27 @@ static void _slurm_rpc_burst_buffer_status(slurm_msg_t *msg)
 	xfree(status_resp_msg.status_resp);
 }
 
+/* _slurm_rpc_dump_events - process RPC for job, node and reservation events */
+static void _slurm_rpc_dump_events(slurm_msg_t *msg)
+{
+	char *dump;
+	int dump_size;
+	slurm_msg_t response_msg;
+	event_info_request_msg_t *req_msg =
+		(event_info_request_msg_t *) msg->data;
+
+	event_mgr_pack(req_msg->seq, req_msg->wait, msg->auth_uid, &dump,
+		       &dump_size, msg->protocol_version);
+
+	response_init(&response_msg, msg);
+	response_msg.msg_type = RESPONSE_EVENT_INFO;
+	response_msg.data = dump;
+	response_msg.data_size = dump_size;
+
+	slurm_send_node_msg(msg->conn_fd, &response_msg);
+	xfree(dump);
+}
+
 /* _slurm_rpc_dump_stats - process RPC for statistics information */
 static void _slurm_rpc_dump_stats(slurm_msg_t *msg)
 {
@@ -5468,6 +5867,9 @@ static void _slurm_rpc_dump_stats(slurm_msg_t *msg)
 	if (request_msg->command_id == STAT_COMMAND_RESET) {
 		reset_stats(1);
 		_clear_rpc_stats();
+		reset_lock_stats();
+		rpc_queue_reset_stats();
+		fed_mgr_reset_stats();
 		pack_all_stat(0, &dump, &dump_size, msg->protocol_version);
 		_pack_rpc_stats(0, &dump, &dump_size, msg->protocol_version);
 		response_msg.data = dump;
@@ -6210,6 +6612,13 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = MESSAGE_EPILOG_COMPLETE,
 		.func = _slurm_rpc_epilog_complete,
+		.post_func = _epilog_complete_post,
+		.queue_enabled = true,
+		.locks = {
+			.conf = READ_LOCK,
+			.job = WRITE_LOCK,
+			.node = WRITE_LOCK,
+		},
 	},{
 		.msg_type = REQUEST_CANCEL_JOB_STEP,
 		.func = _slurm_rpc_job_step_kill,
@@ -6258,6 +6667,9 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = MESSAGE_NODE_REGISTRATION_STATUS,
 		.func = _slurm_rpc_node_registration,
+#ifndef HAVE_FRONT_END
+		.batch_func = purge_missing_jobs_deferred,
+#endif
 		.queue_enabled = true,
 		.locks = {
 			.conf = READ_LOCK,
@@ -6310,6 +6722,9 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_SUBMIT_BATCH_HET_JOB,
 		.func = _slurm_rpc_submit_batch_het_job,
+	},{
+		.msg_type = REQUEST_SUBMIT_BATCH_JOB_LIST,
+		.func = _slurm_rpc_submit_batch_job_list,
 	},{
 		.msg_type = REQUEST_UPDATE_FRONT_END,
 		.func = _slurm_rpc_update_front_end,
@@ -6442,6 +6857,12 @@ slurmctld_rpc_t slurmctld_rpcs[] =
 	},{
 		.msg_type = REQUEST_BURST_BUFFER_STATUS,
 		.func = _slurm_rpc_burst_buffer_status,
+	},{
+		.msg_type = REQUEST_EVENT_INFO,
+		.func = _slurm_rpc_dump_events,
+	},{
+		.msg_type = REQUEST_JOB_SCHED_TRACE,
+		.func = _slurm_rpc_job_sched_trace,
 	},{
 		.msg_type = REQUEST_CRONTAB,
 		.func = _slurm_rpc_request_crontab,
@@ -6505,9 +6926,16 @@ void slurmctld_req(slurm_msg_t *msg)
 	}
 
 	if (this_rpc) {
+		uint64_t lock_wait;
+
+		lock_stats_rpc_type(msg->msg_type);
+		SLURM_PROBE2(rpc__start, msg->msg_type, msg->auth_uid);
 		(*(this_rpc->func))(msg);
+		lock_wait = lock_stats_rpc_wait();
+		lock_stats_rpc_type(0);
 		END_TIMER;
-		record_rpc_stats(msg, DELTA_TIMER);
+		SLURM_PROBE2(rpc__done, msg->msg_type, DELTA_TIMER);
+		record_rpc_stats(msg, DELTA_TIMER, lock_wait);
 	} else {
 		error("invalid RPC msg_type=%u", msg->msg_type);
 		slurm_send_rc_msg(msg, EINVAL);
@@ -49,6 +49,8 @@ typedef struct {
 	uint16_t msg_type;
 	void (*func)(slurm_msg_t *msg);
 	slurmctld_lock_t locks;
+	void (*batch_func)(void); /* run after each queued batch, locks held */
+	void (*post_func)(void); /* run after each queued batch, no locks */
 
 	/* Queue structual elements */
 	char *msg_name; /* automatically derived from msg_type */
@@ -61,6 +63,14 @@ typedef struct {
 	pthread_mutex_t mutex;
 
 	List work;
+
+	/* Queue statistics, protected by mutex */
+	uint32_t batch_cnt;
+	uint32_t batch_max;
+	uint32_t depth_max;
+	uint32_t msg_cnt;
+	uint64_t wait_max;	/* usec from enqueue to processing */
+	uint64_t wait_sum;
 } slurmctld_rpc_t;
 
 extern slurmctld_rpc_t slurmctld_rpcs[];
@@ -73,8 +83,17 @@ void slurmctld_req(slurm_msg_t *msg);
 
 /*
  * Update slurmctld stats structure with time spent processing an rpc.
+ * IN msg - the RPC processed
+ * IN delta - total processing time in microseconds
+ * IN lock_wait - microseconds of delta spent waiting for slurmctld locks
+ */
+extern void record_rpc_stats(slurm_msg_t *msg, long delta, uint64_t lock_wait);
+
+/*
+ * Record the time in microseconds between a connection being accepted (or
+ * becoming readable again if kept alive) and its RPC starting processing.
  */
-extern void record_rpc_stats(slurm_msg_t *msg, long delta);
+extern void record_rpc_queue_delay(uint64_t delay);
 
 /*
  * Initialize a response slurm_msg_t to an inbound msg,
@@ -42,6 +42,7 @@
 
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -98,6 +99,7 @@
 List active_feature_list;	/* list of currently active features_records */
 List avail_feature_list;	/* list of available features_records */
 bool node_features_updated = true;
+uint32_t node_features_gen = 1;	/* 0 means job feature bitmaps unset */
 bool slurmctld_init_db = true;
 
 static void _acct_restore_active_jobs(void);
@@ -113,6 +115,7 @@ static int  _compare_hostnames(node_record_t *old_node_table,
 static void _gres_reconfig(bool reconfig);
 static void _init_all_slurm_conf(void);
 static void _list_delete_feature(void *feature_entry);
+static void _prefetch_state_files(void);
 static int _preserve_select_type_param(slurm_conf_t *ctl_conf_ptr,
                                        uint16_t old_select_type_p);
 static void _purge_old_node_state(node_record_t *old_node_table_ptr,
@@ -204,6 +207,33 @@ static void _stat_slurm_dirs(void)
 	}
 }
 
+/*
+ * Start reading all state files which are about to be recovered. The files
+ * must be unpacked one after another since each depends upon the records
+ * loaded before it, but the kernel can read them all concurrently in the
+ * background while slurm.conf is processed and the earlier files unpacked.
+ */
+static void _prefetch_state_files(void)
+{
+	static const char *state_files[] = {
+		"node_state", "front_end_state", "part_state", "job_state",
+		"job_state.journal", "resv_state", "trigger_state",
+		"fed_mgr_state", NULL
+	};
+	char *file_name = NULL;
+	int fd, i;
+
+	for (i = 0; state_files[i]; i++) {
+		xstrfmtcat(file_name, "%s/%s", slurm_conf.state_save_location,
+			   state_files[i]);
+		if ((fd = open(file_name, O_RDONLY | O_CLOEXEC)) >= 0) {
+			(void) posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+			close(fd);
+		}
+		xfree(file_name);
+	}
+}
+
 /*
  * _reorder_nodes_by_name - order node table in ascending order of name
  */
@@ -1092,6 +1122,9 @@ int read_slurm_conf(int recover, bool reconfig)
 	/* initialization */
 	START_TIMER;
 
+	if (!reconfig && recover)
+		_prefetch_state_files();
+
 	if (reconfig) {
 		/*
 		 * In order to re-use job state information,
@@ -1305,6 +1338,7 @@ int read_slurm_conf(int recover, bool reconfig)
 
 	_gres_reconfig(reconfig);
 	reset_job_bitmaps();		/* must follow select_g_job_init() */
+	sched_plan_set(NULL);		/* plan bitmaps follow the old nodes */
 
 	/*
 	 * The burst buffer plugin must be initialized and state loaded before
@@ -1587,6 +1621,7 @@ extern void build_feature_list_eq(void)
 	ListIterator feature_iter;
 	char *tmp_str, *token, *last = NULL;
 
+	node_features_gen++;
 	FREE_NULL_LIST(active_feature_list);
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
@@ -1656,6 +1691,7 @@ extern void build_feature_list_ne(void)
 	char *tmp_str, *token, *last = NULL;
 	int i;
 
+	node_features_gen++;
 	FREE_NULL_LIST(active_feature_list);
 	FREE_NULL_LIST(avail_feature_list);
 	active_feature_list = list_create(_list_delete_feature);
@@ -1704,6 +1740,7 @@ extern void update_feature_list(List feature_list, char *new_features,
 	ListIterator feature_iter;
 	char *tmp_str, *token, *last = NULL;
 
+	node_features_gen++;
 	/*
 	 * Clear these nodes from the feature_list record,
 	 * then restore as needed
@@ -72,12 +72,14 @@
 #include "src/common/xstring.h"
 
 #include "src/slurmctld/burst_buffer.h"
+#include "src/slurmctld/event_mgr.h"
 #include "src/slurmctld/groups.h"
 #include "src/slurmctld/job_scheduler.h"
 #include "src/slurmctld/licenses.h"
 #include "src/slurmctld/locks.h"
 #include "src/slurmctld/node_scheduler.h"
 #include "src/slurmctld/reservation.h"
+#include "src/slurmctld/sched_trace.h"
 #include "src/slurmctld/slurmctld.h"
 #include "src/slurmctld/state_save.h"
 
@@ -123,6 +125,11 @@ List      resv_list = (List) NULL;
 static List magnetic_resv_list = NULL;
 uint32_t  top_suffix = 0;
 
+/* Pending validate_all_reservations() and validate_node_reservations() */
+static pthread_mutex_t validate_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t validate_requests = 0;
+static bitstr_t *validate_node_bitmap = NULL;
+
 /*
  * the two following structs enable to build a
  * planning of a constraint evolution over time
@@ -138,6 +145,35 @@ typedef struct constraint_slot {
 	uint32_t value;
 } constraint_slot_t;
 
+/*
+ * Time index over resv_list, used by job_test_resv() and find_resv_end() to
+ * only visit the reservations whose time window can overlap a job's.
+ * Rebuilt lazily once _resv_index_stale() is called or a reservation ends.
+ */
+typedef struct resv_index_ent {
+	int pos;			/* position in resv_list */
+	slurmctld_resv_t *resv_ptr;
+	time_t start_time;		/* resv_ptr->start_time_first */
+	time_t end_time;		/* resv_ptr->end_time */
+} resv_index_ent_t;
+
+typedef struct resv_index {
+	int alloc_cnt;			/* size of the arrays below */
+	resv_index_ent_t *by_start;	/* fixed time reservations */
+	time_t *max_end;		/* running max of by_start end_time */
+	int start_cnt;
+	resv_index_ent_t *floating;	/* RESERVE_FLAG_TIME_FLOAT */
+	int float_cnt;
+	time_t *end_times;		/* end_time of all reservations */
+	int end_cnt;
+	resv_index_ent_t *hits;		/* _resv_index_query() results */
+	uint32_t max_boot_time;
+	time_t next_expire;		/* first by_start end_time after build */
+	bool valid;
+} resv_index_t;
+
+static resv_index_t resv_index = { 0 };
+
 /*
  * the associated functions are the following
  */
@@ -202,6 +238,7 @@ static int  _post_resv_update(slurmctld_resv_t *resv_ptr,
 static int  _resize_resv(slurmctld_resv_t *resv_ptr, uint32_t node_cnt);
 static void _restore_resv(slurmctld_resv_t *dest_resv,
 			  slurmctld_resv_t *src_resv);
+static void _resv_index_stale(void);
 static bool _resv_overlap(resv_desc_msg_t *resv_desc_ptr,
 			  bitstr_t *node_bitmap,
 			  slurmctld_resv_t *this_resv_ptr);
@@ -222,6 +259,7 @@ static int  _update_account_list(slurmctld_resv_t *resv_ptr,
 static int  _update_uid_list(slurmctld_resv_t *resv_ptr, char *users);
 static int _update_group_uid_list(slurmctld_resv_t *resv_ptr, char *groups);
 static void _validate_all_reservations(void);
+static void _validate_changed_reservations(bitstr_t *node_bitmap);
 static int  _valid_job_access_resv(job_record_t *job_ptr,
 				   slurmctld_resv_t *resv_ptr);
 static bool _validate_one_reservation(slurmctld_resv_t *resv_ptr);
@@ -231,6 +269,7 @@ static bool _validate_user_access(slurmctld_resv_t *resv_ptr,
 
 static void _set_boot_time(slurmctld_resv_t *resv_ptr)
 {
+	_resv_index_stale();
 	resv_ptr->boot_time = 0;
 	if (!resv_ptr->node_bitmap)
 		return;
@@ -462,6 +501,8 @@ static void _restore_resv(slurmctld_resv_t *dest_resv,
 
 	if (dest_resv->flags & RESERVE_FLAG_MAGNETIC)
 		list_append(magnetic_resv_list, dest_resv);
+
+	_resv_index_stale();
 }
 
 static void _del_resv_rec(void *x)
@@ -470,6 +511,7 @@ static void _del_resv_rec(void *x)
 	slurmctld_resv_t *resv_ptr = (slurmctld_resv_t *) x;
 
 	if (resv_ptr) {
+		_resv_index_stale();
 		/*
 		 * If shutting down magnetic_resv_list is already freed, meaning
 		 * we don't need to remove anything from it.
@@ -527,6 +569,7 @@ static void _add_resv_to_lists(slurmctld_resv_t *resv_ptr)
 	list_append(resv_list, resv_ptr);
 	if (resv_ptr->flags & RESERVE_FLAG_MAGNETIC)
 		list_append(magnetic_resv_list, resv_ptr);
+	_resv_index_stale();
 }
 
 static int _queue_magnetic_resv(void *x, void *key)
@@ -837,6 +880,7 @@ static int _set_assoc_list(slurmctld_resv_t *resv_ptr)
 	List assoc_list_allow = NULL, assoc_list_deny = NULL, assoc_list;
 	slurmdb_assoc_rec_t assoc, *assoc_ptr = NULL;
 	assoc_mgr_lock_t locks = { .assoc = READ_LOCK, .user = READ_LOCK };
+	char *assoc_pos = NULL;
 
 
 	/* no need to do this if we can't ;) */
@@ -961,11 +1005,11 @@ static int _set_assoc_list(slurmctld_resv_t *resv_ptr)
 		ListIterator itr = list_iterator_create(assoc_list_allow);
 		while ((assoc_ptr = list_next(itr))) {
 			if (resv_ptr->assoc_list) {
-				xstrfmtcat(resv_ptr->assoc_list, "%u,",
-					   assoc_ptr->id);
+				xstrfmtcatat(resv_ptr->assoc_list, &assoc_pos,
+					     "%u,", assoc_ptr->id);
 			} else {
-				xstrfmtcat(resv_ptr->assoc_list, ",%u,",
-					   assoc_ptr->id);
+				xstrfmtcatat(resv_ptr->assoc_list, &assoc_pos,
+					     ",%u,", assoc_ptr->id);
 			}
 		}
 		list_iterator_destroy(itr);
@@ -974,11 +1018,11 @@ static int _set_assoc_list(slurmctld_resv_t *resv_ptr)
 		ListIterator itr = list_iterator_create(assoc_list_deny);
 		while ((assoc_ptr = list_next(itr))) {
 			if (resv_ptr->assoc_list) {
-				xstrfmtcat(resv_ptr->assoc_list, "-%u,",
-					   assoc_ptr->id);
+				xstrfmtcatat(resv_ptr->assoc_list, &assoc_pos,
+					     "-%u,", assoc_ptr->id);
 			} else {
-				xstrfmtcat(resv_ptr->assoc_list, ",-%u,",
-					   assoc_ptr->id);
+				xstrfmtcatat(resv_ptr->assoc_list, &assoc_pos,
+					     ",-%u,", assoc_ptr->id);
 			}
 		}
 		list_iterator_destroy(itr);
@@ -1001,6 +1045,7 @@ static int _post_resv_create(slurmctld_resv_t *resv_ptr)
 	char temp_bit[BUF_SIZE];
 
 	_set_boot_time(resv_ptr);
+	event_mgr_resv(resv_ptr, EVENT_TYPE_RESV_CREATE);
 
 	if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT)
 		return rc;
@@ -1034,6 +1079,8 @@ static int _post_resv_delete(slurmctld_resv_t *resv_ptr)
 	slurmdb_reservation_rec_t resv;
 	time_t now = time(NULL);
 
+	event_mgr_resv(resv_ptr, EVENT_TYPE_RESV_DELETE);
+
 	if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT)
 		return rc;
 
@@ -1066,6 +1113,7 @@ static int _post_resv_update(slurmctld_resv_t *resv_ptr,
 	xassert(old_resv_ptr);
 
 	_set_boot_time(resv_ptr);
+	event_mgr_resv(resv_ptr, EVENT_TYPE_RESV_UPDATE);
 
 	if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT)
 		return rc;
@@ -1745,9 +1793,10 @@ static int _get_core_resrcs(slurmctld_resv_t *resv_ptr)
 		i_last = bit_fls(resv_ptr->core_resrcs->node_bitmap);
 	else
 		i_last = i_first - 1;
-	for (i = i_first, node_inx = -1; i <= i_last; i++) {
-		if (!bit_test(resv_ptr->core_resrcs->node_bitmap, i))
-			continue;
+	for (i = i_first, node_inx = -1;
+	     ((i = bit_ffs_from_bit(resv_ptr->core_resrcs->node_bitmap,
+				    i)) >= 0) &&
+	     (i <= i_last); i++) {
 		node_inx++;
 		core_offset_global = cr_get_coremap_offset(i);
 		core_end = cr_get_coremap_offset(i + 1);
@@ -1804,9 +1853,9 @@ static void _set_core_resrcs(slurmctld_resv_t *resv_ptr)
 	core_offset_local = -1;
 	node_inx = -1;
 	i_last = bit_fls(resv_ptr->node_bitmap);
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(resv_ptr->node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(resv_ptr->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		node_inx++;
 		core_offset_global = cr_get_coremap_offset(i);
 		core_end = cr_get_coremap_offset(i + 1);
@@ -2873,6 +2922,14 @@ extern void resv_fini(void)
 {
 	FREE_NULL_LIST(magnetic_resv_list);
 	FREE_NULL_LIST(resv_list);
+	FREE_NULL_BITMAP(validate_node_bitmap);
+
+	xfree(resv_index.by_start);
+	xfree(resv_index.max_end);
+	xfree(resv_index.floating);
+	xfree(resv_index.end_times);
+	xfree(resv_index.hits);
+	memset(&resv_index, 0, sizeof(resv_index));
 }
 
 /* Update an exiting resource reservation */
@@ -2906,6 +2963,7 @@ extern int update_resv(resv_desc_msg_t *resv_desc_ptr)
 
 	/* Make backup to restore state in case of failure */
 	resv_backup = _copy_resv(resv_ptr);
+	_resv_index_stale();
 
 	/* Process the request */
 	if (resv_desc_ptr->flags != NO_VAL64) {
@@ -3813,27 +3871,28 @@ static bool _validate_one_reservation(slurmctld_resv_t *resv_ptr)
 
 extern void validate_all_reservations(bool run_now)
 {
-	static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-	static uint32_t requests = 0;
+	bitstr_t *node_bitmap;
 	bool run;
 
 	if (!run_now) {
-		slurm_mutex_lock(&mutex);
-		requests++;
+		slurm_mutex_lock(&validate_mutex);
+		validate_requests++;
 		log_flag(RESERVATION, "%s: requests %u",
-			 __func__, requests);
-		xassert(requests != UINT32_MAX);
-		slurm_mutex_unlock(&mutex);
+			 __func__, validate_requests);
+		xassert(validate_requests != UINT32_MAX);
+		slurm_mutex_unlock(&validate_mutex);
 		return;
 	}
 
-	slurm_mutex_lock(&mutex);
-	run = (requests > 0);
+	slurm_mutex_lock(&validate_mutex);
+	run = (validate_requests > 0);
 	/* reset requests counter */
-	requests = 0;
-	slurm_mutex_unlock(&mutex);
+	validate_requests = 0;
+	node_bitmap = validate_node_bitmap;
+	validate_node_bitmap = NULL;
+	slurm_mutex_unlock(&validate_mutex);
 
-	if (run) {
+	if (run || node_bitmap) {
 		slurmctld_lock_t lock = {
 			.conf = READ_LOCK,
 			.job = WRITE_LOCK,
@@ -3841,9 +3900,61 @@ extern void validate_all_reservations(bool run_now)
 			.part = READ_LOCK,
 		};
 		lock_slurmctld(lock);
-		_validate_all_reservations();
+		/* node_record_count changes only on reconfigure */
+		if (run || (bit_size(node_bitmap) != node_record_count))
+			_validate_all_reservations();
+		else
+			_validate_changed_reservations(node_bitmap);
 		unlock_slurmctld(lock);
 	}
+	FREE_NULL_BITMAP(node_bitmap);
+}
+
+extern void validate_node_reservations(int node_inx)
+{
+	slurm_mutex_lock(&validate_mutex);
+	if (!validate_node_bitmap)
+		validate_node_bitmap = bit_alloc(node_record_count);
+	if (bit_size(validate_node_bitmap) != node_record_count)
+		validate_requests++;
+	else
+		bit_set(validate_node_bitmap, node_inx);
+	slurm_mutex_unlock(&validate_mutex);
+}
+
+/*
+ * Re-evaluate the node selection of reservations after node state changes.
+ * Reservation records themselves do not depend upon node state, so only
+ * _validate_node_choice() is needed and only for the reservations it would
+ * act upon: those using a changed node, those short of usable nodes and
+ * those replacing nodes.
+ */
+static void _validate_changed_reservations(bitstr_t *node_bitmap)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	int resv_cnt = 0;
+
+	xassert(verify_lock(NODE_LOCK, WRITE_LOCK));
+
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = list_next(iter))) {
+		if (!resv_ptr->node_bitmap)
+			continue;
+		if (!(resv_ptr->flags & RESERVE_FLAG_REPLACE) &&
+		    !(resv_ptr->flags & RESERVE_FLAG_REPLACE_DOWN) &&
+		    !bit_overlap_any(resv_ptr->node_bitmap, node_bitmap) &&
+		    (bit_overlap(resv_ptr->node_bitmap, avail_node_bitmap) ==
+		     resv_ptr->node_cnt))
+			continue;
+		_validate_node_choice(resv_ptr);
+		resv_cnt++;
+	}
+	list_iterator_destroy(iter);
+
+	log_flag(RESERVATION, "%s: validated %d of %d reservations for %d changed nodes",
+		 __func__, resv_cnt, list_count(resv_list),
+		 bit_set_count(node_bitmap));
 }
 
 /*
@@ -4809,6 +4920,8 @@ TRY_AVAIL:
 		if ((feat_ptr->paren == 1) ||	 /* Continue parenthesis */
 		    (feat_ptr->paren < paren)) { /* End of parenthesis */
 			paren = feat_ptr->paren;
+			/* Bitmaps no longer match the feature lists */
+			feat_ptr->node_features_gen = 0;
 			if (test_active) {
 				bit_and(feat_ptr->node_bitmap_active,
 					tmp_bitmap);
@@ -6049,6 +6162,174 @@ static void _get_rel_start_end(slurmctld_resv_t *resv_ptr, time_t now,
 	}
 }
 
+static void _resv_index_stale(void)
+{
+	resv_index.valid = false;
+}
+
+static int _cmp_resv_index_start(const void *x, const void *y)
+{
+	const resv_index_ent_t *ent1 = x, *ent2 = y;
+
+	if (ent1->start_time < ent2->start_time)
+		return -1;
+	if (ent1->start_time > ent2->start_time)
+		return 1;
+	return 0;
+}
+
+static int _cmp_resv_index_pos(const void *x, const void *y)
+{
+	const resv_index_ent_t *ent1 = x, *ent2 = y;
+
+	return (ent1->pos - ent2->pos);
+}
+
+static int _cmp_time(const void *x, const void *y)
+{
+	time_t t1 = *(const time_t *) x, t2 = *(const time_t *) y;
+
+	if (t1 < t2)
+		return -1;
+	if (t1 > t2)
+		return 1;
+	return 0;
+}
+
+/*
+ * Make sure resv_index reflects resv_list.
+ * IN advance - first advance recurring reservations which have ended, as
+ *	_get_rel_start_end() would, so their next instance gets indexed
+ */
+static void _resv_index_update(bool advance)
+{
+	ListIterator iter;
+	slurmctld_resv_t *resv_ptr;
+	resv_index_ent_t *ent;
+	time_t now = time(NULL);
+	int cnt, i, pos = 0;
+
+	if (resv_index.valid &&
+	    (!advance || (now < resv_index.next_expire)))
+		return;
+
+	if (advance) {
+		iter = list_iterator_create(resv_list);
+		while ((resv_ptr = list_next(iter))) {
+			if (!(resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) &&
+			    (resv_ptr->end_time <= now))
+				(void) _advance_resv_time(resv_ptr);
+		}
+		list_iterator_destroy(iter);
+	}
+
+	cnt = list_count(resv_list);
+	if (cnt > resv_index.alloc_cnt) {
+		resv_index.alloc_cnt = MAX(cnt, resv_index.alloc_cnt * 2);
+		xrecalloc(resv_index.by_start, resv_index.alloc_cnt,
+			  sizeof(resv_index_ent_t));
+		xrecalloc(resv_index.max_end, resv_index.alloc_cnt,
+			  sizeof(time_t));
+		xrecalloc(resv_index.floating, resv_index.alloc_cnt,
+			  sizeof(resv_index_ent_t));
+		xrecalloc(resv_index.end_times, resv_index.alloc_cnt,
+			  sizeof(time_t));
+		xrecalloc(resv_index.hits, resv_index.alloc_cnt,
+			  sizeof(resv_index_ent_t));
+	}
+
+	resv_index.start_cnt = 0;
+	resv_index.float_cnt = 0;
+	resv_index.end_cnt = 0;
+	resv_index.max_boot_time = 0;
+	resv_index.next_expire = (time_t) INFINITE;
+
+	iter = list_iterator_create(resv_list);
+	while ((resv_ptr = list_next(iter))) {
+		resv_index.end_times[resv_index.end_cnt++] = resv_ptr->end_time;
+		resv_index.max_boot_time = MAX(resv_index.max_boot_time,
+					       resv_ptr->boot_time);
+		if (resv_ptr->flags & RESERVE_FLAG_TIME_FLOAT) {
+			ent = &resv_index.floating[resv_index.float_cnt++];
+		} else {
+			ent = &resv_index.by_start[resv_index.start_cnt++];
+			if ((resv_ptr->end_time > now) &&
+			    (resv_ptr->end_time < resv_index.next_expire))
+				resv_index.next_expire = resv_ptr->end_time;
+		}
+		ent->pos = pos++;
+		ent->resv_ptr = resv_ptr;
+		ent->start_time = resv_ptr->start_time_first;
+		ent->end_time = resv_ptr->end_time;
+	}
+	list_iterator_destroy(iter);
+
+	qsort(resv_index.by_start, resv_index.start_cnt,
+	      sizeof(resv_index_ent_t), _cmp_resv_index_start);
+	qsort(resv_index.end_times, resv_index.end_cnt, sizeof(time_t),
+	      _cmp_time);
+	for (i = 0; i < resv_index.start_cnt; i++) {
+		resv_index.max_end[i] = resv_index.by_start[i].end_time;
+		if (i && (resv_index.max_end[i - 1] > resv_index.max_end[i]))
+			resv_index.max_end[i] = resv_index.max_end[i - 1];
+	}
+	resv_index.valid = true;
+}
+
+/*
+ * Find the reservations which may be active at some time in
+ * [start_time, end_time), allowing for any reservation's boot_time. The
+ * caller still needs to test each one, as floating reservations are always
+ * returned. Results are in resv_list order and remain valid until the next
+ * call.
+ * OUT hits - set to array of matching index entries
+ * RET count of entries in hits
+ */
+static int _resv_index_query(time_t start_time, time_t end_time,
+			     resv_index_ent_t **hits)
+{
+	int cnt = 0, i, lo, hi, mid;
+
+	_resv_index_update(true);
+	end_time += resv_index.max_boot_time;
+
+	/* First reservation starting at or after end_time */
+	lo = 0;
+	hi = resv_index.start_cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_index.by_start[mid].start_time < end_time)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	hi = lo;
+
+	/* First reservation with anything ending after start_time before it */
+	lo = 0;
+	i = hi;
+	while (lo < i) {
+		mid = (lo + i) / 2;
+		if (resv_index.max_end[mid] <= start_time)
+			lo = mid + 1;
+		else
+			i = mid;
+	}
+
+	for (i = lo; i < hi; i++) {
+		if (resv_index.by_start[i].end_time > start_time)
+			resv_index.hits[cnt++] = resv_index.by_start[i];
+	}
+	for (i = 0; i < resv_index.float_cnt; i++)
+		resv_index.hits[cnt++] = resv_index.floating[i];
+
+	qsort(resv_index.hits, cnt, sizeof(resv_index_ent_t),
+	      _cmp_resv_index_pos);
+	*hits = resv_index.hits;
+
+	return cnt;
+}
+
 /*
  * Determine how many watts the specified job is prevented from using
  * due to reservations
@@ -6138,17 +6419,17 @@ extern uint32_t job_test_watts_resv(job_record_t *job_ptr, time_t when,
  *	ESLURM_RESERVATION_MAINT job has no reservation, but required nodes are
  *				 in maintenance reservation
  */
-extern int job_test_resv(job_record_t *job_ptr, time_t *when,
-			 bool move_time, bitstr_t **node_bitmap,
-			 bitstr_t **exc_core_bitmap, bool *resv_overlap,
-			 bool reboot)
+static int _job_test_resv(job_record_t *job_ptr, time_t *when,
+			  bool move_time, bitstr_t **node_bitmap,
+			  bitstr_t **exc_core_bitmap, bool *resv_overlap,
+			  bool reboot)
 {
 	slurmctld_resv_t *resv_ptr = NULL, *res2_ptr;
 	time_t job_start_time, job_end_time, job_end_time_use, lic_resv_time;
 	time_t start_relative, end_relative;
 	time_t now = time(NULL);
-	ListIterator iter;
-	int i, rc = SLURM_SUCCESS, rc2;
+	resv_index_ent_t *hits;
+	int hit_cnt, i, j, rc = SLURM_SUCCESS, rc2;
 
 	*resv_overlap = false;	/* initialize to false */
 	job_start_time = *when;
@@ -6233,8 +6514,10 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 		 * if there are any overlapping reservations, we need to
 		 * prevent the job from using those nodes (e.g. MAINT nodes)
 		 */
-		iter = list_iterator_create(resv_list);
-		while ((res2_ptr = list_next(iter))) {
+		hit_cnt = _resv_index_query(job_start_time, job_end_time,
+					    &hits);
+		for (j = 0; j < hit_cnt; j++) {
+			res2_ptr = hits[j].resv_ptr;
 			if (reboot)
 				job_end_time_use =
 					job_end_time + res2_ptr->boot_time;
@@ -6264,7 +6547,6 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 				bit_and_not(*node_bitmap,res2_ptr->node_bitmap);
 			}
 		}
-		list_iterator_destroy(iter);
 
 		if (slurm_conf.debug_flags & DEBUG_FLAG_RESERVATION) {
 			char *nodes = bitmap2node_name(*node_bitmap);
@@ -6299,8 +6581,10 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 	for (i = 0; ; i++) {
 		lic_resv_time = (time_t) 0;
 
-		iter = list_iterator_create(resv_list);
-		while ((resv_ptr = list_next(iter))) {
+		hit_cnt = _resv_index_query(job_start_time, job_end_time,
+					    &hits);
+		for (j = 0; j < hit_cnt; j++) {
+			resv_ptr = hits[j].resv_ptr;
 			_get_rel_start_end(
 				resv_ptr, now, &start_relative, &end_relative);
 
@@ -6389,7 +6673,6 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 				continue;
 			}
 		}
-		list_iterator_destroy(iter);
 
 		if ((rc == SLURM_SUCCESS) && move_time) {
 			if (license_job_test(job_ptr, job_start_time, reboot)
@@ -6424,6 +6707,22 @@ extern int job_test_resv(job_record_t *job_ptr, time_t *when,
 	return rc;
 }
 
+/* Time reservation checks of the scheduling attempt in progress */
+extern int job_test_resv(job_record_t *job_ptr, time_t *when,
+			 bool move_time, bitstr_t **node_bitmap,
+			 bitstr_t **exc_core_bitmap, bool *resv_overlap,
+			 bool reboot)
+{
+	uint64_t start = sched_trace_phase_start();
+	int rc;
+
+	rc = _job_test_resv(job_ptr, when, move_time, node_bitmap,
+			    exc_core_bitmap, resv_overlap, reboot);
+	sched_trace_phase_end(SCHED_TRACE_RESV, start);
+
+	return rc;
+}
+
 static int _update_resv_group_uid_access_list(void *x, void *arg)
 {
 	slurmctld_resv_t *resv_ptr = (slurmctld_resv_t *)x;
@@ -6479,21 +6778,26 @@ static int _update_resv_group_uid_access_list(void *x, void *arg)
  */
 extern time_t find_resv_end(time_t start_time, int resolution)
 {
-	ListIterator iter;
-	slurmctld_resv_t *resv_ptr;
 	time_t end_time = 0;
+	int lo, hi, mid;
 
 	if (!resv_list)
 		return end_time;
 
-	iter = list_iterator_create(resv_list);
-	while ((resv_ptr = list_next(iter))) {
-		if (start_time > resv_ptr->end_time)
-			continue;
-		if ((end_time == 0) || (resv_ptr->end_time < end_time))
-			end_time = resv_ptr->end_time;
+	_resv_index_update(false);
+
+	/* First reservation ending at or after start_time */
+	lo = 0;
+	hi = resv_index.end_cnt;
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (resv_index.end_times[mid] < start_time)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
-	list_iterator_destroy(iter);
+	if (lo < resv_index.end_cnt)
+		end_time = resv_index.end_times[lo];
 
 	/* Round-up returned time to given resolution */
 	if (resolution > 0) {
@@ -6643,6 +6947,7 @@ static int _advance_resv_time(slurmctld_resv_t *resv_ptr)
 		resv_ptr->start_time_prev = resv_ptr->start_time;
 		resv_ptr->start_time_first = resv_ptr->start_time;
 		_advance_time(&resv_ptr->end_time, day_cnt);
+		_resv_index_stale();
 		resv_ptr->ctld_flags &= (~RESV_CTLD_PROLOG);
 		resv_ptr->ctld_flags &= (~RESV_CTLD_EPILOG);
 		_post_resv_create(resv_ptr);
@@ -7096,9 +7401,9 @@ static void _set_nodes_flags(slurmctld_resv_t *resv_ptr, time_t now,
 		return;
 	}
 	i_last  = bit_fls(resv_ptr->node_bitmap);
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(resv_ptr->node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(resv_ptr->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 
 		node_ptr = node_record_table_ptr + i;
 		old_state = node_ptr->node_state;
@@ -114,6 +114,18 @@ extern int load_all_resv_state(int recover);
  */
 extern void validate_all_reservations(bool run_now);
 
+/*
+ * Request validation of the node selection of reservations using nodes
+ * whose state changed. Deferred like validate_all_reservations(false), but
+ * when only node changes are pending the next validate_all_reservations(true)
+ * re-evaluates just the reservations using these nodes, plus any which still
+ * need replacement nodes, instead of revalidating every reservation and job.
+ *
+ * IN node_inx - index of the changed node in node_record_table_ptr
+ * NOTE: READ lock_slurmctld node before entry
+ */
+extern void validate_node_reservations(int node_inx);
+
 /*
  * Determine if a job request can use the specified reservations
  *
@@ -0,0 +1,171 @@
+/*****************************************************************************\
+ *  rpc_capture.c - record received RPCs for later replay
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "src/common/log.h"
+#include "src/common/macros.h"
+#include "src/common/pack.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/rpc_capture.h"
+
+#define CAPTURE_BUF_SIZE (1024 * 1024)
+
+static pthread_mutex_t capture_lock = PTHREAD_MUTEX_INITIALIZER;
+static FILE *capture_fp = NULL;
+static char *capture_buf = NULL;
+static struct timeval capture_start;
+static time_t last_flush = 0;
+
+/* Users are recorded by the order they were first seen in */
+static uid_t *user_uids = NULL;
+static int user_cnt = 0;
+
+static int _anon_user(uid_t uid)
+{
+	int i;
+
+	/* Keep privileged requests apart, as they take different paths */
+	if ((uid == 0) || (uid == slurm_conf.slurm_user_id))
+		return 0;
+
+	for (i = 0; i < user_cnt; i++) {
+		if (user_uids[i] == uid)
+			return i + 1;
+	}
+	if (!(user_cnt % 64))
+		xrecalloc(user_uids, user_cnt + 64, sizeof(uid_t));
+	user_uids[user_cnt++] = uid;
+
+	return user_cnt;
+}
+
+extern void rpc_capture_init(void)
+{
+	char *tmp_ptr, *path, *sep;
+	int fd;
+
+	if (!(tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				    "rpc_capture=")))
+		return;
+
+	path = xstrdup(tmp_ptr + strlen("rpc_capture="));
+	if ((sep = strchr(path, ',')))
+		*sep = '\0';
+
+	slurm_mutex_lock(&capture_lock);
+	if (capture_fp) {
+		slurm_mutex_unlock(&capture_lock);
+		xfree(path);
+		return;
+	}
+
+	if (((fd = open(path, O_CREAT | O_WRONLY | O_TRUNC | O_CLOEXEC,
+			0600)) < 0) ||
+	    !(capture_fp = fdopen(fd, "w"))) {
+		error("%s: unable to open %s: %m", __func__, path);
+		if (fd >= 0)
+			close(fd);
+		slurm_mutex_unlock(&capture_lock);
+		xfree(path);
+		return;
+	}
+	capture_buf = xmalloc(CAPTURE_BUF_SIZE);
+	setvbuf(capture_fp, capture_buf, _IOFBF, CAPTURE_BUF_SIZE);
+
+	gettimeofday(&capture_start, NULL);
+	fprintf(capture_fp,
+		"# slurmctld RPC capture version 1, started %ld\n"
+		"# usec_offset msg_type body_bytes user msg_name\n",
+		(long) capture_start.tv_sec);
+	slurm_mutex_unlock(&capture_lock);
+
+	info("Recording received RPCs to %s", path);
+	xfree(path);
+}
+
+extern void rpc_capture_fini(void)
+{
+	slurm_mutex_lock(&capture_lock);
+	if (capture_fp) {
+		fclose(capture_fp);
+		capture_fp = NULL;
+	}
+	xfree(capture_buf);
+	xfree(user_uids);
+	user_cnt = 0;
+	slurm_mutex_unlock(&capture_lock);
+}
+
+extern void rpc_capture_record(slurm_msg_t *msg, struct timeval *recv_time)
+{
+	uint32_t body_bytes = 0;
+	int64_t offset;
+
+	/* Unlocked test, capture is enabled once before RPCs are accepted */
+	if (!capture_fp)
+		return;
+
+	if (msg->buffer && (size_buf(msg->buffer) > msg->body_offset))
+		body_bytes = size_buf(msg->buffer) - msg->body_offset;
+	offset = ((int64_t) (recv_time->tv_sec - capture_start.tv_sec) *
+		  USEC_IN_SEC) + (recv_time->tv_usec - capture_start.tv_usec);
+
+	slurm_mutex_lock(&capture_lock);
+	if (capture_fp) {
+		fprintf(capture_fp, "%"PRId64" %u %u %d %s\n",
+			offset, msg->msg_type, body_bytes,
+			_anon_user(msg->auth_uid),
+			rpc_num2string(msg->msg_type));
+		/* Keep the file usable while slurmctld is still running */
+		if (recv_time->tv_sec != last_flush) {
+			fflush(capture_fp);
+			last_flush = recv_time->tv_sec;
+		}
+	}
+	slurm_mutex_unlock(&capture_lock);
+}
@@ -0,0 +1,60 @@
+/*****************************************************************************\
+ *  rpc_capture.h - record received RPCs for later replay
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+
+#ifndef _RPC_CAPTURE_H_
+#define _RPC_CAPTURE_H_
+
+#include <sys/time.h>
+
+#include "src/common/slurm_protocol_defs.h"
+
+/*
+ * Start recording received RPCs to the file named by the rpc_capture=
+ * option of SlurmctldParameters, if set.
+ */
+extern void rpc_capture_init(void);
+
+extern void rpc_capture_fini(void);
+
+/*
+ * Record the arrival of one RPC: its time, type, body size and an
+ * anonymized user. No message content is recorded.
+ * IN msg - received message, with the buffer it was unpacked from if kept
+ * IN recv_time - when the message was received
+ */
+extern void rpc_capture_record(slurm_msg_t *msg, struct timeval *recv_time);
+
+#endif
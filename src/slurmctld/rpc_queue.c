@@ -44,6 +44,7 @@
 
 #include "src/common/list.h"
 #include "src/common/macros.h"
+#include "src/common/probes.h"
 #include "src/common/read_config.h"
 #include "src/common/slurm_protocol_defs.h"
 #include "src/common/xmalloc.h"
@@ -54,13 +55,35 @@
 #include "src/slurmctld/proc_req.h"
 #include "src/slurmctld/state_save.h"
 
+#define RPC_QUEUE_BATCH_DEFAULT 256
+
+typedef struct {
+	slurm_msg_t *msg;
+	struct timeval enqueue_time;
+} rpc_queue_work_t;
+
 bool enabled = true;
+static int batch_size = RPC_QUEUE_BATCH_DEFAULT;
+
+static void _free_work(void *x)
+{
+	rpc_queue_work_t *work = x;
+
+	if ((work->msg->conn_fd >= 0) && (close(work->msg->conn_fd) < 0))
+		error("close(%d): %m", work->msg->conn_fd);
+	slurm_free_msg(work->msg);
+	xfree(work);
+}
 
 static void *_rpc_queue_worker(void *arg)
 {
 	slurmctld_rpc_t *q = (slurmctld_rpc_t *) arg;
+	rpc_queue_work_t *work;
 	slurm_msg_t *msg;
-	int processed = 0;
+	struct timeval now;
+	uint64_t wait, wait_max, wait_sum;
+	int processed;
+	List batch = list_create(_free_work);
 
 #if HAVE_SYS_PRCTL_H
 	char *name = xstrdup_printf("rpcq-%u", q->msg_type);
@@ -70,87 +93,173 @@ static void *_rpc_queue_worker(void *arg)
 	xfree(name);
 #endif
 
-	/*
-	 * Acquire on init to simplify the inner loop.
-	 * On rpc_queue_init() this will proceed directly to slurm_cond_wait().
-	 */
-	lock_slurmctld(q->locks);
+	lock_stats_rpc_type(q->msg_type);
 
 	/*
-	 * Process as many queued messages as possible in one slurmctld_lock()
-	 * acquisition, then fall back to sleep until additional work is queued.
+	 * Process the messages queued when the locks are granted as one batch
+	 * under a single slurmctld_lock() acquisition, then fall back to
+	 * sleep until additional work is queued.
 	 */
 	while (true) {
-		msg = list_dequeue(q->work);
-
-		if (!msg) {
-			unlock_slurmctld(q->locks);
-
-			log_flag(PROTOCOL, "%s(%s): sleeping after processing %d",
-				 __func__, q->msg_name, processed);
-			processed = 0;
-
-			/*
-			 * Rate limit RPC processing. Ensure that when we
-			 * stop processing we don't immediately start again
-			 * by inserting a slight delay.
-			 *
-			 * This encourages additional RPCs to accumulate,
-			 * which is desirable as it lowers pressure on the
-			 * slurmctld locks.
-			 *
-			 * This extends the race described below, but this
-			 * is handled properly.
-			 */
-			usleep(500);
-
-			slurm_mutex_lock(&q->mutex);
-
+		slurm_mutex_lock(&q->mutex);
+		/*
+		 * list_enqueue() is called without the mutex held, always
+		 * check the list before waiting.
+		 */
+		while (!list_count(q->work)) {
 			if (q->shutdown) {
 				log_flag(PROTOCOL, "%s(%s): shutting down",
 					 __func__, q->msg_name);
 				slurm_mutex_unlock(&q->mutex);
+				FREE_NULL_LIST(batch);
 				return NULL;
 			}
-
-			/*
-			 * Verify list is empty. Since list_dequeue() above is
-			 * called without the mutex held, there is a race with
-			 * rpc_enqueue() that this check will solve.
-			 */
-			if (!list_count(q->work))
-				slurm_cond_wait(&q->cond, &q->mutex);
-
-			slurm_mutex_unlock(&q->mutex);
+			slurm_cond_wait(&q->cond, &q->mutex);
 			log_flag(PROTOCOL, "%s(%s): woke up",
 				 __func__, q->msg_name);
-			lock_slurmctld(q->locks);
-		} else {
+		}
+		slurm_mutex_unlock(&q->mutex);
+
+		lock_slurmctld(q->locks);
+
+		/*
+		 * Messages arriving while the batch is processed wait for the
+		 * next batch so other threads get a turn at the locks. The
+		 * batch is taken off the queue at once so producers contend
+		 * for the queue's list lock only once per batch.
+		 */
+		(void) list_transfer_max(batch, q->work, batch_size);
+		wait_max = wait_sum = 0;
+		for (processed = 0; (work = list_dequeue(batch)); processed++) {
 			DEF_TIMERS;
-			START_TIMER;
 
+			msg = work->msg;
+
+			gettimeofday(&now, NULL);
+			wait = ((now.tv_sec - work->enqueue_time.tv_sec) *
+				USEC_IN_SEC) +
+			       (now.tv_usec - work->enqueue_time.tv_usec);
+			wait_sum += wait;
+			wait_max = MAX(wait_max, wait);
+
+			START_TIMER;
 			msg->flags |= CTLD_QUEUE_PROCESSING;
+			SLURM_PROBE2(rpc__start, msg->msg_type, msg->auth_uid);
 			q->func(msg);
 			if ((msg->conn_fd >= 0) && (close(msg->conn_fd) < 0))
 				error("close(%d): %m", msg->conn_fd);
 
 			END_TIMER;
-			record_rpc_stats(msg, DELTA_TIMER);
+			SLURM_PROBE2(rpc__done, msg->msg_type, DELTA_TIMER);
+			record_rpc_stats(msg, DELTA_TIMER,
+					 lock_stats_rpc_wait());
 			slurm_free_msg(msg);
-			processed++;
+			xfree(work);
 		}
+
+		if (q->batch_func)
+			q->batch_func();
+
+		unlock_slurmctld(q->locks);
+
+		if (q->post_func)
+			q->post_func();
+
+		slurm_mutex_lock(&q->mutex);
+		q->batch_cnt++;
+		q->batch_max = MAX(q->batch_max, processed);
+		q->msg_cnt += processed;
+		q->wait_max = MAX(q->wait_max, wait_max);
+		q->wait_sum += wait_sum;
+		slurm_mutex_unlock(&q->mutex);
+
+		log_flag(PROTOCOL, "%s(%s): processed batch of %d",
+			 __func__, q->msg_name, processed);
+
+		/*
+		 * Rate limit RPC processing. Ensure that when we stop
+		 * processing we don't immediately start again by inserting a
+		 * slight delay.
+		 *
+		 * This encourages additional RPCs to accumulate, which is
+		 * desirable as it lowers pressure on the slurmctld locks.
+		 */
+		usleep(500);
 	}
 
 	return NULL;
 }
 
+/*
+ * Restrict queuing to the message types named by
+ * SlurmctldParameters=rpc_queue_types=<name>[:<name>...]
+ */
+static void _set_queue_types(char *types)
+{
+	char *tmp_str, *end, *tok, *save_ptr = NULL;
+	uint16_t *msg_types = NULL;
+	int i, type_cnt = 0;
+	slurmctld_rpc_t *q;
+
+	tmp_str = xstrdup(types);
+	if ((end = strchr(tmp_str, ',')))
+		end[0] = '\0';
+
+	tok = strtok_r(tmp_str, ":", &save_ptr);
+	while (tok) {
+		for (q = slurmctld_rpcs; q->msg_type; q++) {
+			if (!xstrcasecmp(tok, rpc_num2string(q->msg_type)))
+				break;
+		}
+		if (!q->msg_type) {
+			error("SlurmctldParameters=rpc_queue_types: unknown message type %s",
+			      tok);
+		} else if (!q->queue_enabled) {
+			error("SlurmctldParameters=rpc_queue_types: %s can not be queued",
+			      tok);
+		} else {
+			xrecalloc(msg_types, type_cnt + 1, sizeof(uint16_t));
+			msg_types[type_cnt++] = q->msg_type;
+		}
+		tok = strtok_r(NULL, ":", &save_ptr);
+	}
+	xfree(tmp_str);
+
+	for (q = slurmctld_rpcs; q->msg_type; q++) {
+		if (!q->queue_enabled)
+			continue;
+		for (i = 0; i < type_cnt; i++) {
+			if (msg_types[i] == q->msg_type)
+				break;
+		}
+		if (i >= type_cnt)
+			q->queue_enabled = false;
+	}
+	xfree(msg_types);
+}
+
 extern void rpc_queue_init(void)
 {
-	if (!xstrcasestr(slurm_conf.slurmctld_params, "enable_rpc_queue")) {
+	char *tmp_ptr;
+
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "rpc_queue_types=")))
+		_set_queue_types(tmp_ptr + strlen("rpc_queue_types="));
+	else if (!xstrcasestr(slurm_conf.slurmctld_params, "enable_rpc_queue")) {
 		enabled = false;
 		return;
 	}
 
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "rpc_queue_batch_size="))) {
+		batch_size = atoi(tmp_ptr + strlen("rpc_queue_batch_size="));
+		if (batch_size < 0) {
+			error("Invalid SlurmctldParameters rpc_queue_batch_size, using default of %d",
+			      RPC_QUEUE_BATCH_DEFAULT);
+			batch_size = RPC_QUEUE_BATCH_DEFAULT;
+		}
+	}
+
 	error("enabled experimental rpc queuing system");
 
 	for (slurmctld_rpc_t *q = slurmctld_rpcs; q->msg_type; q++) {
@@ -158,7 +267,7 @@ extern void rpc_queue_init(void)
 			continue;
 
 		q->msg_name = rpc_num2string(q->msg_type);
-		q->work = list_create(NULL);
+		q->work = list_create(_free_work);
 		slurm_cond_init(&q->cond, NULL);
 		slurm_mutex_init(&q->mutex);
 		q->shutdown = false;
@@ -199,6 +308,9 @@ extern void rpc_queue_shutdown(void)
 
 extern bool rpc_enqueue(slurm_msg_t *msg)
 {
+	rpc_queue_work_t *work;
+	uint32_t depth;
+
 	if (!enabled)
 		return false;
 
@@ -207,8 +319,14 @@ extern bool rpc_enqueue(slurm_msg_t *msg)
 			if (!q->queue_enabled)
 				break;
 
-			list_enqueue(q->work, msg);
+			work = xmalloc(sizeof(*work));
+			work->msg = msg;
+			gettimeofday(&work->enqueue_time, NULL);
+
+			list_enqueue(q->work, work);
+			depth = list_count(q->work);
 			slurm_mutex_lock(&q->mutex);
+			q->depth_max = MAX(q->depth_max, depth);
 			slurm_cond_signal(&q->cond);
 			slurm_mutex_unlock(&q->mutex);
 			return true;
@@ -218,3 +336,54 @@ extern bool rpc_enqueue(slurm_msg_t *msg)
 	/* RPC does not have a dedicated queue */
 	return false;
 }
+
+extern void rpc_queue_pack_stats(buf_t *buffer, uint16_t protocol_version)
+{
+	uint32_t cnt = 0;
+
+	if (enabled) {
+		for (slurmctld_rpc_t *q = slurmctld_rpcs; q->msg_type; q++) {
+			if (q->queue_enabled)
+				cnt++;
+		}
+	}
+	pack32(cnt, buffer);
+	if (!cnt)
+		return;
+
+	for (slurmctld_rpc_t *q = slurmctld_rpcs; q->msg_type; q++) {
+		if (!q->queue_enabled)
+			continue;
+
+		pack16(q->msg_type, buffer);
+		pack32(list_count(q->work), buffer);
+		slurm_mutex_lock(&q->mutex);
+		pack32(q->depth_max, buffer);
+		pack32(q->msg_cnt, buffer);
+		pack32(q->batch_cnt, buffer);
+		pack32(q->batch_max, buffer);
+		pack64(q->wait_sum, buffer);
+		pack64(q->wait_max, buffer);
+		slurm_mutex_unlock(&q->mutex);
+	}
+}
+
+extern void rpc_queue_reset_stats(void)
+{
+	if (!enabled)
+		return;
+
+	for (slurmctld_rpc_t *q = slurmctld_rpcs; q->msg_type; q++) {
+		if (!q->queue_enabled)
+			continue;
+
+		slurm_mutex_lock(&q->mutex);
+		q->batch_cnt = 0;
+		q->batch_max = 0;
+		q->depth_max = 0;
+		q->msg_cnt = 0;
+		q->wait_max = 0;
+		q->wait_sum = 0;
+		slurm_mutex_unlock(&q->mutex);
+	}
+}
@@ -37,10 +37,18 @@
 #ifndef _RPC_QUEUE_H_
 #define _RPC_QUEUE_H_
 
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_defs.h"
+
 extern void rpc_queue_init(void);
 
 extern void rpc_queue_shutdown(void);
 
 extern bool rpc_enqueue(slurm_msg_t *msg);
 
+/* Pack per queue depth, batch and latency statistics for sdiag */
+extern void rpc_queue_pack_stats(buf_t *buffer, uint16_t protocol_version);
+
+extern void rpc_queue_reset_stats(void);
+
 #endif
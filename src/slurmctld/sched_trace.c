@@ -0,0 +1,245 @@
+/*****************************************************************************\
+ *  sched_trace.c - recent scheduling attempts of each job
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "src/common/assoc_mgr.h"
+#include "src/common/read_config.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include "src/slurmctld/sched_trace.h"
+
+#define SCHED_TRACE_DEPTH_DEFAULT	4
+#define SCHED_TRACE_DEPTH_MAX		64
+
+/* Ring of the most recent attempts, allocated on a job's first attempt */
+struct sched_trace_ring {
+	uint32_t attempts;	/* attempts recorded since job submission */
+	uint16_t count;		/* records used in rec[] */
+	uint16_t depth;		/* records in rec[] */
+	uint16_t next;		/* rec[] index of the next attempt */
+	uint64_t total_usec;	/* scheduler time of all attempts */
+	sched_trace_rec_t rec[];
+};
+
+/*
+ * The attempt in progress. Both schedulers hold the job write lock for the
+ * whole attempt, which serializes them.
+ */
+static struct {
+	job_record_t *job_ptr;	/* NULL if no attempt is in progress */
+	sched_trace_rec_t rec;
+	uint64_t select_nested;	/* acct and resv usec at select start */
+	uint64_t select_start;
+	uint64_t start;
+} attempt;
+
+static uint16_t trace_depth = SCHED_TRACE_DEPTH_DEFAULT;
+static time_t trace_conf_update = 0;
+
+static uint64_t _now_usec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ((uint64_t) ts.tv_sec * USEC_IN_SEC) + (ts.tv_nsec / 1000);
+}
+
+/*
+ * Parse SlurmctldParameters=sched_trace_depth=#
+ * NOTE: Call with a read lock on the slurmctld configuration
+ */
+static void _parse_depth(void)
+{
+	char *tmp_ptr;
+	long depth;
+
+	if (trace_conf_update == slurm_conf.last_update)
+		return;
+	trace_conf_update = slurm_conf.last_update;
+
+	trace_depth = SCHED_TRACE_DEPTH_DEFAULT;
+	if ((tmp_ptr = xstrcasestr(slurm_conf.slurmctld_params,
+				   "sched_trace_depth="))) {
+		depth = strtol(tmp_ptr + strlen("sched_trace_depth="),
+			       NULL, 10);
+		if ((depth < 0) || (depth > SCHED_TRACE_DEPTH_MAX)) {
+			error("Invalid SlurmctldParameters sched_trace_depth=%ld, using %d",
+			      depth, SCHED_TRACE_DEPTH_DEFAULT);
+		} else
+			trace_depth = depth;
+	}
+}
+
+extern void sched_trace_begin(job_record_t *job_ptr, uint16_t scheduler)
+{
+	sched_trace_end();
+	_parse_depth();
+
+	memset(&attempt, 0, sizeof(attempt));
+	if (!trace_depth)
+		return;
+
+	attempt.job_ptr = job_ptr;
+	attempt.rec.scheduler = scheduler;
+	attempt.start = _now_usec();
+}
+
+extern void sched_trace_end(void)
+{
+	job_record_t *job_ptr = attempt.job_ptr;
+	struct sched_trace_ring *ring;
+
+	if (!job_ptr)
+		return;
+	attempt.job_ptr = NULL;
+
+	ring = job_ptr->sched_trace;
+	if (!ring || (ring->depth != trace_depth)) {
+		struct sched_trace_ring *old = ring;
+
+		ring = xmalloc(sizeof(*ring) +
+			       (trace_depth * sizeof(sched_trace_rec_t)));
+		ring->depth = trace_depth;
+		if (old) {
+			/* Depth changed by reconfigure, keep the totals */
+			ring->attempts = old->attempts;
+			ring->total_usec = old->total_usec;
+			xfree(old);
+		}
+		job_ptr->sched_trace = ring;
+	}
+
+	attempt.rec.time = time(NULL);
+	attempt.rec.reason = job_ptr->state_reason;
+	attempt.rec.total_usec = _now_usec() - attempt.start;
+
+	ring->rec[ring->next] = attempt.rec;
+	ring->next = (ring->next + 1) % ring->depth;
+	if (ring->count < ring->depth)
+		ring->count++;
+	ring->attempts++;
+	ring->total_usec += attempt.rec.total_usec;
+}
+
+extern uint64_t sched_trace_phase_start(void)
+{
+	if (!attempt.job_ptr)
+		return 0;
+	return _now_usec();
+}
+
+extern void sched_trace_phase_end(sched_trace_phase_t phase, uint64_t start)
+{
+	uint32_t usec;
+
+	if (!start || !attempt.job_ptr)
+		return;
+
+	usec = _now_usec() - start;
+	if (phase == SCHED_TRACE_ACCT)
+		attempt.rec.acct_usec += usec;
+	else
+		attempt.rec.resv_usec += usec;
+}
+
+extern void sched_trace_select_start(void)
+{
+	if (!attempt.job_ptr)
+		return;
+
+	attempt.select_nested = attempt.rec.acct_usec + attempt.rec.resv_usec;
+	attempt.select_start = _now_usec();
+}
+
+extern void sched_trace_select_end(int rc)
+{
+	uint64_t nested;
+
+	if (!attempt.job_ptr || !attempt.select_start)
+		return;
+
+	nested = attempt.rec.acct_usec + attempt.rec.resv_usec -
+		 attempt.select_nested;
+	attempt.rec.select_usec += _now_usec() - attempt.select_start - nested;
+	attempt.rec.error_code = rc;
+	attempt.select_start = 0;
+}
+
+extern void sched_trace_free(job_record_t *job_ptr)
+{
+	if (attempt.job_ptr == job_ptr)
+		attempt.job_ptr = NULL;
+	xfree(job_ptr->sched_trace);
+}
+
+extern int sched_trace_get(uint32_t job_id, uid_t uid,
+			   sched_trace_msg_t *resp)
+{
+	job_record_t *job_ptr = find_job_record(job_id);
+	struct sched_trace_ring *ring;
+	int i, inx;
+
+	memset(resp, 0, sizeof(*resp));
+	if (!job_ptr)
+		return ESLURM_INVALID_JOB_ID;
+
+	if ((slurm_conf.private_data & PRIVATE_DATA_JOBS) &&
+	    (job_ptr->user_id != uid) && !validate_operator(uid) &&
+	    !assoc_mgr_is_user_acct_coord(acct_db_conn, uid,
+					  job_ptr->account))
+		return ESLURM_ACCESS_DENIED;
+
+	resp->job_id = job_ptr->job_id;
+	if (!(ring = job_ptr->sched_trace))
+		return SLURM_SUCCESS;
+
+	resp->attempts = ring->attempts;
+	resp->total_usec = ring->total_usec;
+	resp->record_count = ring->count;
+	resp->trace_array = xcalloc(resp->record_count,
+				    sizeof(sched_trace_rec_t));
+	for (i = 0, inx = ring->next; i < resp->record_count; i++) {
+		inx = (inx + ring->depth - 1) % ring->depth;
+		resp->trace_array[i] = ring->rec[inx];
+	}
+
+	return SLURM_SUCCESS;
+}
@@ -0,0 +1,89 @@
+/*****************************************************************************\
+ *  sched_trace.h - recent scheduling attempts of each job
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+#ifndef _HAVE_SCHED_TRACE_H
+#define _HAVE_SCHED_TRACE_H
+
+#include "src/slurmctld/slurmctld.h"
+
+/* Scheduling phases timed within an attempt */
+typedef enum {
+	SCHED_TRACE_ACCT,	/* accounting policy checks */
+	SCHED_TRACE_RESV,	/* reservation checks */
+} sched_trace_phase_t;
+
+/*
+ * Start recording a scheduling attempt of job_ptr by scheduler
+ * (SCHED_TRACE_MAIN or SCHED_TRACE_BACKFILL). An attempt still in progress is
+ * recorded first. The attempt must be ended with sched_trace_end() before the
+ * job write lock is released.
+ * NOTE: READ lock_slurmctld config and WRITE lock job before entry
+ */
+extern void sched_trace_begin(job_record_t *job_ptr, uint16_t scheduler);
+
+/*
+ * Record the attempt in progress, if any, in its job's trace with the job's
+ * current state_reason
+ */
+extern void sched_trace_end(void);
+
+/*
+ * Time a phase of the attempt in progress: pass the return value of
+ * sched_trace_phase_start() to sched_trace_phase_end(). Nothing is recorded
+ * when no attempt is in progress.
+ */
+extern uint64_t sched_trace_phase_start(void);
+extern void sched_trace_phase_end(sched_trace_phase_t phase, uint64_t start);
+
+/*
+ * Time node selection of the attempt in progress, excluding accounting
+ * policy and reservation checks made meanwhile. rc is the result of the
+ * node selection.
+ */
+extern void sched_trace_select_start(void);
+extern void sched_trace_select_end(int rc);
+
+/* Free the trace of a job record being purged */
+extern void sched_trace_free(job_record_t *job_ptr);
+
+/*
+ * Fill resp with the trace of job_id, most recent attempt first
+ * RET SLURM_SUCCESS, ESLURM_INVALID_JOB_ID or ESLURM_ACCESS_DENIED
+ * NOTE: READ lock_slurmctld job before entry
+ */
+extern int sched_trace_get(uint32_t job_id, uid_t uid,
+			   sched_trace_msg_t *resp);
+
+#endif	/* !_HAVE_SCHED_TRACE_H */
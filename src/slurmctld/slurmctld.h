@@ -164,6 +164,8 @@ typedef struct diag_stats {
 	uint32_t schedule_cycle_counter;
 	uint32_t schedule_cycle_depth;
 	uint32_t schedule_queue_len;
+	uint64_t schedule_queue_build_sum; /* usec in build_job_queue() */
+	uint64_t schedule_select_sum;	/* usec in select_nodes() */
 
 	uint32_t jobs_submitted;
 	uint32_t jobs_started;
@@ -192,6 +194,9 @@ typedef struct diag_stats {
 	uint32_t bf_table_size;
 	uint32_t bf_table_size_sum;
 	time_t   bf_when_last_cycle;
+	uint64_t bf_queue_build_sum;	/* usec in build_job_queue() */
+	uint64_t bf_select_sum;		/* usec testing node selection */
+	uint64_t bf_yield_sum;		/* usec with locks released */
 
 	uint32_t latency;
 } diag_stats_t;
@@ -230,6 +235,7 @@ extern uint32_t   cluster_cpus;
 extern bool disable_remote_singleton;
 extern int max_depend_depth;
 extern bool node_features_updated;
+extern uint32_t node_features_gen;	/* bumped on feature list changes */
 extern pthread_cond_t purge_thread_cond;
 extern pthread_mutex_t purge_thread_lock;
 extern pthread_mutex_t check_bf_running_lock;
@@ -403,6 +409,13 @@ typedef struct {
 	uint64_t *tres_cnt;	/* array of total TRES in partition. NO_PACK */
 	char     *tres_fmt_str;	/* str of configured TRES in partition */
 	bf_part_data_t *bf_data;/* backfill data, NO PACK */
+	uint32_t sched_resume_job_id; /* main scheduler resumes after this
+				 * job with sched_continue, NO PACK */
+	uint32_t sched_resume_prio; /* priority of sched_resume_job_id */
+	time_t sched_resume_time; /* start of the cycle which began the pass
+				   * ending at sched_resume_job_id */
+	uint32_t sched_heap_cnt; /* records left in the main scheduler's
+				  * heap, NO PACK */
 } part_record_t;
 
 extern List part_list;			/* list of part_record entries */
@@ -502,7 +515,11 @@ typedef struct job_feature {
 	uint8_t op_code;		/* separator, see FEATURE_OP_ above */
 	bitstr_t *node_bitmap_active;	/* nodes with this feature active */
 	bitstr_t *node_bitmap_avail;	/* nodes with this feature available */
+	uint32_t node_features_gen;	/* node_features_gen when the bitmaps
+					 * were set, 0 if not set */
 	uint16_t paren;			/* count of enclosing parenthesis */
+	bool reboot_avail;		/* node_bitmap_avail set with
+					 * can_reboot */
 } job_feature_t;
 
 /*
@@ -725,6 +742,10 @@ struct job_record {
 	time_t end_time_exp;		/* when we believe the job is
 					   going to end. */
 	bool epilog_running;		/* true of EpilogSlurmctld is running */
+	uint32_t event_gen;		/* event_mgr scan generation this job
+					 * was last seen in. NO_PACK */
+	uint32_t event_state;		/* job_state last reported by
+					 * event_mgr. NO_PACK */
 	uint32_t exit_code;		/* exit code for job (status from
 					 * wait call) */
 	job_fed_details_t *fed_details;	/* details for federated jobs. */
@@ -747,9 +768,6 @@ struct job_record {
 	List het_job_list;		/* List of job pointers to all
 					 * components */
 	uint32_t job_id;		/* job ID */
-	job_record_t *job_next;		/* next entry with same hash index */
-	job_record_t *job_array_next_j;	/* job array linked list by job_id */
-	job_record_t *job_array_next_t;	/* job array linked list by task_id */
 	job_record_t *job_preempt_comp; /* het job preempt component */
 	job_resources_t *job_resrcs;	/* details of allocated cores */
 	uint32_t job_state;		/* state of the job */
@@ -789,9 +807,30 @@ struct job_record {
 	char *nodes_completing;		/* nodes still in completing state
 					 * for this job, used to ensure
 					 * epilog is not re-run for job */
+	char *nodes_cg_str;		/* names of node_bitmap_cg nodes used
+					 * by pack_job(), DON'T PACK. This
+					 * and nodes_cg_map are protected by
+					 * the job shard lock */
+	bitstr_t *nodes_cg_map;		/* node_bitmap_cg that nodes_cg_str
+					 * was built from */
 	char *origin_cluster;		/* cluster name that the job was
 					 * submitted from */
 	uint16_t other_port;		/* port for client communications */
+	char *pack_cache;		/* cached pack_job() output of finished
+					 * job, DON'T PACK. This and the other
+					 * pack_cache fields are protected by
+					 * the job shard lock */
+	uint32_t pack_cache_size;	/* size of pack_cache in bytes */
+	uint16_t pack_cache_flags;	/* show_flags used to build pack_cache */
+	uint16_t pack_cache_proto;	/* protocol version of pack_cache */
+	uint32_t pack_cache_state;	/* job_state when pack_cache built */
+	time_t pack_cache_time;		/* time when pack_cache built */
+	uint32_t pack_hash[2];		/* hash of last packed record for two
+					 * sets of show_flags, for SHOW_DELTA
+					 * requests. DON'T PACK. Protected by
+					 * the job shard lock */
+	uint16_t pack_flags[2];		/* show_flags of pack_hash */
+	time_t pack_change[2];		/* time pack_hash last changed */
 	char *partition;		/* name of job partition(s) */
 	List part_ptr_list;		/* list of pointers to partition recs */
 	bool part_nodes_missing;	/* set if job's nodes removed from this
@@ -831,6 +870,8 @@ struct job_record {
 	uint32_t requid;	    	/* requester user ID */
 	char *resp_host;		/* host for srun communications */
 	char *sched_nodes;		/* list of nodes scheduled for job */
+	struct sched_trace_ring *sched_trace; /* recent scheduling attempts,
+					 * see sched_trace.c, DON'T PACK */
 	dynamic_plugin_data_t *select_jobinfo;/* opaque data, BlueGene */
 	uint32_t site_factor;		/* factor to consider in priority */
 	char **spank_job_env;		/* environment variables for job prolog
@@ -850,7 +891,16 @@ struct job_record {
 	uint32_t state_reason_prev_db;	/* Previous state_reason that isn't
 					 * priority or resources, only stored in
 					 * the database. */
+	uint32_t state_save_hash;	/* hash of job's last saved state
+					 * record, used by the job state
+					 * journal, DON'T PACK */
+	struct step_layout_cache *step_layout_cache; /* last step layout built
+					 * by step_layout_create(), DON'T PACK */
 	List step_list;			/* list of job's steps */
+	uint32_t *step_node_use;	/* running steps on each of the job's
+					 * nodes, DON'T PACK */
+	bitstr_t *step_node_use_map;	/* node_bitmap step_node_use was built
+					 * for, DON'T PACK */
 	time_t suspend_time;		/* time job last suspended or resumed */
 	char *system_comment;		/* slurmctld's arbitrary comment */
 	time_t time_last_active;	/* time of last job activity */
@@ -968,6 +1018,8 @@ typedef struct {
 	char *mem_per_tres;		/* semicolon delimited list of TRES=# values */
 	uint64_t *memory_allocated;	/* per node array of memory allocated */
 	char *name;			/* name of job step */
+	bool node_use_counted;		/* counted in job's step_node_use,
+					 * DON'T PACK */
 	char *network;			/* step's network specification */
 	uint64_t pn_min_memory;		/* minimum real memory per node OR
 					 * real memory per CPU | MEM_PER_CPU,
@@ -1929,6 +1981,50 @@ extern void node_no_resp_msg(void);
  * own separate job_record (do not count tasks in pending META job record) */
 extern int num_pending_job_array_tasks(uint32_t array_job_id);
 
+/* job_pack_cache_clear - discard any cached packed form of a job record */
+extern void job_pack_cache_clear(job_record_t *job_ptr);
+
+/* Published snapshot of packed job information */
+typedef struct job_info_snapshot job_info_snapshot_t;
+
+/*
+ * job_info_snapshot_get - find a published snapshot of all jobs' packed
+ *	information matching a request, no job lock is needed
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request
+ * IN protocol_version - slurm protocol version of client
+ * IN locked - caller holds the config and partition read locks, otherwise
+ *	they are briefly taken
+ * RET snapshot no older than job_info_snapshot_interval or NULL if none,
+ *	release with job_info_snapshot_put()
+ */
+extern job_info_snapshot_t *job_info_snapshot_get(uint16_t show_flags,
+						  uid_t uid,
+						  uint16_t protocol_version,
+						  bool locked);
+
+/* job_info_snapshot_data - return packed data of a snapshot and its size */
+extern char *job_info_snapshot_data(job_info_snapshot_t *snap, int *size,
+				    time_t *job_update);
+
+/* job_info_snapshot_put - release a snapshot from job_info_snapshot_get() */
+extern void job_info_snapshot_put(job_info_snapshot_t *snap);
+
+/*
+ * job_info_snapshot_publish - pack all jobs' information and publish it as
+ *	a snapshot for use by later requests with the same parameters, when
+ *	SlurmctldParameters=job_info_snapshot_interval is configured and the
+ *	information does not depend upon the requesting user's privileges
+ * IN show_flags - job filtering options
+ * IN uid - uid of user making request
+ * IN protocol_version - slurm protocol version of client
+ * RET snapshot to release with job_info_snapshot_put() or NULL if no
+ *	snapshot can be published for this request
+ * NOTE: Call with locks set as for pack_all_jobs()
+ */
+extern job_info_snapshot_t *job_info_snapshot_publish(
+	uint16_t show_flags, uid_t uid, uint16_t protocol_version);
+
 /*
  * pack_all_jobs - dump all job information for all jobs in
  *	machine independent form (for network transmission)
@@ -1937,6 +2033,8 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  * IN show_flags - job filtering options
  * IN uid - uid of user making request (for partition filtering)
  * IN filter_uid - pack only jobs belonging to this user if not NO_VAL
+ * IN filter - pack only jobs passing the filters of this request if not NULL
+ * IN update_time - with SHOW_DELTA, only pack records changed since this time
  * IN protocol_version - slurm protocol version of client
  * global: job_list - global list of job records
  * NOTE: the buffer at *buffer_ptr must be xfreed by the caller
@@ -1945,6 +2043,7 @@ extern int num_pending_job_array_tasks(uint32_t array_job_id);
  */
 extern void pack_all_jobs(char **buffer_ptr, int *buffer_size,
 			  uint16_t show_flags, uid_t uid, uint32_t filter_uid,
+			  job_info_request_msg_t *filter, time_t update_time,
 			  uint16_t protocol_version);
 
 /*
@@ -1972,6 +2071,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
  * OUT buffer_size - set to size of the buffer in bytes
  * IN show_flags - node filtering options
  * IN uid - uid of user making request (for partition filtering)
+ * IN update_time - with SHOW_DELTA, only pack records changed since this time
  * IN protocol_version - slurm protocol version of client
  * global: node_record_table_ptr - pointer to global node table
  * NOTE: the caller must xfree the buffer at *buffer_ptr
@@ -1979,7 +2079,7 @@ extern void pack_spec_jobs(char **buffer_ptr, int *buffer_size, List job_ids,
  * NOTE: READ lock_slurmctld config before entry
  */
 extern void pack_all_node (char **buffer_ptr, int *buffer_size,
-			   uint16_t show_flags, uid_t uid,
+			   uint16_t show_flags, uid_t uid, time_t update_time,
 			   uint16_t protocol_version);
 
 /* Pack all scheduling statistics */
@@ -2376,6 +2476,13 @@ extern slurm_step_layout_t *step_layout_create(step_record_t *step_ptr,
 					       uint32_t task_dist,
 					       uint16_t plane_size);
 
+/*
+ * step_cache_free - free a job's cached step layout and step node usage,
+ *	call when the job's step node bitmaps are rebuilt or its steps are
+ *	gone. Both caches are rebuilt on demand.
+ */
+extern void step_cache_free(job_record_t *job_ptr);
+
 /*
  * step_epilog_complete - note completion of epilog on some node and
  *	release it's switch windows if appropriate. can perform partition
@@ -2561,8 +2668,17 @@ extern int validate_job_create_req(job_desc_msg_t * job_desc, uid_t submit_uid,
  *	records, call this function after validate_node_specs() sets the node
  *	state properly
  * IN reg_msg - node registration message
+ * IN defer_purge - leave the purge of jobs missing from the node to the next
+ *	purge_missing_jobs_deferred() call
+ */
+extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg,
+				  bool defer_purge);
+
+/*
+ * purge_missing_jobs_deferred - purge jobs missing from all nodes validated
+ *	with defer_purge set since the last call, walking job_list once
  */
-extern void validate_jobs_on_node(slurm_node_registration_status_msg_t *reg_msg);
+extern void purge_missing_jobs_deferred(void);
 
 /*
  * validate_node_specs - validate the node's specifications as valid,
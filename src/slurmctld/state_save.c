@@ -46,6 +46,7 @@
 #include <pthread.h>
 
 #include "src/common/macros.h"
+#include "src/common/probes.h"
 #include "src/slurmctld/front_end.h"
 #include "src/slurmctld/reservation.h"
 #include "src/slurmctld/slurmctld.h"
@@ -126,6 +127,15 @@ extern void shutdown_state_save(void)
 	slurm_mutex_unlock(&state_save_lock);
 }
 
+static void _save_state(const char *type, int (*save_func)(void))
+{
+	int rc;
+
+	SLURM_PROBE1(state_save__start, type);
+	rc = save_func();
+	SLURM_PROBE2(state_save__done, type, rc);
+}
+
 /*
  * Run as pthread to keep saving slurmctld state information as needed,
  * Use schedule_job_save(),  schedule_node_save(), and schedule_part_save()
@@ -187,7 +197,7 @@ extern void *slurmctld_state_save(void *no_data)
 		}
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
-			(void)dump_all_front_end_state();
+			_save_state("front_end", dump_all_front_end_state);
 
 		/* save job info if necessary */
 		run_save = false;
@@ -198,7 +208,7 @@ extern void *slurmctld_state_save(void *no_data)
 		}
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
-			(void)dump_all_job_state();
+			_save_state("job", dump_all_job_state);
 
 		/* save node info if necessary */
 		run_save = false;
@@ -209,7 +219,7 @@ extern void *slurmctld_state_save(void *no_data)
 		}
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
-			(void)dump_all_node_state();
+			_save_state("node", dump_all_node_state);
 
 		/* save partition info if necessary */
 		run_save = false;
@@ -220,7 +230,7 @@ extern void *slurmctld_state_save(void *no_data)
 		}
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
-			(void)dump_all_part_state();
+			_save_state("part", dump_all_part_state);
 
 		/* save reservation info if necessary */
 		run_save = false;
@@ -231,7 +241,7 @@ extern void *slurmctld_state_save(void *no_data)
 		}
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
-			(void)dump_all_resv_state();
+			_save_state("resv", dump_all_resv_state);
 
 		/* save trigger info if necessary */
 		run_save = false;
@@ -242,6 +252,6 @@ extern void *slurmctld_state_save(void *no_data)
 		}
 		slurm_mutex_unlock(&state_save_lock);
 		if (run_save)
-			(void)trigger_state_save();
+			_save_state("trigger", trigger_state_save);
 	}
 }
@@ -140,6 +140,21 @@ extern void pack_all_stat(int resp, char **buffer_ptr, int *buffer_size,
 			pack32(slurmctld_diag_stats.bf_active, buffer);
 			pack32(slurmctld_diag_stats.backfilled_het_jobs,
 			       buffer);
+
+			if (protocol_version >= SLURM_21_08_PROTOCOL_VERSION) {
+				pack32(retry_list_merge_count(), buffer);
+
+				pack64(slurmctld_diag_stats.
+				       schedule_queue_build_sum, buffer);
+				pack64(slurmctld_diag_stats.schedule_select_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_queue_build_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_select_sum,
+				       buffer);
+				pack64(slurmctld_diag_stats.bf_yield_sum,
+				       buffer);
+			}
 		}
 	}
 
@@ -157,6 +172,8 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.schedule_cycle_sum = 0;
 	slurmctld_diag_stats.schedule_cycle_counter = 0;
 	slurmctld_diag_stats.schedule_cycle_depth = 0;
+	slurmctld_diag_stats.schedule_queue_build_sum = 0;
+	slurmctld_diag_stats.schedule_select_sum = 0;
 	slurmctld_diag_stats.jobs_submitted = 0;
 	slurmctld_diag_stats.jobs_started = 0;
 	slurmctld_diag_stats.jobs_completed = 0;
@@ -180,6 +197,9 @@ extern void reset_stats(int level)
 	slurmctld_diag_stats.bf_cycle_max = 0;
 	slurmctld_diag_stats.bf_last_depth = 0;
 	slurmctld_diag_stats.bf_last_depth_try = 0;
+	slurmctld_diag_stats.bf_queue_build_sum = 0;
+	slurmctld_diag_stats.bf_select_sum = 0;
+	slurmctld_diag_stats.bf_yield_sum = 0;
 
 	last_proc_req_start = time(NULL);
 }
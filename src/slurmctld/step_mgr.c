@@ -87,6 +87,27 @@ typedef struct {
 	uid_t uid;
 } step_signal_t;
 
+/*
+ * Inputs and result of a job's last slurm_step_layout_create() call. Steps
+ * launched back to back in an allocation usually ask for the same layout,
+ * which is then copied instead of being laid out again.
+ */
+struct step_layout_cache {
+	int cpu_inx_cnt;
+	uint32_t *cpu_count_reps;
+	uint16_t *cpus_per_node;
+	uint16_t *cpus_per_task;
+	uint32_t *cpus_task_reps;
+	int cpus_task_cnt;
+	slurm_step_layout_t *layout;
+	char *node_list;
+	uint32_t num_hosts;
+	uint32_t num_tasks;
+	uint16_t plane_size;
+	uint16_t select_type_param;
+	uint32_t task_dist;
+};
+
 static void _build_pending_step(job_record_t *job_ptr,
 				job_step_create_request_msg_t *step_specs);
 static int  _count_cpus(job_record_t *job_ptr, bitstr_t *bitmap,
@@ -137,9 +158,9 @@ static int  _opt_cpu_cnt(uint32_t step_min_cpus, bitstr_t *node_bitmap,
 		last_bit = bit_fls(node_bitmap);
 	else
 		last_bit = first_bit - 1;
-	for (i = first_bit; i <= last_bit; i++) {
-		if (!bit_test(node_bitmap, i))
-			continue;
+	for (i = first_bit;
+	     ((i = bit_ffs_from_bit(node_bitmap, i)) >= 0) &&
+	     (i <= last_bit); i++) {
 		if (usable_cpu_cnt[i] >= rem_cpus)
 			return 0;
 		rem_cpus -= usable_cpu_cnt[i];
@@ -428,12 +449,120 @@ extern void delete_step_records(job_record_t *job_ptr)
 	list_iterator_destroy(step_iterator);
 }
 
+/*
+ * Return true if the step keeps its nodes from being "idle" for new steps.
+ * The batch, extern and interactive steps do not count.
+ */
+static bool _step_uses_nodes(step_record_t *step_ptr)
+{
+	return ((step_ptr->state >= JOB_RUNNING) &&
+		(step_ptr->step_id.step_id != SLURM_BATCH_SCRIPT) &&
+		(step_ptr->step_id.step_id != SLURM_EXTERN_CONT) &&
+		(step_ptr->step_id.step_id != SLURM_INTERACTIVE_STEP) &&
+		step_ptr->step_node_bitmap);
+}
+
+/* Add cnt to the job's step_node_use for each node of the step */
+static void _step_node_use_add(job_record_t *job_ptr, step_record_t *step_ptr,
+			       int cnt)
+{
+	int i, first_bit, last_bit, pos = -1;
+
+	for (first_bit = i = bit_ffs(job_ptr->node_bitmap),
+	     last_bit = bit_fls(job_ptr->node_bitmap);
+	     (first_bit >= 0) && (i <= last_bit); i++) {
+		if (!bit_test(job_ptr->node_bitmap, i))
+			continue;
+		pos++;
+		if (bit_test(step_ptr->step_node_bitmap, i))
+			job_ptr->step_node_use[pos] += cnt;
+	}
+}
+
+/*
+ * The job's step_node_use is built from the step list when first needed and
+ * then kept current as steps start and are freed, so picking nodes for a new
+ * step does not walk every running step. It is rebuilt if the job's
+ * node_bitmap changed since.
+ */
+static bool _step_node_use_valid(job_record_t *job_ptr)
+{
+	return (job_ptr->step_node_use && job_ptr->node_bitmap &&
+		bit_equal(job_ptr->step_node_use_map, job_ptr->node_bitmap));
+}
+
+static void _step_node_use_start(job_record_t *job_ptr,
+				 step_record_t *step_ptr)
+{
+	if (!_step_uses_nodes(step_ptr))
+		return;
+
+	step_ptr->node_use_counted = true;
+	if (_step_node_use_valid(job_ptr))
+		_step_node_use_add(job_ptr, step_ptr, 1);
+}
+
+static void _step_node_use_end(step_record_t *step_ptr)
+{
+	job_record_t *job_ptr = step_ptr->job_ptr;
+
+	if (!step_ptr->node_use_counted)
+		return;
+
+	step_ptr->node_use_counted = false;
+	if (job_ptr && _step_node_use_valid(job_ptr))
+		_step_node_use_add(job_ptr, step_ptr, -1);
+}
+
+static int _step_node_use_build(void *x, void *arg)
+{
+	step_record_t *step_ptr = x;
+	job_record_t *job_ptr = arg;
+
+	step_ptr->node_use_counted = _step_uses_nodes(step_ptr);
+	if (step_ptr->node_use_counted)
+		_step_node_use_add(job_ptr, step_ptr, 1);
+
+	return 0;
+}
+
+/* Return a bitmap of the nodes in nodes_avail not used by any running step */
+static bitstr_t *_step_nodes_idle(job_record_t *job_ptr, bitstr_t *nodes_avail)
+{
+	bitstr_t *nodes_idle = bit_alloc(bit_size(nodes_avail));
+	int i, first_bit, last_bit, pos = -1;
+
+	if (!_step_node_use_valid(job_ptr)) {
+		xfree(job_ptr->step_node_use);
+		FREE_NULL_BITMAP(job_ptr->step_node_use_map);
+		job_ptr->step_node_use = xcalloc(
+			bit_set_count(job_ptr->node_bitmap), sizeof(uint32_t));
+		job_ptr->step_node_use_map = bit_copy(job_ptr->node_bitmap);
+		list_for_each(job_ptr->step_list, _step_node_use_build,
+			      job_ptr);
+	}
+
+	for (first_bit = i = bit_ffs(job_ptr->node_bitmap),
+	     last_bit = bit_fls(job_ptr->node_bitmap);
+	     (first_bit >= 0) && (i <= last_bit); i++) {
+		if (!bit_test(job_ptr->node_bitmap, i))
+			continue;
+		pos++;
+		if (!job_ptr->step_node_use[pos])
+			bit_set(nodes_idle, i);
+	}
+	bit_and(nodes_idle, nodes_avail);
+
+	return nodes_idle;
+}
+
 /* free_step_record - delete a step record's data structures */
 extern void free_step_record(void *x)
 {
 	step_record_t *step_ptr = (step_record_t *) x;
 	xassert(step_ptr);
 	xassert(step_ptr->magic == STEP_MAGIC);
+	_step_node_use_end(step_ptr);
 /*
  * FIXME: If job step record is preserved after completion,
  * the switch_g_job_step_complete() must be called upon completion
@@ -841,9 +970,9 @@ static bitstr_t *_pick_step_nodes_cpus(job_record_t *job_ptr,
 		last_bit  = bit_fls(nodes_bitmap);
 	else
 		last_bit = first_bit - 1;
-	for (i = first_bit; i <= last_bit; i++) {
-		if (!bit_test(nodes_bitmap, i))
-			continue;
+	for (i = first_bit;
+	     ((i = bit_ffs_from_bit(nodes_bitmap, i)) >= 0) &&
+	     (i <= last_bit); i++) {
 		if (usable_cpu_cnt[i] < cpu_target) {
 			usable_cpu_array[usable_cpu_cnt[i]]++;
 			continue;
@@ -886,9 +1015,9 @@ static bitstr_t *_pick_step_nodes_cpus(job_record_t *job_ptr,
 	rem_cpus  = save_rem_cpus;
 
 	/* Pick nodes with CPU counts below original target */
-	for (i = first_bit; i <= last_bit; i++) {
-		if (!bit_test(nodes_bitmap, i))
-			continue;
+	for (i = first_bit;
+	     ((i = bit_ffs_from_bit(nodes_bitmap, i)) >= 0) &&
+	     (i <= last_bit); i++) {
 		if (usable_cpu_cnt[i] >= cpu_target)
 			continue;	/* already picked */
 		if (usable_cpu_array[usable_cpu_cnt[i]] == 0)
@@ -941,8 +1070,6 @@ static bitstr_t *_pick_step_nodes(job_record_t *job_ptr,
 	int cpu_cnt, i, max_rem_nodes;
 	int mem_blocked_nodes = 0, mem_blocked_cpus = 0;
 	int job_blocked_nodes = 0, job_blocked_cpus = 0;
-	ListIterator step_iterator;
-	step_record_t *step_ptr;
 	job_resources_t *job_resrcs_ptr = job_ptr->job_resrcs;
 	uint32_t *usable_cpu_cnt = NULL;
 	uint64_t gres_cpus;
@@ -1053,9 +1180,9 @@ static bitstr_t *_pick_step_nodes(job_record_t *job_ptr,
 			i_last  = bit_fls(job_ptr->node_bitmap);
 		else
 			i_last = -2;
-		for (i = i_first; i <= i_last; i++) {
-			if (!bit_test(job_ptr->node_bitmap, i))
-				continue;
+		for (i = i_first;
+		     ((i = bit_ffs_from_bit(job_ptr->node_bitmap, i)) >= 0) &&
+		     (i <= i_last); i++) {
 			node_ptr = node_record_table_ptr + i;
 			if (IS_NODE_POWER_SAVE(node_ptr) ||
 			    IS_NODE_FUTURE(node_ptr) ||
@@ -1095,9 +1222,9 @@ static bitstr_t *_pick_step_nodes(job_record_t *job_ptr,
 		last_bit  = bit_fls(job_resrcs_ptr->node_bitmap);
 	else
 		last_bit = -2;
-	for (i = first_bit, node_inx = -1; i <= last_bit; i++) {
-		if (!bit_test(job_resrcs_ptr->node_bitmap, i))
-			continue;
+	for (i = first_bit, node_inx = -1;
+	     ((i = bit_ffs_from_bit(job_resrcs_ptr->node_bitmap, i)) >= 0) &&
+	     (i <= last_bit); i++) {
 		node_inx++;
 		if (!bit_test(nodes_avail, i))
 			continue;	/* node now DOWN */
@@ -1362,40 +1489,7 @@ static bitstr_t *_pick_step_nodes(job_record_t *job_ptr,
 		bit_and_not(nodes_avail, relative_nodes);
 		FREE_NULL_BITMAP(relative_nodes);
 	} else {
-		nodes_idle = bit_alloc (bit_size (nodes_avail) );
-		step_iterator = list_iterator_create(job_ptr->step_list);
-		while ((step_ptr = list_next(step_iterator))) {
-			if (step_ptr->state < JOB_RUNNING)
-				continue;
-
-			/*
-			 * Don't consider the batch and extern steps when
-			 * looking for "idle" nodes.
-			 */
-			if ((step_ptr->step_id.step_id == SLURM_BATCH_SCRIPT) ||
-			    (step_ptr->step_id.step_id == SLURM_EXTERN_CONT) ||
-			    (step_ptr->step_id.step_id == SLURM_INTERACTIVE_STEP))
-				continue;
-
-			if (!step_ptr->step_node_bitmap) {
-				error("%s: %pS has no step_node_bitmap",
-				      __func__, step_ptr);
-				continue;
-			}
-
-			bit_or(nodes_idle, step_ptr->step_node_bitmap);
-			if (slurm_conf.debug_flags & DEBUG_FLAG_STEPS) {
-				char *temp;
-				temp = bitmap2node_name(step_ptr->
-							step_node_bitmap);
-				log_flag(STEPS, "%s: %pS has nodes %s",
-					 __func__,step_ptr, temp);
-				xfree(temp);
-			}
-		}
-		list_iterator_destroy (step_iterator);
-		bit_not(nodes_idle);
-		bit_and(nodes_idle, nodes_avail);
+		nodes_idle = _step_nodes_idle(job_ptr, nodes_avail);
 	}
 
 	if (slurm_conf.debug_flags & DEBUG_FLAG_STEPS) {
@@ -1635,9 +1729,9 @@ cleanup:
 			last_bit = -2;
 		else
 			last_bit = bit_fls(nodes_picked);
-		for (i = first_bit; i <= last_bit; i++) {
-			if (!bit_test(nodes_picked, i))
-				continue;
+		for (i = first_bit;
+		     ((i = bit_ffs_from_bit(nodes_picked, i)) >= 0) &&
+		     (i <= last_bit); i++) {
 			node_ptr = node_record_table_ptr + i;
 			if (!IS_NODE_NO_RESPOND(node_ptr)) {
 				*return_code = ESLURM_NODES_BUSY;
@@ -1860,9 +1954,10 @@ static void _step_alloc_lps(step_record_t *step_ptr)
 
 	rem_nodes = bit_set_count(step_ptr->step_node_bitmap);
 	step_ptr->memory_allocated = xcalloc(rem_nodes, sizeof(uint64_t));
-	for (i_node = i_first; i_node <= i_last; i_node++) {
-		if (!bit_test(job_resrcs_ptr->node_bitmap, i_node))
-			continue;
+	for (i_node = i_first;
+	     ((i_node = bit_ffs_from_bit(job_resrcs_ptr->node_bitmap,
+					 i_node)) >= 0) &&
+	     (i_node <= i_last); i_node++) {
 		job_node_inx++;
 		if (!bit_test(step_ptr->step_node_bitmap, i_node))
 			continue;
@@ -2037,9 +2132,10 @@ static void _step_dealloc_lps(step_record_t *step_ptr)
 		step_ptr->pn_min_memory = 0;
 	}
 
-	for (i_node = i_first; i_node <= i_last; i_node++) {
-		if (!bit_test(job_resrcs_ptr->node_bitmap, i_node))
-			continue;
+	for (i_node = i_first;
+	     ((i_node = bit_ffs_from_bit(job_resrcs_ptr->node_bitmap,
+					 i_node)) >= 0) &&
+	     (i_node <= i_last); i_node++) {
 		job_node_inx++;
 		if (!bit_test(step_ptr->step_node_bitmap, i_node))
 			continue;
@@ -2191,9 +2287,9 @@ static void _set_def_cpu_bind(job_record_t *job_ptr)
 		i_last = -2;
 	else
 		i_last  = bit_fls(job_resrcs_ptr->node_bitmap);
-	for (i = i_first; i <= i_last; i++) {
-		if (!bit_test(job_resrcs_ptr->node_bitmap, i))
-			continue;
+	for (i = i_first;
+	     ((i = bit_ffs_from_bit(job_resrcs_ptr->node_bitmap, i)) >= 0) &&
+	     (i <= i_last); i++) {
 		node_ptr = node_record_table_ptr + i;
 		if (node_bind == NO_VAL) {
 			if (node_ptr->cpu_bind != 0)
@@ -2807,6 +2903,7 @@ extern int step_create(job_step_create_request_msg_t *step_specs,
 		xfree(step_layout->node_list);
 
 	_step_alloc_lps(step_ptr);
+	_step_node_use_start(job_ptr, step_ptr);
 
 	*new_step_record = step_ptr;
 
@@ -2821,6 +2918,91 @@ extern int step_create(job_step_create_request_msg_t *step_specs,
 	return SLURM_SUCCESS;
 }
 
+static void _step_layout_cache_free(job_record_t *job_ptr)
+{
+	struct step_layout_cache *cache = job_ptr->step_layout_cache;
+
+	if (!cache)
+		return;
+
+	xfree(cache->cpu_count_reps);
+	xfree(cache->cpus_per_node);
+	xfree(cache->cpus_per_task);
+	xfree(cache->cpus_task_reps);
+	slurm_step_layout_destroy(cache->layout);
+	xfree(cache->node_list);
+	xfree(cache);
+	job_ptr->step_layout_cache = NULL;
+}
+
+extern void step_cache_free(job_record_t *job_ptr)
+{
+	_step_layout_cache_free(job_ptr);
+	xfree(job_ptr->step_node_use);
+	FREE_NULL_BITMAP(job_ptr->step_node_use_map);
+}
+
+static bool _step_layout_cache_match(struct step_layout_cache *cache,
+				     slurm_step_layout_req_t *req,
+				     int cpu_inx_cnt, int cpus_task_cnt)
+{
+	if (!cache ||
+	    (cache->num_hosts != req->num_hosts) ||
+	    (cache->num_tasks != req->num_tasks) ||
+	    (cache->task_dist != req->task_dist) ||
+	    (cache->plane_size != req->plane_size) ||
+	    (cache->select_type_param != slurm_conf.select_type_param) ||
+	    (cache->cpu_inx_cnt != cpu_inx_cnt) ||
+	    (cache->cpus_task_cnt != cpus_task_cnt) ||
+	    xstrcmp(cache->node_list, req->node_list))
+		return false;
+
+	if (memcmp(cache->cpus_per_node, req->cpus_per_node,
+		   sizeof(uint16_t) * cpu_inx_cnt) ||
+	    memcmp(cache->cpu_count_reps, req->cpu_count_reps,
+		   sizeof(uint32_t) * cpu_inx_cnt) ||
+	    memcmp(cache->cpus_per_task, req->cpus_per_task,
+		   sizeof(uint16_t) * cpus_task_cnt) ||
+	    memcmp(cache->cpus_task_reps, req->cpus_task_reps,
+		   sizeof(uint32_t) * cpus_task_cnt))
+		return false;
+
+	return true;
+}
+
+static void _step_layout_cache_set(job_record_t *job_ptr,
+				   slurm_step_layout_req_t *req,
+				   int cpu_inx_cnt, int cpus_task_cnt,
+				   slurm_step_layout_t *layout)
+{
+	struct step_layout_cache *cache;
+
+	_step_layout_cache_free(job_ptr);
+	cache = xmalloc(sizeof(*cache));
+	cache->cpu_inx_cnt = cpu_inx_cnt;
+	cache->cpus_per_node = xcalloc(cpu_inx_cnt, sizeof(uint16_t));
+	memcpy(cache->cpus_per_node, req->cpus_per_node,
+	       sizeof(uint16_t) * cpu_inx_cnt);
+	cache->cpu_count_reps = xcalloc(cpu_inx_cnt, sizeof(uint32_t));
+	memcpy(cache->cpu_count_reps, req->cpu_count_reps,
+	       sizeof(uint32_t) * cpu_inx_cnt);
+	cache->cpus_task_cnt = cpus_task_cnt;
+	cache->cpus_per_task = xcalloc(cpus_task_cnt, sizeof(uint16_t));
+	memcpy(cache->cpus_per_task, req->cpus_per_task,
+	       sizeof(uint16_t) * cpus_task_cnt);
+	cache->cpus_task_reps = xcalloc(cpus_task_cnt, sizeof(uint32_t));
+	memcpy(cache->cpus_task_reps, req->cpus_task_reps,
+	       sizeof(uint32_t) * cpus_task_cnt);
+	cache->layout = slurm_step_layout_copy(layout);
+	cache->node_list = xstrdup(req->node_list);
+	cache->num_hosts = req->num_hosts;
+	cache->num_tasks = req->num_tasks;
+	cache->plane_size = req->plane_size;
+	cache->select_type_param = slurm_conf.select_type_param;
+	cache->task_dist = req->task_dist;
+	job_ptr->step_layout_cache = cache;
+}
+
 extern slurm_step_layout_t *step_layout_create(step_record_t *step_ptr,
 					       char *step_node_list,
 					       uint32_t node_count,
@@ -2846,7 +3028,8 @@ extern slurm_step_layout_t *step_layout_create(step_record_t *step_ptr,
 	uint32_t cpus_task = 0;
 	uint16_t ntasks_per_core = 0;
 	uint16_t ntasks_per_socket = 0;
-	bool first_step_node = true;
+	bool first_step_node = true, cache_ok;
+	int cpus_task_cnt;
 
 	xassert(job_resrcs_ptr);
 	xassert(job_resrcs_ptr->cpus);
@@ -3070,8 +3253,30 @@ extern slurm_step_layout_t *step_layout_create(step_record_t *step_ptr,
 	step_layout_req.task_dist = task_dist;
 	step_layout_req.plane_size = plane_size;
 
+	/*
+	 * Arbitrary layouts are rare and rewrite num_hosts, so are not
+	 * cached. The one thread per core path above only sets the first
+	 * cpus_per_task entry.
+	 */
+	cache_ok = (set_nodes > 0) &&
+		   ((task_dist & SLURM_DIST_STATE_BASE) != SLURM_DIST_ARBITRARY);
+	cpus_task_cnt = MAX(cpus_task_inx + 1, 1);
+	if (cache_ok &&
+	    _step_layout_cache_match(job_ptr->step_layout_cache,
+				     &step_layout_req, cpu_inx + 1,
+				     cpus_task_cnt)) {
+		step_layout = slurm_step_layout_copy(
+			job_ptr->step_layout_cache->layout);
+		step_layout->start_protocol_ver = step_ptr->start_protocol_ver;
+		return step_layout;
+	}
+
 	if ((step_layout = slurm_step_layout_create(&step_layout_req))) {
 		step_layout->start_protocol_ver = step_ptr->start_protocol_ver;
+		if (cache_ok)
+			_step_layout_cache_set(job_ptr, &step_layout_req,
+					       cpu_inx + 1, cpus_task_cnt,
+					       step_layout);
 	}
 
 	return step_layout;
@@ -4391,6 +4596,7 @@ extern int load_step_state(job_record_t *job_ptr, buf_t *buffer,
 		step_ptr->ext_sensors = ext_sensors_alloc();
 
 	step_ptr->exit_code    = exit_code;
+	_step_node_use_start(job_ptr, step_ptr);
 
 	if (exit_node_bitmap) {
 		step_ptr->exit_node_bitmap = exit_node_bitmap;
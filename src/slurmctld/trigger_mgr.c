@@ -91,6 +91,13 @@ static bool trigger_pri_dbd_fail = false;
 static bool trigger_pri_dbd_res_op = false;
 static bool trigger_pri_db_fail = false;
 static bool trigger_pri_db_res_op = false;
+/*
+ * TRIGGER_TYPE_* of the node events pending for this trigger_process() pass,
+ * so each node trigger does not need to scan the event bitmaps, and the idle
+ * nodes, found at most once per pass for all TRIGGER_TYPE_IDLE triggers.
+ */
+static uint32_t trigger_node_events = 0;
+static bitstr_t *trigger_idle_nodes_bitmap = NULL;
 
 /* Current trigger pull states (saved and restored) */
 uint8_t ctld_failure = 0;
@@ -1043,9 +1050,8 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_DOWN) {
-		if (trigger_down_nodes_bitmap &&
-		    bit_overlap_any(job_ptr->node_bitmap,
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_DOWN) {
+		if (bit_overlap_any(job_ptr->node_bitmap,
 				    trigger_down_nodes_bitmap)) {
 			log_flag(TRIGGERS, "trigger[%u] for job %u down",
 				 trig_in->trig_id, trig_in->job_id);
@@ -1056,9 +1062,8 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_FAIL) {
-		if (trigger_fail_nodes_bitmap &&
-		    bit_overlap_any(job_ptr->node_bitmap,
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_FAIL) {
+		if (bit_overlap_any(job_ptr->node_bitmap,
 				    trigger_fail_nodes_bitmap)) {
 			log_flag(TRIGGERS, "trigger[%u] for job %u node fail",
 				 trig_in->trig_id, trig_in->job_id);
@@ -1069,9 +1074,8 @@ static void _trigger_job_event(trig_mgr_info_t *trig_in, time_t now)
 		}
 	}
 
-	if (trig_in->trig_type & TRIGGER_TYPE_UP) {
-		if (trigger_up_nodes_bitmap &&
-		    bit_overlap_any(job_ptr->node_bitmap,
+	if (trig_in->trig_type & trigger_node_events & TRIGGER_TYPE_UP) {
+		if (bit_overlap_any(job_ptr->node_bitmap,
 				    trigger_up_nodes_bitmap)) {
 			trig_in->state = 1;
 			trig_in->trig_time = now +
@@ -1139,13 +1143,45 @@ static void _trigger_other_event(trig_mgr_info_t *trig_in, time_t now)
 	}
 }
 
+/* Bitmap of all idle nodes */
+static bitstr_t *_idle_nodes_bitmap(void)
+{
+	bitstr_t *idle_bitmap = bit_alloc(node_record_count);
+	node_record_t *node_ptr = node_record_table_ptr;
+	int i;
+
+	for (i = 0; i < node_record_count; i++, node_ptr++) {
+		if (IS_NODE_IDLE(node_ptr))
+			bit_set(idle_bitmap, i);
+	}
+
+	return idle_bitmap;
+}
+
+/* Set trigger_node_events from the node event bitmaps */
+static void _set_node_events(void)
+{
+	trigger_node_events = 0;
+	if (trigger_down_nodes_bitmap &&
+	    (bit_ffs(trigger_down_nodes_bitmap) != -1))
+		trigger_node_events |= TRIGGER_TYPE_DOWN;
+	if (trigger_drained_nodes_bitmap &&
+	    (bit_ffs(trigger_drained_nodes_bitmap) != -1))
+		trigger_node_events |= TRIGGER_TYPE_DRAINED;
+	if (trigger_fail_nodes_bitmap &&
+	    (bit_ffs(trigger_fail_nodes_bitmap) != -1))
+		trigger_node_events |= TRIGGER_TYPE_FAIL;
+	if (trigger_up_nodes_bitmap &&
+	    (bit_ffs(trigger_up_nodes_bitmap) != -1))
+		trigger_node_events |= TRIGGER_TYPE_UP;
+}
+
 static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 {
 	xassert(verify_lock(NODE_LOCK, READ_LOCK));
 
 	if ((trig_in->trig_type & TRIGGER_TYPE_DOWN) &&
-	    trigger_down_nodes_bitmap                &&
-	    (bit_ffs(trigger_down_nodes_bitmap) != -1)) {
+	    (trigger_node_events & TRIGGER_TYPE_DOWN)) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
 			trig_in->res_id = bitmap2node_name(
@@ -1170,8 +1206,7 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 	}
 
 	if ((trig_in->trig_type & TRIGGER_TYPE_DRAINED) &&
-	    trigger_drained_nodes_bitmap                &&
-	    (bit_ffs(trigger_drained_nodes_bitmap) != -1)) {
+	    (trigger_node_events & TRIGGER_TYPE_DRAINED)) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
 			trig_in->res_id = bitmap2node_name(
@@ -1196,8 +1231,7 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 	}
 
 	if ((trig_in->trig_type & TRIGGER_TYPE_FAIL) &&
-	    trigger_fail_nodes_bitmap                &&
-	    (bit_ffs(trigger_fail_nodes_bitmap) != -1)) {
+	    (trigger_node_events & TRIGGER_TYPE_FAIL)) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
 			trig_in->res_id = bitmap2node_name(
@@ -1225,16 +1259,23 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 		/* We need to determine which (if any) of these
 		 * nodes have been idle for at least the offset time */
 		time_t min_idle = now - (trig_in->trig_time - 0x8000);
-		int i;
-		node_record_t *node_ptr = node_record_table_ptr;
+		int i, i_first, i_last;
 		bitstr_t *trigger_idle_node_bitmap;
 
-		trigger_idle_node_bitmap = bit_alloc(node_record_count);
-		for (i = 0; i < node_record_count; i++, node_ptr++) {
-			if (!IS_NODE_IDLE(node_ptr) ||
-			    (node_ptr->last_busy > min_idle))
-				continue;
-			bit_set(trigger_idle_node_bitmap, i);
+		if (!trigger_idle_nodes_bitmap)
+			trigger_idle_nodes_bitmap = _idle_nodes_bitmap();
+		trigger_idle_node_bitmap = bit_copy(trigger_idle_nodes_bitmap);
+		if (trig_in->nodes_bitmap)
+			bit_and(trigger_idle_node_bitmap, trig_in->nodes_bitmap);
+		i_first = bit_ffs(trigger_idle_node_bitmap);
+		if (i_first >= 0)
+			i_last = bit_fls(trigger_idle_node_bitmap);
+		else
+			i_last = -2;
+		for (i = i_first; i <= i_last; i++) {
+			if (bit_test(trigger_idle_node_bitmap, i) &&
+			    (node_record_table_ptr[i].last_busy > min_idle))
+				bit_clear(trigger_idle_node_bitmap, i);
 		}
 		if (trig_in->nodes_bitmap == NULL) {    /* all nodes */
 			xfree(trig_in->res_id);
@@ -1260,8 +1301,7 @@ static void _trigger_node_event(trig_mgr_info_t *trig_in, time_t now)
 	}
 
 	if ((trig_in->trig_type & TRIGGER_TYPE_UP) &&
-	    trigger_up_nodes_bitmap                &&
-	    (bit_ffs(trigger_up_nodes_bitmap) != -1)) {
+	    (trigger_node_events & TRIGGER_TYPE_UP)) {
 		if (trig_in->nodes_bitmap == NULL) {	/* all nodes */
 			xfree(trig_in->res_id);
 			trig_in->res_id = bitmap2node_name(
@@ -1518,6 +1558,8 @@ static void _clear_event_triggers(void)
 		bit_nclear(trigger_up_nodes_bitmap,
 			   0, (bit_size(trigger_up_nodes_bitmap) - 1));
 	}
+	FREE_NULL_BITMAP(trigger_idle_nodes_bitmap);
+	trigger_node_events = 0;
 	trigger_node_reconfig = false;
 	trigger_bb_error = false;
 	trigger_pri_ctld_fail = false;
@@ -1572,6 +1614,7 @@ extern void trigger_process(void)
 	slurm_mutex_lock(&trigger_mutex);
 	if (trigger_list == NULL)
 		trigger_list = list_create(_trig_del);
+	_set_node_events();
 
 	trig_iter = list_iterator_create(trigger_list);
 	while ((trig_in = list_next(trig_iter))) {
@@ -71,6 +71,8 @@ bool proctrack_forked = false;
 typedef struct slurm_proctrack_ops {
 	int              (*create)    (stepd_step_rec_t * job);
 	int              (*add)       (stepd_step_rec_t * job, pid_t pid);
+	int              (*add_pids)  (stepd_step_rec_t * job, pid_t *pids,
+				       int npids);
 	int              (*signal)    (uint64_t id, int signal);
 	int              (*destroy)   (uint64_t id);
 	uint64_t         (*find_cont) (pid_t pid);
@@ -85,6 +87,7 @@ typedef struct slurm_proctrack_ops {
 static const char *syms[] = {
 	"proctrack_p_create",
 	"proctrack_p_add",
+	"proctrack_p_add_pids",
 	"proctrack_p_signal",
 	"proctrack_p_destroy",
 	"proctrack_p_find",
@@ -191,6 +194,36 @@ extern int proctrack_g_add(stepd_step_rec_t * job, pid_t pid)
 	return rc;
 }
 
+/*
+ * Add several processes to the specified container
+ * job IN - stepd_step_rec_t structure
+ * pids IN     - process IDs to be added to the container
+ * npids IN    - number of entries in pids
+ *
+ * Returns a Slurm errno.
+ */
+extern int proctrack_g_add_pids(stepd_step_rec_t *job, pid_t *pids, int npids)
+{
+	int i = 0, max_retry = 3, rc;
+
+	if (slurm_proctrack_init() < 0)
+		return SLURM_ERROR;
+
+	/* Adding a pid already in the container is harmless, so a transient
+	 * failure part way through just retries the whole set.
+	 */
+	while ((rc = (*(ops.add_pids)) (job, pids, npids)) != SLURM_SUCCESS) {
+		if (i++ > max_retry)
+			break;
+		debug("%s: %u.%u couldn't add %d pids, sleeping and trying again",
+		      __func__, job->step_id.job_id, job->step_id.step_id,
+		      npids);
+		sleep(1);
+	}
+
+	return rc;
+}
+
 /* Determine if core dump in progress
  * stat_fname - Pathname of the form /proc/<PID>/stat
  * RET - True if core dump in progress, otherwise false
@@ -87,6 +87,17 @@ extern int proctrack_g_create(stepd_step_rec_t *job);
  */
 extern int proctrack_g_add(stepd_step_rec_t *job, pid_t pid);
 
+/*
+ * Add several processes to the specified container with a single plugin
+ * call, e.g. all tasks of a step once they have been forked.
+ * job IN - stepd_step_rec_t structure
+ * pids IN     - process IDs to be added to the container
+ * npids IN    - number of entries in pids
+ *
+ * Returns a Slurm errno.
+ */
+extern int proctrack_g_add_pids(stepd_step_rec_t *job, pid_t *pids, int npids);
+
 /*
  * Signal all processes within a container
  * cont_id IN - container ID as returned by proctrack_g_create()
@@ -126,6 +126,14 @@ get_procs(uint16_t *procs)
 
 static char *hwloc_xml_whole = NULL;
 
+/*
+ * In the slurmstepd the step's topology is discovered once and written to
+ * conf->hwloc_xml before any task is forked. Keep that topology so each task
+ * can duplicate it instead of parsing the XML file again.
+ */
+static hwloc_topology_t cached_topo;
+static char *cached_topo_file = NULL;
+
 #if _DEBUG
 static void _hwloc_children(hwloc_topology_t topology, hwloc_obj_t obj,
 			    int depth)
@@ -185,6 +193,14 @@ extern int xcpuinfo_hwloc_topo_load(
 		goto handle_write;
 	}
 
+	if (!full && cached_topo_file && !xstrcmp(cached_topo_file, topo_file)) {
+		hwloc_topology_destroy(*topology);
+		if (!hwloc_topology_dup(topology, cached_topo))
+			return ret;
+		error("%s: hwloc_topology_dup() failed", __func__);
+		hwloc_topology_init(topology);
+	}
+
 	if (full && first_full) {
 		/* Always regenerate file on slurmd startup */
 		if (running_in_slurmd())
@@ -249,8 +265,16 @@ handle_write:
 		}
 	}
 
-	if (!topology_in)
-		hwloc_topology_destroy(tmp_topo);
+	if (!topology_in) {
+		if (!ret && !full && running_in_slurmstepd()) {
+			if (cached_topo_file)
+				hwloc_topology_destroy(cached_topo);
+			cached_topo = tmp_topo;
+			xfree(cached_topo_file);
+			cached_topo_file = xstrdup(topo_file);
+		} else
+			hwloc_topology_destroy(tmp_topo);
+	}
 
 	return ret;
 }
@@ -956,6 +980,12 @@ xcpuinfo_init(void)
 int
 xcpuinfo_fini(void)
 {
+#ifdef HAVE_HWLOC
+	if (cached_topo_file) {
+		hwloc_topology_destroy(cached_topo);
+		xfree(cached_topo_file);
+	}
+#endif
 	if ( ! initialized )
 		return XCPUINFO_SUCCESS;
 
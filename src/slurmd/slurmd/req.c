@@ -42,6 +42,7 @@
 #include "config.h"
 
 #include <ctype.h>
+#include <dirent.h>
 #include <fcntl.h>
 #include <grp.h>
 #ifdef HAVE_NUMA
@@ -244,6 +245,8 @@ static pthread_mutex_t prolog_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_mutex_t prolog_serial_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 #define FILE_BCAST_TIMEOUT 300
+#define SBCAST_CACHE_DIR "sbcast_cache"
+#define SBCAST_CACHE_BUF_SIZE (1024 * 1024)
 static pthread_mutex_t file_bcast_mutex = PTHREAD_MUTEX_INITIALIZER;
 static pthread_cond_t  file_bcast_cond  = PTHREAD_COND_INITIALIZER;
 static int fb_read_lock = 0, fb_write_wait_lock = 0, fb_write_lock = 0;
@@ -1348,8 +1351,6 @@ _rpc_launch_tasks(slurm_msg_t *msg)
 	int node_id = 0;
 	bitstr_t *numa_bitmap = NULL;
 
-	slurm_mutex_lock(&launch_mutex);
-
 #ifndef HAVE_FRONT_END
 	/* It is always 0 for front end systems */
 	node_id = nodelist_find(req->complete_nodelist, conf->node_name);
@@ -1484,19 +1485,6 @@ _rpc_launch_tasks(slurm_msg_t *msg)
 	}
 #endif
 
-	if (req->mem_bind_type & MEM_BIND_SORT) {
-		int task_cnt = -1;
-		if (req->tasks_to_launch)
-			task_cnt = (int) req->tasks_to_launch[node_id];
-		mem_sort = true;
-		numa_bitmap = _build_numa_bitmap(req->mem_bind_type,
-						 req->mem_bind,
-						 req->cpu_bind_type,
-						 req->cpu_bind, task_cnt);
-	}
-	node_features_g_step_config(mem_sort, numa_bitmap);
-	FREE_NULL_BITMAP(numa_bitmap);
-
 	if (req->job_mem_lim || req->step_mem_lim) {
 		step_loc_t step_info;
 		slurm_mutex_lock(&job_limits_mutex);
@@ -1531,10 +1519,30 @@ _rpc_launch_tasks(slurm_msg_t *msg)
 		goto done;
 	}
 
+	/*
+	 * Only the node features step configuration and the slurmstepd
+	 * startup need to be serialized, as done for batch jobs. Credential
+	 * checks and prologs of other launches may proceed in the meantime.
+	 */
+	slurm_mutex_lock(&launch_mutex);
+	if (req->mem_bind_type & MEM_BIND_SORT) {
+		int task_cnt = -1;
+		if (req->tasks_to_launch)
+			task_cnt = (int) req->tasks_to_launch[node_id];
+		mem_sort = true;
+		numa_bitmap = _build_numa_bitmap(req->mem_bind_type,
+						 req->mem_bind,
+						 req->cpu_bind_type,
+						 req->cpu_bind, task_cnt);
+	}
+	node_features_g_step_config(mem_sort, numa_bitmap);
+	FREE_NULL_BITMAP(numa_bitmap);
+
 	debug3("%s: call to _forkexec_slurmstepd", __func__);
 	errnum = _forkexec_slurmstepd(LAUNCH_TASKS, (void *)req, cli, &self,
 				      step_hset, msg->protocol_version);
 	debug3("%s: return from _forkexec_slurmstepd", __func__);
+	slurm_mutex_unlock(&launch_mutex);
 	_launch_complete_add(req->step_id.job_id);
 
 done:
@@ -1561,8 +1569,6 @@ done:
 		_launch_job_fail(req->step_id.job_id, errnum);
 		send_registration_msg(errnum, false);
 	}
-
-	slurm_mutex_unlock(&launch_mutex);
 }
 
 /*
@@ -3407,6 +3413,69 @@ static void _rpc_daemon_status(slurm_msg_t *msg)
 	slurm_free_slurmd_status(resp);
 }
 
+/*
+ * Fold the RESPONSE_JOB_STEP_STAT replies forwarded to us by the nodes below
+ * us in the tree into our own reply, so a single record per subtree travels
+ * back up. The forwarding code expects one entry per node, so each merged
+ * reply is replaced by a SLURM_SUCCESS return code.
+ */
+static void _merge_step_stats(slurm_msg_t *msg, job_step_stat_t *resp)
+{
+	ListIterator itr;
+	ret_data_info_t *ret_data_info;
+	job_step_stat_t *stat;
+	return_code_msg_t *rc_msg;
+	hostlist_t hl;
+	uint32_t *pids;
+
+	forward_wait(msg);
+	if (!msg->ret_list || !list_count(msg->ret_list))
+		return;
+
+	hl = hostlist_create(resp->step_pids->node_name);
+	itr = list_iterator_create(msg->ret_list);
+	while ((ret_data_info = list_next(itr))) {
+		if (ret_data_info->type != RESPONSE_JOB_STEP_STAT)
+			continue;
+		stat = ret_data_info->data;
+		if (!stat || !stat->step_pids || !stat->step_pids->node_name)
+			continue;
+		if (!stat->jobacct != !resp->jobacct)
+			continue;
+		if (stat->jobacct) {
+			if (stat->jobacct->tres_count !=
+			    resp->jobacct->tres_count)
+				continue;
+			jobacctinfo_aggregate(resp->jobacct, stat->jobacct);
+		}
+
+		hostlist_push(hl, stat->step_pids->node_name);
+		resp->num_tasks += stat->num_tasks;
+		if (stat->step_pids->pid_cnt) {
+			pids = xrealloc(resp->step_pids->pid,
+					sizeof(uint32_t) *
+					(resp->step_pids->pid_cnt +
+					 stat->step_pids->pid_cnt));
+			memcpy(pids + resp->step_pids->pid_cnt,
+			       stat->step_pids->pid,
+			       sizeof(uint32_t) * stat->step_pids->pid_cnt);
+			resp->step_pids->pid = pids;
+			resp->step_pids->pid_cnt += stat->step_pids->pid_cnt;
+		}
+
+		slurm_free_job_step_stat(stat);
+		rc_msg = xmalloc(sizeof(return_code_msg_t));
+		rc_msg->return_code = SLURM_SUCCESS;
+		ret_data_info->type = RESPONSE_SLURM_RC;
+		ret_data_info->data = rc_msg;
+	}
+	list_iterator_destroy(itr);
+
+	xfree(resp->step_pids->node_name);
+	resp->step_pids->node_name = hostlist_ranged_string_xmalloc(hl);
+	hostlist_destroy(hl);
+}
+
 static void _rpc_stat_jobacct(slurm_msg_t *msg)
 {
 	slurm_step_id_t *req = (slurm_step_id_t *)msg->data;
@@ -3473,6 +3542,9 @@ static void _rpc_stat_jobacct(slurm_msg_t *msg)
 
 	close(fd);
 
+	if (msg->flags & SLURM_AGGREGATE_REPLY)
+		_merge_step_stats(&resp_msg, resp);
+
 	resp_msg.msg_type     = RESPONSE_JOB_STEP_STAT;
 	resp_msg.data         = resp;
 
@@ -3884,6 +3956,309 @@ static void _file_bcast_close_file(file_bcast_info_t *key)
 	_fb_wrunlock();
 }
 
+/*
+ * Size limit in bytes of the node's cache of broadcast files, from
+ * SbcastParameters=CacheSize=<MB>. Zero if caching is disabled.
+ */
+static uint64_t _sbcast_cache_limit(void)
+{
+	char *tmp;
+
+	if (!(tmp = xstrcasestr(slurm_conf.sbcast_parameters, "CacheSize=")))
+		return 0;
+
+	return (strtoull(tmp + 10, NULL, 10) * 1024 * 1024);
+}
+
+/*
+ * Path of the cache entry for a file. Entries are private to each user so
+ * nobody can have their file replaced by another user's content.
+ * RET path to be xfree()'d
+ */
+static char *_sbcast_cache_path(uid_t uid, uint64_t file_hash,
+				uint64_t file_size, uint32_t job_id)
+{
+	char *path = NULL;
+
+	xstrfmtcat(path, "%s/%s/%u.%016"PRIx64".%"PRIu64,
+		   conf->spooldir, SBCAST_CACHE_DIR, uid, file_hash,
+		   file_size);
+	if (job_id)
+		xstrfmtcat(path, ".%u.tmp", job_id);
+
+	return path;
+}
+
+typedef struct {
+	char *path;
+	off_t size;
+	time_t mtime;
+} sbcast_cache_ent_t;
+
+static int _sbcast_cache_ent_cmp(const void *a, const void *b)
+{
+	const sbcast_cache_ent_t *ent_a = a, *ent_b = b;
+
+	if (ent_a->mtime < ent_b->mtime)
+		return -1;
+	return (ent_a->mtime > ent_b->mtime);
+}
+
+/* Remove the least recently used cache entries beyond the size limit */
+static void _sbcast_cache_trim(void)
+{
+	static pthread_mutex_t trim_mutex = PTHREAD_MUTEX_INITIALIZER;
+	uint64_t limit = _sbcast_cache_limit(), total = 0;
+	sbcast_cache_ent_t *ents = NULL;
+	int ent_cnt = 0, ent_max = 0, i;
+	char *dir = NULL;
+	struct dirent *de;
+	struct stat st;
+	DIR *dp;
+
+	xstrfmtcat(dir, "%s/%s", conf->spooldir, SBCAST_CACHE_DIR);
+	slurm_mutex_lock(&trim_mutex);
+	if (!(dp = opendir(dir))) {
+		slurm_mutex_unlock(&trim_mutex);
+		xfree(dir);
+		return;
+	}
+	while ((de = readdir(dp))) {
+		if ((de->d_name[0] == '.') || xstrstr(de->d_name, ".tmp"))
+			continue;
+		if (ent_cnt == ent_max) {
+			ent_max = MAX(64, ent_max * 2);
+			xrecalloc(ents, ent_max, sizeof(*ents));
+		}
+		ents[ent_cnt].path = xstrdup_printf("%s/%s", dir, de->d_name);
+		if (stat(ents[ent_cnt].path, &st)) {
+			xfree(ents[ent_cnt].path);
+			continue;
+		}
+		ents[ent_cnt].size = st.st_size;
+		ents[ent_cnt].mtime = st.st_mtime;
+		total += st.st_size;
+		ent_cnt++;
+	}
+	closedir(dp);
+
+	if (total > limit)
+		qsort(ents, ent_cnt, sizeof(*ents), _sbcast_cache_ent_cmp);
+	for (i = 0; i < ent_cnt; i++) {
+		if ((total > limit) && !unlink(ents[i].path)) {
+			debug("sbcast: evicted %s from cache", ents[i].path);
+			total -= ents[i].size;
+		}
+		xfree(ents[i].path);
+	}
+	slurm_mutex_unlock(&trim_mutex);
+
+	xfree(ents);
+	xfree(dir);
+}
+
+/*
+ * Open a temporary cache entry that the blocks of a file being broadcast
+ * are also written to. It is renamed to its final name by
+ * _sbcast_cache_commit() once the last block is received.
+ */
+static void _sbcast_cache_open(file_bcast_info_t *file_info)
+{
+	char *dir = NULL;
+
+	file_info->cache_fd = -1;
+	if (!file_info->file_hash || !file_info->file_size ||
+	    (file_info->file_size > _sbcast_cache_limit()))
+		return;
+
+	xstrfmtcat(dir, "%s/%s", conf->spooldir, SBCAST_CACHE_DIR);
+	if (mkdir(dir, 0700) && (errno != EEXIST)) {
+		error("sbcast: unable to create %s: %m", dir);
+		xfree(dir);
+		return;
+	}
+	xfree(dir);
+
+	file_info->cache_tmp = _sbcast_cache_path(file_info->uid,
+						  file_info->file_hash,
+						  file_info->file_size,
+						  file_info->job_id);
+	file_info->cache_fd = open(file_info->cache_tmp,
+				   (O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC),
+				   0600);
+	if (file_info->cache_fd < 0) {
+		error("sbcast: unable to open %s: %m", file_info->cache_tmp);
+		xfree(file_info->cache_tmp);
+	}
+}
+
+/* Stop caching a file, discarding what was written so far */
+static void _sbcast_cache_abort(file_bcast_info_t *file_info)
+{
+	if (file_info->cache_fd < 0)
+		return;
+
+	close(file_info->cache_fd);
+	file_info->cache_fd = -1;
+	(void) unlink(file_info->cache_tmp);
+	xfree(file_info->cache_tmp);
+}
+
+/* Make a completely received file available to later broadcasts */
+static void _sbcast_cache_commit(file_bcast_info_t *file_info)
+{
+	char *path;
+
+	if (file_info->cache_fd < 0)
+		return;
+
+	if (file_info->cache_error) {
+		_sbcast_cache_abort(file_info);
+		return;
+	}
+
+	if (close(file_info->cache_fd)) {
+		error("sbcast: unable to close %s: %m", file_info->cache_tmp);
+		file_info->cache_fd = -1;
+		(void) unlink(file_info->cache_tmp);
+		xfree(file_info->cache_tmp);
+		return;
+	}
+	file_info->cache_fd = -1;
+
+	path = _sbcast_cache_path(file_info->uid, file_info->file_hash,
+				  file_info->file_size, 0);
+	if (rename(file_info->cache_tmp, path)) {
+		error("sbcast: unable to rename %s: %m", file_info->cache_tmp);
+		(void) unlink(file_info->cache_tmp);
+	} else
+		debug("sbcast: cached %s as %s", file_info->fname, path);
+	xfree(file_info->cache_tmp);
+	xfree(path);
+}
+
+/* Apply the final owner, modes and times of a broadcast file */
+static void _file_bcast_set_attrs(int fd, file_bcast_msg_t *req,
+				  file_bcast_info_t *key)
+{
+	if (fchmod(fd, (req->modes & 0777))) {
+		error("sbcast: uid:%u can't chmod `%s`: %m",
+		      key->uid, key->fname);
+	}
+	if (fchown(fd, key->uid, key->gid)) {
+		error("sbcast: uid:%u gid:%u can't chown `%s`: %m",
+		      key->uid, key->gid, key->fname);
+	}
+	if (req->atime) {
+		struct utimbuf time_buf;
+		time_buf.actime  = req->atime;
+		time_buf.modtime = req->mtime;
+		if (utime(key->fname, &time_buf)) {
+			error("sbcast: uid:%u can't utime `%s`: %m",
+			      key->uid, key->fname);
+		}
+	}
+}
+
+/* Open the destination file of a broadcast as the user */
+static int _file_bcast_open(slurm_msg_t *msg, sbcast_cred_arg_t *cred_arg,
+			    file_bcast_info_t *key, int *fd)
+{
+	file_bcast_msg_t *req = msg->data;
+	int flags, rc;
+
+	/* may still be unset in credential */
+	if (!cred_arg->ngids || !cred_arg->gids)
+		cred_arg->ngids = group_cache_lookup(key->uid, key->gid,
+						     cred_arg->user_name,
+						     &cred_arg->gids);
+
+	flags = O_WRONLY | O_CREAT;
+	if (req->force)
+		flags |= O_TRUNC;
+	else
+		flags |= O_EXCL;
+
+	rc = _open_as_other(req->fname, flags, 0700, key->job_id, key->uid,
+			    key->gid, cred_arg->ngids, cred_arg->gids, fd);
+	if (rc != SLURM_SUCCESS)
+		error("Unable to open %s: %s", req->fname, strerror(rc));
+
+	return rc;
+}
+
+/*
+ * Create the destination file of a broadcast from the node's cache.
+ * RET true if the file was in the cache, with *rc set to the result
+ */
+static bool _file_bcast_from_cache(slurm_msg_t *msg,
+				   sbcast_cred_arg_t *cred_arg,
+				   file_bcast_info_t *key, int *rc)
+{
+	file_bcast_msg_t *req = msg->data;
+	char *path, *buf;
+	int in_fd, out_fd;
+	ssize_t len, offset, inx;
+	struct stat st;
+
+	path = _sbcast_cache_path(key->uid, req->file_hash, req->file_size, 0);
+	if ((in_fd = open(path, (O_RDONLY | O_CLOEXEC))) < 0) {
+		xfree(path);
+		return false;
+	}
+	if (fstat(in_fd, &st) || (st.st_size != req->file_size)) {
+		close(in_fd);
+		xfree(path);
+		return false;
+	}
+	/* record the use for least recently used eviction */
+	(void) utime(path, NULL);
+
+	if ((*rc = _file_bcast_open(msg, cred_arg, key, &out_fd))) {
+		close(in_fd);
+		xfree(path);
+		return true;
+	}
+
+	buf = xmalloc(SBCAST_CACHE_BUF_SIZE);
+	while ((len = read(in_fd, buf, SBCAST_CACHE_BUF_SIZE))) {
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			error("sbcast: can't read `%s`: %m", path);
+			*rc = SLURM_ERROR;
+			break;
+		}
+		for (offset = 0; offset < len; offset += inx) {
+			inx = write(out_fd, buf + offset, len - offset);
+			if (inx < 0) {
+				if ((errno == EINTR) || (errno == EAGAIN)) {
+					inx = 0;
+					continue;
+				}
+				error("sbcast: uid:%u can't write `%s`: %m",
+				      key->uid, key->fname);
+				*rc = SLURM_ERROR;
+				break;
+			}
+		}
+		if (*rc)
+			break;
+	}
+	xfree(buf);
+
+	if (!*rc) {
+		_file_bcast_set_attrs(out_fd, req, key);
+		info("sbcast: uid:%u job_id:%u created `%s` from cache",
+		     key->uid, key->job_id, key->fname);
+	}
+	close(out_fd);
+	close(in_fd);
+	xfree(path);
+
+	return true;
+}
+
 static void _free_file_bcast_info_t(void *arg)
 {
 	file_bcast_info_t *f = (file_bcast_info_t *)arg;
@@ -3894,6 +4269,7 @@ static void _free_file_bcast_info_t(void *arg)
 	xfree(f->fname);
 	if (f->fd)
 		close(f->fd);
+	_sbcast_cache_abort(f);
 	xfree(f);
 }
 
@@ -3995,6 +4371,18 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		      key.uid, key.job_id, key.fname, req->block_no);
 	}
 
+	/*
+	 * A first block carrying the file's hash asks whether the node can
+	 * create the file from its cache. If not, the file is registered as
+	 * usual and ESLURMD_SBCAST_CACHE_MISS tells sbcast to send the data.
+	 */
+	if ((req->block_no == 1) && req->file_hash && !req->last_block &&
+	    _sbcast_cache_limit() &&
+	    _file_bcast_from_cache(msg, cred_arg, &key, &rc)) {
+		sbcast_cred_arg_free(cred_arg);
+		goto done;
+	}
+
 	/* first block must register the file and open fd/mmap */
 	if (req->block_no == 1) {
 		if ((rc = _file_bcast_register_file(msg, cred_arg, &key))) {
@@ -4022,10 +4410,15 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		goto done;
 	}
 
+	/*
+	 * sbcast sends several blocks at once, so write each one at its
+	 * offset rather than in the order they arrive.
+	 */
 	offset = 0;
 	while (req->block_len - offset) {
-		inx = write(file_info->fd, &req->block[offset],
-			    (req->block_len - offset));
+		inx = pwrite(file_info->fd, &req->block[offset],
+			     (req->block_len - offset),
+			     (req->block_offset + offset));
 		if (inx == -1) {
 			if ((errno == EINTR) || (errno == EAGAIN))
 				continue;
@@ -4038,31 +4431,43 @@ static void _rpc_file_bcast(slurm_msg_t *msg)
 		offset += inx;
 	}
 
+	/*
+	 * Keep a copy for later broadcasts of the same file. Other blocks may
+	 * be written concurrently, so a failure only flags the entry to be
+	 * discarded with the last block.
+	 */
+	offset = 0;
+	while ((file_info->cache_fd >= 0) && !file_info->cache_error &&
+	       (req->block_len - offset)) {
+		inx = pwrite(file_info->cache_fd, &req->block[offset],
+			     (req->block_len - offset),
+			     (req->block_offset + offset));
+		if (inx == -1) {
+			if ((errno == EINTR) || (errno == EAGAIN))
+				continue;
+			error("sbcast: can't write `%s`: %m",
+			      file_info->cache_tmp);
+			file_info->cache_error = true;
+			break;
+		}
+		offset += inx;
+	}
+
 	file_info->last_update = time(NULL);
 
-	if (req->last_block && fchmod(file_info->fd, (req->modes & 0777))) {
-		error("sbcast: uid:%u can't chmod `%s`: %m",
-		      key.uid, key.fname);
-	}
-	if (req->last_block && fchown(file_info->fd, key.uid, key.gid)) {
-		error("sbcast: uid:%u gid:%u can't chown `%s`: %m",
-		      key.uid, key.gid, key.fname);
-	}
-	if (req->last_block && req->atime) {
-		struct utimbuf time_buf;
-		time_buf.actime  = req->atime;
-		time_buf.modtime = req->mtime;
-		if (utime(key.fname, &time_buf)) {
-			error("sbcast: uid:%u can't utime `%s`: %m",
-			      key.uid, key.fname);
-		}
+	if (req->last_block) {
+		_file_bcast_set_attrs(file_info->fd, req, &key);
+		_sbcast_cache_commit(file_info);
 	}
 
 	_fb_rdunlock();
 
 	if (req->last_block) {
 		_file_bcast_close_file(&key);
-	}
+		if (req->file_hash && _sbcast_cache_limit())
+			_sbcast_cache_trim();
+	} else if ((req->block_no == 1) && req->file_hash)
+		rc = ESLURMD_SBCAST_CACHE_MISS;
 
 done:
 	slurm_send_rc_msg(msg, rc);
@@ -4073,27 +4478,11 @@ static int _file_bcast_register_file(slurm_msg_t *msg,
 				     file_bcast_info_t *key)
 {
 	file_bcast_msg_t *req = msg->data;
-	int fd, flags, rc;
+	int fd, rc;
 	file_bcast_info_t *file_info;
 
-	/* may still be unset in credential */
-	if (!cred_arg->ngids || !cred_arg->gids)
-		cred_arg->ngids = group_cache_lookup(key->uid, key->gid,
-						     cred_arg->user_name,
-						     &cred_arg->gids);
-
-	flags = O_WRONLY | O_CREAT;
-	if (req->force)
-		flags |= O_TRUNC;
-	else
-		flags |= O_EXCL;
-
-	rc = _open_as_other(req->fname, flags, 0700, key->job_id, key->uid,
-			    key->gid, cred_arg->ngids, cred_arg->gids, &fd);
-	if (rc != SLURM_SUCCESS) {
-		error("Unable to open %s: %s", req->fname, strerror(rc));
+	if ((rc = _file_bcast_open(msg, cred_arg, key, &fd)))
 		return rc;
-	}
 
 	file_info = xmalloc(sizeof(file_bcast_info_t));
 	file_info->fd = fd;
@@ -4102,6 +4491,9 @@ static int _file_bcast_register_file(slurm_msg_t *msg,
 	file_info->gid = key->gid;
 	file_info->job_id = key->job_id;
 	file_info->last_update = file_info->start_time = time(NULL);
+	file_info->file_hash = req->file_hash;
+	file_info->file_size = req->file_size;
+	_sbcast_cache_open(file_info);
 
 	//TODO: mmap the file here
 	_fb_wrlock();
@@ -5669,10 +6061,12 @@ static void _add_job_running_prolog(uint32_t job_id)
 /* Remove this job from the list of jobs currently running their prolog */
 static void _remove_job_running_prolog(uint32_t job_id)
 {
+	slurm_mutex_lock(&prolog_mutex);
 	if (!list_delete_all(conf->prolog_running_jobs,
 			     _match_jobid, &job_id))
 		error("_remove_job_running_prolog: job not found");
 	slurm_cond_broadcast(&conf->prolog_running_cond);
+	slurm_mutex_unlock(&prolog_mutex);
 }
 
 static int _match_jobid(void *listentry, void *key)
@@ -5693,26 +6087,30 @@ static int _prolog_is_running (uint32_t jobid)
 	return (rc);
 }
 
-/* Wait for the job's prolog to complete */
+/*
+ * Wait for the job's prolog to complete
+ * NOTE: prolog_mutex must not be held by the caller. It is the mutex used with
+ * conf->prolog_running_cond, so the wake up from _remove_job_running_prolog()
+ * can not be missed between testing the list and waiting.
+ */
 static void _wait_for_job_running_prolog(uint32_t job_id)
 {
-	static pthread_mutex_t dummy_lock = PTHREAD_MUTEX_INITIALIZER;
 	struct timespec ts = {0, 0};
 	struct timeval now;
 
 	debug("Waiting for job %d's prolog to complete", job_id);
 
+	slurm_mutex_lock(&prolog_mutex);
 	while (_prolog_is_running (job_id)) {
 
 		gettimeofday(&now, NULL);
 		ts.tv_sec = now.tv_sec+1;
 		ts.tv_nsec = now.tv_usec * 1000;
 
-		slurm_mutex_lock(&dummy_lock);
 		slurm_cond_timedwait(&conf->prolog_running_cond,
-				     &dummy_lock, &ts);
-		slurm_mutex_unlock(&dummy_lock);
+				     &prolog_mutex, &ts);
 	}
+	slurm_mutex_unlock(&prolog_mutex);
 
 	debug("Finished wait for job %d's prolog to complete", job_id);
 }
@@ -121,6 +121,8 @@
 #include "src/slurmd/slurmd/slurmd.h"
 
 #define MAX_THREADS		256
+#define RPC_WORKER_IDLE_TIMEOUT 60 /* Seconds an idle RPC worker thread
+				    * waits for a connection before exiting */
 
 #define _free_and_set(__dst, __src)		\
 	do {					\
@@ -152,6 +154,14 @@ typedef struct connection {
 	slurm_addr_t *cli_addr;
 } conn_t;
 
+/*
+ * Connections waiting for an idle RPC worker thread
+ */
+static List            rpc_worker_conns = NULL;
+static int             rpc_worker_idle = 0;
+static pthread_mutex_t rpc_worker_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  rpc_worker_cond = PTHREAD_COND_INITIALIZER;
+
 /*
  * Global data for resource specialization
  */
@@ -199,6 +209,7 @@ static void      _process_cmdline(int ac, char **av);
 static void      _read_config(void);
 static void      _reconfigure(void);
 static void     *_registration_engine(void *arg);
+static void     *_rpc_worker(void *arg);
 static void      _resource_spec_fini(void);
 static int       _resource_spec_init(void);
 static int       _restore_cred_state(slurm_cred_ctx_t ctx);
@@ -448,6 +459,7 @@ _msg_engine(void)
 
 	msg_pthread = pthread_self();
 	slurmd_req(NULL);	/* initialize timer */
+	rpc_worker_conns = list_create(NULL);
 	while (!_shutdown) {
 		if (_reconfig) {
 			int rpc_wait = MAX(5, slurm_conf.msg_timeout / 2);
@@ -484,6 +496,11 @@ _msg_engine(void)
 	}
 	verbose("got shutdown request");
 	close(conf->lfd);
+
+	/* Let idle workers see the shutdown and exit */
+	slurm_mutex_lock(&rpc_worker_lock);
+	slurm_cond_broadcast(&rpc_worker_cond);
+	slurm_mutex_unlock(&rpc_worker_lock);
 	return;
 }
 
@@ -553,7 +570,50 @@ static void _handle_connection(int fd, slurm_addr_t *cli)
 	fd_set_close_on_exec(fd);
 
 	_increment_thd_count();
-	slurm_thread_create_detached(NULL, _service_connection, arg);
+
+	/* Hand the connection to an idle worker or start a new one */
+	slurm_mutex_lock(&rpc_worker_lock);
+	if (rpc_worker_idle > list_count(rpc_worker_conns)) {
+		list_append(rpc_worker_conns, arg);
+		slurm_cond_signal(&rpc_worker_cond);
+		arg = NULL;
+	}
+	slurm_mutex_unlock(&rpc_worker_lock);
+
+	if (arg)
+		slurm_thread_create_detached(NULL, _rpc_worker, arg);
+}
+
+/*
+ * Service connections handed over by _handle_connection(). Rather than one
+ * thread per connection, a worker waits for another connection once done
+ * and exits after RPC_WORKER_IDLE_TIMEOUT of idleness.
+ */
+static void *_rpc_worker(void *arg)
+{
+	conn_t *con = arg;
+
+	while (con) {
+		struct timespec ts = {0, 0};
+
+		_service_connection(con);
+
+		slurm_mutex_lock(&rpc_worker_lock);
+		rpc_worker_idle++;
+		ts.tv_sec = time(NULL) + RPC_WORKER_IDLE_TIMEOUT;
+		while (!(con = list_pop(rpc_worker_conns)) && !_shutdown) {
+			slurm_cond_timedwait(&rpc_worker_cond,
+					     &rpc_worker_lock, &ts);
+			if (time(NULL) >= ts.tv_sec) {
+				con = list_pop(rpc_worker_conns);
+				break;
+			}
+		}
+		rpc_worker_idle--;
+		slurm_mutex_unlock(&rpc_worker_lock);
+	}
+
+	return NULL;
 }
 
 static void *
@@ -1944,6 +2004,7 @@ _slurmd_fini(void)
 	fini_system_cgroup();
 	cgroup_g_fini();
 	route_fini();
+	forward_fini();
 	xcpuinfo_fini();
 	slurm_mutex_lock(&fini_job_mutex);
 	xfree(fini_job_id);
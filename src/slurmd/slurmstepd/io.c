@@ -56,6 +56,7 @@
 #include <sys/socket.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <termios.h>
 #include <unistd.h>
 
@@ -78,6 +79,15 @@
 #include "src/slurmd/slurmstepd/io.h"
 #include "src/slurmd/slurmstepd/slurmstepd.h"
 
+/*
+ * Maximum bytes of a task's stdout or stderr read ahead into its cbuf.
+ * Reading a pipe's worth at a time packs several messages per poll() cycle.
+ */
+#define STDIO_MAX_TASK_BUF (MAX_MSG_LEN * 16)
+
+/* Maximum number of queued messages written to a client in one writev() */
+#define STDIO_MAX_CLIENT_IOV 16
+
 /**********************************************************************
  * IO client socket declarations
  **********************************************************************/
@@ -118,6 +128,10 @@ struct client_io_info {
 
 	/* true if writing to a file, false if writing to a socket */
 	bool is_local_file;
+
+	/* true to send output as SLURM_IO_MULTI messages when possible */
+	bool coalesce;
+	struct io_buf *multi_msg;
 };
 
 
@@ -422,14 +436,89 @@ _client_read(eio_obj_t *obj, List objs)
 }
 
 /*
- * Write outgoing packed messages to the client socket.
+ * Coalesce the output messages at the head of a client's queue into one
+ * SLURM_IO_MULTI message, releasing their buffers. Only non-empty messages
+ * of the same stream are combined, up to MAX_MSG_LEN bytes in all.
+ * Returns NULL if fewer than two messages could be combined.
+ */
+static struct io_buf *_build_multi_message(struct client_io_info *client)
+{
+	struct io_buf *msg, *first = NULL;
+	struct slurm_io_header header;
+	ListIterator msgs;
+	buf_t *packbuf;
+	uint32_t length = 0;
+	int cnt = 0;
+	char *ptr;
+
+	msgs = list_iterator_create(client->msg_queue);
+	while ((msg = list_next(msgs))) {
+		if (!first)
+			first = msg;
+		if (((msg->header.type != SLURM_IO_STDOUT) &&
+		     (msg->header.type != SLURM_IO_STDERR)) ||
+		    (msg->header.type != first->header.type) ||
+		    !msg->header.length ||
+		    ((length + msg->length) > MAX_MSG_LEN))
+			break;
+		length += msg->length;
+		cnt++;
+	}
+	list_iterator_destroy(msgs);
+
+	if (cnt < 2)
+		return NULL;
+
+	if (!client->multi_msg)
+		client->multi_msg = alloc_io_buf();
+
+	/*
+	 * Messages routed while releasing these are only ever added to the
+	 * tail of the queue.
+	 */
+	ptr = (char *) client->multi_msg->data + io_hdr_packed_size();
+	while (cnt--) {
+		msg = list_dequeue(client->msg_queue);
+		memcpy(ptr, msg->data, msg->length);
+		ptr += msg->length;
+		_free_outgoing_msg(msg, client->job);
+	}
+
+	header.type = SLURM_IO_MULTI;
+	header.ltaskid = 0;  /* Unused */
+	header.gtaskid = 0;  /* Unused */
+	header.length = length;
+
+	packbuf = create_buf(client->multi_msg->data, io_hdr_packed_size());
+	if (!packbuf) {
+		fatal("Failure to allocate memory for a message header");
+		return NULL;	/* Fix for CLANG false positive error */
+	}
+	io_hdr_pack(&header, packbuf);
+	client->multi_msg->length = io_hdr_packed_size() + header.length;
+	client->multi_msg->header = header;
+
+	/* free packbuf, but not the memory to which it points */
+	packbuf->head = NULL;	/* CLANG false positive bug here */
+	free_buf(packbuf);
+
+	return client->multi_msg;
+}
+
+/*
+ * Write outgoing packed messages to the client socket. The rest of the
+ * current message and the messages queued behind it are gathered into a
+ * single writev() call.
  */
 static int
 _client_write(eio_obj_t *obj, List objs)
 {
 	struct client_io_info *client = (struct client_io_info *) obj->arg;
-	void *buf;
-	int n;
+	struct iovec iov[STDIO_MAX_CLIENT_IOV];
+	struct io_buf *msg;
+	ListIterator msgs;
+	int i, iovcnt;
+	ssize_t n;
 
 	xassert(client->magic == CLIENT_IO_MAGIC);
 
@@ -440,7 +529,10 @@ _client_write(eio_obj_t *obj, List objs)
 	 * next message from the queue.
 	 */
 	if (client->out_msg == NULL) {
-		client->out_msg = list_dequeue(client->msg_queue);
+		if (client->coalesce)
+			client->out_msg = _build_multi_message(client);
+		if (client->out_msg == NULL)
+			client->out_msg = list_dequeue(client->msg_queue);
 		if (client->out_msg == NULL) {
 			debug5("_client_write: nothing in the queue");
 			return SLURM_SUCCESS;
@@ -453,12 +545,25 @@ _client_write(eio_obj_t *obj, List objs)
 	debug5("  client->out_remaining = %d", client->out_remaining);
 
 	/*
-	 * Write message to socket.
+	 * Write messages to socket.
 	 */
-	buf = client->out_msg->data +
+	iov[0].iov_base = client->out_msg->data +
 		(client->out_msg->length - client->out_remaining);
+	iov[0].iov_len = client->out_remaining;
+	iovcnt = 1;
+	/* Leave queued messages to be coalesced into the next multi message */
+	if (client->out_msg != client->multi_msg) {
+		msgs = list_iterator_create(client->msg_queue);
+		while ((iovcnt < STDIO_MAX_CLIENT_IOV) &&
+		       (msg = list_next(msgs))) {
+			iov[iovcnt].iov_base = msg->data;
+			iov[iovcnt].iov_len = msg->length;
+			iovcnt++;
+		}
+		list_iterator_destroy(msgs);
+	}
 again:
-	if ((n = write(obj->fd, buf, client->out_remaining)) < 0) {
+	if ((n = writev(obj->fd, iov, iovcnt)) < 0) {
 		if (errno == EINTR) {
 			goto again;
 		} else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
@@ -470,17 +575,27 @@ again:
 			return SLURM_SUCCESS;
 		}
 	}
-	if (n < client->out_remaining) {
-		error("Only wrote %d of %d bytes to socket",
-		      n, client->out_remaining);
-	} else
-		debug5("Wrote %d bytes to socket", n);
-	client->out_remaining -= n;
-	if (client->out_remaining > 0)
-		return SLURM_SUCCESS;
+	debug5("Wrote %zd bytes in %d messages to socket", n, iovcnt);
 
-	_free_outgoing_msg(client->out_msg, client->job);
-	client->out_msg = NULL;
+	/*
+	 * Release the messages written in full. The ones gathered from the
+	 * queue are still at its head since messages are only ever added to
+	 * the tail.
+	 */
+	for (i = 0; i < iovcnt; i++) {
+		if (n < client->out_remaining) {
+			client->out_remaining -= n;
+			break;
+		}
+		n -= client->out_remaining;
+		if (client->out_msg != client->multi_msg)
+			_free_outgoing_msg(client->out_msg, client->job);
+		client->out_msg = NULL;
+		if ((i + 1) == iovcnt)
+			break;
+		client->out_msg = list_dequeue(client->msg_queue);
+		client->out_remaining = client->out_msg->length;
+	}
 
 	return SLURM_SUCCESS;
 }
@@ -708,7 +823,7 @@ _create_task_out_eio(int fd, uint16_t type,
 	out->gtaskid = task->gtid;
 	out->ltaskid = task->id;
 	out->job = job;
-	out->buf = cbuf_create(MAX_MSG_LEN, MAX_MSG_LEN*4);
+	out->buf = cbuf_create(MAX_MSG_LEN, STDIO_MAX_TASK_BUF);
 	out->eof = false;
 	out->eof_msg_sent = false;
 	if (cbuf_opt_set(out->buf, CBUF_OPT_OVERWRITE, CBUF_NO_DROP) == -1)
@@ -731,8 +846,8 @@ _task_readable(eio_obj_t *obj)
 		debug5("  false, eof message sent");
 		return false;
 	}
-	if (cbuf_free(out->buf) > 0) {
-		debug5("  cbuf_free = %d", cbuf_free(out->buf));
+	if (cbuf_used(out->buf) < STDIO_MAX_TASK_BUF) {
+		debug5("  cbuf_used = %d", cbuf_used(out->buf));
 		return true;
 	}
 
@@ -755,7 +870,8 @@ _task_read(eio_obj_t *obj, List objs)
 	xassert(out->magic == TASK_OUT_MAGIC);
 
 	debug4("Entering _task_read for obj %zx", (size_t)obj);
-	len = cbuf_free(out->buf);
+	/* The cbuf grows up to STDIO_MAX_TASK_BUF as needed */
+	len = STDIO_MAX_TASK_BUF - cbuf_used(out->buf);
 	if (len > 0 && !out->eof) {
 again:
 		if ((rc = cbuf_write_from_fd(out->buf, obj->fd, len, NULL))
@@ -1262,6 +1378,7 @@ _build_connection_okay_message(stepd_step_rec_t *job)
 	}
 	io_hdr_pack(&header, packbuf);
 	msg->length = io_hdr_packed_size();
+	msg->header = header;
 	msg->ref_count = 0; /* make certain it is initialized */
 
 	/* free packbuf, but not the memory to which it points */
@@ -1523,6 +1640,16 @@ io_create_local_client(const char *filename, int file_flags,
 	return SLURM_SUCCESS;
 }
 
+/*
+ * Coalesce output sent to this client into SLURM_IO_MULTI messages if
+ * requested and the client understands them.
+ */
+static bool _client_coalesce(srun_info_t *srun)
+{
+	return (xstrcasestr(slurm_conf.launch_params, "coalesce_io") &&
+		(srun->protocol_version >= SLURM_21_08_PROTOCOL_VERSION));
+}
+
 /*
  * Create the initial TCP connection back to a waiting client (e.g. srun).
  *
@@ -1577,6 +1704,7 @@ io_initial_client_connect(srun_info_t *srun, stepd_step_rec_t *job,
 	client->labelio = false;
 	client->taskid_width = 0;
 	client->is_local_file = false;
+	client->coalesce = _client_coalesce(srun);
 
 	obj = eio_obj_create(sock, &client_ops, (void *)client);
 	list_append(job->clients, (void *)obj);
@@ -1631,6 +1759,7 @@ io_client_connect(srun_info_t *srun, stepd_step_rec_t *job)
 	client->labelio = false;
 	client->taskid_width = 0;
 	client->is_local_file = false;
+	client->coalesce = _client_coalesce(srun);
 
 	/* client object adds itself to job->clients in _client_writable */
 
@@ -1742,6 +1871,7 @@ _send_eof_msg(struct task_read_info *out)
 
 	io_hdr_pack(&header, packbuf);
 	msg->length = io_hdr_packed_size() + header.length;
+	msg->header = header;
 	msg->ref_count = 0; /* make certain it is initialized */
 
 	/* free packbuf, but not the memory to which it points */
@@ -1833,6 +1963,7 @@ static struct io_buf *_task_build_message(struct task_read_info *out,
 	}
 	io_hdr_pack(&header, packbuf);
 	msg->length = io_hdr_packed_size() + header.length;
+	msg->header = header;
 	msg->ref_count = 0; /* make certain it is initialized */
 
 	/* free packbuf, but not the memory to which it points */
@@ -40,6 +40,7 @@
 #define _IO_H
 
 #include "src/common/eio.h"
+#include "src/common/io_hdr.h"
 
 #include "src/slurmd/slurmstepd/slurmstepd_job.h"
 
@@ -54,6 +55,7 @@ struct io_buf {
 	int ref_count;
 	uint32_t length;
 	void *data;
+	io_hdr_t header;
 };
 
 /* For each task's ofname and efname, are all the names NULL,
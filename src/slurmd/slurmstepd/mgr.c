@@ -174,8 +174,10 @@ static int  _reclaim_privileges(struct priv_state *state);
 static void _send_launch_resp(stepd_step_rec_t *job, int rc);
 static int  _slurmd_job_log_init(stepd_step_rec_t *job);
 static void _wait_for_io(stepd_step_rec_t *job);
+static bool _defer_exit_msgs(stepd_step_rec_t *job);
 static int  _send_exit_msg(stepd_step_rec_t *job, uint32_t *tid, int n,
 			   int status);
+static void _send_tree_exit_msg(stepd_step_rec_t *job);
 static void _set_job_state(stepd_step_rec_t *job, slurmstepd_state_t new_state);
 static void _wait_for_all_tasks(stepd_step_rec_t *job);
 static int  _wait_for_any_task(stepd_step_rec_t *job, bool waitflag);
@@ -621,16 +623,13 @@ _send_exit_msg(stepd_step_rec_t *job, uint32_t *tid, int n, int status)
 	ListIterator    i       = NULL;
 	srun_info_t    *srun    = NULL;
 
-	debug3("sending task exit msg for %d tasks status %d oom %d",
-	       n, status, job->oom_error);
+	debug3("sending task exit msg for %d tasks status %d",
+	       n, status);
 
 	memset(&msg, 0, sizeof(msg));
 	msg.task_id_list	= tid;
 	msg.num_tasks		= n;
-	if (job->oom_error)
-		msg.return_code = SIG_OOM;
-	else
-		msg.return_code = status;
+	msg.return_code		= status;
 
 	memcpy(&msg.step_id, &job->step_id, sizeof(msg.step_id));
 
@@ -638,13 +637,6 @@ _send_exit_msg(stepd_step_rec_t *job, uint32_t *tid, int n, int status)
 	resp.data		= &msg;
 	resp.msg_type		= MESSAGE_TASK_EXIT;
 
-	/*
-	 *  Hack for TCP timeouts on exit of large, synchronized job
-	 *  termination. Delay a random amount if job->nnodes > 500
-	 */
-	if (job->nnodes > 500)
-		_random_sleep(job);
-
 	/*
 	 * Notify each srun and sattach.
 	 * No message for poe or batch jobs
@@ -742,6 +734,7 @@ _one_step_complete_msg(stepd_step_rec_t *job, int first, int last)
 	else
 		msg.step_rc = step_complete.step_rc;
 	msg.jobacct = jobacctinfo_create(NULL);
+	msg.task_exit_ok = step_complete.task_exit_ok;
 	/************* acct stuff ********************/
 	if (!acct_sent) {
 		/*
@@ -777,8 +770,11 @@ _one_step_complete_msg(stepd_step_rec_t *job, int first, int last)
 			if (i)
 				sleep(1);
 			retcode = slurm_send_recv_rc_msg_only_one(&req, &rc, 0);
-			if ((retcode == 0) && (rc == 0))
+			if ((retcode == 0) && (rc == 0)) {
+				/* The parent now holds these task exits */
+				FREE_NULL_BITMAP(step_complete.task_exit_ok);
 				goto finished;
+			}
 		}
 		/*
 		 * On error AGAIN, send to the slurmctld instead.
@@ -796,6 +792,10 @@ _one_step_complete_msg(stepd_step_rec_t *job, int first, int last)
 		       step_complete.rank, first, last);
 	}
 
+	/* Task exits collected through the tree now go directly to srun */
+	_send_tree_exit_msg(job);
+	msg.task_exit_ok = NULL;
+
 	/* Retry step complete RPC send to slurmctld indefinitely.
 	 * Prevent orphan job step if slurmctld is down */
 	i = 1;
@@ -1367,7 +1367,8 @@ fail2:
 	 * Notify srun of completion AFTER frequency reset to avoid race
 	 * condition starting another job on these CPUs.
 	 */
-	while (stepd_send_pending_exit_msgs(job)) {;}
+	if (!_defer_exit_msgs(job))
+		while (stepd_send_pending_exit_msgs(job)) {;}
 
 	/*
 	 * This just cleans up all of the PAM state in case rc == 0
@@ -1657,6 +1658,7 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 	List exec_wait_list = NULL;
 	uint32_t jobid;
 	uint32_t node_offset = 0, task_offset = 0;
+	pid_t *task_pids = NULL;
 
 	if (job->het_job_node_offset != NO_VAL)
 		node_offset = job->het_job_node_offset;
@@ -1677,6 +1679,8 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 	/*
 	 * Create hwloc xml file here to avoid threading issues later.
 	 * This has to be done after task_g_pre_setuid().
+	 * The topology is also kept so the tasks forked below can duplicate
+	 * it rather than parse the file again.
 	 */
 	xcpuinfo_hwloc_topo_load(NULL, conf->hwloc_xml, false);
 
@@ -1881,6 +1885,7 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 		error ("Unable to return to working directory");
 	}
 
+	task_pids = xcalloc(job->node_tasks, sizeof(pid_t));
 	for (i = 0; i < job->node_tasks; i++) {
 		/*
 		 * Put this task in the step process group
@@ -1899,13 +1904,21 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 			rc = SLURM_ERROR;
 			goto fail2;
 		}
+		task_pids[i] = job->task[i]->pid;
+	}
 
-		if (proctrack_g_add(job, job->task[i]->pid)
-		    == SLURM_ERROR) {
-			error("proctrack_g_add: %m");
-			rc = SLURM_ERROR;
-			goto fail2;
-		}
+	/*
+	 * Add all of the tasks to the container in one go, rather than
+	 * opening and writing the container once per task.
+	 */
+	if (proctrack_g_add_pids(job, task_pids, job->node_tasks)
+	    == SLURM_ERROR) {
+		error("proctrack_g_add_pids: %m");
+		rc = SLURM_ERROR;
+		goto fail2;
+	}
+
+	for (i = 0; i < job->node_tasks; i++) {
 		jobacct_id.nodeid = job->nodeid + node_offset;
 		jobacct_id.taskid = job->task[i]->gtid + task_offset;
 		jobacct_id.job    = job;
@@ -1925,6 +1938,7 @@ _fork_all_tasks(stepd_step_rec_t *job, bool *io_initialized)
 			goto fail2;
 		}
 	}
+	xfree(task_pids);
 //	jobacct_gather_set_proctrack_container_id(job->cont_id);
 #ifdef HAVE_NATIVE_CRAY
 	if (job->het_job_id && (job->het_job_id != NO_VAL))
@@ -1968,6 +1982,7 @@ fail4:
 fail3:
 	_reclaim_privileges (&sprivs);
 fail2:
+	xfree(task_pids);
 	FREE_NULL_LIST(exec_wait_list);
 	io_close_task_fds(job);
 fail1:
@@ -2013,13 +2028,98 @@ extern int stepd_send_pending_exit_msgs(stepd_step_rec_t *job)
 
 	if (nsent) {
 		debug2("Aggregated %d task exit messages", nsent);
-		_send_exit_msg(job, tid, nsent, status);
+		/*
+		 *  Hack for TCP timeouts on exit of large, synchronized job
+		 *  termination. Delay a random amount if job->nnodes > 500
+		 */
+		if (job->nnodes > 500)
+			_random_sleep(job);
+		_send_exit_msg(job, tid, nsent,
+			       job->oom_error ? SIG_OOM : status);
 	}
 	xfree(tid);
 
 	return nsent;
 }
 
+/*
+ * With LaunchParameters=tree_task_exit, a non-root rank of the reverse tree
+ * whose remaining tasks all exited 0 leaves their task exit message to the
+ * root, which sends a single MESSAGE_TASK_EXIT for every such task of the
+ * step. Steps with any other exit status, or with additional clients (e.g.
+ * sattach), send their exit messages directly as before.
+ * RET true if the exit messages were left to the tree
+ */
+static bool _defer_exit_msgs(stepd_step_rec_t *job)
+{
+	int i;
+
+	if (!xstrcasestr(slurm_conf.launch_params, "tree_task_exit") ||
+	    job->batch || job->oom_error || (job->het_job_id != NO_VAL) ||
+	    (list_count(job->sruns) != 1))
+		return false;
+
+	slurm_mutex_lock(&step_complete.lock);
+	if ((step_complete.rank <= 0) || (step_complete.parent_rank == -1)) {
+		slurm_mutex_unlock(&step_complete.lock);
+		return false;
+	}
+	for (i = 0; i < job->node_tasks; i++) {
+		stepd_step_task_info_t *t = job->task[i];
+
+		if (t->esent)
+			continue;
+		if (!t->exited || t->estatus || (t->gtid >= job->ntasks)) {
+			slurm_mutex_unlock(&step_complete.lock);
+			return false;
+		}
+	}
+
+	if (!step_complete.task_exit_ok)
+		step_complete.task_exit_ok = bit_alloc(job->ntasks);
+	for (i = 0; i < job->node_tasks; i++) {
+		stepd_step_task_info_t *t = job->task[i];
+
+		if (t->esent)
+			continue;
+		bit_set(step_complete.task_exit_ok, t->gtid);
+		t->esent = true;
+	}
+	slurm_mutex_unlock(&step_complete.lock);
+
+	debug2("Task exit messages for %u tasks left to rank 0",
+	       job->node_tasks);
+
+	return true;
+}
+
+/*
+ * Send the task exit message for the tasks recorded in
+ * step_complete.task_exit_ok, if any, and clear them
+ * caller is holding step_complete.lock
+ */
+static void _send_tree_exit_msg(stepd_step_rec_t *job)
+{
+	uint32_t *tid;
+	int i, n = 0;
+
+	if (!step_complete.task_exit_ok)
+		return;
+
+	tid = xcalloc(bit_set_count(step_complete.task_exit_ok),
+		      sizeof(uint32_t));
+	for (i = 0; (i = bit_ffs_from_bit(step_complete.task_exit_ok, i)) >= 0;
+	     i++)
+		tid[n++] = i;
+	if (n) {
+		debug2("Sending task exit message for %d tasks of the tree",
+		       n);
+		_send_exit_msg(job, tid, n, 0);
+	}
+	xfree(tid);
+	FREE_NULL_BITMAP(step_complete.task_exit_ok);
+}
+
 static inline void
 _log_task_exit(unsigned long taskid, unsigned long pid, int status)
 {
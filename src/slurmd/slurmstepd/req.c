@@ -1581,6 +1581,7 @@ _handle_completion(int fd, stepd_step_rec_t *job, uid_t uid)
 	int first;
 	int last;
 	jobacctinfo_t *jobacct = NULL;
+	bitstr_t *task_exit_ok = NULL;
 	int step_rc;
 	char *buf = NULL;
 	int len;
@@ -1622,6 +1623,8 @@ _handle_completion(int fd, stepd_step_rec_t *job, uid_t uid)
 	if (jobacctinfo_unpack(&jobacct, SLURM_PROTOCOL_VERSION,
 			       PROTOCOL_TYPE_SLURM, buffer, 1) != SLURM_SUCCESS)
 		goto rwfail;
+	if (remaining_buf(buffer))
+		unpack_bit_str_hex(&task_exit_ok, buffer);
 	FREE_NULL_BUFFER(buffer);
 
 	/*
@@ -1676,10 +1679,26 @@ _handle_completion(int fd, stepd_step_rec_t *job, uid_t uid)
 	}
 	step_complete.step_rc = MAX(step_complete.step_rc, step_rc);
 
+	if (task_exit_ok) {
+		if (!step_complete.task_exit_ok) {
+			step_complete.task_exit_ok = task_exit_ok;
+			task_exit_ok = NULL;
+		} else if (bit_size(task_exit_ok) ==
+			   bit_size(step_complete.task_exit_ok)) {
+			bit_or(step_complete.task_exit_ok, task_exit_ok);
+		} else {
+			error("%s: task exit bitmap size mismatch (%"PRId64" != %"PRId64") from ranks %d to %d",
+			      __func__, bit_size(task_exit_ok),
+			      bit_size(step_complete.task_exit_ok),
+			      first, last);
+		}
+	}
+
 	/************* acct stuff ********************/
 	jobacctinfo_aggregate(step_complete.jobacct, jobacct);
 timeout:
 	jobacctinfo_destroy(jobacct);
+	FREE_NULL_BITMAP(task_exit_ok);
 	/*********************************************/
 
 	/*
@@ -1695,12 +1714,14 @@ timeout:
 	return SLURM_SUCCESS;
 
 
+unpack_error:
 rwfail:	if (lock_set) {
 		slurm_cond_signal(&step_complete.cond);
 		slurm_mutex_unlock(&step_complete.lock);
 	}
 	xfree(buf);	/* In case of failure before moving to "buffer" */
 	FREE_NULL_BUFFER(buffer);
+	FREE_NULL_BITMAP(task_exit_ok);
 	return SLURM_ERROR;
 }
 
@@ -60,6 +60,8 @@ typedef struct {
 	bitstr_t *bits;
 	int step_rc;
 	jobacctinfo_t *jobacct;
+	bitstr_t *task_exit_ok;	/* tasks of this subtree which exited 0, for
+				 * one MESSAGE_TASK_EXIT from the tree root */
 } step_complete_t;
 
 extern step_complete_t step_complete;
@@ -38,6 +38,7 @@
 
 #include "config.h"
 
+#include <limits.h>
 #include <signal.h>
 
 #if HAVE_SYS_PRCTL_H
@@ -63,6 +64,19 @@
 #include "src/slurmdbd/slurmdbd.h"
 #include "src/slurmctld/slurmctld.h"
 
+/* most replies kept by the query cache at once */
+#define QUERY_CACHE_MAX 256
+
+typedef struct {
+	buf_t *key;	/* request, packed as received, plus uid and cluster */
+	buf_t *reply;	/* reply as sent */
+	time_t stored;
+} query_cache_t;
+
+static List query_cache_list = NULL;
+static pthread_mutex_t query_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t query_cache_gen = 0;
+
 /* Local functions */
 static bool  _validate_slurm_user(uint32_t uid);
 static bool  _validate_super_user(uint32_t uid, slurmdbd_conn_t *slurmdbd_conn);
@@ -970,8 +984,10 @@ static int _get_jobs_cond(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			list_msg.my_list = list_create(NULL);
 		*out_buffer = init_buf(1024);
 		pack16((uint16_t) DBD_GOT_JOBS, *out_buffer);
-		slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
-				       DBD_GOT_JOBS, *out_buffer);
+		/* The job list can be huge, free each job once packed */
+		slurmdbd_pack_list_msg_consume(&list_msg,
+					       slurmdbd_conn->conn->version,
+					       DBD_GOT_JOBS, *out_buffer);
 	} else {
 		*out_buffer = slurm_persist_make_rc_msg(slurmdbd_conn->conn,
 							errno,
@@ -2866,6 +2882,292 @@ static int _send_mult_job_start(slurmdbd_conn_t *slurmdbd_conn,
 	return SLURM_SUCCESS;
 }
 
+/* record of a DBD_SEND_MULT_MSG processed in parallel */
+typedef struct {
+	persist_msg_t msg;
+	bool unpacked;		/* msg needs to be freed */
+	bool done;		/* rc and ret_buf are set */
+	int rc;
+	buf_t *ret_buf;
+	uint32_t job_id;	/* lane selector */
+} mult_rec_t;
+
+typedef struct {
+	pthread_mutex_t mutex;
+	mult_rec_t *recs;
+	int start;
+	int end;
+	int lanes;
+	int fail_at;		/* first failed record or INT_MAX */
+	uint32_t uid;
+#ifndef NDEBUG
+	bool drop_priv;
+#endif
+} mult_run_t;
+
+typedef struct {
+	mult_run_t *run;
+	int lane;
+	slurmdbd_conn_t lane_conn;
+} mult_lane_t;
+
+/*
+ * Records of a single job must be processed in order; records of different
+ * jobs are independent of each other.
+ * RET true and job_id set if msg is a job or step record
+ */
+static bool _mult_msg_job_id(persist_msg_t *msg, uint32_t *job_id)
+{
+	switch (msg->msg_type) {
+	case DBD_JOB_COMPLETE:
+		*job_id = ((dbd_job_comp_msg_t *) msg->data)->job_id;
+		return true;
+	case DBD_JOB_START:
+		*job_id = ((dbd_job_start_msg_t *) msg->data)->job_id;
+		return true;
+	case DBD_JOB_SUSPEND:
+		*job_id = ((dbd_job_suspend_msg_t *) msg->data)->job_id;
+		return true;
+	case DBD_STEP_COMPLETE:
+		*job_id = ((dbd_step_comp_msg_t *) msg->data)->step_id.job_id;
+		return true;
+	case DBD_STEP_START:
+		*job_id = ((dbd_step_start_msg_t *) msg->data)->step_id.job_id;
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Open database connections for up to lanes - 1 extra lanes, the
+ * connection's own database connection is used for the first lane.
+ * RET number of lanes available
+ */
+static int _get_lane_db_conns(slurmdbd_conn_t *slurmdbd_conn, int lanes)
+{
+	if (slurmdbd_conn->lane_db_conn_cnt < (lanes - 1))
+		xrecalloc(slurmdbd_conn->lane_db_conns, (lanes - 1),
+			  sizeof(*slurmdbd_conn->lane_db_conns));
+
+	while (slurmdbd_conn->lane_db_conn_cnt < (lanes - 1)) {
+		void *db_conn;
+
+		errno = 0;
+		db_conn = acct_storage_g_get_connection(
+			slurmdbd_conn->conn->fd, NULL, true,
+			slurmdbd_conn->conn->cluster_name);
+		if (!db_conn || errno) {
+			error("%s: unable to open database connection for cluster %s: %m",
+			      __func__, slurmdbd_conn->conn->cluster_name);
+			acct_storage_g_close_connection(&db_conn);
+			break;
+		}
+
+		slurmdbd_conn->lane_db_conns[
+			slurmdbd_conn->lane_db_conn_cnt++] = db_conn;
+	}
+
+	return MIN(lanes, (slurmdbd_conn->lane_db_conn_cnt + 1));
+}
+
+static void *_mult_lane(void *x)
+{
+	mult_lane_t *lane = x;
+	mult_run_t *run = lane->run;
+	uint32_t uid = run->uid;
+
+#ifndef NDEBUG
+	drop_priv = run->drop_priv;
+#endif
+
+	for (int i = run->start; i < run->end; i++) {
+		mult_rec_t *rec = &run->recs[i];
+		bool stop;
+
+		if ((rec->job_id % run->lanes) != lane->lane)
+			continue;
+
+		/* later records will be resent anyway */
+		slurm_mutex_lock(&run->mutex);
+		stop = (i > run->fail_at);
+		slurm_mutex_unlock(&run->mutex);
+		if (stop)
+			break;
+
+		rec->rc = proc_req(&lane->lane_conn, &rec->msg, &rec->ret_buf,
+				   &uid);
+		rec->done = true;
+
+		if (rec->rc != SLURM_SUCCESS) {
+			slurm_mutex_lock(&run->mutex);
+			if (i < run->fail_at)
+				run->fail_at = i;
+			slurm_mutex_unlock(&run->mutex);
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * Process records start to end - 1, which are all job or step records,
+ * spreading the jobs over lanes threads each with its own database connection.
+ * RET index of first failed record or INT_MAX
+ */
+static int _run_mult_lanes(slurmdbd_conn_t *slurmdbd_conn, mult_rec_t *recs,
+			   int start, int end, uint32_t *uid)
+{
+	mult_run_t run = {
+		.recs = recs,
+		.start = start,
+		.end = end,
+		.fail_at = INT_MAX,
+		.uid = *uid,
+#ifndef NDEBUG
+		.drop_priv = drop_priv,
+#endif
+	};
+	mult_lane_t *lanes;
+	pthread_t *tids;
+	bool commit_failed = false;
+
+	run.lanes = MIN(slurmdbd_conf->mult_msg_threads, (end - start));
+	run.lanes = _get_lane_db_conns(slurmdbd_conn, run.lanes);
+	slurm_mutex_init(&run.mutex);
+
+	lanes = xcalloc(run.lanes, sizeof(*lanes));
+	tids = xcalloc(run.lanes, sizeof(*tids));
+
+	for (int i = 0; i < run.lanes; i++) {
+		lanes[i].run = &run;
+		lanes[i].lane = i;
+		lanes[i].lane_conn.conn = slurmdbd_conn->conn;
+		lanes[i].lane_conn.db_conn =
+			(i ? slurmdbd_conn->lane_db_conns[i - 1] :
+			 slurmdbd_conn->db_conn);
+		lanes[i].lane_conn.in_mult_msg = true;
+
+		if (i)
+			slurm_thread_create(&tids[i], _mult_lane, &lanes[i]);
+	}
+
+	/* first lane is done by this thread */
+	(void) _mult_lane(&lanes[0]);
+
+	for (int i = 1; i < run.lanes; i++) {
+		pthread_join(tids[i], NULL);
+
+		/*
+		 * The first lane is committed along with the rest of the
+		 * DBD_SEND_MULT_MSG, and the commit thread only knows of the
+		 * connection's own database connection either way.
+		 */
+		if (slurmdbd_conn->conn->rem_port &&
+		    acct_storage_g_commit(lanes[i].lane_conn.db_conn, 1))
+			commit_failed = true;
+	}
+
+	/*
+	 * Rows of the failed lane may be lost, so none of these records are
+	 * acknowledged. The others are committed, but storing them again is
+	 * harmless.
+	 */
+	if (commit_failed) {
+		error("%s: commit of records %d-%d failed, they will be resent",
+		      __func__, start, (end - 1));
+		FREE_NULL_BUFFER(recs[start].ret_buf);
+		recs[start].ret_buf = slurm_persist_make_rc_msg(
+			slurmdbd_conn->conn, SLURM_ERROR, "commit failed",
+			recs[start].msg.msg_type);
+		recs[start].rc = SLURM_ERROR;
+		recs[start].done = true;
+		run.fail_at = MIN(run.fail_at, start);
+	}
+
+	slurm_mutex_destroy(&run.mutex);
+	xfree(lanes);
+	xfree(tids);
+
+	return run.fail_at;
+}
+
+/*
+ * Process DBD_SEND_MULT_MSG with the job and step records spread over
+ * Parameters=mult_msg_threads threads. Any other record acts as a barrier
+ * and is processed once all records before it are done. As with the serial
+ * version, the reply holds the return of every record up to and including
+ * the first that failed so the sender will resend the rest.
+ */
+static void _send_mult_msg_parallel(slurmdbd_conn_t *slurmdbd_conn,
+				    dbd_list_msg_t *get_msg,
+				    dbd_list_msg_t *list_msg, uint32_t *uid)
+{
+	int cnt = list_count(get_msg->my_list), i = 0, pos = 0;
+	mult_rec_t *recs = xcalloc(cnt, sizeof(*recs));
+	ListIterator itr;
+	buf_t *req_buf;
+
+	itr = list_iterator_create(get_msg->my_list);
+	while ((req_buf = list_next(itr))) {
+		mult_rec_t *rec = &recs[i++];
+
+		rec->rc = slurm_persist_conn_process_msg(
+			slurmdbd_conn->conn, &rec->msg,
+			get_buf_data(req_buf),
+			size_buf(req_buf), &rec->ret_buf, 0);
+		if (rec->rc != SLURM_SUCCESS) {
+			/* nothing after this can be processed */
+			rec->done = true;
+			break;
+		}
+		rec->unpacked = true;
+	}
+	list_iterator_destroy(itr);
+	cnt = i;
+
+	while ((pos < cnt) && recs[pos].unpacked) {
+		int end = pos;
+
+		while ((end < cnt) && recs[end].unpacked &&
+		       _mult_msg_job_id(&recs[end].msg, &recs[end].job_id))
+			end++;
+
+		if (end == pos) {
+			/* not a job record: barrier */
+			recs[pos].rc = proc_req(slurmdbd_conn, &recs[pos].msg,
+						&recs[pos].ret_buf, uid);
+			recs[pos].done = true;
+			if (recs[pos].rc != SLURM_SUCCESS)
+				break;
+			pos++;
+		} else if (_run_mult_lanes(slurmdbd_conn, recs, pos, end,
+					   uid) != INT_MAX) {
+			break;
+		} else
+			pos = end;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		if (!recs[i].done)
+			break;
+		if (recs[i].ret_buf) {
+			list_append(list_msg->my_list, recs[i].ret_buf);
+			recs[i].ret_buf = NULL;
+		}
+		if (recs[i].rc != SLURM_SUCCESS)
+			break;
+	}
+
+	for (i = 0; i < cnt; i++) {
+		if (recs[i].unpacked)
+			slurmdbd_free_msg(&recs[i].msg);
+		FREE_NULL_BUFFER(recs[i].ret_buf);
+	}
+	xfree(recs);
+}
+
 static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 			  buf_t **out_buffer, uint32_t *uid)
 {
@@ -2888,7 +3190,21 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	}
 
 	list_msg.my_list = list_create(slurmdbd_free_buffer);
+	/*
+	 * The records are committed once the whole DBD_SEND_MULT_MSG is done,
+	 * so the step inserts of the batch can go out as multi-row statements.
+	 * The commit thread skips the connection meanwhile.
+	 */
+	if (slurmdbd_conf->commit_delay)
+		slurm_mutex_lock(&registered_lock);
+	slurmdbd_conn->in_mult_msg = true;
+	if (slurmdbd_conf->commit_delay)
+		slurm_mutex_unlock(&registered_lock);
 	/* START_TIMER; */
+	if (slurmdbd_conf->mult_msg_threads > 1) {
+		_send_mult_msg_parallel(slurmdbd_conn, get_msg, &list_msg, uid);
+		goto reply;
+	}
 	itr = list_iterator_create(get_msg->my_list);
 	while ((req_buf = list_next(itr))) {
 		persist_msg_t sub_msg;
@@ -2914,6 +3230,25 @@ static int _send_mult_msg(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	/* END_TIMER; */
 	/* info("%d multi took %s", list_count(get_msg->my_list), TIME_STR); */
 
+reply:
+	/*
+	 * Step rows are only queued until the commit, so commit before
+	 * telling the sender its records are stored. If rows were lost none
+	 * of the records are acknowledged and the sender resends them all.
+	 */
+	if (slurmdbd_conn->conn->rem_port) {
+		if (slurmdbd_conf->commit_delay)
+			slurm_mutex_lock(&registered_lock);
+		if (acct_storage_g_commit(slurmdbd_conn->db_conn, 1)) {
+			error("%s: commit failed, %d records will be resent",
+			      __func__, list_count(get_msg->my_list));
+			list_flush(list_msg.my_list);
+		}
+		slurmdbd_conn->in_mult_msg = false;
+		if (slurmdbd_conf->commit_delay)
+			slurm_mutex_unlock(&registered_lock);
+	} else
+		slurmdbd_conn->in_mult_msg = false;
 	*out_buffer = init_buf(1024);
 	pack16((uint16_t) DBD_GOT_MULT_MSG, *out_buffer);
 	slurmdbd_pack_list_msg(&list_msg, slurmdbd_conn->conn->version,
@@ -3149,6 +3484,198 @@ static int _shutdown(slurmdbd_conn_t *slurmdbd_conn, persist_msg_t *msg,
 	return rc;
 }
 
+static void _destroy_query_cache(void *object)
+{
+	query_cache_t *cache = object;
+
+	if (cache) {
+		FREE_NULL_BUFFER(cache->key);
+		FREE_NULL_BUFFER(cache->reply);
+		xfree(cache);
+	}
+}
+
+static int _find_query_cache(void *x, void *key)
+{
+	query_cache_t *cache = x;
+	buf_t *buffer = key;
+
+	if ((get_buf_offset(cache->key) == get_buf_offset(buffer)) &&
+	    !memcmp(get_buf_data(cache->key), get_buf_data(buffer),
+		    get_buf_offset(buffer)))
+		return 1;
+	return 0;
+}
+
+static int _query_cache_expired(void *x, void *key)
+{
+	query_cache_t *cache = x;
+	time_t *now = key;
+
+	if ((cache->stored + slurmdbd_conf->query_cache_time) <= *now)
+		return 1;
+	return 0;
+}
+
+static buf_t *_copy_buf(buf_t *buffer)
+{
+	uint32_t size = get_buf_offset(buffer);
+	buf_t *copy = init_buf(size);
+
+	memcpy(get_buf_data(copy), get_buf_data(buffer), size);
+	set_buf_offset(copy, size);
+
+	return copy;
+}
+
+/*
+ * Reads answered from the query cache. The result of these only changes
+ * through RPCs that _query_cache_keep() is false for, or through rollup.
+ */
+static bool _query_cache_type(slurmdbd_msg_type_t msg_type)
+{
+	switch (msg_type) {
+	case DBD_GET_ASSOCS:
+	case DBD_GET_ASSOC_USAGE:
+	case DBD_GET_CLUSTER_USAGE:
+	case DBD_GET_QOS:
+	case DBD_GET_USERS:
+	case DBD_GET_WCKEY_USAGE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * RPCs that leave the query cache valid. Job, step and node records only
+ * reach the cached usage through rollup, which invalidates on its own.
+ * A DBD_FINI only does when it commits the changes made by sacctmgr.
+ * Anything else may have changed associations, users or QOS.
+ */
+static bool _query_cache_keep(persist_msg_t *msg)
+{
+	switch (msg->msg_type) {
+	case DBD_FINI:
+		return !((dbd_fini_msg_t *) msg->data)->commit;
+	case REQUEST_PERSIST_INIT:
+	case DBD_CLUSTER_TRES:
+	case DBD_CLEAR_STATS:
+	case DBD_FLUSH_JOBS:
+	case DBD_GET_ACCOUNTS:
+	case DBD_GET_ASSOCS:
+	case DBD_GET_ASSOC_USAGE:
+	case DBD_GET_CLUSTERS:
+	case DBD_GET_CLUSTER_USAGE:
+	case DBD_GET_CONFIG:
+	case DBD_GET_EVENTS:
+	case DBD_GET_FEDERATIONS:
+	case DBD_GET_JOBS_COND:
+	case DBD_GET_PROBS:
+	case DBD_GET_QOS:
+	case DBD_GET_RES:
+	case DBD_GET_RESVS:
+	case DBD_GET_STATS:
+	case DBD_GET_TRES:
+	case DBD_GET_TXN:
+	case DBD_GET_USERS:
+	case DBD_GET_WCKEYS:
+	case DBD_GET_WCKEY_USAGE:
+	case DBD_JOB_COMPLETE:
+	case DBD_JOB_START:
+	case DBD_JOB_SUSPEND:
+	case DBD_NODE_STATE:
+	case DBD_SEND_MULT_JOB_START:
+	case DBD_SEND_MULT_MSG:
+	case DBD_STEP_COMPLETE:
+	case DBD_STEP_START:
+		return true;
+	default:
+		return false;
+	}
+}
+
+/*
+ * Build the query cache key of msg, NULL if the reply is not to be cached.
+ * The reply depends on who asks and the protocol version it is packed
+ * with, so both are part of the key.
+ */
+static buf_t *_query_cache_key(slurmdbd_conn_t *slurmdbd_conn,
+			       persist_msg_t *msg, uint32_t uid)
+{
+	buf_t *key;
+
+	if (!slurmdbd_conf->query_cache_time ||
+	    !_query_cache_type(msg->msg_type))
+		return NULL;
+
+	if (!(key = pack_slurmdbd_msg(msg, slurmdbd_conn->conn->version)))
+		return NULL;
+	pack16(slurmdbd_conn->conn->version, key);
+	pack32(uid, key);
+	packstr(slurmdbd_conn->conn->cluster_name, key);
+
+	return key;
+}
+
+/* Fill *out_buffer from the query cache, RET true on a hit */
+static bool _query_cache_get(buf_t *key, buf_t **out_buffer, uint32_t *gen)
+{
+	query_cache_t *cache;
+	time_t now = time(NULL);
+
+	slurm_mutex_lock(&query_cache_mutex);
+	*gen = query_cache_gen;
+	if (query_cache_list)
+		list_delete_all(query_cache_list, _query_cache_expired, &now);
+	if (query_cache_list &&
+	    (cache = list_find_first(query_cache_list, _find_query_cache,
+				     key)))
+		*out_buffer = _copy_buf(cache->reply);
+	slurm_mutex_unlock(&query_cache_mutex);
+
+	return *out_buffer ? true : false;
+}
+
+/*
+ * Keep a copy of reply. Not done if anything was invalidated while the
+ * reply was being built as it may hold data from before that change.
+ */
+static void _query_cache_put(buf_t *key, buf_t *reply, uint32_t gen)
+{
+	query_cache_t *cache;
+
+	slurm_mutex_lock(&query_cache_mutex);
+	if (gen != query_cache_gen) {
+		slurm_mutex_unlock(&query_cache_mutex);
+		return;
+	}
+	if (!query_cache_list)
+		query_cache_list = list_create(_destroy_query_cache);
+	else if (list_count(query_cache_list) >= QUERY_CACHE_MAX)
+		_destroy_query_cache(list_pop(query_cache_list));
+
+	cache = xmalloc(sizeof(query_cache_t));
+	cache->key = key;
+	cache->reply = _copy_buf(reply);
+	cache->stored = time(NULL);
+	list_append(query_cache_list, cache);
+	slurm_mutex_unlock(&query_cache_mutex);
+}
+
+static void _query_cache_invalidate(void)
+{
+	slurm_mutex_lock(&query_cache_mutex);
+	query_cache_gen++;
+	FREE_NULL_LIST(query_cache_list);
+	slurm_mutex_unlock(&query_cache_mutex);
+}
+
+extern void proc_req_cache_flush(void)
+{
+	_query_cache_invalidate();
+}
+
 /* Process an incoming RPC
  * slurmdbd_conn IN/OUT - in will that the conn.fd set before
  *       calling and db_conn and conn.version will be filled in with the init.
@@ -3165,10 +3692,28 @@ extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 	int rc = SLURM_SUCCESS;
 	char *comment = NULL;
 	slurmdb_rpc_obj_t *rpc_obj;
+	buf_t *cache_key = NULL;
+	uint32_t cache_gen = 0;
+	bool cache_keep = _query_cache_keep(msg);
 
 	DEF_TIMERS;
 	START_TIMER;
 
+	/*
+	 * Invalidate before a possible change so readers already running do
+	 * not cache the old data, and again after the commit below.
+	 */
+	if (!cache_keep)
+		_query_cache_invalidate();
+	else if ((cache_key = _query_cache_key(slurmdbd_conn, msg, *uid)) &&
+		 _query_cache_get(cache_key, out_buffer, &cache_gen)) {
+		debug2("%s: answered from query cache in CONN %d",
+		       slurmdbd_msg_type_2_str(msg->msg_type, 1),
+		       slurmdbd_conn->conn->fd);
+		FREE_NULL_BUFFER(cache_key);
+		goto end_it;
+	}
+
 	switch (msg->msg_type) {
 	case REQUEST_PERSIST_INIT:
 		rc = _unpack_persist_init(slurmdbd_conn, msg, out_buffer, uid);
@@ -3392,15 +3937,28 @@ extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 		      slurmdbd_conn->conn->fd,
 		      slurmdbd_msg_type_2_str(msg->msg_type, 1));
 	else if (slurmdbd_conn->conn->rem_port
-		 && !slurmdbd_conf->commit_delay) {
+		 && !slurmdbd_conf->commit_delay
+		 && !slurmdbd_conn->in_mult_msg
+		 && (msg->msg_type != DBD_SEND_MULT_MSG)) {
 		/* If we are dealing with the slurmctld do the
 		   commit (SUCCESS or NOT) afterwards since we
 		   do transactions for performance reasons.
 		   (don't ever use autocommit with innodb)
+		   DBD_SEND_MULT_MSG commits before packing its reply.
 		*/
 		acct_storage_g_commit(slurmdbd_conn->db_conn, 1);
 	}
 
+	if (!cache_keep)
+		_query_cache_invalidate();
+	else if (cache_key) {
+		if ((rc == SLURM_SUCCESS) && *out_buffer)
+			_query_cache_put(cache_key, *out_buffer, cache_gen);
+		else
+			FREE_NULL_BUFFER(cache_key);
+	}
+
+end_it:
 	END_TIMER;
 
 	slurm_mutex_lock(&rpc_mutex);
@@ -47,6 +47,14 @@ typedef struct {
 	slurm_persist_conn_t *conn;
 	void *db_conn; /* database connection */
 	char *tres_str;
+	/* extra database connections for parallel DBD_SEND_MULT_MSG */
+	void **lane_db_conns;
+	int lane_db_conn_cnt;
+	/*
+	 * records of DBD_SEND_MULT_MSG are committed together at the end,
+	 * set under registered_lock with CommitDelay
+	 */
+	bool in_mult_msg;
 } slurmdbd_conn_t;
 
 /* Process an incoming RPC
@@ -61,4 +69,7 @@ typedef struct {
 extern int proc_req(void *conn, persist_msg_t *msg, buf_t **out_buffer,
 		    uint32_t *uid);
 
+/* Drop all replies kept by the query cache (Parameters=query_cache_time) */
+extern void proc_req_cache_flush(void);
+
 #endif /* !_PROC_REQ */
@@ -330,12 +330,53 @@ extern int read_slurmdbd_conf(void)
 		else if (slurm_conf.msg_timeout > 100)
 			info("WARNING: MessageTimeout is too high for effective fault-tolerance");
 
+		slurmdbd_conf->mult_msg_threads = 1;
+		slurmdbd_conf->query_cache_time = 0;
+		slurmdbd_conf->rollup_threads = 0;
 		s_p_get_string(&slurmdbd_conf->parameters, "Parameters", tbl);
 		if (slurmdbd_conf->parameters) {
+			char *tmp_ptr;
+
 			if (xstrcasestr(slurmdbd_conf->parameters,
 					"PreserveCaseUser"))
 				slurmdbd_conf->persist_conn_rc_flags |=
 					PERSIST_FLAG_P_USER_CASE;
+			/*                   01234567890123456 */
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "mult_msg_threads="))) {
+				int threads = atoi(tmp_ptr + 17);
+
+				if ((threads < 1) || (threads > 64)) {
+					error("Invalid Parameters mult_msg_threads=%d, must be between 1 and 64",
+					      threads);
+					threads = 1;
+				}
+				slurmdbd_conf->mult_msg_threads = threads;
+			}
+			/*                   0123456789012345 */
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "rollup_threads="))) {
+				int threads = atoi(tmp_ptr + 15);
+
+				if ((threads < 0) || (threads > 64)) {
+					error("Invalid Parameters rollup_threads=%d, must be between 0 and 64",
+					      threads);
+					threads = 0;
+				}
+				slurmdbd_conf->rollup_threads = threads;
+			}
+			/*                   012345678901234567 */
+			if ((tmp_ptr = xstrcasestr(slurmdbd_conf->parameters,
+						   "query_cache_time="))) {
+				int cache_time = atoi(tmp_ptr + 17);
+
+				if ((cache_time < 0) || (cache_time > 3600)) {
+					error("Invalid Parameters query_cache_time=%d, must be between 0 and 3600",
+					      cache_time);
+					cache_time = 0;
+				}
+				slurmdbd_conf->query_cache_time = cache_time;
+			}
 		}
 
 		s_p_get_string(&slurmdbd_conf->pid_file, "PidFile", tbl);
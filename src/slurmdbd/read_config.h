@@ -69,8 +69,16 @@ typedef struct {
 					 * adding clusters              */
 	char *		log_file;	/* Log file			*/
 	uint32_t	max_time_range;	/* max time range for user queries */
+	uint16_t	mult_msg_threads; /* threads (and database
+					 * connections) processing the
+					 * records of one DBD_SEND_MULT_MSG */
 	char *		parameters;	/* parameters to change behavior with
 					 * the slurmdbd directly	*/
+	uint16_t	rollup_threads; /* clusters rolled up at once,
+					 * 0 for all of them		*/
+	uint16_t	query_cache_time; /* seconds replies to reads of
+					 * associations, QOS, users and
+					 * usage are kept, 0 to disable */
 	uint16_t        persist_conn_rc_flags; /* flags to be sent back on any
 						* persist connection init
 						*/
@@ -171,9 +171,14 @@ static void _connection_fini_callback(void *arg)
 			locked = true;
 		}
 		/* needs to be the last thing done */
+		for (int i = 0; i < conn->lane_db_conn_cnt; i++)
+			acct_storage_g_commit(conn->lane_db_conns[i], 1);
 		acct_storage_g_commit(conn->db_conn, 1);
 	}
 
+	for (int i = 0; i < conn->lane_db_conn_cnt; i++)
+		acct_storage_g_close_connection(&conn->lane_db_conns[i]);
+	xfree(conn->lane_db_conns);
 	acct_storage_g_close_connection(&conn->db_conn);
 
 	if (locked)
@@ -315,6 +315,7 @@ end_it:
 		_restart_self(argc, argv);
 	}
 
+	proc_req_cache_flush();
 	assoc_mgr_fini(0);
 	slurm_acct_storage_fini();
 	slurm_auth_fini();
@@ -332,6 +333,7 @@ extern void reconfig(void)
 	assoc_mgr_set_missing_uids();
 	acct_storage_g_reconfig(NULL, 0);
 	_update_logging(false);
+	proc_req_cache_flush();
 }
 
 extern void handle_rollup_stats(List rollup_stats_list,
@@ -747,6 +749,7 @@ static void *_rollup_handler(void *db_conn)
 		END_TIMER;
 		acct_storage_g_commit(db_conn, 1);
 		running_rollup = 0;
+		proc_req_cache_flush();
 
 		handle_rollup_stats(rollup_stats_list, DELTA_TIMER, 0);
 		FREE_NULL_LIST(rollup_stats_list);
@@ -807,6 +810,9 @@ static void *_commit_handler(void *db_conn)
 			running_commit = 1;
 			itr = list_iterator_create(registered_clusters);
 			while ((slurmdbd_conn = list_next(itr))) {
+				/* committed when the message is done */
+				if (slurmdbd_conn->in_mult_msg)
+					continue;
 				debug4("running commit for %s",
 				       slurmdbd_conn->conn->cluster_name);
 				acct_storage_g_commit(
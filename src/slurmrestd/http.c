@@ -760,6 +760,16 @@ static int _on_message_complete(http_parser *parser)
 		parser->data = NULL;
 	}
 
+	/*
+	 * Only process a single request per call to parse_http(). Any
+	 * pipelined requests remain in the buffer and are parsed after the
+	 * response to this request has been queued, which keeps responses in
+	 * order, gives every request a clean auth context and lets the workers
+	 * switch between connections instead of one client holding a worker
+	 * for its whole pipeline.
+	 */
+	http_parser_pause(parser, 1);
+
 	return 0;
 }
 
@@ -801,11 +811,15 @@ extern int parse_http(con_mgr_fd_t *con, void *x)
 	xassert(context->magic == MAGIC);
 
 	if (!request) {
-		/* Connection has already been closed */
+		/*
+		 * Connection has already been closed but client pipelined
+		 * more requests after the request to close: ignore them.
+		 */
 		rest_auth_g_clear();
-		debug("%s: [%s] Rejecting continued HTTP connection",
-		      __func__, con->name);
-		return SLURM_UNEXPECTED_MSG_ERROR;
+		debug("%s: [%s] Ignoring %u bytes sent after connection close",
+		      __func__, con->name, size_buf(buffer));
+		set_buf_offset(buffer, size_buf(buffer));
+		return SLURM_SUCCESS;
 	}
 
 	xassert(request->magic == MAGIC_REQUEST_T);
@@ -818,6 +832,10 @@ extern int parse_http(con_mgr_fd_t *con, void *x)
 
 	parser->data = request;
 
+	/* resume parser paused after previous pipelined request */
+	if (HTTP_PARSER_ERRNO(parser) == HPE_PAUSED)
+		http_parser_pause(parser, 0);
+
 	debug("%s: [%s] Accepted HTTP connection", __func__, con->name);
 
 	size_t bytes_parsed = http_parser_execute(parser, &settings,
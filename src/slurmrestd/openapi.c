@@ -122,8 +122,28 @@ typedef struct {
 	int tag;
 } path_t;
 
+/*
+ * Paths registered are compiled into a trie with one level per path entry
+ * so that a request is routed by walking its path once instead of testing
+ * every registered path. A request path matches the lowest tag of any path
+ * it is a prefix of, which is the first path registered that the old path
+ * by path search would have matched.
+ */
+typedef struct path_node_s path_node_t;
+struct path_node_s {
+	entry_t entry;			/* path entry matched, unset for root */
+	int min_tag;			/* lowest tag at or below this node */
+	path_node_t **str_children;	/* string entries sorted by entry */
+	int str_cnt;
+	path_node_t **param_children;	/* parameter entries, in order added */
+	int param_cnt;
+};
+
+static path_node_t *path_trie = NULL;	/* protected by paths_lock */
+
 static void _free_entry_list(entry_t *entry, path_t *path,
 			     entry_method_t *method);
+static int _trie_add_path(void *x, void *arg);
 static data_for_each_cmd_t _match_server_path_string(const data_t *data,
 						     void *arg);
 
@@ -561,6 +581,7 @@ extern int register_path_tag(const char *str_path)
 		fatal_abort("%s: failed", __func__);
 
 	list_append(paths, path);
+	(void) _trie_add_path(path, NULL);
 
 	rc = path->tag;
 
@@ -571,6 +592,119 @@ cleanup:
 	return rc;
 }
 
+static void _trie_free(path_node_t *node)
+{
+	if (!node)
+		return;
+
+	for (int i = 0; i < node->str_cnt; i++)
+		_trie_free(node->str_children[i]);
+	for (int i = 0; i < node->param_cnt; i++)
+		_trie_free(node->param_children[i]);
+	xfree(node->str_children);
+	xfree(node->param_children);
+	xfree(node->entry.entry);
+	xfree(node->entry.name);
+	xfree(node);
+}
+
+/*
+ * Find index of string child or where it would be inserted
+ * RET true if found
+ */
+static bool _trie_find_str(path_node_t *node, const char *str, int *index)
+{
+	int lo = 0, hi = node->str_cnt;
+
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = xstrcmp(str, node->str_children[mid]->entry.entry);
+
+		if (!cmp) {
+			*index = mid;
+			return true;
+		} else if (cmp < 0) {
+			hi = mid;
+		} else {
+			lo = mid + 1;
+		}
+	}
+
+	*index = lo;
+	return false;
+}
+
+/* Find or add the child of node matching path entry */
+static path_node_t *_trie_child(path_node_t *node, const entry_t *entry)
+{
+	path_node_t *child;
+	int i;
+
+	if (entry->type == OPENAPI_PATH_ENTRY_MATCH_STRING) {
+		if (_trie_find_str(node, entry->entry, &i))
+			return node->str_children[i];
+	} else {
+		for (i = 0; i < node->param_cnt; i++) {
+			child = node->param_children[i];
+			if ((child->entry.parameter == entry->parameter) &&
+			    !xstrcmp(child->entry.name, entry->name))
+				return child;
+		}
+	}
+
+	child = xmalloc(sizeof(*child));
+	child->entry.entry = xstrdup(entry->entry);
+	child->entry.name = xstrdup(entry->name);
+	child->entry.type = entry->type;
+	child->entry.parameter = entry->parameter;
+	child->min_tag = -1;
+
+	if (entry->type == OPENAPI_PATH_ENTRY_MATCH_STRING) {
+		xrecalloc(node->str_children, (node->str_cnt + 1),
+			  sizeof(*node->str_children));
+		memmove(&node->str_children[i + 1], &node->str_children[i],
+			((node->str_cnt - i) * sizeof(*node->str_children)));
+		node->str_children[i] = child;
+		node->str_cnt++;
+	} else {
+		xrecalloc(node->param_children, (node->param_cnt + 1),
+			  sizeof(*node->param_children));
+		node->param_children[node->param_cnt++] = child;
+	}
+
+	return child;
+}
+
+static void _trie_set_min_tag(path_node_t *node, int tag)
+{
+	if ((node->min_tag == -1) || (tag < node->min_tag))
+		node->min_tag = tag;
+}
+
+/* Add every method's entries of a path_t to the trie */
+static int _trie_add_path(void *x, void *arg)
+{
+	path_t *path = x;
+	entry_method_t *method;
+
+	if (!path_trie) {
+		path_trie = xmalloc(sizeof(*path_trie));
+		path_trie->min_tag = -1;
+	}
+
+	for (method = path->methods; method->entries; method++) {
+		path_node_t *node = path_trie;
+
+		_trie_set_min_tag(node, path->tag);
+		for (entry_t *entry = method->entries; entry->type; entry++) {
+			node = _trie_child(node, entry);
+			_trie_set_min_tag(node, path->tag);
+		}
+	}
+
+	return SLURM_SUCCESS;
+}
+
 static int _rm_path_by_tag(void *x, void *tptr)
 {
 	path_t *path = (path_t *)x;
@@ -588,30 +722,24 @@ extern void unregister_path_tag(int tag)
 {
 	slurm_rwlock_wrlock(&paths_lock);
 
-	if (paths)
-		list_delete_all(paths, _rm_path_by_tag, &tag);
+	if (paths && list_delete_all(paths, _rm_path_by_tag, &tag)) {
+		/* tags below a node are not tracked, rebuild from scratch */
+		_trie_free(path_trie);
+		path_trie = NULL;
+		list_for_each(paths, _trie_add_path, NULL);
+	}
 
 	slurm_rwlock_unlock(&paths_lock);
 }
 
-typedef struct {
-	bool matched;
-	const data_t *dpath;
-	path_t *path;
-	data_t *params;
-	http_request_method_t method;
-	entry_t *entry;
-} match_path_from_data_t;
-
 /*
  * Check if the entry matches based on the OAS type
- * and if it does, then add that matched parameter
+ * and if it does, then add that matched parameter to params (if not NULL)
  */
-static bool _match_param(const data_t *data, match_path_from_data_t *args)
+static bool _match_param(const data_t *data, const entry_t *entry,
+			 data_t *params)
 {
 	bool matched = false;
-	entry_t *entry = args->entry;
-	data_t *params = args->params;
 	data_t *match = data_new();
 
 	data_copy(match, data);
@@ -621,8 +749,10 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 	{
 		if (data_convert_type(match, DATA_TYPE_FLOAT) ==
 		    DATA_TYPE_FLOAT) {
-			data_set_float(data_key_set(params, entry->name),
-				       data_get_float(match));
+			if (params)
+				data_set_float(data_key_set(params,
+							    entry->name),
+					       data_get_float(match));
 			matched = true;
 		}
 		break;
@@ -631,8 +761,9 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 	{
 		if (data_convert_type(match, DATA_TYPE_INT_64) ==
 		    DATA_TYPE_INT_64) {
-			data_set_int(data_key_set(params, entry->name),
-				     data_get_int(match));
+			if (params)
+				data_set_int(data_key_set(params, entry->name),
+					     data_get_int(match));
 			matched = true;
 		}
 		break;
@@ -645,8 +776,10 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 	{
 		if (data_convert_type(match, DATA_TYPE_STRING) ==
 		    DATA_TYPE_STRING) {
-			data_set_string(data_key_set(params, entry->name),
-					data_get_string(match));
+			if (params)
+				data_set_string(data_key_set(params,
+							     entry->name),
+						data_get_string(match));
 			matched = true;
 		}
 		break;
@@ -670,96 +803,107 @@ static bool _match_param(const data_t *data, match_path_from_data_t *args)
 	return matched;
 }
 
-static data_for_each_cmd_t _match_path(const data_t *data, void *y)
+typedef struct {
+	const data_t **dpath;	/* entries of requested path */
+	int depth;		/* number of entries in dpath */
+	path_node_t **stack;	/* nodes matched for each entry */
+	path_node_t **best;	/* nodes of the best match so far */
+	int tag;		/* tag of best match so far or -1 */
+} match_trie_t;
+
+static data_for_each_cmd_t _list_dpath(const data_t *data, void *arg)
 {
-	match_path_from_data_t *args = y;
-	entry_t *entry = args->entry;
-	args->matched = false;
+	match_trie_t *args = arg;
 
-	if (!entry->type)
-		return DATA_FOR_EACH_FAIL;
-
-	if (entry->type == OPENAPI_PATH_ENTRY_MATCH_STRING) {
-		bool match;
-
-		if (data_get_type(data) != DATA_TYPE_STRING)
-			return DATA_FOR_EACH_FAIL;
-
-		match = !xstrcmp(data_get_string_const(data), entry->entry);
-
-		debug5("%s: string attempt match %s to %s: %s",
-		       __func__, entry->entry, data_get_string_const(data),
-		       (match ? "SUCCESS" : "FAILURE"));
+	args->dpath[args->depth++] = data;
 
-		if (!match)
-			return DATA_FOR_EACH_FAIL;
-	} else if (entry->type == OPENAPI_PATH_ENTRY_MATCH_PARAMETER) {
-		if (!_match_param(data, args))
-			return DATA_FOR_EACH_FAIL;
-	} else
-		fatal_abort("%s: unknown OAS path entry match type",
-			    __func__);
-
-	args->entry++;
-	args->matched = true;
 	return DATA_FOR_EACH_CONT;
 }
 
-static int _match_path_from_data(void *x, void *key)
+static void _match_trie(path_node_t *node, int depth, match_trie_t *args)
 {
-	match_path_from_data_t *args = key;
-	path_t *path = x;
-	entry_method_t *method;
+	const data_t *data;
+	path_node_t *child;
+	int i;
 
-	args->path = path;
-	for (method = path->methods; method->entries; method++) {
-		args->entry = method->entries;
-		data_list_for_each_const(args->dpath, _match_path, args);
+	/* nothing below this node can beat the current match */
+	if ((node->min_tag == -1) ||
+	    ((args->tag != -1) && (node->min_tag >= args->tag)))
+		return;
 
-		if (args->matched)
-			break;
+	if (depth == args->depth) {
+		args->tag = node->min_tag;
+		memcpy(args->best, args->stack, (depth * sizeof(*args->stack)));
+		return;
 	}
 
-	if (get_log_level() >= LOG_LEVEL_DEBUG5) {
-		char *str_path = NULL;
-
-		data_g_serialize(&str_path, args->dpath, MIME_TYPE_JSON,
-				 DATA_SER_FLAGS_COMPACT);
+	data = args->dpath[depth];
 
-		if (args->matched)
-			debug5("%s: match successful for tag %d to %s(0x%"PRIXPTR")",
-			       __func__, args->path->tag, str_path,
-			       (uintptr_t) args->dpath);
-		else
-			debug5("%s: match failed for tag %d to %s(0x%"PRIXPTR")",
-			       __func__, args->path->tag, str_path,
-			       (uintptr_t) args->dpath);
-		xfree(str_path);
+	if ((data_get_type(data) == DATA_TYPE_STRING) &&
+	    _trie_find_str(node, data_get_string_const(data), &i)) {
+		child = node->str_children[i];
+		debug5("%s: string match %s at depth %d",
+		       __func__, child->entry.entry, depth);
+		args->stack[depth] = child;
+		_match_trie(child, (depth + 1), args);
 	}
 
-	return (args->matched ? 1 : 0);
+	for (i = 0; i < node->param_cnt; i++) {
+		child = node->param_children[i];
+		if (!_match_param(data, &child->entry, NULL))
+			continue;
+		args->stack[depth] = child;
+		_match_trie(child, (depth + 1), args);
+	}
 }
 
 extern int find_path_tag(const data_t *dpath, data_t *params,
 			 http_request_method_t method)
 {
-	path_t *path;
-	int tag = -1;
-	match_path_from_data_t args = {
-		.params = params,
-		.dpath = dpath,
-	};
+	match_trie_t args = { .tag = -1 };
+	int count;
 
 	xassert(data_get_type(params) == DATA_TYPE_DICT);
+
+	if ((data_get_type(dpath) != DATA_TYPE_LIST) ||
+	    !(count = data_get_list_length(dpath)))
+		return -1;
+
+	args.dpath = xcalloc(count, sizeof(*args.dpath));
+	args.stack = xcalloc(count, sizeof(*args.stack));
+	args.best = xcalloc(count, sizeof(*args.best));
+	(void) data_list_for_each_const(dpath, _list_dpath, &args);
+
 	slurm_rwlock_rdlock(&paths_lock);
 
-	path = list_find_first(paths, _match_path_from_data, &args);
-	if (path)
-		tag = path->tag;
+	if (path_trie)
+		_match_trie(path_trie, 0, &args);
+
+	/* populate parameters from the entries matched */
+	for (int i = 0; (args.tag != -1) && (i < args.depth); i++)
+		if (args.best[i]->entry.type ==
+		    OPENAPI_PATH_ENTRY_MATCH_PARAMETER)
+			(void) _match_param(args.dpath[i], &args.best[i]->entry,
+					    params);
 
 	slurm_rwlock_unlock(&paths_lock);
 
-	return tag;
+	if (get_log_level() >= LOG_LEVEL_DEBUG5) {
+		char *str_path = NULL;
+
+		data_g_serialize(&str_path, dpath, MIME_TYPE_JSON,
+				 DATA_SER_FLAGS_COMPACT);
+		debug5("%s: %s tag %d for %s(0x%"PRIXPTR")",
+		       __func__, ((args.tag != -1) ? "matched" : "no match"),
+		       args.tag, str_path, (uintptr_t) dpath);
+		xfree(str_path);
+	}
+
+	xfree(args.dpath);
+	xfree(args.stack);
+	xfree(args.best);
+
+	return args.tag;
 }
 
 data_for_each_cmd_t _merge_schema(const char *key, data_t *data, void *arg)
@@ -1195,6 +1339,8 @@ extern void destroy_openapi(void)
 	g_context_cnt = -1;
 
 	FREE_NULL_LIST(paths);
+	_trie_free(path_trie);
+	path_trie = NULL;
 
 	for (size_t i = 0; spec[i]; i++)
 		FREE_NULL_DATA(spec[i]);
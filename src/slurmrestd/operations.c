@@ -36,6 +36,8 @@
 
 #include "config.h"
 
+#include <inttypes.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "slurm/slurm.h"
@@ -62,8 +64,12 @@ typedef struct {
 	int tag;
 	/* handler's callback to call on match */
 	operation_handler_t callback;
+	/* or handler's callback writing into stream */
+	operation_stream_handler_t stream_callback;
 	/* tag to hand to handler */
 	int callback_tag;
+	/* send string response verbatim with this mime type */
+	const char *raw_mime;
 } path_t;
 
 typedef struct {
@@ -71,11 +77,36 @@ typedef struct {
 	float q; /* quality factor (priority) */
 } http_header_accept_t;
 
+#define CACHE_MAGIC 0xDFFEAABB
+#define CACHE_MAX_ENTRIES 1024
+#define HTTP_DATE_FORMAT "%a, %d %b %Y %H:%M:%S GMT"
+
+/* Response to a GET request kept for SLURMRESTD_RESPONSE_CACHE_TTL */
+typedef struct {
+	int magic;
+	/* auth identity, path, query and mime type of request */
+	char *key;
+	/* response of first request is still being generated */
+	bool pending;
+	/* time response was generated */
+	time_t when;
+	time_t expires;
+	char *etag;
+	char *body;
+} cached_resp_t;
+
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cache_cond = PTHREAD_COND_INITIALIZER;
+static List cache = NULL;	/* NULL if caching is disabled */
+static int cache_ttl = 0;
+
+static void _free_cached_resp(void *x);
+
 static void _check_path_magic(const path_t *path)
 {
 	xassert(path->magic == MAGIC);
 	xassert(path->tag >= 0);
-	xassert(path->callback);
+	xassert(path->callback || path->stream_callback);
 }
 
 static void _free_path(void *x)
@@ -91,7 +122,12 @@ static void _free_path(void *x)
 	xfree(path);
 }
 
-extern int init_operations(void)
+static void _free_http_header(void *header)
+{
+	free_http_header(header);
+}
+
+extern int init_operations(int response_cache_ttl)
 {
 	slurm_rwlock_wrlock(&paths_lock);
 
@@ -102,6 +138,13 @@ extern int init_operations(void)
 
 	slurm_rwlock_unlock(&paths_lock);
 
+	if (response_cache_ttl > 0) {
+		slurm_mutex_lock(&cache_lock);
+		cache_ttl = response_cache_ttl;
+		cache = list_create(_free_cached_resp);
+		slurm_mutex_unlock(&cache_lock);
+	}
+
 	return SLURM_SUCCESS;
 }
 
@@ -112,6 +155,10 @@ extern void destroy_operations(void)
 	FREE_NULL_LIST(paths);
 
 	slurm_rwlock_unlock(&paths_lock);
+
+	slurm_mutex_lock(&cache_lock);
+	FREE_NULL_LIST(cache);
+	slurm_mutex_unlock(&cache_lock);
 }
 
 static int _match_path_key(void *x, void *ptr)
@@ -127,9 +174,9 @@ static int _match_path_key(void *x, void *ptr)
 		return 0;
 }
 
-extern int bind_operation_handler(const char *str_path,
-				  operation_handler_t callback,
-				  int callback_tag)
+static int _bind_handler(const char *str_path, operation_handler_t callback,
+			 operation_stream_handler_t stream_callback,
+			 int callback_tag, const char *raw_mime)
 {
 	int path_tag;
 	path_t *path;
@@ -137,7 +184,8 @@ extern int bind_operation_handler(const char *str_path,
 	slurm_rwlock_wrlock(&paths_lock);
 
 	debug3("%s: binding %s to 0x%"PRIxPTR,
-	       __func__, str_path, (uintptr_t) callback);
+	       __func__, str_path,
+	       (callback ? (uintptr_t) callback : (uintptr_t) stream_callback));
 
 	path_tag = register_path_tag(str_path);
 	if (path_tag == -1)
@@ -157,21 +205,47 @@ extern int bind_operation_handler(const char *str_path,
 
 exists:
 	path->callback = callback;
+	path->stream_callback = stream_callback;
 	path->callback_tag = callback_tag;
+	path->raw_mime = raw_mime;
 
 	slurm_rwlock_unlock(&paths_lock);
 
 	return SLURM_SUCCESS;
 }
 
+extern int bind_operation_handler(const char *str_path,
+				  operation_handler_t callback,
+				  int callback_tag)
+{
+	return _bind_handler(str_path, callback, NULL, callback_tag, NULL);
+}
+
+extern int bind_operation_raw_handler(const char *str_path,
+				      operation_handler_t callback,
+				      int callback_tag, const char *mime_type)
+{
+	xassert(mime_type);
+
+	return _bind_handler(str_path, callback, NULL, callback_tag, mime_type);
+}
+
+extern int bind_operation_stream_handler(const char *str_path,
+					 operation_stream_handler_t callback,
+					 int callback_tag)
+{
+	return _bind_handler(str_path, NULL, callback, callback_tag, NULL);
+}
+
 static int _rm_path_callback(void *x, void *ptr)
 {
 	path_t *path = (path_t *)x;
-	operation_handler_t callback = ptr;
+	void *callback = ptr;
 
 	_check_path_magic(path);
 
-	if (path->callback != callback)
+	if ((path->callback != callback) &&
+	    (path->stream_callback != callback))
 		return 0;
 
 	debug5("%s: removing tag %d for callback %"PRIxPTR,
@@ -192,6 +266,17 @@ extern int unbind_operation_handler(operation_handler_t callback)
 	return SLURM_ERROR;
 }
 
+extern int unbind_operation_stream_handler(operation_stream_handler_t callback)
+{
+	slurm_rwlock_wrlock(&paths_lock);
+
+	if (paths)
+		list_delete_all(paths, _rm_path_callback, callback);
+
+	slurm_rwlock_unlock(&paths_lock);
+	return SLURM_ERROR;
+}
+
 static int _operations_router_reject(const on_http_request_args_t *args,
 				     const char *err,
 				     http_status_code_t err_code,
@@ -361,7 +446,10 @@ static int _resolve_mime(on_http_request_args_t *args, const char **read_mime,
 		      __func__, args->context->con->name);
 	}
 
-	if (args->accept) {
+	if (*write_mime) {
+		debug4("%s: [%s] path only responds with %s",
+		       __func__, args->context->con->name, *write_mime);
+	} else if (args->accept) {
 		List accept = _parse_http_accept(args->accept);
 		http_header_accept_t *ptr = NULL;
 		ListIterator itr = list_iterator_create(accept);
@@ -426,23 +514,55 @@ static int _resolve_mime(on_http_request_args_t *args, const char **read_mime,
 	return SLURM_SUCCESS;
 }
 
-static int _call_handler(on_http_request_args_t *args, data_t *params,
-			 data_t *query, operation_handler_t callback,
-			 int callback_tag, const char *write_mime)
+/* Call handler and serialize its response into body_ptr */
+static int _run_handler(on_http_request_args_t *args, data_t *params,
+			data_t *query, const path_t *handler,
+			const char *write_mime, char **body_ptr)
 {
 	int rc;
-	data_t *resp = data_new();
-	char *body = NULL;
+	data_t *resp;
+
+	if (handler->stream_callback) {
+		data_stream_t *stream = data_stream_new(write_mime,
+							DATA_SER_FLAGS_PRETTY);
+		int rc2;
+
+		if (!stream)
+			return ESLURM_DATA_UNKNOWN_MIME_TYPE;
 
-	rc = callback(args->context->con->name, args->method, params, query,
-		      callback_tag, resp, args->context->auth);
+		rc = handler->stream_callback(args->context->con->name,
+					      args->method, params, query,
+					      handler->callback_tag, stream,
+					      args->context->auth);
+		rc2 = data_stream_finish(stream, body_ptr);
+
+		return (rc ? rc : rc2);
+	}
+
+	resp = data_new();
+	rc = handler->callback(args->context->con->name, args->method, params,
+			       query, handler->callback_tag, resp,
+			       args->context->auth);
 
 	if (data_get_type(resp) == DATA_TYPE_NULL)
 		/* no op */;
-	else
-		rc = data_g_serialize(&body, resp, write_mime,
+	else if (!handler->raw_mime)
+		rc = data_g_serialize(body_ptr, resp, write_mime,
 				      DATA_SER_FLAGS_PRETTY);
+	else if (data_get_type(resp) == DATA_TYPE_STRING)
+		*body_ptr = xstrdup(data_get_string(resp));
+	else if (!rc)
+		rc = ESLURM_DATA_CONV_FAILED;
 
+	FREE_NULL_DATA(resp);
+
+	return rc;
+}
+
+static int _send_handler_resp(on_http_request_args_t *args, int rc,
+			      const char *body, const char *write_mime,
+			      List headers)
+{
 	if (rc == SLURM_NO_CHANGE_IN_DATA) {
 		/*
 		 * RFC#7232 Section:4.1
@@ -455,6 +575,7 @@ static int _call_handler(on_http_request_args_t *args, data_t *params,
 			.http_major = args->http_major,
 			.http_minor = args->http_minor,
 			.status_code = HTTP_STATUS_CODE_REDIRECT_NOT_MODIFIED,
+			.headers = headers,
 		};
 
 		rc = send_http_response(&send_args);
@@ -477,6 +598,7 @@ static int _call_handler(on_http_request_args_t *args, data_t *params,
 			.http_major = args->http_major,
 			.http_minor = args->http_minor,
 			.status_code = HTTP_STATUS_CODE_SUCCESS_OK,
+			.headers = headers,
 			.body = NULL,
 			.body_length = 0,
 		};
@@ -490,8 +612,242 @@ static int _call_handler(on_http_request_args_t *args, data_t *params,
 		rc = send_http_response(&send_args);
 	}
 
+	return rc;
+}
+
+/* Parse RFC7231 IMF-fixdate. RET time or 0 if invalid */
+static time_t _parse_http_date(const char *str)
+{
+	struct tm tm = { 0 };
+	char *end;
+
+	if (!str || !(end = strptime(str, HTTP_DATE_FORMAT, &tm)) || *end)
+		return 0;
+
+	return timegm(&tm);
+}
+
+static void _add_header(List headers, const char *name, const char *value)
+{
+	http_header_entry_t *header = xmalloc(sizeof(*header));
+
+	header->name = xstrdup(name);
+	header->value = xstrdup(value);
+	list_append(headers, header);
+}
+
+/* Build Last-Modified and (if known) ETag headers for a GET response */
+static List _validator_headers(const char *etag, time_t when)
+{
+	List headers = list_create(_free_http_header);
+	struct tm tm;
+	char buf[64];
+
+	if (gmtime_r(&when, &tm) &&
+	    strftime(buf, sizeof(buf), HTTP_DATE_FORMAT, &tm))
+		_add_header(headers, "Last-Modified", buf);
+	if (etag)
+		_add_header(headers, "ETag", etag);
+
+	return headers;
+}
+
+/* Check RFC7232 conditional request headers against the response */
+static bool _not_modified(on_http_request_args_t *args, const char *etag,
+			  time_t when)
+{
+	const char *match, *since;
+	time_t since_time;
+
+	/* If-None-Match takes precedence per RFC7232 Section 3.3 */
+	if ((match = find_http_header(args->headers, "If-None-Match")))
+		return (etag && (!xstrcmp(match, "*") || xstrstr(match, etag)));
+
+	if ((since = find_http_header(args->headers, "If-Modified-Since")) &&
+	    (since_time = _parse_http_date(since)))
+		return (when <= since_time);
+
+	return false;
+}
+
+static int _call_handler(on_http_request_args_t *args, data_t *params,
+			 data_t *query, const path_t *handler,
+			 const char *write_mime)
+{
+	int rc;
+	char *body = NULL;
+	List headers = NULL;
+	time_t now = time(NULL);
+
+	if (args->method == HTTP_REQUEST_GET) {
+		const char *since = find_http_header(args->headers,
+						     "If-Modified-Since");
+		time_t since_time = _parse_http_date(since);
+
+		/*
+		 * Let handlers loading from slurmctld with update_time reply
+		 * with "no change in data" to a conditional request
+		 */
+		if (since_time && (data_get_type(query) == DATA_TYPE_DICT) &&
+		    !data_key_get(query, "update_time"))
+			data_set_int(data_key_set(query, "update_time"),
+				     since_time);
+
+		headers = _validator_headers(NULL, now);
+	}
+
+	rc = _run_handler(args, params, query, handler, write_mime, &body);
+	rc = _send_handler_resp(args, rc, body, write_mime, headers);
+
+	FREE_NULL_LIST(headers);
 	xfree(body);
-	FREE_NULL_DATA(resp);
+
+	return rc;
+}
+
+static char *_cache_key(on_http_request_args_t *args, const char *write_mime)
+{
+	rest_auth_context_t *auth = args->context->auth;
+	const char *token = find_http_header(args->headers,
+					     HTTP_HEADER_USER_TOKEN);
+
+	/*
+	 * Tokens are only verified by slurmctld, so a cached response may only
+	 * be handed to requests presenting the same token.
+	 */
+	return xstrdup_printf("%u:%s:%s:%s?%s:%s",
+			      (auth ? auth->plugin_id : 0),
+			      ((auth && auth->user_name) ? auth->user_name : ""),
+			      (token ? token : ""), args->path,
+			      (args->query ? args->query : ""), write_mime);
+}
+
+static char *_etag(const char *body)
+{
+	/* FNV-1a */
+	uint64_t hash = 0xcbf29ce484222325;
+
+	for (const char *c = body; *c; c++) {
+		hash ^= (unsigned char) *c;
+		hash *= 0x100000001b3;
+	}
+
+	return xstrdup_printf("\"%016"PRIx64"\"", hash);
+}
+
+static void _free_cached_resp(void *x)
+{
+	cached_resp_t *entry = x;
+
+	if (!entry)
+		return;
+
+	xassert(entry->magic == CACHE_MAGIC);
+	entry->magic = ~CACHE_MAGIC;
+	xfree(entry->key);
+	xfree(entry->etag);
+	xfree(entry->body);
+	xfree(entry);
+}
+
+static int _match_cache_key(void *x, void *key)
+{
+	cached_resp_t *entry = x;
+
+	xassert(entry->magic == CACHE_MAGIC);
+
+	return !xstrcmp(entry->key, key);
+}
+
+static int _cache_expired(void *x, void *arg)
+{
+	cached_resp_t *entry = x;
+	time_t now = *(time_t *) arg;
+
+	return (!entry->pending && (entry->expires <= now));
+}
+
+/*
+ * Answer GET request from the response cache. Identical requests arriving
+ * while the first is processed wait for and share its response.
+ */
+static int _call_cached_handler(on_http_request_args_t *args, data_t *params,
+				data_t *query, const path_t *handler,
+				const char *write_mime)
+{
+	int rc = SLURM_SUCCESS;
+	char *key = _cache_key(args, write_mime);
+	char *body = NULL, *etag = NULL;
+	List headers = NULL;
+	cached_resp_t *entry;
+	time_t now = time(NULL), when = now;
+
+	slurm_mutex_lock(&cache_lock);
+	while ((entry = list_find_first(cache, _match_cache_key, key))) {
+		if (!entry->pending) {
+			if (entry->expires > now)
+				break;
+			list_delete_ptr(cache, entry);
+			continue;
+		}
+
+		slurm_cond_wait(&cache_cond, &cache_lock);
+		now = time(NULL);
+	}
+
+	if (entry) {
+		debug3("%s: [%s] cache hit for %s",
+		       __func__, args->context->con->name, args->path);
+		body = xstrdup(entry->body);
+		etag = xstrdup(entry->etag);
+		when = entry->when;
+		slurm_mutex_unlock(&cache_lock);
+	} else {
+		list_delete_all(cache, _cache_expired, &now);
+		if (list_count(cache) < CACHE_MAX_ENTRIES) {
+			entry = xmalloc(sizeof(*entry));
+			entry->magic = CACHE_MAGIC;
+			entry->key = key;
+			key = NULL;
+			entry->pending = true;
+			list_append(cache, entry);
+		}
+		slurm_mutex_unlock(&cache_lock);
+
+		when = now;
+		rc = _run_handler(args, params, query, handler, write_mime,
+				  &body);
+		if (!rc && body)
+			etag = _etag(body);
+
+		if (entry) {
+			slurm_mutex_lock(&cache_lock);
+			if (etag) {
+				entry->pending = false;
+				entry->when = when;
+				entry->expires = when + cache_ttl;
+				entry->body = xstrdup(body);
+				entry->etag = xstrdup(etag);
+			} else {
+				list_delete_ptr(cache, entry);
+			}
+			slurm_cond_broadcast(&cache_cond);
+			slurm_mutex_unlock(&cache_lock);
+		}
+	}
+
+	if (!rc) {
+		headers = _validator_headers(etag, when);
+		if (_not_modified(args, etag, when))
+			rc = SLURM_NO_CHANGE_IN_DATA;
+	}
+
+	rc = _send_handler_resp(args, rc, body, write_mime, headers);
+
+	FREE_NULL_LIST(headers);
+	xfree(body);
+	xfree(etag);
+	xfree(key);
 
 	return rc;
 }
@@ -503,8 +859,7 @@ extern int operations_router(on_http_request_args_t *args)
 	data_t *params = NULL;
 	int path_tag;
 	path_t *path = NULL;
-	operation_handler_t callback = NULL;
-	int callback_tag;
+	path_t handler;
 	const char *read_mime = NULL;
 	const char *write_mime = NULL;
 
@@ -524,7 +879,7 @@ extern int operations_router(on_http_request_args_t *args)
 
 	params = data_set_dict(data_new());
 	if ((rc = _resolve_path(args, &path_tag, params)))
-	    return rc;
+		goto cleanup;
 
 	/*
 	 * Hold read lock while the callback is executing to avoid
@@ -537,22 +892,27 @@ extern int operations_router(on_http_request_args_t *args)
 	_check_path_magic(path);
 
 	/* clone over the callback info to release lock */
-	callback = path->callback;
-	callback_tag = path->callback_tag;
+	handler = *path;
 	slurm_rwlock_unlock(&paths_lock);
 
 	debug5("%s: [%s] found callback handler: (0x%"PRIXPTR") callback_tag %d for path: %s",
-	       __func__, args->context->con->name, (uintptr_t) callback,
-	       callback_tag, args->path);
+	       __func__, args->context->con->name,
+	       (handler.callback ? (uintptr_t) handler.callback :
+		(uintptr_t) handler.stream_callback),
+	       handler.callback_tag, args->path);
 
+	write_mime = handler.raw_mime;
 	if ((rc = _resolve_mime(args, &read_mime, &write_mime)))
 		goto cleanup;
 
 	if ((rc = _get_query(args, &query, read_mime)))
 		goto cleanup;
 
-	rc = _call_handler(args, params, query, callback, callback_tag,
-			   write_mime);
+	if (cache && (args->method == HTTP_REQUEST_GET))
+		rc = _call_cached_handler(args, params, query, &handler,
+					  write_mime);
+	else
+		rc = _call_handler(args, params, query, &handler, write_mime);
 
 cleanup:
 	FREE_NULL_DATA(query);
@@ -44,8 +44,9 @@
 /*
  * setup locks.
  * only call once!
+ * IN response_cache_ttl - seconds to cache GET responses or 0 to disable
  */
-extern int init_operations(void);
+extern int init_operations(int response_cache_ttl);
 extern void destroy_operations(void);
 
 /*
@@ -63,6 +64,21 @@ typedef int (*operation_handler_t)(
 	rest_auth_context_t *auth /* authentication context */
 );
 
+/*
+ * Callback from operations manager for handlers writing their response
+ * incrementally into a stream instead of populating a data_t.
+ * See operation_handler_t.
+ */
+typedef int (*operation_stream_handler_t)(
+	const char *context_id, /* context id of client */
+	http_request_method_t method, /* request method */
+	data_t *parameters, /* openapi parameters */
+	data_t *query, /* query sent by client */
+	int tag, /* tag associated with path */
+	data_stream_t *resp, /* stream to write response into */
+	rest_auth_context_t *auth /* authentication context */
+);
+
 /*
  * Bind callback handler for a given URL pattern.
  * Will query OpenAPI spec for description of path including variables
@@ -86,6 +102,36 @@ extern int bind_operation_handler(const char *path,
 				  operation_handler_t callback,
 				  int tag);
 
+/*
+ * Bind callback handler for a given URL pattern whose response is not
+ * serialized. See bind_operation_handler().
+ * Handler must set resp to a string which is sent verbatim as the body,
+ * regardless of the Accept header of the request.
+ *
+ * IN path - url path to match
+ * IN callback - handler function for callback
+ * IN tag - arbitrary tag passed to handler when path matched
+ * IN mime_type - content type of response body (must be static)
+ * RET SLURM_SUCCESS or error
+ */
+extern int bind_operation_raw_handler(const char *path,
+				      operation_handler_t callback,
+				      int tag, const char *mime_type);
+
+/*
+ * Bind stream callback handler for a given URL pattern.
+ * See bind_operation_handler().
+ * Intended for responses too large to hold as a single data_t tree.
+ *
+ * IN path - url path to match
+ * IN callback - handler function for callback
+ * IN tag - arbitrary tag passed to handler when path matched
+ * RET SLURM_SUCCESS or error
+ */
+extern int bind_operation_stream_handler(const char *path,
+					 operation_stream_handler_t callback,
+					 int tag);
+
 /*
  * Unbind a given callback handler from all paths
  * WARNING: NOT YET IMPLEMENTED
@@ -93,6 +139,7 @@ extern int bind_operation_handler(const char *path,
  * RET SLURM_SUCCESS or error
  */
 extern int unbind_operation_handler(operation_handler_t callback);
+extern int unbind_operation_stream_handler(operation_stream_handler_t callback);
 
 /*
  * Parses incoming requests and calls handlers.
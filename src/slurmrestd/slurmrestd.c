@@ -91,6 +91,7 @@ static List socket_listen = NULL;
 static char *slurm_conf_filename = NULL;
 /* Number of requested threads */
 static int thread_count = 20;
+static int response_cache_ttl = 0;
 /* User to become once loaded */
 static uid_t uid = 0;
 static gid_t gid = 0;
@@ -144,6 +145,14 @@ static void _parse_env(void)
 		rest_auth = xstrdup(buffer);
 	}
 
+	if ((buffer = getenv("SLURMRESTD_RESPONSE_CACHE_TTL"))) {
+		response_cache_ttl = atoi(buffer);
+
+		if (response_cache_ttl < 0)
+			fatal("Invalid env SLURMRESTD_RESPONSE_CACHE_TTL: %s",
+			      buffer);
+	}
+
 	if ((buffer = getenv("SLURMRESTD_OPENAPI_PLUGINS")) != NULL) {
 		xfree(oas_specs);
 		oas_specs = xstrdup(buffer);
@@ -400,7 +409,7 @@ int main(int argc, char **argv)
 	if (!(conmgr = init_con_mgr(run_mode.listen ? thread_count : 1)))
 		fatal("Unable to initialize connection manager");
 
-	if (init_operations())
+	if (init_operations(response_cache_ttl))
 		fatal("Unable to initialize operations structures");
 
 	auth_rack = plugrack_create("rest_auth");
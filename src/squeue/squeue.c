@@ -63,6 +63,8 @@ int max_line_size;
  *************/
 static int  _get_info(bool clear_old, bool log_cluster_name);
 static int  _get_window_width( void );
+static int  _load_jobs(job_info_msg_t *old_job_ptr,
+		       job_info_msg_t **job_ptr, uint16_t show_flags);
 static int  _multi_cluster(List clusters);
 static int  _print_job(bool clear_old, bool log_cluster_name);
 static int  _print_job_steps( bool clear_old );
@@ -195,16 +197,11 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 			error_code = slurm_load_job(
 				&new_job_ptr, params.job_id,
 				show_flags);
-		} else if (params.user_id) {
-			error_code = slurm_load_job_user(&new_job_ptr,
-							 params.user_id,
-							 show_flags);
 		} else {
 			if (params.clusters)
 				show_flags |= SHOW_LOCAL;
-			error_code = slurm_load_jobs(
-				old_job_ptr->last_update,
-				&new_job_ptr, show_flags);
+			error_code = _load_jobs(old_job_ptr, &new_job_ptr,
+						show_flags);
 		}
 		if (error_code ==  SLURM_SUCCESS)
 			slurm_free_job_info_msg( old_job_ptr );
@@ -215,12 +212,8 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 	} else if (params.job_id) {
 		error_code = slurm_load_job(&new_job_ptr, params.job_id,
 					    show_flags);
-	} else if (params.user_id) {
-		error_code = slurm_load_job_user(&new_job_ptr, params.user_id,
-						 show_flags);
 	} else {
-		error_code = slurm_load_jobs((time_t) NULL, &new_job_ptr,
-					     show_flags);
+		error_code = _load_jobs(NULL, &new_job_ptr, show_flags);
 	}
 
 	if (error_code) {
@@ -228,7 +221,7 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 		return SLURM_ERROR;
 	}
 	old_job_ptr = new_job_ptr;
-	if (params.job_id || params.user_id)
+	if (params.job_id)
 		old_job_ptr->last_update = (time_t) 0;
 
 	if (params.verbose) {
@@ -267,6 +260,61 @@ static int _print_job(bool clear_old, bool log_cluster_name)
 
 
 /* _print_job_step - print the specified job step's information */
+static char *_list_to_str(List str_list)
+{
+	ListIterator itr;
+	char *str, *ret = NULL;
+
+	if (!str_list)
+		return NULL;
+
+	itr = list_iterator_create(str_list);
+	while ((str = list_next(itr)))
+		xstrfmtcat(ret, "%s%s", ret ? "," : "", str);
+	list_iterator_destroy(itr);
+
+	return ret;
+}
+
+/*
+ * Load jobs, having slurmctld leave out those not passing the account,
+ * job, partition, state and user filters. Those filters are applied again
+ * locally as an older slurmctld ignores them. With old_job_ptr, only the
+ * jobs changed since it was loaded are transferred.
+ */
+static int _load_jobs(job_info_msg_t *old_job_ptr, job_info_msg_t **job_ptr,
+		      uint16_t show_flags)
+{
+	char *accounts = _list_to_str(params.account_list);
+	char *partitions = _list_to_str(params.part_list);
+	List job_id_list = NULL;
+	ListIterator itr;
+	squeue_job_step_t *job_step_id;
+	uint32_t *job_id;
+	int rc;
+
+	if (params.job_list) {
+		job_id_list = list_create(xfree_ptr);
+		itr = list_iterator_create(params.job_list);
+		while ((job_step_id = list_next(itr))) {
+			job_id = xmalloc(sizeof(uint32_t));
+			*job_id = job_step_id->step_id.job_id;
+			list_append(job_id_list, job_id);
+		}
+		list_iterator_destroy(itr);
+	}
+
+	rc = slurm_load_jobs_delta(old_job_ptr, job_ptr, show_flags,
+				   accounts, job_id_list, partitions,
+				   params.state_list, params.user_list);
+
+	xfree(accounts);
+	xfree(partitions);
+	FREE_NULL_LIST(job_id_list);
+
+	return rc;
+}
+
 static int
 _print_job_steps( bool clear_old )
 {
@@ -75,6 +75,14 @@ main(int argc, char *argv[])
 		bit_nset(bs,0,8);
 		TEST(bit_ffc(bs) == 15, "ffc");
 
+		bit_nclear(bs,0,15);
+		bit_set(bs,3);
+		bit_set(bs,12);
+		TEST(bit_ffs_from_bit(bs,0) == 3, "ffs_from_bit");
+		TEST(bit_ffs_from_bit(bs,3) == 3, "ffs_from_bit");
+		TEST(bit_ffs_from_bit(bs,4) == 12, "ffs_from_bit");
+		TEST(bit_ffs_from_bit(bs,13) == -1, "ffs_from_bit");
+
 		bit_free(bs);
 		/*bit_set(bs,9); */	/* triggers TEST in bit_set - OK */
 	}
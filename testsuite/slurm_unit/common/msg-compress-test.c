@@ -0,0 +1,186 @@
+/*
+ * Test of slurm_compress_msg_body() and slurm_uncompress_msg_body()
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_api.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+/* Stands in for the header and credential packed ahead of the body */
+#define PREFIX "packed header and auth credential"
+
+/* A node info like body, large and compressible */
+static char *_node_body(int nodes, uint32_t *len)
+{
+	char *body = NULL;
+
+	for (int i = 0; i < nodes; i++)
+		xstrfmtcat(body, "NodeName=n%05d Arch=x86_64 CPUTot=64 "
+			   "RealMemory=257000 State=IDLE Partitions=batch\n",
+			   i);
+	*len = strlen(body);
+
+	return body;
+}
+
+#if HAVE_LZ4
+/* Body of random bytes, which lz4 can not shrink */
+static char *_random_body(uint32_t len)
+{
+	char *body = xmalloc(len);
+
+	srand(42);
+	for (uint32_t i = 0; i < len; i++)
+		body[i] = rand();
+
+	return body;
+}
+#endif
+
+static void _msg_init(slurm_msg_t *msg, uint16_t msg_type)
+{
+	slurm_msg_t_init(msg);
+	msg->msg_type = msg_type;
+	msg->protocol_version = SLURM_PROTOCOL_VERSION;
+	msg->flags = SLURM_ACCEPT_COMPRESSED;
+}
+
+/* Return a buffer holding PREFIX and body, positioned at the body */
+static buf_t *_recv_buf(const char *body, uint32_t body_len,
+			header_t *header)
+{
+	char *data = xmalloc(strlen(PREFIX) + body_len);
+	buf_t *buffer;
+
+	memcpy(data, PREFIX, strlen(PREFIX));
+	memcpy(data + strlen(PREFIX), body, body_len);
+
+	memset(header, 0, sizeof(*header));
+	header->msg_type = RESPONSE_NODE_INFO;
+	header->flags = SLURM_BODY_COMPRESSED;
+	header->body_length = body_len;
+
+	buffer = create_buf(data, strlen(PREFIX) + body_len);
+	set_buf_offset(buffer, strlen(PREFIX));
+
+	return buffer;
+}
+
+int main(int argc, char *argv[])
+{
+	slurm_msg_t msg;
+	header_t header;
+	buf_t *buffer;
+	char *body, *comp;
+	uint32_t body_len, comp_len = 0;
+
+	body = _node_body(4096, &body_len);
+
+#if HAVE_LZ4
+	/* round trip */
+	_msg_init(&msg, RESPONSE_NODE_INFO);
+	comp = slurm_compress_msg_body(&msg, body, body_len, &comp_len);
+	TEST(comp && (comp_len < (body_len - (body_len / 8))),
+	     "large node info body compressed");
+
+	buffer = _recv_buf(comp, comp_len, &header);
+	TEST(!slurm_uncompress_msg_body(&header, buffer) &&
+	     (header.body_length == body_len) &&
+	     !(header.flags & SLURM_BODY_COMPRESSED) &&
+	     (get_buf_offset(buffer) == strlen(PREFIX)) &&
+	     (remaining_buf(buffer) == body_len),
+	     "body uncompressed in place");
+	TEST(!memcmp(get_buf_data(buffer), PREFIX, strlen(PREFIX)) &&
+	     !memcmp(get_buf_data(buffer) + strlen(PREFIX), body, body_len),
+	     "uncompressed body matches");
+	free_buf(buffer);
+
+	/* malformed compressed bodies */
+	buffer = _recv_buf(comp, comp_len / 2, &header);
+	TEST(slurm_uncompress_msg_body(&header, buffer),
+	     "truncated body rejected");
+	free_buf(buffer);
+
+	comp[0] = 0x7f;
+	buffer = _recv_buf(comp, comp_len, &header);
+	TEST(slurm_uncompress_msg_body(&header, buffer),
+	     "oversized uncompressed length rejected");
+	free_buf(buffer);
+
+	buffer = _recv_buf(comp, 2, &header);
+	TEST(slurm_uncompress_msg_body(&header, buffer),
+	     "body shorter than its length rejected");
+	free_buf(buffer);
+
+	buffer = _recv_buf(comp, comp_len, &header);
+	header.body_length = comp_len + 1;
+	TEST(slurm_uncompress_msg_body(&header, buffer),
+	     "body length past the buffer rejected");
+	free_buf(buffer);
+	xfree(comp);
+
+	/* bodies which are sent as is */
+	_msg_init(&msg, RESPONSE_NODE_INFO);
+	msg.flags = 0;
+	comp = slurm_compress_msg_body(&msg, body, body_len, &comp_len);
+	TEST(!comp, "peer not accepting compression");
+	xfree(comp);
+
+	_msg_init(&msg, RESPONSE_NODE_INFO);
+	msg.protocol_version = SLURM_ONE_BACK_PROTOCOL_VERSION;
+	comp = slurm_compress_msg_body(&msg, body, body_len, &comp_len);
+	TEST(!comp, "peer on an older protocol");
+	xfree(comp);
+
+	_msg_init(&msg, REQUEST_NODE_INFO);
+	comp = slurm_compress_msg_body(&msg, body, body_len, &comp_len);
+	TEST(!comp, "message type not allowed");
+	xfree(comp);
+
+	_msg_init(&msg, RESPONSE_NODE_INFO);
+	comp = slurm_compress_msg_body(&msg, body, (64 * 1024) - 1,
+				       &comp_len);
+	TEST(!comp, "body below the size threshold");
+	xfree(comp);
+	xfree(body);
+
+	body_len = 128 * 1024;
+	body = _random_body(body_len);
+	_msg_init(&msg, RESPONSE_JOB_INFO);
+	comp = slurm_compress_msg_body(&msg, body, body_len, &comp_len);
+	TEST(!comp, "incompressible body");
+	xfree(comp);
+#else
+	_msg_init(&msg, RESPONSE_NODE_INFO);
+	comp = slurm_compress_msg_body(&msg, body, body_len, &comp_len);
+	TEST(!comp, "no compression without lz4");
+	xfree(comp);
+
+	buffer = _recv_buf(body, body_len, &header);
+	TEST(slurm_uncompress_msg_body(&header, buffer),
+	     "compressed body rejected without lz4");
+	free_buf(buffer);
+#endif
+	xfree(body);
+
+	totals();
+	return failed;
+}
@@ -3,6 +3,9 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <slurm/slurm.h>
+#include <slurm/slurm_errno.h>
+
 #include <src/common/pack.h>
 #include <src/common/xmalloc.h>
 
@@ -19,7 +22,7 @@
 
 int main (int argc, char *argv[])
 {
-	buf_t *buffer;
+	buf_t *buffer, *shadow, *inner;
 	uint16_t test16 = 1234, out16;
 	uint32_t test32 = 5678, out32, byte_cnt;
 	char testbytes[] = "TEST BYTES", *outbytes;
@@ -29,6 +32,7 @@ int main (int argc, char *argv[])
 	int data_size;
 	long double test_double = 1340664754944.2132312, test_double2;
 	uint64_t test64;
+	time_t testtime;
 
 	buffer = init_buf (0);
         pack16(test16, buffer);
@@ -82,6 +86,81 @@ int main (int argc, char *argv[])
 
 	xfree(outstring);
 
+	free_buf(buffer);
+
+	/* Variable length encodings */
+	buffer = init_buf(0);
+	packvar32(0, buffer);
+	packvar32(NO_VAL, buffer);
+	packvar32(INFINITE, buffer);
+	packvar32(NO_VAL - 1, buffer);
+	packvar64(NO_VAL64, buffer);
+	packvar64(INFINITE64, buffer);
+	packvar64(NO_VAL64 - 1, buffer);
+	packvar64(123456789012345, buffer);
+	packvar_time((time_t) 1617000000, buffer);
+	packvar_time((time_t) -5, buffer);
+	packvarstr(teststring, buffer);
+	packvarnull(buffer);
+	data_size = get_buf_offset(buffer);
+	TEST(data_size != 47, "packvar sizes");
+
+	data = xfer_buf_data(buffer);
+	buffer = create_buf(data, data_size);
+	unpackvar32(&out32, buffer);
+	TEST(out32 != 0, "un/packvar32 of zero");
+	unpackvar32(&out32, buffer);
+	TEST(out32 != NO_VAL, "un/packvar32 of NO_VAL");
+	unpackvar32(&out32, buffer);
+	TEST(out32 != INFINITE, "un/packvar32 of INFINITE");
+	unpackvar32(&out32, buffer);
+	TEST(out32 != (NO_VAL - 1), "un/packvar32 of NO_VAL - 1");
+	unpackvar64(&test64, buffer);
+	TEST(test64 != NO_VAL64, "un/packvar64 of NO_VAL64");
+	unpackvar64(&test64, buffer);
+	TEST(test64 != INFINITE64, "un/packvar64 of INFINITE64");
+	unpackvar64(&test64, buffer);
+	TEST(test64 != (NO_VAL64 - 1), "un/packvar64 of NO_VAL64 - 1");
+	unpackvar64(&test64, buffer);
+	TEST(test64 != 123456789012345, "un/packvar64");
+	unpackvar_time(&testtime, buffer);
+	TEST(testtime != 1617000000, "un/packvar_time");
+	unpackvar_time(&testtime, buffer);
+	TEST(testtime != -5, "un/packvar_time of negative time");
+	unpackvarmem_xmalloc(&outstring, &byte_cnt, buffer);
+	TEST(strcmp(teststring, outstring) != 0, "un/packvarstr");
+	xfree(outstring);
+	unpackvarmem_xmalloc(&outstring, &byte_cnt, buffer);
+	TEST(outstring != NULL, "un/packvarstr of null string");
+	TEST(unpackvar32(&out32, buffer) != SLURM_ERROR,
+	     "unpackvar32 past end of buffer");
+
+	free_buf(buffer);
+
+	/* Shadow buffer over a packmem() field */
+	buffer = init_buf(0);
+	pack32(test32, buffer);
+	packstr(teststring, buffer);
+	data_size = get_buf_offset(buffer);
+	data = xfer_buf_data(buffer);
+	buffer = create_buf(data, data_size);
+
+	shadow = init_buf(0);
+	packmem(data, data_size, shadow);
+	set_buf_offset(shadow, 0);
+	unpackmem_ptr(&outbytes, &byte_cnt, shadow);
+	inner = create_shadow_buf(outbytes, byte_cnt);
+	TEST(get_buf_data(inner) != get_buf_data(shadow) + sizeof(uint32_t),
+	     "create_shadow_buf does not copy");
+	unpack32(&out32, inner);
+	TEST(out32 != test32, "unpack32 from shadow buffer");
+	unpackstr_xmalloc(&outstring, &byte_cnt, inner);
+	TEST(strcmp(teststring, outstring) != 0, "unpackstr from shadow buffer");
+	xfree(outstring);
+	TEST(unpack32(&out32, inner) != SLURM_ERROR,
+	     "unpack32 past end of shadow buffer");
+	free_buf(inner);
+	free_buf(shadow);
 	free_buf(buffer);
 	totals();
 	return failed;
@@ -0,0 +1,775 @@
+/*****************************************************************************\
+ *  primitives-bench.c - microbenchmarks for core libslurm primitives
+ *****************************************************************************
+ *  Copyright (C) 2021 SchedMD LLC.
+ *
+ *  This file is part of Slurm, a resource management program.
+ *  For details, see <https://slurm.schedmd.com/>.
+ *  Please also read the included file: DISCLAIMER.
+ *
+ *  Slurm is free software; you can redistribute it and/or modify it under
+ *  the terms of the GNU General Public License as published by the Free
+ *  Software Foundation; either version 2 of the License, or (at your option)
+ *  any later version.
+ *
+ *  In addition, as a special exception, the copyright holders give permission
+ *  to link the code of portions of this program with the OpenSSL library under
+ *  certain conditions as described in each individual source file, and
+ *  distribute linked combinations including the two. You must obey the GNU
+ *  General Public License in all respects for all of the code used other than
+ *  OpenSSL. If you modify file(s) with this exception, you may extend this
+ *  exception to your version of the file(s), but you are not obligated to do
+ *  so. If you do not wish to do so, delete this exception statement from your
+ *  version.  If you delete this exception statement from all source files in
+ *  the program, then also delete it here.
+ *
+ *  Slurm is distributed in the hope that it will be useful, but WITHOUT ANY
+ *  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+ *  FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+ *  details.
+ *
+ *  You should have received a copy of the GNU General Public License along
+ *  with Slurm; if not, write to the Free Software Foundation, Inc.,
+ *  51 Franklin Street, Fifth Floor, Boston, MA 02110-1301  USA.
+\*****************************************************************************/
+
+/*
+ * Each benchmark is run with a doubling iteration count until it takes at
+ * least the requested time, then reported as nanoseconds and heap
+ * allocations per operation. Allocations are counted by replacing the
+ * malloc family, which is only done with glibc; elsewhere they are reported
+ * as -1. Setup of the data operated on is not measured.
+ *
+ * Benchmarks of protocol messages load the select plugin and so only run
+ * when SLURM_CONF names a configuration to load.
+ *
+ * Usage: primitives-bench [-j] [-l] [-p] [-t msec] [name_filter ...]
+ */
+
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/bitstring.h"
+#include "src/common/data.h"
+#include "src/common/hostlist.h"
+#include "src/common/list.h"
+#include "src/common/log.h"
+#include "src/common/pack.h"
+#include "src/common/read_config.h"
+#include "src/common/slurm_protocol_defs.h"
+#include "src/common/slurm_protocol_pack.h"
+#include "src/common/xhash.h"
+#include "src/common/xmalloc.h"
+#include "src/common/xstring.h"
+
+#define HOST_CNT 4096
+#define LIST_CNT 1000
+#define XHASH_CNT 10000
+#define DATA_CNT 100
+
+#define BENCH_FLAG_CONF 0x0001	/* slurm.conf must be loaded */
+#define BENCH_FLAG_JSON 0x0002	/* serializer/json must be loaded */
+
+typedef struct {
+	const char *name;
+	void (*setup)(void);
+	void (*run)(uint64_t iters);
+	void (*teardown)(void);
+	uint16_t flags;
+} bench_t;
+
+static uint64_t alloc_cnt = 0;
+static bool alloc_counted = false;
+
+#ifdef __GLIBC__
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t nmemb, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+extern void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+	alloc_cnt++;
+	return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+	alloc_cnt++;
+	return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+	alloc_cnt++;
+	return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+	__libc_free(ptr);
+}
+#endif
+
+/* Keep the compiler from discarding results of the measured calls */
+static volatile uint64_t sink = 0;
+
+static buf_t *buffer = NULL;
+static slurm_msg_t msg;
+static job_desc_msg_t job_desc;
+static char *job_env[32];
+
+static bitstr_t *bits_a = NULL, *bits_b = NULL;
+static char *bits_str = NULL;
+static int bits_len = 0;
+
+static hostlist_t hl = NULL;
+static char *host_str = NULL;
+
+static List list = NULL;
+static int list_items[LIST_CNT];
+
+static xhash_t *xhash = NULL;
+static char **xhash_keys = NULL;
+
+static data_t *data = NULL;
+static char *data_str = NULL;
+static const char *json_mime = NULL;
+
+/*
+ * pack.c
+ */
+static void _pack_record(buf_t *buf)
+{
+	for (int i = 0; i < 8; i++)
+		pack32(i * 1000, buf);
+	for (int i = 0; i < 4; i++)
+		pack64(((uint64_t) i) << 40, buf);
+	packstr("node0001", buf);
+	packstr("debug,batch", buf);
+	packstr("cpu=64,mem=256000M,node=1,billing=64", buf);
+	packnull(buf);
+	pack_time(time(NULL), buf);
+}
+
+static void _pack_setup(void)
+{
+	buffer = init_buf(BUF_SIZE);
+}
+
+static void _pack_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		set_buf_offset(buffer, 0);
+		_pack_record(buffer);
+	}
+}
+
+static void _pack_teardown(void)
+{
+	FREE_NULL_BUFFER(buffer);
+}
+
+static void _unpack_setup(void)
+{
+	buffer = init_buf(BUF_SIZE);
+	_pack_record(buffer);
+}
+
+static void _unpack_run(uint64_t iters)
+{
+	uint32_t u32, len;
+	uint64_t u64;
+	time_t t;
+	char *str;
+
+	for (uint64_t i = 0; i < iters; i++) {
+		set_buf_offset(buffer, 0);
+		for (int j = 0; j < 8; j++)
+			unpack32(&u32, buffer);
+		for (int j = 0; j < 4; j++)
+			unpack64(&u64, buffer);
+		for (int j = 0; j < 4; j++) {
+			unpackstr_xmalloc(&str, &len, buffer);
+			xfree(str);
+		}
+		unpack_time(&t, buffer);
+		sink += u32 + u64;
+	}
+}
+
+static void _job_desc_setup(void)
+{
+	slurm_init_job_desc_msg(&job_desc);
+	job_desc.name = "bench";
+	job_desc.partition = "debug";
+	job_desc.account = "physics";
+	job_desc.work_dir = "/home/user/work";
+	job_desc.std_out = "/home/user/work/slurm-%j.out";
+	job_desc.script = "#!/bin/sh\n#SBATCH -N4\nsrun hostname\n";
+	job_desc.tres_per_node = "gres:gpu:4";
+	job_desc.user_id = 1000;
+	job_desc.group_id = 1000;
+	job_desc.min_nodes = 4;
+	job_desc.max_nodes = 4;
+	job_desc.min_cpus = 256;
+	job_desc.time_limit = 60;
+	for (int i = 0; i < ARRAY_SIZE(job_env); i++)
+		job_env[i] = xstrdup_printf("BENCH_VARIABLE_%d=/some/path/%d",
+					    i, i);
+	job_desc.environment = job_env;
+	job_desc.env_size = ARRAY_SIZE(job_env);
+
+	slurm_msg_t_init(&msg);
+	msg.msg_type = REQUEST_SUBMIT_BATCH_JOB;
+	msg.protocol_version = SLURM_PROTOCOL_VERSION;
+	msg.data = &job_desc;
+	buffer = init_buf(BUF_SIZE);
+}
+
+static void _job_desc_teardown(void)
+{
+	for (int i = 0; i < ARRAY_SIZE(job_env); i++)
+		xfree(job_env[i]);
+	FREE_NULL_BUFFER(buffer);
+}
+
+static void _pack_job_desc_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		set_buf_offset(buffer, 0);
+		pack_msg(&msg, buffer);
+	}
+}
+
+static void _unpack_job_desc_setup(void)
+{
+	_job_desc_setup();
+	pack_msg(&msg, buffer);
+}
+
+static void _unpack_job_desc_run(uint64_t iters)
+{
+	slurm_msg_t unpack_msg_buf;
+
+	for (uint64_t i = 0; i < iters; i++) {
+		slurm_msg_t_init(&unpack_msg_buf);
+		unpack_msg_buf.msg_type = msg.msg_type;
+		unpack_msg_buf.protocol_version = msg.protocol_version;
+		set_buf_offset(buffer, 0);
+		if (unpack_msg(&unpack_msg_buf, buffer))
+			fatal("unable to unpack job descriptor");
+		slurm_free_job_desc_msg(unpack_msg_buf.data);
+	}
+}
+
+/*
+ * bitstring.c
+ */
+static void _bits_setup(int nbits)
+{
+	bits_len = nbits;
+	bits_a = bit_alloc(nbits);
+	bits_b = bit_alloc(nbits);
+	/* Fragmented allocation similar to a busy cluster */
+	for (int i = nbits / 2; i < nbits; i += 7)
+		bit_nset(bits_a, i, MIN(i + 3, nbits - 1));
+	for (int i = 0; i < nbits; i += 3)
+		bit_set(bits_b, i);
+	bits_str = xmalloc(nbits * 8);
+}
+
+static void _bits_10k_setup(void)
+{
+	_bits_setup(10000);
+}
+
+static void _bits_100k_setup(void)
+{
+	_bits_setup(100000);
+}
+
+static void _bits_teardown(void)
+{
+	FREE_NULL_BITMAP(bits_a);
+	FREE_NULL_BITMAP(bits_b);
+	xfree(bits_str);
+}
+
+static void _bit_set_count_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		sink += bit_set_count(bits_a);
+}
+
+static void _bit_ffs_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		sink += bit_ffs(bits_a);
+}
+
+static void _bit_and_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		bit_and(bits_b, bits_a);
+}
+
+static void _bit_fmt_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		sink += (uintptr_t) bit_fmt(bits_str, bits_len * 8, bits_a);
+}
+
+/*
+ * hostlist.c
+ */
+static void _hostlist_setup(void)
+{
+	hl = hostlist_create(NULL);
+	for (int i = 0; i < HOST_CNT; i++) {
+		char name[32];
+		/* Leave holes so the ranged string has many ranges */
+		if ((i % 64) == 63)
+			continue;
+		snprintf(name, sizeof(name), "node%04d", i);
+		hostlist_push_host(hl, name);
+	}
+	host_str = hostlist_ranged_string_xmalloc(hl);
+}
+
+static void _hostlist_teardown(void)
+{
+	FREE_NULL_HOSTLIST(hl);
+	xfree(host_str);
+}
+
+static void _hostlist_create_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		hostlist_t tmp = hostlist_create(host_str);
+		sink += hostlist_count(tmp);
+		hostlist_destroy(tmp);
+	}
+}
+
+static void _hostlist_ranged_string_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		char *str = hostlist_ranged_string_xmalloc(hl);
+		sink += str[0];
+		xfree(str);
+	}
+}
+
+static void _hostlist_find_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		sink += hostlist_find(hl, "node3000");
+}
+
+/*
+ * list.c
+ */
+static int _list_find_int(void *x, void *key)
+{
+	return (*(int *) x == *(int *) key);
+}
+
+static int _list_for_each_int(void *x, void *arg)
+{
+	*(uint64_t *) arg += *(int *) x;
+	return 0;
+}
+
+static int _list_cmp_int_asc(void *x, void *y)
+{
+	int a = **(int **) x, b = **(int **) y;
+
+	return (a > b) - (a < b);
+}
+
+static int _list_cmp_int_desc(void *x, void *y)
+{
+	return _list_cmp_int_asc(y, x);
+}
+
+static void _list_setup(void)
+{
+	list = list_create(NULL);
+	for (int i = 0; i < LIST_CNT; i++) {
+		/* Scrambled order to make sorting do work */
+		list_items[i] = (i * 7919) % LIST_CNT;
+		list_append(list, &list_items[i]);
+	}
+}
+
+static void _list_teardown(void)
+{
+	FREE_NULL_LIST(list);
+}
+
+static void _list_append_pop_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		list_append(list, &list_items[0]);
+		sink += (uintptr_t) list_pop(list);
+	}
+}
+
+static void _list_find_first_run(uint64_t iters)
+{
+	int key = list_items[LIST_CNT - 1];
+
+	for (uint64_t i = 0; i < iters; i++)
+		sink += (uintptr_t) list_find_first(list, _list_find_int, &key);
+}
+
+static void _list_for_each_run(uint64_t iters)
+{
+	uint64_t sum = 0;
+
+	for (uint64_t i = 0; i < iters; i++)
+		list_for_each(list, _list_for_each_int, &sum);
+	sink += sum;
+}
+
+static void _list_sort_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		/* Alternate so each pass has work to do */
+		if (i & 1)
+			list_sort(list, _list_cmp_int_asc);
+		else
+			list_sort(list, _list_cmp_int_desc);
+	}
+}
+
+/*
+ * xhash.c
+ */
+static void _xhash_id(void *item, const char **key, uint32_t *key_len)
+{
+	*key = item;
+	*key_len = strlen(item);
+}
+
+static void _xhash_setup(void)
+{
+	xhash = xhash_init(_xhash_id, NULL);
+	xhash_keys = xcalloc(XHASH_CNT, sizeof(char *));
+	for (int i = 0; i < XHASH_CNT; i++) {
+		xhash_keys[i] = xstrdup_printf("key_%d", i);
+		xhash_add(xhash, xhash_keys[i]);
+	}
+}
+
+static void _xhash_teardown(void)
+{
+	xhash_free(xhash);
+	for (int i = 0; i < XHASH_CNT; i++)
+		xfree(xhash_keys[i]);
+	xfree(xhash_keys);
+}
+
+static void _xhash_get_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		sink += (uintptr_t) xhash_get_str(xhash,
+						  xhash_keys[i % XHASH_CNT]);
+}
+
+static void _xhash_add_delete_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		char *key = xhash_keys[i % XHASH_CNT];
+		xhash_delete_str(xhash, key);
+		xhash_add(xhash, key);
+	}
+}
+
+/*
+ * data.c and serializers
+ */
+static data_t *_data_build(void)
+{
+	data_t *d = data_set_dict(data_new());
+
+	for (int i = 0; i < DATA_CNT; i++) {
+		char key[32];
+		data_t *e;
+
+		snprintf(key, sizeof(key), "job_%d", i);
+		e = data_set_dict(data_key_set(d, key));
+		data_set_int(data_key_set(e, "job_id"), i);
+		data_set_string(data_key_set(e, "partition"), "debug");
+		data_set_bool(data_key_set(e, "requeue"), true);
+		data_set_float(data_key_set(e, "priority"), i * 0.5);
+	}
+
+	return d;
+}
+
+static void _data_setup(void)
+{
+	data = _data_build();
+	if (json_mime &&
+	    data_g_serialize(&data_str, data, json_mime,
+			     DATA_SER_FLAGS_COMPACT))
+		fatal("unable to serialize data");
+}
+
+static void _data_teardown(void)
+{
+	FREE_NULL_DATA(data);
+	xfree(data_str);
+}
+
+static void _data_build_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		data_t *d = _data_build();
+		FREE_NULL_DATA(d);
+	}
+}
+
+static void _data_key_get_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++)
+		sink += (uintptr_t) data_key_get(data, "job_99");
+}
+
+static void _data_copy_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		data_t *d = data_copy(data_new(), data);
+		FREE_NULL_DATA(d);
+	}
+}
+
+static void _json_serialize_run(uint64_t iters)
+{
+	for (uint64_t i = 0; i < iters; i++) {
+		char *str = NULL;
+		data_g_serialize(&str, data, json_mime, DATA_SER_FLAGS_COMPACT);
+		xfree(str);
+	}
+}
+
+static void _json_deserialize_run(uint64_t iters)
+{
+	size_t len = strlen(data_str);
+
+	for (uint64_t i = 0; i < iters; i++) {
+		data_t *d = NULL;
+		data_g_deserialize(&d, data_str, len, json_mime);
+		FREE_NULL_DATA(d);
+	}
+}
+
+static const bench_t benches[] = {
+	{ "pack/record", _pack_setup, _pack_run, _pack_teardown },
+	{ "unpack/record", _unpack_setup, _unpack_run, _pack_teardown },
+	{ "pack/job_desc_msg", _job_desc_setup, _pack_job_desc_run,
+	  _job_desc_teardown, BENCH_FLAG_CONF },
+	{ "unpack/job_desc_msg", _unpack_job_desc_setup, _unpack_job_desc_run,
+	  _job_desc_teardown, BENCH_FLAG_CONF },
+	{ "bitstring/set_count/10k", _bits_10k_setup, _bit_set_count_run,
+	  _bits_teardown },
+	{ "bitstring/set_count/100k", _bits_100k_setup, _bit_set_count_run,
+	  _bits_teardown },
+	{ "bitstring/ffs/10k", _bits_10k_setup, _bit_ffs_run, _bits_teardown },
+	{ "bitstring/ffs/100k", _bits_100k_setup, _bit_ffs_run,
+	  _bits_teardown },
+	{ "bitstring/and/10k", _bits_10k_setup, _bit_and_run, _bits_teardown },
+	{ "bitstring/and/100k", _bits_100k_setup, _bit_and_run,
+	  _bits_teardown },
+	{ "bitstring/fmt/10k", _bits_10k_setup, _bit_fmt_run, _bits_teardown },
+	{ "bitstring/fmt/100k", _bits_100k_setup, _bit_fmt_run,
+	  _bits_teardown },
+	{ "hostlist/create/4k", _hostlist_setup, _hostlist_create_run,
+	  _hostlist_teardown },
+	{ "hostlist/ranged_string/4k", _hostlist_setup,
+	  _hostlist_ranged_string_run, _hostlist_teardown },
+	{ "hostlist/find/4k", _hostlist_setup, _hostlist_find_run,
+	  _hostlist_teardown },
+	{ "list/append_pop", _list_setup, _list_append_pop_run,
+	  _list_teardown },
+	{ "list/find_first/1k", _list_setup, _list_find_first_run,
+	  _list_teardown },
+	{ "list/for_each/1k", _list_setup, _list_for_each_run,
+	  _list_teardown },
+	{ "list/sort/1k", _list_setup, _list_sort_run, _list_teardown },
+	{ "xhash/get/10k", _xhash_setup, _xhash_get_run, _xhash_teardown },
+	{ "xhash/add_delete/10k", _xhash_setup, _xhash_add_delete_run,
+	  _xhash_teardown },
+	{ "data/build/100", NULL, _data_build_run, NULL },
+	{ "data/key_get/100", _data_setup, _data_key_get_run,
+	  _data_teardown },
+	{ "data/copy/100", _data_setup, _data_copy_run, _data_teardown },
+	{ "serializer/json/serialize/100", _data_setup, _json_serialize_run,
+	  _data_teardown, BENCH_FLAG_JSON },
+	{ "serializer/json/deserialize/100", _data_setup,
+	  _json_deserialize_run, _data_teardown, BENCH_FLAG_JSON },
+};
+
+static uint64_t _now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ts.tv_sec * NSEC_IN_SEC) + ts.tv_nsec;
+}
+
+static bool _filter_match(const char *name, int argc, char **argv)
+{
+	if (optind >= argc)
+		return true;
+	for (int i = optind; i < argc; i++)
+		if (xstrstr(name, argv[i]))
+			return true;
+	return false;
+}
+
+static void _usage(void)
+{
+	fprintf(stderr,
+"Usage: primitives-bench [OPTIONS] [name_filter ...]\n"
+"  -j, --json          also run serializer/json benchmarks, loading the\n"
+"                      plugin from PluginDir or the default directory\n"
+"  -l, --list          list benchmark names and exit\n"
+"  -p, --parsable      print results delimited by '|'\n"
+"  -t, --time=msec     minimum run time of each benchmark (default 200)\n"
+"  -h, --help          show this message\n");
+}
+
+int main(int argc, char **argv)
+{
+	static struct option long_options[] = {
+		{"help", no_argument, 0, 'h'},
+		{"json", no_argument, 0, 'j'},
+		{"list", no_argument, 0, 'l'},
+		{"parsable", no_argument, 0, 'p'},
+		{"time", required_argument, 0, 't'},
+		{NULL, 0, 0, 0}
+	};
+	log_options_t log_opts = LOG_OPTS_STDERR_ONLY;
+	bool have_conf = false, json = false, list_only = false;
+	bool parsable = false;
+	uint64_t min_nsec = 200 * NSEC_IN_MSEC;
+	int c;
+
+	log_init("primitives-bench", log_opts, 0, NULL);
+
+	while ((c = getopt_long(argc, argv, "hjlpt:", long_options,
+				NULL)) != -1) {
+		switch (c) {
+		case 'j':
+			json = true;
+			break;
+		case 'l':
+			list_only = true;
+			break;
+		case 'p':
+			parsable = true;
+			break;
+		case 't':
+			min_nsec = strtoull(optarg, NULL, 10) * NSEC_IN_MSEC;
+			if (!min_nsec) {
+				_usage();
+				exit(1);
+			}
+			break;
+		case 'h':
+			_usage();
+			exit(0);
+		default:
+			_usage();
+			exit(1);
+		}
+	}
+
+	if (list_only) {
+		for (int i = 0; i < ARRAY_SIZE(benches); i++)
+			if (_filter_match(benches[i].name, argc, argv))
+				printf("%s\n", benches[i].name);
+		exit(0);
+	}
+
+	if (getenv("SLURM_CONF") && !slurm_conf_init(NULL))
+		have_conf = true;
+
+	if (json) {
+		/* No slurm.conf is needed, only the plugin itself */
+		if (!have_conf)
+			slurm_conf.plugindir = xstrdup(default_plugin_path);
+		if (data_init(MIME_TYPE_JSON_PLUGIN, NULL))
+			fatal("data_init() failed");
+		json_mime = data_resolve_mime_type(MIME_TYPE_JSON);
+	} else if (data_init("", NULL)) {
+		fatal("data_init() failed");
+	}
+
+#ifdef __GLIBC__
+	alloc_counted = true;
+#endif
+
+	if (parsable)
+		printf("name|ns_per_op|allocs_per_op|iterations\n");
+	else
+		printf("%-32s %12s %13s %12s\n",
+		       "NAME", "NS/OP", "ALLOCS/OP", "ITERATIONS");
+
+	for (int i = 0; i < ARRAY_SIZE(benches); i++) {
+		const bench_t *b = &benches[i];
+		uint64_t iters = 1, start, elapsed, allocs;
+		double ns_op, allocs_op;
+
+		if (!_filter_match(b->name, argc, argv))
+			continue;
+		if ((b->flags & BENCH_FLAG_CONF) && !have_conf) {
+			info("%s: skipped, SLURM_CONF not set", b->name);
+			continue;
+		}
+		if ((b->flags & BENCH_FLAG_JSON) && !json_mime) {
+			info("%s: skipped, serializer/json not loaded", b->name);
+			continue;
+		}
+
+		if (b->setup)
+			b->setup();
+		while (true) {
+			allocs = alloc_cnt;
+			start = _now_nsec();
+			b->run(iters);
+			elapsed = _now_nsec() - start;
+			allocs = alloc_cnt - allocs;
+			if ((elapsed >= min_nsec) || (iters >= (1ULL << 40)))
+				break;
+			iters *= 2;
+		}
+		if (b->teardown)
+			b->teardown();
+
+		ns_op = (double) elapsed / iters;
+		allocs_op = alloc_counted ? ((double) allocs / iters) : -1;
+		if (parsable)
+			printf("%s|%.2f|%.2f|%"PRIu64"\n",
+			       b->name, ns_op, allocs_op, iters);
+		else
+			printf("%-32s %12.2f %13.2f %12"PRIu64"\n",
+			       b->name, ns_op, allocs_op, iters);
+		fflush(stdout);
+	}
+
+	data_destroy_static();
+	if (have_conf)
+		slurm_conf_destroy();
+	log_fini();
+	return 0;
+}
@@ -0,0 +1,176 @@
+/*
+ * Test of src/plugins/serializer/json/serializer_json.c
+ *
+ * The plugin is built into the test directly so no plugin directory is
+ * needed to load it.
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "src/plugins/serializer/json/serializer_json.c"
+
+#include <testsuite/dejagnu.h>
+
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+static data_t *_parse(const char *str)
+{
+	data_t *d = NULL;
+
+	serializer_p_deserialize(&d, str, strlen(str));
+
+	return d;
+}
+
+/* Return true if str parses to a single string matching expected */
+static bool _parse_string_match(const char *str, const char *expected)
+{
+	data_t *d = _parse(str);
+	bool rc;
+
+	rc = (d && (data_get_type(d) == DATA_TYPE_STRING) &&
+	      !xstrcmp(data_get_string(d), expected));
+	FREE_NULL_DATA(d);
+
+	return rc;
+}
+
+/* Return true if d serializes to expected and parses back to a match */
+static bool _round_trip(const data_t *d, const char *expected)
+{
+	char *str = NULL;
+	data_t *parsed;
+	bool rc;
+
+	serializer_p_serialize(&str, d, DATA_SER_FLAGS_COMPACT);
+	rc = !xstrcmp(str, expected);
+	parsed = _parse(str);
+	rc = rc && parsed && data_check_match(d, parsed, false);
+	FREE_NULL_DATA(parsed);
+	xfree(str);
+
+	return rc;
+}
+
+static char *_nested(int depth)
+{
+	char *str = NULL;
+
+	for (int i = 0; i < depth; i++)
+		xstrcatchar(str, '[');
+	for (int i = 0; i < depth; i++)
+		xstrcatchar(str, ']');
+
+	return str;
+}
+
+int main(int argc, char *argv[])
+{
+	data_t *d, *a;
+	char *str = NULL;
+
+	/* duplicate keys keep the last value, releasing the earlier one */
+	d = _parse("{\"a\":[\"first list\",{\"z\":1}],\"b\":2,\"a\":\"second\"}");
+	TEST(d && (data_get_dict_length(d) == 2) &&
+	     (a = data_key_get(d, "a")) &&
+	     (data_get_type(a) == DATA_TYPE_STRING) &&
+	     !xstrcmp(data_get_string(a), "second"),
+	     "duplicate key keeps last value");
+	FREE_NULL_DATA(d);
+	d = _parse("{\"a\":\"first\",\"a\":{\"x\":[1,2]}}");
+	TEST(d && (a = data_key_get(d, "a")) &&
+	     (data_get_type(a) == DATA_TYPE_DICT) &&
+	     (data_get_dict_length(a) == 1),
+	     "duplicate key replaces string with dict");
+	FREE_NULL_DATA(d);
+
+	/* escapes */
+	TEST(_parse_string_match("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"",
+				 "\"\\/\b\f\n\r\t"),
+	     "simple escapes");
+	TEST(_parse_string_match("\"x\\u00e9\\u20acy\"",
+				 "x\xc3\xa9\xe2\x82\xacy"),
+	     "unicode escapes");
+	TEST(_parse_string_match("\"\\ud83d\\ude00\"", "\xf0\x9f\x98\x80"),
+	     "surrogate pair");
+	TEST(_parse_string_match("\"\\ud800\"", "\xef\xbf\xbd"),
+	     "lone high surrogate is U+FFFD");
+	TEST(_parse_string_match("\"\\ud800\\u0041\"", "\xef\xbf\xbd" "A"),
+	     "unpaired high surrogate keeps next escape");
+	TEST(_parse_string_match("\"\\udc00x\"", "\xef\xbf\xbd" "x"),
+	     "lone low surrogate is U+FFFD");
+	d = _parse("\"\\ud800\\uzzzz\"");
+	TEST(!d, "invalid escape after high surrogate rejected");
+	FREE_NULL_DATA(d);
+	d = _parse("\"\\q\"");
+	TEST(!d, "unknown escape rejected");
+	FREE_NULL_DATA(d);
+
+	d = data_set_string(data_new(), "\"quoted\"\\\n\t\x01/\xc3\xa9");
+	TEST(_round_trip(d, "\"\\\"quoted\\\"\\\\\\n\\t\\u0001/\xc3\xa9\""),
+	     "string round trip");
+	FREE_NULL_DATA(d);
+
+	/* numbers, including non-finite floats */
+	d = data_set_dict(data_new());
+	data_set_float(data_key_set(d, "two"), 2.0);
+	data_set_float(data_key_set(d, "nan"), NAN);
+	data_set_float(data_key_set(d, "inf"), INFINITY);
+	data_set_float(data_key_set(d, "ninf"), -INFINITY);
+	data_set_int(data_key_set(d, "int"), -5);
+	serializer_p_serialize(&str, d, DATA_SER_FLAGS_COMPACT);
+	TEST(!xstrcmp(str, "{\"two\":2.0,\"nan\":NaN,\"inf\":Infinity,"
+		      "\"ninf\":-Infinity,\"int\":-5}"),
+	     "float output");
+	FREE_NULL_DATA(d);
+	d = _parse(str);
+	TEST(d && (data_get_type(data_key_get(d, "two")) == DATA_TYPE_FLOAT) &&
+	     (data_get_float(data_key_get(d, "two")) == 2.0) &&
+	     isnan(data_get_float(data_key_get(d, "nan"))) &&
+	     (data_get_float(data_key_get(d, "inf")) == INFINITY) &&
+	     (data_get_float(data_key_get(d, "ninf")) == -INFINITY) &&
+	     (data_get_int(data_key_get(d, "int")) == -5),
+	     "non-finite float round trip");
+	FREE_NULL_DATA(d);
+	xfree(str);
+	d = _parse("-Inf");
+	TEST(!d, "truncated -Infinity rejected");
+	FREE_NULL_DATA(d);
+	d = _parse("99999999999999999999");
+	TEST(d && (data_get_type(d) == DATA_TYPE_FLOAT),
+	     "integer out of range kept as float");
+	FREE_NULL_DATA(d);
+
+	/* nesting limit */
+	str = _nested(JSON_MAX_DEPTH);
+	d = _parse(str);
+	TEST(d && (data_get_type(d) == DATA_TYPE_LIST), "nesting at limit");
+	FREE_NULL_DATA(d);
+	xfree(str);
+	str = _nested(JSON_MAX_DEPTH + 1);
+	d = _parse(str);
+	TEST(!d, "nesting past limit rejected");
+	FREE_NULL_DATA(d);
+	xfree(str);
+
+	/* malformed input */
+	d = _parse("{\"a\":1,}");
+	TEST(!d, "trailing comma rejected");
+	FREE_NULL_DATA(d);
+	d = _parse("[1,2");
+	TEST(!d, "unterminated array rejected");
+	FREE_NULL_DATA(d);
+
+	totals();
+	return failed;
+}
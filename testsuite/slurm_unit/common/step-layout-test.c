@@ -0,0 +1,199 @@
+/*
+ * Test of src/common/slurm_step_layout.c
+ *
+ * Avoid duplicate wait() symbol definition (in both testsuite/dejagnu.h
+ * and sys/wait.h
+ */
+#define _SYS_WAIT_H 1
+#include <stdlib.h>
+#include <string.h>
+
+#include "slurm/slurm.h"
+
+#include "src/common/pack.h"
+#include "src/common/slurm_protocol_common.h"
+#include "src/common/slurm_step_layout.h"
+#include "src/common/xmalloc.h"
+
+#include <testsuite/dejagnu.h>
+
+/*
+ * Test for failure:
+ */
+#define TEST(_tst, _msg) do {		\
+	if (! (_tst))			\
+		fail( _msg );		\
+	else				\
+		pass( _msg );		\
+} while (0)
+
+#define NODE_CNT 4
+
+static uint16_t cpus_per_node[NODE_CNT] = { 4, 2, 4, 2 };
+static uint32_t cpu_count_reps[NODE_CNT] = { 1, 1, 1, 1 };
+
+static slurm_step_layout_t *_create(uint32_t task_dist, uint32_t num_tasks,
+				    uint16_t plane_size)
+{
+	slurm_step_layout_req_t req;
+
+	memset(&req, 0, sizeof(req));
+	req.node_list = "n[1-4]";
+	req.cpus_per_node = cpus_per_node;
+	req.cpu_count_reps = cpu_count_reps;
+	req.num_hosts = NODE_CNT;
+	req.num_tasks = num_tasks;
+	req.task_dist = task_dist;
+	req.plane_size = plane_size;
+
+	return slurm_step_layout_create(&req);
+}
+
+/* Return true if every task id is laid out exactly once */
+static bool _layout_valid(slurm_step_layout_t *layout)
+{
+	int i, j, cnt = 0;
+	bool *seen = xcalloc(layout->task_cnt, sizeof(bool));
+	bool rc = true;
+
+	for (i = 0; i < layout->node_cnt; i++) {
+		for (j = 0; j < layout->tasks[i]; j++) {
+			uint32_t tid = layout->tids[i][j];
+			if ((tid >= layout->task_cnt) || seen[tid])
+				rc = false;
+			else
+				seen[tid] = true;
+			cnt++;
+		}
+	}
+	xfree(seen);
+
+	return (rc && (cnt == layout->task_cnt));
+}
+
+/* Return true if every task's host id matches the layout */
+static bool _host_id_valid(slurm_step_layout_t *layout)
+{
+	int i, j;
+
+	for (i = 0; i < layout->node_cnt; i++) {
+		for (j = 0; j < layout->tasks[i]; j++) {
+			if (slurm_step_layout_host_id(layout,
+						      layout->tids[i][j]) != i)
+				return false;
+		}
+	}
+
+	return (slurm_step_layout_host_id(layout, layout->task_cnt) ==
+		SLURM_ERROR);
+}
+
+static bool _layout_equal(slurm_step_layout_t *l1, slurm_step_layout_t *l2)
+{
+	int i;
+
+	if (!l1 || !l2 || (l1->node_cnt != l2->node_cnt) ||
+	    (l1->task_cnt != l2->task_cnt) ||
+	    (l1->task_dist != l2->task_dist) ||
+	    strcmp(l1->node_list, l2->node_list))
+		return false;
+
+	for (i = 0; i < l1->node_cnt; i++) {
+		if (l1->tasks[i] != l2->tasks[i])
+			return false;
+		if (l1->tasks[i] &&
+		    memcmp(l1->tids[i], l2->tids[i],
+			   l1->tasks[i] * sizeof(uint32_t)))
+			return false;
+	}
+
+	return true;
+}
+
+static bool _pack_round_trip(slurm_step_layout_t *layout,
+			     uint16_t protocol_version)
+{
+	buf_t *buffer = init_buf(0);
+	slurm_step_layout_t *unpacked = NULL;
+	uint32_t size;
+	bool rc;
+
+	pack_slurm_step_layout(layout, buffer, protocol_version);
+	size = get_buf_offset(buffer);
+	set_buf_offset(buffer, 0);
+	rc = ((unpack_slurm_step_layout(&unpacked, buffer, protocol_version) ==
+	       SLURM_SUCCESS) &&
+	      (layout ? _layout_equal(layout, unpacked) : !unpacked) &&
+	      (get_buf_offset(buffer) == size));
+	slurm_step_layout_destroy(unpacked);
+	free_buf(buffer);
+
+	return rc;
+}
+
+static void _test_layout(slurm_step_layout_t *layout, char *name)
+{
+	char msg[128];
+
+	snprintf(msg, sizeof(msg), "%s layout created", name);
+	TEST(layout != NULL, msg);
+	if (!layout)
+		return;
+	snprintf(msg, sizeof(msg), "%s layout has every task once", name);
+	TEST(_layout_valid(layout), msg);
+	snprintf(msg, sizeof(msg), "%s layout host ids", name);
+	TEST(_host_id_valid(layout), msg);
+	snprintf(msg, sizeof(msg), "%s layout un/pack", name);
+	TEST(_pack_round_trip(layout, SLURM_PROTOCOL_VERSION), msg);
+	snprintf(msg, sizeof(msg), "%s layout un/pack, oldest protocol", name);
+	TEST(_pack_round_trip(layout, SLURM_MIN_PROTOCOL_VERSION), msg);
+}
+
+int main(int argc, char *argv[])
+{
+	slurm_step_layout_t *layout;
+	uint32_t cyclic_tids[5] = { 0, 4, 8, 12, 14 };
+	int i;
+
+
+	/* 16 tasks on 12 CPUs, over-subscribed by one task per node */
+	layout = _create(SLURM_DIST_CYCLIC, 16, 0);
+	_test_layout(layout, "cyclic");
+	TEST(layout && (layout->tasks[0] == 5) && (layout->tasks[1] == 3) &&
+	     (layout->tasks[2] == 5) && (layout->tasks[3] == 3) &&
+	     !memcmp(layout->tids[0], cyclic_tids, sizeof(cyclic_tids)) &&
+	     (layout->tids[3][2] == 11),
+	     "cyclic layout over-subscribed");
+	slurm_step_layout_destroy(layout);
+
+	layout = _create(SLURM_DIST_BLOCK, 10, 0);
+	_test_layout(layout, "block");
+	TEST(layout && (layout->tasks[0] == 3) && (layout->tasks[1] == 2) &&
+	     (layout->tids[1][0] == 3), "block layout spreads the tasks");
+	slurm_step_layout_destroy(layout);
+
+	layout = _create(SLURM_DIST_PLANE, 12, 2);
+	_test_layout(layout, "plane");
+	slurm_step_layout_destroy(layout);
+
+	layout = _create(SLURM_DIST_CYCLIC, 3, 0);
+	_test_layout(layout, "cyclic with idle nodes");
+	TEST(layout && (layout->tasks[3] == 0), "cyclic layout leaves an "
+	     "idle node");
+	slurm_step_layout_destroy(layout);
+
+	/* Task ids not in increasing order, as from a merged layout */
+	layout = _create(SLURM_DIST_BLOCK, 12, 0);
+	if (layout) {
+		for (i = 0; i < layout->tasks[0]; i++)
+			layout->tids[0][i] = layout->tasks[0] - 1 - i;
+	}
+	_test_layout(layout, "unordered");
+	slurm_step_layout_destroy(layout);
+
+	TEST(_pack_round_trip(NULL, SLURM_PROTOCOL_VERSION),
+	     "un/pack of no layout");
+
+	totals();
+	return failed;
+}